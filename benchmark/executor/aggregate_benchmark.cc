@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "executor/aggregate.hh"
+#include "parser/mysql/type.hh"
+
+using namespace executor;
+using expression::ColumnRef;
+using expression::ExprPtr;
+using expression::FieldType;
+using util::chunk::Chunk;
+using util::chunk::defaultCapacity;
+
+// `SELECT k, COUNT(*), SUM(v), MAX(v) FROM t GROUP BY k` over 1M rows of BIGINT columns k and v: hashed with
+// state.range(0) distinct keys on state.range(1) threads, and streamed over the rows sorted by k. BM_ApproxAgg is
+// `SELECT k, APPROX_COUNT_DISTINCT(v), APPROX_PERCENTILE(v, 50) FROM t GROUP BY k` the same way.
+
+namespace {
+
+constexpr size_t numRows = 1 << 20;
+
+std::vector<Chunk> newInput(int64_t cardinality, bool sorted) {
+    const std::vector<uint8_t> types(2, mysql::TypeLonglong);
+    std::vector<Chunk> input;
+    for (size_t i = 0; i < numRows; i++) {
+        if (input.empty() || input.back().IsFull()) {
+            input.emplace_back(types);
+        }
+        auto &chk = input.back();
+        auto k = sorted ? static_cast<int64_t>(i * cardinality / numRows)
+                        : static_cast<int64_t>((i * 2654435761u) % static_cast<uint64_t>(cardinality));
+        chk.Col(0).AppendInt64(k);
+        chk.Col(1).AppendInt64(static_cast<int64_t>(i % 1000));
+    }
+    return input;
+}
+
+ExprPtr col(size_t index) {
+    return std::make_unique<ColumnRef>(index, FieldType{mysql::TypeLonglong, 0}, index == 0 ? "k" : "v");
+}
+
+void run(benchmark::State &state, AggOptions opts, bool sorted, bool approx = false) {
+    auto input = newInput(state.range(0), sorted);
+    for (auto _ : state) {
+        std::vector<ExprPtr> groupBy;
+        groupBy.push_back(col(0));
+        std::vector<AggFuncDesc> aggs;
+        if (approx) {
+            aggs.push_back({AggFunc::ApproxCountDistinct, col(1)});
+            aggs.push_back({AggFunc::ApproxPercentile, col(1), 50});
+        } else {
+            aggs.push_back({AggFunc::Count, nullptr});
+            aggs.push_back({AggFunc::Sum, col(1)});
+            aggs.push_back({AggFunc::Max, col(1)});
+        }
+        auto [agg, err] = AggExec::New(std::move(groupBy), std::move(aggs), opts);
+        auto [out, execErr] = agg->Execute(input);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * numRows));
+}
+
+void BM_HashAgg(benchmark::State &state) {
+    run(state, {AggStrategy::Hash, static_cast<size_t>(state.range(1))}, false);
+}
+
+void BM_StreamAgg(benchmark::State &state) { run(state, {AggStrategy::Stream}, true); }
+
+void BM_ApproxAgg(benchmark::State &state) {
+    run(state, {AggStrategy::Hash, static_cast<size_t>(state.range(1))}, false, true);
+}
+
+}  // namespace
+
+BENCHMARK(BM_HashAgg)
+    ->ArgsProduct({{16, 1 << 12, 1 << 20}, {1, 4, 0}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_StreamAgg)->Arg(1 << 12)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ApproxAgg)->ArgsProduct({{16, 1 << 12}, {1, 0}})->Unit(benchmark::kMillisecond)->UseRealTime();
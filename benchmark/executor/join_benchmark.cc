@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "executor/join.hh"
+#include "parser/mysql/type.hh"
+
+using namespace executor;
+using expression::ColumnRef;
+using expression::ExprPtr;
+using expression::FieldType;
+using util::chunk::Chunk;
+
+// `SELECT * FROM fact JOIN dim ON fact.k = dim.k` of 1M fact rows with state.range(0) dim rows, of BIGINT columns k
+// and v, every fact row matching one dim row, on state.range(1) threads.
+
+namespace {
+
+constexpr size_t numFacts = 1 << 20;
+
+std::vector<Chunk> newInput(size_t numRows, uint64_t cardinality) {
+    const std::vector<uint8_t> types(2, mysql::TypeLonglong);
+    std::vector<Chunk> input;
+    for (size_t i = 0; i < numRows; i++) {
+        if (input.empty() || input.back().IsFull()) {
+            input.emplace_back(types);
+        }
+        auto &chk = input.back();
+        chk.Col(0).AppendInt64(static_cast<int64_t>((i * 2654435761u) % cardinality));
+        chk.Col(1).AppendInt64(static_cast<int64_t>(i));
+    }
+    return input;
+}
+
+ExprPtr key() { return std::make_unique<ColumnRef>(0, FieldType{mysql::TypeLonglong, 0}, "k"); }
+
+void BM_HashJoin(benchmark::State &state) {
+    auto numDims = static_cast<size_t>(state.range(0));
+    auto facts = newInput(numFacts, numDims), dims = newInput(numDims, numDims);
+    const std::vector<uint8_t> types(2, mysql::TypeLonglong);
+    for (auto _ : state) {
+        std::vector<ExprPtr> leftKeys, rightKeys;
+        leftKeys.push_back(key());
+        rightKeys.push_back(key());
+        auto [join, err] = HashJoinExec::New(JoinType::Inner, std::move(leftKeys), std::move(rightKeys), types, types,
+                                             {BuildSide::Auto, false, static_cast<size_t>(state.range(1))});
+        auto [out, execErr] = join->Execute(facts, dims);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * (numFacts + numDims)));
+}
+
+}  // namespace
+
+BENCHMARK(BM_HashJoin)
+    ->ArgsProduct({{1 << 10, 1 << 16, 1 << 20}, {1, 4, 0}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,179 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "storage/index/bwtree_index.hh"
+
+using namespace storage::index;
+
+// YCSB-style workloads against the Bw-Tree index: a table of recordCount records keyed by a scrambled ordinal, read,
+// updated and scanned by several threads with the zipfian request distribution of YCSB.
+
+namespace {
+
+constexpr uint64_t recordCount = 1 << 20;
+constexpr int maxScanLength = 100;
+
+// workload is the mix of operations of a YCSB workload, as proportions summing to 1.
+struct workload {
+    double Read;
+    double Update;
+    double Scan;
+    double Insert;
+};
+
+// zipfianGenerator draws integers in [0, n) with the zipfian distribution of YCSB, after Gray et al., "Quickly
+// Generating Billion-Record Synthetic Databases".
+class zipfianGenerator {
+public:
+    explicit zipfianGenerator(uint64_t n, double theta = 0.99) : _n(n), _theta(theta) {
+        for (uint64_t i = 1; i <= n; i++) {
+            _zetan += 1 / std::pow(static_cast<double>(i), theta);
+        }
+        double zeta2 = 1 + 1 / std::pow(2.0, theta);
+        _alpha = 1 / (1 - theta);
+        _eta = (1 - std::pow(2.0 / static_cast<double>(n), 1 - theta)) / (1 - zeta2 / _zetan);
+    }
+
+    template <typename Rng>
+    uint64_t Next(Rng &rng) const {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        double uz = u * _zetan;
+        if (uz < 1) {
+            return 0;
+        }
+        if (uz < 1 + std::pow(0.5, _theta)) {
+            return 1;
+        }
+        return static_cast<uint64_t>(static_cast<double>(_n) * std::pow(_eta * u - _eta + 1, _alpha)) % _n;
+    }
+
+private:
+    uint64_t _n;
+    double _theta;
+    double _zetan{0};
+    double _alpha;
+    double _eta;
+};
+
+// recordKey scrambles the ordinal of a record like YCSB's hashed insert order, so that the popular records are not
+// neighbors in the tree.
+IntKey recordKey(uint64_t ordinal) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < 8; i++) {
+        h = (h ^ ((ordinal >> (i * 8)) & 0xff)) * 0x100000001b3ULL;
+    }
+    return IntKey(static_cast<int64_t>(h));
+}
+
+struct table {
+    BwTreeIndex<IntKey> Index{true};
+    zipfianGenerator Zipfian{recordCount};
+    // NextOrdinal is the ordinal of the next record inserted.
+    std::atomic<uint64_t> NextOrdinal{recordCount};
+
+    table() {
+        std::vector<std::pair<IntKey, uint64_t>> records;
+        for (uint64_t i = 0; i < recordCount; i++) {
+            records.emplace_back(recordKey(i), i);
+        }
+        Index.BulkLoad(std::move(records));
+    }
+};
+
+// loadedTable returns the table, loaded by the first benchmark and shared by all of them.
+table &loadedTable() {
+    static table t;
+    return t;
+}
+
+void BM_YCSB(benchmark::State &state, workload w) {
+    auto &t = loadedTable();
+    static std::atomic<uint64_t> seed{0};
+    std::mt19937_64 rng(seed.fetch_add(1));
+    std::uniform_real_distribution<double> op(0, 1);
+    std::uniform_int_distribution<int> scanLength(1, maxScanLength);
+
+    for (auto _ : state) {
+        double p = op(rng);
+        if (p < w.Read) {
+            benchmark::DoNotOptimize(t.Index.Get(recordKey(t.Zipfian.Next(rng))));
+        } else if ((p -= w.Read) < w.Update) {
+            auto ordinal = t.Zipfian.Next(rng);
+            t.Index.Upsert(recordKey(ordinal), ordinal);
+        } else if ((p -= w.Update) < w.Scan) {
+            auto it = t.Index.Iter(recordKey(t.Zipfian.Next(rng)));
+            for (int n = scanLength(rng); n > 0 && it.Valid(); n--, it.Next()) {
+                benchmark::DoNotOptimize(it.Value());
+            }
+        } else {
+            auto ordinal = t.NextOrdinal.fetch_add(1);
+            t.Index.Insert(recordKey(ordinal), ordinal);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// BM_Load loads the records into an empty index, one by one or in bulk.
+void BM_Load(benchmark::State &state, bool bulk) {
+    std::vector<std::pair<IntKey, uint64_t>> records;
+    for (uint64_t i = 0; i < recordCount; i++) {
+        records.emplace_back(recordKey(i), i);
+    }
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto index = std::make_unique<BwTreeIndex<IntKey>>(true, false);
+        state.ResumeTiming();
+        if (bulk) {
+            index->BulkLoad(records);
+        } else {
+            for (const auto &[key, value] : records) {
+                index->Insert(key, value);
+            }
+        }
+        state.PauseTiming();
+        index.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+// BM_Scan scans the whole table, a pair or a leaf at a time.
+void BM_Scan(benchmark::State &state, bool batch) {
+    auto &t = loadedTable();
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        if (batch) {
+            for (auto it = t.Index.IterBatch(); it.Next();) {
+                for (auto v : it.Values()) {
+                    sum += v;
+                }
+            }
+        } else {
+            for (auto it = t.Index.Iter(); it.Valid(); it.Next()) {
+                sum += it.Value();
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * t.Index.Size());
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_Load, Insert, false)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_Load, Bulk, true)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_Scan, Iter, false)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Scan, Batch, true)->Unit(benchmark::kMillisecond);
+
+// A: update heavy, B: read mostly, C: read only, E: short ranges. E runs last since it grows the table.
+BENCHMARK_CAPTURE(BM_YCSB, A, workload{0.5, 0.5, 0, 0})->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_CAPTURE(BM_YCSB, B, workload{0.95, 0.05, 0, 0})->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_CAPTURE(BM_YCSB, C, workload{1, 0, 0, 0})->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_CAPTURE(BM_YCSB, E, workload{0, 0, 0.95, 0.05})->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "storage/index/handle_index.hh"
+
+using namespace storage::index;
+
+// Point lookups by primary key, `WHERE pk = ?` and `WHERE pk IN (...)`, served by the ordered index alone or by its
+// hash table.
+
+namespace {
+
+constexpr int64_t rowCount = 1 << 20;
+constexpr size_t inListLength = 64;
+
+// loadedIndex returns the index of rowCount rows, with or without the hash table, shared by the benchmarks.
+HandleIndex &loadedIndex(bool withHash) {
+    static auto load = [](bool hash) {
+        auto index = std::make_unique<HandleIndex>(hash, rowCount);
+        std::vector<std::pair<int64_t, RowLocation>> rows;
+        for (int64_t h = 0; h < rowCount; h++) {
+            rows.emplace_back(h, static_cast<RowLocation>(h));
+        }
+        index->BulkLoad(std::move(rows));
+        return index;
+    };
+    static auto tree = load(false);
+    static auto hash = load(true);
+    return withHash ? *hash : *tree;
+}
+
+uint64_t nextSeed() {
+    static std::atomic<uint64_t> seed{0};
+    return seed.fetch_add(1);
+}
+
+void BM_Get(benchmark::State &state, bool withHash) {
+    auto &index = loadedIndex(withHash);
+    std::mt19937_64 rng(nextSeed());
+    std::uniform_int_distribution<int64_t> pick(0, rowCount - 1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(index.Get(pick(rng)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_BatchGet(benchmark::State &state, bool withHash) {
+    auto &index = loadedIndex(withHash);
+    std::mt19937_64 rng(nextSeed());
+    std::uniform_int_distribution<int64_t> pick(0, rowCount - 1);
+    std::vector<int64_t> handles(inListLength);
+    std::vector<std::optional<RowLocation>> out;
+    for (auto _ : state) {
+        for (auto &h : handles) {
+            h = pick(rng);
+        }
+        index.BatchGet(handles, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * inListLength);
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_Get, Tree, false)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_CAPTURE(BM_Get, Hash, true)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_CAPTURE(BM_BatchGet, Tree, false)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_CAPTURE(BM_BatchGet, Hash, true)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,122 @@
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "parser/mysql/const.hh"
+#include "parser/mysql/type.hh"
+#include "server/resultset_encoder.hh"
+#include "util/chunk/arrow_ipc.hh"
+
+using namespace util::chunk;
+
+// A result of numRows rows of a BIGINT, a DOUBLE and a VARCHAR(32) column, in chunks of defaultCapacity rows:
+// serialized as the text protocol rows of the MySQL protocol by server::ResultSetEncoder, as an Arrow IPC stream by
+// ArrowWriter to /dev/null, and read back from memory by ArrowReader. The bytes processed are those of the output.
+
+namespace {
+
+constexpr size_t numRows = 64 * defaultCapacity;
+
+const std::vector<Field> fields{
+    {"id", mysql::TypeLonglong, 0},
+    {"price", mysql::TypeDouble, 0},
+    {"name", mysql::TypeVarString, 0},
+};
+
+std::vector<Chunk> newChunks() {
+    std::vector<uint8_t> types;
+    for (const auto &f : fields) {
+        types.push_back(f.Type);
+    }
+    std::vector<Chunk> chunks;
+    for (size_t row = 0; row < numRows;) {
+        Chunk chk(types);
+        for (size_t i = 0; i < defaultCapacity; i++, row++) {
+            chk.Col(0).AppendInt64(static_cast<int64_t>(row * 2654435761u % 1000000007));
+            chk.Col(1).AppendFloat64(static_cast<double>(row % 100000) / 100);
+            chk.Col(2).AppendBytes("name-" + std::to_string(row) + std::string(row % 24, 'x'));
+        }
+        chunks.push_back(std::move(chk));
+    }
+    return chunks;
+}
+
+void BM_EncodeText(benchmark::State &state) {
+    auto chunks = newChunks();
+    std::vector<server::ColumnInfo> columns;
+    for (const auto &f : fields) {
+        server::ColumnInfo column;
+        column.Name = f.Name;
+        column.Type = f.Type;
+        columns.push_back(column);
+    }
+    server::ResultSetEncoder encoder(columns, mysql::ClientProtocol41);
+    server::PacketBuffer buffer;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        for (const auto &chk : chunks) {
+            auto batch = server::ColumnBatchOf(chk);
+            for (size_t begin = 0; begin < batch.numRows;) {
+                begin = encoder.encodeTextRows(buffer, batch, begin);
+                bytes += buffer.size();
+                buffer.clear();
+            }
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * numRows));
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+void BM_WriteArrow(benchmark::State &state) {
+    auto chunks = newChunks();
+    auto fd = ::open("/dev/null", O_WRONLY);
+    size_t bytes = 0;
+    for (auto _ : state) {
+        ArrowWriter writer(fd, "/dev/null", fields, ArrowFormat::Stream);
+        for (const auto &chk : chunks) {
+            writer.Write(chk);
+        }
+        writer.Finish();
+        bytes += writer.BytesWritten();
+    }
+    ::close(fd);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * numRows));
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+void BM_ReadArrow(benchmark::State &state) {
+    auto chunks = newChunks();
+    auto path = "/tmp/arrow_ipc_benchmark." + std::to_string(::getpid()) + ".arrows";
+    size_t size = 0;
+    {
+        auto [writer, err] = ArrowWriter::Create(path, fields, ArrowFormat::Stream);
+        for (const auto &chk : chunks) {
+            writer->Write(chk);
+        }
+        writer->Finish();
+        size = writer->BytesWritten();
+    }
+    auto [reader, err] = ArrowReader::Open(path);
+    ::unlink(path.c_str());
+    for (auto _ : state) {
+        Chunk chk;
+        int64_t sum = 0;
+        for (size_t i = 0; i < reader->NumBatches(); i++) {
+            reader->ReadBatch(i, chk);
+            sum += chk.Col(0).GetInt64(0);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * numRows));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * size));
+}
+
+}  // namespace
+
+BENCHMARK(BM_EncodeText)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_WriteArrow)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ReadArrow)->Unit(benchmark::kMillisecond);
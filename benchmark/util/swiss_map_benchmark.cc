@@ -0,0 +1,101 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "libcuckoo/cuckoohash_map.hh"
+#include "util/hash/swiss_map.hh"
+
+using namespace util::hash;
+
+// The build and the probe side of a hash join on a single thread, with the Swiss table and with libcuckoo, both
+// hashing with XXH3: the build inserts n distinct keys into a table sized for them, the probe looks up n keys of
+// which half exist.
+
+namespace {
+
+using swissMap = SwissMap<int64_t, int64_t>;
+using cuckooMap = cuckoohash_map<int64_t, int64_t, XXHash<int64_t>>;
+
+std::vector<int64_t> randomKeys(size_t n, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<int64_t> keys(n);
+    for (auto &k : keys) {
+        k = static_cast<int64_t>(rng());
+    }
+    return keys;
+}
+
+// probeKeys returns n keys, every other one from keys.
+std::vector<int64_t> probeKeys(const std::vector<int64_t> &keys) {
+    auto probes = randomKeys(keys.size(), 2);
+    for (size_t i = 0; i < probes.size(); i += 2) {
+        probes[i] = keys[(i * 7919) % keys.size()];
+    }
+    return probes;
+}
+
+template <typename Map>
+void insert(Map &m, int64_t key, int64_t value) {
+    if constexpr (std::is_same_v<Map, swissMap>) {
+        m.TryEmplace(key, value);
+    } else {
+        m.insert(key, value);
+    }
+}
+
+template <typename Map>
+bool find(const Map &m, int64_t key, int64_t &value) {
+    if constexpr (std::is_same_v<Map, swissMap>) {
+        const auto *v = m.Find(key);
+        if (v != nullptr) {
+            value = *v;
+        }
+        return v != nullptr;
+    } else {
+        return m.find(key, value);
+    }
+}
+
+template <typename Map>
+void BM_Build(benchmark::State &state) {
+    auto keys = randomKeys(state.range(0), 1);
+    for (auto _ : state) {
+        Map m(keys.size());
+        for (auto k : keys) {
+            insert(m, k, k);
+        }
+        benchmark::DoNotOptimize(m);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Map>
+void BM_Probe(benchmark::State &state) {
+    auto keys = randomKeys(state.range(0), 1);
+    Map m(keys.size());
+    for (auto k : keys) {
+        insert(m, k, k);
+    }
+    auto probes = probeKeys(keys);
+    for (auto _ : state) {
+        int64_t sum = 0;
+        for (auto k : probes) {
+            int64_t v;
+            if (find(m, k, v)) {
+                sum += v;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_Build, swissMap)->RangeMultiplier(64)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Build, cuckooMap)->RangeMultiplier(64)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Probe, swissMap)->RangeMultiplier(64)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Probe, cuckooMap)->RangeMultiplier(64)->Range(1 << 10, 1 << 22);
@@ -0,0 +1,45 @@
+#include "common/logger.hh"
+
+#include <spdlog/async.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/sinks/stdout_sinks.h>
+
+namespace common {
+
+namespace {
+
+// logQueueSize is the number of messages queued for the background thread before the oldest ones are dropped.
+constexpr size_t logQueueSize = 8192;
+
+std::shared_ptr<spdlog::logger> newLogger(const std::string &file) {
+    // The pool, i.e. the queue and the thread writing it, is shared by all the loggers and outlives them.
+    static auto pool = std::make_shared<spdlog::details::thread_pool>(logQueueSize, 1);
+    spdlog::sink_ptr sink;
+    if (file.empty()) {
+        sink = std::make_shared<spdlog::sinks::stderr_sink_mt>();
+    } else {
+        sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(file);
+    }
+    auto logger = std::make_shared<spdlog::async_logger>("pxtidb", std::move(sink), pool,
+                                                         spdlog::async_overflow_policy::overrun_oldest);
+    // Like TiDB: [2021/10/28 10:11:12.123 +08:00] [info] [server.cc:42] message
+    logger->set_pattern("[%Y/%m/%d %H:%M:%S.%e %z] [%l] [%s:%#] %v");
+    return logger;
+}
+
+std::shared_ptr<spdlog::logger> &globalLogger() {
+    static auto logger = newLogger("");
+    return logger;
+}
+
+}  // namespace
+
+const std::shared_ptr<spdlog::logger> &Logger() { return globalLogger(); }
+
+void InitLogger(const std::string &file, spdlog::level::level_enum level) {
+    auto logger = newLogger(file);
+    logger->set_level(level);
+    globalLogger() = std::move(logger);
+}
+
+}  // namespace common
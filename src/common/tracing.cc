@@ -0,0 +1,139 @@
+#include "common/tracing.hh"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <unordered_set>
+
+namespace common::tracing {
+
+namespace {
+
+// processStart is the origin of the trace timestamps, taken during static initialization.
+struct processStart {
+    uint64_t Ticks{ReadTSC()};
+    std::chrono::steady_clock::time_point Time{std::chrono::steady_clock::now()};
+};
+
+const processStart &origin() {
+    static processStart start;
+    return start;
+}
+
+[[maybe_unused]] const processStart &initOrigin = origin();
+
+thread_local std::unique_ptr<recorder> threadRecorder;
+
+}  // namespace
+
+TickConverter::TickConverter() : _origin(origin().Ticks), _nanosPerTick(1) {
+    auto ticks = ReadTSC() - _origin;
+    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin().Time);
+    if (ticks > 0 && nanos.count() > 0) {
+        _nanosPerTick = static_cast<double>(nanos.count()) / static_cast<double>(ticks);
+    }
+}
+
+uint64_t TickConverter::ToNanos(uint64_t ticks) const {
+    return ticks > _origin ? static_cast<uint64_t>(static_cast<double>(ticks - _origin) * _nanosPerTick) : 0;
+}
+
+TraceScope::TraceScope(bool enabled) {
+    // A command has one trace: there is no nested trace.
+    if (!enabled || activeRecorder != nullptr) {
+        return;
+    }
+    // The command owns the buffer of the thread until it finishes, as it may suspend and resume on another thread
+    // while the first one runs other commands.
+    _recorder = threadRecorder != nullptr ? std::move(threadRecorder) : std::make_unique<recorder>();
+    activeRecorder = _recorder.get();
+}
+
+TraceScope::~TraceScope() {
+    if (_recorder != nullptr) {
+        release();
+    }
+}
+
+Trace TraceScope::Finish(uint32_t connID, std::string label) {
+    Trace trace;
+    if (_recorder == nullptr) {
+        return trace;
+    }
+    trace.ConnID = connID;
+    trace.Label = std::move(label);
+    trace.Truncated = _recorder->_truncated;
+    trace.Events.assign(_recorder->_events, _recorder->_events + _recorder->_n);
+    auto now = ReadTSC();
+    for (auto &e : trace.Events) {
+        if (e.End == 0) {
+            e.End = now;
+        }
+    }
+    release();
+    return trace;
+}
+
+void TraceScope::release() {
+    _recorder->_n = 0;
+    _recorder->_truncated = false;
+    activeRecorder = nullptr;
+    // The buffer goes to the thread the command finished on.
+    if (threadRecorder == nullptr) {
+        threadRecorder = std::move(_recorder);
+    }
+    _recorder = nullptr;
+}
+
+void TraceLog::Add(Trace trace) {
+    std::lock_guard lock(_mu);
+    _traces.push_back(std::move(trace));
+    while (_traces.size() > _capacity) {
+        _traces.pop_front();
+    }
+}
+
+size_t TraceLog::Size() const {
+    std::lock_guard lock(_mu);
+    return _traces.size();
+}
+
+void TraceLog::WriteChromeJSON(std::string &out) const {
+    TickConverter clock;
+    auto pid = getpid();
+    auto micros = [&](uint64_t ticks) { return static_cast<double>(clock.ToNanos(ticks)) / 1000; };
+
+    auto events = nlohmann::json::array();
+    std::unordered_set<uint32_t> conns;
+    std::lock_guard lock(_mu);
+    for (auto &trace : _traces) {
+        if (conns.insert(trace.ConnID).second) {
+            events.push_back({{"name", "thread_name"},
+                              {"ph", "M"},
+                              {"pid", pid},
+                              {"tid", trace.ConnID},
+                              {"args", {{"name", "conn " + std::to_string(trace.ConnID)}}}});
+        }
+        for (size_t i = 0; i < trace.Events.size(); i++) {
+            auto &e = trace.Events[i];
+            nlohmann::json event = {{"name", e.Name},
+                                    {"cat", "pxtidb"},
+                                    {"ph", "X"},
+                                    {"ts", micros(e.Begin)},
+                                    {"dur", micros(e.End) - micros(e.Begin)},
+                                    {"pid", pid},
+                                    {"tid", trace.ConnID}};
+            // The first span is the root of the trace.
+            if (i == 0) {
+                event["args"] = {{"label", trace.Label}, {"truncated", trace.Truncated}};
+            }
+            events.push_back(std::move(event));
+        }
+    }
+    nlohmann::json doc = {{"traceEvents", std::move(events)}, {"displayTimeUnit", "ns"}};
+    // The labels are statement texts, which may not be valid UTF-8.
+    out += doc.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+}  // namespace common::tracing
@@ -0,0 +1,785 @@
+#include "executor/aggregate.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_for_each.h>
+#include <tbb/task_arena.h>
+
+#include "executor/executor.hh"
+#include "expression/builtin.hh"
+#include "parser/misc.hh"
+#include "parser/token.hh"
+#include "util/codec/codec.hh"
+#include "util/hash/swiss_map.hh"
+#include "util/sketch/hyperloglog.hh"
+#include "util/sketch/kll.hh"
+
+namespace executor {
+
+using expression::argument;
+using expression::EvalContext;
+using expression::EvalType;
+using expression::FieldType;
+using expression::Rows;
+using util::chunk::Chunk;
+using util::chunk::Column;
+using util::sketch::HyperLogLog;
+using util::sketch::KLLSketch;
+
+namespace {
+
+// radixBits is the number of the high bits of the hash of a key that give its partition.
+constexpr int radixBits = 6;
+constexpr size_t numPartitions = size_t{1} << radixBits;
+
+struct keyHash {
+    size_t operator()(std::string_view key) const { return XXH3_64bits(key.data(), key.size()); }
+};
+
+// groupMap maps the keys of the groups to their index.
+using groupMap = util::hash::SwissMap<std::string, uint32_t, keyHash, std::equal_to<>>;
+
+size_t partitionOf(std::string_view key) { return keyHash()(key) >> (64 - radixBits); }
+
+// aggKind is an aggregate function of the eval type of its argument.
+enum class aggKind : uint8_t {
+    countAll,
+    count,
+    sumInt,
+    sumUint,
+    sumReal,
+    avg,
+    minInt,
+    maxInt,
+    minUint,
+    maxUint,
+    minReal,
+    maxReal,
+    approxCountDistinct,
+    approxPercentile,
+};
+
+// sketch is the state of APPROX_COUNT_DISTINCT or APPROX_PERCENTILE in a group.
+using sketch = std::variant<HyperLogLog, KLLSketch>;
+
+// sketchOf returns the sketch T of a state, allocating it with the first value.
+template <typename T>
+T &sketchOf(std::unique_ptr<sketch> &s) {
+    if (s == nullptr) {
+        s = std::make_unique<sketch>(std::in_place_type<T>);
+    }
+    return std::get<T>(*s);
+}
+
+uint64_t hashOf(const void *p, size_t n) { return XXH3_64bits(p, n); }
+
+// columnType returns the type of the column of the values of an expression of type tp, in the storage of its eval
+// type.
+FieldType columnType(FieldType tp) {
+    switch (tp.GetEvalType()) {
+        case EvalType::Int:
+            if (tp.Tp == mysql::TypeNull) {
+                tp.Tp = mysql::TypeLonglong;
+            }
+            break;
+        case EvalType::Real:
+            tp.Tp = mysql::TypeDouble;
+            break;
+        case EvalType::String:
+            break;
+    }
+    return tp;
+}
+
+const char *funcName(AggFunc f) {
+    switch (f) {
+        case AggFunc::Count:
+            return "count";
+        case AggFunc::Sum:
+            return "sum";
+        case AggFunc::Avg:
+            return "avg";
+        case AggFunc::Min:
+            return "min";
+        case AggFunc::Max:
+            return "max";
+        case AggFunc::ApproxCountDistinct:
+            return "approx_count_distinct";
+        case AggFunc::ApproxPercentile:
+            return "approx_percentile";
+    }
+    return "";
+}
+
+}  // namespace
+
+// aggState is the state of an aggregate function in a group: the number of its values that are not null, or of its
+// rows for COUNT(*), and their sum, minimum or maximum in Int, the bits of a uint64_t if unsigned, or Real, or their
+// sketch.
+struct AggExec::aggState {
+    int64_t Int{0};
+    double Real{0};
+    int64_t Count{0};
+    std::unique_ptr<sketch> Sketch;
+};
+
+struct AggExec::aggregator {
+    aggKind Kind;
+    // Arg is null for COUNT(*).
+    expression::ExprPtr Arg;
+    EvalType ArgType;
+    FieldType Type;
+    // Quantile is the quantile of APPROX_PERCENTILE, in (0, 1].
+    double Quantile{0};
+    // Name is the function in SQL, for the errors.
+    std::string Name;
+
+    // Update adds the values of arg for rows to the states of their groups, the i-th row to states[rowGroups[i] *
+    // stride]. It returns false if a sum overflows.
+    bool Update(const argument &arg, const Rows &rows, const uint32_t *rowGroups, aggState *states,
+                size_t stride) const {
+        bool overflow = false;
+        switch (Kind) {
+            case aggKind::countAll:
+                for (size_t i = 0; i < rows.Size(); i++) {
+                    states[rowGroups[i] * stride].Count++;
+                }
+                break;
+            case aggKind::count: {
+                size_t i = 0;
+                rows.ForEach([&](size_t row) {
+                    auto g = rowGroups[i++];
+                    states[g * stride].Count += !arg.IsNull(row);
+                });
+                break;
+            }
+            case aggKind::sumInt:
+                forEach<int64_t>(arg, rows, rowGroups, states, stride, [&](aggState &s, int64_t v) {
+                    overflow |= __builtin_add_overflow(s.Int, v, &s.Int);
+                });
+                break;
+            case aggKind::sumUint:
+                forEach<uint64_t>(arg, rows, rowGroups, states, stride, [&](aggState &s, uint64_t v) {
+                    overflow |= addUint(s, v);
+                });
+                break;
+            case aggKind::sumReal:
+            case aggKind::avg:
+                forEach<double>(arg, rows, rowGroups, states, stride, [](aggState &s, double v) { s.Real += v; });
+                break;
+            case aggKind::minInt:
+                forEach<int64_t>(arg, rows, rowGroups, states, stride, [](aggState &s, int64_t v) {
+                    s.Int = s.Count == 0 ? v : std::min(s.Int, v);
+                });
+                break;
+            case aggKind::maxInt:
+                forEach<int64_t>(arg, rows, rowGroups, states, stride, [](aggState &s, int64_t v) {
+                    s.Int = s.Count == 0 ? v : std::max(s.Int, v);
+                });
+                break;
+            case aggKind::minUint:
+                forEach<uint64_t>(arg, rows, rowGroups, states, stride, [](aggState &s, uint64_t v) {
+                    s.Int = static_cast<int64_t>(s.Count == 0 ? v : std::min(static_cast<uint64_t>(s.Int), v));
+                });
+                break;
+            case aggKind::maxUint:
+                forEach<uint64_t>(arg, rows, rowGroups, states, stride, [](aggState &s, uint64_t v) {
+                    s.Int = static_cast<int64_t>(s.Count == 0 ? v : std::max(static_cast<uint64_t>(s.Int), v));
+                });
+                break;
+            case aggKind::minReal:
+                forEach<double>(arg, rows, rowGroups, states, stride, [](aggState &s, double v) {
+                    s.Real = s.Count == 0 ? v : std::min(s.Real, v);
+                });
+                break;
+            case aggKind::maxReal:
+                forEach<double>(arg, rows, rowGroups, states, stride, [](aggState &s, double v) {
+                    s.Real = s.Count == 0 ? v : std::max(s.Real, v);
+                });
+                break;
+            case aggKind::approxCountDistinct:
+                updateDistinct(arg, rows, rowGroups, states, stride);
+                break;
+            case aggKind::approxPercentile:
+                updatePercentile(arg, rows, rowGroups, states, stride);
+                break;
+        }
+        return !overflow;
+    }
+
+    // Merge adds the state o of a group, whose sketch it may take, to its state s. It returns false if a sum
+    // overflows.
+    bool Merge(aggState &s, aggState &o) const {
+        bool overflow = false;
+        if (o.Count > 0) {
+            auto first = s.Count == 0;
+            switch (Kind) {
+                case aggKind::countAll:
+                case aggKind::count:
+                    break;
+                case aggKind::sumInt:
+                    overflow = __builtin_add_overflow(s.Int, o.Int, &s.Int);
+                    break;
+                case aggKind::sumUint:
+                    overflow = addUint(s, static_cast<uint64_t>(o.Int));
+                    break;
+                case aggKind::sumReal:
+                case aggKind::avg:
+                    s.Real += o.Real;
+                    break;
+                case aggKind::minInt:
+                    s.Int = first ? o.Int : std::min(s.Int, o.Int);
+                    break;
+                case aggKind::maxInt:
+                    s.Int = first ? o.Int : std::max(s.Int, o.Int);
+                    break;
+                case aggKind::minUint:
+                    s.Int = first || static_cast<uint64_t>(o.Int) < static_cast<uint64_t>(s.Int) ? o.Int : s.Int;
+                    break;
+                case aggKind::maxUint:
+                    s.Int = first || static_cast<uint64_t>(o.Int) > static_cast<uint64_t>(s.Int) ? o.Int : s.Int;
+                    break;
+                case aggKind::minReal:
+                    s.Real = first ? o.Real : std::min(s.Real, o.Real);
+                    break;
+                case aggKind::maxReal:
+                    s.Real = first ? o.Real : std::max(s.Real, o.Real);
+                    break;
+                case aggKind::approxCountDistinct:
+                    mergeSketch<HyperLogLog>(s, o);
+                    break;
+                case aggKind::approxPercentile:
+                    mergeSketch<KLLSketch>(s, o);
+                    break;
+            }
+        }
+        s.Count += o.Count;
+        return !overflow;
+    }
+
+    // Append appends the result of the state s to col.
+    void Append(const aggState &s, Column &col) const {
+        if (Kind == aggKind::countAll || Kind == aggKind::count) {
+            col.AppendInt64(s.Count);
+            return;
+        }
+        if (Kind == aggKind::approxCountDistinct) {
+            col.AppendInt64(s.Count == 0 ? 0 : static_cast<int64_t>(std::get<HyperLogLog>(*s.Sketch).Estimate()));
+            return;
+        }
+        if (s.Count == 0) {
+            col.AppendNull();
+            return;
+        }
+        switch (Kind) {
+            case aggKind::sumUint:
+            case aggKind::minUint:
+            case aggKind::maxUint:
+                col.AppendUint64(static_cast<uint64_t>(s.Int));
+                break;
+            case aggKind::sumReal:
+            case aggKind::minReal:
+            case aggKind::maxReal:
+                col.AppendFloat64(s.Real);
+                break;
+            case aggKind::avg:
+                col.AppendFloat64(s.Real / static_cast<double>(s.Count));
+                break;
+            case aggKind::approxPercentile: {
+                auto v = std::get<KLLSketch>(*s.Sketch).Quantile(Quantile);
+                if (ArgType == EvalType::Real) {
+                    col.AppendFloat64(util::codec::DecodeCmpUintToFloat(v));
+                } else if (Type.IsUnsigned()) {
+                    col.AppendUint64(v);
+                } else {
+                    col.AppendInt64(util::codec::DecodeCmpUintToInt(v));
+                }
+                break;
+            }
+            default:
+                col.AppendInt64(s.Int);
+                break;
+        }
+    }
+
+    mysql::SQLError ErrOverflow() const {
+        return mysql::NewErr(mysql::ErrDataOutOfRange, Kind == aggKind::sumUint ? "BIGINT UNSIGNED" : "BIGINT",
+                             Name.c_str());
+    }
+
+private:
+    // forEach calls f with the state of the group and the value of every row of arg that is not null, then counts
+    // the value.
+    template <typename T, typename F>
+    static void forEach(const argument &arg, const Rows &rows, const uint32_t *rowGroups, aggState *states,
+                        size_t stride, F &&f) {
+        size_t i = 0;
+        rows.ForEach([&](size_t row) {
+            auto g = rowGroups[i++];
+            if (!arg.IsNull(row)) {
+                auto &s = states[g * stride];
+                if constexpr (std::is_same_v<T, std::string_view>) {
+                    f(s, arg.Bytes(row));
+                } else {
+                    f(s, arg.Value<T>(row));
+                }
+                s.Count++;
+            }
+        });
+    }
+
+    // updateDistinct adds the hashes of the values to the HyperLogLogs of APPROX_COUNT_DISTINCT.
+    void updateDistinct(const argument &arg, const Rows &rows, const uint32_t *rowGroups, aggState *states,
+                        size_t stride) const {
+        switch (ArgType) {
+            case EvalType::Int:
+                forEach<int64_t>(arg, rows, rowGroups, states, stride, [](aggState &s, int64_t v) {
+                    sketchOf<HyperLogLog>(s.Sketch).Update(hashOf(&v, sizeof(v)));
+                });
+                break;
+            case EvalType::Real:
+                forEach<double>(arg, rows, rowGroups, states, stride, [](aggState &s, double v) {
+                    // -0 and 0 are the same value.
+                    v = v == 0 ? 0 : v;
+                    sketchOf<HyperLogLog>(s.Sketch).Update(hashOf(&v, sizeof(v)));
+                });
+                break;
+            case EvalType::String:
+                forEach<std::string_view>(arg, rows, rowGroups, states, stride, [](aggState &s, std::string_view v) {
+                    sketchOf<HyperLogLog>(s.Sketch).Update(hashOf(v.data(), v.size()));
+                });
+                break;
+        }
+    }
+
+    // updatePercentile adds the values to the KLL sketches of APPROX_PERCENTILE, as uint64_t that sort like them.
+    void updatePercentile(const argument &arg, const Rows &rows, const uint32_t *rowGroups, aggState *states,
+                          size_t stride) const {
+        if (ArgType == EvalType::Real) {
+            forEach<double>(arg, rows, rowGroups, states, stride, [](aggState &s, double v) {
+                sketchOf<KLLSketch>(s.Sketch).Update(util::codec::EncodeFloatToCmpUint(v));
+            });
+        } else if (Type.IsUnsigned()) {
+            forEach<uint64_t>(arg, rows, rowGroups, states, stride,
+                              [](aggState &s, uint64_t v) { sketchOf<KLLSketch>(s.Sketch).Update(v); });
+        } else {
+            forEach<int64_t>(arg, rows, rowGroups, states, stride, [](aggState &s, int64_t v) {
+                sketchOf<KLLSketch>(s.Sketch).Update(util::codec::EncodeIntToCmpUint(v));
+            });
+        }
+    }
+
+    // mergeSketch merges the sketch T of o, which has values, into that of s.
+    template <typename T>
+    static void mergeSketch(aggState &s, aggState &o) {
+        if (s.Sketch == nullptr) {
+            s.Sketch = std::move(o.Sketch);
+        } else {
+            std::get<T>(*s.Sketch).Merge(std::get<T>(*o.Sketch));
+        }
+    }
+
+    static bool addUint(aggState &s, uint64_t v) {
+        uint64_t sum;
+        auto overflow = __builtin_add_overflow(static_cast<uint64_t>(s.Int), v, &sum);
+        s.Int = static_cast<int64_t>(sum);
+        return overflow;
+    }
+};
+
+// groups are groups of keys and the states of their aggregates, a run of _aggs.size() states per key.
+struct AggExec::groups {
+    std::vector<std::string> Keys;
+    std::vector<aggState> States;
+};
+
+// partial is the state of a thread of the hash aggregation: the groups of the chunks it took since its table was last
+// flushed, and the groups it flushed by partition.
+class AggExec::partial {
+public:
+    explicit partial(const AggExec &agg) : _agg(agg) {
+        Ctx.Mode = agg._opts.Mode;
+        Ctx.InDML = agg._opts.InDML;
+        _table.Reserve(agg._opts.PartialGroups);
+    }
+
+    std::optional<mysql::SQLError> Add(const Chunk &chk) {
+        if (auto err = EncodeKeys(Ctx, _agg._groupBy, chk, _keys)) {
+            return err;
+        }
+        auto n = chk.NumRows();
+        if (_table.Size() + n > _agg._opts.PartialGroups) {
+            Flush();
+        }
+        auto numAggs = _agg._aggs.size();
+        _rowGroups.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            auto [g, inserted] = _table.TryEmplace(std::move(_keys[i]), static_cast<uint32_t>(_table.Size()));
+            if (inserted) {
+                _states.resize(_states.size() + numAggs);
+            }
+            _rowGroups[i] = *g;
+        }
+        return _agg.update(Ctx, chk, _rowGroups.data(), _states.data());
+    }
+
+    // Flush moves the groups of the table to their partitions.
+    void Flush() {
+        auto numAggs = _agg._aggs.size();
+        _table.ForEach([&](const std::string &key, uint32_t g) {
+            auto &part = Parts[partitionOf(key)];
+            part.Keys.push_back(key);
+            part.States.insert(part.States.end(), std::make_move_iterator(_states.begin() + g * numAggs),
+                               std::make_move_iterator(_states.begin() + (g + 1) * numAggs));
+        });
+        _table.Clear();
+        _states.clear();
+    }
+
+    EvalContext Ctx;
+    std::array<groups, numPartitions> Parts;
+    std::optional<mysql::SQLError> Err;
+
+private:
+    const AggExec &_agg;
+    groupMap _table;
+    std::vector<aggState> _states;
+    std::vector<std::string> _keys;
+    std::vector<uint32_t> _rowGroups;
+};
+
+AggStrategy AggStrategyOfHints(const std::string &lit) {
+    bool hash = false, stream = false;
+    for (auto tok : parser::getHintTokens(lit)) {
+        switch (tok) {
+            case parser::tok_hintHashAgg:
+                hash = true;
+                break;
+            case parser::tok_hintStreamAgg:
+                stream = true;
+                break;
+        }
+    }
+    if (hash == stream) {
+        return AggStrategy::Auto;
+    }
+    return hash ? AggStrategy::Hash : AggStrategy::Stream;
+}
+
+AggExec::AggExec(std::vector<expression::ExprPtr> groupBy, std::vector<aggregator> aggs, AggOptions opts)
+    : _groupBy(std::move(groupBy)), _aggs(std::move(aggs)), _opts(opts) {
+    for (const auto &e : _groupBy) {
+        _fieldTypes.push_back(columnType(e->Type()));
+    }
+    for (const auto &a : _aggs) {
+        _fieldTypes.push_back(a.Type);
+    }
+    for (const auto &tp : _fieldTypes) {
+        _columnTypes.push_back(tp.Tp);
+    }
+}
+
+AggExec::~AggExec() = default;
+
+std::tuple<std::unique_ptr<AggExec>, std::optional<mysql::SQLError>> AggExec::New(
+    std::vector<expression::ExprPtr> groupBy, std::vector<AggFuncDesc> aggs, AggOptions opts) {
+    std::vector<aggregator> aggregators;
+    for (auto &desc : aggs) {
+        aggregator a;
+        if (desc.Arg == nullptr) {
+            if (desc.Func != AggFunc::Count) {
+                return {nullptr, mysql::NewErr(mysql::ErrUnknown, "aggregate function without argument")};
+            }
+            a.Kind = aggKind::countAll;
+            a.ArgType = EvalType::Int;
+            a.Type = {mysql::TypeLonglong, 0};
+            a.Name = "count(*)";
+            aggregators.push_back(std::move(a));
+            continue;
+        }
+        a.Name = std::string(funcName(desc.Func)) + "(" + desc.Arg->String() + ")";
+        auto argType = desc.Arg->GetEvalType();
+        auto isUnsigned = desc.Arg->Type().IsUnsigned();
+        if (desc.Func != AggFunc::Count && desc.Func != AggFunc::ApproxCountDistinct && argType == EvalType::String) {
+            return {nullptr, mysql::NewErr(mysql::ErrNotSupportedYet, a.Name.c_str())};
+        }
+        a.ArgType = argType;
+        switch (desc.Func) {
+            case AggFunc::Count:
+                a.Kind = aggKind::count;
+                a.Type = {mysql::TypeLonglong, 0};
+                break;
+            case AggFunc::Sum:
+                a.Kind = argType == EvalType::Real ? aggKind::sumReal : isUnsigned ? aggKind::sumUint : aggKind::sumInt;
+                a.Type = {argType == EvalType::Real ? mysql::TypeDouble : mysql::TypeLonglong, 0};
+                if (a.Kind == aggKind::sumUint) {
+                    a.Type.Flag = mysql::UnsignedFlag;
+                }
+                break;
+            case AggFunc::Avg:
+                a.Kind = aggKind::avg;
+                a.ArgType = EvalType::Real;
+                a.Type = {mysql::TypeDouble, 0};
+                break;
+            case AggFunc::Min:
+            case AggFunc::Max: {
+                auto min = desc.Func == AggFunc::Min;
+                a.Kind = argType == EvalType::Real ? (min ? aggKind::minReal : aggKind::maxReal)
+                         : isUnsigned             ? (min ? aggKind::minUint : aggKind::maxUint)
+                                                  : (min ? aggKind::minInt : aggKind::maxInt);
+                a.Type = columnType(desc.Arg->Type());
+                a.Type.Flag &= ~mysql::NotNullFlag;
+                break;
+            }
+            case AggFunc::ApproxCountDistinct:
+                a.Kind = aggKind::approxCountDistinct;
+                a.Type = {mysql::TypeLonglong, 0};
+                break;
+            case AggFunc::ApproxPercentile:
+                a.Name.insert(a.Name.size() - 1, ", " + std::to_string(desc.Percent));
+                if (desc.Percent < 1 || desc.Percent > 100) {
+                    return {nullptr, mysql::NewErr(mysql::ErrWrongArguments, a.Name.c_str())};
+                }
+                a.Kind = aggKind::approxPercentile;
+                a.Quantile = static_cast<double>(desc.Percent) / 100;
+                a.Type = columnType(desc.Arg->Type());
+                a.Type.Flag &= ~mysql::NotNullFlag;
+                break;
+        }
+        a.Arg = std::move(desc.Arg);
+        aggregators.push_back(std::move(a));
+    }
+    return {std::unique_ptr<AggExec>(new AggExec(std::move(groupBy), std::move(aggregators), opts)), std::nullopt};
+}
+
+std::optional<mysql::SQLError> AggExec::update(EvalContext &ctx, const Chunk &chk, const uint32_t *rowGroups,
+                                               aggState *states) const {
+    auto rows = Rows::Of(chk);
+    for (size_t a = 0; a < _aggs.size(); a++) {
+        const auto &agg = _aggs[a];
+        argument arg(ctx);
+        if (agg.Arg != nullptr) {
+            if (auto err = arg.Eval(*agg.Arg, agg.ArgType, chk, rows)) {
+                return err;
+            }
+        }
+        if (!agg.Update(arg, rows, rowGroups, states + a, _aggs.size())) {
+            return agg.ErrOverflow();
+        }
+    }
+    return std::nullopt;
+}
+
+std::tuple<size_t, std::optional<mysql::SQLError>> AggExec::stream(std::span<const Chunk> input, groups &streamed) {
+    EvalContext ctx;
+    ctx.Mode = _opts.Mode;
+    ctx.InDML = _opts.InDML;
+    std::vector<std::string> keys;
+    std::vector<uint32_t> rowGroups;
+    size_t c = 0;
+    for (; c < input.size(); c++) {
+        if (auto err = EncodeKeys(ctx, _groupBy, input[c], keys)) {
+            return {c, err};
+        }
+        if (!std::is_sorted(keys.begin(), keys.end()) ||
+            (!keys.empty() && !streamed.Keys.empty() && keys.front() < streamed.Keys.back())) {
+            break;
+        }
+        rowGroups.resize(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (streamed.Keys.empty() || keys[i] != streamed.Keys.back()) {
+                streamed.Keys.push_back(std::move(keys[i]));
+                streamed.States.resize(streamed.States.size() + _aggs.size());
+            }
+            rowGroups[i] = static_cast<uint32_t>(streamed.Keys.size() - 1);
+        }
+        if (auto err = update(ctx, input[c], rowGroups.data(), streamed.States.data())) {
+            return {c, err};
+        }
+    }
+    appendWarnings(ctx.Warnings);
+    return {c, std::nullopt};
+}
+
+std::optional<mysql::SQLError> AggExec::merge(std::span<groups *const> parts, std::vector<Chunk> &out) const {
+    auto numAggs = _aggs.size();
+    size_t n = 0;
+    for (const auto *part : parts) {
+        n += part->Keys.size();
+    }
+    groupMap table(n);
+    std::vector<aggState> states;
+    for (auto *part : parts) {
+        for (size_t i = 0; i < part->Keys.size(); i++) {
+            auto *from = &part->States[i * numAggs];
+            auto [g, inserted] = table.TryEmplace(std::move(part->Keys[i]), static_cast<uint32_t>(table.Size()));
+            if (inserted) {
+                states.insert(states.end(), std::make_move_iterator(from), std::make_move_iterator(from + numAggs));
+                continue;
+            }
+            for (size_t a = 0; a < numAggs; a++) {
+                if (!_aggs[a].Merge(states[*g * numAggs + a], from[a])) {
+                    return _aggs[a].ErrOverflow();
+                }
+            }
+        }
+    }
+    table.ForEach([&](const std::string &key, uint32_t g) { appendGroup(out, key, &states[g * numAggs]); });
+    return std::nullopt;
+}
+
+void AggExec::appendGroup(std::vector<Chunk> &out, std::string_view key, const aggState *states) const {
+    if (out.empty() || out.back().IsFull()) {
+        out.emplace_back(_columnTypes);
+    }
+    auto &chk = out.back();
+    std::string bytes;
+    for (size_t c = 0; c < _groupBy.size(); c++) {
+        auto &col = chk.Col(c);
+        auto flag = static_cast<uint8_t>(key[0]);
+        key.remove_prefix(1);
+        size_t n = 0;
+        switch (flag) {
+            case util::codec::IntFlag: {
+                auto [v, len] = util::codec::DecodeInt(key);
+                col.AppendInt64(v);
+                n = len;
+                break;
+            }
+            case util::codec::UintFlag: {
+                auto [v, len] = util::codec::DecodeUint(key);
+                col.AppendUint64(v);
+                n = len;
+                break;
+            }
+            case util::codec::FloatFlag: {
+                auto [v, len] = util::codec::DecodeFloat(key);
+                col.AppendFloat64(v);
+                n = len;
+                break;
+            }
+            case util::codec::BytesFlag:
+                bytes.clear();
+                n = util::codec::DecodeBytes(key, bytes);
+                col.AppendBytes(bytes);
+                break;
+            default:
+                col.AppendNull();
+                break;
+        }
+        key.remove_prefix(n);
+    }
+    for (size_t a = 0; a < _aggs.size(); a++) {
+        _aggs[a].Append(states[a], chk.Col(_groupBy.size() + a));
+    }
+}
+
+void AggExec::appendWarnings(const std::vector<mysql::SQLError> &warnings) {
+    for (const auto &w : warnings) {
+        if (_warnings.size() < EvalContext::maxWarnings) {
+            _warnings.push_back(w);
+        }
+    }
+}
+
+std::tuple<std::vector<Chunk>, std::optional<mysql::SQLError>> AggExec::Execute(std::span<const Chunk> input) {
+    _warnings.clear();
+    _executed = AggStrategy::Hash;
+    std::vector<Chunk> out;
+    auto numAggs = _aggs.size();
+
+    groups streamed;
+    size_t begin = 0;
+    if (_opts.Strategy != AggStrategy::Hash) {
+        auto [n, err] = stream(input, streamed);
+        if (err) {
+            return {std::move(out), err};
+        }
+        if (n == input.size()) {
+            _executed = AggStrategy::Stream;
+            for (size_t g = 0; g < streamed.Keys.size(); g++) {
+                appendGroup(out, streamed.Keys[g], &streamed.States[g * numAggs]);
+            }
+            if (_groupBy.empty() && streamed.Keys.empty()) {
+                std::vector<aggState> empty(numAggs);
+                appendGroup(out, {}, empty.data());
+            }
+            return {std::move(out), std::nullopt};
+        }
+        if (_opts.Strategy == AggStrategy::Stream) {
+            appendWarnings({mysql::NewErr(mysql::ErrInternal, "Optimizer Hint STREAM_AGG is inapplicable")});
+        }
+        begin = n;
+    }
+
+    // The groups streamed before the input turned out not to be sorted are merged with those of the threads.
+    std::array<groups, numPartitions> streamedParts;
+    for (size_t g = 0; g < streamed.Keys.size(); g++) {
+        auto &part = streamedParts[partitionOf(streamed.Keys[g])];
+        part.Keys.push_back(std::move(streamed.Keys[g]));
+        part.States.insert(part.States.end(), std::make_move_iterator(streamed.States.begin() + g * numAggs),
+                           std::make_move_iterator(streamed.States.begin() + (g + 1) * numAggs));
+    }
+
+    tbb::enumerable_thread_specific<partial> partials(std::cref(*this));
+    std::atomic<bool> failed{false};
+    tbb::task_arena arena(_opts.Concurrency == 0 ? tbb::task_arena::automatic : static_cast<int>(_opts.Concurrency));
+    arena.execute([&] {
+        tbb::parallel_for(tbb::blocked_range<size_t>(begin, input.size(), 1), [&](const tbb::blocked_range<size_t> &r) {
+            auto &p = partials.local();
+            for (auto c = r.begin(); c != r.end() && !failed.load(std::memory_order_relaxed); c++) {
+                if (auto err = p.Add(input[c])) {
+                    p.Err = std::move(err);
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+    });
+    for (auto &p : partials) {
+        if (p.Err) {
+            return {std::move(out), p.Err};
+        }
+        appendWarnings(p.Ctx.Warnings);
+    }
+
+    std::array<std::vector<Chunk>, numPartitions> outs;
+    std::array<std::optional<mysql::SQLError>, numPartitions> errs;
+    arena.execute([&] {
+        tbb::parallel_for_each(partials.begin(), partials.end(), [](partial &p) { p.Flush(); });
+        tbb::parallel_for(size_t{0}, numPartitions, [&](size_t i) {
+            std::vector<groups *> parts{&streamedParts[i]};
+            for (auto &p : partials) {
+                parts.push_back(&p.Parts[i]);
+            }
+            errs[i] = merge(parts, outs[i]);
+        });
+    });
+    for (auto &err : errs) {
+        if (err) {
+            return {std::move(out), err};
+        }
+    }
+
+    for (auto &chunks : outs) {
+        AppendPacked(out, std::move(chunks), _columnTypes);
+    }
+    if (_groupBy.empty() && out.empty()) {
+        std::vector<aggState> empty(numAggs);
+        appendGroup(out, {}, empty.data());
+    }
+    return {std::move(out), std::nullopt};
+}
+
+}  // namespace executor
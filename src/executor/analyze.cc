@@ -0,0 +1,415 @@
+#include "executor/analyze.hh"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#include "executor/executor.hh"
+#include "util/hash/swiss_map.hh"
+
+namespace executor {
+
+using util::chunk::Chunk;
+using util::sketch::CountMinSketch;
+
+namespace {
+
+// maxAnalyzeTopN and maxCMSketchWidth bound the options, like the limits of TiDB.
+constexpr size_t maxAnalyzeTopN = 1024;
+constexpr uint64_t maxCMSketchWidth = 1 << 20;
+
+// radixBits is the number of the high bits of the hash of a key that give its partition.
+constexpr int radixBits = 6;
+constexpr size_t numPartitions = size_t{1} << radixBits;
+
+struct keyHash {
+    size_t operator()(std::string_view key) const { return XXH3_64bits(key.data(), key.size()); }
+};
+
+// countMap maps the keys of the values to their number of rows.
+using countMap = util::hash::SwissMap<std::string, uint64_t, keyHash, std::equal_to<>>;
+
+size_t partitionOf(std::string_view key) { return keyHash()(key) >> (64 - radixBits); }
+
+// moreFrequent orders the values by decreasing count, then by key.
+bool moreFrequent(const TopNEntry &a, const TopNEntry &b) {
+    return a.Count != b.Count ? a.Count > b.Count : a.Key < b.Key;
+}
+
+// statsMagic starts the files of the statistics, followed by statsVersion.
+constexpr char statsMagic[4] = {'P', 'X', 'C', 'S'};
+constexpr uint8_t statsVersion = 1;
+
+mysql::SQLError ioError(uint16_t code, const std::string &path) {
+    auto err = errno;
+    return mysql::NewErr(code, path.c_str(), err, std::strerror(err));
+}
+
+// nextRandom returns the next number of the splitmix64 sequence of state.
+uint64_t nextRandom(uint64_t &state) {
+    auto z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void appendUvarint(std::string &b, uint64_t v) {
+    while (v >= 0x80) {
+        b.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    b.push_back(static_cast<char>(v));
+}
+
+// readUvarint reads a uvarint from b at pos, and returns false if it is truncated or overflows.
+bool readUvarint(std::string_view b, size_t &pos, uint64_t &v) {
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && pos < b.size(); shift += 7) {
+        auto c = static_cast<uint8_t>(b[pos++]);
+        v |= static_cast<uint64_t>(c & 0x7f) << shift;
+        if (c < 0x80) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::optional<mysql::SQLError> writeFile(const std::string &path, std::string_view data) {
+    auto fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return ioError(mysql::ErrCantCreateFile, path);
+    }
+    while (!data.empty()) {
+        auto n = ::write(fd, data.data(), data.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            auto err = ioError(mysql::ErrErrorOnWrite, path);
+            ::close(fd);
+            return err;
+        }
+        data.remove_prefix(n);
+    }
+    if (::close(fd) != 0) {
+        return ioError(mysql::ErrErrorOnWrite, path);
+    }
+    return std::nullopt;
+}
+
+std::optional<mysql::SQLError> readFile(const std::string &path, std::string &data) {
+    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return ioError(mysql::ErrCantOpenFile, path);
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        auto err = ioError(mysql::ErrErrorOnRead, path);
+        ::close(fd);
+        return err;
+    }
+    data.resize(st.st_size);
+    size_t done = 0;
+    while (done < data.size()) {
+        auto n = ::read(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            // A file shorter than its size was truncated as it was read.
+            auto err =
+                n < 0 ? ioError(mysql::ErrErrorOnRead, path) : mysql::NewErr(mysql::ErrNotFormFile, path.c_str());
+            ::close(fd);
+            return err;
+        }
+        done += n;
+    }
+    ::close(fd);
+    return std::nullopt;
+}
+
+}  // namespace
+
+double ColumnStats::EqualRowCount(std::string_view key) const {
+    if (SampleCount == 0) {
+        return 0;
+    }
+    auto scale = static_cast<double>(RowCount) / static_cast<double>(SampleCount);
+    auto it = std::lower_bound(TopN.begin(), TopN.end(), key,
+                               [](const TopNEntry &e, std::string_view k) { return e.Key < k; });
+    if (it != TopN.end() && it->Key == key) {
+        return static_cast<double>(it->Count) * scale;
+    }
+    auto count = Sketch != nullptr ? Sketch->Get(key) : 0;
+    if (count == 0) {
+        return SampleCount < RowCount ? scale : 0;
+    }
+    return static_cast<double>(count) * scale;
+}
+
+double ColumnStats::EqualSelectivity(std::string_view key) const {
+    return RowCount == 0 ? 0 : EqualRowCount(key) / static_cast<double>(RowCount);
+}
+
+std::optional<mysql::SQLError> ColumnStats::Save(const std::string &path) const {
+    std::string b(statsMagic, sizeof(statsMagic));
+    b.push_back(static_cast<char>(statsVersion));
+    appendUvarint(b, RowCount);
+    appendUvarint(b, SampleCount);
+    appendUvarint(b, NullCount);
+    appendUvarint(b, TopN.size());
+    for (const auto &e : TopN) {
+        appendUvarint(b, e.Key.size());
+        b.append(e.Key);
+        appendUvarint(b, e.Count);
+    }
+    b.push_back(static_cast<char>(Sketch != nullptr));
+    if (auto err = writeFile(path, b)) {
+        return err;
+    }
+    return Sketch != nullptr ? Sketch->Save(path + ".cms") : std::nullopt;
+}
+
+std::tuple<ColumnStats, std::optional<mysql::SQLError>> ColumnStats::Load(const std::string &path) {
+    ColumnStats stats;
+    std::string b;
+    if (auto err = readFile(path, b)) {
+        return {std::move(stats), err};
+    }
+    auto corrupted = [&] { return std::tuple{ColumnStats{}, mysql::NewErr(mysql::ErrNotFormFile, path.c_str())}; };
+    if (b.size() <= sizeof(statsMagic) || std::memcmp(b.data(), statsMagic, sizeof(statsMagic)) != 0 ||
+        static_cast<uint8_t>(b[sizeof(statsMagic)]) != statsVersion) {
+        return corrupted();
+    }
+    size_t pos = sizeof(statsMagic) + 1;
+    uint64_t numTopN = 0;
+    if (!readUvarint(b, pos, stats.RowCount) || !readUvarint(b, pos, stats.SampleCount) ||
+        !readUvarint(b, pos, stats.NullCount) || !readUvarint(b, pos, numTopN) || numTopN > maxAnalyzeTopN) {
+        return corrupted();
+    }
+    for (uint64_t i = 0; i < numTopN; i++) {
+        uint64_t n = 0;
+        TopNEntry e;
+        if (!readUvarint(b, pos, n) || n > b.size() - pos) {
+            return corrupted();
+        }
+        e.Key = b.substr(pos, n);
+        pos += n;
+        if (!readUvarint(b, pos, e.Count)) {
+            return corrupted();
+        }
+        stats.TopN.push_back(std::move(e));
+    }
+    if (pos + 1 != b.size()) {
+        return corrupted();
+    }
+    if (b[pos] != 0) {
+        auto [sketch, err] = CountMinSketch::Open(path + ".cms");
+        if (err) {
+            return {ColumnStats{}, err};
+        }
+        stats.Sketch = std::move(sketch);
+    }
+    return {std::move(stats), std::nullopt};
+}
+
+// sample is the sample of a region: the number of rows sampled, and the number of NULLs and the counts of the values
+// of every column, Counts[c * numPartitions + p] counting the values of column c in partition p.
+struct AnalyzeExec::sample {
+    std::optional<mysql::SQLError> Err;
+    uint64_t Rows{0};
+    std::vector<uint64_t> Nulls;
+    std::vector<countMap> Counts;
+};
+
+// partition is the counts of the values of a partition of a column in every region, and the most frequent of them.
+struct AnalyzeExec::partition {
+    countMap Counts;
+    std::vector<TopNEntry> Frequent;
+};
+
+AnalyzeExec::AnalyzeExec(std::vector<expression::ExprPtr> columns, std::vector<uint8_t> types, AnalyzeOptions opts)
+    : _columns(std::move(columns)), _types(std::move(types)), _opts(opts) {}
+
+AnalyzeExec::~AnalyzeExec() = default;
+
+std::tuple<std::unique_ptr<AnalyzeExec>, std::optional<mysql::SQLError>> AnalyzeExec::New(
+    std::vector<expression::ExprPtr> columns, std::vector<uint8_t> types, AnalyzeOptions opts) {
+    if (columns.empty()) {
+        return {nullptr, mysql::NewErr(mysql::ErrInternal, "no column to analyze")};
+    }
+    if (opts.TopN > maxAnalyzeTopN) {
+        return {nullptr, mysql::NewErr(mysql::ErrInternal, "value of topn should be at most 1024")};
+    }
+    if (opts.CMSketchWidth == 0 || opts.CMSketchWidth > maxCMSketchWidth) {
+        return {nullptr, mysql::NewErr(mysql::ErrInternal, "value of cm sketch width should be between 1 and 1048576")};
+    }
+    return {std::unique_ptr<AnalyzeExec>(new AnalyzeExec(std::move(columns), std::move(types), opts)), std::nullopt};
+}
+
+std::optional<mysql::SQLError> AnalyzeExec::sampleRegion(std::span<const Chunk> region, size_t idx, double rate,
+                                                         sample &s) const {
+    expression::EvalContext ctx;
+    ctx.Mode = _opts.Mode;
+    std::vector<std::string> keys;
+    std::vector<uint8_t> hasNull;
+    // count counts the values of the rows of chk.
+    auto count = [&](const Chunk &chk) -> std::optional<mysql::SQLError> {
+        for (size_t c = 0; c < _columns.size(); c++) {
+            if (auto err = EncodeKeys(ctx, std::span(&_columns[c], 1), chk, keys, &hasNull)) {
+                return err;
+            }
+            auto *counts = &s.Counts[c * numPartitions];
+            for (size_t i = 0; i < keys.size(); i++) {
+                if (hasNull[i]) {
+                    s.Nulls[c]++;
+                } else {
+                    auto &part = counts[partitionOf(keys[i])];
+                    part[std::move(keys[i])]++;
+                }
+            }
+        }
+        s.Rows += chk.NumRows();
+        return std::nullopt;
+    };
+
+    if (rate >= 1) {
+        for (const auto &chk : region) {
+            if (auto err = count(chk)) {
+                return err;
+            }
+        }
+        return std::nullopt;
+    }
+    // A row is sampled if its random number is below threshold. The numbers of the regions start apart.
+    auto threshold = rate * 0x1p64 >= 0x1p64 ? UINT64_MAX : static_cast<uint64_t>(rate * 0x1p64);
+    uint64_t random = _opts.Seed ^ (static_cast<uint64_t>(idx) << 32);
+    Chunk sampled(_types);
+    for (const auto &chk : region) {
+        for (size_t i = 0; i < chk.NumRows(); i++) {
+            if (nextRandom(random) >= threshold) {
+                continue;
+            }
+            sampled.AppendRow(chk, i);
+            if (sampled.IsFull()) {
+                if (auto err = count(sampled)) {
+                    return err;
+                }
+                sampled.Reset();
+            }
+        }
+    }
+    return count(sampled);
+}
+
+AnalyzeExec::partition AnalyzeExec::mergePartition(std::span<sample> samples, size_t col, size_t p) const {
+    partition part;
+    size_t n = 0;
+    for (const auto &s : samples) {
+        n = std::max(n, s.Counts[col * numPartitions + p].Size());
+    }
+    part.Counts.Reserve(n);
+    for (auto &s : samples) {
+        auto &counts = s.Counts[col * numPartitions + p];
+        counts.ForEach([&](const std::string &key, uint64_t count) { part.Counts[key] += count; });
+        counts = countMap();
+    }
+    // The TopN of the column are among the TopN + 1 most frequent values of its partitions, and so is the most
+    // frequent of the others.
+    part.Counts.ForEach([&](const std::string &key, uint64_t count) {
+        if (count > 1) {
+            part.Frequent.push_back({key, count});
+        }
+    });
+    auto top = std::min(part.Frequent.size(), _opts.TopN + 1);
+    std::partial_sort(part.Frequent.begin(), part.Frequent.begin() + top, part.Frequent.end(), moreFrequent);
+    part.Frequent.resize(top);
+    return part;
+}
+
+ColumnStats AnalyzeExec::build(std::span<const sample> samples, std::span<partition> parts, size_t col,
+                               uint64_t rowCount) const {
+    ColumnStats stats;
+    stats.RowCount = rowCount;
+    for (const auto &s : samples) {
+        stats.SampleCount += s.Rows;
+        stats.NullCount += s.Nulls[col];
+    }
+
+    std::vector<TopNEntry> frequent;
+    for (auto &part : parts) {
+        std::move(part.Frequent.begin(), part.Frequent.end(), std::back_inserter(frequent));
+    }
+    auto top = std::min(frequent.size(), _opts.TopN);
+    std::partial_sort(frequent.begin(), frequent.begin() + top, frequent.end(), moreFrequent);
+    uint64_t maxCount = 1;
+    for (size_t i = top; i < frequent.size(); i++) {
+        maxCount = std::max(maxCount, frequent[i].Count);
+    }
+    frequent.resize(top);
+    for (const auto &e : frequent) {
+        parts[partitionOf(e.Key)].Counts.Erase(e.Key);
+    }
+    std::sort(frequent.begin(), frequent.end(), [](const auto &a, const auto &b) { return a.Key < b.Key; });
+    stats.TopN = std::move(frequent);
+
+    stats.Sketch = std::make_unique<CountMinSketch>(_opts.CMSketchWidth, maxCount, _opts.Seed);
+    for (auto &part : parts) {
+        part.Counts.ForEach([&](const std::string &key, uint64_t count) { stats.Sketch->Add(key, count); });
+        part.Counts = countMap();
+    }
+    return stats;
+}
+
+std::tuple<std::vector<ColumnStats>, std::optional<mysql::SQLError>> AnalyzeExec::Execute(
+    std::span<const std::vector<Chunk>> regions) {
+    uint64_t rowCount = 0;
+    for (const auto &region : regions) {
+        for (const auto &chk : region) {
+            rowCount += chk.NumRows();
+        }
+    }
+    auto rate = _opts.SampleRows == 0 || rowCount <= _opts.SampleRows
+                    ? 1.0
+                    : static_cast<double>(_opts.SampleRows) / static_cast<double>(rowCount);
+
+    std::vector<sample> samples(regions.size());
+    for (auto &s : samples) {
+        s.Nulls.resize(_columns.size());
+        s.Counts.resize(_columns.size() * numPartitions);
+    }
+    std::vector<ColumnStats> stats(_columns.size());
+    tbb::task_arena arena(_opts.Concurrency == 0 ? tbb::task_arena::automatic : static_cast<int>(_opts.Concurrency));
+    arena.execute([&] {
+        tbb::parallel_for(size_t{0}, regions.size(),
+                          [&](size_t i) { samples[i].Err = sampleRegion(regions[i], i, rate, samples[i]); });
+    });
+    for (auto &s : samples) {
+        if (s.Err) {
+            return {std::vector<ColumnStats>{}, s.Err};
+        }
+    }
+    // The partitions of every column are merged in parallel, then the columns are built in parallel.
+    std::vector<partition> parts(_columns.size() * numPartitions);
+    arena.execute([&] {
+        tbb::parallel_for(size_t{0}, parts.size(), [&](size_t i) {
+            parts[i] = mergePartition(samples, i / numPartitions, i % numPartitions);
+        });
+        tbb::parallel_for(size_t{0}, _columns.size(), [&](size_t c) {
+            stats[c] = build(samples, std::span(parts).subspan(c * numPartitions, numPartitions), c, rowCount);
+        });
+    });
+    return {std::move(stats), std::nullopt};
+}
+
+}  // namespace executor
@@ -0,0 +1,105 @@
+#include "executor/executor.hh"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "expression/builtin.hh"
+#include "util/codec/codec.hh"
+
+namespace executor {
+
+using expression::argument;
+using expression::EvalType;
+using expression::Rows;
+using util::chunk::Chunk;
+
+std::optional<mysql::SQLError> EncodeKeys(expression::EvalContext &ctx, std::span<const expression::ExprPtr> exprs,
+                                          const Chunk &chk, std::vector<std::string> &keys,
+                                          std::vector<uint8_t> *hasNull) {
+    auto rows = Rows::Of(chk);
+    keys.resize(rows.Size());
+    for (auto &key : keys) {
+        key.clear();
+    }
+    if (hasNull != nullptr) {
+        hasNull->assign(rows.Size(), 0);
+    }
+    for (const auto &e : exprs) {
+        argument arg(ctx);
+        auto tp = e->GetEvalType();
+        if (auto err = arg.Eval(*e, tp, chk, rows)) {
+            return err;
+        }
+        // encode appends the value of every row with its flag, or NilFlag.
+        auto encode = [&](auto &&encodeValue) {
+            size_t i = 0;
+            rows.ForEach([&](size_t row) {
+                auto &key = keys[i];
+                if (arg.IsNull(row)) {
+                    key.push_back(static_cast<char>(util::codec::NilFlag));
+                    if (hasNull != nullptr) {
+                        (*hasNull)[i] = 1;
+                    }
+                } else {
+                    encodeValue(key, row);
+                }
+                i++;
+            });
+        };
+        switch (tp) {
+            case EvalType::Int:
+                if (e->Type().IsUnsigned()) {
+                    encode([&](std::string &b, size_t row) {
+                        auto v = arg.Value<uint64_t>(row);
+                        if (v <= INT64_MAX) {
+                            b.push_back(static_cast<char>(util::codec::IntFlag));
+                            util::codec::EncodeInt(b, static_cast<int64_t>(v));
+                        } else {
+                            b.push_back(static_cast<char>(util::codec::UintFlag));
+                            util::codec::EncodeUint(b, v);
+                        }
+                    });
+                } else {
+                    encode([&](std::string &b, size_t row) {
+                        b.push_back(static_cast<char>(util::codec::IntFlag));
+                        util::codec::EncodeInt(b, arg.Value<int64_t>(row));
+                    });
+                }
+                break;
+            case EvalType::Real:
+                encode([&](std::string &b, size_t row) {
+                    b.push_back(static_cast<char>(util::codec::FloatFlag));
+                    util::codec::EncodeFloat(b, arg.Value<double>(row));
+                });
+                break;
+            case EvalType::String:
+                encode([&](std::string &b, size_t row) {
+                    b.push_back(static_cast<char>(util::codec::BytesFlag));
+                    util::codec::EncodeBytes(b, arg.Bytes(row));
+                });
+                break;
+        }
+    }
+    return std::nullopt;
+}
+
+void AppendPacked(std::vector<Chunk> &out, std::vector<Chunk> chunks, std::span<const uint8_t> types) {
+    for (auto &chk : chunks) {
+        if (chk.IsFull() && !chk.HasSel()) {
+            out.push_back(std::move(chk));
+            continue;
+        }
+        size_t i = 0;
+        while (i < chk.NumRows()) {
+            if (out.empty() || out.back().IsFull()) {
+                out.emplace_back(types);
+            }
+            auto &last = out.back();
+            auto n = std::min(chk.NumRows() - i, last.Capacity() - last.NumRows());
+            last.Append(chk, i, i + n);
+            i += n;
+        }
+    }
+}
+
+}  // namespace executor
@@ -0,0 +1,375 @@
+#include "executor/join.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <utility>
+
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#include "executor/executor.hh"
+#include "parser/misc.hh"
+#include "parser/token.hh"
+#include "xxHash/xxhash.h"
+
+namespace executor {
+
+using expression::EvalContext;
+using util::chunk::Chunk;
+
+namespace {
+
+// partitionRows is the number of rows of the build side of a partition, whose hashes, keys and hash table then fit in
+// the L2 cache.
+constexpr size_t partitionRows = 1 << 12;
+constexpr size_t maxPartitions = 1 << 10;
+// probeBatch is the number of rows probed together, their buckets being prefetched first.
+constexpr size_t probeBatch = 16;
+
+uint64_t hashKey(std::string_view key) { return XXH3_64bits(key.data(), key.size()); }
+
+// isSemi returns whether the join of tp returns the left rows only.
+bool isSemi(JoinType tp) {
+    return tp == JoinType::Semi || tp == JoinType::AntiSemi || tp == JoinType::NullAwareAntiSemi;
+}
+
+// rowRef is a row of an input: the index of its chunk and of the row in the chunk.
+struct rowRef {
+    uint32_t Chunk;
+    uint32_t Row;
+};
+
+size_t numRows(std::span<const Chunk> chunks) {
+    size_t n = 0;
+    for (const auto &chk : chunks) {
+        n += chk.NumRows();
+    }
+    return n;
+}
+
+}  // namespace
+
+// side is the rows of an input in a partition: the hashes and the keys of their join keys, and the rows.
+struct HashJoinExec::side {
+    std::vector<uint64_t> Hashes;
+    std::vector<std::string> Keys;
+    std::vector<rowRef> Rows;
+
+    size_t Size() const { return Rows.size(); }
+
+    void Append(side &&other) {
+        Hashes.insert(Hashes.end(), other.Hashes.begin(), other.Hashes.end());
+        Keys.insert(Keys.end(), std::make_move_iterator(other.Keys.begin()), std::make_move_iterator(other.Keys.end()));
+        Rows.insert(Rows.end(), other.Rows.begin(), other.Rows.end());
+    }
+};
+
+// partitioner is the state of a thread partitioning an input: its rows by partition, and those with a NULL key.
+class HashJoinExec::partitioner {
+public:
+    partitioner(size_t numPartitions, const JoinOptions &opts)
+        : Parts(numPartitions), _shift(64 - std::countr_zero(numPartitions)) {
+        Ctx.Mode = opts.Mode;
+        Ctx.InDML = opts.InDML;
+    }
+
+    std::optional<mysql::SQLError> Add(std::span<const expression::ExprPtr> keys, const Chunk &chk, size_t c) {
+        if (auto err = EncodeKeys(Ctx, keys, chk, _keys, &_hasNull)) {
+            return err;
+        }
+        for (size_t i = 0; i < _keys.size(); i++) {
+            rowRef row{static_cast<uint32_t>(c), static_cast<uint32_t>(chk.RowIdx(i))};
+            if (_hasNull[i]) {
+                Nulls.push_back(row);
+                continue;
+            }
+            auto h = hashKey(_keys[i]);
+            // A shift of 64 is undefined: one partition takes every row.
+            auto &part = Parts[_shift == 64 ? 0 : h >> _shift];
+            part.Hashes.push_back(h);
+            part.Keys.push_back(std::move(_keys[i]));
+            part.Rows.push_back(row);
+        }
+        return std::nullopt;
+    }
+
+    EvalContext Ctx;
+    std::vector<side> Parts;
+    std::vector<rowRef> Nulls;
+    std::optional<mysql::SQLError> Err;
+
+private:
+    int _shift;
+    std::vector<std::string> _keys;
+    std::vector<uint8_t> _hasNull;
+};
+
+JoinHints JoinHintsOf(const std::string &lit) {
+    JoinHints hints;
+    bool swap = false, noSwap = false, noSemiJoin = false;
+    for (auto tok : parser::getHintTokens(lit)) {
+        switch (tok) {
+            case parser::tok_hintHashJoin:
+                hints.HashJoin = true;
+                break;
+            case parser::tok_hintSwapJoinInputs:
+                swap = true;
+                break;
+            case parser::tok_hintNoSwapJoinInputs:
+                noSwap = true;
+                break;
+            case parser::tok_hintSemijoin:
+                hints.SemiJoin = true;
+                break;
+            case parser::tok_hintNoSemijoin:
+                noSemiJoin = true;
+                break;
+        }
+    }
+    if (swap != noSwap) {
+        hints.Build = swap ? BuildSide::Left : BuildSide::Right;
+    }
+    hints.SemiJoin &= !noSemiJoin;
+    return hints;
+}
+
+HashJoinExec::HashJoinExec(JoinType tp, std::vector<expression::ExprPtr> leftKeys,
+                           std::vector<expression::ExprPtr> rightKeys, std::vector<uint8_t> leftTypes,
+                           std::vector<uint8_t> rightTypes, JoinOptions opts)
+    : _tp(tp),
+      _leftKeys(std::move(leftKeys)),
+      _rightKeys(std::move(rightKeys)),
+      _leftTypes(std::move(leftTypes)),
+      _rightTypes(std::move(rightTypes)),
+      _opts(opts) {
+    _types = _leftTypes;
+    if (!isSemi(_tp)) {
+        _types.insert(_types.end(), _rightTypes.begin(), _rightTypes.end());
+    }
+}
+
+HashJoinExec::~HashJoinExec() = default;
+
+std::tuple<std::unique_ptr<HashJoinExec>, std::optional<mysql::SQLError>> HashJoinExec::New(
+    JoinType tp, std::vector<expression::ExprPtr> leftKeys, std::vector<expression::ExprPtr> rightKeys,
+    std::vector<uint8_t> leftTypes, std::vector<uint8_t> rightTypes, JoinOptions opts) {
+    if (leftKeys.size() != rightKeys.size()) {
+        return {nullptr, mysql::NewErr(mysql::ErrUnknown, "the join keys of the inputs differ in number")};
+    }
+    if (tp == JoinType::NullAwareAntiSemi && leftKeys.size() != 1) {
+        return {nullptr, mysql::NewErr(mysql::ErrNotSupportedYet, "NOT IN on more than one column")};
+    }
+    for (size_t i = 0; i < leftKeys.size(); i++) {
+        if (leftKeys[i]->GetEvalType() != rightKeys[i]->GetEvalType()) {
+            auto cond = leftKeys[i]->String() + " = " + rightKeys[i]->String();
+            return {nullptr, mysql::NewErr(mysql::ErrNotSupportedYet, ("hash join on " + cond).c_str())};
+        }
+    }
+    return {std::unique_ptr<HashJoinExec>(new HashJoinExec(tp, std::move(leftKeys), std::move(rightKeys),
+                                                           std::move(leftTypes), std::move(rightTypes), opts)),
+            std::nullopt};
+}
+
+bool HashJoinExec::buildLeft(size_t left, size_t right) const {
+    switch (_opts.Build) {
+        case BuildSide::Left:
+            return true;
+        case BuildSide::Right:
+            return false;
+        case BuildSide::Auto:
+            break;
+    }
+    if (isSemi(_tp) && !_opts.SwapSemiJoin) {
+        return false;
+    }
+    return left < right;
+}
+
+void HashJoinExec::join(const side &build, const side &probe, std::span<const Chunk> left,
+                        std::span<const Chunk> right, std::vector<Chunk> &out) const {
+    auto semi = isSemi(_tp);
+    // emit appends the row of the left row l and the right row r, a null one being NULLs.
+    auto emit = [&](const rowRef *l, const rowRef *r) {
+        if (out.empty() || out.back().IsFull()) {
+            out.emplace_back(_types);
+        }
+        auto &chk = out.back();
+        for (size_t c = 0; c < _leftTypes.size(); c++) {
+            l != nullptr ? chk.Col(c).AppendFrom(left[l->Chunk].Col(c), l->Row) : chk.Col(c).AppendNull();
+        }
+        if (semi) {
+            return;
+        }
+        for (size_t c = 0; c < _rightTypes.size(); c++) {
+            auto &col = chk.Col(_leftTypes.size() + c);
+            r != nullptr ? col.AppendFrom(right[r->Chunk].Col(c), r->Row) : col.AppendNull();
+        }
+    };
+    auto emitPair = [&](const rowRef &b, const rowRef &p) {
+        _builtLeft ? emit(&b, &p) : emit(&p, &b);
+    };
+
+    // The rows of the build side are chained by bucket, heads[b] and next[i] holding the index of a row plus one.
+    auto numBuckets = std::bit_ceil(std::max<size_t>(build.Size(), 1));
+    auto mask = numBuckets - 1;
+    std::vector<uint32_t> heads(numBuckets), next(build.Size());
+    for (size_t i = 0; i < build.Size(); i++) {
+        auto &head = heads[build.Hashes[i] & mask];
+        next[i] = head;
+        head = static_cast<uint32_t>(i + 1);
+    }
+
+    // The build side is preserved by the outer joins of its side, and by the semi joins built on the left: its rows
+    // are marked when they match, and the others emitted at the end.
+    auto preservesBuild = _builtLeft ? _tp == JoinType::LeftOuter || semi : _tp == JoinType::RightOuter;
+    auto preservesProbe = _builtLeft ? _tp == JoinType::RightOuter : _tp == JoinType::LeftOuter;
+    std::vector<uint8_t> matched(preservesBuild ? build.Size() : 0);
+
+    std::array<uint32_t, probeBatch> first;
+    for (size_t begin = 0; begin < probe.Size(); begin += probeBatch) {
+        auto end = std::min(begin + probeBatch, probe.Size());
+        for (auto i = begin; i < end; i++) {
+            __builtin_prefetch(&heads[probe.Hashes[i] & mask]);
+        }
+        for (auto i = begin; i < end; i++) {
+            first[i - begin] = heads[probe.Hashes[i] & mask];
+            if (first[i - begin] != 0) {
+                __builtin_prefetch(&build.Hashes[first[i - begin] - 1]);
+            }
+        }
+        for (auto i = begin; i < end; i++) {
+            auto h = probe.Hashes[i];
+            bool found = false;
+            for (auto e = first[i - begin]; e != 0; e = next[e - 1]) {
+                auto b = e - 1;
+                if (build.Hashes[b] != h || build.Keys[b] != probe.Keys[i]) {
+                    continue;
+                }
+                found = true;
+                if (preservesBuild) {
+                    matched[b] = 1;
+                }
+                if (semi) {
+                    if (!_builtLeft) {
+                        break;
+                    }
+                } else {
+                    emitPair(build.Rows[b], probe.Rows[i]);
+                }
+            }
+            if (semi && !_builtLeft && found == (_tp == JoinType::Semi)) {
+                emit(&probe.Rows[i], nullptr);
+            } else if (preservesProbe && !found) {
+                _builtLeft ? emit(nullptr, &probe.Rows[i]) : emit(&probe.Rows[i], nullptr);
+            }
+        }
+    }
+
+    if (preservesBuild) {
+        for (size_t b = 0; b < build.Size(); b++) {
+            // The semi join emits the rows that matched, the others the rows that did not.
+            if (matched[b] == (_tp == JoinType::Semi)) {
+                _builtLeft ? emit(&build.Rows[b], nullptr) : emit(nullptr, &build.Rows[b]);
+            }
+        }
+    }
+}
+
+std::tuple<std::vector<Chunk>, std::optional<mysql::SQLError>> HashJoinExec::Execute(std::span<const Chunk> left,
+                                                                                    std::span<const Chunk> right) {
+    std::vector<Chunk> out;
+    _builtLeft = buildLeft(numRows(left), numRows(right));
+    auto build = _builtLeft ? left : right;
+    auto probe = _builtLeft ? right : left;
+    const auto &buildKeys = _builtLeft ? _leftKeys : _rightKeys;
+    const auto &probeKeys = _builtLeft ? _rightKeys : _leftKeys;
+    _numPartitions = std::min(std::bit_ceil(std::max<size_t>(numRows(build) / partitionRows, 1)), maxPartitions);
+
+    tbb::enumerable_thread_specific<partitioner> buildParts(_numPartitions, _opts),
+        probeParts(_numPartitions, _opts);
+    std::atomic<bool> failed{false};
+    auto partition = [&](std::span<const Chunk> input, const std::vector<expression::ExprPtr> &keys,
+                         tbb::enumerable_thread_specific<partitioner> &parts) {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, input.size(), 1), [&](const tbb::blocked_range<size_t> &r) {
+            auto &p = parts.local();
+            for (auto c = r.begin(); c != r.end() && !failed.load(std::memory_order_relaxed); c++) {
+                if (auto err = p.Add(keys, input[c], c)) {
+                    p.Err = std::move(err);
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+    };
+    tbb::task_arena arena(_opts.Concurrency == 0 ? tbb::task_arena::automatic : static_cast<int>(_opts.Concurrency));
+    arena.execute([&] {
+        partition(build, buildKeys, buildParts);
+        partition(probe, probeKeys, probeParts);
+    });
+    for (auto *parts : {&buildParts, &probeParts}) {
+        for (auto &p : *parts) {
+            if (p.Err) {
+                return {std::move(out), p.Err};
+            }
+        }
+    }
+    // A NULL right key makes NOT IN unknown for every left row.
+    const auto &rightParts = _builtLeft ? probeParts : buildParts;
+    if (_tp == JoinType::NullAwareAntiSemi &&
+        std::any_of(rightParts.begin(), rightParts.end(), [](const partitioner &p) { return !p.Nulls.empty(); })) {
+        return {std::move(out), std::nullopt};
+    }
+
+    std::vector<std::vector<Chunk>> outs(_numPartitions);
+    arena.execute([&] {
+        tbb::parallel_for(size_t{0}, _numPartitions, [&](size_t i) {
+            side b, p;
+            for (auto &t : buildParts) {
+                b.Append(std::move(t.Parts[i]));
+            }
+            for (auto &t : probeParts) {
+                p.Append(std::move(t.Parts[i]));
+            }
+            join(b, p, left, right, outs[i]);
+        });
+    });
+    for (auto &chunks : outs) {
+        AppendPacked(out, std::move(chunks), _types);
+    }
+
+    // The rows with a NULL key match no row: the outer joins emit those of their outer input, the anti semi join
+    // those of the left one, and NOT IN those of the left one if the right one is empty.
+    std::vector<Chunk> nulls;
+    auto emitNulls = [&](auto &parts, bool isLeft) {
+        for (auto &t : parts) {
+            for (const auto &row : t.Nulls) {
+                if (nulls.empty() || nulls.back().IsFull()) {
+                    nulls.emplace_back(_types);
+                }
+                auto &chk = nulls.back();
+                const auto &src = isLeft ? left[row.Chunk] : right[row.Chunk];
+                auto offset = isLeft ? 0 : _leftTypes.size();
+                for (size_t c = 0; c < _types.size(); c++) {
+                    if (c >= offset && c - offset < src.NumCols()) {
+                        chk.Col(c).AppendFrom(src.Col(c - offset), row.Row);
+                    } else {
+                        chk.Col(c).AppendNull();
+                    }
+                }
+            }
+        }
+    };
+    if (_tp == JoinType::LeftOuter || _tp == JoinType::AntiSemi ||
+        (_tp == JoinType::NullAwareAntiSemi && numRows(right) == 0)) {
+        emitNulls(_builtLeft ? buildParts : probeParts, true);
+    } else if (_tp == JoinType::RightOuter) {
+        emitNulls(_builtLeft ? probeParts : buildParts, false);
+    }
+    AppendPacked(out, std::move(nulls), _types);
+    return {std::move(out), std::nullopt};
+}
+
+}  // namespace executor
@@ -0,0 +1,452 @@
+#include "executor/sort.hh"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#include "executor/executor.hh"
+#include "ips4o.hpp"
+#include "parser/mysql/type.hh"
+#include "util/chunk/arrow_ipc.hh"
+
+namespace executor {
+
+using util::chunk::ArrowReader;
+using util::chunk::ArrowWriter;
+using util::chunk::Chunk;
+using util::chunk::defaultCapacity;
+
+namespace {
+
+// batchChunks is the number of chunks of sorted rows built at a time, for a run or for Next, so that few of the rows
+// held are copied at once.
+constexpr size_t batchChunks = 16;
+// readAheadBatches is the number of record batches a run reads ahead of the one merged.
+constexpr size_t readAheadBatches = 2;
+
+// prefixOf returns the first 8 bytes of key as a big-endian integer, padded with zeros, so that the prefixes compare
+// like the keys.
+uint64_t prefixOf(std::string_view key) {
+    uint64_t p = 0;
+    std::memcpy(&p, key.data(), std::min(key.size(), sizeof(p)));
+    return __builtin_bswap64(p);
+}
+
+// rowBytes returns the bytes of the rows of chk, those of a selection in proportion.
+size_t rowBytes(const Chunk &chk) {
+    size_t n = 0;
+    for (size_t c = 0; c < chk.NumCols(); c++) {
+        const auto &col = chk.Col(c);
+        n += col.DataSize() + (col.Length() + 7) / 8 + (col.IsFixed() ? 0 : (col.Length() + 1) * sizeof(int64_t));
+    }
+    if (chk.HasSel() && chk.NumRowsUnfiltered() > 0) {
+        n = n * chk.NumRows() / chk.NumRowsUnfiltered();
+    }
+    return n;
+}
+
+// loserTree merges k sorted sources, less(i, j) comparing their current rows. Every inner node holds the loser of the
+// match of its children and the root the winner, so that when the winner moves to its next row, only the matches on
+// the path from its leaf are replayed: log2(k) comparisons, each with a single other source.
+template <typename Less>
+class loserTree {
+public:
+    loserTree(size_t k, Less less) : _k(k), _less(std::move(less)), _nodes(std::max<size_t>(k, 1)) {
+        if (k > 0) {
+            _nodes[0] = build(1);
+        }
+    }
+
+    // Winner returns the source of the least row.
+    size_t Winner() const { return _nodes[0]; }
+
+    // Replay finds the winner after the current row of the last one changed.
+    void Replay() {
+        auto w = _nodes[0];
+        for (auto n = (w + _k) / 2; n > 0; n /= 2) {
+            if (_less(_nodes[n], w)) {
+                std::swap(_nodes[n], w);
+            }
+        }
+        _nodes[0] = w;
+    }
+
+private:
+    // build plays the matches of the subtree of node n, whose leaves n >= k are the sources n - k, and returns its
+    // winner.
+    size_t build(size_t n) {
+        if (n >= _k) {
+            return n - _k;
+        }
+        auto winner = build(2 * n), loser = build(2 * n + 1);
+        if (_less(loser, winner)) {
+            std::swap(winner, loser);
+        }
+        _nodes[n] = loser;
+        return winner;
+    }
+
+    size_t _k;
+    Less _less;
+    std::vector<size_t> _nodes;
+};
+
+}  // namespace
+
+// entry is a row in memory: its key in _keyData and the prefix of it, and its index in the input.
+struct SortExec::entry {
+    uint64_t Prefix;
+    uint64_t Offset;
+    uint32_t Length;
+    uint32_t Chunk;
+    uint32_t Row;
+};
+
+// cursor is the current row of a run, or of the rows in memory, and its key.
+struct SortExec::cursor {
+    // Reader is the run, null for the rows in memory, whose current one is _entries[Entry].
+    ArrowReader *Reader{nullptr};
+    size_t Batch{0};
+    size_t Entry{0};
+    Chunk Chk;
+    const Chunk *Cur{nullptr};
+    size_t Row{0};
+    std::string_view Key;
+    bool Done{false};
+};
+
+// merger is the merge of the runs and the rows in memory, the cursor of which is the last.
+struct SortExec::merger {
+    // less compares the current rows of two cursors, those done being the greatest. The cursors of equal keys are
+    // taken in order, so that the merge is deterministic.
+    struct less {
+        const std::vector<cursor> *Cursors;
+
+        bool operator()(size_t i, size_t j) const {
+            const auto &a = (*Cursors)[i], &b = (*Cursors)[j];
+            if (a.Done || b.Done) {
+                return !a.Done;
+            }
+            auto c = a.Key.compare(b.Key);
+            return c < 0 || (c == 0 && i < j);
+        }
+    };
+
+    // Cursors are built before the tree, which plays their matches.
+    std::vector<cursor> Cursors;
+    loserTree<less> Tree;
+
+    explicit merger(std::vector<cursor> cursors)
+        : Cursors(std::move(cursors)), Tree(Cursors.size(), less{&Cursors}) {}
+};
+
+SortExec::SortExec(std::vector<ByItem> byItems, std::vector<uint8_t> types, SortOptions opts)
+    : _types(std::move(types)), _opts(std::move(opts)) {
+    for (auto &item : byItems) {
+        _exprs.push_back(std::move(item.Expr));
+        _desc.push_back(item.Desc);
+        _hasDesc |= item.Desc;
+    }
+    _runTypes = _types;
+    _runTypes.push_back(mysql::TypeVarString);
+    _ctx.Mode = _opts.Mode;
+    _ctx.InDML = _opts.InDML;
+}
+
+SortExec::~SortExec() = default;
+
+std::tuple<std::unique_ptr<SortExec>, std::optional<mysql::SQLError>> SortExec::New(std::vector<ByItem> byItems,
+                                                                                     std::vector<uint8_t> types,
+                                                                                     SortOptions opts) {
+    if (byItems.empty()) {
+        return {nullptr, mysql::NewErr(mysql::ErrInternal, "sort without ORDER BY items")};
+    }
+    return {std::unique_ptr<SortExec>(new SortExec(std::move(byItems), std::move(types), std::move(opts))),
+            std::nullopt};
+}
+
+std::optional<mysql::SQLError> SortExec::encodeKeys(const Chunk &chk, uint32_t chunkIdx) {
+    if (!_hasDesc) {
+        if (auto err = EncodeKeys(_ctx, _exprs, chk, _keys)) {
+            return err;
+        }
+    } else {
+        // The keys of the items are encoded one at a time, those of the descending ones inverted.
+        _keys.resize(chk.NumRows());
+        for (auto &key : _keys) {
+            key.clear();
+        }
+        for (size_t i = 0; i < _exprs.size(); i++) {
+            if (auto err = EncodeKeys(_ctx, std::span(&_exprs[i], 1), chk, _itemKeys)) {
+                return err;
+            }
+            for (size_t r = 0; r < _keys.size(); r++) {
+                auto &itemKey = _itemKeys[r];
+                if (_desc[i]) {
+                    for (auto &b : itemKey) {
+                        b = static_cast<char>(~b);
+                    }
+                }
+                _keys[r] += itemKey;
+            }
+        }
+    }
+    for (size_t r = 0; r < _keys.size(); r++) {
+        const auto &key = _keys[r];
+        _entries.push_back({prefixOf(key), _keyData.size(), static_cast<uint32_t>(key.size()), chunkIdx,
+                            static_cast<uint32_t>(r)});
+        _keyData += key;
+    }
+    return std::nullopt;
+}
+
+void SortExec::sortEntries() {
+    // The prefixes decide most comparisons; the rest of the keys are compared only when they are equal.
+    auto less = [data = _keyData.data()](const entry &a, const entry &b) {
+        if (a.Prefix != b.Prefix) {
+            return a.Prefix < b.Prefix;
+        }
+        auto n = std::min(a.Length, b.Length);
+        if (n > sizeof(uint64_t)) {
+            auto c = std::memcmp(data + a.Offset + sizeof(uint64_t), data + b.Offset + sizeof(uint64_t),
+                                 n - sizeof(uint64_t));
+            if (c != 0) {
+                return c < 0;
+            }
+        }
+        return a.Length < b.Length;
+    };
+    if (_opts.Concurrency == 1) {
+        ips4o::sort(_entries.begin(), _entries.end(), less);
+    } else if (_opts.Concurrency == 0) {
+        ips4o::parallel::sort(_entries.begin(), _entries.end(), less);
+    } else {
+        ips4o::parallel::sort(_entries.begin(), _entries.end(), less, static_cast<int>(_opts.Concurrency));
+    }
+}
+
+std::vector<Chunk> SortExec::sorted(size_t begin, size_t end, bool withKeys) const {
+    std::vector<Chunk> out((end - begin + defaultCapacity - 1) / defaultCapacity);
+    tbb::task_arena arena(_opts.Concurrency == 0 ? tbb::task_arena::automatic : static_cast<int>(_opts.Concurrency));
+    arena.execute([&] {
+        tbb::parallel_for(size_t{0}, out.size(), [&](size_t j) {
+            auto first = begin + j * defaultCapacity;
+            auto last = std::min(first + defaultCapacity, end);
+            Chunk chk(withKeys ? _runTypes : _types);
+            for (size_t c = 0; c < _types.size(); c++) {
+                auto &col = chk.Col(c);
+                col.Reserve(last - first);
+                for (auto i = first; i < last; i++) {
+                    const auto &e = _entries[i];
+                    col.AppendFrom(_chunks[e.Chunk].Col(c), _chunks[e.Chunk].RowIdx(e.Row));
+                }
+            }
+            if (withKeys) {
+                auto &col = chk.Col(_types.size());
+                for (auto i = first; i < last; i++) {
+                    col.AppendBytes({_keyData.data() + _entries[i].Offset, _entries[i].Length});
+                }
+            }
+            out[j] = std::move(chk);
+        });
+    });
+    return out;
+}
+
+std::optional<mysql::SQLError> SortExec::spill() {
+    sortEntries();
+    std::error_code ec;
+    auto dir = _opts.TempDir.empty() ? std::filesystem::temp_directory_path(ec).string() : _opts.TempDir;
+    auto path = (dir.empty() ? std::string("/tmp") : dir) + "/pxtidb-sort-XXXXXX";
+    auto fd = ::mkstemp(path.data());
+    if (fd < 0) {
+        auto err = errno;
+        return mysql::NewErr(mysql::ErrCantCreateFile, path.c_str(), err, std::strerror(err));
+    }
+
+    std::vector<util::chunk::Field> fields;
+    for (size_t c = 0; c < _types.size(); c++) {
+        fields.push_back({"c" + std::to_string(c), _types[c], 0});
+    }
+    fields.push_back({"key", mysql::TypeVarString, mysql::BinaryFlag});
+    auto err = [&]() -> std::optional<mysql::SQLError> {
+        ArrowWriter writer(fd, path, std::move(fields), util::chunk::ArrowFormat::Stream);
+        for (size_t begin = 0; begin < _entries.size(); begin += batchChunks * defaultCapacity) {
+            auto chunks = sorted(begin, std::min(begin + batchChunks * defaultCapacity, _entries.size()), true);
+            for (const auto &chk : chunks) {
+                if (auto err = writer.Write(chk)) {
+                    return err;
+                }
+            }
+        }
+        return writer.Finish();
+    }();
+    ::close(fd);
+    // The run is unlinked once mapped, so that it goes away with its reader, or with the process.
+    std::unique_ptr<ArrowReader> reader;
+    if (!err) {
+        std::tie(reader, err) = ArrowReader::Open(path);
+    }
+    ::unlink(path.c_str());
+    if (err) {
+        return err;
+    }
+    _runs.push_back(std::move(reader));
+    _chunks.clear();
+    _held = 0;
+    _keyData.clear();
+    _entries.clear();
+    return std::nullopt;
+}
+
+void SortExec::reset() {
+    _ctx.Warnings.clear();
+    _chunks.clear();
+    _held = 0;
+    _runs.clear();
+    _finished = false;
+    _ready.clear();
+    _readyPos = 0;
+    _nextEntry = 0;
+    _merger.reset();
+    _keyData.clear();
+    _entries.clear();
+}
+
+std::optional<mysql::SQLError> SortExec::Add(Chunk chk) {
+    if (_finished) {
+        return mysql::NewErr(mysql::ErrInternal, "rows added to a sort being read");
+    }
+    if (auto err = encodeKeys(chk, static_cast<uint32_t>(_chunks.size()))) {
+        return err;
+    }
+    _held += rowBytes(chk);
+    _chunks.push_back(std::move(chk));
+    if (_held + _keyData.size() + _entries.size() * sizeof(entry) > _opts.MemQuota) {
+        return spill();
+    }
+    return std::nullopt;
+}
+
+std::optional<mysql::SQLError> SortExec::load(cursor &c, size_t b) const {
+    auto keyCol = _types.size();
+    for (; b < c.Reader->NumBatches(); b++) {
+        c.Reader->WillNeed(b + readAheadBatches);
+        if (auto err = c.Reader->ReadBatch(b, c.Chk)) {
+            return err;
+        }
+        if (c.Chk.NumRows() > 0) {
+            c.Batch = b;
+            c.Cur = &c.Chk;
+            c.Row = 0;
+            c.Key = c.Chk.Col(keyCol).GetBytes(0);
+            return std::nullopt;
+        }
+    }
+    c.Done = true;
+    return std::nullopt;
+}
+
+void SortExec::loadEntry(cursor &c, size_t i) const {
+    if (i >= _entries.size()) {
+        c.Done = true;
+        return;
+    }
+    const auto &e = _entries[i];
+    c.Entry = i;
+    c.Cur = &_chunks[e.Chunk];
+    c.Row = e.Row;
+    c.Key = {_keyData.data() + e.Offset, e.Length};
+}
+
+std::optional<mysql::SQLError> SortExec::finish() {
+    _finished = true;
+    sortEntries();
+    if (_runs.empty()) {
+        return std::nullopt;
+    }
+    // The rows left in memory are merged where they are, rather than written to a run.
+    std::vector<cursor> cursors(_runs.size() + 1);
+    for (size_t i = 0; i < _runs.size(); i++) {
+        auto &c = cursors[i];
+        c.Reader = _runs[i].get();
+        for (size_t b = 0; b < readAheadBatches; b++) {
+            c.Reader->WillNeed(b);
+        }
+        if (auto err = load(c, 0)) {
+            return err;
+        }
+    }
+    loadEntry(cursors.back(), 0);
+    _merger = std::make_unique<merger>(std::move(cursors));
+    return std::nullopt;
+}
+
+std::optional<mysql::SQLError> SortExec::Next(Chunk &chk) {
+    if (!_finished) {
+        if (auto err = finish()) {
+            return err;
+        }
+    }
+    if (_merger == nullptr) {
+        // The chunks of the rows in memory are built batchChunks at a time, in parallel.
+        if (_readyPos == _ready.size() && _nextEntry < _entries.size()) {
+            auto end = std::min(_nextEntry + batchChunks * defaultCapacity, _entries.size());
+            _ready = sorted(_nextEntry, end, false);
+            _readyPos = 0;
+            _nextEntry = end;
+        }
+        chk = _readyPos < _ready.size() ? std::move(_ready[_readyPos++]) : Chunk(_types);
+        return std::nullopt;
+    }
+
+    chk = Chunk(_types);
+    auto &cursors = _merger->Cursors;
+    auto &tree = _merger->Tree;
+    while (!chk.IsFull() && !cursors[tree.Winner()].Done) {
+        auto &c = cursors[tree.Winner()];
+        chk.AppendRow(*c.Cur, c.Row);
+        if (c.Reader == nullptr) {
+            loadEntry(c, c.Entry + 1);
+        } else if (++c.Row < c.Cur->NumRows()) {
+            c.Key = c.Cur->Col(_types.size()).GetBytes(c.Row);
+        } else if (auto err = load(c, c.Batch + 1)) {
+            return err;
+        }
+        tree.Replay();
+    }
+    return std::nullopt;
+}
+
+std::tuple<std::vector<Chunk>, std::optional<mysql::SQLError>> SortExec::Execute(std::vector<Chunk> input) {
+    reset();
+    std::vector<Chunk> out;
+    for (auto &chk : input) {
+        if (auto err = Add(std::move(chk))) {
+            return {std::move(out), err};
+        }
+    }
+    for (;;) {
+        Chunk chk;
+        if (auto err = Next(chk)) {
+            return {std::move(out), err};
+        }
+        if (chk.NumRows() == 0) {
+            break;
+        }
+        out.push_back(std::move(chk));
+    }
+    return {std::move(out), std::nullopt};
+}
+
+}  // namespace executor
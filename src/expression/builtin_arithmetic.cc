@@ -0,0 +1,323 @@
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#include "expression/builtin.hh"
+#include "parser/mysql/errcode.hh"
+
+namespace expression {
+
+using util::chunk::Chunk;
+using util::chunk::Column;
+
+namespace {
+
+// withBool calls f with b as a std::bool_constant, to instantiate a loop for each signedness of its operands.
+template <typename F>
+void withBool(bool b, F &&f) {
+    if (b) {
+        f(std::true_type{});
+    } else {
+        f(std::false_type{});
+    }
+}
+
+template <bool isUnsigned>
+__int128 widen(int64_t v) {
+    if constexpr (isUnsigned) {
+        return static_cast<uint64_t>(v);
+    } else {
+        return v;
+    }
+}
+
+template <bool isUnsigned>
+bool inRange(__int128 v) {
+    if constexpr (isUnsigned) {
+        return v >= 0 && v <= static_cast<__int128>(UINT64_MAX);
+    } else {
+        return v >= INT64_MIN && v <= INT64_MAX;
+    }
+}
+
+template <Op op, typename T>
+bool overflows(T a, T b, T *out) {
+    if constexpr (op == Op::Plus) {
+        return __builtin_add_overflow(a, b, out);
+    } else if constexpr (op == Op::Minus) {
+        return __builtin_sub_overflow(a, b, out);
+    } else {
+        return __builtin_mul_overflow(a, b, out);
+    }
+}
+
+// intOp sets out to a op b, of the signedness lu and ru, as a result of the signedness u, and returns whether it is
+// out of its range. A zero divisor gives 0, the row being set null afterwards.
+template <Op op, bool lu, bool ru, bool u>
+inline bool intOp(int64_t a, int64_t b, int64_t &out) {
+    if constexpr (op == Op::Plus || op == Op::Minus || op == Op::Mul) {
+        if constexpr (!lu && !ru && !u) {
+            return overflows<op>(a, b, &out);
+        } else if constexpr (lu && ru && u) {
+            uint64_t r;
+            bool overflow = overflows<op>(static_cast<uint64_t>(a), static_cast<uint64_t>(b), &r);
+            out = static_cast<int64_t>(r);
+            return overflow;
+        } else {
+            __int128 r;
+            bool overflow = overflows<op>(widen<lu>(a), widen<ru>(b), &r);
+            out = static_cast<int64_t>(r);
+            return overflow || !inRange<u>(r);
+        }
+    } else if constexpr (op == Op::IntDiv) {
+        if (b == 0) {
+            out = 0;
+            return false;
+        }
+        __int128 r = widen<lu>(a) / widen<ru>(b);
+        out = static_cast<int64_t>(r);
+        return !inRange<u>(r);
+    } else {
+        // The remainder has the sign of the dividend, so that it is in its range.
+        out = b == 0 ? 0 : static_cast<int64_t>(widen<lu>(a) % widen<ru>(b));
+        return false;
+    }
+}
+
+template <Op op>
+inline double realOp(double a, double b) {
+    if constexpr (op == Op::Plus) {
+        return a + b;
+    } else if constexpr (op == Op::Minus) {
+        return a - b;
+    } else if constexpr (op == Op::Mul) {
+        return a * b;
+    } else if constexpr (op == Op::Div) {
+        return b == 0 ? 0 : a / b;
+    } else {
+        return b == 0 ? 0 : std::fmod(a, b);
+    }
+}
+
+bool isDivision(Op op) { return op == Op::Div || op == Op::IntDiv || op == Op::Mod; }
+
+// arithmeticFunction is +, -, *, /, DIV or %, evaluated as _argType.
+class arithmeticFunction : public scalarFunction {
+public:
+    arithmeticFunction(FieldType tp, Op op, std::vector<ExprPtr> args, EvalType argType)
+        : scalarFunction(tp, op, std::move(args)), _argType(argType) {}
+
+    std::optional<mysql::SQLError> VecEval(EvalContext &ctx, const Chunk &chk, const Rows &rows,
+                                           Column &result) const override {
+        resizeResult(result, rows);
+        argument a(ctx), b(ctx);
+        if (auto err = a.Eval(*_args[0], _argType, chk, rows)) {
+            return err;
+        }
+        if (auto err = b.Eval(*_args[1], _argType, chk, rows)) {
+            return err;
+        }
+        if (a.IsNullConst() || b.IsNullConst()) {
+            setAllNull(result);
+            return std::nullopt;
+        }
+        mergeNulls(result, {&a, &b});
+
+        std::optional<mysql::SQLError> err;
+        if (_argType == EvalType::Int) {
+            err = evalInt(a, b, rows, result);
+        } else if (_op == Op::IntDiv) {
+            err = evalIntDivReal(a, b, rows, result);
+        } else {
+            err = evalReal(a, b, rows, result);
+        }
+        if (err || !isDivision(_op)) {
+            return err;
+        }
+        return nullDivisions(ctx, b, rows, result);
+    }
+
+private:
+    std::optional<mysql::SQLError> evalInt(const argument &a, const argument &b, const Rows &rows,
+                                           Column &result) const {
+        bool lu = _args[0]->Type().IsUnsigned(), ru = _args[1]->Type().IsUnsigned();
+        bool u = _type.IsUnsigned();
+        auto *out = result.MutableValues<int64_t>().data();
+        bool bad = false;
+        withBool(lu, [&](auto lu) {
+            withBool(ru, [&](auto ru) {
+                withBool(u, [&](auto u) {
+                    switch (_op) {
+                        case Op::Plus:
+                            bad = evalIntOp<Op::Plus, lu, ru, u>(a, b, rows, result, out);
+                            break;
+                        case Op::Minus:
+                            bad = evalIntOp<Op::Minus, lu, ru, u>(a, b, rows, result, out);
+                            break;
+                        case Op::Mul:
+                            bad = evalIntOp<Op::Mul, lu, ru, u>(a, b, rows, result, out);
+                            break;
+                        case Op::IntDiv:
+                            bad = evalIntOp<Op::IntDiv, lu, ru, u>(a, b, rows, result, out);
+                            break;
+                        default:
+                            bad = evalIntOp<Op::Mod, lu, ru, u>(a, b, rows, result, out);
+                            break;
+                    }
+                });
+            });
+        });
+        if (bad) {
+            return errOutOfRange(*this);
+        }
+        return std::nullopt;
+    }
+
+    // evalIntOp computes the values of the rows, and returns whether one that is not null is out of range. The
+    // overflows are accumulated by the loop and only then looked for, as the null rows may hold any value.
+    template <Op op, bool lu, bool ru, bool u>
+    static bool evalIntOp(const argument &a, const argument &b, const Rows &rows, const Column &result, int64_t *out) {
+        bool overflow = false;
+        visit<int64_t>(a, b, [&](auto x, auto y) {
+            rows.ForEach([&](size_t i) { overflow |= intOp<op, lu, ru, u>(x[i], y[i], out[i]); });
+        });
+        if (!overflow) {
+            return false;
+        }
+        bool bad = false;
+        rows.ForEach([&](size_t i) {
+            int64_t r;
+            bad = bad || (!result.IsNull(i) && intOp<op, lu, ru, u>(a.Value<int64_t>(i), b.Value<int64_t>(i), r));
+        });
+        return bad;
+    }
+
+    std::optional<mysql::SQLError> evalReal(const argument &a, const argument &b, const Rows &rows,
+                                            Column &result) const {
+        auto *out = result.MutableValues<double>().data();
+        bool overflow = false;
+        visit<double>(a, b, [&](auto x, auto y) {
+            auto loop = [&]<Op op>() {
+                rows.ForEach([&](size_t i) {
+                    out[i] = realOp<op>(x[i], y[i]);
+                    overflow |= !std::isfinite(out[i]);
+                });
+            };
+            switch (_op) {
+                case Op::Plus:
+                    loop.template operator()<Op::Plus>();
+                    break;
+                case Op::Minus:
+                    loop.template operator()<Op::Minus>();
+                    break;
+                case Op::Mul:
+                    loop.template operator()<Op::Mul>();
+                    break;
+                case Op::Div:
+                    loop.template operator()<Op::Div>();
+                    break;
+                default:
+                    loop.template operator()<Op::Mod>();
+                    break;
+            }
+        });
+        if (overflow) {
+            bool bad = false;
+            rows.ForEach([&](size_t i) { bad = bad || (!result.IsNull(i) && !std::isfinite(out[i])); });
+            if (bad) {
+                return errOutOfRange(*this);
+            }
+        }
+        return std::nullopt;
+    }
+
+    // evalIntDivReal is DIV of a Real, the quotient truncated to an integer.
+    std::optional<mysql::SQLError> evalIntDivReal(const argument &a, const argument &b, const Rows &rows,
+                                                  Column &result) const {
+        auto *out = result.MutableValues<int64_t>().data();
+        bool u = _type.IsUnsigned();
+        double lo = u ? 0 : -0x1p63, hi = u ? 0x1p64 : 0x1p63;
+        bool overflow = false;
+        visit<double>(a, b, [&](auto x, auto y) {
+            rows.ForEach([&](size_t i) {
+                double q = y[i] == 0 ? 0 : std::trunc(x[i] / y[i]);
+                bool ok = q >= lo && q < hi;
+                overflow |= !ok;
+                out[i] = !ok ? 0 : u ? static_cast<int64_t>(static_cast<uint64_t>(q)) : static_cast<int64_t>(q);
+            });
+        });
+        if (overflow) {
+            bool bad = false;
+            rows.ForEach([&](size_t i) {
+                double q = b.Value<double>(i) == 0 ? 0 : std::trunc(a.Value<double>(i) / b.Value<double>(i));
+                bad = bad || (!result.IsNull(i) && !(q >= lo && q < hi));
+            });
+            if (bad) {
+                return errOutOfRange(*this);
+            }
+        }
+        return std::nullopt;
+    }
+
+    // nullDivisions sets the rows divided by zero null, and reports them as the SQL mode of ctx says.
+    std::optional<mysql::SQLError> nullDivisions(EvalContext &ctx, const argument &b, const Rows &rows,
+                                                 Column &result) const {
+        size_t zeros = 0;
+        auto isZero = [&](size_t i) {
+            return _argType == EvalType::Int ? b.Value<int64_t>(i) == 0 : b.Value<double>(i) == 0;
+        };
+        rows.ForEach([&](size_t i) {
+            if (!result.IsNull(i) && isZero(i)) {
+                result.SetNull(i, true);
+                zeros++;
+            }
+        });
+        if (zeros == 0) {
+            return std::nullopt;
+        }
+        switch (divisionByZeroOf(ctx)) {
+            case divisionByZero::ignore:
+                break;
+            case divisionByZero::warn:
+                for (size_t i = 0; i < zeros; i++) {
+                    ctx.AppendWarning(mysql::NewErr(mysql::ErrDivisionByZero));
+                }
+                break;
+            case divisionByZero::error:
+                return mysql::NewErr(mysql::ErrDivisionByZero);
+        }
+        return std::nullopt;
+    }
+
+    EvalType _argType;
+};
+
+}  // namespace
+
+std::tuple<ExprPtr, std::optional<mysql::SQLError>> newArithmetic(Op op, std::vector<ExprPtr> args,
+                                                                  mysql::SQLMode mode) {
+    auto &lhs = args[0]->Type(), &rhs = args[1]->Type();
+    for (const auto &arg : args) {
+        if (arg->GetEvalType() == EvalType::String && !isNullConstant(*arg)) {
+            return {nullptr, mysql::NewErr(mysql::ErrNotSupportedYet, ("arithmetic of " + arg->String()).c_str())};
+        }
+    }
+    bool real = lhs.GetEvalType() == EvalType::Real || rhs.GetEvalType() == EvalType::Real;
+    auto argType = real || op == Op::Div ? EvalType::Real : EvalType::Int;
+
+    FieldType tp{mysql::TypeLonglong, 0};
+    bool isUnsigned = lhs.IsUnsigned() || rhs.IsUnsigned();
+    if (op == Op::Div || (real && op != Op::IntDiv)) {
+        tp.Tp = mysql::TypeDouble;
+    } else if (op == Op::Mod) {
+        isUnsigned = lhs.IsUnsigned();
+    } else if (op == Op::Minus) {
+        isUnsigned = isUnsigned && !mode.HasNoUnsignedSubtractionMode();
+    }
+    if (tp.Tp == mysql::TypeLonglong && isUnsigned) {
+        tp.Flag |= mysql::UnsignedFlag;
+    }
+    return {std::make_unique<arithmeticFunction>(tp, op, std::move(args), argType), std::nullopt};
+}
+
+}  // namespace expression
@@ -0,0 +1,173 @@
+#include <cstdint>
+#include <string_view>
+
+#include "expression/builtin.hh"
+#include "parser/mysql/errcode.hh"
+
+namespace expression {
+
+using util::chunk::Chunk;
+using util::chunk::Column;
+
+namespace {
+
+template <Op op, typename T>
+inline bool compare(T a, T b) {
+    if constexpr (op == Op::EQ || op == Op::NullEQ) {
+        return a == b;
+    } else if constexpr (op == Op::NE) {
+        return a != b;
+    } else if constexpr (op == Op::LT) {
+        return a < b;
+    } else if constexpr (op == Op::LE) {
+        return a <= b;
+    } else if constexpr (op == Op::GT) {
+        return a > b;
+    } else {
+        return a >= b;
+    }
+}
+
+// withOp calls f with op as its template argument, NullEQ comparing like EQ.
+template <typename F>
+void withOp(Op op, F &&f) {
+    switch (op) {
+        case Op::EQ:
+        case Op::NullEQ:
+            f.template operator()<Op::EQ>();
+            break;
+        case Op::NE:
+            f.template operator()<Op::NE>();
+            break;
+        case Op::LT:
+            f.template operator()<Op::LT>();
+            break;
+        case Op::LE:
+            f.template operator()<Op::LE>();
+            break;
+        case Op::GT:
+            f.template operator()<Op::GT>();
+            break;
+        default:
+            f.template operator()<Op::GE>();
+            break;
+    }
+}
+
+// compareFunction is a comparison of two values of _argType.
+class compareFunction : public scalarFunction {
+public:
+    compareFunction(Op op, std::vector<ExprPtr> args, EvalType argType)
+        : scalarFunction(FieldType{mysql::TypeLonglong, 0}, op, std::move(args)), _argType(argType) {}
+
+    std::optional<mysql::SQLError> VecEval(EvalContext &ctx, const Chunk &chk, const Rows &rows,
+                                           Column &result) const override {
+        resizeResult(result, rows);
+        argument a(ctx), b(ctx);
+        if (auto err = a.Eval(*_args[0], _argType, chk, rows)) {
+            return err;
+        }
+        if (auto err = b.Eval(*_args[1], _argType, chk, rows)) {
+            return err;
+        }
+        auto *out = result.MutableValues<int64_t>().data();
+        if (_op != Op::NullEQ) {
+            if (a.IsNullConst() || b.IsNullConst()) {
+                setAllNull(result);
+                return std::nullopt;
+            }
+            mergeNulls(result, {&a, &b});
+        }
+
+        switch (_argType) {
+            case EvalType::Int:
+                compareInt(a, b, rows, out);
+                break;
+            case EvalType::Real:
+                withOp(_op, [&]<Op op>() {
+                    visit<double>(a, b, [&](auto x, auto y) {
+                        rows.ForEach([&](size_t i) { out[i] = compare<op>(x[i], y[i]); });
+                    });
+                });
+                break;
+            case EvalType::String:
+                withOp(_op, [&]<Op op>() {
+                    rows.ForEach([&](size_t i) { out[i] = compare<op>(a.Bytes(i).compare(b.Bytes(i)), 0); });
+                });
+                break;
+        }
+
+        // NULL <=> NULL is true, and a value <=> NULL false.
+        if (_op == Op::NullEQ && (a.HasNulls() || b.HasNulls())) {
+            rows.ForEach([&](size_t i) {
+                bool an = a.IsNull(i), bn = b.IsNull(i);
+                if (an || bn) {
+                    out[i] = an && bn;
+                }
+            });
+        }
+        return std::nullopt;
+    }
+
+private:
+    void compareInt(const argument &a, const argument &b, const Rows &rows, int64_t *out) const {
+        bool lu = _args[0]->Type().IsUnsigned(), ru = _args[1]->Type().IsUnsigned();
+        withOp(_op, [&]<Op op>() {
+            if (lu == ru) {
+                // Values of the same signedness compare as their type.
+                auto loop = [&]<typename T>() {
+                    visit<T>(a, b, [&](auto x, auto y) {
+                        rows.ForEach([&](size_t i) { out[i] = compare<op>(x[i], y[i]); });
+                    });
+                };
+                if (lu) {
+                    loop.template operator()<uint64_t>();
+                } else {
+                    loop.template operator()<int64_t>();
+                }
+                return;
+            }
+            // A negative signed value is less than any unsigned one, else they compare as unsigned.
+            visit<int64_t>(a, b, [&](auto x, auto y) {
+                rows.ForEach([&](size_t i) {
+                    __int128 l = lu ? static_cast<__int128>(static_cast<uint64_t>(x[i])) : x[i];
+                    __int128 r = ru ? static_cast<__int128>(static_cast<uint64_t>(y[i])) : y[i];
+                    out[i] = compare<op>(l, r);
+                });
+            });
+        });
+    }
+
+    EvalType _argType;
+};
+
+}  // namespace
+
+std::tuple<ExprPtr, std::optional<mysql::SQLError>> newCompare(Op op, std::vector<ExprPtr> args) {
+    // The arguments are compared as their type, NULL being of any, as Real if one is and the other is Int.
+    bool hasInt = false, hasReal = false, hasString = false;
+    for (const auto &arg : args) {
+        if (isNullConstant(*arg)) {
+            continue;
+        }
+        switch (arg->GetEvalType()) {
+            case EvalType::Int:
+                hasInt = true;
+                break;
+            case EvalType::Real:
+                hasReal = true;
+                break;
+            case EvalType::String:
+                hasString = true;
+                break;
+        }
+    }
+    if (hasString && (hasInt || hasReal)) {
+        return {nullptr, mysql::NewErr(mysql::ErrNotSupportedYet,
+                                       ("comparison of " + args[0]->String() + " and " + args[1]->String()).c_str())};
+    }
+    auto argType = hasString ? EvalType::String : hasReal ? EvalType::Real : EvalType::Int;
+    return {std::make_unique<compareFunction>(op, std::move(args), argType), std::nullopt};
+}
+
+}  // namespace expression
@@ -0,0 +1,148 @@
+#include <cstdint>
+#include <memory>
+
+#include "expression/builtin.hh"
+#include "parser/mysql/errcode.hh"
+
+namespace expression {
+
+using util::chunk::Chunk;
+using util::chunk::Column;
+
+namespace {
+
+// caseFunction is `CASE WHEN args[0] THEN args[1] ... [ELSE args[n - 1]] END`. The conditions are evaluated for the
+// rows no previous one matched, and every branch for the rows it is taken by, so that none is evaluated for a row it
+// does not return.
+class caseFunction : public scalarFunction {
+public:
+    caseFunction(FieldType tp, std::vector<ExprPtr> args) : scalarFunction(tp, Op::Case, std::move(args)) {}
+
+    std::optional<mysql::SQLError> VecEval(EvalContext &ctx, const Chunk &chk, const Rows &rows,
+                                           Column &result) const override {
+        auto n = rows.Len();
+        auto whens = _args.size() / 2;
+        // branch is the branch taken by every row, whens for the ELSE or NULL, and unselected for the other rows.
+        constexpr uint32_t unselected = UINT32_MAX;
+        std::vector<uint32_t> branch(n, unselected);
+        std::vector<uint32_t> remaining, kept;
+        rows.ForEach([&](size_t i) { branch[i] = static_cast<uint32_t>(whens); });
+
+        for (size_t w = 0; w < whens; w++) {
+            auto when = w == 0 ? rows : Rows(n, remaining);
+            if (when.Size() == 0) {
+                break;
+            }
+            argument cond(ctx);
+            auto tp = _args[2 * w]->GetEvalType();
+            if (auto err = cond.Eval(*_args[2 * w], tp, chk, when)) {
+                return err;
+            }
+            kept.clear();
+            when.ForEach([&](size_t i) {
+                bool matched = !cond.IsNull(i) && (tp == EvalType::Int ? cond.Value<int64_t>(i) != 0
+                                                                       : cond.Value<double>(i) != 0);
+                if (matched) {
+                    branch[i] = static_cast<uint32_t>(w);
+                } else {
+                    kept.push_back(static_cast<uint32_t>(i));
+                }
+            });
+            std::swap(remaining, kept);
+        }
+
+        // Every branch is evaluated for its rows.
+        std::vector<std::vector<uint32_t>> sels(whens + 1);
+        rows.ForEach([&](size_t i) { sels[branch[i]].push_back(static_cast<uint32_t>(i)); });
+        auto tp = GetEvalType();
+        std::vector<std::unique_ptr<argument>> values(whens + 1);
+        for (size_t b = 0; b <= whens; b++) {
+            auto index = b < whens ? 2 * b + 1 : _args.size() - 1;
+            if (sels[b].empty() || (b == whens && _args.size() % 2 == 0)) {
+                continue;
+            }
+            values[b] = std::make_unique<argument>(ctx);
+            if (auto err = values[b]->Eval(*_args[index], tp, chk, Rows(n, sels[b]))) {
+                return err;
+            }
+        }
+        auto isNull = [&](size_t i) { return values[branch[i]] == nullptr || values[branch[i]]->IsNull(i); };
+
+        if (tp == EvalType::String) {
+            result.Reset();
+            result.Reserve(n);
+            for (size_t i = 0; i < n; i++) {
+                if (branch[i] == unselected || isNull(i)) {
+                    result.AppendNull();
+                } else {
+                    result.AppendBytes(values[branch[i]]->Bytes(i));
+                }
+            }
+            return std::nullopt;
+        }
+        resizeResult(result, rows);
+        auto fill = [&]<typename T>() {
+            auto out = result.MutableValues<T>();
+            rows.ForEach([&](size_t i) {
+                if (isNull(i)) {
+                    result.SetNull(i, true);
+                } else {
+                    out[i] = values[branch[i]]->template Value<T>(i);
+                }
+            });
+        };
+        if (tp == EvalType::Int) {
+            fill.template operator()<int64_t>();
+        } else {
+            fill.template operator()<double>();
+        }
+        return std::nullopt;
+    }
+};
+
+}  // namespace
+
+std::tuple<ExprPtr, std::optional<mysql::SQLError>> newCase(std::vector<ExprPtr> args) {
+    // The result is of the type of the branches, NULL being of any: Real if one is Real or they are Int of both
+    // signednesses.
+    bool hasSigned = false, hasUnsigned = false, hasReal = false, hasString = false;
+    for (size_t i = 0; i < args.size(); i++) {
+        bool isValue = i % 2 == 1 || i == args.size() - 1;
+        auto tp = args[i]->GetEvalType();
+        if (!isValue) {
+            if (tp == EvalType::String && !isNullConstant(*args[i])) {
+                auto what = "truth value of " + args[i]->String();
+                return {nullptr, mysql::NewErr(mysql::ErrNotSupportedYet, what.c_str())};
+            }
+            continue;
+        }
+        if (isNullConstant(*args[i])) {
+            continue;
+        }
+        switch (tp) {
+            case EvalType::Int:
+                (args[i]->Type().IsUnsigned() ? hasUnsigned : hasSigned) = true;
+                break;
+            case EvalType::Real:
+                hasReal = true;
+                break;
+            case EvalType::String:
+                hasString = true;
+                break;
+        }
+    }
+    if (hasString && (hasSigned || hasUnsigned || hasReal)) {
+        return {nullptr, mysql::NewErr(mysql::ErrNotSupportedYet, "CASE of strings and numbers")};
+    }
+    FieldType tp{mysql::TypeLonglong, 0};
+    if (hasString) {
+        tp.Tp = mysql::TypeVarString;
+    } else if (hasReal || (hasSigned && hasUnsigned)) {
+        tp.Tp = mysql::TypeDouble;
+    } else if (hasUnsigned) {
+        tp.Flag |= mysql::UnsignedFlag;
+    }
+    return {std::make_unique<caseFunction>(tp, std::move(args)), std::nullopt};
+}
+
+}  // namespace expression
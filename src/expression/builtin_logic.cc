@@ -0,0 +1,118 @@
+#include <cstdint>
+
+#include "expression/builtin.hh"
+#include "parser/mysql/errcode.hh"
+
+namespace expression {
+
+using util::chunk::Chunk;
+using util::chunk::Column;
+
+namespace {
+
+// truthOf reads the values of an argument as booleans.
+template <typename R>
+struct truthOf {
+    R r;
+    bool operator[](size_t i) const { return r[i] != 0; }
+};
+
+// withTruth calls f with the reader of the truth values of a, an argument of tp.
+template <typename F>
+void withTruth(const argument &a, EvalType tp, F &&f) {
+    auto call = [&](auto x) { f(truthOf<decltype(x)>{x}); };
+    if (tp == EvalType::Int) {
+        visit1<int64_t>(a, call);
+    } else {
+        visit1<double>(a, call);
+    }
+}
+
+bool isTrue(const argument &a, EvalType tp, size_t row) {
+    return tp == EvalType::Int ? a.Value<int64_t>(row) != 0 : a.Value<double>(row) != 0;
+}
+
+// logicFunction is AND, OR, XOR, NOT, IS NULL or IS NOT NULL.
+class logicFunction : public scalarFunction {
+public:
+    logicFunction(Op op, std::vector<ExprPtr> args)
+        : scalarFunction(FieldType{mysql::TypeLonglong, 0}, op, std::move(args)) {}
+
+    std::optional<mysql::SQLError> VecEval(EvalContext &ctx, const Chunk &chk, const Rows &rows,
+                                           Column &result) const override {
+        resizeResult(result, rows);
+        auto *out = result.MutableValues<int64_t>().data();
+        argument a(ctx), b(ctx);
+        auto at = _args[0]->GetEvalType();
+        if (auto err = a.Eval(*_args[0], at, chk, rows)) {
+            return err;
+        }
+        if (_op == Op::IsNull || _op == Op::IsNotNull) {
+            // They are never null.
+            bool isNull = _op == Op::IsNull;
+            if (!a.HasNulls()) {
+                rows.ForEach([&](size_t i) { out[i] = !isNull; });
+            } else {
+                rows.ForEach([&](size_t i) { out[i] = a.IsNull(i) == isNull; });
+            }
+            return std::nullopt;
+        }
+        if (_op == Op::UnaryNot) {
+            withTruth(a, at, [&](auto x) { rows.ForEach([&](size_t i) { out[i] = !x[i]; }); });
+            mergeNulls(result, {&a});
+            return std::nullopt;
+        }
+
+        auto bt = _args[1]->GetEvalType();
+        if (auto err = b.Eval(*_args[1], bt, chk, rows)) {
+            return err;
+        }
+        withTruth(a, at, [&](auto x) {
+            withTruth(b, bt, [&](auto y) {
+                switch (_op) {
+                    case Op::LogicAnd:
+                        rows.ForEach([&](size_t i) { out[i] = x[i] && y[i]; });
+                        break;
+                    case Op::LogicOr:
+                        rows.ForEach([&](size_t i) { out[i] = x[i] || y[i]; });
+                        break;
+                    default:
+                        rows.ForEach([&](size_t i) { out[i] = x[i] != y[i]; });
+                        break;
+                }
+            });
+        });
+        mergeNulls(result, {&a, &b});
+        if (_op == Op::LogicXor || result.NullCount() == 0) {
+            return std::nullopt;
+        }
+
+        // FALSE AND NULL is FALSE, and TRUE OR NULL is TRUE.
+        bool decides = _op == Op::LogicOr;
+        rows.ForEach([&](size_t i) {
+            if (!result.IsNull(i)) {
+                return;
+            }
+            if ((!a.IsNull(i) && isTrue(a, at, i) == decides) || (!b.IsNull(i) && isTrue(b, bt, i) == decides)) {
+                result.SetNull(i, false);
+                out[i] = decides;
+            }
+        });
+        return std::nullopt;
+    }
+};
+
+}  // namespace
+
+std::tuple<ExprPtr, std::optional<mysql::SQLError>> newLogic(Op op, std::vector<ExprPtr> args) {
+    if (op != Op::IsNull && op != Op::IsNotNull) {
+        for (const auto &arg : args) {
+            if (arg->GetEvalType() == EvalType::String && !isNullConstant(*arg)) {
+                return {nullptr, mysql::NewErr(mysql::ErrNotSupportedYet, ("truth value of " + arg->String()).c_str())};
+            }
+        }
+    }
+    return {std::make_unique<logicFunction>(op, std::move(args)), std::nullopt};
+}
+
+}  // namespace expression
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "expression/builtin.hh"
+#include "parser/mysql/errcode.hh"
+
+namespace expression {
+
+using util::chunk::Chunk;
+using util::chunk::Column;
+
+namespace {
+
+// maxLinearIn is the size of the longest list looked up by comparing a row with every value, in a loop over the rows
+// for each value; the longer ones are binary searched.
+constexpr size_t maxLinearIn = 16;
+
+// inFunction is `args[0] IN (args[1], ...)`, the values of the list sorted by the domain of the comparison.
+class inFunction : public scalarFunction {
+public:
+    inFunction(std::vector<ExprPtr> args, EvalType argType)
+        : scalarFunction(FieldType{mysql::TypeLonglong, 0}, Op::In, std::move(args)), _argType(argType) {
+        bool isUnsigned = _args[0]->Type().IsUnsigned();
+        for (size_t i = 1; i < _args.size(); i++) {
+            const auto &c = static_cast<const Constant &>(*_args[i]);
+            const auto &v = c.GetValue();
+            if (c.IsNull()) {
+                _hasNull = true;
+            } else if (_argType == EvalType::String) {
+                _strings.push_back(std::get<std::string>(v));
+            } else if (const auto *d = std::get_if<double>(&v)) {
+                _reals.push_back(*d);
+            } else if (_argType == EvalType::Real) {
+                auto n = std::get<int64_t>(v);
+                _reals.push_back(c.Type().IsUnsigned() ? static_cast<double>(static_cast<uint64_t>(n))
+                                                       : static_cast<double>(n));
+            } else {
+                // A value of the other signedness out of the range of the argument never matches.
+                auto n = std::get<int64_t>(v);
+                if (n >= 0 || c.Type().IsUnsigned() == isUnsigned) {
+                    _ints.push_back(n);
+                }
+            }
+        }
+        if (isUnsigned) {
+            std::sort(_ints.begin(), _ints.end(),
+                      [](int64_t a, int64_t b) { return static_cast<uint64_t>(a) < static_cast<uint64_t>(b); });
+        } else {
+            std::sort(_ints.begin(), _ints.end());
+        }
+        std::sort(_reals.begin(), _reals.end());
+        std::sort(_strings.begin(), _strings.end());
+    }
+
+    std::optional<mysql::SQLError> VecEval(EvalContext &ctx, const Chunk &chk, const Rows &rows,
+                                           Column &result) const override {
+        resizeResult(result, rows);
+        argument a(ctx);
+        if (auto err = a.Eval(*_args[0], _argType, chk, rows)) {
+            return err;
+        }
+        if (a.IsNullConst()) {
+            setAllNull(result);
+            return std::nullopt;
+        }
+        auto *out = result.MutableValues<int64_t>().data();
+        switch (_argType) {
+            case EvalType::Int:
+                if (_args[0]->Type().IsUnsigned()) {
+                    lookup<uint64_t>(a, {reinterpret_cast<const uint64_t *>(_ints.data()), _ints.size()}, rows, out);
+                } else {
+                    lookup<int64_t>(a, _ints, rows, out);
+                }
+                break;
+            case EvalType::Real:
+                lookup<double>(a, _reals, rows, out);
+                break;
+            case EvalType::String:
+                rows.ForEach([&](size_t i) {
+                    out[i] = std::binary_search(_strings.begin(), _strings.end(), a.Bytes(i), std::less<>());
+                });
+                break;
+        }
+        mergeNulls(result, {&a});
+
+        // A value not in a list with NULL may be the NULL.
+        if (_hasNull) {
+            rows.ForEach([&](size_t i) {
+                if (out[i] == 0) {
+                    result.SetNull(i, true);
+                }
+            });
+        }
+        return std::nullopt;
+    }
+
+private:
+    template <typename T>
+    static void lookup(const argument &a, std::span<const T> values, const Rows &rows, int64_t *out) {
+        visit1<T>(a, [&](auto x) {
+            rows.ForEach([&](size_t i) { out[i] = 0; });
+            if (values.size() <= maxLinearIn) {
+                for (auto v : values) {
+                    rows.ForEach([&](size_t i) { out[i] |= x[i] == v; });
+                }
+            } else {
+                rows.ForEach([&](size_t i) { out[i] = std::binary_search(values.begin(), values.end(), x[i]); });
+            }
+        });
+    }
+
+    EvalType _argType;
+    bool _hasNull{false};
+    std::vector<int64_t> _ints;
+    std::vector<double> _reals;
+    std::vector<std::string> _strings;
+};
+
+}  // namespace
+
+std::tuple<ExprPtr, std::optional<mysql::SQLError>> newIn(std::vector<ExprPtr> args) {
+    // The list is compared in the domain of the argument, Real if one of them is and the others are Int.
+    auto argType = args[0]->GetEvalType();
+    if (isNullConstant(*args[0])) {
+        argType = EvalType::Int;
+    }
+    for (size_t i = 1; i < args.size(); i++) {
+        if (dynamic_cast<const Constant *>(args[i].get()) == nullptr) {
+            return {nullptr, mysql::NewErr(mysql::ErrNotSupportedYet, ("IN list of " + args[i]->String()).c_str())};
+        }
+        if (isNullConstant(*args[i])) {
+            continue;
+        }
+        auto tp = args[i]->GetEvalType();
+        if ((tp == EvalType::String) != (argType == EvalType::String)) {
+            return {nullptr, mysql::NewErr(mysql::ErrNotSupportedYet,
+                                           ("IN of " + args[0]->String() + " and " + args[i]->String()).c_str())};
+        }
+        if (tp == EvalType::Real) {
+            argType = EvalType::Real;
+        }
+    }
+    return {std::make_unique<inFunction>(std::move(args), argType), std::nullopt};
+}
+
+}  // namespace expression
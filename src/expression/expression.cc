@@ -0,0 +1,396 @@
+#include "expression/expression.hh"
+
+#include <cstdio>
+#include <cstring>
+
+#include "expression/builtin.hh"
+
+namespace expression {
+
+using util::chunk::Chunk;
+using util::chunk::Column;
+
+namespace {
+
+// opNames are the operators of the functions, for String.
+const char *opName(Op op) {
+    switch (op) {
+        case Op::Plus:
+            return "+";
+        case Op::Minus:
+            return "-";
+        case Op::Mul:
+            return "*";
+        case Op::Div:
+            return "/";
+        case Op::IntDiv:
+            return "DIV";
+        case Op::Mod:
+            return "%";
+        case Op::EQ:
+            return "=";
+        case Op::NE:
+            return "!=";
+        case Op::LT:
+            return "<";
+        case Op::LE:
+            return "<=";
+        case Op::GT:
+            return ">";
+        case Op::GE:
+            return ">=";
+        case Op::NullEQ:
+            return "<=>";
+        case Op::LogicAnd:
+            return "AND";
+        case Op::LogicOr:
+            return "OR";
+        case Op::LogicXor:
+            return "XOR";
+        case Op::UnaryNot:
+            return "NOT";
+        case Op::IsNull:
+            return "IS NULL";
+        case Op::IsNotNull:
+            return "IS NOT NULL";
+        case Op::In:
+            return "IN";
+        case Op::Case:
+            return "CASE";
+    }
+    return "";
+}
+
+}  // namespace
+
+EvalType FieldType::GetEvalType() const {
+    switch (Tp) {
+        case mysql::TypeTiny:
+        case mysql::TypeShort:
+        case mysql::TypeInt24:
+        case mysql::TypeLong:
+        case mysql::TypeLonglong:
+        case mysql::TypeYear:
+        case mysql::TypeNull:
+            return EvalType::Int;
+        case mysql::TypeFloat:
+        case mysql::TypeDouble:
+            return EvalType::Real;
+        default:
+            return EvalType::String;
+    }
+}
+
+Column EvalColumn(EvalContext &ctx, EvalType tp) {
+    switch (tp) {
+        case EvalType::Int:
+            return ctx.Columns.AllocColumn(Column::ElemSize(mysql::TypeLonglong));
+        case EvalType::Real:
+            return ctx.Columns.AllocColumn(Column::ElemSize(mysql::TypeDouble));
+        default:
+            return ctx.Columns.AllocColumn(Column::varElemSize);
+    }
+}
+
+const Column *ColumnRef::Input(const Chunk &chk) const {
+    // A FLOAT column holds floats, evaluated as doubles.
+    return _type.Tp == mysql::TypeFloat ? nullptr : &chk.Col(_index);
+}
+
+std::optional<mysql::SQLError> ColumnRef::VecEval(EvalContext &, const Chunk &chk, const Rows &rows,
+                                                  Column &result) const {
+    const auto &col = chk.Col(_index);
+    auto n = rows.Len();
+    if (!col.IsFixed()) {
+        result.Reset();
+        result.Reserve(n, col.DataSize());
+        for (size_t i = 0; i < n; i++) {
+            result.AppendFrom(col, i);
+        }
+        return std::nullopt;
+    }
+    result.ResizeFixed(n);
+    if (_type.Tp == mysql::TypeFloat) {
+        auto in = col.Values<float>();
+        auto out = result.MutableValues<double>();
+        rows.ForEach([&](size_t i) { out[i] = in[i]; });
+    } else if (n > 0) {
+        std::memcpy(result.MutableValues<int64_t>().data(), col.Data(), n * sizeof(int64_t));
+    }
+    if (col.NullCount() > 0) {
+        std::memcpy(result.MutableNullBitmap(), col.NullBitmap(), (n + 7) / 8);
+        result.RecountNulls();
+    }
+    return std::nullopt;
+}
+
+Constant::Constant(FieldType tp, Value value) : Expression(tp), _value(std::move(value)) {}
+
+std::optional<mysql::SQLError> Constant::VecEval(EvalContext &, const Chunk &, const Rows &rows,
+                                                 Column &result) const {
+    auto n = rows.Len();
+    if (GetEvalType() == EvalType::String) {
+        result.Reset();
+        const auto *s = std::get_if<std::string>(&_value);
+        result.Reserve(n, s != nullptr ? s->size() * n : 0);
+        for (size_t i = 0; i < n; i++) {
+            if (s == nullptr) {
+                result.AppendNull();
+            } else {
+                result.AppendBytes(*s);
+            }
+        }
+        return std::nullopt;
+    }
+    result.ResizeFixed(n);
+    if (IsNull()) {
+        setAllNull(result);
+    } else if (const auto *v = std::get_if<int64_t>(&_value)) {
+        auto out = result.MutableValues<int64_t>();
+        std::fill(out.begin(), out.end(), *v);
+    } else {
+        auto out = result.MutableValues<double>();
+        std::fill(out.begin(), out.end(), std::get<double>(_value));
+    }
+    return std::nullopt;
+}
+
+std::string Constant::String() const {
+    if (IsNull()) {
+        return "NULL";
+    }
+    if (const auto *v = std::get_if<int64_t>(&_value)) {
+        return _type.IsUnsigned() ? std::to_string(static_cast<uint64_t>(*v)) : std::to_string(*v);
+    }
+    if (const auto *v = std::get_if<double>(&_value)) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%g", *v);
+        return buf;
+    }
+    return "'" + std::get<std::string>(_value) + "'";
+}
+
+std::string scalarFunction::String() const {
+    switch (_op) {
+        case Op::UnaryNot:
+            return "(NOT " + _args[0]->String() + ")";
+        case Op::IsNull:
+        case Op::IsNotNull:
+            return "(" + _args[0]->String() + " " + opName(_op) + ")";
+        case Op::In: {
+            auto s = "(" + _args[0]->String() + " IN (";
+            for (size_t i = 1; i < _args.size(); i++) {
+                s += (i > 1 ? ", " : "") + _args[i]->String();
+            }
+            return s + "))";
+        }
+        case Op::Case: {
+            std::string s = "CASE";
+            size_t i = 0;
+            for (; i + 1 < _args.size(); i += 2) {
+                s += " WHEN " + _args[i]->String() + " THEN " + _args[i + 1]->String();
+            }
+            if (i < _args.size()) {
+                s += " ELSE " + _args[i]->String();
+            }
+            return s + " END";
+        }
+        default:
+            return "(" + _args[0]->String() + " " + opName(_op) + " " + _args[1]->String() + ")";
+    }
+}
+
+argument::~argument() {
+    if (_scratch) {
+        _ctx.Columns.FreeColumn(std::move(*_scratch));
+    }
+}
+
+std::optional<mysql::SQLError> argument::Eval(const Expression &e, EvalType tp, const Chunk &chk, const Rows &rows) {
+    if (const auto *c = dynamic_cast<const Constant *>(&e)) {
+        _col = nullptr;
+        _null = c->IsNull();
+        if (const auto *v = std::get_if<int64_t>(&c->GetValue())) {
+            _int = *v;
+            _real = e.Type().IsUnsigned() ? static_cast<double>(static_cast<uint64_t>(*v)) : static_cast<double>(*v);
+        } else if (const auto *v = std::get_if<double>(&c->GetValue())) {
+            _real = *v;
+        } else if (const auto *v = std::get_if<std::string>(&c->GetValue())) {
+            _bytes = *v;
+        }
+        return std::nullopt;
+    }
+
+    const auto *col = e.Input(chk);
+    if (col == nullptr) {
+        _scratch = EvalColumn(_ctx, e.GetEvalType());
+        if (auto err = e.VecEval(_ctx, chk, rows, *_scratch)) {
+            return err;
+        }
+        col = &*_scratch;
+    }
+    if (e.GetEvalType() == tp) {
+        _col = col;
+        return std::nullopt;
+    }
+
+    // An Int evaluated as a Real.
+    auto real = EvalColumn(_ctx, EvalType::Real);
+    real.ResizeFixed(rows.Len());
+    auto in = col->Values<int64_t>();
+    auto out = real.MutableValues<double>();
+    if (e.Type().IsUnsigned()) {
+        rows.ForEach([&](size_t i) { out[i] = static_cast<double>(static_cast<uint64_t>(in[i])); });
+    } else {
+        rows.ForEach([&](size_t i) { out[i] = static_cast<double>(in[i]); });
+    }
+    if (col->NullCount() > 0 && rows.Len() > 0) {
+        std::memcpy(real.MutableNullBitmap(), col->NullBitmap(), (rows.Len() + 7) / 8);
+        real.RecountNulls();
+    }
+    if (_scratch) {
+        _ctx.Columns.FreeColumn(std::move(*_scratch));
+    }
+    _scratch = std::move(real);
+    _col = &*_scratch;
+    return std::nullopt;
+}
+
+void setAllNull(Column &result) {
+    if (result.Length() > 0) {
+        std::memset(result.MutableNullBitmap(), 0, (result.Length() + 7) / 8);
+    }
+    result.RecountNulls();
+}
+
+void mergeNulls(Column &result, std::initializer_list<const argument *> args) {
+    auto bytes = (result.Length() + 7) / 8;
+    bool merged = false;
+    for (const auto *a : args) {
+        if (a->IsNullConst()) {
+            setAllNull(result);
+            return;
+        }
+        if (a->IsConst() || a->Col().NullCount() == 0) {
+            continue;
+        }
+        auto *out = result.MutableNullBitmap();
+        const auto *in = a->Col().NullBitmap();
+        for (size_t i = 0; i < bytes; i++) {
+            out[i] &= in[i];
+        }
+        merged = true;
+    }
+    if (merged) {
+        result.RecountNulls();
+    }
+}
+
+bool isNullConstant(const Expression &e) {
+    const auto *c = dynamic_cast<const Constant *>(&e);
+    return c != nullptr && c->IsNull();
+}
+
+mysql::SQLError errOutOfRange(const Expression &e) {
+    const char *tp = e.GetEvalType() == EvalType::Real ? "DOUBLE"
+                     : e.Type().IsUnsigned()           ? "BIGINT UNSIGNED"
+                                                       : "BIGINT";
+    return mysql::NewErr(mysql::ErrDataOutOfRange, tp, e.String().c_str());
+}
+
+divisionByZero divisionByZeroOf(EvalContext &ctx) {
+    // A division by zero is NULL. It is reported as a warning, except by the writes: they ignore it without
+    // ERROR_FOR_DIVISION_BY_ZERO, and fail with it in the strict mode.
+    if (ctx.InDML) {
+        if (!ctx.Mode.HasErrorForDivisionByZeroMode()) {
+            return divisionByZero::ignore;
+        }
+        if (ctx.Mode.HasStrictMode()) {
+            return divisionByZero::error;
+        }
+    }
+    return divisionByZero::warn;
+}
+
+std::tuple<ExprPtr, std::optional<mysql::SQLError>> NewFunction(Op op, std::vector<ExprPtr> args,
+                                                                mysql::SQLMode mode) {
+    size_t minArgs = 2, maxArgs = 2;
+    switch (op) {
+        case Op::UnaryNot:
+        case Op::IsNull:
+        case Op::IsNotNull:
+            minArgs = maxArgs = 1;
+            break;
+        case Op::In:
+        case Op::Case:
+            maxArgs = SIZE_MAX;
+            break;
+        default:
+            break;
+    }
+    if (args.size() < minArgs || args.size() > maxArgs) {
+        return {nullptr, mysql::NewErr(mysql::ErrWrongParamcountToNativeFct, opName(op))};
+    }
+
+    switch (op) {
+        case Op::Plus:
+        case Op::Minus:
+        case Op::Mul:
+        case Op::Div:
+        case Op::IntDiv:
+        case Op::Mod:
+            return newArithmetic(op, std::move(args), mode);
+        case Op::EQ:
+        case Op::NE:
+        case Op::LT:
+        case Op::LE:
+        case Op::GT:
+        case Op::GE:
+        case Op::NullEQ:
+            return newCompare(op, std::move(args));
+        case Op::In:
+            return newIn(std::move(args));
+        case Op::Case:
+            return newCase(std::move(args));
+        default:
+            return newLogic(op, std::move(args));
+    }
+}
+
+std::optional<mysql::SQLError> VectorizedFilter(EvalContext &ctx, std::span<const ExprPtr> conds, Chunk &chk) {
+    auto rows = Rows::Of(chk);
+    std::vector<uint32_t> sel, kept;
+    for (const auto &cond : conds) {
+        auto tp = cond->GetEvalType();
+        if (tp == EvalType::String) {
+            return mysql::NewErr(mysql::ErrNotSupportedYet, ("string condition " + cond->String()).c_str());
+        }
+        argument a(ctx);
+        if (auto err = a.Eval(*cond, tp, chk, rows)) {
+            return err;
+        }
+        kept.clear();
+        kept.reserve(rows.Size());
+        if (tp == EvalType::Int) {
+            rows.ForEach([&](size_t i) {
+                if (!a.IsNull(i) && a.Value<int64_t>(i) != 0) {
+                    kept.push_back(static_cast<uint32_t>(i));
+                }
+            });
+        } else {
+            rows.ForEach([&](size_t i) {
+                if (!a.IsNull(i) && a.Value<double>(i) != 0) {
+                    kept.push_back(static_cast<uint32_t>(i));
+                }
+            });
+        }
+        std::swap(sel, kept);
+        rows = Rows(chk.NumRowsUnfiltered(), sel);
+    }
+    if (!conds.empty()) {
+        chk.SetSel(std::move(sel));
+    }
+    return std::nullopt;
+}
+
+}  // namespace expression
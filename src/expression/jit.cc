@@ -0,0 +1,405 @@
+#include "expression/jit.hh"
+
+#include <xbyak/xbyak.h>
+
+#include <array>
+#include <bit>
+#include <exception>
+
+#include "expression/builtin.hh"
+
+namespace expression {
+
+using util::chunk::Chunk;
+
+struct JitFilter::predicate {
+    enum class domain : uint8_t { i64, u64, f64 };
+
+    size_t Column;
+    domain Domain;
+    // Cmp is EQ, NE, LT, LE, GT, GE, IsNull or IsNotNull.
+    Op Cmp;
+    int64_t Param;
+};
+
+struct KernelCache::kernel {
+    std::unique_ptr<Xbyak::CodeGenerator> Code;
+    FilterKernel Fn;
+};
+
+namespace {
+
+using predicate = JitFilter::predicate;
+
+// filterGenerator generates the kernel of predicates, with a loop over the rows of a selection if hasSel, checking the
+// validity bitmap of the columns of the predicates in nullable. Every row is written to the output, and counted if it
+// passes, so that the loop does not branch on the values.
+class filterGenerator : public Xbyak::CodeGenerator {
+public:
+    filterGenerator(std::span<const predicate> predicates, bool hasSel, uint32_t nullable) : CodeGenerator(4096) {
+        // The arguments are in rdi (columns), rsi (params), rdx (sel), rcx (n) and r8 (out). rax counts the rows
+        // passing, r9 is the index of the row in sel or the columns, r10 the row and r11b whether it passes; rbx,
+        // r12 and r13 are scratch, saved by the callee.
+        Xbyak::Label loop, done;
+        push(rbx);
+        push(r12);
+        push(r13);
+        xor_(eax, eax);
+        xor_(r9d, r9d);
+        test(rcx, rcx);
+        jz(done, T_NEAR);
+
+        L(loop);
+        if (hasSel) {
+            mov(r10d, dword[rdx + r9 * 4]);
+        } else {
+            mov(r10, r9);
+        }
+        mov(dword[r8 + rax * 4], r10d);
+        mov(r11d, 1);
+        for (size_t k = 0; k < predicates.size(); k++) {
+            emit(predicates[k], static_cast<int>(k), (nullable >> k & 1) != 0);
+        }
+        add(rax, r11);
+        inc(r9);
+        cmp(r9, rcx);
+        jb(loop, T_NEAR);
+
+        L(done);
+        pop(r13);
+        pop(r12);
+        pop(rbx);
+        ret();
+    }
+
+private:
+    void emit(const predicate &p, int k, bool nullable) {
+        if (p.Cmp == Op::IsNull || p.Cmp == Op::IsNotNull) {
+            if (!nullable) {
+                // IS NOT NULL of a column with no null is true, IS NULL false.
+                if (p.Cmp == Op::IsNull) {
+                    xor_(r11d, r11d);
+                }
+                return;
+            }
+            loadValid(k);
+            if (p.Cmp == Op::IsNull) {
+                xor_(r12b, 1);
+            }
+            and_(r11b, r12b);
+            return;
+        }
+
+        mov(rbx, qword[rdi + 16 * k]);
+        if (p.Domain == predicate::domain::f64) {
+            movsd(xmm0, qword[rbx + r10 * 8]);
+            ucomisd(xmm0, qword[rsi + 8 * k]);
+        } else {
+            mov(r12, qword[rbx + r10 * 8]);
+            cmp(r12, qword[rsi + 8 * k]);
+        }
+        setCmp(p);
+        if (p.Domain == predicate::domain::f64) {
+            setOrdered(p);
+        }
+        and_(r11b, r12b);
+        if (nullable) {
+            loadValid(k);
+            and_(r11b, r12b);
+        }
+    }
+
+    // setCmp sets r12b to the comparison of the flags, those of a signed comparison for i64 and of an unsigned one for
+    // u64 and f64, whose ucomisd sets CF and ZF like an unsigned comparison of ordered operands.
+    void setCmp(const predicate &p) {
+        bool isSigned = p.Domain == predicate::domain::i64;
+        switch (p.Cmp) {
+            case Op::EQ:
+                sete(r12b);
+                break;
+            case Op::NE:
+                setne(r12b);
+                break;
+            case Op::LT:
+                isSigned ? setl(r12b) : setb(r12b);
+                break;
+            case Op::LE:
+                isSigned ? setle(r12b) : setbe(r12b);
+                break;
+            case Op::GT:
+                isSigned ? setg(r12b) : seta(r12b);
+                break;
+            default:
+                isSigned ? setge(r12b) : setae(r12b);
+                break;
+        }
+    }
+
+    // setOrdered corrects r12b for a NaN, for which ucomisd sets ZF, PF and CF: a NaN compares unequal to every value,
+    // != being true and the other comparisons false. seta and setae already are false with CF set.
+    void setOrdered(const predicate &p) {
+        switch (p.Cmp) {
+            case Op::EQ:
+            case Op::LT:
+            case Op::LE:
+                setnp(r13b);
+                and_(r12b, r13b);
+                break;
+            case Op::NE:
+                setp(r13b);
+                or_(r12b, r13b);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // loadValid sets r12b to the bit of the row in the validity bitmap of the column of predicate k.
+    void loadValid(int k) {
+        mov(rbx, qword[rdi + 16 * k + 8]);
+        mov(r12, r10);
+        shr(r12, 3);
+        movzx(r12d, byte[rbx + r12]);
+        mov(r13d, r10d);
+        and_(r13d, 7);
+        bt(r12d, r13d);
+        setc(r12b);
+    }
+};
+
+Op mirror(Op op) {
+    switch (op) {
+        case Op::LT:
+            return Op::GT;
+        case Op::LE:
+            return Op::GE;
+        case Op::GT:
+            return Op::LT;
+        case Op::GE:
+            return Op::LE;
+        default:
+            return op;
+    }
+}
+
+// conjuncts appends the conditions of the conjunction e to out.
+void conjuncts(const Expression &e, std::vector<const Expression *> &out) {
+    const auto *f = dynamic_cast<const scalarFunction *>(&e);
+    if (f != nullptr && f->GetOp() == Op::LogicAnd) {
+        for (const auto &arg : f->Args()) {
+            conjuncts(*arg, out);
+        }
+    } else {
+        out.push_back(&e);
+    }
+}
+
+// predicateOf returns the predicate of e, if it is a comparison of a BIGINT or DOUBLE column with a constant of a
+// value the column compares with as its type, or IS [NOT] NULL of a column.
+std::optional<predicate> predicateOf(const Expression &e) {
+    const auto *f = dynamic_cast<const scalarFunction *>(&e);
+    if (f == nullptr) {
+        return std::nullopt;
+    }
+    auto op = f->GetOp();
+    const auto &args = f->Args();
+    if (op == Op::IsNull || op == Op::IsNotNull) {
+        const auto *col = dynamic_cast<const ColumnRef *>(args[0].get());
+        if (col == nullptr) {
+            return std::nullopt;
+        }
+        return predicate{col->Index(), predicate::domain::i64, op, 0};
+    }
+    if (op != Op::EQ && op != Op::NE && op != Op::LT && op != Op::LE && op != Op::GT && op != Op::GE) {
+        return std::nullopt;
+    }
+    const auto *col = dynamic_cast<const ColumnRef *>(args[0].get());
+    const auto *c = dynamic_cast<const Constant *>(args[1].get());
+    if (col == nullptr) {
+        col = dynamic_cast<const ColumnRef *>(args[1].get());
+        c = dynamic_cast<const Constant *>(args[0].get());
+        op = mirror(op);
+    }
+    if (col == nullptr || c == nullptr || c->IsNull()) {
+        return std::nullopt;
+    }
+
+    // The kernels load 8 bytes per row, e.g. not from the var-length column of a NULL, whose eval type is Int.
+    const auto &tp = col->Type();
+    if (util::chunk::Column::ElemSize(tp.Tp) != sizeof(int64_t)) {
+        return std::nullopt;
+    }
+    const auto *i = std::get_if<int64_t>(&c->GetValue());
+    switch (tp.GetEvalType()) {
+        case EvalType::Int:
+            // A negative value compares with an unsigned column as such, and so does one above INT64_MAX with a
+            // signed column: neither is a parameter of the column's type.
+            if (i == nullptr || (c->Type().IsUnsigned() != tp.IsUnsigned() && *i < 0)) {
+                return std::nullopt;
+            }
+            return predicate{col->Index(), tp.IsUnsigned() ? predicate::domain::u64 : predicate::domain::i64, op, *i};
+        case EvalType::Real: {
+            if (tp.Tp != mysql::TypeDouble) {
+                return std::nullopt;
+            }
+            double d;
+            if (i != nullptr) {
+                d = c->Type().IsUnsigned() ? static_cast<double>(static_cast<uint64_t>(*i)) : static_cast<double>(*i);
+            } else if (const auto *r = std::get_if<double>(&c->GetValue())) {
+                d = *r;
+            } else {
+                return std::nullopt;
+            }
+            return predicate{col->Index(), predicate::domain::f64, op, std::bit_cast<int64_t>(d)};
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
+const char *cmpName(Op op) {
+    switch (op) {
+        case Op::EQ:
+            return "=";
+        case Op::NE:
+            return "!=";
+        case Op::LT:
+            return "<";
+        case Op::LE:
+            return "<=";
+        case Op::GT:
+            return ">";
+        case Op::GE:
+            return ">=";
+        case Op::IsNull:
+            return "null";
+        default:
+            return "!null";
+    }
+}
+
+}  // namespace
+
+KernelCache::KernelCache() = default;
+
+KernelCache::~KernelCache() = default;
+
+KernelCache &KernelCache::Global() {
+    static KernelCache cache;
+    return cache;
+}
+
+size_t KernelCache::Size() const {
+    std::lock_guard lock(_mu);
+    return _kernels.size();
+}
+
+template <typename F>
+FilterKernel KernelCache::get(const std::string &fingerprint, F &&compile) {
+    std::lock_guard lock(_mu);
+    auto it = _kernels.find(fingerprint);
+    if (it == _kernels.end()) {
+        it = _kernels.emplace(fingerprint, compile()).first;
+    }
+    return it->second != nullptr ? it->second->Fn : nullptr;
+}
+
+JitFilter::JitFilter(std::vector<predicate> predicates, KernelCache &cache)
+    : _predicates(std::move(predicates)),
+      _cache(cache),
+      _variants(size_t{2} << _predicates.size()),
+      _failed(_variants.size()) {
+    for (const auto &p : _predicates) {
+        if (!_fingerprint.empty()) {
+            _fingerprint += ",";
+        }
+        if (p.Cmp != Op::IsNull && p.Cmp != Op::IsNotNull) {
+            _fingerprint += p.Domain == predicate::domain::i64   ? "i"
+                            : p.Domain == predicate::domain::u64 ? "u"
+                                                                 : "d";
+        }
+        _fingerprint += cmpName(p.Cmp);
+        _params.push_back(p.Param);
+    }
+}
+
+JitFilter::~JitFilter() = default;
+
+std::unique_ptr<JitFilter> JitFilter::Compile(std::span<const ExprPtr> conds, KernelCache &cache) {
+    std::vector<const Expression *> all;
+    for (const auto &cond : conds) {
+        conjuncts(*cond, all);
+    }
+    if (all.empty() || all.size() > maxPredicates) {
+        return nullptr;
+    }
+    std::vector<predicate> predicates;
+    for (const auto *e : all) {
+        auto p = predicateOf(*e);
+        if (!p) {
+            return nullptr;
+        }
+        predicates.push_back(*p);
+    }
+    return std::unique_ptr<JitFilter>(new JitFilter(std::move(predicates), cache));
+}
+
+FilterKernel JitFilter::kernelOf(uint32_t variant) {
+    if (_variants[variant] != nullptr || _failed[variant]) {
+        return _variants[variant];
+    }
+    auto fingerprint = _fingerprint + (variant & 1 ? "|sel|" : "||") + std::to_string(variant >> 1);
+    _variants[variant] = _cache.get(fingerprint, [&]() -> std::unique_ptr<KernelCache::kernel> {
+        try {
+            auto k = std::make_unique<KernelCache::kernel>();
+            auto code = std::make_unique<filterGenerator>(_predicates, (variant & 1) != 0, variant >> 1);
+            k->Fn = code->getCode<FilterKernel>();
+            k->Code = std::move(code);
+            return k;
+        } catch (const std::exception &) {
+            // The filter is evaluated by the interpreter.
+            return nullptr;
+        }
+    });
+    _failed[variant] = _variants[variant] == nullptr;
+    return _variants[variant];
+}
+
+bool JitFilter::Apply(Chunk &chk) {
+    auto n = chk.NumRowsUnfiltered();
+    std::array<const uint8_t *, 2 * maxPredicates> columns{};
+    uint32_t variant = chk.HasSel() ? 1 : 0;
+    for (size_t k = 0; k < _predicates.size(); k++) {
+        const auto &col = chk.Col(_predicates[k].Column);
+        columns[2 * k] = col.Data();
+        columns[2 * k + 1] = col.NullBitmap();
+        if (col.NullCount() > 0) {
+            variant |= 2u << k;
+        }
+    }
+    auto kernel = kernelOf(variant);
+    if (kernel == nullptr) {
+        return false;
+    }
+    if (chk.HasSel()) {
+        auto &sel = chk.MutableSel();
+        sel.resize(kernel(columns.data(), _params.data(), sel.data(), sel.size(), sel.data()));
+    } else {
+        auto &sel = chk.MutableSel();
+        sel.resize(n);
+        sel.resize(kernel(columns.data(), _params.data(), nullptr, n, sel.data()));
+    }
+    return true;
+}
+
+Filter::Filter(std::vector<ExprPtr> conds, KernelCache &cache)
+    : _conds(std::move(conds)), _jit(JitFilter::Compile(_conds, cache)) {}
+
+std::optional<mysql::SQLError> Filter::Apply(EvalContext &ctx, Chunk &chk) {
+    if (_jit != nullptr && _jit->Apply(chk)) {
+        return std::nullopt;
+    }
+    return VectorizedFilter(ctx, _conds, chk);
+}
+
+}  // namespace expression
@@ -0,0 +1,40 @@
+#pragma once
+
+// SPDLOG_ACTIVE_LEVEL is the lowest level compiled in, see PXTIDB_LOG_LEVEL in CMakeLists.txt.
+#ifndef SPDLOG_ACTIVE_LEVEL
+#define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_INFO
+#endif
+
+#include <spdlog/spdlog.h>
+
+#include <memory>
+#include <string>
+
+namespace common {
+
+// Logger returns the logger of the server. It is asynchronous: a call formats the message and queues it, a
+// background thread writes it, and the oldest messages are dropped when the queue is full, so logging never blocks
+// the caller on the disk or the terminal.
+const std::shared_ptr<spdlog::logger> &Logger();
+
+// InitLogger sends the logs to file, or to stderr if file is empty, and sets the lowest level logged at runtime.
+// It must be called before any log is written.
+void InitLogger(const std::string &file, spdlog::level::level_enum level = spdlog::level::info);
+
+}  // namespace common
+
+// The log macros compile to nothing below SPDLOG_ACTIVE_LEVEL or without PXTIDB_USE_LOGGING: their arguments are not
+// even evaluated. Above, a message below the runtime level costs a branch.
+#ifdef PXTIDB_USE_LOGGING
+#define LOG_TRACE(...) SPDLOG_LOGGER_TRACE(::common::Logger(), __VA_ARGS__)
+#define LOG_DEBUG(...) SPDLOG_LOGGER_DEBUG(::common::Logger(), __VA_ARGS__)
+#define LOG_INFO(...) SPDLOG_LOGGER_INFO(::common::Logger(), __VA_ARGS__)
+#define LOG_WARN(...) SPDLOG_LOGGER_WARN(::common::Logger(), __VA_ARGS__)
+#define LOG_ERROR(...) SPDLOG_LOGGER_ERROR(::common::Logger(), __VA_ARGS__)
+#else
+#define LOG_TRACE(...) (void)0
+#define LOG_DEBUG(...) (void)0
+#define LOG_INFO(...) (void)0
+#define LOG_WARN(...) (void)0
+#define LOG_ERROR(...) (void)0
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace common {
+
+// MPSCRing is a bounded lock-free queue with many producers and a single consumer, after Dmitry Vyukov's bounded
+// MPMC queue: every slot carries a sequence number telling whether it is free for the producer of a given position
+// or ready for the consumer. Producers only contend on the tail with a CAS; a full ring makes TryPush fail instead of
+// waiting, so a producer never blocks.
+// Capacity must be a power of two. T is copied in and out of the slots, it should be a small trivially copyable type.
+template <typename T, size_t Capacity>
+class MPSCRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    MPSCRing() : _slots(std::make_unique<slot[]>(Capacity)) {
+        for (size_t i = 0; i < Capacity; i++) {
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPSCRing(const MPSCRing &) = delete;
+    MPSCRing &operator=(const MPSCRing &) = delete;
+
+    // TryPush appends value, returning false if the ring is full. It may be called from any thread.
+    bool TryPush(const T &value) {
+        auto pos = _tail.load(std::memory_order_relaxed);
+        while (true) {
+            auto &s = _slots[pos & (Capacity - 1)];
+            auto seq = s.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    s.value = value;
+                    s.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // The slot still holds the value pushed a lap ago.
+                return false;
+            } else {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // TryPop removes the oldest value into value, returning false if the ring is empty. Only the consumer thread may
+    // call it.
+    bool TryPop(T &value) {
+        auto &s = _slots[_head & (Capacity - 1)];
+        if (s.sequence.load(std::memory_order_acquire) != _head + 1) {
+            return false;
+        }
+        value = s.value;
+        s.sequence.store(_head + Capacity, std::memory_order_release);
+        _head++;
+        return true;
+    }
+
+private:
+    struct alignas(64) slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<slot[]> _slots;
+    alignas(64) std::atomic<size_t> _tail{0};
+    alignas(64) size_t _head{0};
+};
+
+}  // namespace common
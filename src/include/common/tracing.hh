@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace common::tracing {
+
+// ReadTSC returns the time stamp counter, or the steady clock in nanoseconds where there is none. Either way it only
+// measures intervals: TickConverter converts it.
+inline uint64_t ReadTSC() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+// TickConverter converts time stamp counter values to nanoseconds since the start of the process. The rate of the
+// counter is measured against the steady clock between the start of the process and the creation of the converter:
+// there is no calibration delay, and the rate gets more precise as the process runs.
+class TickConverter {
+public:
+    TickConverter();
+
+    uint64_t ToNanos(uint64_t ticks) const;
+
+private:
+    uint64_t _origin;
+    double _nanosPerTick;
+};
+
+// Event is a span recorded by a trace. Name must be a string literal.
+struct Event {
+    const char *Name;
+    uint64_t Begin;
+    uint64_t End;
+};
+
+// Trace is the spans of one traced command, in the order they began.
+struct Trace {
+    uint32_t ConnID{0};
+    // Label describes the command, e.g. the statement text.
+    std::string Label;
+    std::vector<Event> Events;
+    // Truncated is set if spans were dropped because the buffer of the thread was full.
+    bool Truncated{false};
+};
+
+// recorder is the preallocated span buffer of a thread.
+class recorder {
+public:
+    static constexpr uint32_t capacity = 4096;
+    static constexpr uint32_t dropped = ~0u;
+
+    uint32_t begin(const char *name) {
+        if (_n == capacity) {
+            _truncated = true;
+            return dropped;
+        }
+        _events[_n] = {name, ReadTSC(), 0};
+        return _n++;
+    }
+
+    void end(uint32_t index) {
+        if (index != dropped) {
+            _events[index].End = ReadTSC();
+        }
+    }
+
+private:
+    friend class TraceScope;
+
+    Event _events[capacity];
+    uint32_t _n{0};
+    bool _truncated{false};
+};
+
+// activeRecorder is the recorder of the calling thread while it runs a traced command, null otherwise.
+constinit inline thread_local recorder *activeRecorder = nullptr;
+
+// Span records the time between its construction and its destruction in the trace of the command the thread runs.
+// When the command is not traced, constructing and destroying a span each cost one well predicted branch.
+// A span may outlive a suspension of the session's coroutine, which may resume on another thread, provided that the
+// suspension moves activeRecorder along, as the socket waits of PacketIO do.
+class Span {
+public:
+    explicit Span(const char *name) {
+        if (activeRecorder != nullptr) [[unlikely]] {
+            _recorder = activeRecorder;
+            _index = _recorder->begin(name);
+        }
+    }
+
+    ~Span() {
+        if (_recorder != nullptr) [[unlikely]] {
+            _recorder->end(_index);
+        }
+    }
+
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+private:
+    recorder *_recorder{nullptr};
+    uint32_t _index{0};
+};
+
+// TraceScope records the spans of the calling thread from its construction, if enabled is set, until Finish.
+// The buffer of a thread is allocated by its first trace and reused by the next ones; a trace owns it until it
+// finishes.
+class TraceScope {
+public:
+    explicit TraceScope(bool enabled);
+    ~TraceScope();
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+    bool Enabled() const { return _recorder != nullptr; }
+
+    // Finish stops recording and returns the spans recorded. Spans still open end now.
+    Trace Finish(uint32_t connID, std::string label);
+
+private:
+    // release stops recording and gives the buffer back to the calling thread.
+    void release();
+
+    std::unique_ptr<recorder> _recorder;
+};
+
+// sampleCounter counts the calls to Sample on the thread.
+constinit inline thread_local uint32_t sampleCounter = 0;
+
+// Sample returns true once every rate calls on the calling thread, never if rate is 0.
+inline bool Sample(uint32_t rate) { return rate != 0 && ++sampleCounter % rate == 0; }
+
+// TraceLog keeps the last traces.
+class TraceLog {
+public:
+    static constexpr size_t defaultCapacity = 64;
+
+    explicit TraceLog(size_t capacity = defaultCapacity) : _capacity(capacity) {}
+
+    void Add(Trace trace);
+
+    size_t Size() const;
+
+    // WriteChromeJSON appends the traces to out in the Chrome trace event format, which chrome://tracing and
+    // Perfetto load. Every connection is a thread of the trace.
+    void WriteChromeJSON(std::string &out) const;
+
+private:
+    size_t _capacity;
+    mutable std::mutex _mu;
+    std::deque<Trace> _traces;
+};
+
+}  // namespace common::tracing
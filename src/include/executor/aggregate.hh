@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "expression/expression.hh"
+#include "parser/mysql/error.hh"
+#include "util/chunk/chunk.hh"
+
+namespace executor {
+
+// defaultPartialGroups bounds the groups a thread pre-aggregates before handing them to the merge, so that its hash
+// table stays in its caches whatever the number of groups.
+constexpr size_t defaultPartialGroups = 1 << 14;
+
+// AggFunc is an aggregate function.
+enum class AggFunc : uint8_t { Count, Sum, Avg, Min, Max, ApproxCountDistinct, ApproxPercentile };
+
+// AggFuncDesc is an aggregate function of an argument, or COUNT(*) if Arg is null. SUM of integers is a BIGINT, or a
+// BIGINT UNSIGNED if the argument is unsigned, and reports an overflow; AVG is a DOUBLE.
+//
+// APPROX_COUNT_DISTINCT is a BIGINT estimated by a HyperLogLog of the hashes of the values, exact up to a few hundred
+// values. APPROX_PERCENTILE is the value of the argument at the Percent-th percentile of its values, estimated by a KLL
+// sketch. Their states merge like those of the other functions, so that they run in parallel.
+struct AggFuncDesc {
+    AggFunc Func;
+    expression::ExprPtr Arg;
+    // Percent is the percentage of APPROX_PERCENTILE, in [1, 100].
+    int64_t Percent{0};
+};
+
+// AggStrategy is how the rows are grouped: Hash by hash tables, Stream from the runs of equal keys of an input sorted
+// by them, Auto by streaming if the first chunk of the input is sorted.
+enum class AggStrategy : uint8_t { Auto, Hash, Stream };
+
+// AggStrategyOfHints returns the strategy asked for by the optimizer hint comment lit: Hash for HASH_AGG(), Stream for
+// STREAM_AGG(), Auto for neither or both.
+AggStrategy AggStrategyOfHints(const std::string &lit);
+
+struct AggOptions {
+    AggStrategy Strategy{AggStrategy::Auto};
+    // Concurrency is the number of threads of the hash aggregation, 0 for one per core.
+    size_t Concurrency{0};
+    size_t PartialGroups{defaultPartialGroups};
+    // Mode and InDML are those of the statement, which every thread evaluates the expressions with.
+    mysql::SQLMode Mode{mysql::ModeNone};
+    bool InDML{false};
+};
+
+// AggExec groups its input by the values of the group-by expressions, and returns a row per group: the group-by values
+// then the aggregates. Without group-by expressions it returns a single row, even for no input.
+//
+// The hash aggregation runs in two phases. Each thread aggregates the chunks it takes into a small hash table, and
+// when the table is full or the input done, moves the groups to its partitions by the high bits of the hash of their
+// key. Then each partition merges the groups of all the threads on its own, so that no table is shared nor locked.
+// The stream aggregation reads the chunks in order and closes a group when its key changes. If it meets a key lower
+// than the previous one, the input was not sorted: it hands the groups it made to the merge and goes on hashing.
+// The keys are memcomparable, so that the strings group by their bytes.
+class AggExec {
+public:
+    ~AggExec();
+
+    AggExec(const AggExec &) = delete;
+    AggExec &operator=(const AggExec &) = delete;
+
+    // New returns the aggregation of aggs grouped by groupBy. SUM, AVG, MIN, MAX and APPROX_PERCENTILE of strings are
+    // not supported.
+    static std::tuple<std::unique_ptr<AggExec>, std::optional<mysql::SQLError>> New(
+        std::vector<expression::ExprPtr> groupBy, std::vector<AggFuncDesc> aggs, AggOptions opts = {});
+
+    // FieldTypes returns the types of the columns of the result.
+    const std::vector<expression::FieldType> &FieldTypes() const { return _fieldTypes; }
+
+    // Execute aggregates the rows of input, and returns the groups in chunks of up to defaultCapacity rows: by
+    // ascending key if it streamed the whole input, in no particular order otherwise.
+    std::tuple<std::vector<util::chunk::Chunk>, std::optional<mysql::SQLError>> Execute(
+        std::span<const util::chunk::Chunk> input);
+
+    // Executed returns how the last Execute grouped the rows: Stream if it streamed all of them, else Hash.
+    AggStrategy Executed() const { return _executed; }
+
+    // Warnings returns the warnings of the last Execute.
+    const std::vector<mysql::SQLError> &Warnings() const { return _warnings; }
+
+private:
+    struct aggState;
+    struct aggregator;
+    struct groups;
+    class partial;
+
+    AggExec(std::vector<expression::ExprPtr> groupBy, std::vector<aggregator> aggs, AggOptions opts);
+
+    // update adds the rows of chk to the states of their groups, the i-th row to group rowGroups[i] whose states are
+    // from states[rowGroups[i] * _aggs.size()].
+    std::optional<mysql::SQLError> update(expression::EvalContext &ctx, const util::chunk::Chunk &chk,
+                                          const uint32_t *rowGroups, aggState *states) const;
+    // stream aggregates the chunks of input from the first while they are sorted by key, into streamed, and returns
+    // the number of chunks it took.
+    std::tuple<size_t, std::optional<mysql::SQLError>> stream(std::span<const util::chunk::Chunk> input,
+                                                              groups &streamed);
+    // merge merges the groups of parts, the groups of a partition of every thread, and appends them to out.
+    std::optional<mysql::SQLError> merge(std::span<groups *const> parts, std::vector<util::chunk::Chunk> &out) const;
+    // appendGroup appends the row of the group of key and states to the last chunk of out, or to a new one if it is
+    // full.
+    void appendGroup(std::vector<util::chunk::Chunk> &out, std::string_view key, const aggState *states) const;
+    void appendWarnings(const std::vector<mysql::SQLError> &warnings);
+
+    std::vector<expression::ExprPtr> _groupBy;
+    std::vector<aggregator> _aggs;
+    AggOptions _opts;
+    std::vector<expression::FieldType> _fieldTypes;
+    std::vector<uint8_t> _columnTypes;
+    AggStrategy _executed{AggStrategy::Hash};
+    std::vector<mysql::SQLError> _warnings;
+};
+
+}  // namespace executor
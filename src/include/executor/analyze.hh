@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "expression/expression.hh"
+#include "parser/mysql/error.hh"
+#include "util/chunk/chunk.hh"
+#include "util/sketch/count_min.hh"
+
+namespace executor {
+
+// defaultAnalyzeSampleRows is the number of rows ANALYZE samples from a table.
+constexpr size_t defaultAnalyzeSampleRows = 100000;
+// defaultAnalyzeTopN is the number of most frequent values kept for a column, like WITH 20 TOPN.
+constexpr size_t defaultAnalyzeTopN = 20;
+
+struct AnalyzeOptions {
+    // SampleRows is the expected number of rows sampled: every row is if it is 0 or the table has no more rows.
+    size_t SampleRows{defaultAnalyzeSampleRows};
+    size_t TopN{defaultAnalyzeTopN};
+    // CMSketchWidth is the number of counters of a row of the sketches, like WITH 2048 CMSKETCH WIDTH. Their depth is
+    // the 3 rows of madoka.
+    uint64_t CMSketchWidth{util::sketch::CountMinSketch::defaultWidth};
+    // Concurrency is the number of threads sampling the regions, 0 for one per core.
+    size_t Concurrency{0};
+    // Seed seeds the sampling, so that the statistics of the same table are the same.
+    uint64_t Seed{0};
+    // Mode is the SQL mode of the statement, which every thread evaluates the columns with.
+    mysql::SQLMode Mode{mysql::ModeNone};
+};
+
+// TopNEntry is a value of a column, by its memcomparable key, and its number of rows in the sample.
+struct TopNEntry {
+    std::string Key;
+    uint64_t Count;
+};
+
+// ColumnStats are the statistics of a column from a sample of its table: the most frequent values of the sample with
+// their counts, and the counts of the others in a count-min sketch. Keeping the frequent values apart keeps them from
+// inflating the estimates of the values that share their counters, and bounds the counters by the count of the most
+// frequent of the others, so that they take few bits.
+struct ColumnStats {
+    // RowCount is the number of rows of the table.
+    uint64_t RowCount{0};
+    // SampleCount is the number of rows sampled, and NullCount the number of them which are NULL.
+    uint64_t SampleCount{0};
+    uint64_t NullCount{0};
+    // TopN are ordered by key.
+    std::vector<TopNEntry> TopN;
+    std::unique_ptr<util::sketch::CountMinSketch> Sketch;
+
+    // EqualRowCount returns the estimated number of rows equal to the value of key, as encoded by EncodeKeys. A value
+    // missing from a partial sample is counted as if sampled once.
+    double EqualRowCount(std::string_view key) const;
+
+    // EqualSelectivity returns the estimated fraction of the rows equal to the value of key.
+    double EqualSelectivity(std::string_view key) const;
+
+    // Save writes the statistics to the file at path, and their sketch to path + ".cms".
+    std::optional<mysql::SQLError> Save(const std::string &path) const;
+
+    // Load reads the statistics saved at path, their sketch being mapped read-only.
+    static std::tuple<ColumnStats, std::optional<mysql::SQLError>> Load(const std::string &path);
+};
+
+// AnalyzeExec builds the statistics of columns for ANALYZE TABLE, after TiDB's v1 statistics.
+//
+// The regions of the table are sampled in parallel, each row with the same probability, by their own random numbers
+// seeded by the seed and the index of the region, and the values sampled are counted by key in each region, in
+// partitions by the high bits of the hash of the key. Then the counts of the regions are merged by partition, in
+// parallel, and each column keeps its TopN most frequent values seen more than once and adds the others to its sketch.
+class AnalyzeExec {
+public:
+    ~AnalyzeExec();
+
+    AnalyzeExec(const AnalyzeExec &) = delete;
+    AnalyzeExec &operator=(const AnalyzeExec &) = delete;
+
+    // New returns the analysis of the columns of the chunks of the columns of types.
+    static std::tuple<std::unique_ptr<AnalyzeExec>, std::optional<mysql::SQLError>> New(
+        std::vector<expression::ExprPtr> columns, std::vector<uint8_t> types, AnalyzeOptions opts = {});
+
+    // Execute returns the statistics of every column, the chunks of each region of the table being an element of
+    // regions.
+    std::tuple<std::vector<ColumnStats>, std::optional<mysql::SQLError>> Execute(
+        std::span<const std::vector<util::chunk::Chunk>> regions);
+
+private:
+    struct sample;
+    struct partition;
+
+    AnalyzeExec(std::vector<expression::ExprPtr> columns, std::vector<uint8_t> types, AnalyzeOptions opts);
+
+    // sampleRegion samples each row of the chunks of the region idx with a probability of rate into s.
+    std::optional<mysql::SQLError> sampleRegion(std::span<const util::chunk::Chunk> region, size_t idx, double rate,
+                                                sample &s) const;
+    // mergePartition merges the counts of the partition p of column col of the samples of the regions.
+    partition mergePartition(std::span<sample> samples, size_t col, size_t p) const;
+    // build builds the statistics of column col from the samples of the regions and the merged partitions of the
+    // column.
+    ColumnStats build(std::span<const sample> samples, std::span<partition> parts, size_t col,
+                      uint64_t rowCount) const;
+
+    std::vector<expression::ExprPtr> _columns;
+    std::vector<uint8_t> _types;
+    AnalyzeOptions _opts;
+};
+
+}  // namespace executor
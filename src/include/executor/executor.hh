@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "expression/expression.hh"
+#include "parser/mysql/error.hh"
+#include "util/chunk/chunk.hh"
+
+// Package executor runs the operators of the plans over chunks, after TiDB's executor package. The operators take
+// their whole input as chunks and return their result in chunks of up to defaultCapacity rows.
+namespace executor {
+
+// EncodeKeys sets keys[i] to the memcomparable key of the values of exprs for the i-th row of chk, and hasNull[i],
+// if hasNull is not null, to whether one of them is NULL. The keys compare like the values, the strings by their
+// bytes. An unsigned value that fits a BIGINT is encoded as one, so that the equal values of both signedness have
+// equal keys.
+std::optional<mysql::SQLError> EncodeKeys(expression::EvalContext &ctx, std::span<const expression::ExprPtr> exprs,
+                                          const util::chunk::Chunk &chk, std::vector<std::string> &keys,
+                                          std::vector<uint8_t> *hasNull = nullptr);
+
+// AppendPacked moves the rows of chunks to the chunks of out, the full chunks as they are and the others packed into
+// full ones of the columns of types, so that the result of the partitions of an operator is not many small chunks.
+void AppendPacked(std::vector<util::chunk::Chunk> &out, std::vector<util::chunk::Chunk> chunks,
+                  std::span<const uint8_t> types);
+
+}  // namespace executor
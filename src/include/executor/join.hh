@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "expression/expression.hh"
+#include "parser/mysql/error.hh"
+#include "util/chunk/chunk.hh"
+
+namespace executor {
+
+// JoinType is the kind of a join of a left (outer) and a right (inner) input. Semi and AntiSemi return the left rows
+// with and without a match, e.g. of EXISTS and NOT EXISTS: a row with a NULL key matches no row.
+//
+// NullAwareAntiSemi is the anti semi join of NOT IN, on a single key, whose comparisons with NULL are unknown rather
+// than false: it returns the left rows whose key is unequal to every right key, that is none if a right key is NULL,
+// and a left row with a NULL key only if the right input is empty.
+enum class JoinType : uint8_t { Inner, LeftOuter, RightOuter, Semi, AntiSemi, NullAwareAntiSemi };
+
+// BuildSide is the input a hash join builds its hash tables on, the other one being probed: Auto for the smaller.
+enum class BuildSide : uint8_t { Auto, Left, Right };
+
+// JoinHints are the join hints of an optimizer hint comment. The tables they name are left to the planner to match
+// with the inputs of the joins.
+struct JoinHints {
+    // HashJoin is HASH_JOIN(): join with HashJoinExec.
+    bool HashJoin{false};
+    // Build is Left for SWAP_JOIN_INPUTS(), Right for NO_SWAP_JOIN_INPUTS(), Auto for neither or both.
+    BuildSide Build{BuildSide::Auto};
+    // SemiJoin is SEMIJOIN(): see JoinOptions::SwapSemiJoin.
+    bool SemiJoin{false};
+};
+
+// JoinHintsOf returns the join hints of the optimizer hint comment lit.
+JoinHints JoinHintsOf(const std::string &lit);
+
+struct JoinOptions {
+    BuildSide Build{BuildSide::Auto};
+    // SwapSemiJoin lets Auto build the semi joins on their left input, marking the rows that match, when it is the
+    // smaller; otherwise they are built on the right one, whose rows are only looked up.
+    bool SwapSemiJoin{false};
+    // Concurrency is the number of threads, 0 for one per core.
+    size_t Concurrency{0};
+    // Mode and InDML are those of the statement, which every thread evaluates the join keys with.
+    mysql::SQLMode Mode{mysql::ModeNone};
+    bool InDML{false};
+
+    // Of returns the options of hints.
+    static JoinOptions Of(const JoinHints &hints) { return {hints.Build, hints.SemiJoin}; }
+};
+
+// HashJoinExec is the equi-join of two inputs by the values of their join keys, a radix-partitioned hash join.
+//
+// Both inputs are partitioned in parallel by the high bits of the hash of their keys, in as many partitions as make
+// those of the build side fit in the caches. Then the partitions are joined in parallel, each building a hash table of
+// its rows of the build side and probing it with its rows of the other, a batch at a time: the buckets of a batch are
+// prefetched before they are looked up. The keys are memcomparable, compared when their hashes are equal.
+//
+// The result has the columns of the left input then those of the right one, but for the semi joins that only have the
+// left ones; the columns of the missing side of an outer join are NULL.
+class HashJoinExec {
+public:
+    ~HashJoinExec();
+
+    HashJoinExec(const HashJoinExec &) = delete;
+    HashJoinExec &operator=(const HashJoinExec &) = delete;
+
+    // New returns the join of the inputs of the columns of leftTypes and rightTypes on leftKeys[i] = rightKeys[i],
+    // whose eval types must be the same. NullAwareAntiSemi takes a single key.
+    static std::tuple<std::unique_ptr<HashJoinExec>, std::optional<mysql::SQLError>> New(
+        JoinType tp, std::vector<expression::ExprPtr> leftKeys, std::vector<expression::ExprPtr> rightKeys,
+        std::vector<uint8_t> leftTypes, std::vector<uint8_t> rightTypes, JoinOptions opts = {});
+
+    // Execute joins the rows of left and right, and returns the result in no particular order.
+    std::tuple<std::vector<util::chunk::Chunk>, std::optional<mysql::SQLError>> Execute(
+        std::span<const util::chunk::Chunk> left, std::span<const util::chunk::Chunk> right);
+
+    // BuiltLeft returns whether the last Execute built on the left input.
+    bool BuiltLeft() const { return _builtLeft; }
+    // NumPartitions returns the number of partitions of the last Execute.
+    size_t NumPartitions() const { return _numPartitions; }
+
+private:
+    struct side;
+    class partitioner;
+
+    HashJoinExec(JoinType tp, std::vector<expression::ExprPtr> leftKeys, std::vector<expression::ExprPtr> rightKeys,
+                 std::vector<uint8_t> leftTypes, std::vector<uint8_t> rightTypes, JoinOptions opts);
+
+    // buildLeft returns whether to build on the left input of left and right rows.
+    bool buildLeft(size_t left, size_t right) const;
+    // join joins a partition of build and probe into out.
+    void join(const side &build, const side &probe, std::span<const util::chunk::Chunk> left,
+              std::span<const util::chunk::Chunk> right, std::vector<util::chunk::Chunk> &out) const;
+
+    JoinType _tp;
+    std::vector<expression::ExprPtr> _leftKeys;
+    std::vector<expression::ExprPtr> _rightKeys;
+    std::vector<uint8_t> _leftTypes;
+    std::vector<uint8_t> _rightTypes;
+    std::vector<uint8_t> _types;
+    JoinOptions _opts;
+    bool _builtLeft{false};
+    size_t _numPartitions{0};
+};
+
+}  // namespace executor
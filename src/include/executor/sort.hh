@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "expression/expression.hh"
+#include "parser/mysql/error.hh"
+#include "util/chunk/chunk.hh"
+
+namespace util::chunk {
+class ArrowReader;
+}  // namespace util::chunk
+
+namespace executor {
+
+// defaultSortMemQuota is the memory quota of a sort, like the default of tidb_mem_quota_query.
+constexpr size_t defaultSortMemQuota = size_t{1} << 30;
+
+// ByItem is an expression of an ORDER BY and its direction.
+struct ByItem {
+    expression::ExprPtr Expr;
+    bool Desc{false};
+};
+
+struct SortOptions {
+    // MemQuota bounds the bytes of the rows a sort holds, and of their keys, before it spills them to a run.
+    size_t MemQuota{defaultSortMemQuota};
+    // TempDir is the directory of the runs, the temporary directory of the system if empty.
+    std::string TempDir;
+    // Concurrency is the number of threads of the in-memory sorts, 0 for one per core.
+    size_t Concurrency{0};
+    // Mode and InDML are those of the statement, which the ORDER BY items are evaluated with.
+    mysql::SQLMode Mode{mysql::ModeNone};
+    bool InDML{false};
+};
+
+// SortExec sorts its input by the values of the ORDER BY items, the NULLs first in ascending order and last in
+// descending order, the strings by their bytes.
+//
+// The values of the items of a row are normalized into a memcomparable key, whose bytes are inverted for the
+// descending items, so that rows compare by a memcmp of their keys. The first 8 bytes of every key are kept as an
+// integer next to the row, and compare the rows on their own but for the ties. The sort holds the chunks it is given,
+// until they and their keys exceed the memory quota: then their rows are sorted by ips4o and written to a run, a
+// temporary file of Arrow record batches holding their keys in a last column, and the chunks are released. Once the
+// input is read, the runs and the rows left in memory are merged by a loser tree as the rows are read, each run reading
+// its next record batches ahead, so that the sort holds about the quota whatever the size of its input.
+class SortExec {
+public:
+    ~SortExec();
+
+    SortExec(const SortExec &) = delete;
+    SortExec &operator=(const SortExec &) = delete;
+
+    // New returns the sort of the input of the columns of types by byItems.
+    static std::tuple<std::unique_ptr<SortExec>, std::optional<mysql::SQLError>> New(std::vector<ByItem> byItems,
+                                                                                     std::vector<uint8_t> types,
+                                                                                     SortOptions opts = {});
+
+    // Add adds the rows of chk to the sort, which holds chk until it spills them. The sort takes no more chunks once its
+    // rows are read.
+    std::optional<mysql::SQLError> Add(util::chunk::Chunk chk);
+
+    // Next sets chk to the next up to defaultCapacity rows of the sorted input, once every chunk was added, and to an
+    // empty chunk after the last row. The order of the rows of equal keys is unspecified.
+    std::optional<mysql::SQLError> Next(util::chunk::Chunk &chk);
+
+    // Execute sorts the rows of input from scratch, and returns them all in chunks of up to defaultCapacity rows. It
+    // releases the chunks of input as it spills them, but holds the whole result: the callers that do not need it at
+    // once Add and take the rows by Next instead.
+    std::tuple<std::vector<util::chunk::Chunk>, std::optional<mysql::SQLError>> Execute(
+        std::vector<util::chunk::Chunk> input);
+
+    // NumRuns returns the number of runs the sort spilled.
+    size_t NumRuns() const { return _runs.size(); }
+
+private:
+    struct entry;
+    struct cursor;
+    struct merger;
+
+    SortExec(std::vector<ByItem> byItems, std::vector<uint8_t> types, SortOptions opts);
+
+    void reset();
+    // encodeKeys appends the keys of the rows of chk to _keyData and their entries to _entries.
+    std::optional<mysql::SQLError> encodeKeys(const util::chunk::Chunk &chk, uint32_t chunkIdx);
+    void sortEntries();
+    // sorted returns the rows of _entries[begin, end) in chunks, with their keys in a last column if withKeys.
+    std::vector<util::chunk::Chunk> sorted(size_t begin, size_t end, bool withKeys) const;
+    // spill sorts the rows of _entries, writes them to a run and releases the chunks they are from.
+    std::optional<mysql::SQLError> spill();
+    // finish sorts the rows left in memory, and starts the merge if there are runs.
+    std::optional<mysql::SQLError> finish();
+    // load moves c to the first row of the batch b of its run, or of the next non-empty one.
+    std::optional<mysql::SQLError> load(cursor &c, size_t b) const;
+    // loadEntry moves c, the cursor of the rows in memory, to the row of _entries[i].
+    void loadEntry(cursor &c, size_t i) const;
+
+    std::vector<expression::ExprPtr> _exprs;
+    std::vector<bool> _desc;
+    bool _hasDesc{false};
+    std::vector<uint8_t> _types;
+    // _runTypes are _types and the key column of the runs.
+    std::vector<uint8_t> _runTypes;
+    SortOptions _opts;
+    expression::EvalContext _ctx;
+
+    // The chunks held and the bytes of their rows, and the runs spilled.
+    std::vector<util::chunk::Chunk> _chunks;
+    size_t _held{0};
+    std::vector<std::unique_ptr<util::chunk::ArrowReader>> _runs;
+    // Whether every chunk was added. Then the rows are read from _ready, the next chunks of the rows in memory if
+    // nothing was spilled, else from the merge.
+    bool _finished{false};
+    std::vector<util::chunk::Chunk> _ready;
+    size_t _readyPos{0};
+    size_t _nextEntry{0};
+    std::unique_ptr<merger> _merger;
+
+    // The keys of the rows in memory, and the scratch of their encoding.
+    std::string _keyData;
+    std::vector<entry> _entries;
+    std::vector<std::string> _keys;
+    std::vector<std::string> _itemKeys;
+};
+
+}  // namespace executor
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "expression/expression.hh"
+
+// The scalar functions of NewFunction, and the helpers of their loops.
+namespace expression {
+
+// scalarFunction is a function of args.
+class scalarFunction : public Expression {
+public:
+    scalarFunction(FieldType tp, Op op, std::vector<ExprPtr> args)
+        : Expression(tp), _op(op), _args(std::move(args)) {}
+
+    Op GetOp() const { return _op; }
+    const std::vector<ExprPtr> &Args() const { return _args; }
+
+    std::string String() const override;
+
+protected:
+    Op _op;
+    std::vector<ExprPtr> _args;
+};
+
+// argument is an argument of a function evaluated for the rows of a batch: a constant, or a column with the value of
+// every row evaluated, read in place if the argument is a column of the chunk.
+class argument {
+public:
+    explicit argument(EvalContext &ctx) : _ctx(ctx) {}
+    ~argument();
+
+    argument(const argument &) = delete;
+    argument &operator=(const argument &) = delete;
+
+    // Eval evaluates e as tp, which is its eval type or Real for an Int.
+    std::optional<mysql::SQLError> Eval(const Expression &e, EvalType tp, const util::chunk::Chunk &chk,
+                                        const Rows &rows);
+
+    bool IsConst() const { return _col == nullptr; }
+    // IsNullConst reports whether the argument is the constant NULL.
+    bool IsNullConst() const { return _col == nullptr && _null; }
+
+    const util::chunk::Column &Col() const { return *_col; }
+
+    // HasNulls reports whether a row may be null.
+    bool HasNulls() const { return _col != nullptr ? _col->NullCount() > 0 : _null; }
+    bool IsNull(size_t row) const { return _col != nullptr ? _col->IsNull(row) : _null; }
+
+    // Value returns the value of row as T, int64_t, uint64_t or double.
+    template <typename T>
+    T Value(size_t row) const {
+        if (_col == nullptr) {
+            if constexpr (std::is_same_v<T, double>) {
+                return _real;
+            } else {
+                return static_cast<T>(_int);
+            }
+        }
+        return _col->Values<T>()[row];
+    }
+
+    std::string_view Bytes(size_t row) const { return _col != nullptr ? _col->GetBytes(row) : _bytes; }
+
+private:
+    EvalContext &_ctx;
+    const util::chunk::Column *_col{nullptr};
+    // _scratch holds the values of an argument evaluated by the function, returned to the pool of _ctx.
+    std::optional<util::chunk::Column> _scratch;
+    bool _null{false};
+    int64_t _int{0};
+    double _real{0};
+    std::string _bytes;
+};
+
+// vecOf and constOf read the values of an argument in the loops of the functions.
+template <typename T>
+struct vecOf {
+    const T *v;
+    T operator[](size_t i) const { return v[i]; }
+};
+
+template <typename T>
+struct constOf {
+    T v;
+    T operator[](size_t) const { return v; }
+};
+
+// visit calls f with the readers of the values of a and b as T, so that the loop over a column and a constant reads
+// the constant once.
+template <typename T, typename F>
+void visit(const argument &a, const argument &b, F &&f) {
+    auto vec = [](const argument &x) { return vecOf<T>{x.Col().Values<T>().data()}; };
+    auto con = [](const argument &x) { return constOf<T>{x.Value<T>(0)}; };
+    if (!a.IsConst()) {
+        if (!b.IsConst()) {
+            f(vec(a), vec(b));
+        } else {
+            f(vec(a), con(b));
+        }
+    } else if (!b.IsConst()) {
+        f(con(a), vec(b));
+    } else {
+        f(con(a), con(b));
+    }
+}
+
+// visit1 is visit for one argument.
+template <typename T, typename F>
+void visit1(const argument &a, F &&f) {
+    if (!a.IsConst()) {
+        f(vecOf<T>{a.Col().Values<T>().data()});
+    } else {
+        f(constOf<T>{a.Value<T>(0)});
+    }
+}
+
+// resizeResult sets result to rows.Len() rows, none null, for a fixed-width function to write their values.
+inline void resizeResult(util::chunk::Column &result, const Rows &rows) { result.ResizeFixed(rows.Len()); }
+
+// setAllNull sets every row of a fixed-width result null.
+void setAllNull(util::chunk::Column &result);
+
+// mergeNulls sets a row of result null if it is in one of args, by and-ing their bitmaps.
+void mergeNulls(util::chunk::Column &result, std::initializer_list<const argument *> args);
+
+// isNullConstant reports whether e is the constant NULL, which is an argument of any type.
+bool isNullConstant(const Expression &e);
+
+// errOutOfRange returns the error of a value of e out of the range of its type, e.g. "BIGINT UNSIGNED".
+mysql::SQLError errOutOfRange(const Expression &e);
+
+// divisionByZero is what a division by zero does, by the SQL mode of the batch.
+enum class divisionByZero { ignore, warn, error };
+divisionByZero divisionByZeroOf(EvalContext &ctx);
+
+std::tuple<ExprPtr, std::optional<mysql::SQLError>> newArithmetic(Op op, std::vector<ExprPtr> args,
+                                                                  mysql::SQLMode mode);
+std::tuple<ExprPtr, std::optional<mysql::SQLError>> newCompare(Op op, std::vector<ExprPtr> args);
+std::tuple<ExprPtr, std::optional<mysql::SQLError>> newLogic(Op op, std::vector<ExprPtr> args);
+std::tuple<ExprPtr, std::optional<mysql::SQLError>> newIn(std::vector<ExprPtr> args);
+std::tuple<ExprPtr, std::optional<mysql::SQLError>> newCase(std::vector<ExprPtr> args);
+
+}  // namespace expression
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+#include "parser/mysql/const.hh"
+#include "parser/mysql/error.hh"
+#include "parser/mysql/type.hh"
+#include "util/chunk/alloc.hh"
+#include "util/chunk/chunk.hh"
+
+// Package expression evaluates the scalar expressions of the operators, after TiDB's expression package, a batch of
+// rows at a time: every function computes its result for a whole chunk in a loop over the columns of its arguments,
+// and the session state its semantics depend on, e.g. the SQL mode, is read once per batch rather than once per row.
+namespace expression {
+
+// EvalType is the type an expression is evaluated as: Int as int64_t (uint64_t when unsigned), Real as double,
+// String as bytes. The temporal and decimal types are evaluated as strings, in their text form.
+enum class EvalType : uint8_t { Int, Real, String };
+
+// FieldType is the type of the values of an expression: a mysql type and its flags, e.g. mysql::UnsignedFlag.
+struct FieldType {
+    uint8_t Tp{mysql::TypeLonglong};
+    uint16_t Flag{0};
+
+    EvalType GetEvalType() const;
+    bool IsUnsigned() const { return mysql::HasUnsignedFlag(Flag); }
+};
+
+// Rows are the rows of a chunk an expression is evaluated for: the n rows of its columns, or those of a selection
+// vector. The results of an expression are indexed like the columns, their other rows being undefined.
+class Rows {
+public:
+    explicit Rows(size_t n) : _n(n) {}
+    Rows(size_t n, std::span<const uint32_t> sel) : _n(n), _sel(sel), _hasSel(true) {}
+
+    // Of returns the rows of chk.
+    static Rows Of(const util::chunk::Chunk &chk) {
+        return chk.HasSel() ? Rows(chk.NumRowsUnfiltered(), chk.Sel()) : Rows(chk.NumRowsUnfiltered());
+    }
+
+    // Len returns the number of rows of the columns.
+    size_t Len() const { return _n; }
+    // Size returns the number of rows evaluated.
+    size_t Size() const { return _hasSel ? _sel.size() : _n; }
+    bool HasSel() const { return _hasSel; }
+    std::span<const uint32_t> Sel() const { return _sel; }
+
+    // ForEach calls f with the index of every row. Without a selection it is a plain loop the compiler vectorizes.
+    template <typename F>
+    void ForEach(F &&f) const {
+        if (!_hasSel) {
+            for (size_t i = 0; i < _n; i++) {
+                f(i);
+            }
+        } else {
+            for (auto i : _sel) {
+                f(static_cast<size_t>(i));
+            }
+        }
+    }
+
+private:
+    size_t _n;
+    std::span<const uint32_t> _sel;
+    bool _hasSel{false};
+};
+
+// EvalContext is the context of the evaluations of an operator: the session state they depend on, the warnings they
+// raise and the pool of their intermediate results. It is used by one thread at a time.
+struct EvalContext {
+    // maxWarnings bounds Warnings, like max_error_count.
+    static constexpr size_t maxWarnings = 64;
+
+    mysql::SQLMode Mode{mysql::ModeNone};
+    // InDML is whether the statement is an INSERT, UPDATE or DELETE, whose errors the strict mode reports.
+    bool InDML{false};
+    std::vector<mysql::SQLError> Warnings;
+    util::chunk::Allocator Columns;
+
+    void AppendWarning(mysql::SQLError err) {
+        if (Warnings.size() < maxWarnings) {
+            Warnings.push_back(std::move(err));
+        }
+    }
+};
+
+class Expression;
+using ExprPtr = std::unique_ptr<Expression>;
+
+// Expression is a scalar expression.
+class Expression {
+public:
+    explicit Expression(FieldType tp) : _type(tp) {}
+    virtual ~Expression() = default;
+
+    const FieldType &Type() const { return _type; }
+    EvalType GetEvalType() const { return _type.GetEvalType(); }
+
+    // VecEval evaluates the expression for rows of chk into result, a column of the element size of its eval type,
+    // e.g. from EvalColumn, which it resets.
+    virtual std::optional<mysql::SQLError> VecEval(EvalContext &ctx, const util::chunk::Chunk &chk, const Rows &rows,
+                                                   util::chunk::Column &result) const = 0;
+
+    // String returns the expression in SQL, for the errors.
+    virtual std::string String() const = 0;
+
+    // Input returns the column of chk the expression is, if it is one with the storage of its eval type, so that
+    // the functions read it in place.
+    virtual const util::chunk::Column *Input(const util::chunk::Chunk &chk) const { return nullptr; }
+
+protected:
+    FieldType _type;
+};
+
+// EvalColumn returns an empty column of the storage of tp, from the pool of ctx.
+util::chunk::Column EvalColumn(EvalContext &ctx, EvalType tp);
+
+// ColumnRef is the column at an index of the chunks.
+class ColumnRef : public Expression {
+public:
+    ColumnRef(size_t index, FieldType tp, std::string name) : Expression(tp), _index(index), _name(std::move(name)) {}
+
+    size_t Index() const { return _index; }
+
+    std::optional<mysql::SQLError> VecEval(EvalContext &ctx, const util::chunk::Chunk &chk, const Rows &rows,
+                                           util::chunk::Column &result) const override;
+    std::string String() const override { return _name; }
+    const util::chunk::Column *Input(const util::chunk::Chunk &chk) const override;
+
+private:
+    size_t _index;
+    std::string _name;
+};
+
+// Constant is a constant, e.g. a literal or a parameter; std::monostate is NULL.
+class Constant : public Expression {
+public:
+    using Value = std::variant<std::monostate, int64_t, double, std::string>;
+
+    static ExprPtr NewNull() { return std::make_unique<Constant>(FieldType{mysql::TypeNull, 0}, std::monostate{}); }
+    static ExprPtr NewInt(int64_t v) { return std::make_unique<Constant>(FieldType{mysql::TypeLonglong, 0}, v); }
+    static ExprPtr NewUint(uint64_t v) {
+        return std::make_unique<Constant>(FieldType{mysql::TypeLonglong, mysql::UnsignedFlag},
+                                          static_cast<int64_t>(v));
+    }
+    static ExprPtr NewReal(double v) { return std::make_unique<Constant>(FieldType{mysql::TypeDouble, 0}, v); }
+    static ExprPtr NewString(std::string v) {
+        return std::make_unique<Constant>(FieldType{mysql::TypeVarString, 0}, std::move(v));
+    }
+
+    // A constant of tp, an int64_t holding the bits of an unsigned value.
+    Constant(FieldType tp, Value value);
+
+    const Value &GetValue() const { return _value; }
+    bool IsNull() const { return std::holds_alternative<std::monostate>(_value); }
+
+    std::optional<mysql::SQLError> VecEval(EvalContext &ctx, const util::chunk::Chunk &chk, const Rows &rows,
+                                           util::chunk::Column &result) const override;
+    std::string String() const override;
+
+private:
+    Value _value;
+};
+
+// Op is a scalar function.
+enum class Op : uint8_t {
+    // Arithmetic. Div is evaluated as Real and IntDiv (DIV) as Int; the others as Real if an argument is, else Int.
+    Plus,
+    Minus,
+    Mul,
+    Div,
+    IntDiv,
+    Mod,
+    // Comparisons, evaluated as Int 0 or 1. NullEQ is <=>.
+    EQ,
+    NE,
+    LT,
+    LE,
+    GT,
+    GE,
+    NullEQ,
+    // Logical operators, three-valued.
+    LogicAnd,
+    LogicOr,
+    LogicXor,
+    UnaryNot,
+    IsNull,
+    IsNotNull,
+    // In is `args[0] IN (args[1], ...)`, whose list is constants.
+    In,
+    // Case is `CASE WHEN args[0] THEN args[1] ... [ELSE args[n - 1]] END`.
+    Case,
+};
+
+// NewFunction returns the function op of args. mode is the SQL mode of the session the plan is built for, which
+// decides the result type of an unsigned subtraction: the evaluation follows that type whatever the mode of its
+// context, so a session whose mode changed must build its plan again.
+std::tuple<ExprPtr, std::optional<mysql::SQLError>> NewFunction(Op op, std::vector<ExprPtr> args,
+                                                                mysql::SQLMode mode = {mysql::ModeNone});
+
+// VectorizedFilter sets the selection of chk to its rows for which every one of conds is true, evaluating each
+// condition for the rows the previous ones kept.
+std::optional<mysql::SQLError> VectorizedFilter(EvalContext &ctx, std::span<const ExprPtr> conds,
+                                                util::chunk::Chunk &chk);
+
+}  // namespace expression
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "expression/expression.hh"
+
+// The filters compiled to x86-64 with xbyak: a conjunction of comparisons of BIGINT or DOUBLE columns with constants,
+// e.g. `a > ? AND b BETWEEN ? AND ?`, runs as one loop generated for its shape that writes the selection vector of
+// the rows passing it, with no function call, no intermediate column and no branch per row.
+namespace expression {
+
+// FilterKernel is a compiled filter. It writes to out the rows passing it, of the rows sel[0, n) or [0, n) if sel is
+// nullptr, and returns their number; out may be sel. columns holds the values and the validity bitmap of the column
+// of every predicate, params its constant.
+using FilterKernel = uint32_t (*)(const uint8_t *const *columns, const int64_t *params, const uint32_t *sel, size_t n,
+                                  uint32_t *out);
+
+// KernelCache holds the kernels compiled for the shapes of the filters, so that the filters that differ only by their
+// columns or constants share one. It is safe for concurrent use.
+class KernelCache {
+public:
+    KernelCache();
+    ~KernelCache();
+
+    KernelCache(const KernelCache &) = delete;
+    KernelCache &operator=(const KernelCache &) = delete;
+
+    // Global returns the cache of the process.
+    static KernelCache &Global();
+
+    size_t Size() const;
+
+private:
+    friend class JitFilter;
+    struct kernel;
+
+    // get returns the kernel of fingerprint, compiled by compile the first time; nullptr if it failed to.
+    template <typename F>
+    FilterKernel get(const std::string &fingerprint, F &&compile);
+
+    mutable std::mutex _mu;
+    std::unordered_map<std::string, std::unique_ptr<kernel>> _kernels;
+};
+
+// JitFilter is the compiled form of the conditions of a filter.
+class JitFilter {
+public:
+    // maxPredicates bounds the comparisons of a compiled filter.
+    static constexpr size_t maxPredicates = 8;
+
+    // predicate is a comparison of a column with a parameter, or IS [NOT] NULL.
+    struct predicate;
+
+    ~JitFilter();
+
+    // Compile returns the compiled form of conds, or nullptr if one of them is not a conjunction of comparisons of a
+    // BIGINT or DOUBLE column with a constant, or of IS [NOT] NULL of a column.
+    static std::unique_ptr<JitFilter> Compile(std::span<const ExprPtr> conds,
+                                              KernelCache &cache = KernelCache::Global());
+
+    // Fingerprint returns the shape of the filter the kernels are cached by, e.g. "i>,d>=,d<=".
+    const std::string &Fingerprint() const { return _fingerprint; }
+
+    // Apply sets the selection of chk to its rows passing the filter, and returns false if no kernel could be
+    // compiled for it.
+    bool Apply(util::chunk::Chunk &chk);
+
+private:
+    JitFilter(std::vector<predicate> predicates, KernelCache &cache);
+
+    FilterKernel kernelOf(uint32_t variant);
+
+    std::vector<predicate> _predicates;
+    std::string _fingerprint;
+    std::vector<int64_t> _params;
+    KernelCache &_cache;
+    // _variants are the kernels of the filter, by whether there is a selection and the predicates whose column has
+    // nulls in the batch, compiled when first used; _failed are those that could not be.
+    std::vector<FilterKernel> _variants;
+    std::vector<bool> _failed;
+};
+
+// Filter evaluates the conditions of a filter, with a compiled kernel if it can be, else with VectorizedFilter.
+class Filter {
+public:
+    explicit Filter(std::vector<ExprPtr> conds, KernelCache &cache = KernelCache::Global());
+
+    bool IsCompiled() const { return _jit != nullptr; }
+
+    // Apply sets the selection of chk to its rows for which every condition is true.
+    std::optional<mysql::SQLError> Apply(EvalContext &ctx, util::chunk::Chunk &chk);
+
+private:
+    std::vector<ExprPtr> _conds;
+    std::unique_ptr<JitFilter> _jit;
+};
+
+}  // namespace expression
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace metrics {
+
+// numShards is the number of shards of every metric. A thread always updates the same shard, so that updates from
+// different threads do not contend on a cache line as long as there are no more threads than shards; the shards are
+// only merged when the metrics are scraped.
+constexpr size_t numShards = 16;
+
+// shardIndex returns the shard of the calling thread.
+size_t shardIndex();
+
+// Metric is a metric exported in the Prometheus text format. Metrics register themselves on construction and must
+// outlive the process, i.e. be globals or function statics.
+class Metric {
+public:
+    // labels is the Prometheus label set of the metric, e.g. `type="Query"`, empty if it has none. Metrics with the
+    // same name and different labels make one family.
+    Metric(std::string_view name, std::string_view help, std::string_view labels);
+    virtual ~Metric() = default;
+
+    Metric(const Metric &) = delete;
+    Metric &operator=(const Metric &) = delete;
+
+    const std::string &Name() const { return _name; }
+    const std::string &Help() const { return _help; }
+    const std::string &Labels() const { return _labels; }
+
+    // Type returns the Prometheus type of the metric.
+    virtual std::string_view Type() const = 0;
+
+    // WriteSamples appends the samples of the metric to out in the Prometheus text format.
+    virtual void WriteSamples(std::string &out) const = 0;
+
+protected:
+    // writeSample appends one sample line, the extra label being added to the labels of the metric.
+    void writeSample(std::string &out, std::string_view suffix, std::string_view extraLabel, double value) const;
+
+private:
+    std::string _name;
+    std::string _help;
+    std::string _labels;
+};
+
+// Counter is a monotonically increasing counter.
+class Counter final : public Metric {
+public:
+    using Metric::Metric;
+
+    void Add(uint64_t n = 1) { _shards[shardIndex()].value.fetch_add(n, std::memory_order_relaxed); }
+
+    // Value returns the sum of the shards.
+    uint64_t Value() const;
+
+    std::string_view Type() const override { return "counter"; }
+    void WriteSamples(std::string &out) const override;
+
+private:
+    struct alignas(64) shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<shard, numShards> _shards;
+};
+
+// Gauge is a value that goes up and down, like the number of open connections. A thread may decrement it on another
+// shard than the one it was incremented on: only the sum of the shards makes sense.
+class Gauge final : public Metric {
+public:
+    using Metric::Metric;
+
+    void Add(int64_t n) { _shards[shardIndex()].value.fetch_add(n, std::memory_order_relaxed); }
+    void Inc() { Add(1); }
+    void Dec() { Add(-1); }
+
+    int64_t Value() const;
+
+    std::string_view Type() const override { return "gauge"; }
+    void WriteSamples(std::string &out) const override;
+
+private:
+    struct alignas(64) shard {
+        std::atomic<int64_t> value{0};
+    };
+    std::array<shard, numShards> _shards;
+};
+
+// GaugeFunc is a gauge whose value is computed by a function when the metrics are scraped, e.g. a ratio of other
+// metrics. The function may be called from any thread.
+class GaugeFunc final : public Metric {
+public:
+    GaugeFunc(std::string_view name, std::string_view help, std::string_view labels, std::function<double()> fn);
+
+    double Value() const { return _fn(); }
+
+    std::string_view Type() const override { return "gauge"; }
+    void WriteSamples(std::string &out) const override;
+
+private:
+    std::function<double()> _fn;
+};
+
+// HistogramSnapshot is the merged state of a Histogram.
+struct HistogramSnapshot {
+    uint64_t Count{0};
+    uint64_t Sum{0};
+    std::vector<uint64_t> Buckets;
+
+    // Percentile returns the smallest value that is greater than or equal to q (0 < q <= 1) of the observations, up
+    // to the precision of the buckets. It returns 0 if there is none.
+    uint64_t Percentile(double q) const;
+};
+
+// Histogram records the distribution of non-negative integer values, e.g. latencies in nanoseconds, in log-linear
+// buckets like HdrHistogram: every power of two is split in subBuckets buckets, which bounds the relative error of
+// the percentiles to 1/subBuckets whatever the range of the values. It is exported as a Prometheus summary with the
+// quantiles the capacity planning needs, the values being scaled by unit (1e-9 to export nanoseconds as seconds).
+class Histogram final : public Metric {
+public:
+    static constexpr size_t subBucketBits = 3;
+    static constexpr size_t subBuckets = 1 << subBucketBits;
+    static constexpr size_t numBuckets = (64 - subBucketBits + 1) * subBuckets;
+
+    Histogram(std::string_view name, std::string_view help, std::string_view labels, double unit = 1);
+
+    void Observe(uint64_t value) {
+        auto &s = _shards[shardIndex()];
+        s.buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        s.sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    // ObserveSince observes the nanoseconds elapsed since start.
+    void ObserveSince(std::chrono::steady_clock::time_point start) {
+        Observe(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // Snapshot merges the shards.
+    HistogramSnapshot Snapshot() const;
+
+    std::string_view Type() const override { return "summary"; }
+    void WriteSamples(std::string &out) const override;
+
+    // bucketIndex returns the bucket of value: values below subBuckets have their own bucket, the others share one
+    // with the values having the same highest subBucketBits + 1 bits.
+    static size_t bucketIndex(uint64_t value) {
+        if (value < subBuckets) {
+            return value;
+        }
+        size_t exp = 63 - __builtin_clzll(value);
+        return (exp - subBucketBits + 1) * subBuckets + ((value >> (exp - subBucketBits)) & (subBuckets - 1));
+    }
+
+    // bucketUpperBound returns the largest value of bucket i.
+    static uint64_t bucketUpperBound(size_t i);
+
+private:
+    struct alignas(64) shard {
+        std::atomic<uint64_t> sum{0};
+        std::array<std::atomic<uint64_t>, numBuckets> buckets{};
+    };
+    double _unit;
+    std::array<shard, numShards> _shards;
+};
+
+// WritePrometheus appends all the registered metrics to out in the Prometheus text exposition format.
+void WritePrometheus(std::string &out);
+
+}  // namespace metrics
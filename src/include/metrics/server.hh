@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+#include "metrics/metrics.hh"
+
+namespace metrics {
+
+// Phase is a phase of the handling of a statement.
+enum class Phase : uint8_t {
+    // Lex is the lexing of a statement being prepared.
+    Lex,
+    // Parse is the splitting of a COM_QUERY into its statements.
+    Parse,
+    // Execute is the run of the executor, including the writes of the results that do not fit the packet buffer.
+    Execute,
+    // Network is the time spent reading a command and writing its response on the socket, once the connection was
+    // woken up by its reactor.
+    Network,
+    NumPhases,
+};
+
+// PhaseDuration returns the latency histogram of phase, in nanoseconds.
+Histogram &PhaseDuration(Phase phase);
+
+// CommandCounter returns the counter of the commands of type cmd, cmd being below mysql::ComEnd.
+Counter &CommandCounter(uint8_t cmd);
+
+// CommandDuration is the latency of the commands, from the moment they are read to the end of their response.
+extern Histogram CommandDuration;
+
+// Connections is the number of open connections.
+extern Gauge Connections;
+
+// SlowQueries is the number of statements logged in the slow query log, SlowQueriesDropped the number of those that
+// were dropped because the log could not keep up.
+extern Counter SlowQueries;
+extern Counter SlowQueriesDropped;
+
+}  // namespace metrics
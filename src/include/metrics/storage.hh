@@ -0,0 +1,13 @@
+#pragma once
+
+#include "metrics/metrics.hh"
+
+namespace metrics {
+
+// HandleIndexEntries and HandleIndexSlots are the number of entries and of slots of the hash indexes of the handles,
+// all tables together. HandleIndexLoadFactor is their ratio, 0 without any slot.
+extern Gauge HandleIndexEntries;
+extern Gauge HandleIndexSlots;
+extern GaugeFunc HandleIndexLoadFactor;
+
+}  // namespace metrics
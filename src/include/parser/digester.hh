@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+namespace parser {
+
+// Digest stores the digest of a normalized sql statement: the 128-bit XXH3 hash of the normalized text.
+struct Digest {
+    uint64_t _high{0};
+    uint64_t _low{0};
+
+    // String returns the digest hex string.
+    std::string String() const;
+
+    bool empty() const { return _high == 0 && _low == 0; }
+    bool operator==(const Digest &other) const = default;
+};
+
+// DigestHasher hashes a Digest for unordered containers; the digest is already a hash, so half of it will do.
+struct DigestHasher {
+    size_t operator()(const Digest &digest) const { return digest._low; }
+};
+
+// Normalize generates the normalized statements.
+// it will get normalized form of statement text
+// which removes general property of a statement but keeps specific property.
+//
+// for example: Normalize('select 1 from b where a = 1') => 'select ? from b where a = ?'
+std::string Normalize(const std::string &sql);
+
+// NormalizeDigest combines Normalize and DigestNormalized into one method.
+std::tuple<std::string, Digest> NormalizeDigest(const std::string &sql);
+
+// DigestNormalized generates the digest of a normalized sql, as returned by Normalize.
+//
+// for example: DigestNormalized(Normalize('select 1')) == DigestNormalized(Normalize('SELECT 2'))
+Digest DigestNormalized(std::string_view normalized);
+
+}  // namespace parser
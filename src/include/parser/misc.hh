@@ -31,4 +31,12 @@ struct trieNode {
 std::shared_ptr<trieNode> getRuleTable();
 std::unordered_map<std::string, int> getTokenMap();
 std::string getTokenStr(int tok);
+
+// isHintedToken reports whether an optimizer hint comment may directly follow the keyword tok.
+bool isHintedToken(int tok);
+// getHintToken returns the token of the optimizer hint name, case-insensitively, or 0 if it is not a hint.
+int getHintToken(std::string name);
+// getHintTokens returns the tokens of the hints of the optimizer hint comment lit, e.g. "/*+ HASH_AGG() */", in order:
+// the known names followed by '('.
+std::vector<int> getHintTokens(const std::string &lit);
 }  // namespace parser
\ No newline at end of file
@@ -1,7 +1,21 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
 namespace mysql {
 
+// TiDBReleaseVersion is the release version of this tidb-server.
+extern std::string TiDBReleaseVersion;
+
+// ServerVersion is the version information of this tidb-server in MySQL's format.
+extern std::string ServerVersion;
+
+// DefaultCollationID is the collation announced in the handshake: utf8mb4_bin.
+constexpr uint8_t DefaultCollationID = 46;
+
 // Header information
 enum : uint8_t {
     OKHeader = 0x00,
@@ -10,11 +24,79 @@ enum : uint8_t {
     LocalInFileHeader = 0xfb,
 };
 
+// Command information.
+enum : uint8_t {
+    ComSleep = 0x00,
+    ComQuit,
+    ComInitDB,
+    ComQuery,
+    ComFieldList,
+    ComCreateDB,
+    ComDropDB,
+    ComRefresh,
+    ComShutdown,
+    ComStatistics,
+    ComProcessInfo,
+    ComConnect,
+    ComProcessKill,
+    ComDebug,
+    ComPing,
+    ComTime,
+    ComDelayedInsert,
+    ComChangeUser,
+    ComBinlogDump,
+    ComTableDump,
+    ComConnectOut,
+    ComRegisterSlave,
+    ComStmtPrepare,
+    ComStmtExecute,
+    ComStmtSendLongData,
+    ComStmtClose,
+    ComStmtReset,
+    ComSetOption,
+    ComStmtFetch,
+    ComDaemon,
+    ComBinlogDumpGtid,
+    ComResetConnection,
+    ComEnd,
+};
+
+// Command2Str is the command information to command name.
+extern const std::array<std::string_view, ComEnd> Command2Str;
+
 // Protocol Features
 enum {
     AuthSwitchRequest = 0xfe,
 };
 
+// Client information.
+enum : uint32_t {
+    ClientLongPassword = 1 << 0,
+    ClientFoundRows = 1 << 1,
+    ClientLongFlag = 1 << 2,
+    ClientConnectWithDB = 1 << 3,
+    ClientNoSchema = 1 << 4,
+    ClientCompress = 1 << 5,
+    ClientODBC = 1 << 6,
+    ClientLocalFiles = 1 << 7,
+    ClientIgnoreSpace = 1 << 8,
+    ClientProtocol41 = 1 << 9,
+    ClientInteractive = 1 << 10,
+    ClientSSL = 1 << 11,
+    ClientIgnoreSigpipe = 1 << 12,
+    ClientTransactions = 1 << 13,
+    ClientReserved = 1 << 14,
+    ClientSecureConnection = 1 << 15,
+    ClientMultiStatements = 1 << 16,
+    ClientMultiResults = 1 << 17,
+    ClientPSMultiResults = 1 << 18,
+    ClientPluginAuth = 1 << 19,
+    ClientConnectAtts = 1 << 20,
+    ClientPluginAuthLenencClientData = 1 << 21,
+    ClientDeprecateEOF = 1 << 24,
+    ClientZstdCompressionAlgorithm = 1 << 26,
+};
+
 // Server information.
 enum : uint16_t {
     ServerStatusInTrans = 0x0001,
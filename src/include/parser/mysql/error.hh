@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "parser/mysql/errcode.hh"
+
+namespace mysql {
+
+// DefaultMySQLState is default state of the mySQL
+constexpr const char *DefaultMySQLState = "HY000";
+
+// MySQLState maps error code to MySQL SQLSTATE value.
+// The values are taken from ANSI SQL and ODBC and are more standardized.
+extern std::unordered_map<uint16_t, std::string> MySQLState;
+
+// MySQLErrName maps error code to MySQL error messages.
+extern std::unordered_map<uint16_t, std::shared_ptr<ErrMessage>> MySQLErrName;
+
+// SQLError records an error information, from executing SQL.
+struct SQLError {
+    uint16_t Code;
+    std::string Message;
+    std::string State;
+
+    // Error prints errors, with a formatted string.
+    std::string Error() const;
+};
+
+// NewErrf creates a SQL error, with an error code and a printf-style format specifier.
+template <typename... Args>
+SQLError NewErrf(uint16_t errCode, const std::string &format, Args... args) {
+    SQLError e{errCode, {}, DefaultMySQLState};
+    if (auto it = MySQLState.find(errCode); it != MySQLState.end()) {
+        e.State = it->second;
+    }
+    if constexpr (sizeof...(args) == 0) {
+        e.Message = format;
+    } else {
+        auto n = std::snprintf(nullptr, 0, format.c_str(), args...);
+        if (n > 0) {
+            e.Message.resize(n + 1);
+            std::snprintf(e.Message.data(), n + 1, format.c_str(), args...);
+            e.Message.resize(n);
+        }
+    }
+    return e;
+}
+
+// NewErr generates a SQL error, with an error code and default format specifier defined in MySQLErrName.
+// The arguments are passed to snprintf, so strings must be given as const char *.
+template <typename... Args>
+SQLError NewErr(uint16_t errCode, Args... args) {
+    if (auto it = MySQLErrName.find(errCode); it != MySQLErrName.end()) {
+        return NewErrf(errCode, it->second->Raw, args...);
+    }
+    return NewErrf(errCode, "unknown error %d", static_cast<int>(errCode));
+}
+
+}  // namespace mysql
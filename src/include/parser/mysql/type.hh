@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+
+namespace mysql {
+
+// MySQL type information.
+enum : uint8_t {
+    TypeUnspecified = 0,
+    TypeTiny = 1,
+    TypeShort = 2,
+    TypeLong = 3,
+    TypeFloat = 4,
+    TypeDouble = 5,
+    TypeNull = 6,
+    TypeTimestamp = 7,
+    TypeLonglong = 8,
+    TypeInt24 = 9,
+    TypeDate = 10,
+    // TypeDuration is MySQL's TIME type; TiDB names it after the value it holds.
+    TypeDuration = 11,
+    TypeDatetime = 12,
+    TypeYear = 13,
+    TypeNewDate = 14,
+    TypeVarchar = 15,
+    TypeBit = 16,
+
+    TypeJSON = 0xf5,
+    TypeNewDecimal = 0xf6,
+    TypeEnum = 0xf7,
+    TypeSet = 0xf8,
+    TypeTinyBlob = 0xf9,
+    TypeMediumBlob = 0xfa,
+    TypeLongBlob = 0xfb,
+    TypeBlob = 0xfc,
+    TypeVarString = 0xfd,
+    TypeString = 0xfe,
+    TypeGeometry = 0xff,
+};
+
+// Flag information.
+enum : uint16_t {
+    NotNullFlag = 1 << 0,          /* Field can't be NULL */
+    PriKeyFlag = 1 << 1,           /* Field is part of a primary key */
+    UniqueKeyFlag = 1 << 2,        /* Field is part of a unique key */
+    MultipleKeyFlag = 1 << 3,      /* Field is part of a key */
+    BlobFlag = 1 << 4,             /* Field is a blob */
+    UnsignedFlag = 1 << 5,         /* Field is unsigned */
+    ZerofillFlag = 1 << 6,         /* Field is zerofill */
+    BinaryFlag = 1 << 7,           /* Field is binary   */
+    EnumFlag = 1 << 8,             /* Field is an enum */
+    AutoIncrementFlag = 1 << 9,    /* Field is an auto increment field */
+    TimestampFlag = 1 << 10,       /* Field is a timestamp */
+    SetFlag = 1 << 11,             /* Field is a set */
+    NoDefaultValueFlag = 1 << 12,  /* Field doesn't have a default value */
+    OnUpdateNowFlag = 1 << 13,     /* Field is set to NOW on UPDATE */
+    NumFlag = 1 << 15,             /* Field is a num (for clients) */
+};
+
+// HasUnsignedFlag checks if UnsignedFlag is set.
+constexpr bool HasUnsignedFlag(uint16_t flag) { return (flag & UnsignedFlag) > 0; }
+
+// HasNotNullFlag checks if NotNullFlag is set.
+constexpr bool HasNotNullFlag(uint16_t flag) { return (flag & NotNullFlag) > 0; }
+
+// IsIntegerType returns true if tp is an integer type.
+constexpr bool IsIntegerType(uint8_t tp) {
+    switch (tp) {
+        case TypeTiny:
+        case TypeShort:
+        case TypeInt24:
+        case TypeLong:
+        case TypeLonglong:
+        case TypeYear:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// IsTemporalType returns true if tp is a date/time type.
+constexpr bool IsTemporalType(uint8_t tp) {
+    switch (tp) {
+        case TypeDate:
+        case TypeNewDate:
+        case TypeDatetime:
+        case TypeTimestamp:
+        case TypeDuration:
+            return true;
+        default:
+            return false;
+    }
+}
+}  // namespace mysql
@@ -2,7 +2,9 @@
 
 #include <memory>
 #include <sstream>
+#include <string_view>
 #include <tuple>
+#include <vector>
 
 #include "common/utf8/reader.hh"
 #include "parser/mysql/const.hh"
@@ -15,6 +17,9 @@ public:
     std::string stmtText() const;
     common::utf8::rune_t getNextToken();
     std::tuple<int, common::utf8::Pos, std::string> scan();
+    // Lex returns the next token like scan, resolving identifiers to keywords and
+    // remembering the last keywords so that optimizer hints are recognized.
+    std::tuple<int, common::utf8::Pos, std::string> Lex();
     common::utf8::rune_t skipWhitespace();
     int isTokenIdentifier(std::string lit, int offset);
     std::shared_ptr<common::utf8::reader_t> reader() { return _reader; }
@@ -64,7 +69,7 @@ public:
     // If the lexer should recognize keywords for window function.
     // It may break the compatibility when support those keywords,
     // because some application may already use them as identifiers.
-    bool _supportWindowFunc;
+    bool _supportWindowFunc{false};
 
     // Whether record the original text keyword position to the AST node.
     bool _skipPositionRecording;
@@ -92,4 +97,11 @@ public:
 };
 
 std::shared_ptr<Scanner> NewScanner(std::string);
+
+// SplitStatements splits a multi-statement batch at its top-level ';' in one pass of the scanner, so that the ';'
+// in string literals, quoted identifiers and comments do not count. The statements are returned without the
+// separator and the surrounding whitespace, empty ones are dropped.
+// If the scanner fails, e.g. on an unterminated string, the rest of the batch is returned as the last statement
+// so that its syntax error is reported when it runs.
+std::vector<std::string_view> SplitStatements(std::string_view sql);
 }  // namespace parser
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "libcuckoo/cuckoohash_map.hh"
+#include "parser/digester.hh"
+#include "parser/mysql/const.hh"
+#include "parser/mysql/error.hh"
+
+namespace planner::core {
+
+// defaultPlanCacheCapacity is the number of statement digests GlobalPlanCache holds.
+constexpr size_t defaultPlanCacheCapacity = 4096;
+
+// maxPlanCacheVariants bounds how many templates with different tokens share one digest, e.g. the same query with
+// IN lists of different lengths.
+constexpr size_t maxPlanCacheVariants = 8;
+
+// StmtToken is a token of a prepared statement, with keywords resolved.
+struct StmtToken {
+    int Tok;
+    std::string Lit;
+
+    bool operator==(const StmtToken &other) const = default;
+};
+
+// PlanCacheStmt is the template of a prepared statement: everything that only depends on the statement text.
+// It is immutable once built, so a single instance is shared by all the sessions that prepare the same statement.
+struct PlanCacheStmt {
+    // NormalizedSQL and SQLDigest identify the statement, see parser::NormalizeDigest.
+    std::string NormalizedSQL;
+    parser::Digest SQLDigest;
+    // Tokens is the lexed statement without comments, optimizer hints and the trailing ';'.
+    std::vector<StmtToken> Tokens;
+    // ParamMarkers holds the index into Tokens of every parameter marker, in order.
+    std::vector<uint32_t> ParamMarkers;
+    // SQLMode is the mode the statement was prepared in. The plans built from the template depend on it, e.g. for the
+    // type of an unsigned subtraction, so the sessions only share the templates of their mode.
+    mysql::SQLMode SQLMode{mysql::ModeNone};
+
+    size_t NumParams() const { return ParamMarkers.size(); }
+};
+
+// PlanCache is the process-wide cache of prepared statement templates, keyed by the digest of the normalized
+// statement. Sessions look it up concurrently without a global lock; each digest holds up to maxPlanCacheVariants
+// templates, which must have identical tokens and SQL modes to be shared.
+//
+// The digests are evicted by CLOCK: each one cached takes a slot of a ring of capacity slots, which a hand sweeps when
+// a new digest finds none free, a few slots per miss. The templates of a swept digest that no session holds are evicted
+// under the locks of its buckets, unless they were used since the last sweep. The templates no session holds are
+// counted, so that a miss does not sweep when none can be evicted.
+class PlanCache {
+public:
+    explicit PlanCache(size_t capacity = defaultPlanCacheCapacity);
+    ~PlanCache();
+
+    // Put returns the cached template with the same tokens as stmt, or caches stmt and returns it.
+    // When the cache is full the templates that no session holds any more are evicted first; if none can be,
+    // stmt is returned without being cached. A template returned is held until the last copy of it is destroyed.
+    std::shared_ptr<const PlanCacheStmt> Put(std::shared_ptr<const PlanCacheStmt> stmt);
+
+    size_t Size() const { return _stmts.size(); }
+    uint64_t Hits() const { return _hits.load(std::memory_order_relaxed); }
+    uint64_t Misses() const { return _misses.load(std::memory_order_relaxed); }
+
+private:
+    struct cached;
+    struct slot;
+    using variants = std::vector<std::shared_ptr<cached>>;
+
+    // claimSlot returns a free slot of the ring, evicting a digest if needed, or null if none could be evicted.
+    slot *claimSlot();
+    // evict evicts the templates of the digest of s that can be, and returns whether the digest is gone.
+    bool evict(const slot &s);
+    void releaseSlot(slot &s);
+    // handleOf returns c to a session, which holds it until the last copy is destroyed.
+    static std::shared_ptr<const PlanCacheStmt> handleOf(std::shared_ptr<cached> c);
+
+    size_t _capacity;
+    cuckoohash_map<parser::Digest, variants, parser::DigestHasher> _stmts;
+    std::unique_ptr<slot[]> _slots;
+    std::atomic<size_t> _hand{0};
+    std::atomic<size_t> _free;
+    // _evictable counts the templates no session holds. It is shared with the templates handed out, which may
+    // outlive the cache.
+    std::shared_ptr<std::atomic<int64_t>> _evictable;
+    std::atomic<uint64_t> _hits{0};
+    std::atomic<uint64_t> _misses{0};
+};
+
+// GlobalPlanCache returns the plan cache shared by all the sessions.
+PlanCache &GlobalPlanCache();
+
+// PreparedPlanCacheEnabled reports whether prepared statements are cached when they carry no USE_PLAN_CACHE or
+// IGNORE_PLAN_CACHE hint. It is enabled by default.
+bool PreparedPlanCacheEnabled();
+void SetPreparedPlanCacheEnabled(bool enabled);
+
+// GetPlanCacheStmt lexes sql and returns its template, shared with other sessions through GlobalPlanCache.
+// The IGNORE_PLAN_CACHE() hint keeps the statement out of the cache and USE_PLAN_CACHE() caches it even when
+// PreparedPlanCacheEnabled is false.
+std::tuple<std::shared_ptr<const PlanCacheStmt>, std::optional<mysql::SQLError>> GetPlanCacheStmt(
+    const std::string &sql, mysql::SQLMode sqlMode);
+
+}  // namespace planner::core
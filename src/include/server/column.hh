@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace server {
+
+// ColumnInfo contains information of a column.
+struct ColumnInfo {
+    std::string Schema;
+    std::string Table;
+    std::string OrgTable;
+    std::string Name;
+    std::string OrgName;
+    uint32_t ColumnLength{0};
+    uint16_t Charset{0};
+    uint16_t Flag{0};
+    uint8_t Decimal{0};
+    uint8_t Type{0};
+
+    // Dump appends the column definition packet payload to buffer.
+    void Dump(std::string &buffer) const;
+};
+
+}  // namespace server
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace server {
+
+// CompressionAlgorithm is the algorithm of the compressed protocol negotiated with a client.
+enum class CompressionAlgorithm : uint8_t {
+    None,
+    Zlib,
+    Zstd,
+};
+
+// zstdSupported tells whether the server was built with zstd.
+#ifdef PXTIDB_HAVE_ZSTD
+constexpr bool zstdSupported = true;
+#else
+constexpr bool zstdSupported = false;
+#endif
+
+// compressedHeaderSize is the size of the header of a compressed packet: the 3-byte length of the payload, the
+// 1-byte compressed sequence id and the 3-byte length of the payload before compression, 0 if it is not compressed.
+// See https://dev.mysql.com/doc/internals/en/compressed-packet-header.html
+constexpr size_t compressedHeaderSize = 7;
+
+// defaultCompressionThreshold is the payload length below which packets are sent uncompressed, like MySQL's
+// MIN_COMPRESS_LENGTH: compressing them costs CPU and saves nothing.
+constexpr size_t defaultCompressionThreshold = 50;
+
+// defaultZstdCompressionLevel is the zstd level used when the client does not ask for one.
+constexpr int defaultZstdCompressionLevel = 3;
+
+// CompressionStats counts the traffic of a connection using the compressed protocol.
+struct CompressionStats {
+    // BytesWritten is the size of the packets written, WireBytesWritten the size of the compressed packets that
+    // carried them.
+    uint64_t BytesWritten{0};
+    uint64_t WireBytesWritten{0};
+    // BytesRead and WireBytesRead are the same for the packets read.
+    uint64_t BytesRead{0};
+    uint64_t WireBytesRead{0};
+    // CompressTime and DecompressTime are the CPU time spent compressing and decompressing.
+    std::chrono::nanoseconds CompressTime{0};
+    std::chrono::nanoseconds DecompressTime{0};
+
+    // Ratio returns the compression ratio of the packets written.
+    double Ratio() const {
+        return WireBytesWritten == 0 ? 1 : static_cast<double>(BytesWritten) / static_cast<double>(WireBytesWritten);
+    }
+};
+
+// compressPayload appends src compressed with alg to dst. It returns false if the compression failed.
+// level only applies to zstd, zlib always uses its default level like MySQL.
+// The compression contexts are cached per thread, so that a connection holds none between its commands.
+bool compressPayload(CompressionAlgorithm alg, int level, std::string_view src, std::string &dst);
+
+// decompressPayload replaces dst with src decompressed with alg. It returns false unless that gives exactly
+// uncompressedLen bytes.
+bool decompressPayload(CompressionAlgorithm alg, std::string_view src, size_t uncompressedLen, std::string &dst);
+
+}  // namespace server
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "parser/mysql/const.hh"
+#include "parser/mysql/error.hh"
+#include "server/compress.hh"
+#include "server/driver_tidb.hh"
+#include "server/packetio.hh"
+#include "server/slow_log.hh"
+#include "server/stmt_summary.hh"
+
+namespace server {
+
+class Server;
+
+// defaultCapability is the capability of the server when it is created using the default configuration.
+// ClientSSL is not supported, zstd compression only if it was built in.
+constexpr uint32_t defaultCapability =
+    mysql::ClientLongPassword | mysql::ClientLongFlag | mysql::ClientConnectWithDB | mysql::ClientProtocol41 |
+    mysql::ClientTransactions | mysql::ClientSecureConnection | mysql::ClientFoundRows | mysql::ClientMultiResults |
+    mysql::ClientMultiStatements | mysql::ClientLocalFiles | mysql::ClientConnectAtts | mysql::ClientPluginAuth |
+    mysql::ClientInteractive | mysql::ClientDeprecateEOF | mysql::ClientCompress |
+    (zstdSupported ? mysql::ClientZstdCompressionAlgorithm : 0);
+
+// clientConn represents a connection between server and client, it maintains connection specific state,
+// handles client query.
+// Its methods that do I/O are tasks of the session coroutine, which suspend it in its reactor while the socket would
+// block.
+class clientConn {
+public:
+    clientConn(Server &server, Reactor &reactor, int fd, uint32_t connID);
+
+    // writeInitialHandshake sends the first packet of the handshake, with the server capabilities and the salt.
+    Task<bool> writeInitialHandshake();
+
+    // handshake reads the response to the initial handshake and answers it.
+    // There is no privilege system yet, so every user is accepted.
+    Task<bool> handshake();
+
+    // readPacket reads the next command.
+    Task<bool> readPacket(std::string &data);
+
+    // dispatch handles client request based on command which is the first byte of the data.
+    // It returns false when the connection must be closed.
+    // The statements prefixed with TRACE, and one every Config::TraceSampleRate, are traced: the spans recorded
+    // while the command runs are added to the traces of the server.
+    Task<bool> dispatch(std::string_view data);
+
+    PacketIO &io() { return _pkt; }
+    uint32_t ConnectionID() const { return _connectionID; }
+    uint32_t Capability() const { return _capability; }
+    const std::string &User() const { return _user; }
+    const std::string &DBName() const { return _dbname; }
+
+    // GetCompressionStats returns the traffic counters of the compressed protocol. It may be called from any thread.
+    CompressionStats GetCompressionStats() const { return _pkt.compressionStats(); }
+
+private:
+    // dispatchCommand executes command cmd, data being its payload.
+    Task<bool> dispatchCommand(uint8_t cmd, std::string_view data);
+
+    // stmtResult is how a statement of a COM_QUERY ended.
+    enum class stmtResult : uint8_t {
+        Succeeded,
+        // Failed is a statement which returned an error: it was written, and the rest of the batch is skipped.
+        Failed,
+        // Disconnected is a statement whose response could not be written: the connection must be closed.
+        Disconnected,
+    };
+
+    // handleQuery handles COM_QUERY. A multi-statement batch is split and its statements executed in turn, every
+    // result but the last one flagged with ServerMoreResultsExists. The results are flushed together at the end of
+    // the batch, or by the encoder as they fill the buffer, so the statements do not wait for each other's results
+    // to be sent. The batch stops at the first error, like in MySQL.
+    Task<bool> handleQuery(std::string_view sql);
+
+    // execute runs one statement of a COM_QUERY and writes its error if it fails. The response is flushed if last is
+    // set, or if the statement failed, which ends the batch. parseTime is the time it took to split the batch.
+    Task<stmtResult> execute(std::string_view sql, std::chrono::nanoseconds parseTime, bool last);
+
+    // executePrepared handles COM_STMT_EXECUTE.
+    Task<bool> executePrepared(std::string_view data);
+
+    // finishStatement reports the statement that just ran to the statement summary, and to the slow query log if it
+    // took at least the slow threshold. prepared is the statement executed by COM_STMT_EXECUTE, if it was found.
+    void finishStatement(StmtExecInfo &info, std::chrono::nanoseconds writeTime, const TiDBStatement *prepared);
+
+    Task<bool> writeOK();
+    // respond writes err if the command failed, and flushes the response.
+    Task<bool> respond(const std::optional<mysql::SQLError> &err);
+
+    Server &_server;
+    PacketIO _pkt;
+    uint32_t _connectionID;
+    uint32_t _capability{defaultCapability};
+    std::string _salt;
+    std::string _user;
+    std::string _dbname;
+    TiDBContext _ctx;
+};
+
+}  // namespace server
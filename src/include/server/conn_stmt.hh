@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "parser/mysql/error.hh"
+#include "server/driver_tidb.hh"
+#include "server/packetio.hh"
+
+namespace server {
+
+// StmtExecutor runs a prepared statement with the parameters in stmt.Params() and writes its result to io: a binary
+// result set or an OK packet. It returns the error of a statement that fails instead, which the connection writes; one
+// whose result could not be written fails with ErrNetErrorOnWrite, and the connection is closed when writing that error
+// fails too.
+using StmtExecutor = std::function<Task<std::optional<mysql::SQLError>>(PacketIO &io, TiDBStatement &stmt)>;
+
+// The handlers of the prepared statement commands take the command payload without the command byte.
+// They write the response of a command that succeeds and return the error of one that fails, for the connection to
+// write; it flushes the response.
+
+// handleStmtPrepare handles COM_STMT_PREPARE.
+std::optional<mysql::SQLError> handleStmtPrepare(PacketIO &io, TiDBContext &ctx, uint32_t capability,
+                                                 const std::string &sql);
+
+// handleStmtExecute handles COM_STMT_EXECUTE: it binds the parameters and hands the statement to exec.
+Task<std::optional<mysql::SQLError>> handleStmtExecute(PacketIO &io, TiDBContext &ctx, std::string_view data,
+                                                       const StmtExecutor &exec);
+
+// handleStmtSendLongData handles COM_STMT_SEND_LONG_DATA, which has no response.
+void handleStmtSendLongData(TiDBContext &ctx, std::string_view data);
+
+// handleStmtReset handles COM_STMT_RESET.
+std::optional<mysql::SQLError> handleStmtReset(PacketIO &io, TiDBContext &ctx, uint32_t capability,
+                                               std::string_view data);
+
+// handleStmtClose handles COM_STMT_CLOSE, which has no response.
+void handleStmtClose(TiDBContext &ctx, std::string_view data);
+
+// parseExecArgs decodes the parameter values of a COM_STMT_EXECUTE in the binary protocol into args.
+// Parameters sent by COM_STMT_SEND_LONG_DATA are taken from boundParams.
+std::optional<mysql::SQLError> parseExecArgs(std::vector<StmtParam> &args,
+                                             const std::vector<std::optional<std::string>> &boundParams,
+                                             std::string_view nullBitmap, std::string_view paramTypes,
+                                             std::string_view paramValues);
+
+}  // namespace server
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "parser/digester.hh"
+#include "parser/mysql/const.hh"
+#include "parser/mysql/error.hh"
+#include "planner/core/plan_cache.hh"
+
+namespace server {
+
+// StmtParam is the value of a parameter bound by COM_STMT_EXECUTE, std::monostate standing for NULL.
+// Temporal and decimal values are kept in their canonical text form, e.g. "2021-10-28 10:11:12.000123".
+using StmtParam = std::variant<std::monostate, int64_t, uint64_t, double, std::string>;
+
+// TiDBStatement is a statement prepared by a session.
+// The lexed statement is the immutable template shared through the plan cache; the statement only adds what is
+// private to the session: its id and the parameters of the execution.
+class TiDBStatement {
+public:
+    TiDBStatement(uint32_t id, std::string sql, std::shared_ptr<const planner::core::PlanCacheStmt> stmt);
+
+    // ID returns statement ID
+    uint32_t ID() const { return _id; }
+
+    // SQL returns the text the statement was prepared from.
+    const std::string &SQL() const { return _sql; }
+
+    // Template returns the shared template of the statement.
+    const planner::core::PlanCacheStmt &Template() const { return *_stmt; }
+    const std::shared_ptr<const planner::core::PlanCacheStmt> &SharedTemplate() const { return _stmt; }
+
+    // NumParams returns number of parameters.
+    size_t NumParams() const { return _stmt->NumParams(); }
+
+    // AppendParam implements PreparedStatement AppendParam method, for COM_STMT_SEND_LONG_DATA.
+    bool AppendParam(size_t paramID, std::string_view data);
+
+    // BoundParams returns the parameters sent by COM_STMT_SEND_LONG_DATA.
+    const std::vector<std::optional<std::string>> &BoundParams() const { return _boundParams; }
+
+    // SetParamsType sets the parameter types: a type byte and a flag byte per parameter, as sent by the first
+    // COM_STMT_EXECUTE. Later executions may omit them.
+    void SetParamsType(std::string_view paramsType) { _paramsType = paramsType; }
+    const std::string &GetParamsType() const { return _paramsType; }
+
+    // Params returns the parameter values of the current execution.
+    std::vector<StmtParam> &Params() { return _params; }
+    const std::vector<StmtParam> &Params() const { return _params; }
+
+    // Reset removes all bound parameters.
+    void Reset();
+
+private:
+    uint32_t _id;
+    std::string _sql;
+    std::shared_ptr<const planner::core::PlanCacheStmt> _stmt;
+    std::vector<std::optional<std::string>> _boundParams;
+    std::string _paramsType;
+    std::vector<StmtParam> _params;
+};
+
+// StatementContext is what the executor reports about the statement it runs, for the slow query log and the
+// statement summary.
+struct StatementContext {
+    // OriginalSQL is the text of the statement.
+    std::string_view OriginalSQL;
+    // ResultRows is the number of rows returned or affected.
+    uint64_t ResultRows{0};
+    // ExaminedRows is the number of rows read to compute them.
+    uint64_t ExaminedRows{0};
+    // MemMax is the peak memory used, in bytes.
+    uint64_t MemMax{0};
+
+    // SQLDigest returns the normalized OriginalSQL and its digest. They are only computed the first time they are
+    // needed, then shared by the executor, the statement summary and the slow query log.
+    std::tuple<std::string_view, parser::Digest> SQLDigest();
+
+private:
+    std::string _normalizedSQL;
+    std::optional<parser::Digest> _digest;
+};
+
+// TiDBContext holds the session state the connection needs: its prepared statements, server status and SQL mode.
+class TiDBContext {
+public:
+    // Prepare prepares a statement and returns it, or the error that made the statement text invalid.
+    std::tuple<TiDBStatement *, std::optional<mysql::SQLError>> Prepare(const std::string &sql);
+
+    // GetStatement gets PreparedStatement by statement ID, nullptr if there is none.
+    TiDBStatement *GetStatement(uint32_t stmtID);
+
+    // CloseStatement deallocates a prepared statement.
+    void CloseStatement(uint32_t stmtID) { _stmts.erase(stmtID); }
+
+    size_t NumStatements() const { return _stmts.size(); }
+
+    // Status returns server status code.
+    uint16_t Status() const { return _status; }
+    void SetStatus(uint16_t status) { _status = status; }
+
+    mysql::SQLMode GetSQLMode() const { return _sqlMode; }
+    void SetSQLMode(mysql::SQLMode mode) { _sqlMode = mode; }
+
+    // StmtCtx returns the context of the statement being executed. The connection resets it before every statement.
+    StatementContext &StmtCtx() { return _stmtCtx; }
+
+private:
+    uint32_t _preparedStmtID{0};
+    std::unordered_map<uint32_t, std::unique_ptr<TiDBStatement>> _stmts;
+    uint16_t _status{mysql::ServerStatusAutocommit};
+    mysql::SQLMode _sqlMode{mysql::ModeNone};
+    StatementContext _stmtCtx;
+};
+
+}  // namespace server
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "server/compress.hh"
+#include "server/scheduler.hh"
+
+namespace server {
+
+// defaultWriterSize is the capacity of a connection's write buffer.
+// Result rows are encoded straight into it and it is flushed to the socket whenever it fills up.
+constexpr size_t defaultWriterSize = 16 * 1024;
+
+// packetHeaderSize is the size of the 3-byte length + 1-byte sequence header of every packet.
+constexpr size_t packetHeaderSize = 4;
+
+// PacketBuffer accumulates framed packets in a fixed-capacity buffer until its owner flushes them.
+// It is the only place that assigns sequence ids to outgoing packets.
+// The storage is allocated on first use and given back by release(), so that idle connections hold none.
+class PacketBuffer {
+public:
+    explicit PacketBuffer(size_t capacity = defaultWriterSize);
+
+    // reservePacket writes the header of a packet with a payloadLen byte payload and returns the payload area,
+    // which the caller must fill completely. It returns nullptr if the packet does not fit into the space left;
+    // the caller should then flush and retry. payloadLen must be smaller than mysql::MaxPayloadLen.
+    uint8_t *reservePacket(size_t payloadLen);
+
+    // appendPacket frames payload as one or more packets, splitting it at mysql::MaxPayloadLen.
+    // Unlike reservePacket it never fails: the buffer grows beyond its capacity if needed.
+    void appendPacket(std::string_view payload);
+
+    // ensureRoomFor grows an empty buffer so that a single packet of payloadLen bytes fits.
+    // It is used for the rare row that is larger than the whole buffer.
+    void ensureRoomFor(size_t payloadLen);
+
+    const uint8_t *data() const { return _buf.data(); }
+    size_t size() const { return _len; }
+    bool empty() const { return _len == 0; }
+    size_t capacity() const { return _buf.size(); }
+    size_t available() const { return _buf.size() - _len; }
+
+    // clear drops the buffered bytes after they have been flushed, shrinking a buffer that grew for an oversized
+    // packet back to its configured capacity.
+    void clear();
+
+    // release frees the storage of an empty buffer. It is allocated again by the next packet.
+    void release();
+
+    uint8_t sequence() const { return _sequence; }
+    void setSequence(uint8_t sequence) { _sequence = sequence; }
+
+private:
+    void allocate() {
+        if (_buf.empty()) {
+            _buf.resize(_capacity);
+        }
+    }
+
+    void putHeader(uint8_t *p, size_t payloadLen) {
+        p[0] = static_cast<uint8_t>(payloadLen);
+        p[1] = static_cast<uint8_t>(payloadLen >> 8);
+        p[2] = static_cast<uint8_t>(payloadLen >> 16);
+        p[3] = _sequence++;
+    }
+
+    std::vector<uint8_t> _buf;
+    size_t _len{0};
+    size_t _capacity;
+    uint8_t _sequence{0};
+};
+
+// PacketIO is a helper to read and write MySQL packets on a socket.
+// When a non-blocking socket would block in the middle of a packet, the reads and flushes suspend the session's
+// coroutine until the reactor sees the socket ready, so that the worker serves other sessions meanwhile. A PacketIO
+// without a reactor is for a blocking socket: its tasks complete without suspending and may be Run.
+//
+// Once compression is set, the packets are carried by compressed packets. Compression runs in flush() and
+// decompression in readPacket(), that is on the session's worker, never on a reactor.
+class PacketIO {
+public:
+    explicit PacketIO(int fd, Reactor *reactor = nullptr) : _fd(fd), _reactor(reactor) {}
+
+    // readPacket reads one logical packet, joining the chunks of payloads larger than mysql::MaxPayloadLen.
+    // It returns false on EOF, a socket error or a packet sequence mismatch.
+    Task<bool> readPacket(std::string &data);
+
+    // writePacket buffers payload. The buffer grows if it does not fit: the rows of a result set, which make up
+    // most of the output, are flushed by the encoder as it fills the buffer.
+    void writePacket(std::string_view payload);
+
+    // flush writes all the buffered packets to the socket.
+    Task<bool> flush();
+
+    PacketBuffer &buffer() { return _buffer; }
+
+    uint8_t sequence() const { return _buffer.sequence(); }
+    void setSequence(uint8_t sequence) { _buffer.setSequence(sequence); }
+
+    // resetSequence starts the packet sequences of a new command.
+    void resetSequence() {
+        _buffer.setSequence(0);
+        _compressedSequence = 0;
+    }
+
+    // setCompression switches to the compressed protocol. Chunks of the packets written shorter than threshold
+    // are sent uncompressed. level is the zstd compression level.
+    void setCompression(CompressionAlgorithm alg, int level = defaultZstdCompressionLevel,
+                        size_t threshold = defaultCompressionThreshold);
+    CompressionAlgorithm compression() const { return _compression; }
+
+    // compressionStats may be called from any thread.
+    CompressionStats compressionStats() const;
+
+    // hasBufferedInput tells whether bytes that were read from the socket are waiting to be consumed, as happens
+    // when a compressed packet carries several commands.
+    bool hasBufferedInput() const { return _readPos < _readBuf.length(); }
+
+    // ioTime returns the total time spent reading and writing the socket, the suspensions for a socket that would
+    // block included.
+    std::chrono::nanoseconds ioTime() const { return _ioTime; }
+
+    // release frees the buffers of an idle connection. The input that has not been consumed yet is kept.
+    void release();
+
+    int fd() const { return _fd; }
+
+private:
+    Task<bool> readFull(uint8_t *p, size_t n);
+    Task<bool> readSocket(uint8_t *p, size_t n);
+    Task<bool> writeSocket(const uint8_t *p, size_t n);
+    // wait suspends the session until the socket has one of events, which must be awaited after it returned EAGAIN.
+    // It returns false if there is no reactor to wait in.
+    Task<bool> wait(short events);
+
+    Task<bool> readCompressedPacket();
+    Task<bool> flushCompressed();
+
+    int _fd;
+    Reactor *_reactor;
+    PacketBuffer _buffer;
+    std::chrono::nanoseconds _ioTime{0};
+
+    CompressionAlgorithm _compression{CompressionAlgorithm::None};
+    int _compressionLevel{defaultZstdCompressionLevel};
+    size_t _compressionThreshold{defaultCompressionThreshold};
+    uint8_t _compressedSequence{0};
+    // _compressed is the scratch buffer of the compressed packets, _readBuf the decompressed input.
+    std::string _compressed;
+    std::string _readBuf;
+    size_t _readPos{0};
+
+    std::atomic<uint64_t> _bytesWritten{0};
+    std::atomic<uint64_t> _wireBytesWritten{0};
+    std::atomic<uint64_t> _bytesRead{0};
+    std::atomic<uint64_t> _wireBytesRead{0};
+    std::atomic<int64_t> _compressNanos{0};
+    std::atomic<int64_t> _decompressNanos{0};
+};
+
+}  // namespace server
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "parser/mysql/error.hh"
+#include "server/column.hh"
+#include "server/packetio.hh"
+#include "server/util.hh"
+#include "util/chunk/chunk.hh"
+
+namespace server {
+
+// ColumnVector is a read-only view of one column of a batch of result rows.
+//
+// Integer columns hold int64_t values (uint64_t when the column has mysql::UnsignedFlag), TypeFloat columns hold
+// float and TypeDouble columns hold double, all stored contiguously in data. Every other type is var-length:
+// value i is data[offsets[i], offsets[i+1]) in its text form, e.g. "2021-10-28 10:00:00" for a DATETIME.
+// Nulls are a validity bitmap in which a set bit means "not null"; a nullptr bitmap means the column has no nulls.
+// This is the layout of an Arrow array, so batches can be handed to the encoder without copying.
+struct ColumnVector {
+    const uint8_t *nullBitmap{nullptr};
+    const void *data{nullptr};
+    const int64_t *offsets{nullptr};
+
+    bool isNull(size_t row) const { return nullBitmap != nullptr && (nullBitmap[row >> 3] & (1u << (row & 7))) == 0; }
+};
+
+// ColumnBatch is a batch of result rows handed to the encoder column by column.
+struct ColumnBatch {
+    std::vector<ColumnVector> columns;
+    size_t numRows{0};
+};
+
+// ColumnBatchOf returns the view of the rows of chk, whose columns have the layout of the column vectors. chk must
+// have no selection vector: a filtered chunk is compacted first.
+ColumnBatch ColumnBatchOf(const util::chunk::Chunk &chk);
+
+// ResultSetEncoder writes result sets in the text protocol (COM_QUERY) and the binary protocol (COM_STMT_EXECUTE).
+//
+// Rows are encoded column-at-a-time: a first pass over each column computes every row's packet size, so the type
+// dispatch happens once per column instead of once per value; the packets are then reserved in the write buffer and
+// a second pass over each column scatters the values into them. Encoding stops when the write buffer is full and
+// reports how many rows were written, so that writeRows resumes at that row once the buffer is flushed, the session
+// being suspended meanwhile if the socket is full.
+class ResultSetEncoder {
+public:
+    // batchRows bounds the number of rows encoded per pass, and therefore the encoder's scratch memory.
+    static constexpr size_t batchRows = 1024;
+
+    ResultSetEncoder(const std::vector<ColumnInfo> &columns, uint32_t capability);
+
+    // writeColumnInfo writes the column count packet and the column definitions, followed by an EOF packet unless
+    // the client set mysql::ClientDeprecateEOF.
+    void writeColumnInfo(PacketIO &io, uint16_t serverStatus);
+
+    // encodeTextRows encodes the rows of batch starting at row begin as text protocol rows into buffer.
+    // It returns the index of the first row that was not encoded; if that is less than batch.numRows the buffer is
+    // full and must be flushed before calling again.
+    size_t encodeTextRows(PacketBuffer &buffer, const ColumnBatch &batch, size_t begin);
+
+    // encodeBinaryRows is encodeTextRows for the binary protocol row format with its leading null bitmap.
+    size_t encodeBinaryRows(PacketBuffer &buffer, const ColumnBatch &batch, size_t begin);
+
+    // writeRows encodes every row of batch, flushing io whenever its buffer fills up.
+    Task<bool> writeRows(PacketIO &io, const ColumnBatch &batch, bool binary);
+
+    // writeEOF terminates the rows of a result set with serverStatus, which carries mysql::ServerMoreResultsExists
+    // when another result follows and the cursor flags for COM_STMT_FETCH. Clients that set
+    // mysql::ClientDeprecateEOF get an OK packet with the EOF header instead.
+    void writeEOF(PacketIO &io, uint16_t serverStatus, uint16_t warnings = 0);
+
+    const std::vector<ColumnInfo> &columns() const { return _columns; }
+
+private:
+    // reserveRows reserves the packets of the n rows whose payload sizes are in _rowLen and records where each
+    // payload starts in _cursors. It returns how many rows fitted into the buffer, 0 meaning it must be flushed.
+    // n is lowered to stop before a row too large for a single packet; such a row is reserved alone in oversizedRow.
+    size_t reserveRows(PacketBuffer &buffer, size_t &n, std::string &oversizedRow);
+
+    // columnScratch holds what the sizing pass computed for a column and the write pass still needs: the text of
+    // float values (text protocol) or the binary form of temporal values (binary protocol).
+    struct columnScratch {
+        std::string text;
+        std::vector<uint32_t> textEnd;
+        std::vector<BinaryTime> times;
+    };
+
+    std::vector<ColumnInfo> _columns;
+    // _kinds is the storage kind of each column, resolved once from its type.
+    std::vector<uint8_t> _kinds;
+    uint32_t _capability;
+
+    // Per-pass scratch, reused across calls.
+    std::vector<uint32_t> _rowLen;
+    std::vector<uint8_t *> _cursors;
+    std::vector<uint8_t *> _rowStarts;
+    std::vector<columnScratch> _scratch;
+};
+
+// writeOK writes an OK packet with the given counters and server status.
+void writeOK(PacketIO &io, uint32_t capability, uint64_t affectedRows, uint64_t lastInsertID, uint16_t serverStatus,
+             uint16_t warnings, std::string_view info = {});
+
+// writeEOF writes an EOF packet, or an OK packet with the EOF header if the client set mysql::ClientDeprecateEOF.
+void writeEOF(PacketIO &io, uint32_t capability, uint16_t serverStatus, uint16_t warnings = 0);
+
+// writeError writes an error packet.
+void writeError(PacketIO &io, uint32_t capability, const mysql::SQLError &err);
+
+}  // namespace server
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <event2/event.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace server {
+
+// DetachedTask is a coroutine that nobody awaits. It starts suspended so that its creator can hand it to a
+// Scheduler, and frees its frame when it returns.
+class DetachedTask {
+public:
+    struct promise_type {
+        DetachedTask get_return_object() {
+            return DetachedTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    std::coroutine_handle<> handle() const { return _handle; }
+
+private:
+    explicit DetachedTask(std::coroutine_handle<> handle) : _handle(handle) {}
+
+    std::coroutine_handle<> _handle;
+};
+
+// Task is a coroutine that returns a T to the coroutine awaiting it. It starts when it is awaited, and resumes its
+// awaiter on the thread it completes on, so that a session suspended in the middle of a command by a socket that
+// would block holds no worker.
+template <typename T>
+class Task {
+public:
+    struct promise_type {
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept {
+            struct resumeAwaiter {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                    auto continuation = h.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+                void await_resume() noexcept {}
+            };
+            return resumeAwaiter{};
+        }
+        void return_value(T v) { value = std::move(v); }
+        void unhandled_exception() { std::terminate(); }
+
+        T value{};
+        std::coroutine_handle<> continuation;
+    };
+
+    Task(Task &&t) noexcept : _handle(std::exchange(t._handle, nullptr)) {}
+    Task &operator=(Task &&t) noexcept {
+        std::swap(_handle, t._handle);
+        return *this;
+    }
+    ~Task() {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        _handle.promise().continuation = awaiter;
+        return _handle;
+    }
+    T await_resume() { return std::move(_handle.promise().value); }
+
+    // Run runs the task on the calling thread. It must complete without suspending, as the I/O of a PacketIO
+    // without a reactor does, on a blocking socket.
+    T Run() {
+        _handle.resume();
+        if (!_handle.done()) {
+            std::terminate();
+        }
+        return std::move(_handle.promise().value);
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+    std::coroutine_handle<promise_type> _handle;
+};
+
+// Scheduler resumes coroutines on a fixed pool of worker threads.
+// Every worker has its own queue: it runs the newest coroutine of its queue first, and steals the oldest one of
+// another worker when its queue is empty.
+class Scheduler {
+public:
+    explicit Scheduler(int numWorkers);
+
+    // The destructor runs the coroutines still queued, then stops the workers.
+    ~Scheduler();
+
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    // Schedule queues h to be resumed by a worker. A worker queues on its own queue, other threads spread the
+    // coroutines over the workers round-robin.
+    void Schedule(std::coroutine_handle<> h);
+
+    int NumWorkers() const { return static_cast<int>(_workers.size()); }
+
+private:
+    struct worker {
+        std::mutex mu;
+        std::deque<std::coroutine_handle<>> queue;
+    };
+
+    void run(size_t id);
+
+    // pop takes a coroutine from the queue of worker id, or steals one. It returns nullptr if all queues are empty.
+    std::coroutine_handle<> pop(size_t id);
+
+    std::vector<std::unique_ptr<worker>> _workers;
+    std::vector<std::thread> _threads;
+    std::atomic<size_t> _nextWorker{0};
+
+    // _queued counts the coroutines in all the queues; idle workers sleep on _idle until it is not 0.
+    std::atomic<int64_t> _queued{0};
+    std::atomic<int> _sleeping{0};
+    std::mutex _mu;
+    std::condition_variable _idle;
+    bool _stopped{false};
+};
+
+class Reactor;
+
+// fdAwaiter suspends a coroutine until its socket is ready. await_resume returns the libevent events that fired.
+class fdAwaiter {
+public:
+    fdAwaiter(Reactor &reactor, int fd, short events) : _reactor(reactor), _fd(fd), _events(events) {}
+
+    bool await_ready() const { return false; }
+    bool await_suspend(std::coroutine_handle<> h);
+    short await_resume() const { return _events; }
+
+private:
+    friend class Reactor;
+
+    Reactor &_reactor;
+    int _fd;
+    short _events;
+    std::coroutine_handle<> _handle;
+};
+
+// Reactor runs a libevent loop in its own thread. It only waits for sockets and hands the ready coroutines to the
+// Scheduler: session code never runs on it, so a long query cannot hold up the other connections of the reactor.
+class Reactor {
+public:
+    explicit Reactor(Scheduler &scheduler);
+    ~Reactor();
+
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    // WaitFor returns an awaitable that resumes the coroutine on a worker once fd has one of the events
+    // (EV_READ, EV_WRITE) pending. It may be awaited from any thread.
+    fdAwaiter WaitFor(int fd, short events) { return {*this, fd, events}; }
+
+    event_base *base() const { return _base; }
+
+    // Stop stops the event loop, the base staying valid until the reactor is destroyed.
+    void Stop();
+
+private:
+    friend class fdAwaiter;
+
+    static void onReady(evutil_socket_t fd, short events, void *arg);
+
+    Scheduler &_scheduler;
+    event_base *_base;
+    std::thread _thread;
+};
+
+}  // namespace server
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <event2/http.h>
+#include <event2/listener.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/tracing.hh"
+#include "parser/mysql/error.hh"
+#include "server/compress.hh"
+#include "server/conn_stmt.hh"
+#include "server/driver_tidb.hh"
+#include "server/packetio.hh"
+#include "server/scheduler.hh"
+#include "server/slow_log.hh"
+#include "server/stmt_summary.hh"
+
+namespace server {
+
+class clientConn;
+
+// Config is the configuration of the MySQL protocol server.
+struct Config {
+    std::string Host{"0.0.0.0"};
+    // Port 0 binds an ephemeral port, see Server::Port.
+    uint16_t Port{4000};
+    // NumWorkers is the number of threads running the sessions: reading, executing and answering commands.
+    int NumWorkers{static_cast<int>(std::thread::hardware_concurrency())};
+    // NumReactors is the number of threads waiting for the sockets. Connections are spread over them round-robin.
+    int NumReactors{1};
+    // ReportStatus enables the HTTP status server, which exports the metrics in the Prometheus format at /metrics.
+    // It runs on the first reactor, next to the MySQL listener.
+    bool ReportStatus{true};
+    std::string StatusHost{"0.0.0.0"};
+    uint16_t StatusPort{10080};
+    // SlowQueryFile is the path of the slow query log, empty to disable it. The statements that take at least
+    // SlowThreshold are logged there.
+    std::string SlowQueryFile{"tidb-slow.log"};
+    std::chrono::milliseconds SlowThreshold{300};
+    // EnableStmtSummary aggregates the statements by digest, see StmtSummary. The status server serves the summary
+    // at /statements_summary and /statements_summary_history.
+    bool EnableStmtSummary{true};
+    std::chrono::seconds StmtSummaryRefreshInterval{StmtSummary::defaultRefreshInterval};
+    size_t StmtSummaryHistorySize{StmtSummary::defaultHistorySize};
+    size_t StmtSummaryMaxStmtCount{StmtSummary::defaultMaxStmtCount};
+    size_t StmtSummaryMaxSQLLength{StmtSummary::defaultMaxSQLLength};
+    // TraceSampleRate traces one statement every TraceSampleRate on each worker, none if it is 0. Statements prefixed
+    // with TRACE are always traced. The status server serves the last MaxTraces traces at /debug/trace in the Chrome
+    // trace event format.
+    uint32_t TraceSampleRate{0};
+    size_t MaxTraces{common::tracing::TraceLog::defaultCapacity};
+    // CompressionThreshold is the length below which the compressed protocol sends payloads uncompressed.
+    size_t CompressionThreshold{defaultCompressionThreshold};
+};
+
+// QueryExecutor runs a statement of a COM_QUERY and writes its result to io: a result set or an OK packet. It returns
+// the error of a statement that fails instead, like StmtExecutor.
+using QueryExecutor = std::function<Task<std::optional<mysql::SQLError>>(PacketIO &io, TiDBContext &ctx,
+                                                                         uint32_t capability, std::string_view sql)>;
+
+// Server is the MySQL protocol server.
+// Every connection is served by a coroutine that reads a command, executes it and writes the response on one of
+// the scheduler's workers, then parks in a reactor until the next command arrives. A parked connection holds no
+// thread and no buffer, only its coroutine frame and session state.
+class Server {
+public:
+    explicit Server(Config cfg);
+    ~Server();
+
+    Server(const Server &) = delete;
+    Server &operator=(const Server &) = delete;
+
+    // SetQueryExecutor and SetStmtExecutor install the executors of the sessions. They must be called before Start.
+    void SetQueryExecutor(QueryExecutor exec) { _queryExecutor = std::move(exec); }
+    void SetStmtExecutor(StmtExecutor exec) { _stmtExecutor = std::move(exec); }
+
+    // Start binds the listening sockets and starts accepting connections.
+    // It returns false if an address cannot be listened on.
+    bool Start();
+
+    // Close stops accepting connections, closes the open ones and waits for their sessions to end.
+    void Close();
+
+    // Port returns the port the server listens on.
+    uint16_t Port() const { return _port; }
+
+    // StatusPort returns the port of the HTTP status server.
+    uint16_t StatusPort() const { return _statusPort; }
+
+    // NumConnections returns the number of open connections.
+    size_t NumConnections() const;
+
+    // ConnCompressionStats returns the compression stats of the open connections by connection id. They are zero
+    // for the connections that do not use the compressed protocol.
+    std::unordered_map<uint32_t, CompressionStats> ConnCompressionStats() const;
+
+    // Traces returns the last traces.
+    const common::tracing::TraceLog &Traces() const { return _traces; }
+
+    // GetStmtSummary returns the statement summary, null if it is disabled.
+    StmtSummary *GetStmtSummary() { return _stmtSummary.get(); }
+
+private:
+    friend class clientConn;
+
+    static void onAccept(evconnlistener *listener, evutil_socket_t fd, sockaddr *addr, int socklen, void *arg);
+    static void onMetrics(evhttp_request *req, void *arg);
+    static void onStmtSummary(evhttp_request *req, void *arg);
+    static void onStmtSummaryHistory(evhttp_request *req, void *arg);
+    static void onTrace(evhttp_request *req, void *arg);
+
+    bool startStatus();
+
+    DetachedTask runSession(Reactor &reactor, int fd, uint32_t connID);
+
+    void setConn(int fd, clientConn *cc);
+    void onConnClosed(int fd);
+
+    Config _cfg;
+    QueryExecutor _queryExecutor;
+    StmtExecutor _stmtExecutor;
+
+    Scheduler _scheduler;
+    std::unique_ptr<SlowQueryLogger> _slowLog;
+    std::unique_ptr<StmtSummary> _stmtSummary;
+    common::tracing::TraceLog _traces;
+    std::vector<std::unique_ptr<Reactor>> _reactors;
+    evconnlistener *_listener{nullptr};
+    uint16_t _port{0};
+    evhttp *_status{nullptr};
+    uint16_t _statusPort{0};
+
+    // Only the accepting reactor thread touches these.
+    uint32_t _baseConnID{0};
+    size_t _nextReactor{0};
+
+    mutable std::mutex _mu;
+    std::condition_variable _connsClosed;
+    // _conns maps the open descriptors to their connections, null until the session starts and after it ends.
+    std::unordered_map<int, clientConn *> _conns;
+    bool _closing{false};
+};
+
+}  // namespace server
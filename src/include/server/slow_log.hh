@@ -0,0 +1,88 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "common/mpsc_ring.hh"
+#include "parser/digester.hh"
+
+namespace server {
+
+// SlowQueryRecord is an entry of the slow query log. It has a fixed size so that it can be pushed into a ring
+// without allocating: the normalized statement is truncated to maxSQLLen bytes.
+struct SlowQueryRecord {
+    static constexpr size_t maxSQLLen = 384;
+
+    std::chrono::system_clock::time_point Time;
+    uint32_t ConnID{0};
+    bool Succ{true};
+    bool Prepared{false};
+    parser::Digest Digest;
+    // QueryTime is the time of the statement, from its parsing to the end of its response. ParseTime, ExecuteTime
+    // and WriteTime are its parts: splitting the batch it belongs to, running the executor and writing the response.
+    std::chrono::nanoseconds QueryTime{0};
+    std::chrono::nanoseconds ParseTime{0};
+    std::chrono::nanoseconds ExecuteTime{0};
+    std::chrono::nanoseconds WriteTime{0};
+    uint64_t ResultRows{0};
+    uint64_t MemMax{0};
+    uint16_t SQLLen{0};
+    char SQL[maxSQLLen];
+
+    void SetSQL(std::string_view sql);
+    std::string_view GetSQL() const { return {SQL, SQLLen}; }
+};
+
+// SlowQueryLogger writes the slow query log in TiDB's format.
+// Sessions push records into a lock-free ring and a background thread drains it to the log file in batches, so a
+// session never waits for the disk nor for another session: when the ring is full the record is dropped and
+// counted in the pxtidb_server_slow_query_dropped_total metric.
+class SlowQueryLogger {
+public:
+    // ringSize is the number of records the ring holds.
+    static constexpr size_t ringSize = 1024;
+
+    // file is the path of the log file, flushInterval the longest time a record waits in the ring.
+    explicit SlowQueryLogger(const std::string &file,
+                             std::chrono::milliseconds flushInterval = std::chrono::milliseconds(100));
+    // The destructor writes the records still in the ring.
+    ~SlowQueryLogger();
+
+    SlowQueryLogger(const SlowQueryLogger &) = delete;
+    SlowQueryLogger &operator=(const SlowQueryLogger &) = delete;
+
+    // Log queues a record. It may be called from any thread and never blocks.
+    bool Log(const SlowQueryRecord &record);
+
+    // Flush waits until the records queued before the call are written.
+    void Flush();
+
+private:
+    void run();
+    // drain writes the queued records, returning how many there were.
+    size_t drain();
+
+    std::shared_ptr<spdlog::logger> _logger;
+    std::chrono::milliseconds _flushInterval;
+    common::MPSCRing<SlowQueryRecord, ringSize> _ring;
+    std::atomic<uint64_t> _pushed{0};
+
+    // _mu guards the state of the background thread, the sessions never take it.
+    std::mutex _mu;
+    std::condition_variable _cond;
+    uint64_t _written{0};
+    bool _flushRequested{false};
+    bool _stopped{false};
+    std::thread _thread;
+};
+
+}  // namespace server
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "libcuckoo/cuckoohash_map.hh"
+#include "parser/digester.hh"
+
+namespace server {
+
+// StmtExecInfo describes an execution of a statement, as reported to the statement summary.
+struct StmtExecInfo {
+    parser::Digest Digest;
+    std::string_view SchemaName;
+    std::string_view NormalizedSQL;
+    // SampleSQL is the statement text, before normalization.
+    std::string_view SampleSQL;
+    bool Prepared{false};
+    std::chrono::system_clock::time_point StartTime;
+    // Latency is the time of the statement, from its parsing to the end of its response. ParseLatency and
+    // ExecLatency are its parts spent splitting the batch it belongs to and running the executor.
+    std::chrono::nanoseconds Latency{0};
+    std::chrono::nanoseconds ParseLatency{0};
+    std::chrono::nanoseconds ExecLatency{0};
+    uint64_t ExaminedRows{0};
+    uint64_t ResultRows{0};
+    uint64_t MemMax{0};
+    // ErrorCode is the code of the error the statement returned, 0 if it succeeded.
+    uint16_t ErrorCode{0};
+};
+
+// StmtSummaryStats aggregates the executions of a statement during a window.
+struct StmtSummaryStats {
+    // SampleSQL is the text of the first execution of the window.
+    std::string SampleSQL;
+    bool Prepared{false};
+    uint64_t ExecCount{0};
+    std::chrono::nanoseconds SumLatency{0};
+    std::chrono::nanoseconds MaxLatency{0};
+    std::chrono::nanoseconds MinLatency{0};
+    std::chrono::nanoseconds SumParseLatency{0};
+    std::chrono::nanoseconds SumExecLatency{0};
+    uint64_t SumExaminedRows{0};
+    uint64_t MaxExaminedRows{0};
+    uint64_t SumResultRows{0};
+    uint64_t MaxResultRows{0};
+    uint64_t SumMem{0};
+    uint64_t MaxMem{0};
+    uint64_t SumErrors{0};
+    // Errors counts the failed executions by error code.
+    std::vector<std::pair<uint16_t, uint64_t>> Errors;
+    std::chrono::system_clock::time_point FirstSeen;
+    std::chrono::system_clock::time_point LastSeen;
+    // LatencyBuckets is the distribution of the latencies in microseconds, in the buckets of metrics::Histogram. It
+    // only grows up to the bucket of the largest latency seen.
+    std::vector<uint32_t> LatencyBuckets;
+
+    // Add accounts for an execution, truncating its sample to maxSQLLength bytes.
+    void Add(const StmtExecInfo &info, size_t maxSQLLength);
+    // Merge adds the executions of other.
+    void Merge(const StmtSummaryStats &other);
+    // LatencyPercentile returns the q (0 < q <= 1) percentile of the latencies, up to the precision of the buckets.
+    std::chrono::nanoseconds LatencyPercentile(double q) const;
+};
+
+// StmtSummaryRecord is a row of the statement summary: the executions of a digest in a schema during a window.
+// The executions of the statements evicted from the summary are merged into the "others" record of their window,
+// which has an empty digest.
+struct StmtSummaryRecord {
+    std::chrono::system_clock::time_point Begin;
+    std::chrono::system_clock::time_point End;
+    parser::Digest Digest;
+    std::string SchemaName;
+    std::string NormalizedSQL;
+    StmtSummaryStats Stats;
+
+    bool IsOthers() const { return Digest.empty(); }
+};
+
+// StmtSummary aggregates the executions of the statements by digest and schema, like TiDB's
+// information_schema.statements_summary: it tells which statements are worth tuning.
+// Time is cut in windows of refreshInterval, aligned on the epoch; every statement keeps the stats of its last
+// historySize windows. The statements live in a concurrent hash map so that the sessions update them without a
+// global lock. When it holds maxStmtCount statements, the ones executed the longest ago are evicted into the
+// "others" record of every window to make room.
+class StmtSummary {
+public:
+    static constexpr std::chrono::seconds defaultRefreshInterval{1800};
+    static constexpr size_t defaultHistorySize = 24;
+    static constexpr size_t defaultMaxStmtCount = 3000;
+    static constexpr size_t defaultMaxSQLLength = 4096;
+
+    explicit StmtSummary(std::chrono::seconds refreshInterval = defaultRefreshInterval,
+                         size_t historySize = defaultHistorySize, size_t maxStmtCount = defaultMaxStmtCount,
+                         size_t maxSQLLength = defaultMaxSQLLength);
+
+    StmtSummary(const StmtSummary &) = delete;
+    StmtSummary &operator=(const StmtSummary &) = delete;
+
+    // Add accounts for an execution in the window of its start time.
+    void Add(const StmtExecInfo &info);
+
+    // Current returns the records of the window holding now, the "others" record last if there is one.
+    std::vector<StmtSummaryRecord> Current(
+        std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const;
+
+    // History returns the records of all the windows kept, ordered by window.
+    std::vector<StmtSummaryRecord> History() const;
+
+    // NumStmts returns the number of statements, not counting "others".
+    size_t NumStmts() const { return _stmts.size(); }
+
+    // Clear removes all the statements.
+    void Clear();
+
+private:
+    // stmtKeyView is a stmtKey that does not own its schema, so that looking up an existing statement does not
+    // allocate.
+    struct stmtKeyView {
+        parser::Digest Digest;
+        std::string_view SchemaName;
+    };
+
+    struct stmtKey {
+        parser::Digest Digest;
+        std::string SchemaName;
+
+        // The conversion is implicit so that the map builds the key of a new statement from the view it was
+        // looked up with.
+        stmtKey(const stmtKeyView &view) : Digest(view.Digest), SchemaName(view.SchemaName) {}
+    };
+
+    struct stmtKeyHasher {
+        size_t operator()(const stmtKeyView &key) const {
+            return parser::DigestHasher{}(key.Digest) ^ std::hash<std::string_view>{}(key.SchemaName);
+        }
+        size_t operator()(const stmtKey &key) const { return (*this)(stmtKeyView{key.Digest, key.SchemaName}); }
+    };
+
+    struct stmtKeyEqual {
+        static stmtKeyView view(const stmtKeyView &key) { return key; }
+        static stmtKeyView view(const stmtKey &key) { return {key.Digest, key.SchemaName}; }
+
+        template <typename A, typename B>
+        bool operator()(const A &a, const B &b) const {
+            return view(a).Digest == view(b).Digest && view(a).SchemaName == view(b).SchemaName;
+        }
+    };
+
+    // window is the stats of a statement during a window.
+    struct window {
+        std::chrono::system_clock::time_point Begin;
+        StmtSummaryStats Stats;
+    };
+
+    // stmtEntry is the stats of a statement, by window from the oldest.
+    struct stmtEntry {
+        std::string NormalizedSQL;
+        std::deque<window> Windows;
+    };
+
+    std::chrono::system_clock::time_point windowBegin(std::chrono::system_clock::time_point t) const;
+
+    // addToWindows accounts for an execution in the window of windows it belongs to, adding the window if needed
+    // and dropping the ones beyond the history size.
+    void addToWindows(std::deque<window> &windows, const StmtExecInfo &info) const;
+
+    // evict merges the statements executed the longest ago into "others", a fraction of them at a time so that the
+    // table is not locked at every new statement.
+    void evict();
+
+    // appendRecords appends the windows of a statement, or of "others" if key is null, to out. Only the window
+    // starting at begin is appended if it is not null.
+    void appendRecords(std::vector<StmtSummaryRecord> &out, const stmtKey *key, std::string_view normalizedSQL,
+                       const std::deque<window> &windows, const std::chrono::system_clock::time_point *begin) const;
+
+    std::chrono::seconds _refreshInterval;
+    size_t _historySize;
+    size_t _maxStmtCount;
+    size_t _maxSQLLength;
+    // _stmts is locked as a whole to be read.
+    mutable cuckoohash_map<stmtKey, stmtEntry, stmtKeyHasher, stmtKeyEqual> _stmts;
+
+    mutable std::mutex _othersMu;
+    std::deque<window> _others;
+};
+
+// WriteStmtSummaryJSON appends records to out as a JSON array, with the column names of TiDB's statements_summary.
+void WriteStmtSummaryJSON(const std::vector<StmtSummaryRecord> &records, std::string &out);
+
+}  // namespace server
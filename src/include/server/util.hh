@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+namespace server {
+
+// lengthEncodedIntSize returns the number of bytes dumpLengthEncodedInt writes for n.
+constexpr size_t lengthEncodedIntSize(uint64_t n) {
+    if (n <= 250) {
+        return 1;
+    } else if (n <= 0xffff) {
+        return 3;
+    } else if (n <= 0xffffff) {
+        return 4;
+    }
+    return 9;
+}
+
+// putLengthEncodedInt writes n at p as a length-encoded integer and returns the position after it.
+// The caller must have reserved lengthEncodedIntSize(n) bytes.
+inline uint8_t *putLengthEncodedInt(uint8_t *p, uint64_t n) {
+    if (n <= 250) {
+        *p = static_cast<uint8_t>(n);
+        return p + 1;
+    } else if (n <= 0xffff) {
+        p[0] = 0xfc;
+        p[1] = static_cast<uint8_t>(n);
+        p[2] = static_cast<uint8_t>(n >> 8);
+        return p + 3;
+    } else if (n <= 0xffffff) {
+        p[0] = 0xfd;
+        p[1] = static_cast<uint8_t>(n);
+        p[2] = static_cast<uint8_t>(n >> 8);
+        p[3] = static_cast<uint8_t>(n >> 16);
+        return p + 4;
+    }
+    p[0] = 0xfe;
+    for (int i = 0; i < 8; i++) {
+        p[1 + i] = static_cast<uint8_t>(n >> (8 * i));
+    }
+    return p + 9;
+}
+
+// putLengthEncodedString writes the length-encoded string s at p and returns the position after it.
+inline uint8_t *putLengthEncodedString(uint8_t *p, const void *s, size_t len) {
+    p = putLengthEncodedInt(p, len);
+    std::memcpy(p, s, len);
+    return p + len;
+}
+
+// putUint16/putUint32/putUint64 write little-endian fixed-length integers at p.
+inline uint8_t *putUint16(uint8_t *p, uint16_t n) {
+    p[0] = static_cast<uint8_t>(n);
+    p[1] = static_cast<uint8_t>(n >> 8);
+    return p + 2;
+}
+
+inline uint8_t *putUint32(uint8_t *p, uint32_t n) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<uint8_t>(n >> (8 * i));
+    }
+    return p + 4;
+}
+
+inline uint8_t *putUint64(uint8_t *p, uint64_t n) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = static_cast<uint8_t>(n >> (8 * i));
+    }
+    return p + 8;
+}
+
+// readLE reads a fixed-length integer at p, which needs not be aligned. The host is little-endian like the protocol.
+template <typename T>
+T readLE(const char *p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+// The dump* functions append to a growable buffer; they are used for the low-volume packets
+// (handshake, OK/ERR, column definitions) where convenience matters more than raw speed.
+void dumpLengthEncodedInt(std::string &buffer, uint64_t n);
+void dumpLengthEncodedString(std::string &buffer, std::string_view s);
+void dumpUint16(std::string &buffer, uint16_t n);
+void dumpUint32(std::string &buffer, uint32_t n);
+void dumpUint64(std::string &buffer, uint64_t n);
+
+// parseLengthEncodedInt returns the decoded value, whether it is the NULL marker (0xfb), and the number of bytes
+// consumed. A consumed size of 0 means the input is truncated.
+std::tuple<uint64_t, bool, size_t> parseLengthEncodedInt(std::string_view b);
+
+// parseLengthEncodedBytes returns the string, whether it is NULL, and the number of bytes consumed (0 if truncated).
+std::tuple<std::string_view, bool, size_t> parseLengthEncodedBytes(std::string_view b);
+
+// parseNullTermString returns the string before the first NUL and the rest after it.
+std::pair<std::string_view, std::string_view> parseNullTermString(std::string_view b);
+
+// BinaryTime is the binary protocol form of DATE, DATETIME, TIMESTAMP and TIME values.
+// See https://dev.mysql.com/doc/internals/en/binary-protocol-value.html
+struct BinaryTime {
+    uint8_t _length;   // number of bytes that follow the length byte: 0, 4, 7 or 11 (8 or 12 for TIME)
+    uint8_t _data[12];
+};
+
+// dumpBinaryDateTime converts a value in canonical text form ("YYYY-MM-DD[ hh:mm:ss[.ffffff]]") to its binary
+// protocol form. It returns false if the text is malformed.
+bool dumpBinaryDateTime(std::string_view text, BinaryTime &out);
+
+// dumpBinaryTime converts a duration in canonical text form ("[-]hhh:mm:ss[.ffffff]") to its binary protocol form.
+// It returns false if the text is malformed.
+bool dumpBinaryTime(std::string_view text, BinaryTime &out);
+
+}  // namespace server
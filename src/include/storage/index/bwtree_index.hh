@@ -0,0 +1,267 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "bwtree/bwtree.h"
+#include "ips4o.hpp"
+#include "storage/index/index_key.hh"
+
+namespace storage::index {
+
+// BwTreeIndex is an ordered in-memory index over the lock-free Bw-Tree: it maps keys to values, e.g. encoded index
+// keys to row handles, and scans them in key order both ways. Every operation may run concurrently with the others
+// without locks; the nodes replaced by a writer are freed once no reader can see them, by a garbage collection thread
+// of the tree or by the caller through PerformGarbageCollection.
+// KeyType is a key of index_key.hh, or any type with the same Less, Equal and Hash comparators and Max. Keys are
+// copied into the delta records and the nodes of the tree, so they should be small and not allocate.
+template <typename KeyType, typename ValueType = uint64_t>
+class BwTreeIndex {
+    using tree = third_party::bwtree::BwTree<KeyType, ValueType, typename KeyType::Less, typename KeyType::Equal,
+                                             typename KeyType::Hash, std::equal_to<ValueType>, std::hash<ValueType>>;
+
+public:
+    // A unique index holds at most one value per key. Without startGCThread, the caller must call
+    // PerformGarbageCollection periodically.
+    explicit BwTreeIndex(bool unique, bool startGCThread = true) : _unique(unique), _tree(startGCThread) {}
+
+    BwTreeIndex(const BwTreeIndex &) = delete;
+    BwTreeIndex &operator=(const BwTreeIndex &) = delete;
+
+    bool Unique() const { return _unique; }
+
+    // Size returns the number of pairs.
+    size_t Size() const { return _tree.GetSize(); }
+
+    // Get returns a value of key, the only one in a unique index.
+    std::optional<ValueType> Get(const KeyType &key) {
+        // The scratch vector is reused so that a point lookup does not allocate.
+        thread_local std::vector<ValueType> values;
+        values.clear();
+        _tree.GetValue(key, values);
+        if (values.empty()) {
+            return std::nullopt;
+        }
+        return values.front();
+    }
+
+    // GetAll appends the values of key to out.
+    void GetAll(const KeyType &key, std::vector<ValueType> &out) { _tree.GetValue(key, out); }
+
+    // Insert adds the pair. It returns false if the pair already exists or, in a unique index, if key has a value.
+    bool Insert(const KeyType &key, const ValueType &value) { return _tree.Insert(key, value, _unique); }
+
+    // Upsert replaces the values of key with value. The new value is inserted before the old ones are deleted, so a
+    // concurrent reader sees the old value, the new one or both, but never none. Concurrent upserts of the same key
+    // must be serialized by the caller, or a unique index may keep several values for it.
+    void Upsert(const KeyType &key, const ValueType &value) {
+        std::vector<ValueType> old;
+        _tree.GetValue(key, old);
+        _tree.Insert(key, value, false);
+        for (const auto &v : old) {
+            if (!(v == value)) {
+                _tree.Delete(key, v);
+            }
+        }
+    }
+
+    // BulkLoad adds the pairs, e.g. the rows of a restore or of LOAD DATA. Into an empty index it sorts them in
+    // parallel and builds the tree bottom-up, far faster than inserting them one by one, and they all become visible
+    // at once; otherwise they are inserted in key order. A unique index keeps the first value given for a key, as if
+    // the pairs were inserted in order. The values of a non-unique index must be ordered by std::less. Readers may run
+    // concurrently, writers must wait for the load to finish. It returns the number of pairs added.
+    size_t BulkLoad(std::vector<std::pair<KeyType, ValueType>> pairs) {
+        typename KeyType::Less less;
+        typename KeyType::Equal equal;
+        if (_unique) {
+            // ips4o does not keep the order of equal keys: the position of every pair breaks the ties.
+            std::vector<std::pair<std::pair<KeyType, ValueType>, size_t>> numbered;
+            numbered.reserve(pairs.size());
+            for (size_t i = 0; i < pairs.size(); i++) {
+                numbered.emplace_back(std::move(pairs[i]), i);
+            }
+            pairs = {};
+            ips4o::parallel::sort(numbered.begin(), numbered.end(), [&](const auto &a, const auto &b) {
+                return less(a.first.first, b.first.first) ||
+                       (!less(b.first.first, a.first.first) && a.second < b.second);
+            });
+            pairs.reserve(numbered.size());
+            for (auto &[pair, i] : numbered) {
+                if (pairs.empty() || !equal(pairs.back().first, pair.first)) {
+                    pairs.push_back(std::move(pair));
+                }
+            }
+        } else {
+            // Sorted by key and value, the pairs given twice are adjacent.
+            std::less<ValueType> valueLess;
+            ips4o::parallel::sort(pairs.begin(), pairs.end(), [&](const auto &a, const auto &b) {
+                return less(a.first, b.first) || (!less(b.first, a.first) && valueLess(a.second, b.second));
+            });
+            pairs.erase(std::unique(pairs.begin(), pairs.end(),
+                                    [&](const auto &a, const auto &b) {
+                                        return equal(a.first, b.first) && a.second == b.second;
+                                    }),
+                        pairs.end());
+        }
+
+        if (_tree.BulkLoad(pairs.data(), pairs.data() + pairs.size())) {
+            return pairs.size();
+        }
+        size_t n = 0;
+        for (const auto &[key, value] : pairs) {
+            n += _tree.Insert(key, value, _unique) ? 1 : 0;
+        }
+        return n;
+    }
+
+    // Delete removes the pair, returning false if it does not exist.
+    bool Delete(const KeyType &key, const ValueType &value) { return _tree.Delete(key, value); }
+
+    // DeleteKey removes the values of key, returning how many were removed.
+    size_t DeleteKey(const KeyType &key) {
+        std::vector<ValueType> values;
+        _tree.GetValue(key, values);
+        size_t n = 0;
+        for (const auto &v : values) {
+            n += _tree.Delete(key, v) ? 1 : 0;
+        }
+        return n;
+    }
+
+    void PerformGarbageCollection() { _tree.PerformGarbageCollection(); }
+
+    // Iterator walks the pairs of a range of keys, forward or backward. It holds a copy of one leaf of the tree at a
+    // time: it never blocks a writer, and sees the changes made to the leaves it has not reached yet.
+    class Iterator {
+    public:
+        bool Valid() const { return _valid; }
+
+        // Key and Value return the current pair. The iterator must be valid.
+        const KeyType &Key() const { return _it->first; }
+        const ValueType &Value() const { return _it->second; }
+
+        // Next moves to the next pair in the direction of the iterator.
+        void Next() {
+            if (_reverse) {
+                --_it;
+            } else {
+                ++_it;
+            }
+            check();
+        }
+
+    private:
+        friend class BwTreeIndex;
+
+        Iterator(typename tree::ForwardIterator it, bool reverse, std::optional<KeyType> bound)
+            : _it(std::move(it)), _reverse(reverse), _bound(std::move(bound)) {
+            check();
+        }
+
+        void check() {
+            typename KeyType::Less less;
+            if (_reverse) {
+                _valid = !_it.IsREnd() && !(_bound && less(_it->first, *_bound));
+            } else {
+                _valid = !_it.IsEnd() && !(_bound && !less(_it->first, *_bound));
+            }
+        }
+
+        // The iterator of the tree does not access the pair it points to through a const this.
+        mutable typename tree::ForwardIterator _it;
+        bool _reverse;
+        // _bound is the exclusive upper bound of a forward iterator, the inclusive lower bound of a reverse one.
+        std::optional<KeyType> _bound;
+        bool _valid{false};
+    };
+
+    // Iter returns an iterator over the keys in [lower, upper) in ascending order, a missing bound meaning no bound.
+    Iterator Iter(const std::optional<KeyType> &lower = std::nullopt,
+                  const std::optional<KeyType> &upper = std::nullopt) {
+        return Iterator(lower ? _tree.Begin(*lower) : _tree.Begin(), false, upper);
+    }
+
+    // IterReverse returns an iterator over the keys in [lower, upper) in descending order.
+    Iterator IterReverse(const std::optional<KeyType> &upper = std::nullopt,
+                         const std::optional<KeyType> &lower = std::nullopt) {
+        // Position on the first key not below the range, then step back onto the last key of the range. Without an
+        // upper bound, only the values of the maximum key may follow that of the first one.
+        auto it = _tree.Begin(upper ? *upper : KeyType::Max());
+        if (!upper) {
+            while (!it.IsEnd()) {
+                ++it;
+            }
+        }
+        --it;
+        return Iterator(std::move(it), true, lower);
+    }
+
+    // BatchIterator scans a range of keys a leaf at a time, for the large scans: every batch holds the pairs of a
+    // consolidated leaf in two contiguous arrays, while the next leaf is prefetched. It follows the leaves through
+    // their siblings instead of traversing the tree for each, and stops at the upper bound or after the limit.
+    class BatchIterator {
+    public:
+        // Next loads the next batch, never empty, returning false at the end of the scan.
+        bool Next() {
+            typename KeyType::Less less;
+            _keys.clear();
+            _values.clear();
+            while (_keys.empty() && !_cursor.done && _limit > 0) {
+                _tree->ScanBatch(&_cursor, _keys, _values);
+                size_t n = _keys.size();
+                if (_upper) {
+                    // The keys of a batch are sorted: cut it at the first one not below the bound.
+                    auto end = std::lower_bound(_keys.begin(), _keys.end(), *_upper, less);
+                    n = end - _keys.begin();
+                    if (end != _keys.end()) {
+                        _cursor.done = true;
+                    }
+                }
+                n = std::min(n, _limit);
+                _keys.resize(n);
+                _values.resize(n);
+                _limit -= n;
+            }
+            return !_keys.empty();
+        }
+
+        // Keys and Values return the pairs of the current batch, in key order.
+        std::span<const KeyType> Keys() const { return _keys; }
+        std::span<const ValueType> Values() const { return _values; }
+
+    private:
+        friend class BwTreeIndex;
+
+        BatchIterator(tree *t, typename tree::ScanCursor cursor, std::optional<KeyType> upper, size_t limit)
+            : _tree(t), _cursor(std::move(cursor)), _upper(std::move(upper)), _limit(limit) {}
+
+        tree *_tree;
+        typename tree::ScanCursor _cursor;
+        std::optional<KeyType> _upper;
+        // _limit is the number of pairs still to return.
+        size_t _limit;
+        std::vector<KeyType> _keys;
+        std::vector<ValueType> _values;
+    };
+
+    // IterBatch returns a batch iterator over at most limit pairs with keys in [lower, upper), in ascending order.
+    BatchIterator IterBatch(const std::optional<KeyType> &lower = std::nullopt,
+                            const std::optional<KeyType> &upper = std::nullopt,
+                            size_t limit = std::numeric_limits<size_t>::max()) {
+        return BatchIterator(&_tree, lower ? typename tree::ScanCursor(*lower) : typename tree::ScanCursor(), upper,
+                             limit);
+    }
+
+private:
+    bool _unique;
+    // GetSize and the iterators of the tree are not const.
+    mutable tree _tree;
+};
+
+}  // namespace storage::index
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "libcuckoo/cuckoohash_map.hh"
+#include "storage/index/bwtree_index.hh"
+#include "storage/index/index_key.hh"
+
+namespace storage::index {
+
+// RowLocation is where a row is stored. The index does not interpret it.
+using RowLocation = uint64_t;
+
+// HandleIndex is the primary-key index of a table: it maps the handles of the rows to their locations. The ordered
+// Bw-Tree serves the range scans; the point lookups, most of the traffic, are served by an optional cuckoo hash
+// table with lock striping instead, where lookups of different handles rarely contend and never traverse a tree.
+// Every write updates both, so that they hold the same handles once it returns. The writes of a handle must be
+// serialized by the caller, e.g. by the lock of the row; those of different handles may run concurrently.
+class HandleIndex {
+public:
+    // maxHashLoadFactor is the load factor Reserve sizes the hash table for: a cuckoo hash table fills up to about
+    // 95% of its slots before it has to grow, so the slots are reserved with some headroom.
+    static constexpr double maxHashLoadFactor = 0.9;
+    // minHashSlots is the size of the hash table of an index without an estimated row count.
+    static constexpr size_t minHashSlots = 1024;
+
+    // With withHash, the handles are hashed too. estimatedRows sizes the hash table, see Reserve.
+    explicit HandleIndex(bool withHash, size_t estimatedRows = 0);
+    ~HandleIndex();
+
+    HandleIndex(const HandleIndex &) = delete;
+    HandleIndex &operator=(const HandleIndex &) = delete;
+
+    bool HasHash() const { return _hash != nullptr; }
+
+    // Size returns the number of handles.
+    size_t Size() const { return _tree.Size(); }
+
+    // LoadFactor returns the ratio of the entries to the slots of the hash table, 0 without one.
+    double LoadFactor() const { return _hash ? _hash->load_factor() : 0; }
+
+    // Reserve sizes the hash table for rows handles, e.g. the row count of the statistics of the table, so that it
+    // does not grow while they are inserted. It shrinks the table if rows is lower, but never below its entries.
+    void Reserve(size_t rows);
+
+    // Get returns the location of the row of handle, for `WHERE pk = ?`.
+    std::optional<RowLocation> Get(int64_t handle) const;
+
+    // BatchGet sets out[i] to the location of the row of handles[i], for `WHERE pk IN (...)`.
+    void BatchGet(std::span<const int64_t> handles, std::vector<std::optional<RowLocation>> &out) const;
+
+    // Insert adds the row, returning false if the handle exists.
+    bool Insert(int64_t handle, RowLocation location);
+
+    // Update moves the row of handle to location, inserting it if it does not exist.
+    void Update(int64_t handle, RowLocation location);
+
+    // Delete removes the row, returning false if the handle does not exist.
+    bool Delete(int64_t handle);
+
+    // BulkLoad adds the rows, see BwTreeIndex::BulkLoad; into an empty index, the hash table is reserved for them
+    // and filled after the tree, the point lookups seeing the rows a batch at a time. It returns the number of rows
+    // added.
+    size_t BulkLoad(std::vector<std::pair<int64_t, RowLocation>> rows);
+
+    // Iter returns an iterator over the handles in [lower, upper) in ascending order.
+    BwTreeIndex<IntKey, RowLocation>::Iterator Iter(std::optional<int64_t> lower = std::nullopt,
+                                                    std::optional<int64_t> upper = std::nullopt);
+
+private:
+    // syncSlots adds the change of the number of slots of the hash table since the last call to the metrics.
+    void syncSlots();
+
+    // The lookups of the tree are not const.
+    mutable BwTreeIndex<IntKey, RowLocation> _tree{true};
+    std::unique_ptr<cuckoohash_map<IntKey, RowLocation, IntKey::Hash, IntKey::Equal>> _hash;
+    // _slots is the number of slots last added to the metrics.
+    std::atomic<size_t> _slots{0};
+};
+
+}  // namespace storage::index
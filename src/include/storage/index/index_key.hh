@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "xxHash/xxhash.h"
+
+// The keys of the ordered indexes. A key type orders like the memcomparable encoding of the values it holds, and
+// provides the comparators the index is instantiated with: Less, Equal and Hash, the hash being used by the Bloom
+// filters of the Bw-Tree's delta chains. Max returns a key no other key sorts after.
+namespace storage::index {
+
+namespace detail {
+
+// loadBigEndian loads 8 bytes as a big-endian integer, so that the integers compare like the bytes.
+inline uint64_t loadBigEndian(const uint8_t *p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    if constexpr (std::endian::native == std::endian::little) {
+        v = __builtin_bswap64(v);
+    }
+    return v;
+}
+
+}  // namespace detail
+
+// IntKey is a key of one signed integer, e.g. the handle of a row. It orders like its memcomparable encoding, the
+// big-endian bytes with the sign bit flipped, but compares as an integer.
+class IntKey {
+public:
+    IntKey() = default;
+    explicit IntKey(int64_t value) : _value(value) {}
+
+    static IntKey Max() { return IntKey(std::numeric_limits<int64_t>::max()); }
+
+    int64_t Value() const { return _value; }
+
+    // Encode appends the memcomparable encoding of the key to out.
+    void Encode(std::string &out) const {
+        auto v = static_cast<uint64_t>(_value) ^ (uint64_t{1} << 63);
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            out.push_back(static_cast<char>(v >> shift));
+        }
+    }
+
+    struct Less {
+        bool operator()(const IntKey &a, const IntKey &b) const { return a._value < b._value; }
+    };
+
+    struct Equal {
+        bool operator()(const IntKey &a, const IntKey &b) const { return a._value == b._value; }
+    };
+
+    struct Hash {
+        size_t operator()(const IntKey &k) const {
+            // The finalizer of MurmurHash3: handles are often sequential, their low bits must be mixed.
+            auto h = static_cast<uint64_t>(k._value);
+            h = (h ^ (h >> 33)) * 0xff51afd7ed558ccdULL;
+            h = (h ^ (h >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+            return h ^ (h >> 33);
+        }
+    };
+
+private:
+    int64_t _value{0};
+};
+
+// Key is a memcomparable key of at most Size bytes, stored inline so that the tree copies it without allocating.
+// Keys order like their bytes compared with memcmp, a key before the longer keys it prefixes. The bytes past the
+// length are zero: two keys first differ where the shorter has padding only if the longer has a non-zero byte there,
+// so the keys compare 8 padded bytes at a time up to the longer length, then by length.
+template <size_t Size>
+class Key {
+    static_assert(Size > 0 && Size % 8 == 0 && Size <= 256, "Size must be a multiple of 8, at most 256");
+
+public:
+    static constexpr size_t capacity = Size;
+
+    Key() = default;
+
+    // FromBytes returns the key of the encoded bytes, or nothing if they are longer than Size.
+    static std::optional<Key> FromBytes(std::string_view bytes) {
+        if (bytes.size() > Size) {
+            return std::nullopt;
+        }
+        Key k;
+        std::memcpy(k._bytes, bytes.data(), bytes.size());
+        k._len = static_cast<uint16_t>(bytes.size());
+        return k;
+    }
+
+    static Key Max() {
+        Key k;
+        std::memset(k._bytes, 0xff, Size);
+        k._len = Size;
+        return k;
+    }
+
+    std::string_view Bytes() const { return {reinterpret_cast<const char *>(_bytes), _len}; }
+
+    struct Less {
+        bool operator()(const Key &a, const Key &b) const {
+            // Past the longer key, both are padding.
+            size_t n = std::max(a._len, b._len);
+            for (size_t i = 0; i < n; i += 8) {
+                auto x = detail::loadBigEndian(a._bytes + i);
+                auto y = detail::loadBigEndian(b._bytes + i);
+                if (x != y) {
+                    return x < y;
+                }
+            }
+            return a._len < b._len;
+        }
+    };
+
+    struct Equal {
+        bool operator()(const Key &a, const Key &b) const {
+            return a._len == b._len && std::memcmp(a._bytes, b._bytes, a._len) == 0;
+        }
+    };
+
+    struct Hash {
+        size_t operator()(const Key &k) const { return XXH3_64bits(k._bytes, k._len); }
+    };
+
+private:
+    alignas(8) uint8_t _bytes[Size]{};
+    uint16_t _len{0};
+};
+
+}  // namespace storage::index
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "parser/mysql/error.hh"
+#include "storage/index/bwtree_index.hh"
+#include "storage/index/index_key.hh"
+#include "util/codec/codec.hh"
+
+// Package mvcc is a multi-version key-value store over the Bw-Tree. Every committed write of a key is a version,
+// stored in the tree under the key followed by its commit timestamp in descending order, so that the versions of a
+// key are adjacent and the newest comes first: the version a snapshot reads is the first at or after the key with
+// the snapshot's timestamp, found with a single seek. Readers take no lock and never block the writers.
+// The value of a version is owned by the store; a deletion is a version too, with a null value, so that the
+// snapshots older than it still read the value before it.
+namespace storage::mvcc {
+
+// versionKeySize is the capacity of the keys of the tree. MaxKeyLength, the length of the longest user key, is the
+// longest string whose memcomparable encoding leaves room for the timestamp.
+constexpr size_t versionKeySize = 96;
+constexpr size_t MaxKeyLength = (versionKeySize - 8) / 9 * 8 - 1;
+
+using versionKey = index::Key<versionKeySize>;
+
+class MVCCStore;
+
+// SnapshotIter walks the keys of a range in ascending order, with their values as of a snapshot. The keys deleted
+// in the snapshot are skipped.
+class SnapshotIter {
+public:
+    bool Valid() const { return _valid; }
+
+    // Key and Value return the current pair. The iterator must be valid.
+    std::string_view Key() const { return _key; }
+    std::string_view Value() const { return *_value; }
+
+    void Next();
+
+private:
+    friend class MVCCStore;
+    using tree = index::BwTreeIndex<versionKey, const std::string *>;
+
+    SnapshotIter(tree::Iterator it, uint64_t ts);
+
+    // settle moves from the current version to the first key with a value in the snapshot.
+    void settle();
+    // skipKey moves past the versions of the current key.
+    void skipKey();
+
+    tree::Iterator _it;
+    uint64_t _ts;
+    // _encoded is the encoded current key, the prefix of its versions.
+    std::string _encoded;
+    std::string _key;
+    const std::string *_value{nullptr};
+    bool _valid{false};
+};
+
+// Txn is a transaction with snapshot isolation. It reads the versions committed before it began and buffers its
+// writes until Commit, which fails if another transaction has committed one of the keys since. A transaction is
+// used by one thread at a time; it is rolled back if it is destroyed before Commit.
+class Txn {
+public:
+    ~Txn();
+
+    Txn(const Txn &) = delete;
+    Txn &operator=(const Txn &) = delete;
+
+    uint64_t StartTS() const { return _startTS; }
+
+    // Get returns the value of key, or nothing if it does not exist.
+    std::optional<std::string> Get(std::string_view key) const;
+
+    // Set and Delete buffer a write. They fail if key is longer than MaxKeyLength.
+    std::optional<mysql::SQLError> Set(std::string_view key, std::string_view value);
+    std::optional<mysql::SQLError> Delete(std::string_view key);
+
+    // Iterator walks the keys of a range as the transaction sees them: its snapshot with its own writes.
+    class Iterator {
+    public:
+        bool Valid() const { return _valid; }
+        std::string_view Key() const { return _fromWrites ? std::string_view(_write->first) : _snap.Key(); }
+        std::string_view Value() const { return _fromWrites ? std::string_view(*_write->second) : _snap.Value(); }
+        void Next();
+
+    private:
+        friend class Txn;
+        using writes = std::map<std::string, std::optional<std::string>, std::less<>>;
+
+        Iterator(SnapshotIter snap, writes::const_iterator write, writes::const_iterator writeEnd);
+
+        void settle();
+
+        SnapshotIter _snap;
+        writes::const_iterator _write;
+        writes::const_iterator _writeEnd;
+        bool _fromWrites{false};
+        bool _valid{false};
+    };
+
+    // Iter returns an iterator over the keys in [lower, upper), a missing upper bound meaning no bound. The
+    // transaction must not write while it is in use.
+    Iterator Iter(std::string_view lower = {}, const std::optional<std::string> &upper = std::nullopt) const;
+
+    // Commit installs the writes atomically: a snapshot sees all of them or none. It returns ErrWriteConflict if a
+    // key written by the transaction has a version committed after StartTS; nothing is installed then.
+    std::optional<mysql::SQLError> Commit();
+    void Rollback();
+
+private:
+    friend class MVCCStore;
+
+    Txn(MVCCStore *store, uint64_t startTS) : _store(store), _startTS(startTS) {}
+
+    MVCCStore *_store;
+    uint64_t _startTS;
+    bool _done{false};
+    std::map<std::string, std::optional<std::string>, std::less<>> _writes;
+};
+
+// MVCCStore is the multi-version store. The timestamps come from a counter: a transaction commits at the next one,
+// and begins at the last one committed.
+// The versions no snapshot can read anymore are removed by a background garbage collection: every version older
+// than the newest one visible at the safe point, the start of the oldest active transaction, and that one too if it
+// is a deletion.
+class MVCCStore {
+public:
+    // gcInterval is the time between two garbage collections in the background, none running if it is zero.
+    explicit MVCCStore(std::chrono::milliseconds gcInterval = std::chrono::milliseconds(10000));
+    ~MVCCStore();
+
+    MVCCStore(const MVCCStore &) = delete;
+    MVCCStore &operator=(const MVCCStore &) = delete;
+
+    // Begin starts a transaction reading the last committed snapshot.
+    std::unique_ptr<Txn> Begin();
+
+    // CommitTS returns the timestamp of the last commit.
+    uint64_t CommitTS() const { return _commitTS.load(std::memory_order_acquire); }
+
+    // SafePoint returns the timestamp below which the versions are garbage collected.
+    uint64_t SafePoint();
+
+    // GC removes the versions older than the safe point, returning how many there were.
+    size_t GC();
+
+    // NumVersions returns the number of versions of all keys.
+    size_t NumVersions() const { return _versions.Size(); }
+
+private:
+    friend class Txn;
+
+    // get returns the value of key visible at ts, null if it does not exist.
+    const std::string *get(std::string_view key, uint64_t ts);
+    SnapshotIter iter(uint64_t ts, std::string_view lower, const std::optional<std::string> &upper);
+    std::optional<mysql::SQLError> commit(const Txn &txn);
+    void release(uint64_t startTS);
+    void runGC();
+    // collect is a garbage collection, run under _gcMu.
+    size_t collect();
+
+    index::BwTreeIndex<versionKey, const std::string *> _versions{true};
+    std::atomic<uint64_t> _commitTS{0};
+    // _commitMu serializes the commits: the conflict checks and the installs of a commit are atomic.
+    std::mutex _commitMu;
+    // _snapshotsMu guards the start timestamps of the active transactions.
+    std::mutex _snapshotsMu;
+    std::multiset<uint64_t> _snapshots;
+
+    std::chrono::milliseconds _gcInterval;
+    // _gcMu serializes the garbage collections, and guards the state of the background thread.
+    std::mutex _gcMu;
+    std::condition_variable _gcCond;
+    bool _stopped{false};
+    std::thread _gcThread;
+};
+
+}  // namespace storage::mvcc
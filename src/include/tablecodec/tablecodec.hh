@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+// Package tablecodec lays the rows and the index entries of the tables out in the key space, like TiDB's tablecodec:
+//   row:          t{tableID}_r{handle}
+//   index entry:  t{tableID}_i{indexID}{encoded column values}
+// The ids and handles are encoded with util::codec::EncodeInt, so the keys of a table sort by handle, and those of an
+// index by column values.
+namespace tablecodec {
+
+constexpr char tablePrefix = 't';
+constexpr std::string_view recordPrefixSep = "_r";
+constexpr std::string_view indexPrefixSep = "_i";
+
+constexpr size_t idLen = 8;
+// prefixLen is the length of the prefix of the rows or of the indexes of a table.
+constexpr size_t prefixLen = 1 + idLen + 2;
+constexpr size_t RecordRowKeyLen = prefixLen + idLen;
+
+// EncodeTablePrefix returns the prefix of all the keys of a table.
+std::string EncodeTablePrefix(int64_t tableID);
+
+// GenTableRecordPrefix and GenTableIndexPrefix return the prefix of the rows and of the index entries of a table.
+std::string GenTableRecordPrefix(int64_t tableID);
+std::string GenTableIndexPrefix(int64_t tableID);
+
+// EncodeRowKeyWithHandle returns the key of a row.
+std::string EncodeRowKeyWithHandle(int64_t tableID, int64_t handle);
+
+// EncodeRowKeys appends the keys of the rows of handles to out, each RecordRowKeyLen bytes long. The prefix is
+// encoded once for the batch.
+void EncodeRowKeys(std::string &out, int64_t tableID, std::span<const int64_t> handles);
+
+// DecodeRecordKey returns the table id and the handle of a row key, and whether key is a row key.
+std::tuple<int64_t, int64_t, bool> DecodeRecordKey(std::string_view key);
+
+// EncodeIndexSeekKey returns the key of an index entry given its encoded column values, or the prefix of the
+// entries starting with them.
+std::string EncodeIndexSeekKey(int64_t tableID, int64_t indexID, std::string_view encodedValue);
+
+// ResetIndexKeys makes keys n copies of the prefix of an index, to which the index columns of a batch of rows are
+// then appended a column at a time by util::codec::Encode*Column.
+void ResetIndexKeys(std::vector<std::string> &keys, size_t n, int64_t tableID, int64_t indexID);
+
+// DecodeKeyHead returns the table id of a row or index key, the index id for an index key, whether it is a row key,
+// and whether key is either.
+std::tuple<int64_t, int64_t, bool, bool> DecodeKeyHead(std::string_view key);
+
+// DecodeTableID returns the table id of key, 0 if it is not a key of a table.
+int64_t DecodeTableID(std::string_view key);
+
+// CutIndexKey splits the first numColumns encoded values off the index key, returning them, what follows them, e.g.
+// the handle of a non-unique index entry, and whether the key is well-formed.
+std::tuple<std::vector<std::string_view>, std::string_view, bool> CutIndexKey(std::string_view key, size_t numColumns);
+
+bool IsRecordKey(std::string_view key);
+bool IsIndexKey(std::string_view key);
+
+}  // namespace tablecodec
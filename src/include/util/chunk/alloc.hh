@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "util/chunk/chunk.hh"
+
+namespace util::chunk {
+
+// Allocator hands out the chunks of an operator, their columns taken from a pool of the columns of the chunks it
+// got back: an operator producing a chunk per batch reuses the same buffers instead of allocating them every time.
+// It is used by one thread at a time, like the operator.
+class Allocator {
+public:
+    // maxFreeColumns bounds the number of pooled columns of every element size.
+    explicit Allocator(size_t maxFreeColumns = 64) : _maxFreeColumns(maxFreeColumns) {}
+
+    // Alloc returns an empty chunk of columns of the mysql types.
+    Chunk Alloc(std::span<const uint8_t> types, size_t capacity = defaultCapacity);
+
+    // Free returns the columns of chk to the pool.
+    void Free(Chunk &&chk);
+
+    // AllocColumn returns an empty column of elemSize bytes per value, e.g. for an intermediate result.
+    Column AllocColumn(size_t elemSize, size_t capacity = defaultCapacity);
+
+    // FreeColumn returns col to the pool.
+    void FreeColumn(Column &&col);
+
+    // NumFree returns the number of pooled columns.
+    size_t NumFree() const;
+
+private:
+    // pool holds the free columns of one element size.
+    struct pool {
+        size_t elemSize;
+        std::vector<Column> columns;
+    };
+
+    pool &poolOf(size_t elemSize);
+
+    size_t _maxFreeColumns;
+    // _pools is small, with a pool per element size.
+    std::vector<pool> _pools;
+};
+
+}  // namespace util::chunk
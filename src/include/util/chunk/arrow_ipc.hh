@@ -0,0 +1,161 @@
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "parser/mysql/error.hh"
+#include "util/chunk/chunk.hh"
+
+namespace flatbuffers {
+class FlatBufferBuilder;
+}  // namespace flatbuffers
+
+// The Arrow IPC formats of chunks, for exporting results to Arrow readers, spilling and exchanging chunks between
+// nodes. See https://arrow.apache.org/docs/format/Columnar.html#serialization-and-interprocess-communication-ipc.
+//
+// The columns of a chunk are already Arrow arrays, so only the metadata, a flatbuffer per message, is built: the
+// writer hands the buffers of the columns to writev, and the reader returns chunks whose columns are views of the
+// mapped file.
+namespace util::chunk {
+
+// Field is a column of the chunks written or read.
+//
+// The integers are written as Arrow Int(64), TypeFloat as FloatingPoint(SINGLE), TypeDouble as
+// FloatingPoint(DOUBLE), and the var-length types as LargeBinary if Flag has mysql::BinaryFlag, LargeUtf8 otherwise.
+// Type and Flag are kept in the custom metadata of the field, so that the reader gets them back.
+struct Field {
+    std::string Name;
+    uint8_t Type{0};
+    uint16_t Flag{0};
+};
+
+// ArrowFormat is one of the two Arrow IPC formats: the stream format is a sequence of messages, the schema first,
+// which can be read as it arrives; the file format frames the stream with magic numbers and a footer indexing the
+// record batches, for random access.
+enum class ArrowFormat { Stream, File };
+
+// ArrowWriter writes chunks as Arrow record batches, in metadata version V4 and with 64-byte aligned buffers.
+class ArrowWriter {
+public:
+    // Create creates the file at path, truncating it.
+    static std::tuple<std::unique_ptr<ArrowWriter>, std::optional<mysql::SQLError>> Create(const std::string &path,
+                                                                                             std::vector<Field> fields,
+                                                                                             ArrowFormat format);
+
+    // A writer to fd, e.g. a socket, which it does not close. name names fd in the errors.
+    ArrowWriter(int fd, std::string name, std::vector<Field> fields, ArrowFormat format);
+    ~ArrowWriter();
+
+    ArrowWriter(const ArrowWriter &) = delete;
+    ArrowWriter &operator=(const ArrowWriter &) = delete;
+
+    // Write writes chk as a record batch, the schema before the first one. A chunk with a selection vector is
+    // compacted first.
+    std::optional<mysql::SQLError> Write(const Chunk &chk);
+
+    // Finish writes the end of the stream, and the footer in the file format. Nothing may be written after.
+    std::optional<mysql::SQLError> Finish();
+
+    // BytesWritten returns the number of bytes written.
+    size_t BytesWritten() const { return _written; }
+
+private:
+    // block locates a record batch in the file format.
+    struct block {
+        int64_t offset;
+        int32_t metadataLength;
+        int64_t bodyLength;
+    };
+
+    std::optional<mysql::SQLError> writeStart();
+    std::optional<mysql::SQLError> writeBatch(const Chunk &chk);
+    // writeMessage writes the message metadata in _fbb and the body, writing its location to b if not null.
+    std::optional<mysql::SQLError> writeMessage(std::span<const iovec> body, size_t bodyLength, block *b);
+    // writeAll writes the iov, in as many writev calls as needed.
+    std::optional<mysql::SQLError> writeAll(std::span<const iovec> iov);
+
+    int _fd;
+    bool _ownsFd{false};
+    std::string _name;
+    std::vector<Field> _fields;
+    ArrowFormat _format;
+    bool _started{false};
+    size_t _written{0};
+    std::vector<block> _blocks;
+    // _compacted holds the rows of the selection of a chunk.
+    std::unique_ptr<Chunk> _compacted;
+
+    // Per-message scratch, reused across calls.
+    std::unique_ptr<flatbuffers::FlatBufferBuilder> _fbb;
+    std::vector<iovec> _iov;
+    std::vector<iovec> _body;
+};
+
+// ArrowReader reads the record batches of an Arrow IPC stream or file. The metadata of every message is verified,
+// and the buffers are checked against the lengths of the arrays, so that a corrupted file is reported rather than
+// read out of bounds.
+//
+// The columns read are views of the data: they are valid while the reader is, and are copied only when rows are
+// appended to them. The supported Arrow types are those ArrowWriter writes, Int(64) being signed or not.
+class ArrowReader {
+public:
+    // Open maps the file at path, in either format. The mapping is private, so that the columns read may be written
+    // in place, like any other, without writing the file.
+    static std::tuple<std::unique_ptr<ArrowReader>, std::optional<mysql::SQLError>> Open(const std::string &path);
+
+    // Open reads the stream or file in data, e.g. received from another node, which must outlive the reader and the
+    // columns read; they may write it in place.
+    static std::tuple<std::unique_ptr<ArrowReader>, std::optional<mysql::SQLError>> Open(std::span<uint8_t> data,
+                                                                                         std::string name);
+
+    ~ArrowReader();
+
+    ArrowReader(const ArrowReader &) = delete;
+    ArrowReader &operator=(const ArrowReader &) = delete;
+
+    const std::vector<Field> &Fields() const { return _fields; }
+
+    // NumBatches returns the number of record batches.
+    size_t NumBatches() const { return _batches.size(); }
+
+    // ReadBatch sets chk to the record batch i.
+    std::optional<mysql::SQLError> ReadBatch(size_t i, Chunk &chk) const;
+
+    // WillNeed starts reading the record batch i of a mapped file in the background, so that a reader going through
+    // the batches in order, e.g. the merge of spilled runs, does not wait for the disk at every one.
+    void WillNeed(size_t i) const;
+
+private:
+    // message is an encapsulated message: its metadata and its body.
+    struct message {
+        const void *metadata;
+        std::span<uint8_t> body;
+    };
+
+    ArrowReader(std::span<uint8_t> data, std::string name) : _data(data), _name(std::move(name)) {}
+
+    std::optional<mysql::SQLError> init();
+    // readMessage reads the message at offset, setting next to the offset after it; a nullptr metadata is the end of
+    // the stream.
+    std::optional<mysql::SQLError> readMessage(size_t offset, message &msg, size_t &next) const;
+    std::optional<mysql::SQLError> readSchema(const void *schema);
+    mysql::SQLError corrupted() const;
+
+    std::span<uint8_t> _data;
+    std::string _name;
+    // _mapped is whether _data is a mapping of the reader.
+    bool _mapped{false};
+    std::vector<Field> _fields;
+    // _elemSizes are the element sizes of the columns of the fields.
+    std::vector<size_t> _elemSizes;
+    std::vector<message> _batches;
+};
+
+}  // namespace util::chunk
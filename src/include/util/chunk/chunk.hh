@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "util/chunk/column.hh"
+
+namespace util::chunk {
+
+// defaultCapacity is the number of rows of a chunk: a vectorized loop over a column of that many values stays in
+// the L1 cache.
+constexpr size_t defaultCapacity = 1024;
+
+// Chunk is a batch of rows, the unit of data exchanged by the operators. It may carry a selection vector, the
+// indices of the rows a filter kept, in ascending order: the rows of the columns are then those of the selection
+// only, and the filtered ones are neither copied nor compacted.
+class Chunk {
+public:
+    Chunk() = default;
+
+    // A chunk of columns of the mysql types, with room for capacity rows.
+    explicit Chunk(std::span<const uint8_t> types, size_t capacity = defaultCapacity);
+
+    // A chunk of columns, e.g. taken from an Allocator.
+    Chunk(std::vector<Column> columns, size_t capacity) : _columns(std::move(columns)), _capacity(capacity) {}
+
+    Chunk(Chunk &&) noexcept = default;
+    Chunk &operator=(Chunk &&) noexcept = default;
+
+    size_t NumCols() const { return _columns.size(); }
+    Column &Col(size_t i) { return _columns[i]; }
+    const Column &Col(size_t i) const { return _columns[i]; }
+
+    size_t Capacity() const { return _capacity; }
+
+    // NumRows returns the number of rows, those of the selection if there is one.
+    size_t NumRows() const { return _hasSel ? _sel.size() : NumRowsUnfiltered(); }
+
+    // NumRowsUnfiltered returns the number of rows of the columns.
+    size_t NumRowsUnfiltered() const { return _columns.empty() ? 0 : _columns[0].Length(); }
+
+    // IsFull reports whether the columns hold Capacity rows.
+    bool IsFull() const { return NumRowsUnfiltered() >= _capacity; }
+
+    // RowIdx returns the index in the columns of the row i of the chunk.
+    size_t RowIdx(size_t i) const { return _hasSel ? _sel[i] : i; }
+
+    bool HasSel() const { return _hasSel; }
+    std::span<const uint32_t> Sel() const { return _sel; }
+
+    // SetSel sets the selection vector, the indices in the columns of the rows of the chunk.
+    void SetSel(std::vector<uint32_t> sel) {
+        _sel = std::move(sel);
+        _hasSel = true;
+    }
+
+    // MutableSel returns the selection vector for a filter to fill in place, setting an empty one if there is none.
+    std::vector<uint32_t> &MutableSel() {
+        if (!_hasSel) {
+            _sel.clear();
+            _hasSel = true;
+        }
+        return _sel;
+    }
+
+    void ClearSel() {
+        _sel.clear();
+        _hasSel = false;
+    }
+
+    // AppendRow appends the row i of other, a chunk of the same column types, i being an index of its rows.
+    void AppendRow(const Chunk &other, size_t i);
+
+    // Append appends the rows [begin, end) of other.
+    void Append(const Chunk &other, size_t begin, size_t end);
+
+    // Reset removes the rows and the selection, and keeps the buffers for the next batch.
+    void Reset();
+
+    // ReleaseColumns moves the columns out of the chunk, e.g. to return them to an Allocator.
+    std::vector<Column> ReleaseColumns();
+
+private:
+    std::vector<Column> _columns;
+    size_t _capacity{0};
+    // _sel is kept when the selection is cleared, so that the next one does not allocate.
+    std::vector<uint32_t> _sel;
+    bool _hasSel{false};
+};
+
+}  // namespace util::chunk
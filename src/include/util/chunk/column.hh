@@ -0,0 +1,261 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <utility>
+
+// Package chunk is the columnar format of the rows flowing between the operators, after TiDB's util/chunk. A Chunk
+// is a batch of rows stored column by column in the layout of Arrow arrays: a fixed-width column is a contiguous
+// buffer of values, a var-length one a buffer of int64 offsets into a buffer of bytes, and the nulls of both a
+// validity bitmap. The buffers are aligned and padded to 64 bytes like Arrow's, so a chunk can be exported as Arrow
+// record batches, or handed to server::ResultSetEncoder, without copying.
+namespace util::chunk {
+
+// bufferAlignment is the alignment and the padding of the buffers.
+constexpr size_t bufferAlignment = 64;
+
+// Buffer is a growable byte buffer, aligned on bufferAlignment with a capacity multiple of it.
+class Buffer {
+public:
+    Buffer() = default;
+    ~Buffer();
+
+    Buffer(Buffer &&other) noexcept
+        : _data(std::exchange(other._data, nullptr)),
+          _size(std::exchange(other._size, 0)),
+          _capacity(std::exchange(other._capacity, 0)),
+          _owned(std::exchange(other._owned, true)) {}
+    Buffer &operator=(Buffer &&other) noexcept {
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+        std::swap(_capacity, other._capacity);
+        std::swap(_owned, other._owned);
+        return *this;
+    }
+
+    // View returns a buffer of the size bytes at data, which it does not own, e.g. those of a mapped Arrow file. The
+    // bytes may be written in place; the buffer copies them to a buffer of its own before it grows, and drops them
+    // when it is cleared.
+    static Buffer View(uint8_t *data, size_t size) {
+        Buffer b;
+        b._data = data;
+        b._size = size;
+        b._owned = false;
+        return b;
+    }
+
+    Buffer(const Buffer &) = delete;
+    Buffer &operator=(const Buffer &) = delete;
+
+    uint8_t *Data() { return _data; }
+    const uint8_t *Data() const { return _data; }
+    size_t Size() const { return _size; }
+    size_t Capacity() const { return _capacity; }
+
+    // Reserve makes room for n bytes, keeping the content.
+    void Reserve(size_t n) {
+        if (n > _capacity) {
+            grow(n);
+        }
+    }
+
+    // Resize sets the size to n bytes. The new bytes are not initialized.
+    void Resize(size_t n) {
+        Reserve(n);
+        _size = n;
+    }
+
+    void Append(const void *p, size_t n) {
+        if (n == 0) {
+            return;
+        }
+        Reserve(_size + n);
+        std::memcpy(_data + _size, p, n);
+        _size += n;
+    }
+
+    void Clear() {
+        if (!_owned) {
+            _data = nullptr;
+            _owned = true;
+        }
+        _size = 0;
+    }
+
+private:
+    // grow reallocates the buffer for at least n bytes, doubling the capacity.
+    void grow(size_t n);
+
+    uint8_t *_data{nullptr};
+    size_t _size{0};
+    // _capacity is 0 for a view, so that it is copied before anything is appended.
+    size_t _capacity{0};
+    bool _owned{true};
+};
+
+// Column is a column of a chunk. A fixed-width column holds int64_t, uint64_t, float or double values, the integers
+// of all sizes being widened to 64 bits; a var-length column holds bytes, e.g. strings or the text form of the
+// temporal types. The values of the null rows are zero or empty.
+class Column {
+public:
+    // varElemSize is the element size of the var-length columns.
+    static constexpr size_t varElemSize = 0;
+
+    // ElemSize returns the element size of the column of the mysql type tp, in the storage of
+    // server::ColumnVector.
+    static size_t ElemSize(uint8_t tp);
+
+    // A column of elemSize bytes per value, var-length if it is varElemSize, with room for capacity rows.
+    explicit Column(size_t elemSize, size_t capacity = 0);
+
+    // A column of length rows on the buffers of an Arrow array, e.g. views of a mapped file: a validity bitmap of at
+    // least (length + 7) / 8 bytes, the length + 1 offsets of a var-length column, and the values.
+    Column(size_t elemSize, size_t length, size_t nullCount, Buffer nullBitmap, Buffer offsets, Buffer data)
+        : _elemSize(elemSize),
+          _length(length),
+          _nullCount(nullCount),
+          _nullBitmap(std::move(nullBitmap)),
+          _offsets(std::move(offsets)),
+          _data(std::move(data)) {}
+
+    Column(Column &&) noexcept = default;
+    Column &operator=(Column &&) noexcept = default;
+
+    size_t ElemSize() const { return _elemSize; }
+    bool IsFixed() const { return _elemSize != varElemSize; }
+
+    size_t Length() const { return _length; }
+    size_t NullCount() const { return _nullCount; }
+
+    bool IsNull(size_t row) const { return (_nullBitmap.Data()[row >> 3] & (1u << (row & 7))) == 0; }
+
+    // SetNull sets whether row is null, e.g. for the results of a vectorized expression. The value is kept.
+    void SetNull(size_t row, bool isNull) {
+        auto &b = _nullBitmap.Data()[row >> 3];
+        uint8_t bit = 1u << (row & 7);
+        if (isNull == ((b & bit) == 0)) {
+            return;
+        }
+        b ^= bit;
+        if (isNull) {
+            _nullCount++;
+        } else {
+            _nullCount--;
+        }
+    }
+
+    void AppendNull() {
+        appendValidity(false);
+        if (IsFixed()) {
+            _data.Resize(_data.Size() + _elemSize);
+            std::memset(_data.Data() + _data.Size() - _elemSize, 0, _elemSize);
+        } else {
+            appendOffset();
+        }
+    }
+
+    void AppendInt64(int64_t v) { appendFixed(v); }
+    void AppendUint64(uint64_t v) { appendFixed(v); }
+    void AppendFloat32(float v) { appendFixed(v); }
+    void AppendFloat64(double v) { appendFixed(v); }
+
+    void AppendBytes(std::string_view v) {
+        appendValidity(true);
+        _data.Append(v.data(), v.size());
+        appendOffset();
+    }
+
+    // AppendFrom appends row of other, a column of the same element size.
+    void AppendFrom(const Column &other, size_t row);
+
+    int64_t GetInt64(size_t row) const { return getFixed<int64_t>(row); }
+    uint64_t GetUint64(size_t row) const { return getFixed<uint64_t>(row); }
+    float GetFloat32(size_t row) const { return getFixed<float>(row); }
+    double GetFloat64(size_t row) const { return getFixed<double>(row); }
+
+    std::string_view GetBytes(size_t row) const {
+        auto offsets = Offsets();
+        return {reinterpret_cast<const char *>(_data.Data()) + offsets[row],
+                static_cast<size_t>(offsets[row + 1] - offsets[row])};
+    }
+
+    // Values returns the values of a fixed-width column of T, for the vectorized loops.
+    template <typename T>
+    std::span<const T> Values() const {
+        return {reinterpret_cast<const T *>(_data.Data()), _length};
+    }
+    template <typename T>
+    std::span<T> MutableValues() {
+        return {reinterpret_cast<T *>(_data.Data()), _length};
+    }
+
+    // ResizeFixed sets the length of a fixed-width column to n rows, none null, for a vectorized operator to write
+    // them through MutableValues. The values are not initialized.
+    void ResizeFixed(size_t n);
+
+    // NullBitmap returns the validity bitmap, a set bit meaning not null.
+    const uint8_t *NullBitmap() const { return _nullBitmap.Data(); }
+    uint8_t *MutableNullBitmap() { return _nullBitmap.Data(); }
+    // RecountNulls recomputes NullCount after the bitmap was written through MutableNullBitmap.
+    void RecountNulls();
+
+    // Offsets returns the Length() + 1 offsets of the values of a var-length column into Data().
+    const int64_t *Offsets() const { return reinterpret_cast<const int64_t *>(_offsets.Data()); }
+
+    // Data returns the values of a fixed-width column, the bytes of a var-length one.
+    const uint8_t *Data() const { return _data.Data(); }
+    size_t DataSize() const { return _data.Size(); }
+
+    // Reserve makes room for rows more rows, and dataBytes more bytes of a var-length column.
+    void Reserve(size_t rows, size_t dataBytes = 0);
+
+    // Reset removes the rows and keeps the buffers.
+    void Reset();
+
+private:
+    void appendValidity(bool valid) {
+        if ((_length & 7) == 0) {
+            _nullBitmap.Resize((_length >> 3) + 1);
+            _nullBitmap.Data()[_length >> 3] = 0;
+        }
+        // The padding bits of the last byte of an Arrow bitmap may be set.
+        uint8_t bit = 1u << (_length & 7);
+        if (valid) {
+            _nullBitmap.Data()[_length >> 3] |= bit;
+        } else {
+            _nullBitmap.Data()[_length >> 3] &= ~bit;
+            _nullCount++;
+        }
+        _length++;
+    }
+
+    void appendOffset() {
+        auto offset = static_cast<int64_t>(_data.Size());
+        _offsets.Append(&offset, sizeof(offset));
+    }
+
+    template <typename T>
+    void appendFixed(T v) {
+        appendValidity(true);
+        _data.Append(&v, sizeof(v));
+    }
+
+    template <typename T>
+    T getFixed(size_t row) const {
+        T v;
+        std::memcpy(&v, _data.Data() + row * sizeof(T), sizeof(T));
+        return v;
+    }
+
+    size_t _elemSize;
+    size_t _length{0};
+    size_t _nullCount{0};
+    Buffer _nullBitmap;
+    // _offsets is empty for a fixed-width column.
+    Buffer _offsets;
+    Buffer _data;
+};
+
+}  // namespace util::chunk
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "parser/mysql/error.hh"
+
+// Package codec is the memcomparable encoding of TiDB's util/codec: the encoded values compare with memcmp like the
+// values themselves, so that the keys of the ordered indexes sort like the rows they point to.
+// The Encode functions append to a buffer; the Decode functions read a value at the start of a buffer and return it
+// with the number of bytes consumed, 0 if the buffer is truncated or malformed.
+namespace util::codec {
+
+// The flags prefix the values of a key, telling their type. NilFlag sorts NULL before every value, MaxFlag after.
+constexpr uint8_t NilFlag = 0;
+constexpr uint8_t BytesFlag = 1;
+constexpr uint8_t CompactBytesFlag = 2;
+constexpr uint8_t IntFlag = 3;
+constexpr uint8_t UintFlag = 4;
+constexpr uint8_t FloatFlag = 5;
+constexpr uint8_t DecimalFlag = 6;
+constexpr uint8_t DurationFlag = 7;
+constexpr uint8_t VarintFlag = 8;
+constexpr uint8_t UvarintFlag = 9;
+constexpr uint8_t JSONFlag = 10;
+constexpr uint8_t MaxFlag = 250;
+
+constexpr uint64_t signMask = 0x8000000000000000ULL;
+
+inline uint64_t toBigEndian(uint64_t v) {
+    if constexpr (std::endian::native == std::endian::little) {
+        return __builtin_bswap64(v);
+    }
+    return v;
+}
+
+inline void appendUint64(std::string &b, uint64_t v) {
+    v = toBigEndian(v);
+    b.append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+inline uint64_t readUint64(const char *p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return toBigEndian(v);
+}
+
+// EncodeIntToCmpUint flips the sign bit so that the negative integers sort before the positive ones as unsigned.
+inline uint64_t EncodeIntToCmpUint(int64_t v) { return static_cast<uint64_t>(v) ^ signMask; }
+inline int64_t DecodeCmpUintToInt(uint64_t u) { return static_cast<int64_t>(u ^ signMask); }
+
+// EncodeInt appends the 8 big-endian bytes of v with the sign bit flipped. The Desc variants sort in reverse.
+inline void EncodeInt(std::string &b, int64_t v) { appendUint64(b, EncodeIntToCmpUint(v)); }
+inline void EncodeIntDesc(std::string &b, int64_t v) { appendUint64(b, ~EncodeIntToCmpUint(v)); }
+inline void EncodeUint(std::string &b, uint64_t v) { appendUint64(b, v); }
+inline void EncodeUintDesc(std::string &b, uint64_t v) { appendUint64(b, ~v); }
+
+inline std::tuple<int64_t, size_t> DecodeInt(std::string_view b) {
+    if (b.size() < 8) {
+        return {0, 0};
+    }
+    return {DecodeCmpUintToInt(readUint64(b.data())), 8};
+}
+
+inline std::tuple<int64_t, size_t> DecodeIntDesc(std::string_view b) {
+    if (b.size() < 8) {
+        return {0, 0};
+    }
+    return {DecodeCmpUintToInt(~readUint64(b.data())), 8};
+}
+
+inline std::tuple<uint64_t, size_t> DecodeUint(std::string_view b) {
+    if (b.size() < 8) {
+        return {0, 0};
+    }
+    return {readUint64(b.data()), 8};
+}
+
+inline std::tuple<uint64_t, size_t> DecodeUintDesc(std::string_view b) {
+    if (b.size() < 8) {
+        return {0, 0};
+    }
+    return {~readUint64(b.data()), 8};
+}
+
+// EncodeFloatToCmpUint sets the sign bit of the positive floats and inverts the negative ones, so that the floats
+// sort as unsigned integers. Both zeros encode the same.
+inline uint64_t EncodeFloatToCmpUint(double f) {
+    auto u = std::bit_cast<uint64_t>(f);
+    return f >= 0 ? u | signMask : ~u;
+}
+
+inline double DecodeCmpUintToFloat(uint64_t u) { return std::bit_cast<double>(u & signMask ? u & ~signMask : ~u); }
+
+inline void EncodeFloat(std::string &b, double f) { appendUint64(b, EncodeFloatToCmpUint(f)); }
+inline void EncodeFloatDesc(std::string &b, double f) { appendUint64(b, ~EncodeFloatToCmpUint(f)); }
+
+inline std::tuple<double, size_t> DecodeFloat(std::string_view b) {
+    if (b.size() < 8) {
+        return {0, 0};
+    }
+    return {DecodeCmpUintToFloat(readUint64(b.data())), 8};
+}
+
+inline std::tuple<double, size_t> DecodeFloatDesc(std::string_view b) {
+    if (b.size() < 8) {
+        return {0, 0};
+    }
+    return {DecodeCmpUintToFloat(~readUint64(b.data())), 8};
+}
+
+// EncodeBytes appends data in groups of 8 bytes, each followed by a marker: 0xff after a full group, 0xff minus the
+// number of zero bytes padding the last group otherwise. The last group is always padded, so a string sorts before
+// the longer strings it prefixes. The encoding takes (len(data) / 8 + 1) * 9 bytes.
+void EncodeBytes(std::string &b, std::string_view data);
+void EncodeBytesDesc(std::string &b, std::string_view data);
+
+// EncodedBytesLength returns the length of the encoding of a string of n bytes.
+constexpr size_t EncodedBytesLength(size_t n) { return (n / 8 + 1) * 9; }
+
+// DecodeBytes appends the string encoded at the start of b to out, and returns the number of bytes consumed.
+size_t DecodeBytes(std::string_view b, std::string &out);
+size_t DecodeBytesDesc(std::string_view b, std::string &out);
+
+// MaxDecimalPrecision and MaxDecimalScale are the largest precision and fractional digits of a DECIMAL.
+constexpr int MaxDecimalPrecision = 65;
+constexpr int MaxDecimalScale = 30;
+
+// EncodeDecimal appends the decimal of text, e.g. "-12.340", as a DECIMAL(precision, frac): the two bytes of
+// precision and frac, then the binary format of MySQL's decimal2bin, 4 bytes per 9 digits. Decimals only compare
+// with the decimals of the same precision and frac. A precision of 0 takes the digits of text.
+// If text is not a decimal or precision and frac are invalid, it appends nothing and returns the error. If the value
+// has more fractional digits than frac, they are truncated; if it has too many integer digits, the largest value
+// of the type is appended instead; either way a warning is returned.
+std::optional<mysql::SQLError> EncodeDecimal(std::string &b, std::string_view text, int precision = 0, int frac = 0);
+
+// DecodeDecimal returns the text of the decimal encoded at the start of b, its precision and frac, and the number of
+// bytes consumed.
+std::tuple<std::string, int, int, size_t> DecodeDecimal(std::string_view b);
+
+// DecimalBinSize returns the length of the binary format of a DECIMAL(precision, frac).
+size_t DecimalBinSize(int precision, int frac);
+
+// PeekKeyValue returns the length of the flagged value at the start of key, 0 if it is malformed.
+size_t PeekKeyValue(std::string_view key);
+
+// The Encode*Column functions append a column to the keys of its rows, keys[i] getting values[i] with its flag, or
+// NilFlag if nulls is not empty and nulls[i] is set. Encoding a column at a time keeps the dispatch on the type out
+// of the loop over the rows. keys must hold a key per value.
+void EncodeIntColumn(std::vector<std::string> &keys, std::span<const int64_t> values,
+                     std::span<const uint8_t> nulls = {});
+void EncodeUintColumn(std::vector<std::string> &keys, std::span<const uint64_t> values,
+                      std::span<const uint8_t> nulls = {});
+void EncodeFloatColumn(std::vector<std::string> &keys, std::span<const double> values,
+                       std::span<const uint8_t> nulls = {});
+void EncodeBytesColumn(std::vector<std::string> &keys, std::span<const std::string_view> values,
+                       std::span<const uint8_t> nulls = {});
+
+}  // namespace util::codec
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "xxHash/xxhash.h"
+
+// Package hash holds the hash tables of the executors. SwissMap is an open-addressing hash table in the style of
+// Abseil's Swiss tables, for the tables a single thread builds and probes, e.g. the hash table of a join or of an
+// aggregation: without the locks and the two-bucket probing of libcuckoo, a lookup is a hash, one vector compare of
+// a group of control bytes, and a key compare per candidate, which is nearly always the match.
+namespace util::hash {
+
+// XXHash hashes with XXH3: the trivially copyable keys by their bytes, the strings by their characters.
+template <typename T>
+struct XXHash {
+    static_assert(std::has_unique_object_representations_v<T>, "T must not have padding bytes");
+
+    size_t operator()(const T &v) const { return XXH3_64bits(&v, sizeof(v)); }
+};
+
+template <>
+struct XXHash<std::string_view> {
+    size_t operator()(std::string_view v) const { return XXH3_64bits(v.data(), v.size()); }
+};
+
+// XXHash<std::string> hashes a std::string_view like the string with the same characters, so that a map of strings
+// is looked up without building a string.
+template <>
+struct XXHash<std::string> {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view v) const { return XXH3_64bits(v.data(), v.size()); }
+};
+
+namespace detail {
+
+// A control byte holds the state of a slot: empty, deleted, or full with the 7 low bits of the hash of its key.
+// Empty and deleted have the sign bit set, so that both are found with one compare.
+constexpr int8_t ctrlEmpty = -128;
+constexpr int8_t ctrlDeleted = -2;
+
+// BitMask is the set of the slots of a group matching a probe, one bit per slot.
+class BitMask {
+public:
+    explicit BitMask(uint32_t mask) : _mask(mask) {}
+
+    explicit operator bool() const { return _mask != 0; }
+
+    // Lowest returns the index of the first slot of the set, which must not be empty.
+    int Lowest() const { return std::countr_zero(_mask); }
+
+    void ClearLowest() { _mask &= _mask - 1; }
+
+private:
+    uint32_t _mask;
+};
+
+// Group is the control bytes of width consecutive slots, compared at once with the widest vectors available.
+#if defined(__AVX2__)
+class Group {
+public:
+    static constexpr size_t width = 32;
+
+    explicit Group(const int8_t *ctrl) : _ctrl(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(ctrl))) {}
+
+    BitMask Match(int8_t h2) const { return mask(_mm256_cmpeq_epi8(_ctrl, _mm256_set1_epi8(h2))); }
+    BitMask MatchEmpty() const { return mask(_mm256_cmpeq_epi8(_ctrl, _mm256_set1_epi8(ctrlEmpty))); }
+    // MatchEmptyOrDeleted matches the control bytes with the sign bit set.
+    BitMask MatchEmptyOrDeleted() const { return mask(_ctrl); }
+
+private:
+    static BitMask mask(__m256i v) { return BitMask(static_cast<uint32_t>(_mm256_movemask_epi8(v))); }
+
+    __m256i _ctrl;
+};
+#elif defined(__SSE2__)
+class Group {
+public:
+    static constexpr size_t width = 16;
+
+    explicit Group(const int8_t *ctrl) : _ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrl))) {}
+
+    BitMask Match(int8_t h2) const { return mask(_mm_cmpeq_epi8(_ctrl, _mm_set1_epi8(h2))); }
+    BitMask MatchEmpty() const { return mask(_mm_cmpeq_epi8(_ctrl, _mm_set1_epi8(ctrlEmpty))); }
+    BitMask MatchEmptyOrDeleted() const { return mask(_ctrl); }
+
+private:
+    static BitMask mask(__m128i v) { return BitMask(static_cast<uint32_t>(_mm_movemask_epi8(v))); }
+
+    __m128i _ctrl;
+};
+#else
+// The portable group compares 8 control bytes in a word. Its masks have one bit per slot like the others.
+class Group {
+public:
+    static constexpr size_t width = 8;
+
+    explicit Group(const int8_t *ctrl) { std::memcpy(&_ctrl, ctrl, sizeof(_ctrl)); }
+
+    BitMask Match(int8_t h2) const {
+        // The bytes equal to h2 are zero in x, found with the classic has-zero-byte test. A borrow may report a byte
+        // after a match too: the key compare filters those out.
+        uint64_t x = _ctrl ^ (lsbs * static_cast<uint8_t>(h2));
+        return mask((x - lsbs) & ~x & msbs);
+    }
+    BitMask MatchEmpty() const { return mask(_ctrl & (~_ctrl << 6) & msbs); }
+    BitMask MatchEmptyOrDeleted() const { return mask(_ctrl & msbs); }
+
+private:
+    static constexpr uint64_t lsbs = 0x0101010101010101ULL;
+    static constexpr uint64_t msbs = 0x8080808080808080ULL;
+
+    // mask gathers the high bit of every byte into the low byte.
+    static BitMask mask(uint64_t highBits) {
+        if constexpr (std::endian::native == std::endian::big) {
+            highBits = __builtin_bswap64(highBits);
+        }
+        return BitMask(static_cast<uint32_t>(((highBits >> 7) * 0x0102040810204080ULL) >> 56));
+    }
+
+    uint64_t _ctrl;
+};
+#endif
+
+}  // namespace detail
+
+// SwissMap maps keys to values with open addressing. The slots are split in groups of Group::width, each with its
+// array of control bytes; a key is looked for from the group of the high bits of its hash, comparing the low 7 bits
+// with the control bytes of a whole group at once, and the groups are probed quadratically until one with an empty
+// slot. The keys and the values are stored inline in the slots, so a match costs one more cache miss at most.
+// The table grows by doubling when it is 7/8 full. Inserting or erasing invalidates the pointers into the table.
+// It is not thread-safe.
+template <typename Key, typename Value, typename Hash = XXHash<Key>, typename Equal = std::equal_to<>>
+class SwissMap {
+public:
+    using value_type = std::pair<Key, Value>;
+
+    explicit SwissMap(size_t capacity = 0, const Hash &hash = Hash(), const Equal &equal = Equal())
+        : _hash(hash), _equal(equal) {
+        Reserve(capacity);
+    }
+
+    ~SwissMap() { destroy(); }
+
+    SwissMap(SwissMap &&other) noexcept { *this = std::move(other); }
+    SwissMap &operator=(SwissMap &&other) noexcept {
+        if (this != &other) {
+            destroy();
+            _hash = std::move(other._hash);
+            _equal = std::move(other._equal);
+            _ctrl = std::move(other._ctrl);
+            _slots = std::exchange(other._slots, nullptr);
+            _capacity = std::exchange(other._capacity, 0);
+            _size = std::exchange(other._size, 0);
+            _growthLeft = std::exchange(other._growthLeft, 0);
+        }
+        return *this;
+    }
+
+    SwissMap(const SwissMap &) = delete;
+    SwissMap &operator=(const SwissMap &) = delete;
+
+    size_t Size() const { return _size; }
+    bool Empty() const { return _size == 0; }
+
+    // Capacity returns the number of slots.
+    size_t Capacity() const { return _capacity; }
+
+    // Reserve makes room for n entries, so that inserting them does not grow the table.
+    void Reserve(size_t n) {
+        if (n > _size + _growthLeft) {
+            resize(capacityFor(n));
+        }
+    }
+
+    // Find returns the value of key, null if it does not exist. key may be of another type than Key that Hash and
+    // Equal take, e.g. a std::string_view for std::string keys.
+    template <typename K>
+    Value *Find(const K &key) {
+        auto i = find(key, _hash(key));
+        return i == npos ? nullptr : &_slots[i].second;
+    }
+    template <typename K>
+    const Value *Find(const K &key) const {
+        return const_cast<SwissMap *>(this)->Find(key);
+    }
+
+    template <typename K>
+    bool Contains(const K &key) const {
+        return Find(key) != nullptr;
+    }
+
+    // TryEmplace returns the value of key, and whether it was inserted: if key does not exist, it is inserted with
+    // the value constructed from args.
+    template <typename K, typename... Args>
+    std::pair<Value *, bool> TryEmplace(K &&key, Args &&...args) {
+        auto h = _hash(key);
+        if (auto i = find(key, h); i != npos) {
+            return {&_slots[i].second, false};
+        }
+        auto i = prepareInsert(h);
+        new (&_slots[i]) value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                                    std::forward_as_tuple(std::forward<Args>(args)...));
+        return {&_slots[i].second, true};
+    }
+
+    // operator[] returns the value of key, inserting a value-initialized one if it does not exist.
+    template <typename K>
+    Value &operator[](K &&key) {
+        return *TryEmplace(std::forward<K>(key)).first;
+    }
+
+    // InsertOrAssign sets the value of key, returning whether it was inserted.
+    template <typename K, typename V>
+    bool InsertOrAssign(K &&key, V &&value) {
+        auto [v, inserted] = TryEmplace(std::forward<K>(key), std::forward<V>(value));
+        if (!inserted) {
+            *v = std::forward<V>(value);
+        }
+        return inserted;
+    }
+
+    // Erase removes key, returning whether it existed.
+    template <typename K>
+    bool Erase(const K &key) {
+        auto i = find(key, _hash(key));
+        if (i == npos) {
+            return false;
+        }
+        _slots[i].~value_type();
+        _size--;
+        // A lookup stops at the first group with an empty slot: if the group has one, no key was pushed past it and
+        // the slot can be emptied; otherwise it is marked deleted, for the lookups to go on.
+        auto group = i & ~(detail::Group::width - 1);
+        if (detail::Group(&_ctrl[group]).MatchEmpty()) {
+            _ctrl[i] = detail::ctrlEmpty;
+            _growthLeft++;
+        } else {
+            _ctrl[i] = detail::ctrlDeleted;
+        }
+        return true;
+    }
+
+    // ForEach calls fn(key, value) on every entry, in no particular order.
+    template <typename F>
+    void ForEach(F fn) {
+        for (size_t i = 0; i < _capacity; i++) {
+            if (_ctrl[i] >= 0) {
+                fn(std::as_const(_slots[i].first), _slots[i].second);
+            }
+        }
+    }
+
+    // Clear removes the entries and keeps the slots.
+    void Clear() {
+        destroyEntries();
+        std::fill(_ctrl.begin(), _ctrl.end(), detail::ctrlEmpty);
+        _size = 0;
+        _growthLeft = maxLoad(_capacity);
+    }
+
+private:
+    static constexpr size_t npos = ~size_t{0};
+
+    // maxLoad returns the number of entries a table of capacity slots holds before growing.
+    static size_t maxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+    // capacityFor returns the number of slots of a table for n entries: a power of two, at least a group.
+    static size_t capacityFor(size_t n) {
+        auto capacity = std::bit_ceil(std::max(n + n / 7 + 1, detail::Group::width));
+        return maxLoad(capacity) < n ? capacity * 2 : capacity;
+    }
+
+    static int8_t h2(size_t hash) { return static_cast<int8_t>(hash & 0x7f); }
+
+    // firstGroup returns the first group probed for hash, from its high bits: the low ones are h2.
+    size_t firstGroup(size_t hash) const { return (hash >> 7) & (_capacity / detail::Group::width - 1); }
+
+    template <typename K>
+    size_t find(const K &key, size_t hash) const {
+        if (_capacity == 0) {
+            return npos;
+        }
+        auto groupMask = _capacity / detail::Group::width - 1;
+        auto g = firstGroup(hash);
+        // The triangular steps visit every group once, the number of groups being a power of two.
+        for (size_t step = 1;; step++) {
+            detail::Group group(&_ctrl[g * detail::Group::width]);
+            for (auto m = group.Match(h2(hash)); m; m.ClearLowest()) {
+                auto i = g * detail::Group::width + m.Lowest();
+                if (_equal(_slots[i].first, key)) [[likely]] {
+                    return i;
+                }
+            }
+            if (group.MatchEmpty()) [[likely]] {
+                return npos;
+            }
+            g = (g + step) & groupMask;
+        }
+    }
+
+    // prepareInsert returns a free slot for a new key of hash, growing the table if it is full, and marks it full.
+    size_t prepareInsert(size_t hash) {
+        auto i = findFree(hash);
+        if (i == npos || (_growthLeft == 0 && _ctrl[i] != detail::ctrlDeleted)) {
+            // The deleted slots are dropped on resize: the table only grows if the entries take its room.
+            resize(capacityFor(_size + 1));
+            i = findFree(hash);
+        }
+        if (_ctrl[i] == detail::ctrlEmpty) {
+            _growthLeft--;
+        }
+        _ctrl[i] = h2(hash);
+        _size++;
+        return i;
+    }
+
+    // findFree returns the first empty or deleted slot on the probe sequence of hash, npos if there are no slots.
+    size_t findFree(size_t hash) const {
+        if (_capacity == 0) {
+            return npos;
+        }
+        auto groupMask = _capacity / detail::Group::width - 1;
+        auto g = firstGroup(hash);
+        for (size_t step = 1;; step++) {
+            if (auto m = detail::Group(&_ctrl[g * detail::Group::width]).MatchEmptyOrDeleted()) {
+                return g * detail::Group::width + m.Lowest();
+            }
+            g = (g + step) & groupMask;
+        }
+    }
+
+    void resize(size_t capacity) {
+        auto oldCtrl = std::move(_ctrl);
+        auto *oldSlots = _slots;
+        auto oldCapacity = _capacity;
+
+        _ctrl.assign(capacity, detail::ctrlEmpty);
+        _slots = std::allocator<value_type>().allocate(capacity);
+        _capacity = capacity;
+        _growthLeft = maxLoad(capacity) - _size;
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (oldCtrl[i] >= 0) {
+                auto h = _hash(oldSlots[i].first);
+                auto j = findFree(h);
+                _ctrl[j] = h2(h);
+                new (&_slots[j]) value_type(std::move(oldSlots[i]));
+                oldSlots[i].~value_type();
+            }
+        }
+        if (oldSlots != nullptr) {
+            std::allocator<value_type>().deallocate(oldSlots, oldCapacity);
+        }
+    }
+
+    void destroyEntries() {
+        if constexpr (!std::is_trivially_destructible_v<value_type>) {
+            for (size_t i = 0; i < _capacity; i++) {
+                if (_ctrl[i] >= 0) {
+                    _slots[i].~value_type();
+                }
+            }
+        }
+    }
+
+    void destroy() {
+        destroyEntries();
+        if (_slots != nullptr) {
+            std::allocator<value_type>().deallocate(_slots, _capacity);
+        }
+    }
+
+    Hash _hash;
+    Equal _equal;
+    // _ctrl holds the control byte of every slot.
+    std::vector<int8_t> _ctrl;
+    value_type *_slots{nullptr};
+    size_t _capacity{0};
+    size_t _size{0};
+    // _growthLeft is the number of empty slots that can be filled before the table grows.
+    size_t _growthLeft{0};
+};
+
+}  // namespace util::hash
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+#include "parser/mysql/error.hh"
+
+namespace madoka {
+class Sketch;
+}  // namespace madoka
+
+namespace util::sketch {
+
+// CountMinSketch estimates the number of occurrences of byte strings, with the count-min sketch of madoka: 3 rows of
+// Width() counters, a key adding its count to a counter of each row chosen by a hash of the row. The estimate of a key
+// is the least of its counters, which is never below its count, and above it by less than e / Width() of the total
+// count, 0.13% for the default width, with a probability of 95%.
+//
+// The counters take the fewest bits that hold the largest value, e.g. 4 bits for a largest value of 15, and saturate
+// at it: when the largest count is known, the estimates can only get closer to the counts.
+class CountMinSketch {
+public:
+    static constexpr uint64_t defaultWidth = 2048;
+
+    // A CountMinSketch of width counters per row holding up to maxValue.
+    explicit CountMinSketch(uint64_t width = defaultWidth, uint64_t maxValue = UINT32_MAX, uint64_t seed = 0);
+    ~CountMinSketch();
+
+    CountMinSketch(CountMinSketch &&) noexcept;
+    CountMinSketch &operator=(CountMinSketch &&) noexcept;
+
+    void Add(std::string_view key, uint64_t count = 1);
+
+    // Get returns the estimated count of key.
+    uint64_t Get(std::string_view key) const;
+
+    uint64_t Width() const;
+    uint64_t MaxValue() const;
+
+    // Bytes returns the size of the sketch, in memory as in its file.
+    size_t Bytes() const;
+
+    // Save writes the sketch to the file at path, in the format of madoka.
+    std::optional<mysql::SQLError> Save(const std::string &path) const;
+
+    // Open maps the sketch saved at path read-only: its pages are read as the keys are looked up.
+    static std::tuple<std::unique_ptr<CountMinSketch>, std::optional<mysql::SQLError>> Open(const std::string &path);
+
+private:
+    explicit CountMinSketch(std::unique_ptr<madoka::Sketch> sketch);
+
+    std::unique_ptr<madoka::Sketch> _sketch;
+};
+
+}  // namespace util::sketch
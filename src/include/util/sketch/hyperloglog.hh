@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace libcount {
+class HLL;
+}  // namespace libcount
+
+// Package sketch holds the sketches of the approximate aggregates and of the statistics: small summaries of many
+// values that answer a question about them within a known error, and that merge, so that each thread or region can
+// summarize its own values.
+namespace util::sketch {
+
+// HyperLogLog estimates the number of distinct values from their 64-bit hashes, on the HyperLogLog++ of libcount.
+//
+// The registers, 2^precision bytes, are only allocated after maxSparse distinct hashes: until then the hashes are
+// kept, and counted exactly, so that the many small groups of an aggregation take little memory.
+class HyperLogLog {
+public:
+    // defaultPrecision gives 2^14 registers, for a standard error of 0.8%.
+    static constexpr int defaultPrecision = 14;
+    static constexpr size_t maxSparse = 256;
+
+    // A HyperLogLog of precision, in [4, 18].
+    explicit HyperLogLog(int precision = defaultPrecision);
+    ~HyperLogLog();
+
+    HyperLogLog(HyperLogLog &&) noexcept;
+    HyperLogLog &operator=(HyperLogLog &&) noexcept;
+
+    // Update adds a value of hash, which must be uniform over all 64 bits.
+    void Update(uint64_t hash);
+
+    // Merge adds the values of other, of the same precision.
+    void Merge(const HyperLogLog &other);
+
+    // Estimate returns the estimated number of distinct values.
+    uint64_t Estimate() const;
+
+    // IsSparse returns whether the registers are not allocated yet.
+    bool IsSparse() const { return _hll == nullptr; }
+
+private:
+    // compact sorts and deduplicates the hashes, allocating the registers if there are more than maxSparse.
+    void compact();
+    void densify();
+
+    int _precision;
+    // _sparse are the hashes while sparse, with duplicates since the last compact.
+    std::vector<uint64_t> _sparse;
+    std::unique_ptr<libcount::HLL> _hll;
+};
+
+}  // namespace util::sketch
@@ -0,0 +1,153 @@
+#include "metrics/metrics.hh"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <utility>
+
+namespace metrics {
+
+namespace {
+
+// registry holds the registered metrics. It is a function static so that metrics defined in any translation unit
+// can register during static initialization.
+struct registry {
+    std::mutex mu;
+    std::vector<const Metric *> metrics;
+};
+
+registry &defaultRegistry() {
+    static registry r;
+    return r;
+}
+
+// exportedQuantiles are the quantiles of the histograms.
+constexpr double exportedQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+}  // namespace
+
+size_t shardIndex() {
+    static std::atomic<size_t> nextShard{0};
+    thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % numShards;
+    return shard;
+}
+
+Metric::Metric(std::string_view name, std::string_view help, std::string_view labels)
+    : _name(name), _help(help), _labels(labels) {
+    auto &r = defaultRegistry();
+    std::lock_guard lock(r.mu);
+    r.metrics.push_back(this);
+}
+
+void Metric::writeSample(std::string &out, std::string_view suffix, std::string_view extraLabel, double value) const {
+    out += _name;
+    out += suffix;
+    if (!_labels.empty() || !extraLabel.empty()) {
+        out += '{';
+        out += _labels;
+        if (!_labels.empty() && !extraLabel.empty()) {
+            out += ',';
+        }
+        out += extraLabel;
+        out += '}';
+    }
+    out += fmt::format(" {}\n", value);
+}
+
+uint64_t Counter::Value() const {
+    uint64_t v = 0;
+    for (auto &s : _shards) {
+        v += s.value.load(std::memory_order_relaxed);
+    }
+    return v;
+}
+
+void Counter::WriteSamples(std::string &out) const { writeSample(out, "", "", static_cast<double>(Value())); }
+
+int64_t Gauge::Value() const {
+    int64_t v = 0;
+    for (auto &s : _shards) {
+        v += s.value.load(std::memory_order_relaxed);
+    }
+    return v;
+}
+
+void Gauge::WriteSamples(std::string &out) const { writeSample(out, "", "", static_cast<double>(Value())); }
+
+GaugeFunc::GaugeFunc(std::string_view name, std::string_view help, std::string_view labels, std::function<double()> fn)
+    : Metric(name, help, labels), _fn(std::move(fn)) {}
+
+void GaugeFunc::WriteSamples(std::string &out) const { writeSample(out, "", "", Value()); }
+
+uint64_t HistogramSnapshot::Percentile(double q) const {
+    if (Count == 0) {
+        return 0;
+    }
+    auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(Count))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < Buckets.size(); i++) {
+        seen += Buckets[i];
+        if (seen >= rank) {
+            return Histogram::bucketUpperBound(i);
+        }
+    }
+    return Histogram::bucketUpperBound(Buckets.size() - 1);
+}
+
+Histogram::Histogram(std::string_view name, std::string_view help, std::string_view labels, double unit)
+    : Metric(name, help, labels), _unit(unit) {}
+
+uint64_t Histogram::bucketUpperBound(size_t i) {
+    if (i < subBuckets) {
+        return i;
+    }
+    size_t shift = i / subBuckets - 1;
+    uint64_t lower = static_cast<uint64_t>(subBuckets + i % subBuckets) << shift;
+    return lower + ((uint64_t{1} << shift) - 1);
+}
+
+HistogramSnapshot Histogram::Snapshot() const {
+    HistogramSnapshot snapshot;
+    snapshot.Buckets.resize(numBuckets);
+    for (auto &s : _shards) {
+        // The sum and the buckets are read separately: a concurrent observation may be in one and not the other.
+        snapshot.Sum += s.sum.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < numBuckets; i++) {
+            auto n = s.buckets[i].load(std::memory_order_relaxed);
+            snapshot.Buckets[i] += n;
+            snapshot.Count += n;
+        }
+    }
+    return snapshot;
+}
+
+void Histogram::WriteSamples(std::string &out) const {
+    auto snapshot = Snapshot();
+    for (auto q : exportedQuantiles) {
+        writeSample(out, "", fmt::format("quantile=\"{}\"", q), static_cast<double>(snapshot.Percentile(q)) * _unit);
+    }
+    writeSample(out, "_sum", "", static_cast<double>(snapshot.Sum) * _unit);
+    writeSample(out, "_count", "", static_cast<double>(snapshot.Count));
+}
+
+void WritePrometheus(std::string &out) {
+    auto &r = defaultRegistry();
+    std::vector<const Metric *> metrics;
+    {
+        std::lock_guard lock(r.mu);
+        metrics = r.metrics;
+    }
+    // The samples of a family must be contiguous.
+    std::stable_sort(metrics.begin(), metrics.end(), [](auto a, auto b) { return a->Name() < b->Name(); });
+    for (size_t i = 0; i < metrics.size(); i++) {
+        auto m = metrics[i];
+        if (i == 0 || metrics[i - 1]->Name() != m->Name()) {
+            out += fmt::format("# HELP {} {}\n# TYPE {} {}\n", m->Name(), m->Help(), m->Name(), m->Type());
+        }
+        m->WriteSamples(out);
+    }
+}
+
+}  // namespace metrics
@@ -0,0 +1,54 @@
+#include "metrics/server.hh"
+
+#include <fmt/format.h>
+
+#include <memory>
+
+#include "parser/mysql/const.hh"
+
+namespace metrics {
+
+namespace {
+
+constexpr double nanosecond = 1e-9;
+
+constexpr const char *phaseNames[] = {"lex", "parse", "execute", "network"};
+static_assert(std::size(phaseNames) == static_cast<size_t>(Phase::NumPhases));
+
+std::array<std::unique_ptr<Histogram>, static_cast<size_t>(Phase::NumPhases)> phaseDurations = [] {
+    std::array<std::unique_ptr<Histogram>, static_cast<size_t>(Phase::NumPhases)> histograms;
+    for (size_t i = 0; i < histograms.size(); i++) {
+        histograms[i] = std::make_unique<Histogram>(
+            "pxtidb_server_phase_duration_seconds",
+            "Bucketed histogram of the time spent in each phase of a statement.",
+            fmt::format("phase=\"{}\"", phaseNames[i]), nanosecond);
+    }
+    return histograms;
+}();
+
+std::array<std::unique_ptr<Counter>, mysql::ComEnd> commandCounters = [] {
+    std::array<std::unique_ptr<Counter>, mysql::ComEnd> counters;
+    for (size_t i = 0; i < counters.size(); i++) {
+        counters[i] = std::make_unique<Counter>("pxtidb_server_command_total", "Counter of the commands by type.",
+                                                fmt::format("type=\"{}\"", mysql::Command2Str[i]));
+    }
+    return counters;
+}();
+
+}  // namespace
+
+Histogram &PhaseDuration(Phase phase) { return *phaseDurations[static_cast<size_t>(phase)]; }
+
+Counter &CommandCounter(uint8_t cmd) { return *commandCounters[cmd]; }
+
+Histogram CommandDuration("pxtidb_server_handle_command_duration_seconds",
+                          "Bucketed histogram of the processing time of the commands.", "", nanosecond);
+
+Gauge Connections("pxtidb_server_connections", "Number of open connections.", "");
+
+Counter SlowQueries("pxtidb_server_slow_query_total", "Counter of the statements logged as slow queries.", "");
+
+Counter SlowQueriesDropped("pxtidb_server_slow_query_dropped_total",
+                           "Counter of the slow queries dropped because the slow query log was full.", "");
+
+}  // namespace metrics
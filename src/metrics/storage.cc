@@ -0,0 +1,20 @@
+#include "metrics/storage.hh"
+
+namespace metrics {
+
+Gauge HandleIndexEntries("pxtidb_storage_handle_index_entries", "Number of entries of the hash indexes of the handles.",
+                         "");
+
+Gauge HandleIndexSlots("pxtidb_storage_handle_index_slots", "Number of slots of the hash indexes of the handles.", "");
+
+GaugeFunc HandleIndexLoadFactor("pxtidb_storage_handle_index_load_factor",
+                                "Ratio of the entries to the slots of the hash indexes of the handles.", "", [] {
+                                    auto slots = HandleIndexSlots.Value();
+                                    if (slots <= 0) {
+                                        return 0.0;
+                                    }
+                                    return static_cast<double>(HandleIndexEntries.Value()) /
+                                           static_cast<double>(slots);
+                                });
+
+}  // namespace metrics
@@ -0,0 +1,225 @@
+#include "parser/digester.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <vector>
+
+#include "parser/scanner.hh"
+#include "parser/token.hh"
+#include "xxHash/xxhash.h"
+
+namespace parser {
+
+namespace {
+
+enum : int {
+    genericSymbol = -1,
+    genericSymbolList = -2,
+};
+
+struct token {
+    int tok;
+    std::string lit;
+};
+
+std::string toLower(std::string str) {
+    std::transform(str.begin(), str.end(), str.begin(), [](unsigned char ch) { return std::tolower(ch); });
+    return str;
+}
+
+// sqlDigester is used to compute DigestHash or Normalize for sql.
+class sqlDigester {
+public:
+    std::string normalize(const std::string &sql) {
+        _lexer.reset(sql);
+        while (true) {
+            auto [tok, pos, lit] = _lexer.scan();
+            if (tok == tok_invalid || tok == 0 || static_cast<size_t>(pos._offset) == sql.length()) {
+                break;
+            }
+            token currTok{tok, toLower(lit)};
+            if (reduceOptimizerHint(currTok)) {
+                continue;
+            }
+            reduceLit(currTok);
+            if (currTok.tok == tok_identifier) {
+                if (auto tok1 = _lexer.isTokenIdentifier(currTok.lit, pos._offset); tok1 != 0) {
+                    currTok.tok = tok1;
+                }
+            }
+            _tokens.push_back(std::move(currTok));
+        }
+
+        std::string normalized;
+        for (size_t i = 0; i < _tokens.size(); i++) {
+            normalized += _tokens[i].lit;
+            if (i != _tokens.size() - 1) {
+                normalized += ' ';
+            }
+        }
+        _tokens.clear();
+        return normalized;
+    }
+
+private:
+    // back returns the last n tokens, or nullptr if there are less than n.
+    const token *back(size_t n) const { return _tokens.size() < n ? nullptr : &_tokens[_tokens.size() - n]; }
+
+    void popBack(size_t n) { _tokens.resize(_tokens.size() < n ? 0 : _tokens.size() - n); }
+
+    bool reduceOptimizerHint(token &tok) {
+        // ignore force/use/ignore index(x)
+        if (auto last = back(1); tok.lit == "index" && last != nullptr) {
+            if (last->lit == "force" || last->lit == "use" || last->lit == "ignore") {
+                while (true) {
+                    auto [tok1, pos, lit] = _lexer.scan();
+                    if (tok1 == 0 || tok1 == tok_invalid) {
+                        return false;
+                    }
+                    if (lit == ")") {
+                        popBack(1);
+                        return true;
+                    }
+                }
+            }
+        }
+        // ignore straight_join
+        if (tok.lit == "straight_join") {
+            tok.lit = "join";
+        }
+        return false;
+    }
+
+    void reduceLit(token &currTok) {
+        if (!isLit(currTok)) {
+            return;
+        }
+        // count(*) => count(?)
+        if (currTok.lit == "*") {
+            if (isStarParam()) {
+                currTok.tok = genericSymbol;
+                currTok.lit = "?";
+            }
+            return;
+        }
+
+        // "-x" or "+x" => "x"
+        if (isPrefixByUnary(currTok.tok)) {
+            popBack(1);
+        }
+
+        // "?, ?, ?, ?" => "..."
+        if (isGenericList()) {
+            popBack(2);
+            currTok.tok = genericSymbolList;
+            currTok.lit = "...";
+            return;
+        }
+
+        // order by n => order by n
+        if (currTok.tok == tok_intLit && isOrderOrGroupBy()) {
+            return;
+        }
+
+        // 2 => ?
+        currTok.tok = genericSymbol;
+        currTok.lit = "?";
+    }
+
+    static bool isNumLit(int tok) {
+        return tok == tok_intLit || tok == tok_decLit || tok == tok_floatLit || tok == tok_hexLit;
+    }
+
+    static bool isLit(const token &t) {
+        return isNumLit(t.tok) || t.tok == tok_stringLit || t.tok == tok_bitLit || t.tok == tok_paramMarker ||
+               t.lit == "*" || t.tok == tok_null || (t.tok == tok_identifier && t.lit == "null");
+    }
+
+    bool isPrefixByUnary(int currTok) const {
+        if (!isNumLit(currTok)) {
+            return false;
+        }
+        auto last = back(1);
+        if (last == nullptr || (last->tok != '-' && last->tok != '+')) {
+            return false;
+        }
+        auto last2 = back(2);
+        if (last2 == nullptr) {
+            return true;
+        }
+        // '(-x' or ',-x' or ',+x' or '--x' or '+-x'
+        for (auto op : {"(", ",", "+", "-", ">=", "is", "<=", "=", "<", ">", "select"}) {
+            if (last2->lit == op) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool isGenericList() const {
+        auto last2 = back(2);
+        if (last2 == nullptr || last2[1].lit != ",") {
+            return false;
+        }
+        return last2[0].tok == genericSymbol || last2[0].tok == genericSymbolList;
+    }
+
+    bool isOrderOrGroupBy() const {
+        // skip number item lists, e.g. "order by 1, 2, 3" should NOT convert to "order by ?, ?, ?"
+        const token *last;
+        size_t n = 2;
+        for (;; n += 2) {
+            last = back(n);
+            if (last == nullptr) {
+                return false;
+            }
+            if (last[1].lit != ",") {
+                break;
+            }
+        }
+        // handle group by number item list surround by "()", e.g. "group by (1, 2)" should not convert to
+        // "group by (?, ?)"
+        if (last[1].lit == "(") {
+            last = back(n + 1);
+            if (last == nullptr) {
+                return false;
+            }
+        }
+        return (last[0].lit == "order" || last[0].lit == "group") && last[1].lit == "by";
+    }
+
+    bool isStarParam() const {
+        auto last = back(1);
+        return last != nullptr && last->lit == "(";
+    }
+
+    Scanner _lexer;
+    std::vector<token> _tokens;
+};
+
+}  // namespace
+
+std::string Digest::String() const {
+    static constexpr char hex[] = "0123456789abcdef";
+    std::string str(32, '0');
+    for (int i = 0; i < 16; i++) {
+        str[15 - i] = hex[(_high >> (i * 4)) & 0xf];
+        str[31 - i] = hex[(_low >> (i * 4)) & 0xf];
+    }
+    return str;
+}
+
+std::string Normalize(const std::string &sql) { return sqlDigester().normalize(sql); }
+
+std::tuple<std::string, Digest> NormalizeDigest(const std::string &sql) {
+    auto normalized = Normalize(sql);
+    auto digest = DigestNormalized(normalized);
+    return {std::move(normalized), digest};
+}
+
+Digest DigestNormalized(std::string_view normalized) {
+    auto hash = XXH3_128bits(normalized.data(), normalized.length());
+    return {hash.high64, hash.low64};
+}
+
+}  // namespace parser
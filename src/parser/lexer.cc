@@ -92,25 +92,17 @@ std::tuple<int, common::utf8::Pos, std::string> startWithSlash(Scanner &s) {
         case 'M':  // '/*M' maybe MariaDB-specific comments
             // no special treatment for now.
             break;
-            //  todo: not implemented yet
-            //        case '+': // '/*+' optimizer hints
-            //            // See https://dev.mysql.com/doc/refman/5.7/en/optimizer-hints.html
-            //            if _, ok := hintedTokens[s.lastKeyword]; ok {
-            //                // only recognize optimizers hints directly followed by certain
-            //                // keywords like SELECT, INSERT, etc., only a special case "FOR UPDATE" needs to be
-            //                handled
-            //                // we will report a warning in order to match MySQL's behavior, but the hint content will
-            //                be ignored if s.lastKeyword2 == forKwd {
-            //                    if s.lastKeyword3 == binding {
-            //                                // special case of `create binding for update`
-            //                                isOptimizerHint = true
-            //                        } else {
-            //                        s.warns = append(s.warns, ParseErrorWith(s.r.data(&pos), s.r.p.Line))
-            //                    }
-            //                } else {
-            //                    isOptimizerHint = true
-            //                }
-            //        }
+        case '+':  // '/*+' optimizer hints
+            // See https://dev.mysql.com/doc/refman/5.7/en/optimizer-hints.html
+            // only recognize optimizers hints directly followed by certain
+            // keywords like SELECT, INSERT, etc., only a special case "FOR UPDATE" needs to be handled.
+            // The hint content is ignored after FOR UPDATE, except for `create binding for update`.
+            if (isHintedToken(s._lastKeyword)) {
+                if (s._lastKeyword2 != tok_forKwd || s._lastKeyword3 == tok_binding) {
+                    isOptimizerHint = true;
+                }
+            }
+            break;
 
         case '*':  // '/**' if the next char is '/' it would close the comment.
             currentCharIsStar = true;
@@ -160,7 +152,18 @@ std::tuple<int, common::utf8::Pos, std::string> startWithStar(Scanner &s) {
     return {'*', pos, "*"};
 }
 
-std::tuple<int, common::utf8::Pos, std::string> startWithDash(Scanner &s) { return {}; }
+std::tuple<int, common::utf8::Pos, std::string> startWithDash(Scanner &s) {
+    auto pos = s.reader()->pos();
+    auto prefix = s.reader()->make_slice(s.reader()->index(), 3);
+    // '-- ' starts a comment which lasts until the end of the line.
+    // See https://dev.mysql.com/doc/refman/5.7/en/ansi-diff-comments.html
+    if (prefix.starts_with("--") && (prefix.length() == 2 || isSpace(prefix[2]))) {
+        s.reader()->incAsLongAs([](common::utf8::rune_t ch) { return ch != '\n'; });
+        return s.scan();
+    }
+    s.reader()->next();
+    return {'-', pos, "-"};
+}
 
 std::tuple<int, common::utf8::Pos, std::string> startWithSharp(Scanner &s) {
     s.reader()->incAsLongAs([](common::utf8::rune_t ch) { return ch != '\n'; });
@@ -223,7 +226,21 @@ std::tuple<int, common::utf8::Pos, std::string> startWithBb(Scanner &s) {
     return scanIdentifier(s);
 }
 
-std::tuple<int, common::utf8::Pos, std::string> startWithDot(Scanner &s) { return {}; }
+std::tuple<int, common::utf8::Pos, std::string> startWithDot(Scanner &s) {
+    auto pos = s.reader()->pos();
+    s.reader()->next();
+    if (s._identifierDot) {
+        return {'.', pos, "."};
+    }
+    if (isDigit(s.reader()->peek())) {
+        auto [tok, p, lit] = s.scanFloat(pos);
+        if (tok == tok_identifier) {
+            return {tok_invalid, p, lit};
+        }
+        return {tok, p, lit};
+    }
+    return {'.', pos, "."};
+}
 
 std::tuple<int, common::utf8::Pos, std::string> scanIdentifier(Scanner &scanner) {
     auto pos = scanner.reader()->pos();
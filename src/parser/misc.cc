@@ -1,5 +1,7 @@
 #include "parser/misc.hh"
 
+#include <cctype>
+
 #include "parser/lexer.hh"
 #include "parser/scanner.hh"
 #include "parser/token.hh"
@@ -921,8 +923,74 @@ int Scanner::isTokenIdentifier(std::string lit, int offset) {
     if (_reader->curr() == '.') {
         return 0;
     }
+    if (offset > 0 && _reader->make_slice(offset - 1, 1) == ".") {
+        return 0;
+    }
 
-    return {};
+    for (auto &ch : lit) {
+        if (ch >= 'a' && ch <= 'z') {
+            ch = ch + 'A' - 'a';
+        }
+    }
+
+    bool checkBtFuncToken = _reader->peek() == '(';
+    if (!checkBtFuncToken && _sqlMode.HasIgnoreSpaceMode()) {
+        skipWhitespace();
+        if (_reader->peek() == '(') {
+            checkBtFuncToken = true;
+        }
+    }
+    if (checkBtFuncToken) {
+        if (auto it = btFuncTokenMap.find(lit); it != btFuncTokenMap.end()) {
+            return it->second;
+        }
+    }
+    if (auto it = tokenMap.find(lit); it != tokenMap.end()) {
+        return it->second;
+    }
+    if (_supportWindowFunc) {
+        if (auto it = windowFuncTokenMap.find(lit); it != windowFuncTokenMap.end()) {
+            return it->second;
+        }
+    }
+    return 0;
+}
+
+bool isHintedToken(int tok) { return hintedTokens.find(tok) != hintedTokens.end(); }
+
+int getHintToken(std::string name) {
+    for (auto &ch : name) {
+        if (ch >= 'a' && ch <= 'z') {
+            ch = ch + 'A' - 'a';
+        }
+    }
+    auto it = hintTokenMap.find(name);
+    return it == hintTokenMap.end() ? 0 : it->second;
+}
+
+std::vector<int> getHintTokens(const std::string &lit) {
+    std::vector<int> toks;
+    size_t i = 0;
+    while (i < lit.length()) {
+        if (!std::isalpha(static_cast<unsigned char>(lit[i])) && lit[i] != '_') {
+            i++;
+            continue;
+        }
+        auto begin = i;
+        while (i < lit.length() && (std::isalnum(static_cast<unsigned char>(lit[i])) || lit[i] == '_')) {
+            i++;
+        }
+        auto name = lit.substr(begin, i - begin);
+        while (i < lit.length() && std::isspace(static_cast<unsigned char>(lit[i]))) {
+            i++;
+        }
+        if (i < lit.length() && lit[i] == '(') {
+            if (auto tok = getHintToken(name); tok != 0) {
+                toks.push_back(tok);
+            }
+        }
+    }
+    return toks;
 }
 
-}  // namespace parser
\ No newline at end of file
+}  // namespace parser
@@ -1,9 +1,18 @@
+#include "parser/mysql/const.hh"
+
 #include <fmt/format.h>
 
 #include <string>
 
 namespace mysql {
 std::string TiDBReleaseVersion = "None";
-std::string ServerVersion = fmt::format("5.7.25-TiDB-%s", TiDBReleaseVersion);
+std::string ServerVersion = fmt::format("5.7.25-TiDB-{}", TiDBReleaseVersion);
+
+const std::array<std::string_view, ComEnd> Command2Str = {
+    "Sleep", "Quit", "Init DB", "Query", "Field List", "Create DB", "Drop DB", "Refresh", "Shutdown", "Statistics",
+    "Processlist", "Connect", "Kill", "Debug", "Ping", "Time", "Delayed Insert", "Change User", "Binlog Dump",
+    "Table Dump", "Connect out", "Register Slave", "Prepare", "Execute", "Long Data", "Close stmt", "Reset stmt",
+    "Set option", "Fetch", "Daemon", "Binlog Dump GTID", "Reset connect",
+};
 
 }  // namespace mysql
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include "parser/mysql/error.hh"
+
+namespace mysql {
+
+std::unordered_map<uint16_t, std::string> MySQLState = {
+    {ErrDupEntry, "23000"},
+    {ErrDataTooLong, "22001"},
+    {ErrDataOutOfRange, "22003"},
+    {ErrTruncatedWrongValue, "22007"},
+    {ErrBadNull, "23000"},
+    {ErrUnknownCom, "08S01"},
+    {ErrUnknownStmtHandler, "HY000"},
+    {ErrWrongArguments, "HY000"},
+    {ErrParse, "42000"},
+    {ErrSyntax, "42000"},
+    {ErrEmptyQuery, "42000"},
+    {ErrWrongParamcountToProcedure, "42000"},
+    {ErrNoSuchTable, "42S02"},
+    {ErrBadTable, "42S02"},
+    {ErrBadField, "42S22"},
+    {ErrBadDB, "42000"},
+    {ErrTableExists, "42S01"},
+    {ErrNetPacketTooLarge, "08S01"},
+    {ErrNetRead, "08S01"},
+    {ErrNetErrorOnWrite, "08S01"},
+    {ErrPsManyParam, "HY000"},
+    {ErrMalformedPacket, "HY000"},
+};
+
+std::string SQLError::Error() const { return "ERROR " + std::to_string(Code) + " (" + State + "): " + Message; }
+
+}  // namespace mysql
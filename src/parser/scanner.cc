@@ -53,7 +53,11 @@ void Scanner::reset(std::string sql) {
     _reader = std::make_shared<common::utf8::reader_t>(sql);
     _stmtStartPos = 0;
     _inBangComment = false;
+    _lastScanOffset = 0;
     _lastKeyword = 0;
+    _lastKeyword2 = 0;
+    _lastKeyword3 = 0;
+    _identifierDot = false;
 }
 
 std::string Scanner::stmtText() const {
@@ -113,6 +117,24 @@ std::tuple<int, common::utf8::Pos, std::string> Scanner::scan() {
     return {node->token, pos, _reader->data(pos)};
 }
 
+std::tuple<int, common::utf8::Pos, std::string> Scanner::Lex() {
+    auto [tok, pos, lit] = scan();
+    _lastScanOffset = pos._offset;
+    _lastKeyword3 = _lastKeyword2;
+    _lastKeyword2 = _lastKeyword;
+    _lastKeyword = 0;
+    if (tok == tok_identifier) {
+        if (auto tok1 = isTokenIdentifier(lit, pos._offset); tok1 != 0) {
+            tok = tok1;
+            _lastKeyword = tok1;
+        }
+    }
+    if (_sqlMode.HasANSIQuotesMode() && tok == tok_stringLit && _reader->make_slice(pos._offset, 1) == "\"") {
+        tok = tok_identifier;
+    }
+    return {tok, pos, lit};
+}
+
 common::utf8::rune_t Scanner::skipWhitespace() { return _reader->incAsLongAs(isSpace); }
 
 // handleEscape handles the case in scanString when previous char is '\'.
@@ -251,4 +273,35 @@ std::shared_ptr<Scanner> NewScanner(std::string str) {
     return scanner;
 }
 
+std::vector<std::string_view> SplitStatements(std::string_view sql) {
+    std::vector<std::string_view> stmts;
+    auto push = [&](size_t begin, size_t end) {
+        while (begin < end && isSpace(sql[begin])) {
+            begin++;
+        }
+        while (end > begin && isSpace(sql[end - 1])) {
+            end--;
+        }
+        if (begin < end) {
+            stmts.push_back(sql.substr(begin, end - begin));
+        }
+    };
+
+    Scanner s;
+    s.reset(std::string(sql));
+    size_t begin = 0;
+    while (true) {
+        auto [tok, pos, lit] = s.scan();
+        if (tok == 0 || tok == tok_invalid) {
+            break;
+        }
+        if (tok == ';') {
+            push(begin, pos._offset);
+            begin = pos._offset + 1;
+        }
+    }
+    push(begin, sql.length());
+    return stmts;
+}
+
 }  // namespace parser
\ No newline at end of file
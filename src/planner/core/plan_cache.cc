@@ -0,0 +1,254 @@
+#include "planner/core/plan_cache.hh"
+
+#include <algorithm>
+#include <cctype>
+
+#include "common/tracing.hh"
+#include "parser/misc.hh"
+#include "parser/scanner.hh"
+#include "parser/token.hh"
+
+namespace planner::core {
+
+namespace {
+
+std::atomic<bool> preparedPlanCacheEnabled{true};
+
+// planCacheHints returns whether the optimizer hint comment lit holds USE_PLAN_CACHE() and IGNORE_PLAN_CACHE().
+std::tuple<bool, bool> planCacheHints(const std::string &lit) {
+    bool use = false, ignore = false;
+    for (auto tok : parser::getHintTokens(lit)) {
+        switch (tok) {
+            case parser::tok_hintUsePlanCache:
+                use = true;
+                break;
+            case parser::tok_hintIgnorePlanCache:
+                ignore = true;
+                break;
+        }
+    }
+    return {use, ignore};
+}
+
+}  // namespace
+
+// cached is a template in the cache, with the number of sessions holding it and whether it was used since the hand
+// last swept its digest.
+struct PlanCache::cached {
+    cached(std::shared_ptr<const PlanCacheStmt> stmt, std::shared_ptr<std::atomic<int64_t>> evictable)
+        : Stmt(std::move(stmt)), Evictable(std::move(evictable)) {}
+
+    std::shared_ptr<const PlanCacheStmt> Stmt;
+    std::shared_ptr<std::atomic<int64_t>> Evictable;
+    // Holders is incremented under the locks of the buckets of the digest, so that an eviction, under them too, does
+    // not race with a hit.
+    std::atomic<uint32_t> Holders{1};
+    std::atomic<bool> Referenced{false};
+};
+
+// slot is a slot of the ring: empty, busy while a thread claims or sweeps it, or full with the digest of a template.
+struct PlanCache::slot {
+    static constexpr uint8_t empty = 0;
+    static constexpr uint8_t busy = 1;
+    static constexpr uint8_t full = 2;
+
+    std::atomic<uint8_t> State{empty};
+    parser::Digest Digest;
+};
+
+namespace {
+
+// evictProbes bounds the slots the hand sweeps for a miss.
+constexpr size_t evictProbes = 16;
+
+}  // namespace
+
+std::shared_ptr<const PlanCacheStmt> PlanCache::handleOf(std::shared_ptr<cached> c) {
+    auto *stmt = c->Stmt.get();
+    return {stmt, [c = std::move(c)](const PlanCacheStmt *) {
+                if (c->Holders.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    c->Evictable->fetch_add(1, std::memory_order_relaxed);
+                }
+            }};
+}
+
+PlanCache::PlanCache(size_t capacity)
+    : _capacity(std::max<size_t>(capacity, 1)),
+      _stmts(_capacity),
+      _slots(new slot[_capacity]),
+      _free(_capacity),
+      _evictable(std::make_shared<std::atomic<int64_t>>(0)) {}
+
+PlanCache::~PlanCache() = default;
+
+std::shared_ptr<const PlanCacheStmt> PlanCache::Put(std::shared_ptr<const PlanCacheStmt> stmt) {
+    auto c = std::make_shared<cached>(stmt, _evictable);
+    std::shared_ptr<cached> hit;
+    bool added = false;
+    auto addVariant = [&](variants &vs) {
+        for (auto &v : vs) {
+            if (v->Stmt->Tokens == stmt->Tokens && v->Stmt->SQLMode._mode == stmt->SQLMode._mode) {
+                if (v->Holders.fetch_add(1, std::memory_order_acq_rel) == 0) {
+                    _evictable->fetch_sub(1, std::memory_order_relaxed);
+                }
+                v->Referenced.store(true, std::memory_order_relaxed);
+                hit = v;
+                return;
+            }
+        }
+        if (vs.size() < maxPlanCacheVariants) {
+            vs.push_back(c);
+            added = true;
+        }
+    };
+
+    bool missed = false;
+    while (true) {
+        if (_stmts.update_fn(stmt->SQLDigest, addVariant)) {
+            break;
+        }
+        if (!missed) {
+            missed = true;
+            _misses.fetch_add(1, std::memory_order_relaxed);
+        }
+        auto *s = claimSlot();
+        if (s == nullptr) {
+            return stmt;
+        }
+        if (_stmts.insert(stmt->SQLDigest, variants{c})) {
+            s->Digest = stmt->SQLDigest;
+            s->State.store(slot::full, std::memory_order_release);
+            return handleOf(std::move(c));
+        }
+        // Another session cached the digest since the lookup.
+        releaseSlot(*s);
+    }
+    if (hit != nullptr) {
+        _hits.fetch_add(1, std::memory_order_relaxed);
+        return handleOf(std::move(hit));
+    }
+    if (!missed) {
+        _misses.fetch_add(1, std::memory_order_relaxed);
+    }
+    return added ? handleOf(std::move(c)) : stmt;
+}
+
+PlanCache::slot *PlanCache::claimSlot() {
+    for (size_t i = 0; i < evictProbes; i++) {
+        if (_free.load(std::memory_order_relaxed) == 0 && _evictable->load(std::memory_order_relaxed) <= 0) {
+            return nullptr;
+        }
+        auto &s = _slots[_hand.fetch_add(1, std::memory_order_relaxed) % _capacity];
+        auto state = slot::empty;
+        if (s.State.compare_exchange_strong(state, slot::busy, std::memory_order_acquire)) {
+            _free.fetch_sub(1, std::memory_order_relaxed);
+            return &s;
+        }
+        if (state != slot::full || !s.State.compare_exchange_strong(state, slot::busy, std::memory_order_acquire)) {
+            continue;
+        }
+        if (evict(s)) {
+            return &s;
+        }
+        s.State.store(slot::full, std::memory_order_release);
+    }
+    return nullptr;
+}
+
+bool PlanCache::evict(const slot &s) {
+    bool gone = true;
+    _stmts.erase_fn(s.Digest, [&](variants &vs) {
+        // A template used since the last sweep gets a second chance.
+        auto evicted = std::remove_if(vs.begin(), vs.end(), [&](const std::shared_ptr<cached> &c) {
+            if (c->Holders.load(std::memory_order_acquire) != 0 || c->Referenced.exchange(false)) {
+                return false;
+            }
+            _evictable->fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        });
+        vs.erase(evicted, vs.end());
+        gone = vs.empty();
+        return gone;
+    });
+    return gone;
+}
+
+void PlanCache::releaseSlot(slot &s) {
+    s.State.store(slot::empty, std::memory_order_release);
+    _free.fetch_add(1, std::memory_order_relaxed);
+}
+
+PlanCache &GlobalPlanCache() {
+    static PlanCache cache;
+    return cache;
+}
+
+bool PreparedPlanCacheEnabled() { return preparedPlanCacheEnabled.load(std::memory_order_relaxed); }
+
+void SetPreparedPlanCacheEnabled(bool enabled) { preparedPlanCacheEnabled.store(enabled, std::memory_order_relaxed); }
+
+std::tuple<std::shared_ptr<const PlanCacheStmt>, std::optional<mysql::SQLError>> GetPlanCacheStmt(
+    const std::string &sql, mysql::SQLMode sqlMode) {
+    common::tracing::Span span("lex");
+    auto stmt = std::make_shared<PlanCacheStmt>();
+    stmt->SQLMode = sqlMode;
+    auto scanner = parser::NewScanner(sql);
+    scanner->SetSQLMode(sqlMode);
+    scanner->EnableWindowFunc(true);
+
+    bool useHint = false, ignoreHint = false;
+    std::optional<size_t> stmtEnd;
+    while (true) {
+        auto [tok, pos, lit] = scanner->Lex();
+        if (tok == 0) {
+            break;
+        }
+        if (tok == parser::tok_invalid || tok == static_cast<int>(common::utf8::rune_invalid)) {
+            auto near = "near \"" + sql.substr(pos._offset) + "\"";
+            return {nullptr, mysql::NewErr(mysql::ErrParse,
+                                           "You have an error in your SQL syntax; check the manual that corresponds to "
+                                           "your TiDB version for the right syntax to use",
+                                           near.c_str())};
+        }
+        if (tok == parser::tok_hintComment) {
+            auto [use, ignore] = planCacheHints(lit);
+            useHint |= use;
+            ignoreHint |= ignore;
+            continue;
+        }
+        if (stmtEnd) {
+            return {nullptr, mysql::NewErrf(mysql::ErrUnsupportedPs, "Can not prepare multiple statements")};
+        }
+        if (tok == ';') {
+            stmtEnd = pos._offset;
+            continue;
+        }
+        if (scanner->_lastKeyword != 0) {
+            // Keywords are case-insensitive, make `SELECT` and `select` the same token.
+            std::transform(lit.begin(), lit.end(), lit.begin(), [](unsigned char ch) { return std::tolower(ch); });
+        }
+        if (tok == parser::tok_paramMarker) {
+            stmt->ParamMarkers.push_back(stmt->Tokens.size());
+        }
+        stmt->Tokens.push_back({tok, std::move(lit)});
+    }
+    if (stmt->Tokens.empty()) {
+        return {nullptr, mysql::NewErr(mysql::ErrEmptyQuery)};
+    }
+    if (stmt->NumParams() > UINT16_MAX) {
+        return {nullptr, mysql::NewErr(mysql::ErrPsManyParam)};
+    }
+    {
+        common::tracing::Span normalizeSpan("normalize");
+        std::tie(stmt->NormalizedSQL, stmt->SQLDigest) =
+            parser::NormalizeDigest(stmtEnd ? sql.substr(0, *stmtEnd) : sql);
+    }
+
+    if (ignoreHint || !(useHint || PreparedPlanCacheEnabled())) {
+        return {stmt, std::nullopt};
+    }
+    common::tracing::Span planSpan("plan_cache");
+    return {GlobalPlanCache().Put(std::move(stmt)), std::nullopt};
+}
+
+}  // namespace planner::core
@@ -0,0 +1,49 @@
+#include "server/column.hh"
+
+#include "parser/mysql/type.hh"
+#include "server/util.hh"
+
+namespace server {
+
+namespace {
+// dumpFlag adds the flags clients expect from the column type on top of the column's own flags.
+uint16_t dumpFlag(uint8_t tp, uint16_t flag) {
+    switch (tp) {
+        case mysql::TypeSet:
+            return flag | mysql::SetFlag;
+        case mysql::TypeEnum:
+            return flag | mysql::EnumFlag;
+        default:
+            return flag;
+    }
+}
+
+// dumpType maps the internal column types that clients do not know to the types they do.
+uint8_t dumpType(uint8_t tp) {
+    switch (tp) {
+        case mysql::TypeSet:
+        case mysql::TypeEnum:
+            return mysql::TypeString;
+        default:
+            return tp;
+    }
+}
+}  // namespace
+
+void ColumnInfo::Dump(std::string &buffer) const {
+    dumpLengthEncodedString(buffer, "def");
+    dumpLengthEncodedString(buffer, Schema);
+    dumpLengthEncodedString(buffer, Table);
+    dumpLengthEncodedString(buffer, OrgTable);
+    dumpLengthEncodedString(buffer, Name);
+    dumpLengthEncodedString(buffer, OrgName);
+    buffer.push_back(0x0c);
+    dumpUint16(buffer, Charset);
+    dumpUint32(buffer, ColumnLength);
+    buffer.push_back(static_cast<char>(dumpType(Type)));
+    dumpUint16(buffer, dumpFlag(Type, Flag));
+    buffer.push_back(static_cast<char>(Decimal));
+    buffer.append(2, '\0');
+}
+
+}  // namespace server
@@ -0,0 +1,132 @@
+#include "server/compress.hh"
+
+#include <zlib.h>
+
+#ifdef PXTIDB_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace server {
+
+namespace {
+
+// zlibContext holds the zlib streams of a thread. They are reset, not reallocated, for every payload.
+struct zlibContext {
+    z_stream deflater{};
+    z_stream inflater{};
+    bool deflaterReady{false};
+    bool inflaterReady{false};
+
+    ~zlibContext() {
+        if (deflaterReady) {
+            deflateEnd(&deflater);
+        }
+        if (inflaterReady) {
+            inflateEnd(&inflater);
+        }
+    }
+};
+
+thread_local zlibContext zlibCtx;
+
+bool zlibCompress(std::string_view src, std::string &dst) {
+    auto &z = zlibCtx.deflater;
+    if (!zlibCtx.deflaterReady) {
+        if (deflateInit(&z, Z_DEFAULT_COMPRESSION) != Z_OK) {
+            return false;
+        }
+        zlibCtx.deflaterReady = true;
+    } else if (deflateReset(&z) != Z_OK) {
+        return false;
+    }
+    auto offset = dst.length();
+    dst.resize(offset + deflateBound(&z, src.length()));
+    z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(src.data()));
+    z.avail_in = src.length();
+    z.next_out = reinterpret_cast<Bytef *>(dst.data() + offset);
+    z.avail_out = dst.length() - offset;
+    bool ok = deflate(&z, Z_FINISH) == Z_STREAM_END;
+    dst.resize(ok ? offset + z.total_out : offset);
+    return ok;
+}
+
+bool zlibDecompress(std::string_view src, size_t uncompressedLen, std::string &dst) {
+    auto &z = zlibCtx.inflater;
+    if (!zlibCtx.inflaterReady) {
+        if (inflateInit(&z) != Z_OK) {
+            return false;
+        }
+        zlibCtx.inflaterReady = true;
+    } else if (inflateReset(&z) != Z_OK) {
+        return false;
+    }
+    dst.resize(uncompressedLen);
+    z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(src.data()));
+    z.avail_in = src.length();
+    z.next_out = reinterpret_cast<Bytef *>(dst.data());
+    z.avail_out = uncompressedLen;
+    return inflate(&z, Z_FINISH) == Z_STREAM_END && z.total_out == uncompressedLen;
+}
+
+#ifdef PXTIDB_HAVE_ZSTD
+// zstdContext holds the zstd contexts of a thread.
+struct zstdContext {
+    ZSTD_CCtx *cctx{ZSTD_createCCtx()};
+    ZSTD_DCtx *dctx{ZSTD_createDCtx()};
+
+    ~zstdContext() {
+        ZSTD_freeCCtx(cctx);
+        ZSTD_freeDCtx(dctx);
+    }
+};
+
+thread_local zstdContext zstdCtx;
+
+bool zstdCompress(int level, std::string_view src, std::string &dst) {
+    if (ZSTD_isError(ZSTD_CCtx_setParameter(zstdCtx.cctx, ZSTD_c_compressionLevel, level))) {
+        return false;
+    }
+    auto offset = dst.length();
+    dst.resize(offset + ZSTD_compressBound(src.length()));
+    auto n = ZSTD_compress2(zstdCtx.cctx, dst.data() + offset, dst.length() - offset, src.data(), src.length());
+    bool ok = !ZSTD_isError(n);
+    dst.resize(ok ? offset + n : offset);
+    return ok;
+}
+
+bool zstdDecompress(std::string_view src, size_t uncompressedLen, std::string &dst) {
+    dst.resize(uncompressedLen);
+    auto n = ZSTD_decompressDCtx(zstdCtx.dctx, dst.data(), uncompressedLen, src.data(), src.length());
+    return !ZSTD_isError(n) && n == uncompressedLen;
+}
+#endif
+
+}  // namespace
+
+bool compressPayload(CompressionAlgorithm alg, int level, std::string_view src, std::string &dst) {
+    switch (alg) {
+        case CompressionAlgorithm::Zlib:
+            return zlibCompress(src, dst);
+#ifdef PXTIDB_HAVE_ZSTD
+        case CompressionAlgorithm::Zstd:
+            return zstdCompress(level, src, dst);
+#endif
+        default:
+            return false;
+    }
+}
+
+bool decompressPayload(CompressionAlgorithm alg, std::string_view src, size_t uncompressedLen, std::string &dst) {
+    switch (alg) {
+        case CompressionAlgorithm::Zlib:
+            return zlibDecompress(src, uncompressedLen, dst);
+#ifdef PXTIDB_HAVE_ZSTD
+        case CompressionAlgorithm::Zstd:
+            return zstdDecompress(src, uncompressedLen, dst);
+#endif
+        default:
+            return false;
+    }
+}
+
+}  // namespace server
@@ -0,0 +1,422 @@
+#include "server/conn.hh"
+
+#include <strings.h>
+
+#include <cctype>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "common/tracing.hh"
+#include "errcode/errcode.hh"
+#include "metrics/server.hh"
+#include "parser/mysql/const.hh"
+#include "parser/digester.hh"
+#include "parser/scanner.hh"
+#include "server/resultset_encoder.hh"
+#include "server/server.hh"
+#include "server/util.hh"
+
+namespace server {
+
+namespace {
+
+// authNativePassword is the only authentication plugin the server announces.
+constexpr const char *authNativePassword = "mysql_native_password";
+
+// randomBuf generates a random salt of size printable bytes, without '$' which has a special meaning in
+// authentication strings.
+std::string randomBuf(size_t size) {
+    thread_local std::mt19937 rng{std::random_device{}()};
+    std::string buf(size, '\0');
+    for (auto &b : buf) {
+        b = static_cast<char>(rng() % 127 + 1);
+        if (b == '$') {
+            b++;
+        }
+    }
+    return buf;
+}
+
+// handshakeResponse41 is the part of the HandshakeResponse41 packet the server uses.
+struct handshakeResponse41 {
+    uint32_t Capability{0};
+    std::string_view User;
+    std::string_view Auth;
+    std::string_view DBName;
+    std::string_view AuthPlugin;
+    uint8_t ZstdLevel{0};
+};
+
+// parseHandshakeResponse parses a HandshakeResponse41 packet.
+// See https://dev.mysql.com/doc/internals/en/connection-phase-packets.html#packet-Protocol::HandshakeResponse41
+bool parseHandshakeResponse(std::string_view data, handshakeResponse41 &resp) {
+    // capability, max packet size, charset and a 23 byte filler.
+    if (data.length() < 32) {
+        return false;
+    }
+    resp.Capability = static_cast<uint8_t>(data[0]) | static_cast<uint8_t>(data[1]) << 8 |
+                      static_cast<uint8_t>(data[2]) << 16 | static_cast<uint32_t>(static_cast<uint8_t>(data[3])) << 24;
+    if ((resp.Capability & mysql::ClientProtocol41) == 0) {
+        return false;
+    }
+    auto rest = data.substr(32);
+
+    auto [user, afterUser] = parseNullTermString(rest);
+    if (afterUser.length() == rest.length()) {
+        return false;
+    }
+    resp.User = user;
+    rest = afterUser;
+
+    if ((resp.Capability & mysql::ClientPluginAuthLenencClientData) != 0) {
+        auto [auth, isNull, n] = parseLengthEncodedBytes(rest);
+        if (n == 0) {
+            return false;
+        }
+        resp.Auth = isNull ? std::string_view() : auth;
+        rest.remove_prefix(n);
+    } else if ((resp.Capability & mysql::ClientSecureConnection) != 0) {
+        if (rest.empty() || rest.length() < 1u + static_cast<uint8_t>(rest[0])) {
+            return false;
+        }
+        resp.Auth = rest.substr(1, static_cast<uint8_t>(rest[0]));
+        rest.remove_prefix(1 + resp.Auth.length());
+    } else {
+        std::tie(resp.Auth, rest) = parseNullTermString(rest);
+    }
+
+    if ((resp.Capability & mysql::ClientConnectWithDB) != 0 && !rest.empty()) {
+        std::tie(resp.DBName, rest) = parseNullTermString(rest);
+    }
+    if ((resp.Capability & mysql::ClientPluginAuth) != 0 && !rest.empty()) {
+        std::tie(resp.AuthPlugin, rest) = parseNullTermString(rest);
+    }
+    if ((resp.Capability & mysql::ClientConnectAtts) != 0 && !rest.empty()) {
+        // The connection attributes are ignored.
+        auto [attrsLen, isNull, n] = parseLengthEncodedInt(rest);
+        if (n == 0 || rest.length() < n + attrsLen) {
+            return false;
+        }
+        rest.remove_prefix(n + attrsLen);
+    }
+    if ((resp.Capability & mysql::ClientZstdCompressionAlgorithm) != 0 && !rest.empty()) {
+        resp.ZstdLevel = rest[0];
+    }
+    return true;
+}
+
+// maxTraceLabelLen bounds the statement text kept with a trace.
+constexpr size_t maxTraceLabelLen = 1024;
+
+// stripTrace returns the statement of a TRACE statement, nullopt if sql is not one.
+std::optional<std::string_view> stripTrace(std::string_view sql) {
+    auto begin = sql.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos || sql.length() - begin <= 5 ||
+        strncasecmp(sql.data() + begin, "trace", 5) != 0 || !std::isspace(static_cast<unsigned char>(sql[begin + 5]))) {
+        return std::nullopt;
+    }
+    return sql.substr(begin + 6);
+}
+
+}  // namespace
+
+clientConn::clientConn(Server &server, Reactor &reactor, int fd, uint32_t connID)
+    : _server(server), _pkt(fd, &reactor), _connectionID(connID), _salt(randomBuf(20)) {}
+
+Task<bool> clientConn::writeInitialHandshake() {
+    std::string data;
+    // min version 10
+    data += '\x0a';
+    // server version[00]
+    data += mysql::ServerVersion;
+    data += '\0';
+    // connection id
+    dumpUint32(data, _connectionID);
+    // auth-plugin-data-part-1
+    data.append(_salt, 0, 8);
+    // filler [00]
+    data += '\0';
+    // capability flag lower 2 bytes, using default capability here
+    dumpUint16(data, defaultCapability & 0xffff);
+    // charset
+    data += static_cast<char>(mysql::DefaultCollationID);
+    // status
+    dumpUint16(data, mysql::ServerStatusAutocommit);
+    // capability flag upper 2 bytes, using default capability here
+    dumpUint16(data, defaultCapability >> 16);
+    // length of auth-plugin-data
+    data += static_cast<char>(_salt.length() + 1);
+    // reserved 10 [00]
+    data.append(10, '\0');
+    // auth-plugin-data-part-2
+    data.append(_salt, 8);
+    data += '\0';
+    // auth-plugin name
+    data += authNativePassword;
+    data += '\0';
+    _pkt.writePacket(data);
+    co_return co_await _pkt.flush();
+}
+
+Task<bool> clientConn::handshake() {
+    std::string data;
+    bool ok = co_await _pkt.readPacket(data);
+    if (!ok) {
+        co_return false;
+    }
+    handshakeResponse41 resp;
+    if (!parseHandshakeResponse(data, resp)) {
+        co_await respond(mysql::NewErr(mysql::ErrHandshake));
+        co_return false;
+    }
+    _capability = resp.Capability & defaultCapability;
+    _user = resp.User;
+    _dbname = resp.DBName;
+    ok = co_await writeOK();
+    if (!ok) {
+        co_return false;
+    }
+    // The compressed protocol starts after the OK packet.
+    if ((_capability & mysql::ClientZstdCompressionAlgorithm) != 0) {
+        auto level = resp.ZstdLevel != 0 ? resp.ZstdLevel : defaultZstdCompressionLevel;
+        _pkt.setCompression(CompressionAlgorithm::Zstd, level, _server._cfg.CompressionThreshold);
+    } else if ((_capability & mysql::ClientCompress) != 0) {
+        _pkt.setCompression(CompressionAlgorithm::Zlib, 0, _server._cfg.CompressionThreshold);
+    }
+    co_return true;
+}
+
+Task<bool> clientConn::readPacket(std::string &data) {
+    // Every command starts a new packet sequence.
+    _pkt.resetSequence();
+    co_return co_await _pkt.readPacket(data);
+}
+
+Task<bool> clientConn::dispatch(std::string_view data) {
+    if (data.empty()) {
+        co_return false;
+    }
+    auto cmd = static_cast<uint8_t>(data[0]);
+    data.remove_prefix(1);
+    if (cmd < mysql::ComEnd) {
+        metrics::CommandCounter(cmd).Add();
+    }
+    bool traced = false;
+    switch (cmd) {
+        case mysql::ComQuery:
+            // Some clients send the statement with a trailing '\0'.
+            if (!data.empty() && data.back() == '\0') {
+                data.remove_suffix(1);
+            }
+            if (auto stmt = stripTrace(data)) {
+                data = *stmt;
+                traced = true;
+                break;
+            }
+            [[fallthrough]];
+        case mysql::ComStmtPrepare:
+        case mysql::ComStmtExecute:
+            traced = common::tracing::Sample(_server._cfg.TraceSampleRate);
+            break;
+    }
+
+    common::tracing::TraceScope trace(traced);
+    bool ok;
+    {
+        common::tracing::Span span("command");
+        ok = co_await dispatchCommand(cmd, data);
+    }
+    if (trace.Enabled()) {
+        std::string label(mysql::Command2Str[cmd]);
+        if (cmd != mysql::ComStmtExecute) {
+            label += ' ';
+            label += data.substr(0, maxTraceLabelLen);
+        }
+        _server._traces.Add(trace.Finish(_connectionID, std::move(label)));
+    }
+    co_return ok;
+}
+
+Task<bool> clientConn::dispatchCommand(uint8_t cmd, std::string_view data) {
+    switch (cmd) {
+        case mysql::ComSleep:
+            // According to mysql document, this command is supposed to be used only internally.
+            co_return true;
+        case mysql::ComQuit:
+            co_return false;
+        case mysql::ComInitDB:
+            _dbname = data;
+            co_return co_await writeOK();
+        case mysql::ComQuery:
+            co_return co_await handleQuery(data);
+        case mysql::ComPing:
+            co_return co_await writeOK();
+        case mysql::ComStmtPrepare:
+            co_return co_await respond(handleStmtPrepare(_pkt, _ctx, _capability, std::string(data)));
+        case mysql::ComStmtExecute:
+            co_return co_await executePrepared(data);
+        case mysql::ComStmtSendLongData:
+            handleStmtSendLongData(_ctx, data);
+            co_return true;
+        case mysql::ComStmtClose:
+            handleStmtClose(_ctx, data);
+            co_return true;
+        case mysql::ComStmtReset:
+            co_return co_await respond(handleStmtReset(_pkt, _ctx, _capability, data));
+        default:
+            co_return co_await respond(
+                mysql::NewErrf(mysql::ErrUnknown, "command %d not supported now", static_cast<int>(cmd)));
+    }
+}
+
+Task<bool> clientConn::handleQuery(std::string_view sql) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string_view> stmts;
+    {
+        common::tracing::Span span("parse");
+        stmts = parser::SplitStatements(sql);
+    }
+    auto parseTime = std::chrono::steady_clock::now() - start;
+    metrics::PhaseDuration(metrics::Phase::Parse).Observe(parseTime.count());
+    if (stmts.size() <= 1) {
+        auto result = co_await execute(sql, parseTime, true);
+        co_return result != stmtResult::Disconnected;
+    }
+    if ((_capability & mysql::ClientMultiStatements) == 0) {
+        co_return co_await respond(
+            mysql::NewErrf(errcode::ErrMultiStatementDisabled, "client has multi-statement capability disabled"));
+    }
+    auto result = stmtResult::Succeeded;
+    for (size_t i = 0; result == stmtResult::Succeeded && i < stmts.size(); i++) {
+        // The executor writes the status of the session in its OK and EOF packets.
+        bool last = i == stmts.size() - 1;
+        _ctx.SetStatus(last ? _ctx.Status() & ~mysql::ServerMoreResultsExists
+                            : _ctx.Status() | mysql::ServerMoreResultsExists);
+        result = co_await execute(stmts[i], parseTime, last);
+    }
+    _ctx.SetStatus(_ctx.Status() & ~mysql::ServerMoreResultsExists);
+    co_return result != stmtResult::Disconnected;
+}
+
+Task<clientConn::stmtResult> clientConn::execute(std::string_view sql, std::chrono::nanoseconds parseTime,
+                                                 bool last) {
+    common::tracing::Span span("statement");
+    _ctx.StmtCtx() = {};
+    _ctx.StmtCtx().OriginalSQL = sql;
+    auto ioTime = _pkt.ioTime();
+    StmtExecInfo info;
+    info.StartTime = std::chrono::system_clock::now();
+    auto start = std::chrono::steady_clock::now();
+    std::optional<mysql::SQLError> err;
+    {
+        common::tracing::Span executeSpan("execute");
+        err = co_await _server._queryExecutor(_pkt, _ctx, _capability, sql);
+    }
+    auto executed = std::chrono::steady_clock::now();
+    metrics::PhaseDuration(metrics::Phase::Execute).Observe((executed - start).count());
+    bool ok = true;
+    if (err) {
+        server::writeError(_pkt, _capability, *err);
+    }
+    if (last || err) {
+        common::tracing::Span flushSpan("flush");
+        ok = co_await _pkt.flush();
+    }
+
+    info.ParseLatency = parseTime;
+    info.ExecLatency = executed - start;
+    info.Latency = parseTime + (std::chrono::steady_clock::now() - start);
+    info.ErrorCode = err ? err->Code : 0;
+    finishStatement(info, _pkt.ioTime() - ioTime, nullptr);
+    if (!ok) {
+        co_return stmtResult::Disconnected;
+    }
+    co_return err ? stmtResult::Failed : stmtResult::Succeeded;
+}
+
+Task<bool> clientConn::executePrepared(std::string_view data) {
+    common::tracing::Span span("statement");
+    _ctx.StmtCtx() = {};
+    // A statement that is not found or a malformed packet is reported too, without a text.
+    auto stmt = data.length() >= 4 ? _ctx.GetStatement(readLE<uint32_t>(data.data())) : nullptr;
+    if (stmt != nullptr) {
+        _ctx.StmtCtx().OriginalSQL = stmt->SQL();
+    }
+    auto ioTime = _pkt.ioTime();
+    StmtExecInfo info;
+    info.StartTime = std::chrono::system_clock::now();
+    auto start = std::chrono::steady_clock::now();
+    auto err = co_await handleStmtExecute(_pkt, _ctx, data, _server._stmtExecutor);
+    if (err) {
+        server::writeError(_pkt, _capability, *err);
+    }
+    bool ok;
+    {
+        common::tracing::Span flushSpan("flush");
+        ok = co_await _pkt.flush();
+    }
+
+    auto writeTime = _pkt.ioTime() - ioTime;
+    info.Prepared = true;
+    info.Latency = std::chrono::steady_clock::now() - start;
+    info.ExecLatency = info.Latency - writeTime;
+    info.ErrorCode = err ? err->Code : 0;
+    finishStatement(info, writeTime, stmt);
+    co_return ok;
+}
+
+void clientConn::finishStatement(StmtExecInfo &info, std::chrono::nanoseconds writeTime,
+                                 const TiDBStatement *prepared) {
+    bool slow = _server._slowLog != nullptr && info.Latency >= _server._cfg.SlowThreshold;
+    if (!slow && _server._stmtSummary == nullptr) {
+        return;
+    }
+    info.SchemaName = _dbname;
+    info.ExaminedRows = _ctx.StmtCtx().ExaminedRows;
+    info.ResultRows = _ctx.StmtCtx().ResultRows;
+    info.MemMax = _ctx.StmtCtx().MemMax;
+    // A prepared statement was normalized by Prepare, a text one by whatever needed its digest first, maybe the executor.
+    if (prepared != nullptr) {
+        info.Digest = prepared->Template().SQLDigest;
+        info.NormalizedSQL = prepared->Template().NormalizedSQL;
+    } else {
+        std::tie(info.NormalizedSQL, info.Digest) = _ctx.StmtCtx().SQLDigest();
+    }
+    info.SampleSQL = _ctx.StmtCtx().OriginalSQL;
+    if (_server._stmtSummary != nullptr) {
+        _server._stmtSummary->Add(info);
+    }
+    if (!slow) {
+        return;
+    }
+    SlowQueryRecord record;
+    record.Time = std::chrono::system_clock::now();
+    record.ConnID = _connectionID;
+    record.Succ = info.ErrorCode == 0;
+    record.Prepared = info.Prepared;
+    record.Digest = info.Digest;
+    record.QueryTime = info.Latency;
+    record.ParseTime = info.ParseLatency;
+    record.ExecuteTime = info.ExecLatency;
+    record.WriteTime = writeTime;
+    record.ResultRows = info.ResultRows;
+    record.MemMax = info.MemMax;
+    record.SetSQL(info.NormalizedSQL);
+    _server._slowLog->Log(record);
+}
+
+Task<bool> clientConn::writeOK() {
+    server::writeOK(_pkt, _capability, 0, 0, _ctx.Status(), 0);
+    co_return co_await _pkt.flush();
+}
+
+Task<bool> clientConn::respond(const std::optional<mysql::SQLError> &err) {
+    if (err) {
+        server::writeError(_pkt, _capability, *err);
+    }
+    co_return co_await _pkt.flush();
+}
+
+}  // namespace server
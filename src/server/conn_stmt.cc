@@ -0,0 +1,318 @@
+#include "server/conn_stmt.hh"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#include "common/tracing.hh"
+#include "metrics/server.hh"
+#include "parser/mysql/const.hh"
+#include "parser/mysql/type.hh"
+#include "server/column.hh"
+#include "server/resultset_encoder.hh"
+#include "server/util.hh"
+
+namespace server {
+
+namespace {
+
+mysql::SQLError errMalformPacket() { return mysql::NewErr(mysql::ErrMalformedPacket); }
+
+mysql::SQLError errUnknownStmtHandler(uint32_t stmtID, const char *command) {
+    auto id = std::to_string(stmtID);
+    return mysql::NewErr(mysql::ErrUnknownStmtHandler, static_cast<int>(id.length()), id.c_str(), command);
+}
+
+// binaryDateTime decodes the length bytes of a DATE, DATETIME or TIMESTAMP value into its canonical text form.
+std::optional<std::string> binaryDateTime(std::string_view b) {
+    char buf[64];
+    switch (b.length()) {
+        case 0:
+            return "0000-00-00 00:00:00";
+        case 4:
+            std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d", readLE<uint16_t>(b.data()), b[2], b[3]);
+            return buf;
+        case 7:
+            std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d", readLE<uint16_t>(b.data()), b[2], b[3],
+                          b[4], b[5], b[6]);
+            return buf;
+        case 11:
+            std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d.%06u", readLE<uint16_t>(b.data()), b[2],
+                          b[3], b[4], b[5], b[6], readLE<uint32_t>(b.data() + 7));
+            return buf;
+    }
+    return std::nullopt;
+}
+
+// binaryDuration decodes the length bytes of a TIME value into its canonical text form.
+std::optional<std::string> binaryDuration(std::string_view b) {
+    if (b.length() == 0) {
+        return "00:00:00";
+    }
+    if (b.length() != 8 && b.length() != 12) {
+        return std::nullopt;
+    }
+    char buf[64];
+    auto sign = b[0] == 1 ? "-" : "";
+    auto hours = static_cast<uint64_t>(readLE<uint32_t>(b.data() + 1)) * 24 + static_cast<uint8_t>(b[5]);
+    int n = std::snprintf(buf, sizeof(buf), "%s%02lu:%02d:%02d", sign, hours, b[6], b[7]);
+    if (b.length() == 12) {
+        std::snprintf(buf + n, sizeof(buf) - n, ".%06u", readLE<uint32_t>(b.data() + 8));
+    }
+    return buf;
+}
+
+}  // namespace
+
+std::optional<mysql::SQLError> handleStmtPrepare(PacketIO &io, TiDBContext &ctx, uint32_t capability,
+                                                 const std::string &sql) {
+    auto [stmt, err] = ctx.Prepare(sql);
+    if (err) {
+        return err;
+    }
+
+    // The result columns are only known once the statement is planned; they are sent with every execution.
+    std::string data(1, static_cast<char>(mysql::OKHeader));
+    dumpUint32(data, stmt->ID());
+    dumpUint16(data, 0);
+    dumpUint16(data, stmt->NumParams());
+    data += '\0';
+    dumpUint16(data, 0);
+    io.writePacket(data);
+
+    if (stmt->NumParams() > 0) {
+        ColumnInfo param;
+        param.Name = "?";
+        data.clear();
+        param.Dump(data);
+        for (size_t i = 0; i < stmt->NumParams(); i++) {
+            io.writePacket(data);
+        }
+        if ((capability & mysql::ClientDeprecateEOF) == 0) {
+            writeEOF(io, capability, ctx.Status());
+        }
+    }
+    return std::nullopt;
+}
+
+Task<std::optional<mysql::SQLError>> handleStmtExecute(PacketIO &io, TiDBContext &ctx, std::string_view data,
+                                                       const StmtExecutor &exec) {
+    if (data.length() < 9) {
+        co_return errMalformPacket();
+    }
+    auto stmtID = readLE<uint32_t>(data.data());
+    auto stmt = ctx.GetStatement(stmtID);
+    if (stmt == nullptr) {
+        co_return errUnknownStmtHandler(stmtID, "stmt_execute");
+    }
+    // data[4] is the cursor flag, which is not supported: all the rows are sent at once.
+    // data[5:9] is the iteration count, which is always 1.
+    size_t pos = 9;
+
+    auto numParams = stmt->NumParams();
+    if (numParams > 0) {
+        size_t nullBitmapLen = (numParams + 7) >> 3;
+        if (data.length() < pos + nullBitmapLen + 1) {
+            co_return errMalformPacket();
+        }
+        auto nullBitmap = data.substr(pos, nullBitmapLen);
+        pos += nullBitmapLen;
+        std::string_view paramValues;
+        // new param bound flag
+        if (data[pos] == 1) {
+            pos++;
+            if (data.length() < pos + (numParams << 1)) {
+                co_return errMalformPacket();
+            }
+            // Just the first StmtExecute packet contain parameters type, we need save it for further use.
+            stmt->SetParamsType(data.substr(pos, numParams << 1));
+            paramValues = data.substr(pos + (numParams << 1));
+        } else {
+            paramValues = data.substr(pos + 1);
+        }
+        auto err = parseExecArgs(stmt->Params(), stmt->BoundParams(), nullBitmap, stmt->GetParamsType(), paramValues);
+        stmt->Reset();
+        if (err) {
+            co_return err;
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::optional<mysql::SQLError> err;
+    {
+        common::tracing::Span span("execute");
+        err = co_await exec(io, *stmt);
+    }
+    metrics::PhaseDuration(metrics::Phase::Execute).ObserveSince(start);
+    co_return err;
+}
+
+void handleStmtSendLongData(TiDBContext &ctx, std::string_view data) {
+    if (data.length() < 6) {
+        return;
+    }
+    // The client does not expect a response, errors are reported by the next COM_STMT_EXECUTE.
+    auto stmt = ctx.GetStatement(readLE<uint32_t>(data.data()));
+    if (stmt != nullptr) {
+        stmt->AppendParam(readLE<uint16_t>(data.data() + 4), data.substr(6));
+    }
+}
+
+std::optional<mysql::SQLError> handleStmtReset(PacketIO &io, TiDBContext &ctx, uint32_t capability,
+                                               std::string_view data) {
+    if (data.length() < 4) {
+        return errMalformPacket();
+    }
+    auto stmtID = readLE<uint32_t>(data.data());
+    auto stmt = ctx.GetStatement(stmtID);
+    if (stmt == nullptr) {
+        return errUnknownStmtHandler(stmtID, "stmt_reset");
+    }
+    stmt->Reset();
+    writeOK(io, capability, 0, 0, ctx.Status(), 0);
+    return std::nullopt;
+}
+
+void handleStmtClose(TiDBContext &ctx, std::string_view data) {
+    if (data.length() < 4) {
+        return;
+    }
+    ctx.CloseStatement(readLE<uint32_t>(data.data()));
+}
+
+std::optional<mysql::SQLError> parseExecArgs(std::vector<StmtParam> &args,
+                                             const std::vector<std::optional<std::string>> &boundParams,
+                                             std::string_view nullBitmap, std::string_view paramTypes,
+                                             std::string_view paramValues) {
+    size_t pos = 0;
+    for (size_t i = 0; i < args.size(); i++) {
+        // if params had received via ComStmtSendLongData, use them directly.
+        if (boundParams[i]) {
+            args[i] = *boundParams[i];
+            continue;
+        }
+        // check nullBitMap to determine the NULL arguments.
+        if ((nullBitmap[i >> 3] & (1 << (i % 8))) != 0) {
+            args[i] = std::monostate{};
+            continue;
+        }
+        if ((i << 1) + 1 >= paramTypes.length()) {
+            return errMalformPacket();
+        }
+        uint8_t tp = paramTypes[i << 1];
+        bool isUnsigned = (paramTypes[(i << 1) + 1] & 0x80) != 0;
+        auto rest = paramValues.substr(std::min(pos, paramValues.length()));
+
+        switch (tp) {
+            case mysql::TypeNull:
+                args[i] = std::monostate{};
+                break;
+            case mysql::TypeTiny:
+                if (rest.length() < 1) {
+                    return errMalformPacket();
+                }
+                if (isUnsigned) {
+                    args[i] = uint64_t(static_cast<uint8_t>(rest[0]));
+                } else {
+                    args[i] = int64_t(static_cast<int8_t>(rest[0]));
+                }
+                pos += 1;
+                break;
+            case mysql::TypeShort:
+            case mysql::TypeYear:
+                if (rest.length() < 2) {
+                    return errMalformPacket();
+                }
+                if (isUnsigned) {
+                    args[i] = uint64_t(readLE<uint16_t>(rest.data()));
+                } else {
+                    args[i] = int64_t(readLE<int16_t>(rest.data()));
+                }
+                pos += 2;
+                break;
+            case mysql::TypeInt24:
+            case mysql::TypeLong:
+                if (rest.length() < 4) {
+                    return errMalformPacket();
+                }
+                if (isUnsigned) {
+                    args[i] = uint64_t(readLE<uint32_t>(rest.data()));
+                } else {
+                    args[i] = int64_t(readLE<int32_t>(rest.data()));
+                }
+                pos += 4;
+                break;
+            case mysql::TypeLonglong:
+                if (rest.length() < 8) {
+                    return errMalformPacket();
+                }
+                if (isUnsigned) {
+                    args[i] = readLE<uint64_t>(rest.data());
+                } else {
+                    args[i] = readLE<int64_t>(rest.data());
+                }
+                pos += 8;
+                break;
+            case mysql::TypeFloat:
+                if (rest.length() < 4) {
+                    return errMalformPacket();
+                }
+                args[i] = double(readLE<float>(rest.data()));
+                pos += 4;
+                break;
+            case mysql::TypeDouble:
+                if (rest.length() < 8) {
+                    return errMalformPacket();
+                }
+                args[i] = readLE<double>(rest.data());
+                pos += 8;
+                break;
+            case mysql::TypeDate:
+            case mysql::TypeTimestamp:
+            case mysql::TypeDatetime:
+            case mysql::TypeDuration: {
+                // length byte followed by the value
+                if (rest.length() < 1 || rest.length() < 1u + static_cast<uint8_t>(rest[0])) {
+                    return errMalformPacket();
+                }
+                auto value = rest.substr(1, static_cast<uint8_t>(rest[0]));
+                auto text = tp == mysql::TypeDuration ? binaryDuration(value) : binaryDateTime(value);
+                if (!text) {
+                    return errMalformPacket();
+                }
+                args[i] = std::move(*text);
+                pos += 1 + value.length();
+                break;
+            }
+            case mysql::TypeNewDecimal:
+            case mysql::TypeBlob:
+            case mysql::TypeTinyBlob:
+            case mysql::TypeMediumBlob:
+            case mysql::TypeLongBlob:
+            case mysql::TypeString:
+            case mysql::TypeVarString:
+            case mysql::TypeVarchar:
+            case mysql::TypeJSON:
+            case mysql::TypeEnum:
+            case mysql::TypeSet:
+            case mysql::TypeGeometry:
+            case mysql::TypeBit: {
+                auto [value, isNull, n] = parseLengthEncodedBytes(rest);
+                if (n == 0) {
+                    return errMalformPacket();
+                }
+                if (isNull) {
+                    args[i] = std::monostate{};
+                } else {
+                    args[i] = std::string(value);
+                }
+                pos += n;
+                break;
+            }
+            default:
+                return mysql::NewErrf(mysql::ErrUnknown, "stmt unknown field type %d", static_cast<int>(tp));
+        }
+    }
+    return std::nullopt;
+}
+
+}  // namespace server
@@ -0,0 +1,63 @@
+#include "server/driver_tidb.hh"
+
+#include <chrono>
+
+#include "common/tracing.hh"
+#include "metrics/server.hh"
+
+namespace server {
+
+TiDBStatement::TiDBStatement(uint32_t id, std::string sql, std::shared_ptr<const planner::core::PlanCacheStmt> stmt)
+    : _id(id),
+      _sql(std::move(sql)),
+      _stmt(std::move(stmt)),
+      _boundParams(_stmt->NumParams()),
+      _params(_stmt->NumParams()) {}
+
+bool TiDBStatement::AppendParam(size_t paramID, std::string_view data) {
+    if (paramID >= _boundParams.size()) {
+        return false;
+    }
+    auto &param = _boundParams[paramID];
+    if (!param) {
+        param.emplace();
+    }
+    param->append(data);
+    return true;
+}
+
+void TiDBStatement::Reset() {
+    for (auto &param : _boundParams) {
+        param.reset();
+    }
+}
+
+std::tuple<std::string_view, parser::Digest> StatementContext::SQLDigest() {
+    if (!_digest) {
+        parser::Digest digest;
+        std::tie(_normalizedSQL, digest) = parser::NormalizeDigest(std::string(OriginalSQL));
+        _digest = digest;
+    }
+    return {_normalizedSQL, *_digest};
+}
+
+std::tuple<TiDBStatement *, std::optional<mysql::SQLError>> TiDBContext::Prepare(const std::string &sql) {
+    common::tracing::Span span("prepare");
+    auto start = std::chrono::steady_clock::now();
+    auto [stmt, err] = planner::core::GetPlanCacheStmt(sql, _sqlMode);
+    metrics::PhaseDuration(metrics::Phase::Lex).ObserveSince(start);
+    if (err) {
+        return {nullptr, std::move(err)};
+    }
+    auto id = ++_preparedStmtID;
+    auto &prepared = _stmts[id];
+    prepared = std::make_unique<TiDBStatement>(id, sql, std::move(stmt));
+    return {prepared.get(), std::nullopt};
+}
+
+TiDBStatement *TiDBContext::GetStatement(uint32_t stmtID) {
+    auto it = _stmts.find(stmtID);
+    return it == _stmts.end() ? nullptr : it->second.get();
+}
+
+}  // namespace server
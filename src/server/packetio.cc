@@ -0,0 +1,313 @@
+#include "server/packetio.hh"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <utility>
+
+#include "common/tracing.hh"
+#include "parser/mysql/const.hh"
+
+namespace server {
+
+namespace {
+
+// threadCPUTime returns the CPU time consumed by the calling thread.
+std::chrono::nanoseconds threadCPUTime() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+}  // namespace
+
+PacketBuffer::PacketBuffer(size_t capacity) : _capacity(capacity) {}
+
+uint8_t *PacketBuffer::reservePacket(size_t payloadLen) {
+    allocate();
+    if (packetHeaderSize + payloadLen > available()) {
+        return nullptr;
+    }
+    auto p = _buf.data() + _len;
+    putHeader(p, payloadLen);
+    _len += packetHeaderSize + payloadLen;
+    return p + packetHeaderSize;
+}
+
+void PacketBuffer::appendPacket(std::string_view payload) {
+    // A payload of exactly MaxPayloadLen bytes must be followed by an empty packet so that the reader knows the
+    // logical packet has ended, hence the loop runs at least once and exits only after a short chunk.
+    allocate();
+    while (true) {
+        size_t length = std::min<size_t>(payload.length(), mysql::MaxPayloadLen);
+        if (packetHeaderSize + length > available()) {
+            _buf.resize(_len + packetHeaderSize + length);
+        }
+        auto p = _buf.data() + _len;
+        putHeader(p, length);
+        std::memcpy(p + packetHeaderSize, payload.data(), length);
+        _len += packetHeaderSize + length;
+        payload.remove_prefix(length);
+        if (length < mysql::MaxPayloadLen) {
+            return;
+        }
+    }
+}
+
+void PacketBuffer::ensureRoomFor(size_t payloadLen) {
+    allocate();
+    if (packetHeaderSize + payloadLen > available()) {
+        _buf.resize(_len + packetHeaderSize + payloadLen);
+    }
+}
+
+void PacketBuffer::clear() {
+    _len = 0;
+    if (_buf.size() > _capacity) {
+        _buf.resize(_capacity);
+        _buf.shrink_to_fit();
+    }
+}
+
+void PacketBuffer::release() {
+    _len = 0;
+    std::vector<uint8_t>().swap(_buf);
+}
+
+Task<bool> PacketIO::wait(short events) {
+    if (_reactor == nullptr) {
+        co_return false;
+    }
+    // The session may resume on another worker: the trace of its command moves along.
+    auto *recorder = std::exchange(common::tracing::activeRecorder, nullptr);
+    co_await _reactor->WaitFor(_fd, events);
+    common::tracing::activeRecorder = recorder;
+    co_return true;
+}
+
+Task<bool> PacketIO::readSocket(uint8_t *p, size_t n) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = true;
+    while (ok && n > 0) {
+        auto r = ::read(_fd, p, n);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            ok = co_await wait(EV_READ);
+            continue;
+        }
+        if (r <= 0) {
+            ok = false;
+            break;
+        }
+        p += r;
+        n -= r;
+    }
+    _ioTime += std::chrono::steady_clock::now() - start;
+    co_return ok;
+}
+
+Task<bool> PacketIO::writeSocket(const uint8_t *p, size_t n) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = true;
+    while (ok && n > 0) {
+        auto w = ::write(_fd, p, n);
+        if (w < 0 && errno == EINTR) {
+            continue;
+        }
+        if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            ok = co_await wait(EV_WRITE);
+            continue;
+        }
+        if (w <= 0) {
+            ok = false;
+            break;
+        }
+        p += w;
+        n -= w;
+    }
+    _ioTime += std::chrono::steady_clock::now() - start;
+    co_return ok;
+}
+
+Task<bool> PacketIO::readFull(uint8_t *p, size_t n) {
+    if (_compression == CompressionAlgorithm::None) {
+        co_return co_await readSocket(p, n);
+    }
+    while (n > 0) {
+        if (!hasBufferedInput()) {
+            bool ok = co_await readCompressedPacket();
+            if (!ok) {
+                co_return false;
+            }
+        }
+        auto k = std::min(n, _readBuf.length() - _readPos);
+        std::memcpy(p, _readBuf.data() + _readPos, k);
+        _readPos += k;
+        p += k;
+        n -= k;
+    }
+    co_return true;
+}
+
+Task<bool> PacketIO::readPacket(std::string &data) {
+    data.clear();
+    while (true) {
+        uint8_t header[packetHeaderSize];
+        bool ok = co_await readFull(header, packetHeaderSize);
+        if (!ok) {
+            co_return false;
+        }
+        // With compression, the compressed packets carry the sequence that is checked, as in MySQL.
+        if (_compression == CompressionAlgorithm::None) {
+            if (header[3] != _buffer.sequence()) {
+                // invalid sequence: the peer and us are out of sync.
+                co_return false;
+            }
+            _buffer.setSequence(header[3] + 1);
+        }
+
+        size_t length = header[0] | (header[1] << 8) | (header[2] << 16);
+        auto offset = data.length();
+        data.resize(offset + length);
+        ok = co_await readFull(reinterpret_cast<uint8_t *>(data.data()) + offset, length);
+        if (!ok) {
+            co_return false;
+        }
+        if (length < mysql::MaxPayloadLen) {
+            co_return true;
+        }
+    }
+}
+
+void PacketIO::writePacket(std::string_view payload) {
+    _buffer.appendPacket(payload);
+}
+
+Task<bool> PacketIO::flush() {
+    if (_compression != CompressionAlgorithm::None) {
+        co_return co_await flushCompressed();
+    }
+    bool ok = co_await writeSocket(_buffer.data(), _buffer.size());
+    if (!ok) {
+        co_return false;
+    }
+    _buffer.clear();
+    co_return true;
+}
+
+void PacketIO::setCompression(CompressionAlgorithm alg, int level, size_t threshold) {
+    _compression = alg;
+    _compressionLevel = level;
+    _compressionThreshold = threshold;
+}
+
+CompressionStats PacketIO::compressionStats() const {
+    CompressionStats stats;
+    stats.BytesWritten = _bytesWritten.load(std::memory_order_relaxed);
+    stats.WireBytesWritten = _wireBytesWritten.load(std::memory_order_relaxed);
+    stats.BytesRead = _bytesRead.load(std::memory_order_relaxed);
+    stats.WireBytesRead = _wireBytesRead.load(std::memory_order_relaxed);
+    stats.CompressTime = std::chrono::nanoseconds(_compressNanos.load(std::memory_order_relaxed));
+    stats.DecompressTime = std::chrono::nanoseconds(_decompressNanos.load(std::memory_order_relaxed));
+    return stats;
+}
+
+void PacketIO::release() {
+    _buffer.release();
+    std::string().swap(_compressed);
+    if (!hasBufferedInput()) {
+        std::string().swap(_readBuf);
+        _readPos = 0;
+    }
+}
+
+Task<bool> PacketIO::readCompressedPacket() {
+    uint8_t header[compressedHeaderSize];
+    bool ok = co_await readSocket(header, compressedHeaderSize);
+    if (!ok) {
+        co_return false;
+    }
+    if (header[3] != _compressedSequence) {
+        co_return false;
+    }
+    // The packets written in response continue the sequence of the compressed packet.
+    _compressedSequence = header[3] + 1;
+    _buffer.setSequence(_compressedSequence);
+
+    size_t length = header[0] | (header[1] << 8) | (header[2] << 16);
+    size_t uncompressedLen = header[4] | (header[5] << 8) | (header[6] << 16);
+    _readPos = 0;
+    if (uncompressedLen == 0) {
+        _readBuf.resize(length);
+        ok = co_await readSocket(reinterpret_cast<uint8_t *>(_readBuf.data()), length);
+        if (!ok) {
+            co_return false;
+        }
+    } else {
+        _compressed.resize(length);
+        ok = co_await readSocket(reinterpret_cast<uint8_t *>(_compressed.data()), length);
+        if (!ok) {
+            co_return false;
+        }
+        auto start = threadCPUTime();
+        ok = decompressPayload(_compression, _compressed, uncompressedLen, _readBuf);
+        _decompressNanos.fetch_add((threadCPUTime() - start).count(), std::memory_order_relaxed);
+        if (!ok) {
+            co_return false;
+        }
+    }
+    _bytesRead.fetch_add(_readBuf.length(), std::memory_order_relaxed);
+    _wireBytesRead.fetch_add(compressedHeaderSize + length, std::memory_order_relaxed);
+    co_return true;
+}
+
+Task<bool> PacketIO::flushCompressed() {
+    std::string_view data(reinterpret_cast<const char *>(_buffer.data()), _buffer.size());
+    while (!data.empty()) {
+        auto chunk = data.substr(0, mysql::MaxPayloadLen);
+        data.remove_prefix(chunk.length());
+
+        _compressed.resize(compressedHeaderSize);
+        size_t uncompressedLen = 0;
+        if (chunk.length() >= _compressionThreshold) {
+            auto start = threadCPUTime();
+            bool ok = compressPayload(_compression, _compressionLevel, chunk, _compressed);
+            _compressNanos.fetch_add((threadCPUTime() - start).count(), std::memory_order_relaxed);
+            // Incompressible data is sent as it is.
+            if (ok && _compressed.length() - compressedHeaderSize < chunk.length()) {
+                uncompressedLen = chunk.length();
+            } else {
+                _compressed.resize(compressedHeaderSize);
+            }
+        }
+        if (uncompressedLen == 0) {
+            _compressed.append(chunk);
+        }
+
+        auto header = reinterpret_cast<uint8_t *>(_compressed.data());
+        size_t length = _compressed.length() - compressedHeaderSize;
+        header[0] = static_cast<uint8_t>(length);
+        header[1] = static_cast<uint8_t>(length >> 8);
+        header[2] = static_cast<uint8_t>(length >> 16);
+        header[3] = _compressedSequence++;
+        header[4] = static_cast<uint8_t>(uncompressedLen);
+        header[5] = static_cast<uint8_t>(uncompressedLen >> 8);
+        header[6] = static_cast<uint8_t>(uncompressedLen >> 16);
+        bool ok = co_await writeSocket(header, _compressed.length());
+        if (!ok) {
+            co_return false;
+        }
+        _bytesWritten.fetch_add(chunk.length(), std::memory_order_relaxed);
+        _wireBytesWritten.fetch_add(_compressed.length(), std::memory_order_relaxed);
+    }
+    _buffer.clear();
+    co_return true;
+}
+
+}  // namespace server
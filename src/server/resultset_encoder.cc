@@ -0,0 +1,525 @@
+#include "server/resultset_encoder.hh"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#include "common/tracing.hh"
+#include "parser/mysql/const.hh"
+#include "parser/mysql/type.hh"
+
+namespace server {
+
+namespace {
+// Storage kinds of result columns. The integer kinds all hold 64-bit values and differ only in their binary
+// protocol width.
+enum : uint8_t {
+    kindTiny,
+    kindShort,
+    kindLong,
+    kindLonglong,
+    kindFloat,
+    kindDouble,
+    kindDateTime,
+    kindDuration,
+    kindBytes,
+};
+
+uint8_t kindOf(uint8_t tp) {
+    switch (tp) {
+        case mysql::TypeTiny:
+            return kindTiny;
+        case mysql::TypeShort:
+        case mysql::TypeYear:
+            return kindShort;
+        case mysql::TypeInt24:
+        case mysql::TypeLong:
+            return kindLong;
+        case mysql::TypeLonglong:
+            return kindLonglong;
+        case mysql::TypeFloat:
+            return kindFloat;
+        case mysql::TypeDouble:
+            return kindDouble;
+        case mysql::TypeDate:
+        case mysql::TypeNewDate:
+        case mysql::TypeDatetime:
+        case mysql::TypeTimestamp:
+            return kindDateTime;
+        case mysql::TypeDuration:
+            return kindDuration;
+        default:
+            return kindBytes;
+    }
+}
+
+constexpr bool isIntegerKind(uint8_t kind) { return kind <= kindLonglong; }
+
+// notFixedDec is the column decimal of a float column without a declared scale.
+constexpr uint8_t notFixedDec = 31;
+
+// maxFloatTextLen bounds the fixed notation of a double with up to notFixedDec decimals.
+constexpr size_t maxFloatTextLen = 310 + notFixedDec + 2;
+
+constexpr uint64_t powersOf10[] = {
+    1ull,
+    10ull,
+    100ull,
+    1000ull,
+    10000ull,
+    100000ull,
+    1000000ull,
+    10000000ull,
+    100000000ull,
+    1000000000ull,
+    10000000000ull,
+    100000000000ull,
+    1000000000000ull,
+    10000000000000ull,
+    100000000000000ull,
+    1000000000000000ull,
+    10000000000000000ull,
+    100000000000000000ull,
+    1000000000000000000ull,
+    10000000000000000000ull,
+};
+
+// countDigits returns the number of decimal digits of v without dividing.
+inline uint32_t countDigits(uint64_t v) {
+    v |= 1;
+    uint32_t t = (64 - __builtin_clzll(v)) * 1233 >> 12;
+    return t + 1 - (v < powersOf10[t] ? 1 : 0);
+}
+
+inline uint32_t intTextLen(int64_t v, bool isUnsigned) {
+    if (isUnsigned) {
+        return countDigits(static_cast<uint64_t>(v));
+    }
+    if (v < 0) {
+        return 1 + countDigits(0 - static_cast<uint64_t>(v));
+    }
+    return countDigits(static_cast<uint64_t>(v));
+}
+
+// floatPrecision returns the number of decimals to print a float column with, or -1 for the shortest form that
+// round-trips.
+inline int floatPrecision(const ColumnInfo &column) {
+    if (column.Decimal > 0 && column.Decimal != notFixedDec && column.Table.empty()) {
+        return column.Decimal;
+    }
+    return -1;
+}
+
+template <typename T>
+inline size_t formatFloat(char *p, T v, int prec) {
+    std::to_chars_result r;
+    if (prec >= 0) {
+        r = std::to_chars(p, p + maxFloatTextLen, v, std::chars_format::fixed, prec);
+    } else {
+        r = std::to_chars(p, p + maxFloatTextLen, v);
+    }
+    return r.ptr - p;
+}
+
+inline size_t binaryNullBitmapLen(size_t numColumns) { return (numColumns + 7 + 2) / 8; }
+}  // namespace
+
+ColumnBatch ColumnBatchOf(const util::chunk::Chunk &chk) {
+    ColumnBatch batch;
+    batch.columns.reserve(chk.NumCols());
+    for (size_t c = 0; c < chk.NumCols(); c++) {
+        const auto &col = chk.Col(c);
+        batch.columns.push_back({col.NullCount() > 0 ? col.NullBitmap() : nullptr, col.Data(),
+                                 col.IsFixed() ? nullptr : col.Offsets()});
+    }
+    batch.numRows = chk.NumRowsUnfiltered();
+    return batch;
+}
+
+ResultSetEncoder::ResultSetEncoder(const std::vector<ColumnInfo> &columns, uint32_t capability)
+    : _columns(columns), _capability(capability), _scratch(columns.size()) {
+    _kinds.reserve(columns.size());
+    for (auto &column : columns) {
+        _kinds.push_back(kindOf(column.Type));
+    }
+}
+
+void ResultSetEncoder::writeColumnInfo(PacketIO &io, uint16_t serverStatus) {
+    std::string data;
+    dumpLengthEncodedInt(data, _columns.size());
+    io.writePacket(data);
+    for (auto &column : _columns) {
+        data.clear();
+        column.Dump(data);
+        io.writePacket(data);
+    }
+    if ((_capability & mysql::ClientDeprecateEOF) == 0) {
+        writeEOF(io, serverStatus);
+    }
+}
+
+size_t ResultSetEncoder::reserveRows(PacketBuffer &buffer, size_t &n, std::string &oversizedRow) {
+    // A row that does not fit into a single packet is encoded on its own into oversizedRow, so that the caller can
+    // send it through the splitting path once everything before it has been flushed.
+    auto oversized = std::find_if(_rowLen.begin(), _rowLen.begin() + n,
+                                  [](uint32_t len) { return len >= mysql::MaxPayloadLen; });
+    if (oversized == _rowLen.begin()) {
+        n = 1;
+        if (!buffer.empty()) {
+            return 0;
+        }
+        oversizedRow.resize(_rowLen[0]);
+        _cursors.assign(1, reinterpret_cast<uint8_t *>(oversizedRow.data()));
+        return 1;
+    }
+    n = oversized - _rowLen.begin();
+
+    _cursors.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        auto p = buffer.reservePacket(_rowLen[i]);
+        if (p == nullptr) {
+            if (i == 0 && buffer.empty()) {
+                // The row is larger than the whole buffer: let the buffer grow for it.
+                buffer.ensureRoomFor(_rowLen[0]);
+                _cursors[0] = buffer.reservePacket(_rowLen[0]);
+                return 1;
+            }
+            return i;
+        }
+        _cursors[i] = p;
+    }
+    return n;
+}
+
+size_t ResultSetEncoder::encodeTextRows(PacketBuffer &buffer, const ColumnBatch &batch, size_t begin) {
+    while (begin < batch.numRows) {
+        size_t n = std::min(batchRows, batch.numRows - begin);
+        _rowLen.assign(n, 0);
+
+        // Pass 1: size every row, one column at a time.
+        for (size_t c = 0; c < _columns.size(); c++) {
+            auto &col = batch.columns[c];
+            auto kind = _kinds[c];
+            if (isIntegerKind(kind)) {
+                auto values = static_cast<const int64_t *>(col.data) + begin;
+                bool isUnsigned = mysql::HasUnsignedFlag(_columns[c].Flag);
+                for (size_t i = 0; i < n; i++) {
+                    // Integers are at most 20 characters, so their length prefix is always one byte.
+                    _rowLen[i] += col.isNull(begin + i) ? 1 : 1 + intTextLen(values[i], isUnsigned);
+                }
+            } else if (kind == kindFloat || kind == kindDouble) {
+                auto &scratch = _scratch[c];
+                auto prec = floatPrecision(_columns[c]);
+                scratch.textEnd.resize(n);
+                size_t end = 0;
+                for (size_t i = 0; i < n; i++) {
+                    if (col.isNull(begin + i)) {
+                        _rowLen[i] += 1;
+                    } else {
+                        if (scratch.text.size() < end + maxFloatTextLen) {
+                            scratch.text.resize(2 * (end + maxFloatTextLen));
+                        }
+                        auto out = &scratch.text[end];
+                        size_t len = kind == kindFloat
+                                         ? formatFloat(out, static_cast<const float *>(col.data)[begin + i], prec)
+                                         : formatFloat(out, static_cast<const double *>(col.data)[begin + i], prec);
+                        end += len;
+                        _rowLen[i] += lengthEncodedIntSize(len) + len;
+                    }
+                    scratch.textEnd[i] = end;
+                }
+            } else {
+                auto offsets = col.offsets + begin;
+                for (size_t i = 0; i < n; i++) {
+                    uint64_t len = offsets[i + 1] - offsets[i];
+                    _rowLen[i] += col.isNull(begin + i) ? 1 : lengthEncodedIntSize(len) + len;
+                }
+            }
+        }
+
+        std::string oversizedRow;
+        size_t fitted = reserveRows(buffer, n, oversizedRow);
+        if (fitted == 0) {
+            return begin;
+        }
+
+        // Pass 2: scatter the values into the reserved packets, one column at a time.
+        for (size_t c = 0; c < _columns.size(); c++) {
+            auto &col = batch.columns[c];
+            auto kind = _kinds[c];
+            if (isIntegerKind(kind)) {
+                auto values = static_cast<const int64_t *>(col.data) + begin;
+                bool isUnsigned = mysql::HasUnsignedFlag(_columns[c].Flag);
+                for (size_t i = 0; i < fitted; i++) {
+                    auto &p = _cursors[i];
+                    if (col.isNull(begin + i)) {
+                        *p++ = 0xfb;
+                        continue;
+                    }
+                    auto len = intTextLen(values[i], isUnsigned);
+                    *p++ = static_cast<uint8_t>(len);
+                    if (isUnsigned) {
+                        std::to_chars(reinterpret_cast<char *>(p), reinterpret_cast<char *>(p + len),
+                                      static_cast<uint64_t>(values[i]));
+                    } else {
+                        std::to_chars(reinterpret_cast<char *>(p), reinterpret_cast<char *>(p + len), values[i]);
+                    }
+                    p += len;
+                }
+            } else if (kind == kindFloat || kind == kindDouble) {
+                auto &scratch = _scratch[c];
+                for (size_t i = 0; i < fitted; i++) {
+                    auto &p = _cursors[i];
+                    if (col.isNull(begin + i)) {
+                        *p++ = 0xfb;
+                        continue;
+                    }
+                    size_t start = i == 0 ? 0 : scratch.textEnd[i - 1];
+                    p = putLengthEncodedString(p, &scratch.text[start], scratch.textEnd[i] - start);
+                }
+            } else {
+                auto offsets = col.offsets + begin;
+                auto data = static_cast<const uint8_t *>(col.data);
+                for (size_t i = 0; i < fitted; i++) {
+                    auto &p = _cursors[i];
+                    if (col.isNull(begin + i)) {
+                        *p++ = 0xfb;
+                        continue;
+                    }
+                    p = putLengthEncodedString(p, data + offsets[i], offsets[i + 1] - offsets[i]);
+                }
+            }
+        }
+
+        if (!oversizedRow.empty()) {
+            buffer.appendPacket(oversizedRow);
+        }
+        begin += fitted;
+        if (fitted < n) {
+            return begin;
+        }
+    }
+    return begin;
+}
+
+size_t ResultSetEncoder::encodeBinaryRows(PacketBuffer &buffer, const ColumnBatch &batch, size_t begin) {
+    const size_t bitmapLen = binaryNullBitmapLen(_columns.size());
+    while (begin < batch.numRows) {
+        size_t n = std::min(batchRows, batch.numRows - begin);
+        _rowLen.assign(n, 1 + bitmapLen);
+
+        // Pass 1: size every row, one column at a time.
+        for (size_t c = 0; c < _columns.size(); c++) {
+            auto &col = batch.columns[c];
+            auto kind = _kinds[c];
+            size_t width = 0;
+            switch (kind) {
+                case kindTiny:
+                    width = 1;
+                    break;
+                case kindShort:
+                    width = 2;
+                    break;
+                case kindLong:
+                case kindFloat:
+                    width = 4;
+                    break;
+                case kindLonglong:
+                case kindDouble:
+                    width = 8;
+                    break;
+                default:
+                    break;
+            }
+            if (width != 0) {
+                for (size_t i = 0; i < n; i++) {
+                    _rowLen[i] += col.isNull(begin + i) ? 0 : width;
+                }
+            } else if (kind == kindDateTime || kind == kindDuration) {
+                auto &times = _scratch[c].times;
+                auto offsets = col.offsets + begin;
+                auto data = static_cast<const char *>(col.data);
+                times.resize(n);
+                for (size_t i = 0; i < n; i++) {
+                    if (col.isNull(begin + i)) {
+                        continue;
+                    }
+                    std::string_view text(data + offsets[i], offsets[i + 1] - offsets[i]);
+                    bool ok = kind == kindDateTime ? dumpBinaryDateTime(text, times[i])
+                                                   : dumpBinaryTime(text, times[i]);
+                    if (!ok) {
+                        // Values come from the executor in canonical form; send the zero value for anything else.
+                        times[i]._length = 0;
+                    }
+                    _rowLen[i] += 1 + times[i]._length;
+                }
+            } else {
+                auto offsets = col.offsets + begin;
+                for (size_t i = 0; i < n; i++) {
+                    uint64_t len = offsets[i + 1] - offsets[i];
+                    _rowLen[i] += col.isNull(begin + i) ? 0 : lengthEncodedIntSize(len) + len;
+                }
+            }
+        }
+
+        std::string oversizedRow;
+        size_t fitted = reserveRows(buffer, n, oversizedRow);
+        if (fitted == 0) {
+            return begin;
+        }
+
+        // Each row starts with the OK header and the null bitmap, whose first two bits are reserved.
+        _rowStarts.resize(fitted);
+        for (size_t i = 0; i < fitted; i++) {
+            _rowStarts[i] = _cursors[i];
+            std::memset(_cursors[i], 0, 1 + bitmapLen);
+            _cursors[i] += 1 + bitmapLen;
+        }
+
+        // Pass 2: scatter the values into the reserved packets, one column at a time.
+        for (size_t c = 0; c < _columns.size(); c++) {
+            auto &col = batch.columns[c];
+            auto kind = _kinds[c];
+            size_t bit = c + 2;
+            if (col.nullBitmap != nullptr) {
+                for (size_t i = 0; i < fitted; i++) {
+                    if (col.isNull(begin + i)) {
+                        _rowStarts[i][1 + (bit >> 3)] |= 1 << (bit & 7);
+                    }
+                }
+            }
+            switch (kind) {
+                case kindTiny:
+                case kindShort:
+                case kindLong:
+                case kindLonglong: {
+                    auto values = static_cast<const int64_t *>(col.data) + begin;
+                    size_t width = kind == kindTiny ? 1 : kind == kindShort ? 2 : kind == kindLong ? 4 : 8;
+                    for (size_t i = 0; i < fitted; i++) {
+                        if (col.isNull(begin + i)) {
+                            continue;
+                        }
+                        // Little-endian truncation is the binary protocol encoding for every integer width.
+                        std::memcpy(_cursors[i], &values[i], width);
+                        _cursors[i] += width;
+                    }
+                    break;
+                }
+                case kindFloat:
+                case kindDouble: {
+                    size_t width = kind == kindFloat ? 4 : 8;
+                    auto values = static_cast<const uint8_t *>(col.data) + begin * width;
+                    for (size_t i = 0; i < fitted; i++) {
+                        if (col.isNull(begin + i)) {
+                            continue;
+                        }
+                        std::memcpy(_cursors[i], values + i * width, width);
+                        _cursors[i] += width;
+                    }
+                    break;
+                }
+                case kindDateTime:
+                case kindDuration: {
+                    auto &times = _scratch[c].times;
+                    for (size_t i = 0; i < fitted; i++) {
+                        if (col.isNull(begin + i)) {
+                            continue;
+                        }
+                        auto &p = _cursors[i];
+                        *p++ = times[i]._length;
+                        std::memcpy(p, times[i]._data, times[i]._length);
+                        p += times[i]._length;
+                    }
+                    break;
+                }
+                default: {
+                    auto offsets = col.offsets + begin;
+                    auto data = static_cast<const uint8_t *>(col.data);
+                    for (size_t i = 0; i < fitted; i++) {
+                        if (col.isNull(begin + i)) {
+                            continue;
+                        }
+                        _cursors[i] =
+                            putLengthEncodedString(_cursors[i], data + offsets[i], offsets[i + 1] - offsets[i]);
+                    }
+                    break;
+                }
+            }
+        }
+
+        if (!oversizedRow.empty()) {
+            buffer.appendPacket(oversizedRow);
+        }
+        begin += fitted;
+        if (fitted < n) {
+            return begin;
+        }
+    }
+    return begin;
+}
+
+Task<bool> ResultSetEncoder::writeRows(PacketIO &io, const ColumnBatch &batch, bool binary) {
+    common::tracing::Span span("write_rows");
+    size_t row = 0;
+    while (true) {
+        row = binary ? encodeBinaryRows(io.buffer(), batch, row) : encodeTextRows(io.buffer(), batch, row);
+        if (row == batch.numRows) {
+            co_return true;
+        }
+        // The encoding resumes at row once the buffer is flushed, the session being suspended while the socket is
+        // full.
+        bool ok = co_await io.flush();
+        if (!ok) {
+            co_return false;
+        }
+    }
+}
+
+void ResultSetEncoder::writeEOF(PacketIO &io, uint16_t serverStatus, uint16_t warnings) {
+    server::writeEOF(io, _capability, serverStatus, warnings);
+}
+
+void writeOK(PacketIO &io, uint32_t capability, uint64_t affectedRows, uint64_t lastInsertID, uint16_t serverStatus,
+             uint16_t warnings, std::string_view info) {
+    std::string data(1, static_cast<char>(mysql::OKHeader));
+    dumpLengthEncodedInt(data, affectedRows);
+    dumpLengthEncodedInt(data, lastInsertID);
+    if ((capability & mysql::ClientProtocol41) != 0) {
+        dumpUint16(data, serverStatus);
+        dumpUint16(data, warnings);
+    }
+    data.append(info);
+    io.writePacket(data);
+}
+
+void writeEOF(PacketIO &io, uint32_t capability, uint16_t serverStatus, uint16_t warnings) {
+    if ((capability & mysql::ClientDeprecateEOF) != 0) {
+        // The OK packet that replaces EOF keeps the EOF header so that clients can tell it from a row.
+        std::string data(1, static_cast<char>(mysql::EOFHeader));
+        dumpLengthEncodedInt(data, 0);
+        dumpLengthEncodedInt(data, 0);
+        dumpUint16(data, serverStatus);
+        dumpUint16(data, warnings);
+        io.writePacket(data);
+        return;
+    }
+    std::string data(1, static_cast<char>(mysql::EOFHeader));
+    if ((capability & mysql::ClientProtocol41) != 0) {
+        dumpUint16(data, warnings);
+        dumpUint16(data, serverStatus);
+    }
+    io.writePacket(data);
+}
+
+void writeError(PacketIO &io, uint32_t capability, const mysql::SQLError &err) {
+    std::string data(1, static_cast<char>(mysql::ErrHeader));
+    dumpUint16(data, err.Code);
+    if ((capability & mysql::ClientProtocol41) != 0) {
+        data += '#';
+        data += err.State;
+    }
+    data += err.Message;
+    io.writePacket(data);
+}
+
+}  // namespace server
@@ -0,0 +1,130 @@
+#include "server/scheduler.hh"
+
+#include <event2/thread.h>
+
+#include <mutex>
+#include <thread>
+
+namespace server {
+
+namespace {
+
+// currentScheduler and currentWorker identify the worker running on this thread, if any.
+thread_local const Scheduler *currentScheduler = nullptr;
+thread_local size_t currentWorker = 0;
+
+}  // namespace
+
+Scheduler::Scheduler(int numWorkers) {
+    for (int i = 0; i < numWorkers; i++) {
+        _workers.push_back(std::make_unique<worker>());
+    }
+    for (size_t i = 0; i < _workers.size(); i++) {
+        _threads.emplace_back([this, i] { run(i); });
+    }
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard lock(_mu);
+        _stopped = true;
+    }
+    _idle.notify_all();
+    for (auto &t : _threads) {
+        t.join();
+    }
+}
+
+void Scheduler::Schedule(std::coroutine_handle<> h) {
+    auto id = currentScheduler == this ? currentWorker : _nextWorker.fetch_add(1, std::memory_order_relaxed);
+    auto &w = *_workers[id % _workers.size()];
+    {
+        std::lock_guard lock(w.mu);
+        w.queue.push_back(h);
+    }
+    _queued.fetch_add(1);
+    // Pairs with run(): either the sleeping worker sees the new coroutine, or we see it sleeping.
+    if (_sleeping.load() > 0) {
+        std::lock_guard lock(_mu);
+        _idle.notify_one();
+    }
+}
+
+std::coroutine_handle<> Scheduler::pop(size_t id) {
+    {
+        auto &w = *_workers[id];
+        std::lock_guard lock(w.mu);
+        if (!w.queue.empty()) {
+            auto h = w.queue.back();
+            w.queue.pop_back();
+            return h;
+        }
+    }
+    for (size_t i = 1; i < _workers.size(); i++) {
+        auto &victim = *_workers[(id + i) % _workers.size()];
+        std::lock_guard lock(victim.mu);
+        if (!victim.queue.empty()) {
+            auto h = victim.queue.front();
+            victim.queue.pop_front();
+            return h;
+        }
+    }
+    return nullptr;
+}
+
+void Scheduler::run(size_t id) {
+    currentScheduler = this;
+    currentWorker = id;
+    while (true) {
+        if (auto h = pop(id)) {
+            _queued.fetch_sub(1);
+            h.resume();
+            continue;
+        }
+        std::unique_lock lock(_mu);
+        _sleeping.fetch_add(1);
+        _idle.wait(lock, [this] { return _stopped || _queued.load() > 0; });
+        _sleeping.fetch_sub(1);
+        if (_stopped && _queued.load() == 0) {
+            return;
+        }
+    }
+}
+
+bool fdAwaiter::await_suspend(std::coroutine_handle<> h) {
+    _handle = h;
+    // The event may fire and resume the coroutine on a worker before event_base_once returns: nothing may touch
+    // the awaiter after it.
+    if (event_base_once(_reactor._base, _fd, _events, Reactor::onReady, this, nullptr) != 0) {
+        _events = 0;
+        return false;
+    }
+    return true;
+}
+
+Reactor::Reactor(Scheduler &scheduler) : _scheduler(scheduler) {
+    static std::once_flag threadsEnabled;
+    std::call_once(threadsEnabled, [] { evthread_use_pthreads(); });
+    _base = event_base_new();
+    _thread = std::thread([this] { event_base_loop(_base, EVLOOP_NO_EXIT_ON_EMPTY); });
+}
+
+Reactor::~Reactor() {
+    Stop();
+    event_base_free(_base);
+}
+
+void Reactor::Stop() {
+    if (_thread.joinable()) {
+        event_base_loopbreak(_base);
+        _thread.join();
+    }
+}
+
+void Reactor::onReady(evutil_socket_t, short events, void *arg) {
+    auto awaiter = static_cast<fdAwaiter *>(arg);
+    awaiter->_events = events;
+    awaiter->_reactor._scheduler.Schedule(awaiter->_handle);
+}
+
+}  // namespace server
@@ -0,0 +1,239 @@
+#include "server/server.hh"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <event2/buffer.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+
+#include "common/logger.hh"
+#include "metrics/server.hh"
+#include "server/conn.hh"
+#include "server/resultset_encoder.hh"
+
+namespace server {
+
+Server::Server(Config cfg)
+    : _cfg(std::move(cfg)), _scheduler(std::max(_cfg.NumWorkers, 1)), _traces(_cfg.MaxTraces) {
+    if (_cfg.EnableStmtSummary) {
+        _stmtSummary =
+            std::make_unique<StmtSummary>(_cfg.StmtSummaryRefreshInterval, _cfg.StmtSummaryHistorySize,
+                                          _cfg.StmtSummaryMaxStmtCount, _cfg.StmtSummaryMaxSQLLength);
+    }
+    _queryExecutor = [](PacketIO &, TiDBContext &, uint32_t,
+                        std::string_view) -> Task<std::optional<mysql::SQLError>> {
+        co_return mysql::NewErr(mysql::ErrNotSupportedYet, "COM_QUERY");
+    };
+    _stmtExecutor = [](PacketIO &, TiDBStatement &) -> Task<std::optional<mysql::SQLError>> {
+        co_return mysql::NewErr(mysql::ErrNotSupportedYet, "COM_STMT_EXECUTE");
+    };
+}
+
+Server::~Server() { Close(); }
+
+bool Server::Start() {
+    // A client that goes away while its result is written must not kill the server.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    for (int i = 0; i < std::max(_cfg.NumReactors, 1); i++) {
+        _reactors.push_back(std::make_unique<Reactor>(_scheduler));
+    }
+    if (_cfg.ReportStatus && !startStatus()) {
+        return false;
+    }
+    if (!_cfg.SlowQueryFile.empty()) {
+        try {
+            _slowLog = std::make_unique<SlowQueryLogger>(_cfg.SlowQueryFile);
+        } catch (const spdlog::spdlog_ex &e) {
+            LOG_ERROR("cannot open the slow query log: {}", e.what());
+            return false;
+        }
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(_cfg.Port);
+    if (inet_pton(AF_INET, _cfg.Host.c_str(), &addr.sin_addr) != 1) {
+        return false;
+    }
+    _listener = evconnlistener_new_bind(_reactors[0]->base(), onAccept, this,
+                                        LEV_OPT_CLOSE_ON_FREE | LEV_OPT_REUSEABLE | LEV_OPT_THREADSAFE, -1,
+                                        reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    if (_listener == nullptr) {
+        return false;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(evconnlistener_get_fd(_listener), reinterpret_cast<sockaddr *>(&addr), &len);
+    _port = ntohs(addr.sin_port);
+    return true;
+}
+
+void Server::Close() {
+    if (_listener != nullptr) {
+        evconnlistener_free(_listener);
+        _listener = nullptr;
+    }
+    {
+        std::unique_lock lock(_mu);
+        _closing = true;
+        for (auto &[fd, cc] : _conns) {
+            // Wakes up the sessions parked in a reactor and fails the ones executing at their next read or write.
+            shutdown(fd, SHUT_RDWR);
+        }
+        _connsClosed.wait(lock, [this] { return _conns.empty(); });
+    }
+    // No session is parked anymore, and onAccept does not touch the reactors once _closing is set.
+    // The status server is freed once its reactor stopped, so that no request is being served.
+    for (auto &reactor : _reactors) {
+        reactor->Stop();
+    }
+    if (_status != nullptr) {
+        evhttp_free(_status);
+        _status = nullptr;
+    }
+    _reactors.clear();
+}
+
+bool Server::startStatus() {
+    _status = evhttp_new(_reactors[0]->base());
+    evhttp_set_allowed_methods(_status, EVHTTP_REQ_GET);
+    evhttp_set_cb(_status, "/metrics", onMetrics, this);
+    evhttp_set_cb(_status, "/debug/trace", onTrace, this);
+    if (_stmtSummary != nullptr) {
+        evhttp_set_cb(_status, "/statements_summary", onStmtSummary, this);
+        evhttp_set_cb(_status, "/statements_summary_history", onStmtSummaryHistory, this);
+    }
+    auto handle = evhttp_bind_socket_with_handle(_status, _cfg.StatusHost.c_str(), _cfg.StatusPort);
+    if (handle == nullptr) {
+        return false;
+    }
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    getsockname(evhttp_bound_socket_get_fd(handle), reinterpret_cast<sockaddr *>(&addr), &len);
+    _statusPort = ntohs(addr.sin_port);
+    return true;
+}
+
+void Server::onMetrics(evhttp_request *req, void *) {
+    // The shards of the metrics are merged here, on the reactor: scraping costs the sessions nothing.
+    std::string out;
+    metrics::WritePrometheus(out);
+    evhttp_add_header(evhttp_request_get_output_headers(req), "Content-Type", "text/plain; version=0.0.4");
+    evbuffer_add(evhttp_request_get_output_buffer(req), out.data(), out.length());
+    evhttp_send_reply(req, HTTP_OK, "OK", nullptr);
+}
+
+void Server::onStmtSummary(evhttp_request *req, void *arg) {
+    std::string out;
+    WriteStmtSummaryJSON(static_cast<Server *>(arg)->_stmtSummary->Current(), out);
+    evhttp_add_header(evhttp_request_get_output_headers(req), "Content-Type", "application/json");
+    evbuffer_add(evhttp_request_get_output_buffer(req), out.data(), out.length());
+    evhttp_send_reply(req, HTTP_OK, "OK", nullptr);
+}
+
+void Server::onStmtSummaryHistory(evhttp_request *req, void *arg) {
+    std::string out;
+    WriteStmtSummaryJSON(static_cast<Server *>(arg)->_stmtSummary->History(), out);
+    evhttp_add_header(evhttp_request_get_output_headers(req), "Content-Type", "application/json");
+    evbuffer_add(evhttp_request_get_output_buffer(req), out.data(), out.length());
+    evhttp_send_reply(req, HTTP_OK, "OK", nullptr);
+}
+
+void Server::onTrace(evhttp_request *req, void *arg) {
+    std::string out;
+    static_cast<Server *>(arg)->_traces.WriteChromeJSON(out);
+    evhttp_add_header(evhttp_request_get_output_headers(req), "Content-Type", "application/json");
+    evbuffer_add(evhttp_request_get_output_buffer(req), out.data(), out.length());
+    evhttp_send_reply(req, HTTP_OK, "OK", nullptr);
+}
+
+size_t Server::NumConnections() const {
+    std::lock_guard lock(_mu);
+    return _conns.size();
+}
+
+void Server::onAccept(evconnlistener *, evutil_socket_t fd, sockaddr *, int, void *arg) {
+    auto s = static_cast<Server *>(arg);
+    std::lock_guard lock(s->_mu);
+    if (s->_closing) {
+        close(fd);
+        return;
+    }
+    s->_conns.emplace(fd, nullptr);
+    metrics::Connections.Inc();
+    evutil_make_socket_nonblocking(fd);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    auto &reactor = *s->_reactors[s->_nextReactor++ % s->_reactors.size()];
+    s->_scheduler.Schedule(s->runSession(reactor, fd, ++s->_baseConnID).handle());
+}
+
+DetachedTask Server::runSession(Reactor &reactor, int fd, uint32_t connID) {
+    {
+        clientConn cc(*this, reactor, fd, connID);
+        setConn(fd, &cc);
+        bool ok = co_await cc.writeInitialHandshake();
+        if (ok) {
+            co_await reactor.WaitFor(fd, EV_READ);
+            ok = co_await cc.handshake();
+        }
+        if (ok) {
+            LOG_DEBUG("connection {} logged in", connID);
+        }
+        while (ok) {
+            // Park in the reactor until the next command arrives, holding neither a worker nor a buffer.
+            // A compressed packet may carry several commands: the ones already read are served without parking.
+            if (!cc.io().hasBufferedInput()) {
+                cc.io().release();
+                co_await reactor.WaitFor(fd, EV_READ);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            auto ioTime = cc.io().ioTime();
+            std::string data;
+            ok = co_await cc.readPacket(data);
+            if (ok) {
+                ok = co_await cc.dispatch(data);
+                metrics::CommandDuration.ObserveSince(start);
+                metrics::PhaseDuration(metrics::Phase::Network).Observe((cc.io().ioTime() - ioTime).count());
+            }
+        }
+        setConn(fd, nullptr);
+    }
+    LOG_DEBUG("connection {} closed", connID);
+    onConnClosed(fd);
+}
+
+std::unordered_map<uint32_t, CompressionStats> Server::ConnCompressionStats() const {
+    std::unordered_map<uint32_t, CompressionStats> stats;
+    std::lock_guard lock(_mu);
+    for (auto &[fd, cc] : _conns) {
+        if (cc != nullptr) {
+            stats.emplace(cc->ConnectionID(), cc->GetCompressionStats());
+        }
+    }
+    return stats;
+}
+
+void Server::setConn(int fd, clientConn *cc) {
+    std::lock_guard lock(_mu);
+    _conns[fd] = cc;
+}
+
+void Server::onConnClosed(int fd) {
+    std::lock_guard lock(_mu);
+    // The descriptor is closed under the lock so that Close never shuts down a reused one.
+    close(fd);
+    _conns.erase(fd);
+    metrics::Connections.Dec();
+    if (_conns.empty()) {
+        _connsClosed.notify_all();
+    }
+}
+
+}  // namespace server
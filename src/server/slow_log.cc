@@ -0,0 +1,125 @@
+#include "server/slow_log.hh"
+
+#include <fmt/format.h>
+#include <spdlog/sinks/basic_file_sink.h>
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+#include "metrics/server.hh"
+
+namespace server {
+
+namespace {
+
+// formatTime formats t like TiDB's slow log: 2021-10-28T10:11:12.123456+08:00.
+std::string formatTime(std::chrono::system_clock::time_point t) {
+    auto secs = std::chrono::system_clock::to_time_t(t);
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count() % 1000000;
+    std::tm tm{};
+    localtime_r(&secs, &tm);
+    char date[32], zone[8];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &tm);
+    std::strftime(zone, sizeof(zone), "%z", &tm);
+    // %z gives +0800.
+    return fmt::format("{}.{:06}{}{}:{}", date, micros, zone[0], std::string_view(zone + 1, 2),
+                       std::string_view(zone + 3, 2));
+}
+
+double seconds(std::chrono::nanoseconds d) { return std::chrono::duration<double>(d).count(); }
+
+void formatRecord(std::string &out, const SlowQueryRecord &r) {
+    out += fmt::format("# Time: {}\n", formatTime(r.Time));
+    out += fmt::format("# Conn_ID: {}\n", r.ConnID);
+    out += fmt::format("# Query_time: {}\n", seconds(r.QueryTime));
+    out += fmt::format("# Parse_time: {}\n", seconds(r.ParseTime));
+    out += fmt::format("# Execute_time: {}\n", seconds(r.ExecuteTime));
+    out += fmt::format("# Write_sql_response_total: {}\n", seconds(r.WriteTime));
+    out += fmt::format("# Digest: {}\n", r.Digest.String());
+    out += fmt::format("# Mem_max: {}\n", r.MemMax);
+    out += fmt::format("# Result_rows: {}\n", r.ResultRows);
+    out += fmt::format("# Prepared: {}\n", r.Prepared);
+    out += fmt::format("# Succ: {}\n", r.Succ);
+    out += r.GetSQL();
+    out += ';';
+}
+
+}  // namespace
+
+void SlowQueryRecord::SetSQL(std::string_view sql) {
+    SQLLen = std::min(sql.length(), maxSQLLen);
+    std::memcpy(SQL, sql.data(), SQLLen);
+}
+
+SlowQueryLogger::SlowQueryLogger(const std::string &file, std::chrono::milliseconds flushInterval)
+    : _flushInterval(flushInterval) {
+    // Only the background thread writes, the sink needs no lock.
+    _logger = std::make_shared<spdlog::logger>("slow-query", std::make_shared<spdlog::sinks::basic_file_sink_st>(file));
+    _logger->set_pattern("%v");
+    _thread = std::thread([this] { run(); });
+}
+
+SlowQueryLogger::~SlowQueryLogger() {
+    {
+        std::lock_guard lock(_mu);
+        _stopped = true;
+    }
+    _cond.notify_all();
+    _thread.join();
+}
+
+bool SlowQueryLogger::Log(const SlowQueryRecord &record) {
+    if (!_ring.TryPush(record)) {
+        metrics::SlowQueriesDropped.Add();
+        return false;
+    }
+    _pushed.fetch_add(1, std::memory_order_relaxed);
+    metrics::SlowQueries.Add();
+    return true;
+}
+
+void SlowQueryLogger::Flush() {
+    auto target = _pushed.load(std::memory_order_relaxed);
+    std::unique_lock lock(_mu);
+    _flushRequested = true;
+    _cond.notify_all();
+    _cond.wait(lock, [&] { return _written >= target; });
+}
+
+void SlowQueryLogger::run() {
+    std::unique_lock lock(_mu);
+    while (true) {
+        _cond.wait_for(lock, _flushInterval, [this] { return _flushRequested || _stopped; });
+        _flushRequested = false;
+        bool stopped = _stopped;
+        lock.unlock();
+        auto n = drain();
+        lock.lock();
+        _written += n;
+        _cond.notify_all();
+        if (stopped && n == 0) {
+            return;
+        }
+    }
+}
+
+size_t SlowQueryLogger::drain() {
+    std::string batch;
+    SlowQueryRecord record;
+    size_t n = 0;
+    while (_ring.TryPop(record)) {
+        if (n > 0) {
+            batch += '\n';
+        }
+        formatRecord(batch, record);
+        n++;
+    }
+    if (n > 0) {
+        _logger->info("{}", batch);
+        _logger->flush();
+    }
+    return n;
+}
+
+}  // namespace server
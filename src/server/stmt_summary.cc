@@ -0,0 +1,308 @@
+#include "server/stmt_summary.hh"
+
+#include <algorithm>
+#include <ctime>
+#include <nlohmann/json.hpp>
+
+#include "metrics/metrics.hh"
+
+namespace server {
+
+namespace {
+
+// mergeWindow merges w into the window with the same beginning in windows, which is ordered, keeping the last
+// historySize windows.
+template <typename Window>
+void mergeWindow(std::deque<Window> &windows, const Window &w, size_t historySize) {
+    auto it = std::lower_bound(windows.begin(), windows.end(), w.Begin,
+                               [](const Window &a, auto begin) { return a.Begin < begin; });
+    if (it != windows.end() && it->Begin == w.Begin) {
+        it->Stats.Merge(w.Stats);
+    } else {
+        windows.insert(it, w);
+    }
+    while (windows.size() > historySize) {
+        windows.pop_front();
+    }
+}
+
+// formatTime formats t like a DATETIME, in the local time zone.
+std::string formatTime(std::chrono::system_clock::time_point t) {
+    auto secs = std::chrono::system_clock::to_time_t(t);
+    std::tm tm{};
+    localtime_r(&secs, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    return buf;
+}
+
+}  // namespace
+
+void StmtSummaryStats::Add(const StmtExecInfo &info, size_t maxSQLLength) {
+    if (ExecCount == 0) {
+        SampleSQL = info.SampleSQL.substr(0, maxSQLLength);
+        Prepared = info.Prepared;
+        FirstSeen = info.StartTime;
+        MinLatency = info.Latency;
+    }
+    ExecCount++;
+    SumLatency += info.Latency;
+    MaxLatency = std::max(MaxLatency, info.Latency);
+    MinLatency = std::min(MinLatency, info.Latency);
+    SumParseLatency += info.ParseLatency;
+    SumExecLatency += info.ExecLatency;
+    SumExaminedRows += info.ExaminedRows;
+    MaxExaminedRows = std::max(MaxExaminedRows, info.ExaminedRows);
+    SumResultRows += info.ResultRows;
+    MaxResultRows = std::max(MaxResultRows, info.ResultRows);
+    SumMem += info.MemMax;
+    MaxMem = std::max(MaxMem, info.MemMax);
+    if (info.ErrorCode != 0) {
+        SumErrors++;
+        auto it = std::find_if(Errors.begin(), Errors.end(), [&](auto &e) { return e.first == info.ErrorCode; });
+        if (it != Errors.end()) {
+            it->second++;
+        } else {
+            Errors.emplace_back(info.ErrorCode, 1);
+        }
+    }
+    FirstSeen = std::min(FirstSeen, info.StartTime);
+    LastSeen = std::max(LastSeen, info.StartTime);
+
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(info.Latency).count();
+    auto bucket = metrics::Histogram::bucketIndex(static_cast<uint64_t>(std::max<int64_t>(micros, 0)));
+    if (LatencyBuckets.size() <= bucket) {
+        LatencyBuckets.resize(bucket + 1);
+    }
+    LatencyBuckets[bucket]++;
+}
+
+void StmtSummaryStats::Merge(const StmtSummaryStats &other) {
+    if (other.ExecCount == 0) {
+        return;
+    }
+    if (ExecCount == 0) {
+        *this = other;
+        return;
+    }
+    ExecCount += other.ExecCount;
+    SumLatency += other.SumLatency;
+    MaxLatency = std::max(MaxLatency, other.MaxLatency);
+    MinLatency = std::min(MinLatency, other.MinLatency);
+    SumParseLatency += other.SumParseLatency;
+    SumExecLatency += other.SumExecLatency;
+    SumExaminedRows += other.SumExaminedRows;
+    MaxExaminedRows = std::max(MaxExaminedRows, other.MaxExaminedRows);
+    SumResultRows += other.SumResultRows;
+    MaxResultRows = std::max(MaxResultRows, other.MaxResultRows);
+    SumMem += other.SumMem;
+    MaxMem = std::max(MaxMem, other.MaxMem);
+    SumErrors += other.SumErrors;
+    for (auto &[code, n] : other.Errors) {
+        auto it = std::find_if(Errors.begin(), Errors.end(), [code = code](auto &e) { return e.first == code; });
+        if (it != Errors.end()) {
+            it->second += n;
+        } else {
+            Errors.emplace_back(code, n);
+        }
+    }
+    FirstSeen = std::min(FirstSeen, other.FirstSeen);
+    LastSeen = std::max(LastSeen, other.LastSeen);
+    if (LatencyBuckets.size() < other.LatencyBuckets.size()) {
+        LatencyBuckets.resize(other.LatencyBuckets.size());
+    }
+    for (size_t i = 0; i < other.LatencyBuckets.size(); i++) {
+        LatencyBuckets[i] += other.LatencyBuckets[i];
+    }
+}
+
+std::chrono::nanoseconds StmtSummaryStats::LatencyPercentile(double q) const {
+    metrics::HistogramSnapshot snapshot;
+    snapshot.Count = ExecCount;
+    snapshot.Buckets.assign(LatencyBuckets.begin(), LatencyBuckets.end());
+    // The bucket bounds are coarser than the exact maximum.
+    return std::min<std::chrono::nanoseconds>(std::chrono::microseconds(snapshot.Percentile(q)), MaxLatency);
+}
+
+StmtSummary::StmtSummary(std::chrono::seconds refreshInterval, size_t historySize, size_t maxStmtCount,
+                         size_t maxSQLLength)
+    : _refreshInterval(std::max(refreshInterval, std::chrono::seconds(1))),
+      _historySize(std::max<size_t>(historySize, 1)),
+      _maxStmtCount(std::max<size_t>(maxStmtCount, 1)),
+      _maxSQLLength(maxSQLLength),
+      _stmts(_maxStmtCount) {}
+
+std::chrono::system_clock::time_point StmtSummary::windowBegin(std::chrono::system_clock::time_point t) const {
+    return t - std::chrono::duration_cast<std::chrono::system_clock::duration>(t.time_since_epoch() %
+                                                                                _refreshInterval);
+}
+
+void StmtSummary::addToWindows(std::deque<window> &windows, const StmtExecInfo &info) const {
+    auto begin = windowBegin(info.StartTime);
+    if (windows.empty() || windows.back().Begin < begin) {
+        windows.push_back({begin, {}});
+        if (windows.size() > _historySize) {
+            windows.pop_front();
+        }
+    }
+    // A statement that started just before a new window was opened by another one is accounted in the new window.
+    windows.back().Stats.Add(info, _maxSQLLength);
+}
+
+void StmtSummary::Add(const StmtExecInfo &info) {
+    stmtKeyView key{info.Digest, info.SchemaName};
+    auto update = [&](stmtEntry &entry) { addToWindows(entry.Windows, info); };
+    if (_stmts.update_fn(key, update)) {
+        return;
+    }
+    if (_stmts.size() >= _maxStmtCount) {
+        evict();
+    }
+    stmtEntry entry;
+    entry.NormalizedSQL = info.NormalizedSQL.substr(0, _maxSQLLength);
+    addToWindows(entry.Windows, info);
+    // Another session may have added the statement since the lookup above.
+    _stmts.upsert(key, update, std::move(entry));
+}
+
+void StmtSummary::evict() {
+    auto table = _stmts.lock_table();
+    // Another session may have evicted while this one waited for the lock.
+    if (table.size() < _maxStmtCount) {
+        return;
+    }
+    using iterator = decltype(table.begin());
+    std::vector<std::pair<std::chrono::system_clock::time_point, iterator>> lastSeen;
+    lastSeen.reserve(table.size());
+    for (auto it = table.begin(); it != table.end(); ++it) {
+        lastSeen.emplace_back(it->second.Windows.back().Stats.LastSeen, it);
+    }
+    auto n = std::min(lastSeen.size(), table.size() - _maxStmtCount + std::max<size_t>(_maxStmtCount / 8, 1));
+    std::nth_element(lastSeen.begin(), lastSeen.begin() + (n - 1), lastSeen.end(),
+                     [](auto &a, auto &b) { return a.first < b.first; });
+
+    std::lock_guard lock(_othersMu);
+    for (size_t i = 0; i < n; i++) {
+        for (auto &w : lastSeen[i].second->second.Windows) {
+            mergeWindow(_others, w, _historySize);
+        }
+        // Erasing an element does not move the others: the remaining iterators stay valid.
+        table.erase(lastSeen[i].second);
+    }
+}
+
+void StmtSummary::appendRecords(std::vector<StmtSummaryRecord> &out, const stmtKey *key,
+                                std::string_view normalizedSQL, const std::deque<window> &windows,
+                                const std::chrono::system_clock::time_point *begin) const {
+    for (auto &w : windows) {
+        if (begin != nullptr && w.Begin != *begin) {
+            continue;
+        }
+        auto &r = out.emplace_back();
+        r.Begin = w.Begin;
+        r.End = w.Begin + _refreshInterval;
+        if (key != nullptr) {
+            r.Digest = key->Digest;
+            r.SchemaName = key->SchemaName;
+            r.NormalizedSQL = normalizedSQL;
+        }
+        r.Stats = w.Stats;
+    }
+}
+
+std::vector<StmtSummaryRecord> StmtSummary::Current(std::chrono::system_clock::time_point now) const {
+    auto begin = windowBegin(now);
+    std::vector<StmtSummaryRecord> records;
+    {
+        auto table = _stmts.lock_table();
+        for (auto &[key, entry] : table) {
+            appendRecords(records, &key, entry.NormalizedSQL, entry.Windows, &begin);
+        }
+    }
+    std::sort(records.begin(), records.end(),
+              [](auto &a, auto &b) { return a.Stats.SumLatency > b.Stats.SumLatency; });
+
+    std::lock_guard lock(_othersMu);
+    appendRecords(records, nullptr, {}, _others, &begin);
+    return records;
+}
+
+std::vector<StmtSummaryRecord> StmtSummary::History() const {
+    std::vector<StmtSummaryRecord> records;
+    {
+        auto table = _stmts.lock_table();
+        for (auto &[key, entry] : table) {
+            appendRecords(records, &key, entry.NormalizedSQL, entry.Windows, nullptr);
+        }
+    }
+    {
+        std::lock_guard lock(_othersMu);
+        appendRecords(records, nullptr, {}, _others, nullptr);
+    }
+    // By window, then the slowest statements first and "others" last.
+    std::sort(records.begin(), records.end(), [](auto &a, auto &b) {
+        if (a.Begin != b.Begin) {
+            return a.Begin < b.Begin;
+        }
+        if (a.IsOthers() != b.IsOthers()) {
+            return b.IsOthers();
+        }
+        return a.Stats.SumLatency > b.Stats.SumLatency;
+    });
+    return records;
+}
+
+void StmtSummary::Clear() {
+    _stmts.clear();
+    std::lock_guard lock(_othersMu);
+    _others.clear();
+}
+
+void WriteStmtSummaryJSON(const std::vector<StmtSummaryRecord> &records, std::string &out) {
+    auto doc = nlohmann::json::array();
+    for (auto &r : records) {
+        auto &s = r.Stats;
+        auto avg = [&](auto sum) { return s.ExecCount == 0 ? 0 : static_cast<uint64_t>(sum) / s.ExecCount; };
+        auto errors = nlohmann::json::object();
+        for (auto &[code, count] : s.Errors) {
+            errors[std::to_string(code)] = count;
+        }
+        nlohmann::json record = {{"SUMMARY_BEGIN_TIME", formatTime(r.Begin)},
+                                 {"SUMMARY_END_TIME", formatTime(r.End)},
+                                 {"SCHEMA_NAME", r.SchemaName},
+                                 {"DIGEST", nullptr},
+                                 {"DIGEST_TEXT", nullptr},
+                                 {"QUERY_SAMPLE_TEXT", nullptr},
+                                 {"PREPARED", s.Prepared},
+                                 {"EXEC_COUNT", s.ExecCount},
+                                 {"SUM_ERRORS", s.SumErrors},
+                                 {"ERRORS", std::move(errors)},
+                                 {"SUM_LATENCY", s.SumLatency.count()},
+                                 {"MAX_LATENCY", s.MaxLatency.count()},
+                                 {"MIN_LATENCY", s.MinLatency.count()},
+                                 {"AVG_LATENCY", avg(s.SumLatency.count())},
+                                 {"P50_LATENCY", s.LatencyPercentile(0.5).count()},
+                                 {"P90_LATENCY", s.LatencyPercentile(0.9).count()},
+                                 {"P99_LATENCY", s.LatencyPercentile(0.99).count()},
+                                 {"AVG_PARSE_LATENCY", avg(s.SumParseLatency.count())},
+                                 {"AVG_EXEC_LATENCY", avg(s.SumExecLatency.count())},
+                                 {"AVG_ROWS_EXAMINED", avg(s.SumExaminedRows)},
+                                 {"MAX_ROWS_EXAMINED", s.MaxExaminedRows},
+                                 {"AVG_RESULT_ROWS", avg(s.SumResultRows)},
+                                 {"MAX_RESULT_ROWS", s.MaxResultRows},
+                                 {"AVG_MEM", avg(s.SumMem)},
+                                 {"MAX_MEM", s.MaxMem},
+                                 {"FIRST_SEEN", formatTime(s.FirstSeen)},
+                                 {"LAST_SEEN", formatTime(s.LastSeen)}};
+        if (!r.IsOthers()) {
+            record["DIGEST"] = r.Digest.String();
+            record["DIGEST_TEXT"] = r.NormalizedSQL;
+            record["QUERY_SAMPLE_TEXT"] = s.SampleSQL;
+        }
+        doc.push_back(std::move(record));
+    }
+    // The statement texts may not be valid UTF-8.
+    out += doc.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+}  // namespace server
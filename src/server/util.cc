@@ -0,0 +1,193 @@
+#include "server/util.hh"
+
+namespace server {
+
+void dumpLengthEncodedInt(std::string &buffer, uint64_t n) {
+    uint8_t tmp[9];
+    auto end = putLengthEncodedInt(tmp, n);
+    buffer.append(reinterpret_cast<const char *>(tmp), end - tmp);
+}
+
+void dumpLengthEncodedString(std::string &buffer, std::string_view s) {
+    dumpLengthEncodedInt(buffer, s.length());
+    buffer.append(s);
+}
+
+void dumpUint16(std::string &buffer, uint16_t n) {
+    uint8_t tmp[2];
+    putUint16(tmp, n);
+    buffer.append(reinterpret_cast<const char *>(tmp), sizeof(tmp));
+}
+
+void dumpUint32(std::string &buffer, uint32_t n) {
+    uint8_t tmp[4];
+    putUint32(tmp, n);
+    buffer.append(reinterpret_cast<const char *>(tmp), sizeof(tmp));
+}
+
+void dumpUint64(std::string &buffer, uint64_t n) {
+    uint8_t tmp[8];
+    putUint64(tmp, n);
+    buffer.append(reinterpret_cast<const char *>(tmp), sizeof(tmp));
+}
+
+std::tuple<uint64_t, bool, size_t> parseLengthEncodedInt(std::string_view b) {
+    if (b.empty()) {
+        return {0, false, 0};
+    }
+    auto p = reinterpret_cast<const uint8_t *>(b.data());
+    auto readN = [&](size_t n) -> std::tuple<uint64_t, bool, size_t> {
+        if (b.length() < n + 1) {
+            return {0, false, 0};
+        }
+        uint64_t num = 0;
+        for (size_t i = 0; i < n; i++) {
+            num |= static_cast<uint64_t>(p[1 + i]) << (8 * i);
+        }
+        return {num, false, n + 1};
+    };
+    switch (p[0]) {
+        // 251: NULL
+        case 0xfb:
+            return {0, true, 1};
+        // 252: value of following 2
+        case 0xfc:
+            return readN(2);
+        // 253: value of following 3
+        case 0xfd:
+            return readN(3);
+        // 254: value of following 8
+        case 0xfe:
+            return readN(8);
+        default:
+            // 0-250: value of first byte
+            return {p[0], false, 1};
+    }
+}
+
+std::tuple<std::string_view, bool, size_t> parseLengthEncodedBytes(std::string_view b) {
+    auto [num, isNull, n] = parseLengthEncodedInt(b);
+    if (n == 0 || isNull) {
+        return {{}, isNull, n};
+    }
+    if (num > b.length() - n) {
+        return {{}, false, 0};
+    }
+    return {b.substr(n, num), false, n + num};
+}
+
+std::pair<std::string_view, std::string_view> parseNullTermString(std::string_view b) {
+    auto off = b.find('\0');
+    if (off == std::string_view::npos) {
+        return {{}, b};
+    }
+    return {b.substr(0, off), b.substr(off + 1)};
+}
+
+namespace {
+// parseDigits parses exactly n decimal digits starting at text[pos].
+bool parseDigits(std::string_view text, size_t pos, size_t n, uint32_t &out) {
+    if (pos + n > text.length()) {
+        return false;
+    }
+    out = 0;
+    for (size_t i = pos; i < pos + n; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        out = out * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+// parseMicrosecond parses an optional ".ffffff" fraction at text[pos], right-padding it to 6 digits.
+bool parseMicrosecond(std::string_view text, size_t pos, uint32_t &out) {
+    out = 0;
+    if (pos == text.length()) {
+        return true;
+    }
+    if (text[pos] != '.') {
+        return false;
+    }
+    size_t digits = text.length() - pos - 1;
+    if (digits == 0 || digits > 6 || !parseDigits(text, pos + 1, digits, out)) {
+        return false;
+    }
+    for (; digits < 6; digits++) {
+        out *= 10;
+    }
+    return true;
+}
+}  // namespace
+
+bool dumpBinaryDateTime(std::string_view text, BinaryTime &out) {
+    uint32_t year, month, day, hour = 0, minute = 0, second = 0, microsecond = 0;
+    if (!parseDigits(text, 0, 4, year) || text.length() < 10 || text[4] != '-' || !parseDigits(text, 5, 2, month) ||
+        text[7] != '-' || !parseDigits(text, 8, 2, day)) {
+        return false;
+    }
+    if (text.length() > 10) {
+        if (text.length() < 19 || text[10] != ' ' || !parseDigits(text, 11, 2, hour) || text[13] != ':' ||
+            !parseDigits(text, 14, 2, minute) || text[16] != ':' || !parseDigits(text, 17, 2, second) ||
+            !parseMicrosecond(text, 19, microsecond)) {
+            return false;
+        }
+    }
+
+    auto p = putUint16(out._data, year);
+    *p++ = month;
+    *p++ = day;
+    if (microsecond != 0) {
+        *p++ = hour;
+        *p++ = minute;
+        *p++ = second;
+        putUint32(p, microsecond);
+        out._length = 11;
+    } else if (hour != 0 || minute != 0 || second != 0) {
+        *p++ = hour;
+        *p++ = minute;
+        *p++ = second;
+        out._length = 7;
+    } else if (year != 0 || month != 0 || day != 0) {
+        out._length = 4;
+    } else {
+        out._length = 0;
+    }
+    return true;
+}
+
+bool dumpBinaryTime(std::string_view text, BinaryTime &out) {
+    bool negative = !text.empty() && text[0] == '-';
+    if (negative) {
+        text.remove_prefix(1);
+    }
+    auto colon = text.find(':');
+    if (colon == std::string_view::npos || colon == 0 || colon > 4) {
+        return false;
+    }
+    uint32_t hours, minute, second, microsecond;
+    if (!parseDigits(text, 0, colon, hours) || !parseDigits(text, colon + 1, 2, minute) ||
+        text.length() < colon + 6 || text[colon + 3] != ':' || !parseDigits(text, colon + 4, 2, second) ||
+        !parseMicrosecond(text, colon + 6, microsecond)) {
+        return false;
+    }
+    if (hours == 0 && minute == 0 && second == 0 && microsecond == 0) {
+        out._length = 0;
+        return true;
+    }
+
+    auto p = out._data;
+    *p++ = negative ? 1 : 0;
+    p = putUint32(p, hours / 24);
+    *p++ = hours % 24;
+    *p++ = minute;
+    *p++ = second;
+    out._length = 8;
+    if (microsecond != 0) {
+        putUint32(p, microsecond);
+        out._length = 12;
+    }
+    return true;
+}
+
+}  // namespace server
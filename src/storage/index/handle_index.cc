@@ -0,0 +1,136 @@
+#include "storage/index/handle_index.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include "metrics/storage.hh"
+
+namespace storage::index {
+
+namespace {
+
+// hashSlots returns the number of slots of a hash table for rows entries.
+size_t hashSlots(size_t rows) {
+    auto slots = static_cast<size_t>(std::ceil(static_cast<double>(rows) / HandleIndex::maxHashLoadFactor));
+    return std::max(slots, HandleIndex::minHashSlots);
+}
+
+}  // namespace
+
+HandleIndex::HandleIndex(bool withHash, size_t estimatedRows) {
+    if (withHash) {
+        _hash = std::make_unique<cuckoohash_map<IntKey, RowLocation, IntKey::Hash, IntKey::Equal>>(
+            hashSlots(estimatedRows));
+        syncSlots();
+    }
+}
+
+HandleIndex::~HandleIndex() {
+    if (_hash) {
+        metrics::HandleIndexEntries.Add(-static_cast<int64_t>(_hash->size()));
+        metrics::HandleIndexSlots.Add(-static_cast<int64_t>(_slots.load(std::memory_order_relaxed)));
+    }
+}
+
+void HandleIndex::Reserve(size_t rows) {
+    if (!_hash) {
+        return;
+    }
+    _hash->reserve(hashSlots(rows));
+    syncSlots();
+}
+
+std::optional<RowLocation> HandleIndex::Get(int64_t handle) const {
+    if (!_hash) {
+        return _tree.Get(IntKey(handle));
+    }
+    RowLocation location;
+    if (_hash->find(IntKey(handle), location)) {
+        return location;
+    }
+    return std::nullopt;
+}
+
+void HandleIndex::BatchGet(std::span<const int64_t> handles, std::vector<std::optional<RowLocation>> &out) const {
+    out.assign(handles.size(), std::nullopt);
+    for (size_t i = 0; i < handles.size(); i++) {
+        out[i] = Get(handles[i]);
+    }
+}
+
+bool HandleIndex::Insert(int64_t handle, RowLocation location) {
+    // The tree decides whether the handle exists, the hash table follows it.
+    if (!_tree.Insert(IntKey(handle), location)) {
+        return false;
+    }
+    if (_hash && _hash->insert(IntKey(handle), location)) {
+        metrics::HandleIndexEntries.Inc();
+        syncSlots();
+    }
+    return true;
+}
+
+void HandleIndex::Update(int64_t handle, RowLocation location) {
+    _tree.Upsert(IntKey(handle), location);
+    if (_hash) {
+        if (_hash->insert_or_assign(IntKey(handle), location)) {
+            metrics::HandleIndexEntries.Inc();
+            syncSlots();
+        }
+    }
+}
+
+bool HandleIndex::Delete(int64_t handle) {
+    // The point lookups stop seeing the row before the scans do, like they started seeing it after.
+    if (_hash && _hash->erase(IntKey(handle))) {
+        metrics::HandleIndexEntries.Dec();
+    }
+    return _tree.DeleteKey(IntKey(handle)) > 0;
+}
+
+size_t HandleIndex::BulkLoad(std::vector<std::pair<int64_t, RowLocation>> rows) {
+    if (Size() > 0) {
+        size_t n = 0;
+        for (const auto &[handle, location] : rows) {
+            n += Insert(handle, location) ? 1 : 0;
+        }
+        return n;
+    }
+
+    std::vector<std::pair<IntKey, RowLocation>> pairs;
+    pairs.reserve(rows.size());
+    for (const auto &[handle, location] : rows) {
+        pairs.emplace_back(IntKey(handle), location);
+    }
+    rows = {};
+    auto n = _tree.BulkLoad(std::move(pairs));
+    if (_hash) {
+        // The tree kept one location of every handle: hash those, in key order.
+        Reserve(n);
+        int64_t inserted = 0;
+        for (auto it = _tree.IterBatch(); it.Next();) {
+            for (size_t i = 0; i < it.Keys().size(); i++) {
+                inserted += _hash->insert(it.Keys()[i], it.Values()[i]) ? 1 : 0;
+            }
+        }
+        metrics::HandleIndexEntries.Add(inserted);
+        syncSlots();
+    }
+    return n;
+}
+
+BwTreeIndex<IntKey, RowLocation>::Iterator HandleIndex::Iter(std::optional<int64_t> lower,
+                                                             std::optional<int64_t> upper) {
+    return _tree.Iter(lower ? std::optional(IntKey(*lower)) : std::nullopt,
+                      upper ? std::optional(IntKey(*upper)) : std::nullopt);
+}
+
+void HandleIndex::syncSlots() {
+    auto slots = _hash->capacity();
+    auto old = _slots.exchange(slots, std::memory_order_relaxed);
+    if (slots != old) {
+        metrics::HandleIndexSlots.Add(static_cast<int64_t>(slots) - static_cast<int64_t>(old));
+    }
+}
+
+}  // namespace storage::index
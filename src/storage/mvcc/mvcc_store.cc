@@ -0,0 +1,323 @@
+#include "storage/mvcc/mvcc_store.hh"
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "errcode/errcode.hh"
+
+namespace storage::mvcc {
+
+namespace {
+
+constexpr size_t tsLen = 8;
+
+// seekKey returns the first key of the versions of the user keys not below key. The keys longer than MaxKeyLength
+// are never stored: the stored keys not below one of them are those after its prefix of MaxKeyLength bytes.
+versionKey seekKey(std::string_view key) {
+    std::string b;
+    if (key.size() <= MaxKeyLength) {
+        util::codec::EncodeBytes(b, key);
+    } else {
+        util::codec::EncodeBytes(b, key.substr(0, MaxKeyLength));
+        b.append(tsLen, '\xff');
+    }
+    return *versionKey::FromBytes(b);
+}
+
+// splitVersion returns the encoded user key of a version and its commit timestamp.
+std::pair<std::string_view, uint64_t> splitVersion(const versionKey &k) {
+    auto b = k.Bytes();
+    auto prefix = b.substr(0, b.size() - tsLen);
+    return {prefix, ~util::codec::readUint64(b.data() + prefix.size())};
+}
+
+std::string hexKey(std::string_view key) {
+    static constexpr char hex[] = "0123456789ABCDEF";
+    std::string s;
+    s.reserve(key.size() * 2);
+    for (auto c : key) {
+        s.push_back(hex[static_cast<uint8_t>(c) >> 4]);
+        s.push_back(hex[static_cast<uint8_t>(c) & 0xf]);
+    }
+    return s;
+}
+
+std::optional<mysql::SQLError> checkKey(std::string_view key) {
+    if (key.size() > MaxKeyLength) {
+        return mysql::NewErr(mysql::ErrTooLongKey, static_cast<int>(MaxKeyLength));
+    }
+    return std::nullopt;
+}
+
+}  // namespace
+
+SnapshotIter::SnapshotIter(tree::Iterator it, uint64_t ts) : _it(std::move(it)), _ts(ts) { settle(); }
+
+void SnapshotIter::Next() {
+    skipKey();
+    settle();
+}
+
+void SnapshotIter::settle() {
+    while (_it.Valid()) {
+        auto [prefix, ts] = splitVersion(_it.Key());
+        if (ts > _ts) {
+            // Committed after the snapshot: an older version of the key follows.
+            _it.Next();
+            continue;
+        }
+        _encoded.assign(prefix);
+        _value = _it.Value();
+        if (_value != nullptr) {
+            _key.clear();
+            util::codec::DecodeBytes(_encoded, _key);
+            _valid = true;
+            return;
+        }
+        skipKey();
+    }
+    _valid = false;
+}
+
+void SnapshotIter::skipKey() {
+    do {
+        _it.Next();
+    } while (_it.Valid() && splitVersion(_it.Key()).first == _encoded);
+}
+
+Txn::~Txn() { Rollback(); }
+
+std::optional<std::string> Txn::Get(std::string_view key) const {
+    if (auto it = _writes.find(key); it != _writes.end()) {
+        return it->second;
+    }
+    if (const auto *value = _store->get(key, _startTS)) {
+        return *value;
+    }
+    return std::nullopt;
+}
+
+std::optional<mysql::SQLError> Txn::Set(std::string_view key, std::string_view value) {
+    if (auto err = checkKey(key)) {
+        return err;
+    }
+    _writes.insert_or_assign(std::string(key), std::string(value));
+    return std::nullopt;
+}
+
+std::optional<mysql::SQLError> Txn::Delete(std::string_view key) {
+    if (auto err = checkKey(key)) {
+        return err;
+    }
+    _writes.insert_or_assign(std::string(key), std::nullopt);
+    return std::nullopt;
+}
+
+Txn::Iterator::Iterator(SnapshotIter snap, writes::const_iterator write, writes::const_iterator writeEnd)
+    : _snap(std::move(snap)), _write(write), _writeEnd(writeEnd) {
+    settle();
+}
+
+void Txn::Iterator::Next() {
+    if (_fromWrites) {
+        ++_write;
+    } else {
+        _snap.Next();
+    }
+    settle();
+}
+
+void Txn::Iterator::settle() {
+    while (true) {
+        bool hasWrite = _write != _writeEnd;
+        if (!hasWrite && !_snap.Valid()) {
+            _valid = false;
+            return;
+        }
+        if (hasWrite && (!_snap.Valid() || _write->first <= _snap.Key())) {
+            // The write shadows the snapshot's value of the key.
+            if (_snap.Valid() && _write->first == _snap.Key()) {
+                _snap.Next();
+            }
+            if (!_write->second) {
+                ++_write;
+                continue;
+            }
+            _fromWrites = true;
+        } else {
+            _fromWrites = false;
+        }
+        _valid = true;
+        return;
+    }
+}
+
+Txn::Iterator Txn::Iter(std::string_view lower, const std::optional<std::string> &upper) const {
+    return Iterator(_store->iter(_startTS, lower, upper), _writes.lower_bound(lower),
+                    upper ? _writes.lower_bound(*upper) : _writes.end());
+}
+
+std::optional<mysql::SQLError> Txn::Commit() {
+    if (_done) {
+        return std::nullopt;
+    }
+    std::optional<mysql::SQLError> err;
+    if (!_writes.empty()) {
+        err = _store->commit(*this);
+    }
+    Rollback();
+    return err;
+}
+
+void Txn::Rollback() {
+    if (_done) {
+        return;
+    }
+    _done = true;
+    _writes.clear();
+    _store->release(_startTS);
+}
+
+MVCCStore::MVCCStore(std::chrono::milliseconds gcInterval) : _gcInterval(gcInterval) {
+    if (_gcInterval.count() > 0) {
+        _gcThread = std::thread([this] { runGC(); });
+    }
+}
+
+MVCCStore::~MVCCStore() {
+    if (_gcThread.joinable()) {
+        {
+            std::lock_guard lock(_gcMu);
+            _stopped = true;
+        }
+        _gcCond.notify_all();
+        _gcThread.join();
+    }
+    for (auto it = _versions.Iter(); it.Valid(); it.Next()) {
+        delete it.Value();
+    }
+}
+
+std::unique_ptr<Txn> MVCCStore::Begin() {
+    // The timestamp is read under the lock, so that a garbage collection computing the safe point concurrently
+    // either sees the transaction or a safe point not after its start.
+    std::lock_guard lock(_snapshotsMu);
+    auto startTS = _commitTS.load(std::memory_order_acquire);
+    _snapshots.insert(startTS);
+    return std::unique_ptr<Txn>(new Txn(this, startTS));
+}
+
+uint64_t MVCCStore::SafePoint() {
+    std::lock_guard lock(_snapshotsMu);
+    return _snapshots.empty() ? _commitTS.load(std::memory_order_acquire) : *_snapshots.begin();
+}
+
+void MVCCStore::release(uint64_t startTS) {
+    std::lock_guard lock(_snapshotsMu);
+    _snapshots.erase(_snapshots.find(startTS));
+}
+
+const std::string *MVCCStore::get(std::string_view key, uint64_t ts) {
+    if (key.size() > MaxKeyLength) {
+        return nullptr;
+    }
+    std::string seek;
+    util::codec::EncodeBytes(seek, key);
+    auto n = seek.size();
+    util::codec::EncodeUintDesc(seek, ts);
+    // The first version at or after the key with the timestamp is the newest not after ts, if it is of the key.
+    auto it = _versions.Iter(versionKey::FromBytes(seek));
+    if (!it.Valid() || splitVersion(it.Key()).first != std::string_view(seek).substr(0, n)) {
+        return nullptr;
+    }
+    return it.Value();
+}
+
+SnapshotIter MVCCStore::iter(uint64_t ts, std::string_view lower, const std::optional<std::string> &upper) {
+    std::optional<versionKey> end;
+    if (upper) {
+        end = seekKey(*upper);
+    }
+    return SnapshotIter(_versions.Iter(seekKey(lower), end), ts);
+}
+
+std::optional<mysql::SQLError> MVCCStore::commit(const Txn &txn) {
+    std::lock_guard lock(_commitMu);
+    std::string seek;
+    for (const auto &[key, value] : txn._writes) {
+        seek.clear();
+        util::codec::EncodeBytes(seek, key);
+        auto n = seek.size();
+        util::codec::EncodeUintDesc(seek, std::numeric_limits<uint64_t>::max());
+        // The first version of the key is its newest.
+        auto it = _versions.Iter(versionKey::FromBytes(seek));
+        if (!it.Valid()) {
+            continue;
+        }
+        auto [prefix, commitTS] = splitVersion(it.Key());
+        if (prefix == std::string_view(seek).substr(0, n) && commitTS > txn._startTS) {
+            return mysql::NewErrf(errcode::ErrWriteConflict,
+                                  "Write conflict, txnStartTS=%lu, conflictCommitTS=%lu, key=%s", txn._startTS,
+                                  commitTS, hexKey(key).c_str());
+        }
+    }
+
+    // No snapshot reads at commitTS before it is published, so the versions appear at once.
+    auto commitTS = _commitTS.load(std::memory_order_relaxed) + 1;
+    for (const auto &[key, value] : txn._writes) {
+        std::string b;
+        util::codec::EncodeBytes(b, key);
+        util::codec::EncodeUintDesc(b, commitTS);
+        _versions.Insert(*versionKey::FromBytes(b), value ? new std::string(*value) : nullptr);
+    }
+    _commitTS.store(commitTS, std::memory_order_release);
+    return std::nullopt;
+}
+
+size_t MVCCStore::GC() {
+    std::lock_guard lock(_gcMu);
+    return collect();
+}
+
+void MVCCStore::runGC() {
+    std::unique_lock lock(_gcMu);
+    while (!_gcCond.wait_for(lock, _gcInterval, [this] { return _stopped; })) {
+        collect();
+    }
+}
+
+size_t MVCCStore::collect() {
+    auto safePoint = SafePoint();
+    // The versions of a key before the first one not after the safe point are read by the active snapshots; that
+    // one is read by the snapshot at the safe point unless it is a deletion, and the older ones by none.
+    std::vector<std::pair<versionKey, const std::string *>> garbage;
+    std::string current;
+    bool covered = false;
+    for (auto it = _versions.Iter(); it.Valid(); it.Next()) {
+        auto [prefix, ts] = splitVersion(it.Key());
+        if (prefix != current) {
+            current.assign(prefix);
+            covered = false;
+        }
+        if (covered) {
+            garbage.emplace_back(it.Key(), it.Value());
+        } else if (ts <= safePoint) {
+            covered = true;
+            if (it.Value() == nullptr) {
+                garbage.emplace_back(it.Key(), it.Value());
+            }
+        }
+    }
+    // Delete the oldest versions first: until its deletion is removed, a key never shows an older value.
+    size_t n = 0;
+    for (auto g = garbage.rbegin(); g != garbage.rend(); ++g) {
+        if (_versions.Delete(g->first, g->second)) {
+            delete g->second;
+            n++;
+        }
+    }
+    return n;
+}
+
+}  // namespace storage::mvcc
@@ -0,0 +1,130 @@
+#include "tablecodec/tablecodec.hh"
+
+#include <cstring>
+
+#include "util/codec/codec.hh"
+
+namespace tablecodec {
+
+namespace {
+
+void appendPrefix(std::string &b, int64_t tableID, std::string_view sep) {
+    b.push_back(tablePrefix);
+    util::codec::EncodeInt(b, tableID);
+    b += sep;
+}
+
+bool hasPrefix(std::string_view key, std::string_view sep) {
+    return key.size() >= prefixLen && key[0] == tablePrefix && key.substr(1 + idLen, sep.size()) == sep;
+}
+
+}  // namespace
+
+std::string EncodeTablePrefix(int64_t tableID) {
+    std::string b;
+    b.push_back(tablePrefix);
+    util::codec::EncodeInt(b, tableID);
+    return b;
+}
+
+std::string GenTableRecordPrefix(int64_t tableID) {
+    std::string b;
+    appendPrefix(b, tableID, recordPrefixSep);
+    return b;
+}
+
+std::string GenTableIndexPrefix(int64_t tableID) {
+    std::string b;
+    appendPrefix(b, tableID, indexPrefixSep);
+    return b;
+}
+
+std::string EncodeRowKeyWithHandle(int64_t tableID, int64_t handle) {
+    std::string b;
+    b.reserve(RecordRowKeyLen);
+    appendPrefix(b, tableID, recordPrefixSep);
+    util::codec::EncodeInt(b, handle);
+    return b;
+}
+
+void EncodeRowKeys(std::string &out, int64_t tableID, std::span<const int64_t> handles) {
+    auto prefix = GenTableRecordPrefix(tableID);
+    auto off = out.size();
+    out.resize(off + handles.size() * RecordRowKeyLen);
+    auto *p = out.data() + off;
+    for (auto h : handles) {
+        std::memcpy(p, prefix.data(), prefixLen);
+        auto v = util::codec::toBigEndian(util::codec::EncodeIntToCmpUint(h));
+        std::memcpy(p + prefixLen, &v, idLen);
+        p += RecordRowKeyLen;
+    }
+}
+
+std::tuple<int64_t, int64_t, bool> DecodeRecordKey(std::string_view key) {
+    if (key.size() != RecordRowKeyLen || !hasPrefix(key, recordPrefixSep)) {
+        return {0, 0, false};
+    }
+    auto tableID = std::get<0>(util::codec::DecodeInt(key.substr(1)));
+    auto handle = std::get<0>(util::codec::DecodeInt(key.substr(prefixLen)));
+    return {tableID, handle, true};
+}
+
+std::string EncodeIndexSeekKey(int64_t tableID, int64_t indexID, std::string_view encodedValue) {
+    std::string b;
+    b.reserve(prefixLen + idLen + encodedValue.size());
+    appendPrefix(b, tableID, indexPrefixSep);
+    util::codec::EncodeInt(b, indexID);
+    b += encodedValue;
+    return b;
+}
+
+void ResetIndexKeys(std::vector<std::string> &keys, size_t n, int64_t tableID, int64_t indexID) {
+    auto prefix = EncodeIndexSeekKey(tableID, indexID, {});
+    keys.resize(n);
+    for (auto &k : keys) {
+        k.assign(prefix);
+    }
+}
+
+std::tuple<int64_t, int64_t, bool, bool> DecodeKeyHead(std::string_view key) {
+    if (hasPrefix(key, recordPrefixSep)) {
+        return {DecodeTableID(key), 0, true, true};
+    }
+    if (hasPrefix(key, indexPrefixSep) && key.size() >= prefixLen + idLen) {
+        auto indexID = std::get<0>(util::codec::DecodeInt(key.substr(prefixLen)));
+        return {DecodeTableID(key), indexID, false, true};
+    }
+    return {0, 0, false, false};
+}
+
+int64_t DecodeTableID(std::string_view key) {
+    if (key.size() < 1 + idLen || key[0] != tablePrefix) {
+        return 0;
+    }
+    return std::get<0>(util::codec::DecodeInt(key.substr(1)));
+}
+
+std::tuple<std::vector<std::string_view>, std::string_view, bool> CutIndexKey(std::string_view key,
+                                                                               size_t numColumns) {
+    if (!IsIndexKey(key)) {
+        return {{}, {}, false};
+    }
+    key.remove_prefix(prefixLen + idLen);
+    std::vector<std::string_view> values;
+    values.reserve(numColumns);
+    for (size_t i = 0; i < numColumns; i++) {
+        auto n = util::codec::PeekKeyValue(key);
+        if (n == 0) {
+            return {{}, {}, false};
+        }
+        values.push_back(key.substr(0, n));
+        key.remove_prefix(n);
+    }
+    return {std::move(values), key, true};
+}
+
+bool IsRecordKey(std::string_view key) { return hasPrefix(key, recordPrefixSep); }
+
+bool IsIndexKey(std::string_view key) { return hasPrefix(key, indexPrefixSep) && key.size() >= prefixLen + idLen; }
+
+}  // namespace tablecodec
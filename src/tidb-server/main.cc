@@ -1,6 +1,31 @@
+#include <pthread.h>
+
+#include <csignal>
 #include <iostream>
 
+#include "server/server.hh"
+
 int main() {
-    std::cout << "hello world" << std::endl;
+    // Block the termination signals before the server starts its threads, so that only sigwait receives them.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    server::Config cfg;
+    server::Server svr(cfg);
+    if (!svr.Start()) {
+        std::cerr << "failed to listen on " << cfg.Host << ":" << cfg.Port << std::endl;
+        return 1;
+    }
+    std::cout << "server is running MySQL protocol at " << cfg.Host << ":" << svr.Port() << std::endl;
+    if (cfg.ReportStatus) {
+        std::cout << "status server is running at " << cfg.StatusHost << ":" << svr.StatusPort() << std::endl;
+    }
+
+    int sig;
+    sigwait(&signals, &sig);
+    svr.Close();
     return 0;
 }
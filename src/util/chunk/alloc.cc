@@ -0,0 +1,55 @@
+#include "util/chunk/alloc.hh"
+
+namespace util::chunk {
+
+Chunk Allocator::Alloc(std::span<const uint8_t> types, size_t capacity) {
+    std::vector<Column> columns;
+    columns.reserve(types.size());
+    for (auto tp : types) {
+        columns.push_back(AllocColumn(Column::ElemSize(tp), capacity));
+    }
+    return Chunk(std::move(columns), capacity);
+}
+
+void Allocator::Free(Chunk &&chk) {
+    for (auto &col : chk.ReleaseColumns()) {
+        FreeColumn(std::move(col));
+    }
+}
+
+Column Allocator::AllocColumn(size_t elemSize, size_t capacity) {
+    auto &p = poolOf(elemSize);
+    if (p.columns.empty()) {
+        return Column(elemSize, capacity);
+    }
+    auto col = std::move(p.columns.back());
+    p.columns.pop_back();
+    return col;
+}
+
+void Allocator::FreeColumn(Column &&col) {
+    auto &p = poolOf(col.ElemSize());
+    if (p.columns.size() < _maxFreeColumns) {
+        col.Reset();
+        p.columns.push_back(std::move(col));
+    }
+}
+
+size_t Allocator::NumFree() const {
+    size_t n = 0;
+    for (const auto &p : _pools) {
+        n += p.columns.size();
+    }
+    return n;
+}
+
+Allocator::pool &Allocator::poolOf(size_t elemSize) {
+    for (auto &p : _pools) {
+        if (p.elemSize == elemSize) {
+            return p;
+        }
+    }
+    return _pools.emplace_back(pool{elemSize, {}});
+}
+
+}  // namespace util::chunk
@@ -0,0 +1,633 @@
+#include "util/chunk/arrow_ipc.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <string_view>
+
+#include "flatbuffers/generated/File_generated.h"
+#include "flatbuffers/generated/Message_generated.h"
+#include "parser/mysql/type.hh"
+
+namespace util::chunk {
+
+namespace fb = org::apache::arrow::flatbuf;
+
+namespace {
+
+// continuationMarker starts the prefix of every message, followed by the length of its metadata.
+constexpr uint32_t continuationMarker = 0xffffffff;
+constexpr size_t messagePrefixSize = 8;
+
+// fileMagic starts the file format, padded to 8 bytes, and ends it.
+constexpr std::string_view fileMagic{"ARROW1"};
+constexpr char fileMagicPadded[8] = "ARROW1";
+
+// The keys of the custom metadata of the fields.
+constexpr const char *typeKey = "mysql.type";
+constexpr const char *flagKey = "mysql.flag";
+
+alignas(bufferAlignment) constexpr uint8_t zeros[bufferAlignment]{};
+
+size_t padded(size_t n) { return (n + bufferAlignment - 1) / bufferAlignment * bufferAlignment; }
+
+mysql::SQLError ioError(uint16_t code, const std::string &name) {
+    auto err = errno;
+    return mysql::NewErr(code, name.c_str(), err, std::strerror(err));
+}
+
+std::string_view view(const flatbuffers::String *s) { return {s->c_str(), s->size()}; }
+
+mysql::SQLError unsupported(const std::string &what) { return mysql::NewErr(mysql::ErrNotSupportedYet, what.c_str()); }
+
+// arrowType returns the Arrow type of the columns of the mysql type tp with flag.
+fb::Type arrowType(uint8_t tp, uint16_t flag) {
+    switch (Column::ElemSize(tp)) {
+        case Column::varElemSize:
+            return (flag & mysql::BinaryFlag) != 0 ? fb::Type_LargeBinary : fb::Type_LargeUtf8;
+        case sizeof(float):
+            return fb::Type_FloatingPoint;
+        default:
+            return tp == mysql::TypeDouble ? fb::Type_FloatingPoint : fb::Type_Int;
+    }
+}
+
+flatbuffers::Offset<fb::Schema> buildSchema(flatbuffers::FlatBufferBuilder &fbb, const std::vector<Field> &fields) {
+    std::vector<flatbuffers::Offset<fb::Field>> offsets;
+    offsets.reserve(fields.size());
+    for (const auto &field : fields) {
+        auto name = fbb.CreateString(field.Name);
+        auto tp = arrowType(field.Type, field.Flag);
+        flatbuffers::Offset<void> type;
+        switch (tp) {
+            case fb::Type_Int:
+                type = fb::CreateInt(fbb, 64, !mysql::HasUnsignedFlag(field.Flag)).Union();
+                break;
+            case fb::Type_FloatingPoint:
+                type = fb::CreateFloatingPoint(fbb, field.Type == mysql::TypeFloat ? fb::Precision_SINGLE
+                                                                                   : fb::Precision_DOUBLE)
+                           .Union();
+                break;
+            case fb::Type_LargeBinary:
+                type = fb::CreateLargeBinary(fbb).Union();
+                break;
+            default:
+                type = fb::CreateLargeUtf8(fbb).Union();
+                break;
+        }
+        auto children = fbb.CreateVector(std::vector<flatbuffers::Offset<fb::Field>>{});
+        auto metadata = fbb.CreateVector(std::vector<flatbuffers::Offset<fb::KeyValue>>{
+            fb::CreateKeyValueDirect(fbb, typeKey, std::to_string(field.Type).c_str()),
+            fb::CreateKeyValueDirect(fbb, flagKey, std::to_string(field.Flag).c_str()),
+        });
+        offsets.push_back(fb::CreateField(fbb, name, !mysql::HasNotNullFlag(field.Flag), tp, type, 0, children,
+                                          metadata));
+    }
+    return fb::CreateSchema(fbb, fb::Endianness_Little, fbb.CreateVector(offsets));
+}
+
+}  // namespace
+
+std::tuple<std::unique_ptr<ArrowWriter>, std::optional<mysql::SQLError>> ArrowWriter::Create(
+    const std::string &path, std::vector<Field> fields, ArrowFormat format) {
+    auto fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return {nullptr, ioError(mysql::ErrCantCreateFile, path)};
+    }
+    auto writer = std::make_unique<ArrowWriter>(fd, path, std::move(fields), format);
+    writer->_ownsFd = true;
+    return {std::move(writer), std::nullopt};
+}
+
+ArrowWriter::ArrowWriter(int fd, std::string name, std::vector<Field> fields, ArrowFormat format)
+    : _fd(fd),
+      _name(std::move(name)),
+      _fields(std::move(fields)),
+      _format(format),
+      _fbb(std::make_unique<flatbuffers::FlatBufferBuilder>()) {}
+
+ArrowWriter::~ArrowWriter() {
+    if (_ownsFd) {
+        ::close(_fd);
+    }
+}
+
+std::optional<mysql::SQLError> ArrowWriter::Write(const Chunk &chk) {
+    if (!_started) {
+        if (auto err = writeStart()) {
+            return err;
+        }
+    }
+    if (!chk.HasSel()) {
+        return writeBatch(chk);
+    }
+    if (!_compacted) {
+        std::vector<Column> columns;
+        for (size_t i = 0; i < chk.NumCols(); i++) {
+            columns.emplace_back(chk.Col(i).ElemSize());
+        }
+        _compacted = std::make_unique<Chunk>(std::move(columns), chk.Capacity());
+    }
+    _compacted->Reset();
+    _compacted->Append(chk, 0, chk.NumRows());
+    return writeBatch(*_compacted);
+}
+
+std::optional<mysql::SQLError> ArrowWriter::Finish() {
+    if (!_started) {
+        if (auto err = writeStart()) {
+            return err;
+        }
+    }
+    uint32_t eos[2] = {continuationMarker, 0};
+    _iov.assign({{eos, sizeof(eos)}});
+    if (_format == ArrowFormat::Stream) {
+        return writeAll(_iov);
+    }
+
+    _fbb->Clear();
+    std::vector<fb::Block> blocks;
+    blocks.reserve(_blocks.size());
+    for (const auto &b : _blocks) {
+        blocks.emplace_back(b.offset, b.metadataLength, b.bodyLength);
+    }
+    auto schema = buildSchema(*_fbb, _fields);
+    auto recordBatches = _fbb->CreateVectorOfStructs(blocks.data(), blocks.size());
+    _fbb->Finish(fb::CreateFooter(*_fbb, fb::MetadataVersion_V4, schema, 0, recordBatches));
+    auto footerLength = static_cast<int32_t>(_fbb->GetSize());
+    _iov.push_back({_fbb->GetBufferPointer(), _fbb->GetSize()});
+    _iov.push_back({&footerLength, sizeof(footerLength)});
+    _iov.push_back({const_cast<char *>(fileMagic.data()), fileMagic.size()});
+    return writeAll(_iov);
+}
+
+std::optional<mysql::SQLError> ArrowWriter::writeStart() {
+    _started = true;
+    if (_format == ArrowFormat::File) {
+        _iov.assign({{const_cast<char *>(fileMagicPadded), sizeof(fileMagicPadded)}});
+        if (auto err = writeAll(_iov)) {
+            return err;
+        }
+    }
+    _fbb->Clear();
+    auto schema = buildSchema(*_fbb, _fields);
+    _fbb->Finish(fb::CreateMessage(*_fbb, fb::MetadataVersion_V4, fb::MessageHeader_Schema, schema.Union()));
+    return writeMessage({}, 0, nullptr);
+}
+
+std::optional<mysql::SQLError> ArrowWriter::writeBatch(const Chunk &chk) {
+    std::vector<fb::FieldNode> nodes;
+    std::vector<fb::Buffer> buffers;
+    nodes.reserve(chk.NumCols());
+    buffers.reserve(chk.NumCols() * 3);
+    _body.clear();
+    size_t bodyLength = 0;
+    auto addBuffer = [&](const void *p, size_t n) {
+        buffers.emplace_back(static_cast<int64_t>(bodyLength), static_cast<int64_t>(n));
+        if (n == 0) {
+            return;
+        }
+        _body.push_back({const_cast<void *>(p), n});
+        if (padded(n) > n) {
+            _body.push_back({const_cast<uint8_t *>(zeros), padded(n) - n});
+        }
+        bodyLength += padded(n);
+    };
+
+    for (size_t i = 0; i < chk.NumCols(); i++) {
+        const auto &col = chk.Col(i);
+        auto n = col.Length();
+        nodes.emplace_back(static_cast<int64_t>(n), static_cast<int64_t>(col.NullCount()));
+        // The validity bitmap may be left out when there are no nulls.
+        addBuffer(col.NullBitmap(), col.NullCount() > 0 ? (n + 7) / 8 : 0);
+        if (col.IsFixed()) {
+            addBuffer(col.Data(), n * col.ElemSize());
+        } else {
+            addBuffer(col.Offsets(), (n + 1) * sizeof(int64_t));
+            addBuffer(col.Data(), col.DataSize());
+        }
+    }
+
+    _fbb->Clear();
+    auto batch = fb::CreateRecordBatch(*_fbb, static_cast<int64_t>(chk.NumRowsUnfiltered()),
+                                       _fbb->CreateVectorOfStructs(nodes.data(), nodes.size()),
+                                       _fbb->CreateVectorOfStructs(buffers.data(), buffers.size()));
+    _fbb->Finish(fb::CreateMessage(*_fbb, fb::MetadataVersion_V4, fb::MessageHeader_RecordBatch, batch.Union(),
+                                   static_cast<int64_t>(bodyLength)));
+    block b;
+    if (auto err = writeMessage(_body, bodyLength, &b)) {
+        return err;
+    }
+    _blocks.push_back(b);
+    return std::nullopt;
+}
+
+std::optional<mysql::SQLError> ArrowWriter::writeMessage(std::span<const iovec> body, size_t bodyLength, block *b) {
+    // The metadata is padded for the body to start on a bufferAlignment boundary of the file.
+    auto size = _fbb->GetSize();
+    auto metadataLength = padded(_written + messagePrefixSize + size) - _written - messagePrefixSize;
+    uint32_t prefix[2] = {continuationMarker, static_cast<uint32_t>(metadataLength)};
+    _iov.clear();
+    _iov.push_back({prefix, sizeof(prefix)});
+    _iov.push_back({_fbb->GetBufferPointer(), size});
+    if (metadataLength > size) {
+        _iov.push_back({const_cast<uint8_t *>(zeros), metadataLength - size});
+    }
+    _iov.insert(_iov.end(), body.begin(), body.end());
+    if (b != nullptr) {
+        *b = {static_cast<int64_t>(_written), static_cast<int32_t>(messagePrefixSize + metadataLength),
+              static_cast<int64_t>(bodyLength)};
+    }
+    return writeAll(_iov);
+}
+
+std::optional<mysql::SQLError> ArrowWriter::writeAll(std::span<const iovec> iov) {
+    std::vector<iovec> rest;
+    while (!iov.empty()) {
+        auto n = ::writev(_fd, iov.data(), static_cast<int>(std::min<size_t>(iov.size(), IOV_MAX)));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return ioError(mysql::ErrErrorOnWrite, _name);
+        }
+        _written += n;
+        // Skip what was written, resuming a partly written vector from a copy.
+        auto left = static_cast<size_t>(n);
+        while (!iov.empty() && left >= iov.front().iov_len) {
+            left -= iov.front().iov_len;
+            iov = iov.subspan(1);
+        }
+        if (left > 0) {
+            rest.assign(iov.begin(), iov.end());
+            rest[0].iov_base = static_cast<uint8_t *>(rest[0].iov_base) + left;
+            rest[0].iov_len -= left;
+            iov = rest;
+        }
+    }
+    return std::nullopt;
+}
+
+std::tuple<std::unique_ptr<ArrowReader>, std::optional<mysql::SQLError>> ArrowReader::Open(const std::string &path) {
+    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return {nullptr, ioError(mysql::ErrCantOpenFile, path)};
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        auto err = ioError(mysql::ErrCantOpenFile, path);
+        ::close(fd);
+        return {nullptr, err};
+    }
+    void *p = nullptr;
+    if (st.st_size > 0) {
+        p = ::mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            auto err = ioError(mysql::ErrErrorOnRead, path);
+            ::close(fd);
+            return {nullptr, err};
+        }
+    }
+    ::close(fd);
+
+    std::unique_ptr<ArrowReader> reader(new ArrowReader({static_cast<uint8_t *>(p), static_cast<size_t>(st.st_size)},
+                                                        path));
+    reader->_mapped = p != nullptr;
+    if (auto err = reader->init()) {
+        return {nullptr, err};
+    }
+    return {std::move(reader), std::nullopt};
+}
+
+std::tuple<std::unique_ptr<ArrowReader>, std::optional<mysql::SQLError>> ArrowReader::Open(std::span<uint8_t> data,
+                                                                                           std::string name) {
+    std::unique_ptr<ArrowReader> reader(new ArrowReader(data, std::move(name)));
+    if (auto err = reader->init()) {
+        return {nullptr, err};
+    }
+    return {std::move(reader), std::nullopt};
+}
+
+ArrowReader::~ArrowReader() {
+    if (_mapped) {
+        ::munmap(_data.data(), _data.size());
+    }
+}
+
+std::optional<mysql::SQLError> ArrowReader::init() {
+    auto isFile = _data.size() >= sizeof(fileMagicPadded) + fileMagic.size() &&
+                  std::memcmp(_data.data(), fileMagic.data(), fileMagic.size()) == 0;
+    message msg;
+    size_t next = 0;
+    if (!isFile) {
+        // The stream starts with the schema, and ends with an end-of-stream marker or with the data.
+        if (auto err = readMessage(0, msg, next)) {
+            return err;
+        }
+        auto *schema = msg.metadata != nullptr ? static_cast<const fb::Message *>(msg.metadata)->header_as_Schema()
+                                               : nullptr;
+        if (schema == nullptr) {
+            return corrupted();
+        }
+        if (auto err = readSchema(schema)) {
+            return err;
+        }
+        while (true) {
+            if (auto err = readMessage(next, msg, next)) {
+                return err;
+            }
+            if (msg.metadata == nullptr) {
+                return std::nullopt;
+            }
+            auto header = static_cast<const fb::Message *>(msg.metadata)->header_type();
+            if (header == fb::MessageHeader_DictionaryBatch) {
+                return unsupported("Arrow dictionary batches");
+            }
+            if (header != fb::MessageHeader_RecordBatch) {
+                return corrupted();
+            }
+            _batches.push_back(msg);
+        }
+    }
+
+    // The file ends with the footer, its length and the magic.
+    auto end = _data.size() - fileMagic.size();
+    int32_t footerLength;
+    std::memcpy(&footerLength, _data.data() + end - sizeof(footerLength), sizeof(footerLength));
+    if (std::memcmp(_data.data() + end, fileMagic.data(), fileMagic.size()) != 0 || footerLength <= 0 ||
+        static_cast<size_t>(footerLength) > end - sizeof(footerLength) - sizeof(fileMagicPadded)) {
+        return corrupted();
+    }
+    const auto *footerData = _data.data() + end - sizeof(footerLength) - footerLength;
+    flatbuffers::Verifier verifier(footerData, footerLength);
+    if (!fb::VerifyFooterBuffer(verifier)) {
+        return corrupted();
+    }
+    const auto *footer = fb::GetFooter(footerData);
+    if (footer->schema() == nullptr) {
+        return corrupted();
+    }
+    if (auto err = readSchema(footer->schema())) {
+        return err;
+    }
+    if (footer->dictionaries() != nullptr && footer->dictionaries()->size() > 0) {
+        return unsupported("Arrow dictionary batches");
+    }
+    if (footer->recordBatches() == nullptr) {
+        return std::nullopt;
+    }
+    for (const auto *b : *footer->recordBatches()) {
+        if (b->offset() < 0) {
+            return corrupted();
+        }
+        if (auto err = readMessage(b->offset(), msg, next)) {
+            return err;
+        }
+        if (msg.metadata == nullptr ||
+            static_cast<const fb::Message *>(msg.metadata)->header_type() != fb::MessageHeader_RecordBatch) {
+            return corrupted();
+        }
+        _batches.push_back(msg);
+    }
+    return std::nullopt;
+}
+
+std::optional<mysql::SQLError> ArrowReader::readMessage(size_t offset, message &msg, size_t &next) const {
+    msg = {};
+    next = offset;
+    if (offset >= _data.size()) {
+        return offset == _data.size() ? std::nullopt : std::optional(corrupted());
+    }
+    if (_data.size() - offset < sizeof(uint32_t)) {
+        return corrupted();
+    }
+    // Before Arrow 0.15 the prefix was the length alone.
+    uint32_t length;
+    std::memcpy(&length, _data.data() + offset, sizeof(length));
+    offset += sizeof(length);
+    if (length == continuationMarker) {
+        if (_data.size() - offset < sizeof(length)) {
+            return corrupted();
+        }
+        std::memcpy(&length, _data.data() + offset, sizeof(length));
+        offset += sizeof(length);
+    }
+    if (length == 0) {
+        next = offset;
+        return std::nullopt;
+    }
+    if (length > _data.size() - offset) {
+        return corrupted();
+    }
+    const auto *metadata = _data.data() + offset;
+    flatbuffers::Verifier verifier(metadata, length);
+    if (!fb::VerifyMessageBuffer(verifier)) {
+        return corrupted();
+    }
+    const auto *m = fb::GetMessage(metadata);
+    offset += length;
+    if (m->bodyLength() < 0 || static_cast<size_t>(m->bodyLength()) > _data.size() - offset) {
+        return corrupted();
+    }
+    msg = {m, _data.subspan(offset, m->bodyLength())};
+    next = offset + m->bodyLength();
+    return std::nullopt;
+}
+
+std::optional<mysql::SQLError> ArrowReader::readSchema(const void *p) {
+    const auto *schema = static_cast<const fb::Schema *>(p);
+    if (schema->endianness() != fb::Endianness_Little) {
+        return unsupported("big-endian Arrow data");
+    }
+    if (schema->fields() == nullptr) {
+        return std::nullopt;
+    }
+    for (const auto *f : *schema->fields()) {
+        Field field;
+        if (f->name() != nullptr) {
+            field.Name = f->name()->str();
+        }
+        if (f->dictionary() != nullptr) {
+            return unsupported("Arrow dictionary-encoded fields");
+        }
+        const auto *intType = f->type_as_Int();
+        const auto *floatType = f->type_as_FloatingPoint();
+        switch (f->type_type()) {
+            case fb::Type_Int:
+                if (intType->bitWidth() != 64) {
+                    return unsupported("Arrow Int(" + std::to_string(intType->bitWidth()) + ")");
+                }
+                field.Type = mysql::TypeLonglong;
+                field.Flag = intType->is_signed() ? 0 : mysql::UnsignedFlag;
+                break;
+            case fb::Type_FloatingPoint:
+                if (floatType->precision() == fb::Precision_HALF) {
+                    return unsupported("Arrow FloatingPoint(HALF)");
+                }
+                field.Type = floatType->precision() == fb::Precision_SINGLE ? mysql::TypeFloat : mysql::TypeDouble;
+                break;
+            case fb::Type_LargeUtf8:
+                field.Type = mysql::TypeVarString;
+                break;
+            case fb::Type_LargeBinary:
+                field.Type = mysql::TypeBlob;
+                field.Flag = mysql::BinaryFlag;
+                break;
+            default:
+                return unsupported(std::string("Arrow type ") + fb::EnumNameType(f->type_type()));
+        }
+        if (!f->nullable()) {
+            field.Flag |= mysql::NotNullFlag;
+        }
+
+        // The type and the flag written by ArrowWriter are kept if the Arrow type is theirs.
+        std::optional<uint8_t> tp;
+        std::optional<uint16_t> flag;
+        if (f->custom_metadata() != nullptr) {
+            for (const auto *kv : *f->custom_metadata()) {
+                if (kv->key() == nullptr || kv->value() == nullptr) {
+                    continue;
+                }
+                auto value = view(kv->value());
+                if (view(kv->key()) == typeKey) {
+                    uint8_t v;
+                    if (std::from_chars(value.begin(), value.end(), v).ec == std::errc()) {
+                        tp = v;
+                    }
+                } else if (view(kv->key()) == flagKey) {
+                    uint16_t v;
+                    if (std::from_chars(value.begin(), value.end(), v).ec == std::errc()) {
+                        flag = v;
+                    }
+                }
+            }
+        }
+        if (tp && flag && arrowType(*tp, *flag) == f->type_type() &&
+            Column::ElemSize(*tp) == Column::ElemSize(field.Type) &&
+            mysql::HasUnsignedFlag(*flag) == mysql::HasUnsignedFlag(field.Flag)) {
+            field.Type = *tp;
+            field.Flag = *flag;
+        }
+        _elemSizes.push_back(Column::ElemSize(field.Type));
+        _fields.push_back(std::move(field));
+    }
+    return std::nullopt;
+}
+
+std::optional<mysql::SQLError> ArrowReader::ReadBatch(size_t i, Chunk &chk) const {
+    const auto &msg = _batches[i];
+    const auto *batch = static_cast<const fb::Message *>(msg.metadata)->header_as_RecordBatch();
+    const auto *nodes = batch->nodes();
+    const auto *buffers = batch->buffers();
+    if (batch->length() < 0 || nodes == nullptr || buffers == nullptr || nodes->size() != _fields.size()) {
+        return corrupted();
+    }
+    auto n = static_cast<size_t>(batch->length());
+    // Every column holds at least a byte per row, which bounds the bitmaps allocated for the columns without nulls.
+    if (!_fields.empty() && n > msg.body.size()) {
+        return corrupted();
+    }
+
+    // buffer returns the next buffer of the body, nullopt if it is out of bounds or misaligned.
+    size_t next = 0;
+    auto buffer = [&]() -> std::optional<std::span<uint8_t>> {
+        if (next >= buffers->size()) {
+            return std::nullopt;
+        }
+        const auto *b = buffers->Get(next++);
+        if (b->offset() < 0 || b->length() < 0 || static_cast<size_t>(b->offset()) > msg.body.size() ||
+            static_cast<size_t>(b->length()) > msg.body.size() - b->offset()) {
+            return std::nullopt;
+        }
+        auto span = msg.body.subspan(b->offset(), b->length());
+        if (reinterpret_cast<uintptr_t>(span.data()) % sizeof(int64_t) != 0) {
+            return std::nullopt;
+        }
+        return span;
+    };
+
+    std::vector<Column> columns;
+    columns.reserve(_fields.size());
+    for (size_t c = 0; c < _fields.size(); c++) {
+        const auto *node = nodes->Get(c);
+        if (static_cast<size_t>(node->length()) != n || node->null_count() < 0 ||
+            static_cast<size_t>(node->null_count()) > n) {
+            return corrupted();
+        }
+        auto nullCount = static_cast<size_t>(node->null_count());
+        auto validity = buffer();
+        if (!validity || (nullCount > 0 && validity->size() < (n + 7) / 8)) {
+            return corrupted();
+        }
+        Buffer nullBitmap;
+        if (nullCount > 0) {
+            nullBitmap = Buffer::View(validity->data(), (n + 7) / 8);
+        } else if (n > 0) {
+            // The bitmap may be left out, or hold anything, when there are no nulls.
+            nullBitmap.Resize((n + 7) / 8);
+            std::memset(nullBitmap.Data(), 0xff, nullBitmap.Size());
+        }
+
+        auto elemSize = _elemSizes[c];
+        if (elemSize != Column::varElemSize) {
+            auto data = buffer();
+            if (!data || data->size() / elemSize < n) {
+                return corrupted();
+            }
+            columns.emplace_back(elemSize, n, nullCount, std::move(nullBitmap), Buffer(),
+                                 Buffer::View(data->data(), n * elemSize));
+            continue;
+        }
+        auto offsets = buffer();
+        auto data = buffer();
+        if (!offsets || !data) {
+            return corrupted();
+        }
+        // The offsets of an empty column may be left out.
+        if (n == 0 && offsets->size() < sizeof(int64_t)) {
+            Buffer zero;
+            zero.Resize(sizeof(int64_t));
+            std::memset(zero.Data(), 0, zero.Size());
+            columns.emplace_back(elemSize, 0, 0, std::move(nullBitmap), std::move(zero), Buffer());
+            continue;
+        }
+        if (offsets->size() / sizeof(int64_t) < n + 1) {
+            return corrupted();
+        }
+        // The offsets are checked once here rather than by every GetBytes.
+        const auto *o = reinterpret_cast<const int64_t *>(offsets->data());
+        bool ok = o[0] >= 0 && static_cast<size_t>(o[n]) <= data->size();
+        for (size_t r = 0; r < n; r++) {
+            ok &= o[r] <= o[r + 1];
+        }
+        if (!ok) {
+            return corrupted();
+        }
+        columns.emplace_back(elemSize, n, nullCount, std::move(nullBitmap),
+                             Buffer::View(offsets->data(), (n + 1) * sizeof(int64_t)),
+                             Buffer::View(data->data(), data->size()));
+    }
+    chk = Chunk(std::move(columns), n);
+    return std::nullopt;
+}
+
+void ArrowReader::WillNeed(size_t i) const {
+    if (!_mapped || i >= _batches.size()) {
+        return;
+    }
+    // The metadata is just before the body.
+    static const auto pageSize = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+    auto begin = reinterpret_cast<uintptr_t>(_batches[i].metadata) & ~(pageSize - 1);
+    auto end = reinterpret_cast<uintptr_t>(_batches[i].body.data() + _batches[i].body.size());
+    ::madvise(reinterpret_cast<void *>(begin), end - begin, MADV_WILLNEED);
+}
+
+mysql::SQLError ArrowReader::corrupted() const { return mysql::NewErr(mysql::ErrNotFormFile, _name.c_str()); }
+
+}  // namespace util::chunk
@@ -0,0 +1,42 @@
+#include "util/chunk/chunk.hh"
+
+namespace util::chunk {
+
+Chunk::Chunk(std::span<const uint8_t> types, size_t capacity) : _capacity(capacity) {
+    _columns.reserve(types.size());
+    for (auto tp : types) {
+        _columns.emplace_back(Column::ElemSize(tp), capacity);
+    }
+}
+
+void Chunk::AppendRow(const Chunk &other, size_t i) {
+    auto row = other.RowIdx(i);
+    for (size_t c = 0; c < _columns.size(); c++) {
+        _columns[c].AppendFrom(other._columns[c], row);
+    }
+}
+
+void Chunk::Append(const Chunk &other, size_t begin, size_t end) {
+    for (size_t c = 0; c < _columns.size(); c++) {
+        auto &col = _columns[c];
+        const auto &src = other._columns[c];
+        col.Reserve(end - begin);
+        for (size_t i = begin; i < end; i++) {
+            col.AppendFrom(src, other.RowIdx(i));
+        }
+    }
+}
+
+void Chunk::Reset() {
+    for (auto &col : _columns) {
+        col.Reset();
+    }
+    ClearSel();
+}
+
+std::vector<Column> Chunk::ReleaseColumns() {
+    ClearSel();
+    return std::move(_columns);
+}
+
+}  // namespace util::chunk
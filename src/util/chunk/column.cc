@@ -0,0 +1,110 @@
+#include "util/chunk/column.hh"
+
+#include <algorithm>
+#include <bit>
+#include <new>
+
+#include "parser/mysql/type.hh"
+
+namespace util::chunk {
+
+Buffer::~Buffer() {
+    if (_data != nullptr && _owned) {
+        ::operator delete(_data, std::align_val_t(bufferAlignment));
+    }
+}
+
+void Buffer::grow(size_t n) {
+    auto capacity = std::max({n, _size, _capacity * 2, bufferAlignment});
+    capacity = (capacity + bufferAlignment - 1) / bufferAlignment * bufferAlignment;
+    auto *data = static_cast<uint8_t *>(::operator new(capacity, std::align_val_t(bufferAlignment)));
+    if (_size > 0) {
+        std::memcpy(data, _data, _size);
+    }
+    if (_data != nullptr && _owned) {
+        ::operator delete(_data, std::align_val_t(bufferAlignment));
+    }
+    _data = data;
+    _capacity = capacity;
+    _owned = true;
+}
+
+size_t Column::ElemSize(uint8_t tp) {
+    switch (tp) {
+        case mysql::TypeTiny:
+        case mysql::TypeShort:
+        case mysql::TypeYear:
+        case mysql::TypeInt24:
+        case mysql::TypeLong:
+        case mysql::TypeLonglong:
+        case mysql::TypeDouble:
+            return 8;
+        case mysql::TypeFloat:
+            return 4;
+        default:
+            return varElemSize;
+    }
+}
+
+Column::Column(size_t elemSize, size_t capacity) : _elemSize(elemSize) {
+    if (!IsFixed()) {
+        appendOffset();
+    }
+    Reserve(capacity);
+}
+
+void Column::AppendFrom(const Column &other, size_t row) {
+    if (other.IsNull(row)) {
+        AppendNull();
+        return;
+    }
+    if (IsFixed()) {
+        appendValidity(true);
+        _data.Append(other._data.Data() + row * _elemSize, _elemSize);
+    } else {
+        AppendBytes(other.GetBytes(row));
+    }
+}
+
+void Column::ResizeFixed(size_t n) {
+    _length = n;
+    _nullCount = 0;
+    _nullBitmap.Resize((n + 7) / 8);
+    std::memset(_nullBitmap.Data(), 0xff, _nullBitmap.Size());
+    _data.Resize(n * _elemSize);
+}
+
+void Column::RecountNulls() {
+    size_t valid = 0;
+    auto *bitmap = _nullBitmap.Data();
+    for (size_t i = 0; i < _length / 8; i++) {
+        valid += std::popcount(bitmap[i]);
+    }
+    if (_length % 8 != 0) {
+        valid += std::popcount(static_cast<uint8_t>(bitmap[_length / 8] & ((1u << (_length % 8)) - 1)));
+    }
+    _nullCount = _length - valid;
+}
+
+void Column::Reserve(size_t rows, size_t dataBytes) {
+    _nullBitmap.Reserve((_length + rows + 7) / 8);
+    if (IsFixed()) {
+        _data.Reserve(_data.Size() + rows * _elemSize);
+    } else {
+        _offsets.Reserve(_offsets.Size() + rows * sizeof(int64_t));
+        _data.Reserve(_data.Size() + dataBytes);
+    }
+}
+
+void Column::Reset() {
+    _length = 0;
+    _nullCount = 0;
+    _nullBitmap.Clear();
+    _data.Clear();
+    if (!IsFixed()) {
+        _offsets.Clear();
+        appendOffset();
+    }
+}
+
+}  // namespace util::chunk
@@ -0,0 +1,89 @@
+#include "util/codec/codec.hh"
+
+namespace util::codec {
+
+namespace {
+
+constexpr size_t encGroupSize = 8;
+constexpr uint8_t encMarker = 0xff;
+
+}  // namespace
+
+// Every group is moved as one 8-byte word and the output is sized once: the 9-byte stride of the groups leaves
+// nothing for vector shuffles to win over a load and a store per group.
+void EncodeBytes(std::string &b, std::string_view data) {
+    auto off = b.size();
+    b.resize(off + EncodedBytesLength(data.size()));
+    auto *out = b.data() + off;
+    const auto *in = data.data();
+    for (size_t n = data.size() / encGroupSize; n > 0; n--) {
+        std::memcpy(out, in, encGroupSize);
+        out[encGroupSize] = static_cast<char>(encMarker);
+        in += encGroupSize;
+        out += encGroupSize + 1;
+    }
+    auto remain = data.size() % encGroupSize;
+    uint64_t last = 0;
+    // in is null for an empty string_view, which memcpy must not be given even for 0 bytes.
+    if (remain > 0) {
+        std::memcpy(&last, in, remain);
+    }
+    std::memcpy(out, &last, encGroupSize);
+    out[encGroupSize] = static_cast<char>(encMarker - (encGroupSize - remain));
+}
+
+void EncodeBytesDesc(std::string &b, std::string_view data) {
+    auto off = b.size();
+    EncodeBytes(b, data);
+    for (auto i = off; i < b.size(); i++) {
+        b[i] = static_cast<char>(~b[i]);
+    }
+}
+
+namespace {
+
+template <bool desc>
+size_t decodeBytes(std::string_view b, std::string &out) {
+    constexpr uint8_t mask = desc ? 0xff : 0;
+    auto start = out.size();
+    size_t off = 0;
+    while (true) {
+        if (b.size() - off < encGroupSize + 1) {
+            out.resize(start);
+            return 0;
+        }
+        const auto *group = b.data() + off;
+        off += encGroupSize + 1;
+        auto marker = static_cast<uint8_t>(group[encGroupSize] ^ mask);
+        auto padCount = static_cast<size_t>(encMarker - marker);
+        if (padCount > encGroupSize) {
+            out.resize(start);
+            return 0;
+        }
+        auto realSize = encGroupSize - padCount;
+        for (auto i = realSize; i < encGroupSize; i++) {
+            if (static_cast<uint8_t>(group[i] ^ mask) != 0) {
+                out.resize(start);
+                return 0;
+            }
+        }
+        auto n = out.size();
+        out.append(group, realSize);
+        if constexpr (desc) {
+            for (auto i = n; i < out.size(); i++) {
+                out[i] = static_cast<char>(~out[i]);
+            }
+        }
+        if (padCount != 0) {
+            return off;
+        }
+    }
+}
+
+}  // namespace
+
+size_t DecodeBytes(std::string_view b, std::string &out) { return decodeBytes<false>(b, out); }
+
+size_t DecodeBytesDesc(std::string_view b, std::string &out) { return decodeBytes<true>(b, out); }
+
+}  // namespace util::codec
@@ -0,0 +1,102 @@
+#include "util/codec/codec.hh"
+
+namespace util::codec {
+
+namespace {
+
+size_t peekBytes(std::string_view b) {
+    for (size_t off = 8; off < b.size(); off += 9) {
+        auto marker = static_cast<uint8_t>(b[off]);
+        if (marker != 0xff) {
+            return marker >= 0xff - 8 ? off + 1 : 0;
+        }
+    }
+    return 0;
+}
+
+size_t peekDecimal(std::string_view b) {
+    if (b.size() < 2) {
+        return 0;
+    }
+    int precision = static_cast<uint8_t>(b[0]);
+    int frac = static_cast<uint8_t>(b[1]);
+    if (precision == 0 || precision > MaxDecimalPrecision || frac > MaxDecimalScale || frac > precision) {
+        return 0;
+    }
+    return 2 + DecimalBinSize(precision, frac);
+}
+
+// encodeColumn appends the values to the keys with flag, the type dispatch being resolved at compile time.
+template <typename T, typename Encode>
+void encodeColumn(std::vector<std::string> &keys, std::span<const T> values, std::span<const uint8_t> nulls,
+                  uint8_t flag, Encode encode) {
+    if (nulls.empty()) {
+        for (size_t i = 0; i < values.size(); i++) {
+            keys[i].push_back(static_cast<char>(flag));
+            encode(keys[i], values[i]);
+        }
+        return;
+    }
+    for (size_t i = 0; i < values.size(); i++) {
+        if (nulls[i]) {
+            keys[i].push_back(static_cast<char>(NilFlag));
+            continue;
+        }
+        keys[i].push_back(static_cast<char>(flag));
+        encode(keys[i], values[i]);
+    }
+}
+
+}  // namespace
+
+size_t PeekKeyValue(std::string_view key) {
+    if (key.empty()) {
+        return 0;
+    }
+    auto rest = key.substr(1);
+    size_t n = 0;
+    switch (static_cast<uint8_t>(key[0])) {
+        case NilFlag:
+        case MaxFlag:
+            return 1;
+        case IntFlag:
+        case UintFlag:
+        case FloatFlag:
+        case DurationFlag:
+            n = 8;
+            break;
+        case BytesFlag:
+            n = peekBytes(rest);
+            break;
+        case DecimalFlag:
+            n = peekDecimal(rest);
+            break;
+        default:
+            // The compact bytes, the varints and JSON do not compare: they are never in a key.
+            return 0;
+    }
+    if (n == 0 || n > rest.size()) {
+        return 0;
+    }
+    return 1 + n;
+}
+
+void EncodeIntColumn(std::vector<std::string> &keys, std::span<const int64_t> values, std::span<const uint8_t> nulls) {
+    encodeColumn(keys, values, nulls, IntFlag, [](std::string &b, int64_t v) { EncodeInt(b, v); });
+}
+
+void EncodeUintColumn(std::vector<std::string> &keys, std::span<const uint64_t> values,
+                      std::span<const uint8_t> nulls) {
+    encodeColumn(keys, values, nulls, UintFlag, [](std::string &b, uint64_t v) { EncodeUint(b, v); });
+}
+
+void EncodeFloatColumn(std::vector<std::string> &keys, std::span<const double> values, std::span<const uint8_t> nulls) {
+    encodeColumn(keys, values, nulls, FloatFlag, [](std::string &b, double v) { EncodeFloat(b, v); });
+}
+
+void EncodeBytesColumn(std::vector<std::string> &keys, std::span<const std::string_view> values,
+                       std::span<const uint8_t> nulls) {
+    encodeColumn(keys, values, nulls, BytesFlag, [](std::string &b, std::string_view v) { EncodeBytes(b, v); });
+}
+
+}  // namespace util::codec
@@ -0,0 +1,194 @@
+#include "util/codec/codec.hh"
+
+#include <algorithm>
+#include <array>
+
+namespace util::codec {
+
+namespace {
+
+constexpr int digitsPerWord = 9;
+constexpr int wordSize = 4;
+// dig2bytes is the number of bytes holding a group of up to 9 digits.
+constexpr int dig2bytes[digitsPerWord + 1] = {0, 1, 1, 2, 2, 3, 3, 4, 4, 4};
+constexpr uint32_t powers10[digitsPerWord + 1] = {1,      10,      100,      1000,      10000,
+                                                  100000, 1000000, 10000000, 100000000, 1000000000};
+
+// parsedDecimal is the text of a decimal split in its parts, without the leading zeros of the integer part.
+struct parsedDecimal {
+    bool Negative{false};
+    std::string_view IntDigits;
+    std::string_view FracDigits;
+};
+
+bool isDigits(std::string_view s) {
+    return std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+std::optional<parsedDecimal> parseDecimal(std::string_view text) {
+    parsedDecimal d;
+    if (!text.empty() && (text[0] == '-' || text[0] == '+')) {
+        d.Negative = text[0] == '-';
+        text.remove_prefix(1);
+    }
+    auto dot = text.find('.');
+    d.IntDigits = text.substr(0, dot);
+    if (dot != std::string_view::npos) {
+        d.FracDigits = text.substr(dot + 1);
+    }
+    if ((d.IntDigits.empty() && d.FracDigits.empty()) || !isDigits(d.IntDigits) || !isDigits(d.FracDigits)) {
+        return std::nullopt;
+    }
+    d.IntDigits.remove_prefix(std::min(d.IntDigits.find_first_not_of('0'), d.IntDigits.size()));
+    return d;
+}
+
+uint32_t readDigits(const char *d, int n) {
+    uint32_t v = 0;
+    for (int i = 0; i < n; i++) {
+        v = v * 10 + static_cast<uint32_t>(d[i] - '0');
+    }
+    return v;
+}
+
+}  // namespace
+
+size_t DecimalBinSize(int precision, int frac) {
+    auto intg = precision - frac;
+    return static_cast<size_t>(intg / digitsPerWord * wordSize + dig2bytes[intg % digitsPerWord] +
+                               frac / digitsPerWord * wordSize + dig2bytes[frac % digitsPerWord]);
+}
+
+std::optional<mysql::SQLError> EncodeDecimal(std::string &b, std::string_view text, int precision, int frac) {
+    auto parsed = parseDecimal(text);
+    if (!parsed) {
+        return mysql::NewErr(mysql::ErrTruncatedWrongValue, "DECIMAL", std::string(text).c_str());
+    }
+    if (precision == 0) {
+        frac = static_cast<int>(parsed->FracDigits.size());
+        precision = std::max(static_cast<int>(parsed->IntDigits.size()) + frac, 1);
+    }
+    if (precision > MaxDecimalPrecision) {
+        return mysql::NewErr(mysql::ErrTooBigPrecision, precision, "", MaxDecimalPrecision);
+    }
+    if (frac > MaxDecimalScale) {
+        return mysql::NewErr(mysql::ErrTooBigScale, frac, "", MaxDecimalScale);
+    }
+    if (precision < 0 || frac < 0 || frac > precision) {
+        return mysql::NewErr(mysql::ErrMBiggerThanD, "");
+    }
+
+    // Lay the digits out on exactly precision digits.
+    std::optional<mysql::SQLError> warning;
+    auto intg = precision - frac;
+    std::array<char, MaxDecimalPrecision> digits;
+    auto intDigits = static_cast<int>(parsed->IntDigits.size());
+    auto fracDigits = static_cast<int>(parsed->FracDigits.size());
+    if (intDigits > intg) {
+        std::fill_n(digits.begin(), precision, '9');
+        warning = mysql::NewErr(mysql::ErrDataOutOfRange, "DECIMAL", std::string(text).c_str());
+    } else {
+        std::fill_n(digits.begin(), intg - intDigits, '0');
+        std::copy(parsed->IntDigits.begin(), parsed->IntDigits.end(), digits.begin() + intg - intDigits);
+        auto kept = std::min(fracDigits, frac);
+        std::copy_n(parsed->FracDigits.begin(), kept, digits.begin() + intg);
+        std::fill(digits.begin() + intg + kept, digits.begin() + precision, '0');
+        if (parsed->FracDigits.find_first_not_of('0', kept) != std::string_view::npos) {
+            warning = mysql::NewErrf(mysql::WarnDataTruncated, "Data truncated for DECIMAL value: '%s'",
+                                     std::string(text).c_str());
+        }
+    }
+    bool negative = parsed->Negative && std::any_of(digits.begin(), digits.begin() + precision,
+                                                    [](char c) { return c != '0'; });
+
+    b.push_back(static_cast<char>(precision));
+    b.push_back(static_cast<char>(frac));
+    // Every group of digits is stored big-endian on the bytes it needs, all inverted for a negative value; the first
+    // bit, which is clear for the largest group, is then flipped so that the negative values sort first.
+    auto start = b.size();
+    uint32_t mask = negative ? ~0u : 0u;
+    auto put = [&](uint32_t v, int size) {
+        v ^= mask;
+        for (int shift = (size - 1) * 8; shift >= 0; shift -= 8) {
+            b.push_back(static_cast<char>(v >> shift));
+        }
+    };
+    const char *d = digits.data();
+    auto leading = intg % digitsPerWord;
+    if (leading > 0) {
+        put(readDigits(d, leading), dig2bytes[leading]);
+        d += leading;
+    }
+    for (int i = 0; i < intg / digitsPerWord + frac / digitsPerWord; i++) {
+        put(readDigits(d, digitsPerWord), wordSize);
+        d += digitsPerWord;
+    }
+    auto trailing = frac % digitsPerWord;
+    if (trailing > 0) {
+        put(readDigits(d, trailing), dig2bytes[trailing]);
+    }
+    b[start] = static_cast<char>(b[start] ^ 0x80);
+    return warning;
+}
+
+std::tuple<std::string, int, int, size_t> DecodeDecimal(std::string_view b) {
+    if (b.size() < 2) {
+        return {{}, 0, 0, 0};
+    }
+    int precision = static_cast<uint8_t>(b[0]);
+    int frac = static_cast<uint8_t>(b[1]);
+    if (precision == 0 || precision > MaxDecimalPrecision || frac > MaxDecimalScale || frac > precision) {
+        return {{}, 0, 0, 0};
+    }
+    auto size = DecimalBinSize(precision, frac);
+    if (b.size() < 2 + size) {
+        return {{}, 0, 0, 0};
+    }
+    std::array<uint8_t, MaxDecimalPrecision> bin;
+    std::copy_n(b.begin() + 2, size, bin.begin());
+    bool negative = (bin[0] & 0x80) == 0;
+    bin[0] ^= 0x80;
+    uint8_t mask = negative ? 0xff : 0;
+
+    std::string digits;
+    size_t off = 0;
+    auto get = [&](int n) {
+        uint32_t v = 0;
+        for (int i = 0; i < dig2bytes[n]; i++) {
+            v = v << 8 | static_cast<uint8_t>(bin[off++] ^ mask);
+        }
+        if (v >= powers10[n]) {
+            return false;
+        }
+        auto s = std::to_string(v);
+        digits.append(n - s.size(), '0');
+        digits += s;
+        return true;
+    };
+    auto intg = precision - frac;
+    bool ok = intg % digitsPerWord == 0 || get(intg % digitsPerWord);
+    for (int i = 0; ok && i < intg / digitsPerWord + frac / digitsPerWord; i++) {
+        ok = get(digitsPerWord);
+    }
+    if (ok && frac % digitsPerWord > 0) {
+        ok = get(frac % digitsPerWord);
+    }
+    if (!ok) {
+        return {{}, 0, 0, 0};
+    }
+
+    std::string text;
+    if (negative && digits.find_first_not_of('0') != std::string::npos) {
+        text.push_back('-');
+    }
+    auto intPart = std::string_view(digits).substr(0, intg);
+    intPart.remove_prefix(std::min(intPart.find_first_not_of('0'), intPart.size()));
+    text += intPart.empty() ? "0" : intPart;
+    if (frac > 0) {
+        text.push_back('.');
+        text += std::string_view(digits).substr(intg);
+    }
+    return {std::move(text), precision, frac, 2 + size};
+}
+
+}  // namespace util::codec
@@ -0,0 +1,62 @@
+#include "util/sketch/count_min.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <utility>
+
+#include "madoka/madoka.h"
+
+namespace util::sketch {
+
+CountMinSketch::CountMinSketch(uint64_t width, uint64_t maxValue, uint64_t seed)
+    : _sketch(std::make_unique<madoka::Sketch>()) {
+    _sketch->create(width, maxValue, nullptr, 0, seed);
+}
+
+CountMinSketch::CountMinSketch(std::unique_ptr<madoka::Sketch> sketch) : _sketch(std::move(sketch)) {}
+
+CountMinSketch::~CountMinSketch() = default;
+
+CountMinSketch::CountMinSketch(CountMinSketch &&) noexcept = default;
+CountMinSketch &CountMinSketch::operator=(CountMinSketch &&) noexcept = default;
+
+void CountMinSketch::Add(std::string_view key, uint64_t count) { _sketch->add(key.data(), key.size(), count); }
+
+uint64_t CountMinSketch::Get(std::string_view key) const { return _sketch->get(key.data(), key.size()); }
+
+uint64_t CountMinSketch::Width() const { return _sketch->width(); }
+
+uint64_t CountMinSketch::MaxValue() const { return _sketch->max_value(); }
+
+size_t CountMinSketch::Bytes() const { return _sketch->file_size(); }
+
+std::optional<mysql::SQLError> CountMinSketch::Save(const std::string &path) const {
+    // madoka reports its errors by exceptions without the errno, which is left by the failed call.
+    errno = 0;
+    try {
+        _sketch->save(path.c_str());
+    } catch (const std::exception &) {
+        auto err = errno;
+        return mysql::NewErr(mysql::ErrCantCreateFile, path.c_str(), err, std::strerror(err));
+    }
+    return std::nullopt;
+}
+
+std::tuple<std::unique_ptr<CountMinSketch>, std::optional<mysql::SQLError>> CountMinSketch::Open(
+    const std::string &path) {
+    auto sketch = std::make_unique<madoka::Sketch>();
+    errno = 0;
+    try {
+        sketch->open(path.c_str(), madoka::FILE_READONLY);
+    } catch (const std::exception &) {
+        // Without an errno, the file was opened but is not a sketch.
+        if (auto err = errno; err != 0) {
+            return {nullptr, mysql::NewErr(mysql::ErrCantOpenFile, path.c_str(), err, std::strerror(err))};
+        }
+        return {nullptr, mysql::NewErr(mysql::ErrNotFormFile, path.c_str())};
+    }
+    return {std::unique_ptr<CountMinSketch>(new CountMinSketch(std::move(sketch))), std::nullopt};
+}
+
+}  // namespace util::sketch
@@ -0,0 +1,68 @@
+#include "util/sketch/hyperloglog.hh"
+
+#include <algorithm>
+
+#include "count/hll.h"
+
+namespace util::sketch {
+
+HyperLogLog::HyperLogLog(int precision) : _precision(precision) {}
+
+HyperLogLog::~HyperLogLog() = default;
+
+HyperLogLog::HyperLogLog(HyperLogLog &&) noexcept = default;
+HyperLogLog &HyperLogLog::operator=(HyperLogLog &&) noexcept = default;
+
+void HyperLogLog::Update(uint64_t hash) {
+    if (_hll != nullptr) {
+        _hll->Update(hash);
+        return;
+    }
+    // The duplicates are only removed when the hashes would take twice the sparse size.
+    _sparse.push_back(hash);
+    if (_sparse.size() >= 2 * maxSparse) {
+        compact();
+    }
+}
+
+void HyperLogLog::Merge(const HyperLogLog &other) {
+    if (other._hll != nullptr) {
+        densify();
+        _hll->Merge(other._hll.get());
+        return;
+    }
+    for (auto hash : other._sparse) {
+        Update(hash);
+    }
+}
+
+uint64_t HyperLogLog::Estimate() const {
+    if (_hll != nullptr) {
+        return _hll->Estimate();
+    }
+    auto hashes = _sparse;
+    std::sort(hashes.begin(), hashes.end());
+    return std::unique(hashes.begin(), hashes.end()) - hashes.begin();
+}
+
+void HyperLogLog::compact() {
+    std::sort(_sparse.begin(), _sparse.end());
+    _sparse.erase(std::unique(_sparse.begin(), _sparse.end()), _sparse.end());
+    if (_sparse.size() > maxSparse) {
+        densify();
+    }
+}
+
+void HyperLogLog::densify() {
+    if (_hll != nullptr) {
+        return;
+    }
+    _hll.reset(libcount::HLL::Create(_precision));
+    for (auto hash : _sparse) {
+        _hll->Update(hash);
+    }
+    _sparse.clear();
+    _sparse.shrink_to_fit();
+}
+
+}  // namespace util::sketch
@@ -0,0 +1,112 @@
+#include "util/sketch/kll.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace util::sketch {
+
+namespace {
+
+// capacityRatio is the ratio of the capacity of a level to that of the level above.
+constexpr double capacityRatio = 2.0 / 3.0;
+
+}  // namespace
+
+KLLSketch::KLLSketch(uint32_t k, uint64_t seed) : _k(k), _random(seed) { grow(); }
+
+void KLLSketch::Update(uint64_t v) {
+    _levels[0].push_back(v);
+    _n++;
+    _size++;
+    if (_size >= _maxSize) {
+        compress();
+    }
+}
+
+void KLLSketch::Merge(const KLLSketch &other) {
+    while (_levels.size() < other._levels.size()) {
+        grow();
+    }
+    for (size_t h = 0; h < other._levels.size(); h++) {
+        _levels[h].insert(_levels[h].end(), other._levels[h].begin(), other._levels[h].end());
+    }
+    _n += other._n;
+    _size += other._size;
+    while (_size >= _maxSize) {
+        compress();
+    }
+}
+
+uint64_t KLLSketch::Quantile(double q) const {
+    if (_n == 0) {
+        return 0;
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> weighted;
+    weighted.reserve(_size);
+    for (size_t h = 0; h < _levels.size(); h++) {
+        for (auto v : _levels[h]) {
+            weighted.emplace_back(v, uint64_t{1} << h);
+        }
+    }
+    std::sort(weighted.begin(), weighted.end());
+    // The weights of the values sum to _n: compacting a level of an odd size leaves a value in it.
+    auto rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * _n)), 1);
+    uint64_t seen = 0;
+    for (const auto &[v, weight] : weighted) {
+        seen += weight;
+        if (seen >= rank) {
+            return v;
+        }
+    }
+    return weighted.back().first;
+}
+
+size_t KLLSketch::capacity(size_t h) const {
+    auto depth = static_cast<double>(_levels.size() - h - 1);
+    return static_cast<size_t>(std::ceil(std::pow(capacityRatio, depth) * _k)) + 1;
+}
+
+void KLLSketch::grow() {
+    _levels.emplace_back();
+    _maxSize = 0;
+    for (size_t h = 0; h < _levels.size(); h++) {
+        _maxSize += capacity(h);
+    }
+}
+
+void KLLSketch::compress() {
+    for (size_t h = 0; h < _levels.size(); h++) {
+        if (_levels[h].size() < capacity(h)) {
+            continue;
+        }
+        if (h + 1 == _levels.size()) {
+            grow();
+        }
+        auto &level = _levels[h];
+        auto &next = _levels[h + 1];
+        std::sort(level.begin(), level.end());
+        // The pairs are taken from the end, an odd value being left at the start of the level.
+        auto odd = level.size() % 2;
+        auto offset = randomBit() ? 1 : 0;
+        for (auto i = odd + offset; i < level.size(); i += 2) {
+            next.push_back(level[i]);
+        }
+        _size -= level.size() - odd - (level.size() - odd) / 2;
+        level.resize(odd);
+        // The compaction is lazy: it stops at the first level that makes room.
+        if (_size < _maxSize) {
+            break;
+        }
+    }
+}
+
+bool KLLSketch::randomBit() {
+    // splitmix64, so that a sketch is deterministic for a seed.
+    auto z = (_random += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return ((z ^ (z >> 31)) & 1) != 0;
+}
+
+}  // namespace util::sketch
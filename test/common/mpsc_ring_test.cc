@@ -0,0 +1,58 @@
+#include "common/mpsc_ring.hh"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace common;
+
+TEST(MPSCRingTest, TestPushPop) {
+    MPSCRing<int, 4> ring;
+    int v;
+    EXPECT_FALSE(ring.TryPop(v));
+    for (int lap = 0; lap < 3; lap++) {
+        for (int i = 0; i < 4; i++) {
+            EXPECT_TRUE(ring.TryPush(lap * 4 + i));
+        }
+        // A full ring rejects the push instead of waiting.
+        EXPECT_FALSE(ring.TryPush(-1));
+        for (int i = 0; i < 4; i++) {
+            ASSERT_TRUE(ring.TryPop(v));
+            EXPECT_EQ(v, lap * 4 + i);
+        }
+        EXPECT_FALSE(ring.TryPop(v));
+    }
+}
+
+TEST(MPSCRingTest, TestProducers) {
+    constexpr int numProducers = 4;
+    constexpr int perProducer = 100000;
+    MPSCRing<std::pair<int, int>, 256> ring;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < numProducers; p++) {
+        producers.emplace_back([&ring, p] {
+            for (int i = 0; i < perProducer; i++) {
+                while (!ring.TryPush({p, i})) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    // Every value arrives once, in the order of its producer.
+    std::vector<int> next(numProducers, 0);
+    for (int n = 0; n < numProducers * perProducer;) {
+        std::pair<int, int> v;
+        if (!ring.TryPop(v)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_EQ(v.second, next[v.first]);
+        next[v.first]++;
+        n++;
+    }
+    for (auto &t : producers) {
+        t.join();
+    }
+    EXPECT_EQ(next, std::vector<int>(numProducers, perProducer));
+}
@@ -0,0 +1,115 @@
+#include "common/tracing.hh"
+
+#include <gtest/gtest.h>
+
+#include <nlohmann/json.hpp>
+#include <thread>
+
+using namespace common::tracing;
+
+namespace {
+
+void traced() {
+    Span span("outer");
+    Span inner("inner");
+}
+
+}  // namespace
+
+TEST(TracingTest, TestDisabled) {
+    TraceScope scope(false);
+    EXPECT_FALSE(scope.Enabled());
+    traced();
+    EXPECT_EQ(activeRecorder, nullptr);
+    EXPECT_TRUE(scope.Finish(1, "").Events.empty());
+}
+
+TEST(TracingTest, TestSpans) {
+    Trace trace;
+    {
+        TraceScope scope(true);
+        ASSERT_TRUE(scope.Enabled());
+        // Scopes do not nest.
+        EXPECT_FALSE(TraceScope(true).Enabled());
+        Span root("root");
+        traced();
+        std::thread([] {
+            // Other threads are not traced.
+            Span span("other");
+            EXPECT_EQ(activeRecorder, nullptr);
+        }).join();
+        trace = scope.Finish(7, "select 1");
+    }
+    EXPECT_EQ(activeRecorder, nullptr);
+    EXPECT_EQ(trace.ConnID, 7);
+    EXPECT_EQ(trace.Label, "select 1");
+    EXPECT_FALSE(trace.Truncated);
+    ASSERT_EQ(trace.Events.size(), 3);
+    EXPECT_STREQ(trace.Events[0].Name, "root");
+    EXPECT_STREQ(trace.Events[1].Name, "outer");
+    EXPECT_STREQ(trace.Events[2].Name, "inner");
+    // The root was still open: it ends at Finish, after its children.
+    EXPECT_LE(trace.Events[0].Begin, trace.Events[1].Begin);
+    EXPECT_LE(trace.Events[1].Begin, trace.Events[2].Begin);
+    EXPECT_LE(trace.Events[2].End, trace.Events[1].End);
+    EXPECT_LE(trace.Events[1].End, trace.Events[0].End);
+
+    // The buffer is reused by the next trace.
+    TraceScope scope(true);
+    traced();
+    EXPECT_EQ(scope.Finish(7, "").Events.size(), 2);
+}
+
+TEST(TracingTest, TestTruncated) {
+    TraceScope scope(true);
+    for (uint32_t i = 0; i < recorder::capacity + 10; i++) {
+        Span span("span");
+    }
+    auto trace = scope.Finish(1, "");
+    EXPECT_TRUE(trace.Truncated);
+    EXPECT_EQ(trace.Events.size(), recorder::capacity);
+}
+
+TEST(TracingTest, TestSample) {
+    int n = 0;
+    for (int i = 0; i < 100; i++) {
+        n += Sample(10);
+        EXPECT_FALSE(Sample(0));
+    }
+    EXPECT_EQ(n, 10);
+}
+
+TEST(TracingTest, TestChromeJSON) {
+    TraceLog log(2);
+    for (uint32_t conn = 1; conn <= 3; conn++) {
+        TraceScope scope(true);
+        {
+            Span span("command");
+            traced();
+        }
+        log.Add(scope.Finish(conn, "select \"\xff\""));
+    }
+    EXPECT_EQ(log.Size(), 2);
+
+    std::string out;
+    log.WriteChromeJSON(out);
+    auto doc = nlohmann::json::parse(out);
+    auto &events = doc["traceEvents"];
+    // A thread name and three spans per trace.
+    ASSERT_EQ(events.size(), 8);
+    EXPECT_EQ(events[0]["ph"], "M");
+    EXPECT_EQ(events[0]["tid"], 2);
+    EXPECT_EQ(events[0]["args"]["name"], "conn 2");
+    auto &root = events[1];
+    EXPECT_EQ(root["name"], "command");
+    EXPECT_EQ(root["ph"], "X");
+    EXPECT_EQ(root["tid"], 2);
+    // Invalid UTF-8 is replaced.
+    EXPECT_EQ(root["args"]["label"], "select \"\xef\xbf\xbd\"");
+    auto &inner = events[3];
+    EXPECT_EQ(inner["name"], "inner");
+    EXPECT_GE(inner["ts"].get<double>(), root["ts"].get<double>());
+    EXPECT_LE(inner["ts"].get<double>() + inner["dur"].get<double>(),
+              root["ts"].get<double>() + root["dur"].get<double>() + 0.001);
+    EXPECT_EQ(events[4]["tid"], 3);
+}
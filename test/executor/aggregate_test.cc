@@ -0,0 +1,410 @@
+#include "executor/aggregate.hh"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "parser/mysql/type.hh"
+
+using namespace executor;
+using expression::ColumnRef;
+using expression::Constant;
+using expression::ExprPtr;
+using expression::FieldType;
+using util::chunk::Chunk;
+
+namespace {
+
+// The columns of the input: a BIGINT k, null one time in ten, a VARCHAR s, a BIGINT v and a DOUBLE d.
+enum { colK, colS, colV, colD };
+
+ExprPtr col(size_t index) {
+    static const FieldType types[] = {
+        {mysql::TypeLonglong, 0},
+        {mysql::TypeVarString, 0},
+        {mysql::TypeLonglong, 0},
+        {mysql::TypeDouble, 0},
+    };
+    static const char *names[] = {"k", "s", "v", "d"};
+    return std::make_unique<ColumnRef>(index, types[index], names[index]);
+}
+
+struct row {
+    std::optional<int64_t> K;
+    std::string S;
+    int64_t V;
+    std::optional<double> D;
+};
+
+// newInput returns the rows in chunks of up to 100 rows, every other chunk with a selection of some of them.
+std::vector<Chunk> newInput(const std::vector<row> &rows) {
+    const std::vector<uint8_t> types{mysql::TypeLonglong, mysql::TypeVarString, mysql::TypeLonglong,
+                                     mysql::TypeDouble};
+    std::vector<Chunk> input;
+    for (size_t begin = 0; begin < rows.size(); begin += 100) {
+        Chunk chk(types);
+        std::vector<uint32_t> sel;
+        for (size_t i = begin; i < std::min(begin + 100, rows.size()); i++) {
+            const auto &r = rows[i];
+            // An unselected row before every selected one.
+            if (input.size() % 2 == 1) {
+                sel.push_back(static_cast<uint32_t>(chk.NumRows() + 1));
+                chk.Col(colK).AppendInt64(-1000);
+                chk.Col(colS).AppendBytes("unselected");
+                chk.Col(colV).AppendInt64(1 << 20);
+                chk.Col(colD).AppendFloat64(1e9);
+            }
+            r.K ? chk.Col(colK).AppendInt64(*r.K) : chk.Col(colK).AppendNull();
+            chk.Col(colS).AppendBytes(r.S);
+            chk.Col(colV).AppendInt64(r.V);
+            r.D ? chk.Col(colD).AppendFloat64(*r.D) : chk.Col(colD).AppendNull();
+        }
+        if (input.size() % 2 == 1) {
+            chk.SetSel(sel);
+        }
+        input.push_back(std::move(chk));
+    }
+    return input;
+}
+
+std::vector<AggFuncDesc> newAggs() {
+    std::vector<AggFuncDesc> aggs;
+    aggs.push_back({AggFunc::Count, nullptr});
+    aggs.push_back({AggFunc::Count, col(colD)});
+    aggs.push_back({AggFunc::Sum, col(colV)});
+    aggs.push_back({AggFunc::Avg, col(colV)});
+    aggs.push_back({AggFunc::Min, col(colD)});
+    aggs.push_back({AggFunc::Max, col(colV)});
+    return aggs;
+}
+
+// result is a group: count(*), count(d), sum(v), avg(v), min(d) and max(v).
+struct result {
+    int64_t Count{0};
+    int64_t CountD{0};
+    int64_t Sum{0};
+    std::optional<double> MinD;
+    int64_t Max{INT64_MIN};
+
+    bool operator==(const result &) const = default;
+};
+
+using groupKey = std::tuple<std::optional<int64_t>, std::string>;
+
+std::map<groupKey, result> expected(const std::vector<row> &rows) {
+    std::map<groupKey, result> groups;
+    for (const auto &r : rows) {
+        auto &g = groups[{r.K, r.S}];
+        g.Count++;
+        g.Sum += r.V;
+        g.Max = std::max(g.Max, r.V);
+        if (r.D) {
+            g.CountD++;
+            g.MinD = g.MinD ? std::min(*g.MinD, *r.D) : *r.D;
+        }
+    }
+    return groups;
+}
+
+// collect returns the groups of the output of an aggregation grouped by k and s, checking the average.
+std::map<groupKey, result> collect(const std::vector<Chunk> &out, std::vector<groupKey> *order = nullptr) {
+    std::map<groupKey, result> groups;
+    for (const auto &chk : out) {
+        EXPECT_LE(chk.NumRows(), util::chunk::defaultCapacity);
+        for (size_t i = 0; i < chk.NumRows(); i++) {
+            groupKey key{chk.Col(0).IsNull(i) ? std::nullopt : std::optional(chk.Col(0).GetInt64(i)),
+                         std::string(chk.Col(1).GetBytes(i))};
+            EXPECT_FALSE(groups.contains(key));
+            auto &g = groups[key];
+            g.Count = chk.Col(2).GetInt64(i);
+            g.CountD = chk.Col(3).GetInt64(i);
+            g.Sum = chk.Col(4).GetInt64(i);
+            EXPECT_DOUBLE_EQ(chk.Col(5).GetFloat64(i), static_cast<double>(g.Sum) / g.Count);
+            if (!chk.Col(6).IsNull(i)) {
+                g.MinD = chk.Col(6).GetFloat64(i);
+            }
+            g.Max = chk.Col(7).GetInt64(i);
+            if (order != nullptr) {
+                order->push_back(key);
+            }
+        }
+    }
+    return groups;
+}
+
+std::unique_ptr<AggExec> newAgg(AggOptions opts) {
+    std::vector<ExprPtr> groupBy;
+    groupBy.push_back(col(colK));
+    groupBy.push_back(col(colS));
+    auto [agg, err] = AggExec::New(std::move(groupBy), newAggs(), opts);
+    EXPECT_FALSE(err);
+    return std::move(agg);
+}
+
+std::vector<row> randomRows(std::mt19937_64 &rng, size_t n, int64_t cardinality) {
+    std::vector<row> rows;
+    for (size_t i = 0; i < n; i++) {
+        auto k = static_cast<int64_t>(rng() % cardinality) - cardinality / 2;
+        row r{k, std::to_string(k % 3), static_cast<int64_t>(rng() % 1000) - 500, std::nullopt};
+        if (rng() % 10 == 0) {
+            r.K.reset();
+        }
+        if (rng() % 4 != 0) {
+            r.D = static_cast<double>(rng() % 100) / 4;
+        }
+        rows.push_back(std::move(r));
+    }
+    return rows;
+}
+
+}  // namespace
+
+TEST(AggregateTest, TestHashAgg) {
+    std::mt19937_64 rng(46);
+    // Few groups, and more groups than the threads pre-aggregate before flushing.
+    for (int64_t cardinality : {7, 20000}) {
+        auto rows = randomRows(rng, 30000, cardinality);
+        auto input = newInput(rows);
+        for (size_t concurrency : {1, 4}) {
+            auto agg = newAgg({AggStrategy::Hash, concurrency, 1024});
+            auto [out, err] = agg->Execute(input);
+            ASSERT_FALSE(err) << err->Message;
+            EXPECT_EQ(agg->Executed(), AggStrategy::Hash);
+            EXPECT_EQ(collect(out), expected(rows)) << cardinality << " " << concurrency;
+            // The chunks are packed.
+            for (size_t i = 0; i + 1 < out.size(); i++) {
+                EXPECT_TRUE(out[i].IsFull());
+            }
+        }
+    }
+}
+
+TEST(AggregateTest, TestStreamAgg) {
+    std::mt19937_64 rng(47);
+    auto rows = randomRows(rng, 5000, 500);
+    std::sort(rows.begin(), rows.end(), [](const row &a, const row &b) {
+        return std::tie(a.K, a.S) < std::tie(b.K, b.S);
+    });
+    auto input = newInput(rows);
+
+    for (auto strategy : {AggStrategy::Auto, AggStrategy::Stream}) {
+        auto agg = newAgg({strategy});
+        auto [out, err] = agg->Execute(input);
+        ASSERT_FALSE(err);
+        EXPECT_EQ(agg->Executed(), AggStrategy::Stream);
+        EXPECT_TRUE(agg->Warnings().empty());
+        std::vector<groupKey> order;
+        EXPECT_EQ(collect(out, &order), expected(rows));
+        // The groups come out sorted, NULL first.
+        EXPECT_TRUE(std::is_sorted(order.begin(), order.end()));
+    }
+
+    // The input is sorted until its last chunks: the groups streamed so far are merged with the hashed ones.
+    auto unsorted = rows;
+    auto tail = randomRows(rng, 300, 500);
+    unsorted.insert(unsorted.end(), tail.begin(), tail.end());
+    input = newInput(unsorted);
+    for (auto strategy : {AggStrategy::Auto, AggStrategy::Stream}) {
+        auto agg = newAgg({strategy});
+        auto [out, err] = agg->Execute(input);
+        ASSERT_FALSE(err);
+        EXPECT_EQ(agg->Executed(), AggStrategy::Hash);
+        EXPECT_EQ(agg->Warnings().size(), strategy == AggStrategy::Stream ? 1u : 0u);
+        EXPECT_EQ(collect(out), expected(unsorted));
+    }
+}
+
+TEST(AggregateTest, TestScalarAgg) {
+    std::mt19937_64 rng(48);
+    auto rows = randomRows(rng, 1000, 10);
+    for (auto strategy : {AggStrategy::Auto, AggStrategy::Hash}) {
+        for (size_t n : {size_t{0}, rows.size()}) {
+            auto [agg, err] = AggExec::New({}, newAggs(), {strategy});
+            ASSERT_FALSE(err);
+            auto [out, execErr] = agg->Execute(newInput({rows.begin(), rows.begin() + static_cast<ptrdiff_t>(n)}));
+            ASSERT_FALSE(execErr);
+            ASSERT_EQ(out.size(), 1u);
+            ASSERT_EQ(out[0].NumRows(), 1u);
+            const auto &chk = out[0];
+            EXPECT_EQ(chk.Col(0).GetInt64(0), static_cast<int64_t>(n));
+            if (n == 0) {
+                EXPECT_EQ(chk.Col(1).GetInt64(0), 0);
+                for (size_t c = 2; c < 6; c++) {
+                    EXPECT_TRUE(chk.Col(c).IsNull(0));
+                }
+                continue;
+            }
+            int64_t sum = 0;
+            for (const auto &r : rows) {
+                sum += r.V;
+            }
+            EXPECT_EQ(chk.Col(2).GetInt64(0), sum);
+            EXPECT_DOUBLE_EQ(chk.Col(3).GetFloat64(0), static_cast<double>(sum) / static_cast<double>(n));
+        }
+    }
+}
+
+TEST(AggregateTest, TestErrors) {
+    // SUM of BIGINT overflows, in a thread or in the merge.
+    const std::vector<uint8_t> types{mysql::TypeLonglong, mysql::TypeVarString, mysql::TypeLonglong,
+                                     mysql::TypeDouble};
+    std::vector<Chunk> input;
+    for (int i = 0; i < 4; i++) {
+        Chunk chk(types);
+        chk.Col(colK).AppendInt64(1);
+        chk.Col(colS).AppendBytes("");
+        chk.Col(colV).AppendInt64(INT64_MAX / 2 + 1);
+        chk.Col(colD).AppendNull();
+        input.push_back(std::move(chk));
+    }
+    for (auto strategy : {AggStrategy::Hash, AggStrategy::Stream}) {
+        std::vector<AggFuncDesc> aggs;
+        aggs.push_back({AggFunc::Sum, col(colV)});
+        auto [agg, err] = AggExec::New({}, std::move(aggs), {strategy});
+        ASSERT_FALSE(err);
+        auto [out, execErr] = agg->Execute(input);
+        ASSERT_TRUE(execErr);
+        EXPECT_EQ(execErr->Message, "BIGINT value is out of range in 'sum(v)'");
+    }
+
+    // A division by zero is a warning, and an error for the writes in the strict mode of the statement.
+    for (auto strategy : {AggStrategy::Hash, AggStrategy::Stream}) {
+        for (bool strict : {false, true}) {
+            std::vector<ExprPtr> args;
+            args.push_back(col(colV));
+            args.push_back(Constant::NewInt(0));
+            auto [div, divErr] = expression::NewFunction(expression::Op::IntDiv, std::move(args));
+            ASSERT_FALSE(divErr);
+            std::vector<ExprPtr> groupBy;
+            groupBy.push_back(std::move(div));
+            AggOptions opts{strategy, 2};
+            if (strict) {
+                opts.Mode = mysql::SQLMode{mysql::ModeStrictAllTables | mysql::ModeErrorForDivisionByZero};
+                opts.InDML = true;
+            }
+            std::vector<AggFuncDesc> aggs;
+            aggs.push_back({AggFunc::Count, nullptr});
+            auto [agg, err] = AggExec::New(std::move(groupBy), std::move(aggs), opts);
+            ASSERT_FALSE(err);
+            auto [out, execErr] = agg->Execute(input);
+            if (strict) {
+                ASSERT_TRUE(execErr);
+                EXPECT_EQ(execErr->Code, mysql::ErrDivisionByZero);
+            } else {
+                ASSERT_FALSE(execErr);
+                ASSERT_FALSE(agg->Warnings().empty());
+                EXPECT_EQ(agg->Warnings()[0].Code, mysql::ErrDivisionByZero);
+            }
+        }
+    }
+
+    std::vector<AggFuncDesc> aggs;
+    aggs.push_back({AggFunc::Max, col(colS)});
+    auto [agg, err] = AggExec::New({}, std::move(aggs));
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrNotSupportedYet);
+}
+
+TEST(AggregateTest, TestHints) {
+    EXPECT_EQ(AggStrategyOfHints("/*+ HASH_AGG() */"), AggStrategy::Hash);
+    EXPECT_EQ(AggStrategyOfHints("/*+ use_index(t, a) stream_agg ( ) */"), AggStrategy::Stream);
+    EXPECT_EQ(AggStrategyOfHints("/*+ HASH_AGG() STREAM_AGG() */"), AggStrategy::Auto);
+    EXPECT_EQ(AggStrategyOfHints("/*+ HASH_AGG */"), AggStrategy::Auto);
+    EXPECT_EQ(AggStrategyOfHints("/*+ HASH_JOIN(t) */"), AggStrategy::Auto);
+}
+
+TEST(AggregateTest, TestApproxAgg) {
+    // The group k = 0 has 60000 distinct values of v, k = 1 has 50 and k = 2 has 5000; d is null in k = 2.
+    std::vector<row> rows;
+    for (int64_t i = 0; i < 180000; i++) {
+        auto k = i % 3;
+        auto v = k == 0 ? i : k == 1 ? i % 50 : (i * 7919) % 5000;
+        rows.push_back({k, "s", v, k == 2 ? std::nullopt : std::optional(static_cast<double>(v) / 2)});
+    }
+    // The sorted values of v of every group, and their number of distinct ones.
+    std::map<int64_t, std::vector<int64_t>> values;
+    for (const auto &r : rows) {
+        values[*r.K].push_back(r.V);
+    }
+    std::map<int64_t, int64_t> distinct;
+    for (auto &[k, vs] : values) {
+        std::sort(vs.begin(), vs.end());
+        auto unique = vs;
+        distinct[k] = std::unique(unique.begin(), unique.end()) - unique.begin();
+    }
+
+    auto check = [&](const std::vector<Chunk> &out) {
+        size_t n = 0;
+        for (const auto &chk : out) {
+            for (size_t i = 0; i < chk.NumRows(); i++, n++) {
+                auto k = chk.Col(0).GetInt64(i);
+                auto estimate = chk.Col(1).GetInt64(i);
+                if (distinct[k] <= 256) {
+                    EXPECT_EQ(estimate, distinct[k]);
+                } else {
+                    EXPECT_NEAR(estimate, distinct[k], distinct[k] * 0.03) << k;
+                }
+                EXPECT_EQ(chk.Col(2).GetInt64(i), 1);
+                // The median of v is within the rank error of the true one.
+                const auto &vs = values[k];
+                auto median = chk.Col(3).GetInt64(i);
+                auto rank = std::lower_bound(vs.begin(), vs.end(), median) - vs.begin();
+                auto upper = std::upper_bound(vs.begin(), vs.end(), median) - vs.begin();
+                EXPECT_LE(static_cast<double>(rank), vs.size() * 0.53) << k;
+                EXPECT_GE(static_cast<double>(upper), vs.size() * 0.47) << k;
+                if (k == 2) {
+                    EXPECT_TRUE(chk.Col(4).IsNull(i));
+                } else {
+                    EXPECT_NEAR(chk.Col(4).GetFloat64(i), static_cast<double>(vs[vs.size() * 9 / 10]) / 2,
+                                static_cast<double>(vs.back()) / 2 * 0.03)
+                        << k;
+                }
+            }
+        }
+        EXPECT_EQ(n, 3u);
+    };
+    auto newApproxAgg = [](AggOptions opts) {
+        std::vector<ExprPtr> groupBy;
+        groupBy.push_back(col(colK));
+        std::vector<AggFuncDesc> aggs;
+        aggs.push_back({AggFunc::ApproxCountDistinct, col(colV)});
+        aggs.push_back({AggFunc::ApproxCountDistinct, col(colS)});
+        aggs.push_back({AggFunc::ApproxPercentile, col(colV), 50});
+        aggs.push_back({AggFunc::ApproxPercentile, col(colD), 90});
+        auto [agg, err] = AggExec::New(std::move(groupBy), std::move(aggs), opts);
+        EXPECT_FALSE(err);
+        return std::move(agg);
+    };
+
+    auto input = newInput(rows);
+    for (size_t concurrency : {1, 4}) {
+        auto agg = newApproxAgg({AggStrategy::Hash, concurrency, 1024});
+        auto [out, err] = agg->Execute(input);
+        ASSERT_FALSE(err);
+        check(out);
+    }
+    std::stable_sort(rows.begin(), rows.end(), [](const row &a, const row &b) { return a.K < b.K; });
+    auto agg = newApproxAgg({AggStrategy::Stream});
+    auto [out, err] = agg->Execute(newInput(rows));
+    ASSERT_FALSE(err);
+    EXPECT_EQ(agg->Executed(), AggStrategy::Stream);
+    check(out);
+
+    std::vector<AggFuncDesc> aggs;
+    aggs.push_back({AggFunc::ApproxPercentile, col(colV), 0});
+    std::tie(agg, err) = AggExec::New({}, std::move(aggs));
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Message, "Incorrect arguments to approx_percentile(v, 0)");
+    aggs.clear();
+    aggs.push_back({AggFunc::ApproxPercentile, col(colS), 50});
+    std::tie(agg, err) = AggExec::New({}, std::move(aggs));
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrNotSupportedYet);
+}
@@ -0,0 +1,212 @@
+#include "executor/analyze.hh"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "parser/mysql/type.hh"
+#include "util/codec/codec.hh"
+
+using namespace executor;
+using expression::ColumnRef;
+using expression::ExprPtr;
+using expression::FieldType;
+using util::chunk::Chunk;
+
+namespace {
+
+const std::vector<uint8_t> types{mysql::TypeLonglong, mysql::TypeVarString};
+
+std::vector<ExprPtr> columns() {
+    std::vector<ExprPtr> columns;
+    columns.push_back(std::make_unique<ColumnRef>(0, FieldType{mysql::TypeLonglong, 0}, "k"));
+    columns.push_back(std::make_unique<ColumnRef>(1, FieldType{mysql::TypeVarString, 0}, "s"));
+    return columns;
+}
+
+std::string intKey(int64_t v) {
+    std::string b(1, static_cast<char>(util::codec::IntFlag));
+    util::codec::EncodeInt(b, v);
+    return b;
+}
+
+std::string bytesKey(std::string_view v) {
+    std::string b(1, static_cast<char>(util::codec::BytesFlag));
+    util::codec::EncodeBytes(b, v);
+    return b;
+}
+
+// table is a skewed table of a BIGINT k and a VARCHAR s: k is 0 for 30% of the rows, 1 to 5 for 5% each, NULL for 5%
+// and one of 20000 other values for the rest; s is "hot" for half of the rows and a unique string for the others.
+struct table {
+    std::vector<std::vector<Chunk>> Regions;
+    std::map<int64_t, uint64_t> K;
+    uint64_t NullK{0};
+    uint64_t Rows{0};
+};
+
+// newTable returns a table of n rows in 8 regions of chunks of up to 1000 rows, every other chunk with a selection of
+// some of them.
+table newTable(size_t n, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    table t;
+    t.Regions.resize(8);
+    for (size_t begin = 0; begin < n; begin += 1000) {
+        auto &region = t.Regions[begin / 1000 % t.Regions.size()];
+        Chunk chk(types);
+        std::vector<uint32_t> sel;
+        bool withSel = begin / 1000 % 2 == 1;
+        for (size_t i = begin; i < std::min(begin + 1000, n); i++) {
+            if (withSel) {
+                chk.Col(0).AppendInt64(-1);
+                chk.Col(1).AppendBytes("unselected");
+                sel.push_back(static_cast<uint32_t>(chk.NumRowsUnfiltered()));
+            }
+            auto p = rng() % 100;
+            std::optional<int64_t> k;
+            if (p < 30) {
+                k = 0;
+            } else if (p < 55) {
+                k = static_cast<int64_t>(p - 30) / 5 + 1;
+            } else if (p >= 60) {
+                k = static_cast<int64_t>(rng() % 20000) + 100;
+            }
+            k ? chk.Col(0).AppendInt64(*k) : chk.Col(0).AppendNull();
+            k ? t.K[*k]++ : t.NullK++;
+            chk.Col(1).AppendBytes(rng() % 2 == 0 ? "hot" : "cold" + std::to_string(i));
+            t.Rows++;
+        }
+        if (withSel) {
+            chk.SetSel(sel);
+        }
+        region.push_back(std::move(chk));
+    }
+    return t;
+}
+
+std::vector<ColumnStats> analyze(const table &t, AnalyzeOptions opts) {
+    auto [analyze, err] = AnalyzeExec::New(columns(), types, opts);
+    EXPECT_FALSE(err);
+    auto [stats, execErr] = analyze->Execute(t.Regions);
+    EXPECT_FALSE(execErr);
+    EXPECT_EQ(stats.size(), 2u);
+    return std::move(stats);
+}
+
+}  // namespace
+
+TEST(AnalyzeTest, TestFullSample) {
+    auto t = newTable(50000, 50);
+    for (size_t concurrency : {1, 4}) {
+        auto stats = analyze(t, {0, 20, 2048, concurrency, 0});
+        const auto &k = stats[0];
+        EXPECT_EQ(k.RowCount, t.Rows);
+        EXPECT_EQ(k.SampleCount, t.Rows);
+        EXPECT_EQ(k.NullCount, t.NullK);
+        ASSERT_EQ(k.TopN.size(), 20u);
+        ASSERT_TRUE(k.Sketch);
+        // The frequent values are counted exactly, the others never below their count.
+        for (int64_t v = 0; v <= 5; v++) {
+            EXPECT_EQ(k.EqualRowCount(intKey(v)), static_cast<double>(t.K[v])) << v;
+        }
+        uint64_t maxRare = 0;
+        for (const auto &[v, count] : t.K) {
+            ASSERT_GE(k.EqualRowCount(intKey(v)), static_cast<double>(count)) << v;
+            maxRare = v > 5 ? std::max(maxRare, count) : maxRare;
+        }
+        EXPECT_LE(k.Sketch->MaxValue(), 2 * maxRare);
+        EXPECT_LE(k.EqualRowCount(intKey(-5)), static_cast<double>(maxRare));
+        EXPECT_NEAR(k.EqualSelectivity(intKey(0)), 0.3, 0.01);
+
+        const auto &s = stats[1];
+        EXPECT_EQ(s.NullCount, 0u);
+        ASSERT_EQ(s.TopN.size(), 1u);
+        EXPECT_EQ(s.TopN[0].Key, bytesKey("hot"));
+        EXPECT_NEAR(s.EqualSelectivity(bytesKey("hot")), 0.5, 0.01);
+        // The unique strings are not kept in the TopN, and keep counters of one bit.
+        EXPECT_LE(s.Sketch->MaxValue(), 1u);
+        EXPECT_EQ(s.EqualRowCount(bytesKey("cold1")), 1.0);
+    }
+}
+
+TEST(AnalyzeTest, TestSample) {
+    auto t = newTable(400000, 51);
+    auto stats = analyze(t, {40000, 20, 2048, 4, 7});
+    const auto &k = stats[0];
+    EXPECT_EQ(k.RowCount, t.Rows);
+    EXPECT_NEAR(static_cast<double>(k.SampleCount), 40000.0, 1000.0);
+    EXPECT_NEAR(static_cast<double>(k.NullCount) / k.SampleCount, static_cast<double>(t.NullK) / t.Rows, 0.01);
+    for (int64_t v = 0; v <= 5; v++) {
+        EXPECT_NEAR(k.EqualRowCount(intKey(v)), static_cast<double>(t.K[v]), t.K[v] * 0.1) << v;
+    }
+    // A rare value is estimated as a few sampled rows at most.
+    EXPECT_LE(k.EqualRowCount(intKey(150)), 10.0 * t.Rows / k.SampleCount);
+    EXPECT_GT(k.EqualRowCount(intKey(-5)), 0.0);
+
+    // The same seed samples the same rows, whatever the concurrency.
+    auto again = analyze(t, {40000, 20, 2048, 1, 7});
+    EXPECT_EQ(again[0].SampleCount, k.SampleCount);
+    EXPECT_EQ(again[0].NullCount, k.NullCount);
+    ASSERT_EQ(again[0].TopN.size(), k.TopN.size());
+    for (size_t i = 0; i < k.TopN.size(); i++) {
+        EXPECT_EQ(again[0].TopN[i].Key, k.TopN[i].Key);
+        EXPECT_EQ(again[0].TopN[i].Count, k.TopN[i].Count);
+    }
+}
+
+TEST(AnalyzeTest, TestSaveLoad) {
+    auto dir = std::filesystem::temp_directory_path() / ("analyze_test_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(dir);
+    auto t = newTable(50000, 52);
+    auto stats = analyze(t, {10000, 20, 512, 0, 0});
+    auto path = (dir / "k").string();
+    ASSERT_FALSE(stats[0].Save(path));
+    auto [loaded, err] = ColumnStats::Load(path);
+    ASSERT_FALSE(err);
+    EXPECT_EQ(loaded.RowCount, stats[0].RowCount);
+    EXPECT_EQ(loaded.SampleCount, stats[0].SampleCount);
+    EXPECT_EQ(loaded.NullCount, stats[0].NullCount);
+    EXPECT_EQ(loaded.TopN.size(), stats[0].TopN.size());
+    EXPECT_EQ(loaded.Sketch->Width(), 512u);
+    for (const auto &[v, count] : t.K) {
+        ASSERT_EQ(loaded.EqualRowCount(intKey(v)), stats[0].EqualRowCount(intKey(v))) << v;
+    }
+
+    // The errors of the files are returned.
+    std::filesystem::resize_file(path, 10);
+    std::tie(loaded, err) = ColumnStats::Load(path);
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrNotFormFile);
+    std::tie(loaded, err) = ColumnStats::Load((dir / "missing").string());
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrCantOpenFile);
+    err = stats[0].Save((dir / "missing" / "k").string());
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrCantCreateFile);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(AnalyzeTest, TestOptions) {
+    auto [analyze, err] = AnalyzeExec::New({}, types);
+    EXPECT_TRUE(err);
+    std::tie(analyze, err) = AnalyzeExec::New(columns(), types, {0, 2000, 2048, 0, 0});
+    EXPECT_TRUE(err);
+    std::tie(analyze, err) = AnalyzeExec::New(columns(), types, {0, 20, 0, 0, 0});
+    EXPECT_TRUE(err);
+
+    // An empty table has no rows of any value.
+    std::tie(analyze, err) = AnalyzeExec::New(columns(), types);
+    ASSERT_FALSE(err);
+    auto [stats, execErr] = analyze->Execute({});
+    ASSERT_FALSE(execErr);
+    EXPECT_EQ(stats[0].RowCount, 0u);
+    EXPECT_EQ(stats[0].EqualSelectivity(intKey(0)), 0.0);
+}
@@ -0,0 +1,296 @@
+#include "executor/join.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "parser/mysql/type.hh"
+
+using namespace executor;
+using expression::ColumnRef;
+using expression::ExprPtr;
+using expression::FieldType;
+using util::chunk::Chunk;
+
+namespace {
+
+// row is a row of an input: a BIGINT key k, BIGINT UNSIGNED on the right, null one time in ten, a VARCHAR key s and
+// a BIGINT payload.
+struct row {
+    std::optional<int64_t> K;
+    std::string S;
+    int64_t Payload;
+};
+
+const std::vector<uint8_t> types{mysql::TypeLonglong, mysql::TypeVarString, mysql::TypeLonglong};
+
+std::vector<row> randomRows(std::mt19937_64 &rng, size_t n, int64_t cardinality) {
+    std::vector<row> rows;
+    for (size_t i = 0; i < n; i++) {
+        auto k = static_cast<int64_t>(rng() % cardinality);
+        rows.push_back({k, std::to_string(k % 2), static_cast<int64_t>(i)});
+        if (rng() % 10 == 0) {
+            rows.back().K.reset();
+        }
+    }
+    return rows;
+}
+
+// newInput returns the rows in chunks of up to 300 rows, every other chunk with a selection of some of them.
+std::vector<Chunk> newInput(const std::vector<row> &rows) {
+    std::vector<Chunk> input;
+    for (size_t begin = 0; begin < rows.size(); begin += 300) {
+        Chunk chk(types);
+        std::vector<uint32_t> sel;
+        for (size_t i = begin; i < std::min(begin + 300, rows.size()); i++) {
+            if (input.size() % 2 == 1) {
+                sel.push_back(static_cast<uint32_t>(chk.NumRows() + 1));
+                chk.Col(0).AppendInt64(rows[i].K.value_or(0));
+                chk.Col(1).AppendBytes(rows[i].S);
+                chk.Col(2).AppendInt64(-1);
+            }
+            rows[i].K ? chk.Col(0).AppendInt64(*rows[i].K) : chk.Col(0).AppendNull();
+            chk.Col(1).AppendBytes(rows[i].S);
+            chk.Col(2).AppendInt64(rows[i].Payload);
+        }
+        if (input.size() % 2 == 1) {
+            chk.SetSel(sel);
+        }
+        input.push_back(std::move(chk));
+    }
+    return input;
+}
+
+std::string format(const row *r) {
+    if (r == nullptr) {
+        return "NULL,NULL,NULL";
+    }
+    return (r->K ? std::to_string(*r->K) : "NULL") + "," + r->S + "," + std::to_string(r->Payload);
+}
+
+// nestedLoopJoin returns the rows of the join of left and right, by nested loops.
+std::vector<std::string> nestedLoopJoin(JoinType tp, const std::vector<row> &left, const std::vector<row> &right) {
+    auto match = [](const row &l, const row &r) { return l.K && r.K && *l.K == *r.K && l.S == r.S; };
+    std::vector<std::string> rows;
+    std::vector<bool> rightMatched(right.size());
+    for (const auto &l : left) {
+        bool found = false;
+        for (size_t j = 0; j < right.size(); j++) {
+            if (match(l, right[j])) {
+                found = true;
+                rightMatched[j] = true;
+                if (tp != JoinType::Semi && tp != JoinType::AntiSemi) {
+                    rows.push_back(format(&l) + "|" + format(&right[j]));
+                }
+            }
+        }
+        if ((tp == JoinType::Semi && found) || (tp == JoinType::AntiSemi && !found)) {
+            rows.push_back(format(&l));
+        } else if (tp == JoinType::LeftOuter && !found) {
+            rows.push_back(format(&l) + "|" + format(nullptr));
+        }
+    }
+    if (tp == JoinType::RightOuter) {
+        for (size_t j = 0; j < right.size(); j++) {
+            if (!rightMatched[j]) {
+                rows.push_back(format(nullptr) + "|" + format(&right[j]));
+            }
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+std::vector<std::string> collect(JoinType tp, const std::vector<Chunk> &out) {
+    std::vector<std::string> rows;
+    for (const auto &chk : out) {
+        EXPECT_LE(chk.NumRows(), util::chunk::defaultCapacity);
+        for (size_t i = 0; i < chk.NumRows(); i++) {
+            std::string s;
+            auto sides = tp == JoinType::Semi || tp == JoinType::AntiSemi || tp == JoinType::NullAwareAntiSemi ? 1 : 2;
+            for (int side = 0; side < sides; side++) {
+                auto c = static_cast<size_t>(side * 3);
+                if (chk.Col(c + 2).IsNull(i)) {
+                    s += format(nullptr);
+                } else {
+                    auto k = chk.Col(c).IsNull(i) ? std::nullopt : std::optional(chk.Col(c).GetInt64(i));
+                    row r{k, std::string(chk.Col(c + 1).GetBytes(i)), chk.Col(c + 2).GetInt64(i)};
+                    s += format(&r);
+                }
+                if (side + 1 < sides) {
+                    s += "|";
+                }
+            }
+            rows.push_back(s);
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+std::unique_ptr<HashJoinExec> newJoin(JoinType tp, JoinOptions opts) {
+    std::vector<ExprPtr> leftKeys, rightKeys;
+    leftKeys.push_back(std::make_unique<ColumnRef>(0, FieldType{mysql::TypeLonglong, 0}, "l.k"));
+    leftKeys.push_back(std::make_unique<ColumnRef>(1, FieldType{mysql::TypeVarString, 0}, "l.s"));
+    rightKeys.push_back(std::make_unique<ColumnRef>(0, FieldType{mysql::TypeLonglong, mysql::UnsignedFlag}, "r.k"));
+    rightKeys.push_back(std::make_unique<ColumnRef>(1, FieldType{mysql::TypeVarString, 0}, "r.s"));
+    auto [join, err] = HashJoinExec::New(tp, std::move(leftKeys), std::move(rightKeys), types, types, opts);
+    EXPECT_FALSE(err);
+    return std::move(join);
+}
+
+}  // namespace
+
+TEST(JoinTest, TestJoinTypes) {
+    std::mt19937_64 rng(47);
+    // A small dimension table with a fact table, both ways, and two inputs of many partitions.
+    std::vector<std::tuple<size_t, size_t, int64_t>> shapes{{3000, 200, 150}, {200, 3000, 150}, {20000, 15000, 8000}};
+    for (auto [numLeft, numRight, cardinality] : shapes) {
+        auto left = randomRows(rng, numLeft, cardinality), right = randomRows(rng, numRight, cardinality);
+        auto leftInput = newInput(left), rightInput = newInput(right);
+        for (auto tp : {JoinType::Inner, JoinType::LeftOuter, JoinType::RightOuter, JoinType::Semi,
+                        JoinType::AntiSemi}) {
+            auto expected = nestedLoopJoin(tp, left, right);
+            for (auto build : {BuildSide::Auto, BuildSide::Left, BuildSide::Right}) {
+                for (size_t concurrency : {1, 4}) {
+                    auto join = newJoin(tp, {build, true, concurrency});
+                    auto [out, err] = join->Execute(leftInput, rightInput);
+                    ASSERT_FALSE(err);
+                    EXPECT_EQ(collect(tp, out), expected)
+                        << numLeft << "x" << numRight << " type " << static_cast<int>(tp) << " build left "
+                        << join->BuiltLeft();
+                    if (build != BuildSide::Auto) {
+                        EXPECT_EQ(join->BuiltLeft(), build == BuildSide::Left);
+                    }
+                    EXPECT_EQ(join->NumPartitions() > 1, numLeft == 20000);
+                }
+            }
+        }
+    }
+}
+
+TEST(JoinTest, TestNotIn) {
+    std::mt19937_64 rng(50);
+    auto left = randomRows(rng, 3000, 300), withNulls = randomRows(rng, 200, 300);
+    std::vector<row> withoutNulls;
+    for (const auto &r : withNulls) {
+        if (r.K) {
+            withoutNulls.push_back(r);
+        }
+    }
+    auto leftInput = newInput(left);
+    for (const auto &right : {withNulls, withoutNulls, std::vector<row>{}}) {
+        // l.k NOT IN (SELECT r.k): true if unequal to every r.k, unknown if equal to none but NULL or compared with
+        // NULL.
+        std::vector<std::string> expected;
+        bool rightNull = std::any_of(right.begin(), right.end(), [](const row &r) { return !r.K; });
+        for (const auto &l : left) {
+            bool found = std::any_of(right.begin(), right.end(), [&](const row &r) { return r.K == l.K; });
+            if (right.empty() || (l.K && !rightNull && !found)) {
+                expected.push_back(format(&l));
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+
+        auto rightInput = newInput(right);
+        for (auto build : {BuildSide::Left, BuildSide::Right}) {
+            for (size_t concurrency : {1, 4}) {
+                std::vector<ExprPtr> leftKeys, rightKeys;
+                leftKeys.push_back(std::make_unique<ColumnRef>(0, FieldType{mysql::TypeLonglong, 0}, "l.k"));
+                rightKeys.push_back(std::make_unique<ColumnRef>(0, FieldType{mysql::TypeLonglong, 0}, "r.k"));
+                auto [join, err] = HashJoinExec::New(JoinType::NullAwareAntiSemi, std::move(leftKeys),
+                                                     std::move(rightKeys), types, types, {build, true, concurrency});
+                ASSERT_FALSE(err);
+                auto [out, execErr] = join->Execute(leftInput, rightInput);
+                ASSERT_FALSE(execErr);
+                EXPECT_EQ(collect(JoinType::NullAwareAntiSemi, out), expected)
+                    << right.size() << " right rows, build left " << join->BuiltLeft();
+            }
+        }
+    }
+
+    std::vector<ExprPtr> leftKeys, rightKeys;
+    for (auto *keys : {&leftKeys, &rightKeys}) {
+        keys->push_back(std::make_unique<ColumnRef>(0, FieldType{mysql::TypeLonglong, 0}, "k"));
+        keys->push_back(std::make_unique<ColumnRef>(1, FieldType{mysql::TypeVarString, 0}, "s"));
+    }
+    auto [join, err] =
+        HashJoinExec::New(JoinType::NullAwareAntiSemi, std::move(leftKeys), std::move(rightKeys), types, types);
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrNotSupportedYet);
+}
+
+TEST(JoinTest, TestBuildSide) {
+    std::mt19937_64 rng(48);
+    auto small = newInput(randomRows(rng, 10, 5)), large = newInput(randomRows(rng, 100, 5));
+    auto join = newJoin(JoinType::Inner, {});
+    ASSERT_FALSE(std::get<1>(join->Execute(small, large)));
+    EXPECT_TRUE(join->BuiltLeft());
+    ASSERT_FALSE(std::get<1>(join->Execute(large, small)));
+    EXPECT_FALSE(join->BuiltLeft());
+
+    // The semi joins build on the right unless SEMIJOIN() lets them build on the smaller input.
+    join = newJoin(JoinType::Semi, JoinOptions::Of(JoinHintsOf("/*+ HASH_JOIN(t1, t2) */")));
+    ASSERT_FALSE(std::get<1>(join->Execute(small, large)));
+    EXPECT_FALSE(join->BuiltLeft());
+    join = newJoin(JoinType::Semi, JoinOptions::Of(JoinHintsOf("/*+ SEMIJOIN() */")));
+    ASSERT_FALSE(std::get<1>(join->Execute(small, large)));
+    EXPECT_TRUE(join->BuiltLeft());
+}
+
+TEST(JoinTest, TestHints) {
+    auto hints = JoinHintsOf("/*+ HASH_JOIN(t1) SWAP_JOIN_INPUTS(t1) */");
+    EXPECT_TRUE(hints.HashJoin);
+    EXPECT_EQ(hints.Build, BuildSide::Left);
+    EXPECT_FALSE(hints.SemiJoin);
+    EXPECT_EQ(JoinHintsOf("/*+ no_swap_join_inputs(t2) */").Build, BuildSide::Right);
+    EXPECT_EQ(JoinHintsOf("/*+ SWAP_JOIN_INPUTS(t1) NO_SWAP_JOIN_INPUTS(t1) */").Build, BuildSide::Auto);
+    EXPECT_TRUE(JoinHintsOf("/*+ SEMIJOIN(FIRSTMATCH) */").SemiJoin);
+    EXPECT_FALSE(JoinHintsOf("/*+ SEMIJOIN() NO_SEMIJOIN() */").SemiJoin);
+    EXPECT_FALSE(JoinHintsOf("/*+ INL_HASH_JOIN(t1) */").HashJoin);
+}
+
+TEST(JoinTest, TestKeyTypes) {
+    std::vector<ExprPtr> leftKeys, rightKeys;
+    leftKeys.push_back(std::make_unique<ColumnRef>(0, FieldType{mysql::TypeLonglong, 0}, "l.k"));
+    rightKeys.push_back(std::make_unique<ColumnRef>(1, FieldType{mysql::TypeVarString, 0}, "r.s"));
+    auto [join, err] = HashJoinExec::New(JoinType::Inner, std::move(leftKeys), std::move(rightKeys), types, types);
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrNotSupportedYet);
+}
+
+TEST(JoinTest, TestSQLMode) {
+    std::mt19937_64 rng(49);
+    auto input = newInput(randomRows(rng, 100, 10));
+    // A division by zero is NULL, and an error for the writes in the strict mode of the statement.
+    for (bool strict : {false, true}) {
+        std::vector<ExprPtr> args, leftKeys, rightKeys;
+        args.push_back(std::make_unique<ColumnRef>(0, FieldType{mysql::TypeLonglong, 0}, "l.k"));
+        args.push_back(expression::Constant::NewInt(0));
+        auto [div, divErr] = expression::NewFunction(expression::Op::IntDiv, std::move(args));
+        ASSERT_FALSE(divErr);
+        leftKeys.push_back(std::move(div));
+        rightKeys.push_back(std::make_unique<ColumnRef>(0, FieldType{mysql::TypeLonglong, 0}, "r.k"));
+        JoinOptions opts;
+        if (strict) {
+            opts.Mode = mysql::SQLMode{mysql::ModeStrictAllTables | mysql::ModeErrorForDivisionByZero};
+            opts.InDML = true;
+        }
+        auto [join, err] =
+            HashJoinExec::New(JoinType::Inner, std::move(leftKeys), std::move(rightKeys), types, types, opts);
+        ASSERT_FALSE(err);
+        auto [out, execErr] = join->Execute(input, input);
+        if (strict) {
+            ASSERT_TRUE(execErr);
+            EXPECT_EQ(execErr->Code, mysql::ErrDivisionByZero);
+        } else {
+            ASSERT_FALSE(execErr);
+            EXPECT_TRUE(out.empty());
+        }
+    }
+}
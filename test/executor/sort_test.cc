@@ -0,0 +1,252 @@
+#include "executor/sort.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "parser/mysql/type.hh"
+
+using namespace executor;
+using expression::ColumnRef;
+using expression::FieldType;
+using util::chunk::Chunk;
+
+namespace {
+
+// row is a row of the input: a BIGINT, a BIGINT UNSIGNED, a DOUBLE and a VARCHAR, each NULL one time in ten, and the
+// index of the row.
+struct row {
+    std::optional<int64_t> I;
+    std::optional<uint64_t> U;
+    std::optional<double> D;
+    std::optional<std::string> S;
+    int64_t Idx;
+};
+
+const std::vector<uint8_t> types{mysql::TypeLonglong, mysql::TypeLonglong, mysql::TypeDouble, mysql::TypeVarString,
+                                 mysql::TypeLonglong};
+
+std::vector<row> randomRows(std::mt19937_64 &rng, size_t n) {
+    std::vector<row> rows;
+    for (size_t i = 0; i < n; i++) {
+        row r{static_cast<int64_t>(rng() % 200) - 100, rng() % 4 == 0 ? UINT64_MAX - rng() % 5 : rng() % 5,
+              static_cast<double>(rng() % 100) / 4 - 10, std::string(rng() % 12, static_cast<char>('a' + rng() % 3)),
+              static_cast<int64_t>(i)};
+        if (rng() % 10 == 0) {
+            r.I.reset();
+        }
+        if (rng() % 10 == 0) {
+            r.U.reset();
+        }
+        if (rng() % 10 == 0) {
+            r.D.reset();
+        }
+        if (rng() % 10 == 0) {
+            r.S.reset();
+        }
+        rows.push_back(std::move(r));
+    }
+    return rows;
+}
+
+// newInput returns the rows in chunks of up to 500 rows, every other chunk with a selection of some of them.
+std::vector<Chunk> newInput(const std::vector<row> &rows) {
+    std::vector<Chunk> input;
+    for (size_t begin = 0; begin < rows.size(); begin += 500) {
+        Chunk chk(types);
+        std::vector<uint32_t> sel;
+        auto append = [&](const row &r, int64_t idx) {
+            r.I ? chk.Col(0).AppendInt64(*r.I) : chk.Col(0).AppendNull();
+            r.U ? chk.Col(1).AppendUint64(*r.U) : chk.Col(1).AppendNull();
+            r.D ? chk.Col(2).AppendFloat64(*r.D) : chk.Col(2).AppendNull();
+            r.S ? chk.Col(3).AppendBytes(*r.S) : chk.Col(3).AppendNull();
+            chk.Col(4).AppendInt64(idx);
+        };
+        for (size_t i = begin; i < std::min(begin + 500, rows.size()); i++) {
+            if (input.size() % 2 == 1) {
+                append(rows[i], -1);
+                sel.push_back(static_cast<uint32_t>(chk.NumRowsUnfiltered()));
+            }
+            append(rows[i], rows[i].Idx);
+        }
+        if (input.size() % 2 == 1) {
+            chk.SetSel(sel);
+        }
+        input.push_back(std::move(chk));
+    }
+    return input;
+}
+
+std::vector<ByItem> byItems(std::span<const std::pair<size_t, bool>> items) {
+    static const std::vector<FieldType> fieldTypes{{mysql::TypeLonglong, 0},
+                                                   {mysql::TypeLonglong, mysql::UnsignedFlag},
+                                                   {mysql::TypeDouble, 0},
+                                                   {mysql::TypeVarString, 0}};
+    std::vector<ByItem> byItems;
+    for (auto [col, desc] : items) {
+        byItems.push_back({std::make_unique<ColumnRef>(col, fieldTypes[col], "c" + std::to_string(col)), desc});
+    }
+    return byItems;
+}
+
+// compare compares the values of a column of a and b like memcmp, a NULL being the least.
+template <typename T>
+int compare(const std::optional<T> &a, const std::optional<T> &b) {
+    if (!a || !b) {
+        return static_cast<int>(a.has_value()) - static_cast<int>(b.has_value());
+    }
+    return *a < *b ? -1 : *b < *a ? 1 : 0;
+}
+
+int compare(const row &a, const row &b, size_t col) {
+    switch (col) {
+        case 0:
+            return compare(a.I, b.I);
+        case 1:
+            return compare(a.U, b.U);
+        case 2:
+            return compare(a.D, b.D);
+        default:
+            return compare(a.S, b.S);
+    }
+}
+
+// checkSorted checks that out holds the rows, ordered by items.
+void checkSorted(const std::vector<row> &rows, const std::vector<Chunk> &out,
+                 std::span<const std::pair<size_t, bool>> items) {
+    std::vector<int64_t> indexes;
+    for (const auto &chk : out) {
+        EXPECT_LE(chk.NumRows(), util::chunk::defaultCapacity);
+        for (size_t i = 0; i < chk.NumRows(); i++) {
+            auto idx = chk.Col(4).GetInt64(i);
+            ASSERT_GE(idx, 0);
+            ASSERT_LT(static_cast<size_t>(idx), rows.size());
+            const auto &r = rows[idx];
+            EXPECT_EQ(chk.Col(0).IsNull(i) ? std::nullopt : std::optional(chk.Col(0).GetInt64(i)), r.I);
+            EXPECT_EQ(chk.Col(3).IsNull(i) ? std::nullopt : std::optional(std::string(chk.Col(3).GetBytes(i))), r.S);
+            if (!indexes.empty()) {
+                const auto &prev = rows[indexes.back()];
+                for (auto [col, desc] : items) {
+                    auto c = compare(prev, r, col);
+                    ASSERT_TRUE(desc ? c >= 0 : c <= 0) << "rows " << prev.Idx << " and " << r.Idx << " column " << col;
+                    if (c != 0) {
+                        break;
+                    }
+                }
+            }
+            indexes.push_back(idx);
+        }
+    }
+    std::sort(indexes.begin(), indexes.end());
+    ASSERT_EQ(indexes.size(), rows.size());
+    for (size_t i = 0; i < indexes.size(); i++) {
+        ASSERT_EQ(indexes[i], static_cast<int64_t>(i));
+    }
+}
+
+}  // namespace
+
+TEST(SortTest, TestSort) {
+    std::mt19937_64 rng(48);
+    auto rows = randomRows(rng, 10000);
+    std::vector<std::vector<std::pair<size_t, bool>>> orders{
+        {{0, false}}, {{1, true}}, {{3, false}, {2, true}}, {{2, false}, {3, true}, {1, false}, {0, true}}};
+    for (const auto &items : orders) {
+        for (size_t concurrency : {1, 4}) {
+            auto [sort, err] = SortExec::New(byItems(items), types, {defaultSortMemQuota, "", concurrency});
+            ASSERT_FALSE(err);
+            auto [out, execErr] = sort->Execute(newInput(rows));
+            ASSERT_FALSE(execErr);
+            EXPECT_EQ(sort->NumRuns(), 0);
+            checkSorted(rows, out, items);
+        }
+    }
+
+    auto [sort, err] = SortExec::New(byItems({}), types);
+    ASSERT_TRUE(err);
+}
+
+TEST(SortTest, TestSpill) {
+    auto dir = std::filesystem::temp_directory_path() / ("sort_test_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(dir);
+    std::mt19937_64 rng(49);
+    auto rows = randomRows(rng, 30000);
+    std::vector<std::pair<size_t, bool>> items{{3, true}, {0, false}};
+    auto [sort, err] = SortExec::New(byItems(items), types, {size_t{1} << 17, dir.string(), 4});
+    ASSERT_FALSE(err);
+    auto [out, execErr] = sort->Execute(newInput(rows));
+    ASSERT_FALSE(execErr);
+    EXPECT_GT(sort->NumRuns(), 4);
+    checkSorted(rows, out, items);
+    // The runs are unlinked once written.
+    EXPECT_TRUE(std::filesystem::is_empty(dir));
+
+    // The rows are merged as they are read, a chunk at a time.
+    std::tie(sort, err) = SortExec::New(byItems(items), types, {size_t{1} << 17, dir.string(), 1});
+    ASSERT_FALSE(err);
+    for (auto &chk : newInput(rows)) {
+        ASSERT_FALSE(sort->Add(std::move(chk)));
+    }
+    out.clear();
+    for (;;) {
+        Chunk chk;
+        ASSERT_FALSE(sort->Next(chk));
+        if (chk.NumRows() == 0) {
+            break;
+        }
+        out.push_back(std::move(chk));
+    }
+    EXPECT_GT(sort->NumRuns(), 4);
+    checkSorted(rows, out, items);
+    Chunk chk;
+    ASSERT_FALSE(sort->Next(chk));
+    EXPECT_EQ(chk.NumRows(), 0u);
+    auto addErr = sort->Add(std::move(newInput(rows)[0]));
+    ASSERT_TRUE(addErr);
+    EXPECT_EQ(addErr->Code, mysql::ErrInternal);
+
+    // Errors of the runs are returned.
+    std::tie(sort, err) = SortExec::New(byItems(items), types, {size_t{1} << 17, (dir / "missing").string(), 1});
+    ASSERT_FALSE(err);
+    std::tie(out, execErr) = sort->Execute(newInput(rows));
+    ASSERT_TRUE(execErr);
+    EXPECT_EQ(execErr->Code, mysql::ErrCantCreateFile);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(SortTest, TestSQLMode) {
+    std::mt19937_64 rng(50);
+    auto rows = randomRows(rng, 100);
+    // A division by zero is NULL, and an error for the writes in the strict mode of the statement.
+    for (bool strict : {false, true}) {
+        std::vector<expression::ExprPtr> args;
+        args.push_back(std::make_unique<ColumnRef>(0, FieldType{mysql::TypeLonglong, 0}, "c0"));
+        args.push_back(expression::Constant::NewInt(0));
+        auto [div, divErr] = expression::NewFunction(expression::Op::IntDiv, std::move(args));
+        ASSERT_FALSE(divErr);
+        std::vector<ByItem> items;
+        items.push_back({std::move(div), false});
+        SortOptions opts;
+        if (strict) {
+            opts.Mode = mysql::SQLMode{mysql::ModeStrictAllTables | mysql::ModeErrorForDivisionByZero};
+            opts.InDML = true;
+        }
+        auto [sort, err] = SortExec::New(std::move(items), types, opts);
+        ASSERT_FALSE(err);
+        auto [out, execErr] = sort->Execute(newInput(rows));
+        if (strict) {
+            ASSERT_TRUE(execErr);
+            EXPECT_EQ(execErr->Code, mysql::ErrDivisionByZero);
+        } else {
+            ASSERT_FALSE(execErr);
+            checkSorted(rows, out, {});
+        }
+    }
+}
@@ -0,0 +1,424 @@
+#include "expression/expression.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "parser/mysql/errcode.hh"
+#include "parser/mysql/type.hh"
+
+using namespace expression;
+using util::chunk::Chunk;
+using util::chunk::Column;
+
+namespace {
+
+// The columns of newChunk.
+enum { colA, colU, colD, colS, colF };
+
+// newChunk returns n rows: a BIGINT i - 5, null every fourth row; u the BIGINT UNSIGNED i; d the DOUBLE i / 2; s the
+// VARCHAR of i % 3 'x', null every fifth row; f the FLOAT i.
+Chunk newChunk(int n) {
+    const std::vector<uint8_t> types{mysql::TypeLonglong, mysql::TypeLonglong, mysql::TypeDouble,
+                                     mysql::TypeVarString, mysql::TypeFloat};
+    Chunk chk(types);
+    for (int i = 0; i < n; i++) {
+        if (i % 4 == 3) {
+            chk.Col(colA).AppendNull();
+        } else {
+            chk.Col(colA).AppendInt64(i - 5);
+        }
+        chk.Col(colU).AppendUint64(i);
+        chk.Col(colD).AppendFloat64(i / 2.0);
+        if (i % 5 == 4) {
+            chk.Col(colS).AppendNull();
+        } else {
+            chk.Col(colS).AppendBytes(std::string(i % 3, 'x'));
+        }
+        chk.Col(colF).AppendFloat32(static_cast<float>(i));
+    }
+    return chk;
+}
+
+ExprPtr col(size_t index) {
+    static const FieldType types[] = {
+        {mysql::TypeLonglong, 0},
+        {mysql::TypeLonglong, mysql::UnsignedFlag},
+        {mysql::TypeDouble, 0},
+        {mysql::TypeVarString, 0},
+        {mysql::TypeFloat, 0},
+    };
+    static const char *names[] = {"a", "u", "d", "s", "f"};
+    return std::make_unique<ColumnRef>(index, types[index], names[index]);
+}
+
+template <typename... Args>
+std::vector<ExprPtr> list(Args... args) {
+    std::vector<ExprPtr> v;
+    (v.push_back(std::move(args)), ...);
+    return v;
+}
+
+template <typename... Args>
+ExprPtr fn(Op op, Args... args) {
+    auto [e, err] = NewFunction(op, list(std::move(args)...));
+    EXPECT_FALSE(err) << err->Message;
+    return std::move(e);
+}
+
+// eval evaluates e for the rows of chk, expecting no error.
+Column eval(EvalContext &ctx, const Expression &e, const Chunk &chk) {
+    auto result = EvalColumn(ctx, e.GetEvalType());
+    auto err = e.VecEval(ctx, chk, Rows::Of(chk), result);
+    EXPECT_FALSE(err) << err->Message;
+    return result;
+}
+
+std::optional<mysql::SQLError> evalErr(EvalContext &ctx, const Expression &e, const Chunk &chk) {
+    auto result = EvalColumn(ctx, e.GetEvalType());
+    return e.VecEval(ctx, chk, Rows::Of(chk), result);
+}
+
+}  // namespace
+
+TEST(ExpressionTest, TestArithmetic) {
+    EvalContext ctx;
+    auto chk = newChunk(20);
+
+    auto plus = fn(Op::Plus, col(colA), Constant::NewInt(10));
+    EXPECT_EQ(plus->String(), "(a + 10)");
+    EXPECT_EQ(plus->GetEvalType(), EvalType::Int);
+    auto r = eval(ctx, *plus, chk);
+    ASSERT_EQ(r.Length(), 20u);
+    EXPECT_EQ(r.NullCount(), 5u);
+    for (size_t i = 0; i < 20; i++) {
+        ASSERT_EQ(r.IsNull(i), i % 4 == 3);
+        if (!r.IsNull(i)) {
+            EXPECT_EQ(r.GetInt64(i), static_cast<int64_t>(i) + 5);
+        }
+    }
+
+    // Int and Real are Real; a FLOAT column is read as a double.
+    auto mul = fn(Op::Mul, col(colA), col(colD));
+    EXPECT_EQ(mul->GetEvalType(), EvalType::Real);
+    r = eval(ctx, *mul, chk);
+    EXPECT_EQ(r.GetFloat64(2), -3 * 1.0);
+    EXPECT_TRUE(r.IsNull(3));
+    r = eval(ctx, *fn(Op::Minus, col(colF), Constant::NewReal(0.5)), chk);
+    EXPECT_EQ(r.GetFloat64(3), 2.5);
+
+    // Division is Real, DIV truncates, and % has the sign of the dividend.
+    r = eval(ctx, *fn(Op::Div, col(colU), Constant::NewInt(4)), chk);
+    EXPECT_EQ(r.GetFloat64(10), 2.5);
+    r = eval(ctx, *fn(Op::IntDiv, col(colA), Constant::NewInt(2)), chk);
+    EXPECT_EQ(r.GetInt64(0), -2);
+    EXPECT_EQ(r.GetInt64(8), 1);
+    r = eval(ctx, *fn(Op::Mod, col(colA), Constant::NewInt(3)), chk);
+    EXPECT_EQ(r.GetInt64(0), -2);
+    EXPECT_EQ(r.GetInt64(9), 1);
+    r = eval(ctx, *fn(Op::Mod, col(colD), Constant::NewReal(2)), chk);
+    EXPECT_EQ(r.GetFloat64(7), 1.5);
+    r = eval(ctx, *fn(Op::IntDiv, col(colD), Constant::NewReal(0.5)), chk);
+    EXPECT_EQ(r.GetInt64(7), 7);
+
+    // NULL is of any type.
+    r = eval(ctx, *fn(Op::Plus, col(colU), Constant::NewNull()), chk);
+    EXPECT_EQ(r.NullCount(), 20u);
+
+    EXPECT_TRUE(ctx.Warnings.empty());
+}
+
+TEST(ExpressionTest, TestOverflow) {
+    EvalContext ctx;
+    auto chk = newChunk(8);
+
+    auto err = evalErr(ctx, *fn(Op::Plus, col(colA), Constant::NewInt(INT64_MAX)), chk);
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrDataOutOfRange);
+    EXPECT_NE(err->Message.find("BIGINT value is out of range in '(a + 9223372036854775807)'"), std::string::npos);
+
+    // Unsigned arithmetic is unsigned: 0 - 1 is out of range, so is a negative sum.
+    auto minus = fn(Op::Minus, col(colU), Constant::NewUint(1));
+    EXPECT_TRUE(minus->Type().IsUnsigned());
+    err = evalErr(ctx, *minus, chk);
+    ASSERT_TRUE(err);
+    EXPECT_NE(err->Message.find("BIGINT UNSIGNED"), std::string::npos);
+    err = evalErr(ctx, *fn(Op::Plus, col(colU), col(colA)), chk);
+    ASSERT_TRUE(err);
+
+    auto r = eval(ctx, *fn(Op::Plus, col(colU), Constant::NewUint(UINT64_MAX - 7)), chk);
+    EXPECT_EQ(r.GetUint64(7), UINT64_MAX);
+    err = evalErr(ctx, *fn(Op::Mul, col(colU), Constant::NewUint(UINT64_MAX / 2)), chk);
+    ASSERT_TRUE(err);
+    err = evalErr(ctx, *fn(Op::IntDiv, Constant::NewInt(INT64_MIN), Constant::NewInt(-1)), chk);
+    ASSERT_TRUE(err);
+    err = evalErr(ctx, *fn(Op::Mul, col(colD), Constant::NewReal(1e308)), chk);
+    ASSERT_TRUE(err);
+    EXPECT_NE(err->Message.find("DOUBLE"), std::string::npos);
+
+    // The rows that are null do not overflow.
+    chk.SetSel({3});
+    r = eval(ctx, *fn(Op::Minus, col(colA), Constant::NewInt(INT64_MIN)), chk);
+    EXPECT_TRUE(r.IsNull(3));
+
+    // NO_UNSIGNED_SUBTRACTION makes the difference signed when the plan is built; the type of a plan built without it
+    // holds whatever the mode of the evaluation.
+    mysql::SQLMode mode{mysql::ModeNoUnsignedSubtraction};
+    auto [signedMinus, e] = NewFunction(Op::Minus, list(col(colU), Constant::NewUint(1)), mode);
+    ASSERT_FALSE(e);
+    EXPECT_FALSE(signedMinus->Type().IsUnsigned());
+    chk.ClearSel();
+    r = eval(ctx, *signedMinus, chk);
+    EXPECT_EQ(r.GetInt64(0), -1);
+    ctx.Mode = mode;
+    err = evalErr(ctx, *minus, chk);
+    ASSERT_TRUE(err);
+    EXPECT_NE(err->Message.find("BIGINT UNSIGNED"), std::string::npos);
+    // A signed difference of unsigned values out of its range.
+    auto [bigMinus, bigErr] = NewFunction(Op::Minus, list(Constant::NewUint(UINT64_MAX), col(colU)), mode);
+    ASSERT_FALSE(bigErr);
+    err = evalErr(ctx, *bigMinus, chk);
+    ASSERT_TRUE(err);
+}
+
+TEST(ExpressionTest, TestDivisionByZero) {
+    auto chk = newChunk(8);
+    auto div = fn(Op::Div, Constant::NewInt(1), col(colU));
+    auto mod = fn(Op::Mod, Constant::NewInt(1), col(colA));
+
+    // A query warns.
+    EvalContext ctx;
+    ctx.Mode = mysql::SQLMode{mysql::ModeStrictTransTables | mysql::ModeErrorForDivisionByZero};
+    auto r = eval(ctx, *div, chk);
+    EXPECT_TRUE(r.IsNull(0));
+    EXPECT_EQ(r.NullCount(), 1u);
+    EXPECT_EQ(r.GetFloat64(4), 0.25);
+    ASSERT_EQ(ctx.Warnings.size(), 1u);
+    EXPECT_EQ(ctx.Warnings[0].Code, mysql::ErrDivisionByZero);
+    r = eval(ctx, *mod, chk);
+    EXPECT_TRUE(r.IsNull(5));
+    EXPECT_EQ(ctx.Warnings.size(), 2u);
+
+    // A write fails in the strict mode with ERROR_FOR_DIVISION_BY_ZERO, and ignores it without.
+    ctx.InDML = true;
+    auto err = evalErr(ctx, *div, chk);
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrDivisionByZero);
+    ctx.Mode = mysql::SQLMode{mysql::ModeErrorForDivisionByZero};
+    r = eval(ctx, *div, chk);
+    EXPECT_TRUE(r.IsNull(0));
+    EXPECT_EQ(ctx.Warnings.size(), 3u);
+    ctx.Mode = mysql::SQLMode{mysql::ModeStrictTransTables};
+    r = eval(ctx, *fn(Op::IntDiv, col(colD), Constant::NewReal(0)), chk);
+    EXPECT_EQ(r.NullCount(), 8u);
+    EXPECT_EQ(ctx.Warnings.size(), 3u);
+
+    // The rows not selected are not divided.
+    ctx.Mode = mysql::SQLMode{mysql::ModeStrictTransTables | mysql::ModeErrorForDivisionByZero};
+    chk.SetSel({1, 2});
+    EXPECT_FALSE(evalErr(ctx, *div, chk));
+}
+
+TEST(ExpressionTest, TestCompare) {
+    EvalContext ctx;
+    auto chk = newChunk(12);
+
+    auto r = eval(ctx, *fn(Op::LT, col(colA), Constant::NewInt(0)), chk);
+    EXPECT_EQ(r.NullCount(), 3u);
+    for (size_t i = 0; i < 12; i++) {
+        if (!r.IsNull(i)) {
+            EXPECT_EQ(r.GetInt64(i), i < 5);
+        }
+    }
+
+    // A negative signed value is less than an unsigned one.
+    r = eval(ctx, *fn(Op::GE, col(colU), col(colA)), chk);
+    EXPECT_EQ(r.GetInt64(0), 1);
+    r = eval(ctx, *fn(Op::LT, Constant::NewUint(UINT64_MAX), Constant::NewInt(-1)), chk);
+    EXPECT_EQ(r.GetInt64(0), 0);
+    r = eval(ctx, *fn(Op::EQ, col(colA), col(colD)), chk);
+    EXPECT_EQ(r.GetInt64(10), 1);
+    EXPECT_EQ(r.GetInt64(9), 0);
+    r = eval(ctx, *fn(Op::NE, col(colS), Constant::NewString("x")), chk);
+    EXPECT_EQ(r.GetInt64(1), 0);
+    EXPECT_EQ(r.GetInt64(2), 1);
+    EXPECT_TRUE(r.IsNull(4));
+    r = eval(ctx, *fn(Op::GT, col(colS), Constant::NewString("")), chk);
+    EXPECT_EQ(r.GetInt64(0), 0);
+    EXPECT_EQ(r.GetInt64(2), 1);
+
+    // <=> is never null.
+    r = eval(ctx, *fn(Op::NullEQ, col(colA), Constant::NewNull()), chk);
+    EXPECT_EQ(r.NullCount(), 0u);
+    EXPECT_EQ(r.GetInt64(3), 1);
+    EXPECT_EQ(r.GetInt64(2), 0);
+    r = eval(ctx, *fn(Op::NullEQ, col(colA), Constant::NewInt(-5)), chk);
+    EXPECT_EQ(r.GetInt64(0), 1);
+    EXPECT_EQ(r.GetInt64(3), 0);
+    r = eval(ctx, *fn(Op::EQ, col(colA), Constant::NewNull()), chk);
+    EXPECT_EQ(r.NullCount(), 12u);
+
+    auto [e, err] = NewFunction(Op::EQ, list(col(colS), col(colA)));
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrNotSupportedYet);
+    std::tie(e, err) = NewFunction(Op::EQ, list(col(colA)));
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrWrongParamcountToNativeFct);
+}
+
+TEST(ExpressionTest, TestLogic) {
+    EvalContext ctx;
+    const std::vector<uint8_t> types{mysql::TypeLonglong, mysql::TypeLonglong};
+    Chunk chk(types);
+    // Every pair of TRUE, FALSE and NULL.
+    for (int i = 0; i < 9; i++) {
+        for (int c = 0; c < 2; c++) {
+            int v = c == 0 ? i / 3 : i % 3;
+            if (v == 2) {
+                chk.Col(c).AppendNull();
+            } else {
+                chk.Col(c).AppendInt64(v * 7);
+            }
+        }
+    }
+    auto x = [] { return std::make_unique<ColumnRef>(0, FieldType{}, "x"); };
+    auto y = [] { return std::make_unique<ColumnRef>(1, FieldType{}, "y"); };
+    // The results, -1 being NULL.
+    auto expect = [&](const ExprPtr &e, std::vector<int> want) {
+        auto r = eval(ctx, *e, chk);
+        for (size_t i = 0; i < want.size(); i++) {
+            EXPECT_EQ(r.IsNull(i) ? -1 : r.GetInt64(i), want[i]) << e->String() << " row " << i;
+        }
+    };
+    expect(fn(Op::LogicAnd, x(), y()), {0, 0, 0, 0, 1, -1, 0, -1, -1});
+    expect(fn(Op::LogicOr, x(), y()), {0, 1, -1, 1, 1, 1, -1, 1, -1});
+    expect(fn(Op::LogicXor, x(), y()), {0, 1, -1, 1, 0, -1, -1, -1, -1});
+    expect(fn(Op::UnaryNot, x()), {1, 1, 1, 0, 0, 0, -1, -1, -1});
+    expect(fn(Op::IsNull, y()), {0, 0, 1, 0, 0, 1, 0, 0, 1});
+    expect(fn(Op::IsNotNull, x()), {1, 1, 1, 1, 1, 1, 0, 0, 0});
+    expect(fn(Op::LogicAnd, x(), Constant::NewNull()), {0, 0, 0, -1, -1, -1, -1, -1, -1});
+    expect(fn(Op::LogicOr, Constant::NewReal(0.5), y()), {1, 1, 1, 1, 1, 1, 1, 1, 1});
+
+    auto chk2 = newChunk(5);
+    auto r = eval(ctx, *fn(Op::IsNull, col(colS)), chk2);
+    EXPECT_EQ(r.GetInt64(4), 1);
+    EXPECT_EQ(r.GetInt64(3), 0);
+}
+
+TEST(ExpressionTest, TestIn) {
+    EvalContext ctx;
+    auto chk = newChunk(40);
+
+    auto in = fn(Op::In, col(colA), Constant::NewInt(-5), Constant::NewInt(3), Constant::NewUint(UINT64_MAX));
+    EXPECT_EQ(in->String(), "(a IN (-5, 3, 18446744073709551615))");
+    auto r = eval(ctx, *in, chk);
+    EXPECT_EQ(r.NullCount(), 10u);
+    for (size_t i = 0; i < 40; i++) {
+        if (!r.IsNull(i)) {
+            EXPECT_EQ(r.GetInt64(i), i == 0 || i == 8) << i;
+        }
+    }
+
+    // A long list is searched; one with NULL is NULL rather than false.
+    std::vector<ExprPtr> args;
+    args.push_back(col(colU));
+    for (int v = 100; v >= 0; v -= 3) {
+        args.push_back(Constant::NewInt(v));
+    }
+    args.push_back(Constant::NewNull());
+    auto [longIn, err] = NewFunction(Op::In, std::move(args));
+    ASSERT_FALSE(err);
+    r = eval(ctx, *longIn, chk);
+    for (size_t i = 0; i < 40; i++) {
+        if (i % 3 == 1) {
+            EXPECT_EQ(r.GetInt64(i), 1) << i;
+        } else {
+            EXPECT_TRUE(r.IsNull(i)) << i;
+        }
+    }
+
+    r = eval(ctx, *fn(Op::In, col(colD), Constant::NewInt(1), Constant::NewReal(2.5)), chk);
+    EXPECT_EQ(r.GetInt64(2), 1);
+    EXPECT_EQ(r.GetInt64(5), 1);
+    EXPECT_EQ(r.GetInt64(3), 0);
+    r = eval(ctx, *fn(Op::In, col(colS), Constant::NewString("xx"), Constant::NewString("")), chk);
+    EXPECT_EQ(r.GetInt64(0), 1);
+    EXPECT_EQ(r.GetInt64(1), 0);
+    EXPECT_TRUE(r.IsNull(4));
+
+    std::tie(longIn, err) = NewFunction(Op::In, list(col(colA), col(colU)));
+    ASSERT_TRUE(err);
+}
+
+TEST(ExpressionTest, TestCase) {
+    EvalContext ctx;
+    auto chk = newChunk(12);
+
+    // CASE WHEN a < 0 THEN u WHEN a < 3 THEN 100 END, NULL for a row no WHEN matches.
+    auto c = fn(Op::Case, fn(Op::LT, col(colA), Constant::NewInt(0)), col(colU),
+                fn(Op::LT, col(colA), Constant::NewInt(3)), Constant::NewUint(100));
+    EXPECT_EQ(c->String(), "CASE WHEN (a < 0) THEN u WHEN (a < 3) THEN 100 END");
+    EXPECT_TRUE(c->Type().IsUnsigned());
+    auto r = eval(ctx, *c, chk);
+    std::vector<int> want{0, 1, 2, -1, 4, 100, 100, -1, -1, -1, -1, -1};
+    for (size_t i = 0; i < want.size(); i++) {
+        EXPECT_EQ(r.IsNull(i) ? -1 : r.GetInt64(i), want[i]) << i;
+    }
+
+    // A branch is not evaluated for the rows it does not return: 1 DIV a is not divided by 0 at a = 0.
+    ctx.InDML = true;
+    ctx.Mode = mysql::SQLMode{mysql::ModeStrictTransTables | mysql::ModeErrorForDivisionByZero};
+    c = fn(Op::Case, fn(Op::EQ, col(colA), Constant::NewInt(0)), Constant::NewInt(-1),
+           fn(Op::IntDiv, Constant::NewInt(10), col(colA)));
+    r = eval(ctx, *c, chk);
+    EXPECT_EQ(r.GetInt64(5), -1);
+    EXPECT_EQ(r.GetInt64(6), 10);
+    EXPECT_EQ(r.GetInt64(0), -2);
+
+    // Int of both signednesses is Real, and strings are strings.
+    c = fn(Op::Case, col(colA), Constant::NewUint(1), Constant::NewInt(-1));
+    EXPECT_EQ(c->GetEvalType(), EvalType::Real);
+    r = eval(ctx, *c, chk);
+    EXPECT_EQ(r.GetFloat64(5), -1.0);
+    EXPECT_EQ(r.GetFloat64(3), -1.0);
+    EXPECT_EQ(r.GetFloat64(4), 1.0);
+    c = fn(Op::Case, fn(Op::GT, col(colD), Constant::NewReal(2)), col(colS),
+           fn(Op::LT, col(colD), Constant::NewReal(1)), Constant::NewNull(), Constant::NewString("else"));
+    EXPECT_EQ(c->GetEvalType(), EvalType::String);
+    chk.SetSel({0, 3, 5, 6, 9});
+    r = eval(ctx, *c, chk);
+    ASSERT_EQ(r.Length(), 12u);
+    EXPECT_TRUE(r.IsNull(0));
+    EXPECT_EQ(r.GetBytes(3), "else");
+    EXPECT_EQ(r.GetBytes(5), "xx");
+    EXPECT_EQ(r.GetBytes(6), "");
+    EXPECT_TRUE(r.IsNull(9));
+
+    auto [e, err] = NewFunction(Op::Case, list(col(colA), col(colS), Constant::NewInt(1)));
+    ASSERT_TRUE(err);
+}
+
+TEST(ExpressionTest, TestFilter) {
+    EvalContext ctx;
+    auto chk = newChunk(30);
+
+    // a > 0 AND u % 2 = 0, then d < 10.
+    std::vector<ExprPtr> conds;
+    conds.push_back(fn(Op::LogicAnd, fn(Op::GT, col(colA), Constant::NewInt(0)),
+                       fn(Op::EQ, fn(Op::Mod, col(colU), Constant::NewInt(2)), Constant::NewInt(0))));
+    conds.push_back(fn(Op::LT, col(colD), Constant::NewReal(10)));
+    ASSERT_FALSE(VectorizedFilter(ctx, conds, chk));
+    std::vector<uint32_t> want{6, 8, 10, 12, 14, 16, 18};
+    ASSERT_TRUE(chk.HasSel());
+    EXPECT_EQ(std::vector<uint32_t>(chk.Sel().begin(), chk.Sel().end()), want);
+
+    // A selection is narrowed, the rows not in it not evaluated.
+    chk.SetSel({1, 3, 7, 8, 9, 25});
+    conds.erase(conds.begin());
+    conds.push_back(fn(Op::IsNotNull, col(colA)));
+    ASSERT_FALSE(VectorizedFilter(ctx, conds, chk));
+    want = {1, 8, 9};
+    EXPECT_EQ(std::vector<uint32_t>(chk.Sel().begin(), chk.Sel().end()), want);
+}
@@ -0,0 +1,229 @@
+#include "expression/jit.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "parser/mysql/type.hh"
+
+using namespace expression;
+using util::chunk::Chunk;
+
+namespace {
+
+// The columns of newChunk.
+enum { colA, colU, colD, colS, colN };
+
+// newChunk returns n random rows of a BIGINT a, a BIGINT UNSIGNED u and a DOUBLE d, null one time in five, a VARCHAR s
+// and a BIGINT n with no null, the values of a, u and d around those the filters compare them with.
+Chunk newChunk(std::mt19937_64 &rng, size_t n) {
+    const std::vector<uint8_t> types{mysql::TypeLonglong, mysql::TypeLonglong, mysql::TypeDouble,
+                                     mysql::TypeVarString, mysql::TypeLonglong};
+    Chunk chk(types);
+    for (size_t i = 0; i < n; i++) {
+        auto v = static_cast<int64_t>(rng() % 41) - 20;
+        for (size_t c = colA; c <= colD; c++) {
+            if (rng() % 5 == 0) {
+                chk.Col(c).AppendNull();
+            } else if (c == colA) {
+                chk.Col(c).AppendInt64(v);
+            } else if (c == colU) {
+                chk.Col(c).AppendUint64(v < 0 ? UINT64_MAX + v + 1 : v);
+            } else {
+                chk.Col(c).AppendFloat64(v / 4.0);
+            }
+        }
+        chk.Col(colS).AppendBytes(std::to_string(v));
+        chk.Col(colN).AppendInt64(v);
+    }
+    return chk;
+}
+
+ExprPtr col(size_t index) {
+    static const FieldType types[] = {
+        {mysql::TypeLonglong, 0},
+        {mysql::TypeLonglong, mysql::UnsignedFlag},
+        {mysql::TypeDouble, 0},
+        {mysql::TypeVarString, 0},
+        {mysql::TypeLonglong, mysql::NotNullFlag},
+    };
+    static const char *names[] = {"a", "u", "d", "s", "n"};
+    return std::make_unique<ColumnRef>(index, types[index], names[index]);
+}
+
+template <typename... Args>
+ExprPtr fn(Op op, Args... args) {
+    std::vector<ExprPtr> v;
+    (v.push_back(std::move(args)), ...);
+    auto [e, err] = NewFunction(op, std::move(v));
+    EXPECT_FALSE(err) << err->Message;
+    return std::move(e);
+}
+
+ExprPtr between(ExprPtr (*c)(), ExprPtr lo, ExprPtr hi) {
+    return fn(Op::LogicAnd, fn(Op::GE, c(), std::move(lo)), fn(Op::LE, c(), std::move(hi)));
+}
+
+std::vector<uint32_t> selOf(const Chunk &chk) { return {chk.Sel().begin(), chk.Sel().end()}; }
+
+}  // namespace
+
+TEST(JitTest, TestFilters) {
+    KernelCache cache;
+    std::vector<std::vector<ExprPtr>> filters;
+    auto add = [&](auto... conds) {
+        std::vector<ExprPtr> v;
+        (v.push_back(std::move(conds)), ...);
+        filters.push_back(std::move(v));
+    };
+    add(fn(Op::GT, col(colA), Constant::NewInt(3)));
+    add(fn(Op::LT, Constant::NewInt(3), col(colA)), fn(Op::NE, col(colN), Constant::NewInt(7)));
+    add(between([] { return col(colA); }, Constant::NewInt(-5), Constant::NewInt(5)),
+        fn(Op::GE, col(colD), Constant::NewReal(-1.5)));
+    add(fn(Op::LE, col(colU), Constant::NewInt(10)), fn(Op::EQ, col(colD), Constant::NewInt(2)));
+    add(fn(Op::GT, col(colU), Constant::NewUint(UINT64_MAX - 4)), fn(Op::IsNotNull, col(colA)));
+    add(fn(Op::IsNull, col(colD)), fn(Op::LT, col(colN), Constant::NewUint(0)));
+    add(fn(Op::IsNull, col(colN)));
+    add(fn(Op::LogicAnd, fn(Op::NE, col(colD), Constant::NewReal(0.25)),
+           fn(Op::LogicAnd, fn(Op::GE, col(colA), Constant::NewInt(INT64_MIN)), fn(Op::IsNull, col(colU)))));
+
+    std::mt19937_64 rng(44);
+    for (const auto &conds : filters) {
+        auto jit = JitFilter::Compile(conds, cache);
+        ASSERT_NE(jit, nullptr) << conds[0]->String();
+        for (int round = 0; round < 20; round++) {
+            auto n = static_cast<size_t>(rng() % 200);
+            // The same batch, for the interpreter.
+            auto copy = rng;
+            auto chk = newChunk(rng, n), expected = newChunk(copy, n);
+            if (round % 2 == 1) {
+                std::vector<uint32_t> sel;
+                for (uint32_t i = 0; i < n; i++) {
+                    if (rng() % 3 != 0) {
+                        sel.push_back(i);
+                    }
+                }
+                chk.SetSel(sel);
+                expected.SetSel(sel);
+            }
+            EvalContext ctx;
+            ASSERT_FALSE(VectorizedFilter(ctx, conds, expected));
+
+            ASSERT_TRUE(jit->Apply(chk));
+            EXPECT_EQ(selOf(chk), selOf(expected)) << jit->Fingerprint() << " round " << round;
+        }
+    }
+    // The filters of the same shape share their kernels.
+    auto size = cache.Size();
+    std::vector<ExprPtr> same;
+    same.push_back(fn(Op::GT, col(colN), Constant::NewInt(-100)));
+    auto jit = JitFilter::Compile(same, cache);
+    ASSERT_NE(jit, nullptr);
+    EXPECT_EQ(jit->Fingerprint(), "i>");
+    Chunk chk = newChunk(rng, 10);
+    ASSERT_TRUE(jit->Apply(chk));
+    EXPECT_EQ(chk.NumRows(), 10u);
+    EXPECT_EQ(cache.Size(), size);
+}
+
+TEST(JitTest, TestNaN) {
+    KernelCache cache;
+    for (auto op : {Op::EQ, Op::NE, Op::LT, Op::LE, Op::GT, Op::GE}) {
+        std::vector<ExprPtr> conds;
+        conds.push_back(fn(op, col(colD), Constant::NewReal(1)));
+        auto jit = JitFilter::Compile(conds, cache);
+        ASSERT_NE(jit, nullptr);
+
+        std::vector<Chunk> chks;
+        for (int i = 0; i < 2; i++) {
+            Chunk chk(std::vector<uint8_t>{mysql::TypeLonglong, mysql::TypeLonglong, mysql::TypeDouble});
+            for (double d : {std::numeric_limits<double>::quiet_NaN(), 0.0, 1.0, 2.0,
+                             -std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity()}) {
+                chk.Col(colA).AppendInt64(0);
+                chk.Col(colU).AppendUint64(0);
+                chk.Col(colD).AppendFloat64(d);
+            }
+            chks.push_back(std::move(chk));
+        }
+        EvalContext ctx;
+        ASSERT_FALSE(VectorizedFilter(ctx, conds, chks[1]));
+        ASSERT_TRUE(jit->Apply(chks[0]));
+        EXPECT_EQ(selOf(chks[0]), selOf(chks[1])) << jit->Fingerprint();
+    }
+}
+
+TEST(JitTest, TestFallback) {
+    KernelCache cache;
+    auto compiles = [&](ExprPtr cond) {
+        std::vector<ExprPtr> conds;
+        conds.push_back(std::move(cond));
+        return JitFilter::Compile(conds, cache) != nullptr;
+    };
+    EXPECT_TRUE(compiles(between([] { return col(colD); }, Constant::NewInt(1), Constant::NewReal(2.5))));
+    // Strings, columns compared with columns or expressions, NULL, OR, and a value of the other signedness out of the
+    // range of the column are interpreted.
+    EXPECT_FALSE(compiles(fn(Op::EQ, col(colS), Constant::NewString("1"))));
+    EXPECT_FALSE(compiles(fn(Op::LT, col(colA), col(colN))));
+    EXPECT_FALSE(compiles(fn(Op::LT, fn(Op::Plus, col(colA), Constant::NewInt(1)), Constant::NewInt(3))));
+    EXPECT_FALSE(compiles(fn(Op::EQ, col(colA), Constant::NewNull())));
+    EXPECT_FALSE(compiles(fn(Op::NullEQ, col(colA), Constant::NewInt(1))));
+    EXPECT_FALSE(compiles(fn(Op::LogicOr, fn(Op::IsNull, col(colA)), fn(Op::IsNull, col(colD)))));
+    EXPECT_FALSE(compiles(fn(Op::GT, col(colU), Constant::NewInt(-1))));
+    EXPECT_FALSE(compiles(fn(Op::GT, col(colA), Constant::NewUint(UINT64_MAX))));
+    EXPECT_FALSE(compiles(fn(Op::GT, col(colA), Constant::NewReal(1.5))));
+    std::vector<ExprPtr> many;
+    for (size_t i = 0; i <= JitFilter::maxPredicates; i++) {
+        many.push_back(fn(Op::IsNotNull, col(colA)));
+    }
+    EXPECT_EQ(JitFilter::Compile(many, cache), nullptr);
+
+    // Filter interprets what it cannot compile.
+    std::vector<ExprPtr> conds;
+    conds.push_back(fn(Op::IsNotNull, col(colA)));
+    conds.push_back(fn(Op::GT, col(colA), Constant::NewReal(1.5)));
+    Filter filter(std::move(conds), cache);
+    EXPECT_FALSE(filter.IsCompiled());
+    EvalContext ctx;
+    std::mt19937_64 rng(45);
+    auto chk = newChunk(rng, 100);
+    ASSERT_FALSE(filter.Apply(ctx, chk));
+    for (auto i : selOf(chk)) {
+        EXPECT_GE(chk.Col(colA).GetInt64(i), 2);
+    }
+
+    conds.clear();
+    conds.push_back(fn(Op::GT, col(colA), Constant::NewInt(1)));
+    Filter compiled(std::move(conds), cache);
+    EXPECT_TRUE(compiled.IsCompiled());
+    auto chk2 = newChunk(rng, 100);
+    ASSERT_FALSE(compiled.Apply(ctx, chk2));
+    for (auto i : selOf(chk2)) {
+        EXPECT_GE(chk2.Col(colA).GetInt64(i), 2);
+    }
+}
+
+TEST(JitTest, TestNullColumn) {
+    // A column of NULLs evaluates as BIGINT but holds no 8-byte values: its comparisons are interpreted.
+    KernelCache cache;
+    auto nullCol = [] { return std::make_unique<ColumnRef>(0, FieldType{mysql::TypeNull, 0}, "n"); };
+    std::vector<ExprPtr> conds;
+    conds.push_back(fn(Op::EQ, nullCol(), Constant::NewInt(1)));
+    EXPECT_EQ(JitFilter::Compile(conds, cache), nullptr);
+    EXPECT_FALSE(Filter(std::move(conds), cache).IsCompiled());
+
+    // IS NULL reads only the validity bitmap.
+    std::vector<ExprPtr> isNull;
+    isNull.push_back(fn(Op::IsNull, nullCol()));
+    auto jit = JitFilter::Compile(isNull, cache);
+    ASSERT_NE(jit, nullptr);
+    Chunk chk(std::vector<uint8_t>{mysql::TypeNull});
+    for (int i = 0; i < 10; i++) {
+        chk.Col(0).AppendNull();
+    }
+    ASSERT_TRUE(jit->Apply(chk));
+    EXPECT_EQ(chk.NumRows(), 10u);
+}
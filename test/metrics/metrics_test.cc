@@ -0,0 +1,87 @@
+#include "metrics/metrics.hh"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace metrics;
+
+namespace {
+Counter testCounter("pxtidb_test_counter_total", "A test counter.", "");
+Gauge testGauge("pxtidb_test_gauge", "A test gauge.", "kind=\"a\"");
+Histogram testHistogram("pxtidb_test_duration_seconds", "A test histogram.", "", 1e-9);
+GaugeFunc testGaugeFunc("pxtidb_test_ratio", "A test function gauge.", "", [] { return 0.25; });
+}  // namespace
+
+TEST(MetricsTest, TestCounter) {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([] {
+            for (int j = 0; j < 10000; j++) {
+                testCounter.Add();
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(testCounter.Value(), 80000);
+
+    testGauge.Inc();
+    std::thread([] { testGauge.Add(5); }).join();
+    std::thread([] { testGauge.Dec(); }).join();
+    EXPECT_EQ(testGauge.Value(), 5);
+}
+
+TEST(MetricsTest, TestBuckets) {
+    for (uint64_t v : {0ull, 1ull, 7ull, 8ull, 9ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, ~0ull}) {
+        auto i = Histogram::bucketIndex(v);
+        ASSERT_LT(i, Histogram::numBuckets);
+        EXPECT_GE(Histogram::bucketUpperBound(i), v);
+        if (i > 0) {
+            EXPECT_LT(Histogram::bucketUpperBound(i - 1), v);
+        }
+        // The bucket is at most 1/8 of the value wide.
+        EXPECT_LE(Histogram::bucketUpperBound(i) - v, v / Histogram::subBuckets);
+    }
+    EXPECT_EQ(Histogram::bucketIndex(~0ull), Histogram::numBuckets - 1);
+}
+
+TEST(MetricsTest, TestHistogram) {
+    EXPECT_EQ(testHistogram.Snapshot().Percentile(0.5), 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([] {
+            for (uint64_t v = 1; v <= 1000; v++) {
+                testHistogram.Observe(v * 1000);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    auto snapshot = testHistogram.Snapshot();
+    EXPECT_EQ(snapshot.Count, 4000);
+    EXPECT_EQ(snapshot.Sum, 4 * 500500 * 1000ull);
+    for (auto [q, expect] : {std::pair{0.5, 500000.0}, {0.9, 900000.0}, {0.99, 990000.0}, {1.0, 1000000.0}}) {
+        auto p = static_cast<double>(snapshot.Percentile(q));
+        EXPECT_GE(p, expect) << q;
+        EXPECT_LE(p, expect * 1.125) << q;
+    }
+}
+
+TEST(MetricsTest, TestWritePrometheus) {
+    std::string out;
+    WritePrometheus(out);
+    EXPECT_NE(out.find("# HELP pxtidb_test_counter_total A test counter.\n"
+                       "# TYPE pxtidb_test_counter_total counter\n"
+                       "pxtidb_test_counter_total "),
+              std::string::npos);
+    EXPECT_NE(out.find("# TYPE pxtidb_test_gauge gauge\npxtidb_test_gauge{kind=\"a\"} "), std::string::npos);
+    EXPECT_NE(out.find("# TYPE pxtidb_test_duration_seconds summary\n"
+                       "pxtidb_test_duration_seconds{quantile=\"0.5\"} "),
+              std::string::npos);
+    EXPECT_NE(out.find("pxtidb_test_duration_seconds_count "), std::string::npos);
+    EXPECT_NE(out.find("# TYPE pxtidb_test_ratio gauge\npxtidb_test_ratio 0.25\n"), std::string::npos);
+}
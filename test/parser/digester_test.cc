@@ -0,0 +1,34 @@
+#include "parser/digester.hh"
+
+#include <gtest/gtest.h>
+
+using namespace parser;
+
+TEST(TestDigester, TestNormalize) {
+    std::vector<std::pair<std::string, std::string>> tests = {
+        {"select 1 from b where a = 1", "select ? from b where a = ?"},
+        {"SELECT 1 FROM b WHERE a = 1", "select ? from b where a = ?"},
+        {"select * from t where a in (1, 2, 3) and b = 'x'", "select * from t where a in ( ... ) and b = ?"},
+        {"select count(*) from t where c = -1 -- comment\n", "select count ( ? ) from t where c = ?"},
+        {"select a from t order by 1, 2 limit ?", "select a from t order by 1 , 2 limit ?"},
+        {"select /*+ use_plan_cache() */ a from t force index(idx) where b = .5",
+         "select a from t where b = ?"},
+        {"select a from t1 straight_join t2", "select a from t1 join t2"},
+        {"insert into t values (1, null), (2, 'b')", "insert into t values ( ... ) , ( ... )"},
+    };
+    for (auto &[sql, normalized] : tests) {
+        EXPECT_EQ(Normalize(sql), normalized) << sql;
+    }
+}
+
+TEST(TestDigester, TestDigest) {
+    auto [normalized1, digest1] = NormalizeDigest("select * from t where a = 1");
+    auto [normalized2, digest2] = NormalizeDigest("SELECT *   FROM t WHERE a = ?");
+    auto [normalized3, digest3] = NormalizeDigest("select * from t where b = 1");
+    EXPECT_EQ(normalized1, normalized2);
+    EXPECT_EQ(digest1, digest2);
+    EXPECT_NE(digest1, digest3);
+    EXPECT_EQ(digest1, DigestNormalized(normalized1));
+    EXPECT_EQ(digest1.String().length(), 32);
+    EXPECT_FALSE(digest1.empty());
+}
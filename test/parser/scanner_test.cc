@@ -427,4 +427,24 @@ TEST(TestScanner, TestStartWithBb) {
         ASSERT_EQ(tok, test.tok);
         ASSERT_EQ(lit, test.expect);
     }
-}
\ No newline at end of file
+}
+
+TEST(TestScanner, TestSplitStatements) {
+    struct {
+        std::string sql;
+        std::vector<std::string_view> expect;
+    } tests[] = {
+        {"", {}},
+        {" ; ;", {}},
+        {"select 1", {"select 1"}},
+        {"select 1;", {"select 1"}},
+        {"select 1; select 2 ;\n select 3", {"select 1", "select 2", "select 3"}},
+        {"insert into t values ('a;b'); select `c;d` from t", {"insert into t values ('a;b')", "select `c;d` from t"}},
+        {"select 1 /* ; */; -- ;\nselect 2 # ;", {"select 1 /* ; */", "-- ;\nselect 2 # ;"}},
+        {"/*!40101 SET NAMES utf8 */; select \"x;\"", {"/*!40101 SET NAMES utf8 */", "select \"x;\""}},
+        {"select 1; select 'unterminated; select 3", {"select 1", "select 'unterminated; select 3"}},
+    };
+    for (auto &test : tests) {
+        EXPECT_EQ(SplitStatements(test.sql), test.expect) << test.sql;
+    }
+}
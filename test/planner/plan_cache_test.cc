@@ -0,0 +1,135 @@
+#include "planner/core/plan_cache.hh"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "parser/token.hh"
+
+using namespace planner::core;
+
+namespace {
+std::shared_ptr<const PlanCacheStmt> mustGet(const std::string &sql) {
+    auto [stmt, err] = GetPlanCacheStmt(sql, mysql::SQLMode{mysql::ModeNone});
+    EXPECT_FALSE(err.has_value()) << err->Error();
+    return stmt;
+}
+
+// lex returns the template of sql without caching it in GlobalPlanCache.
+std::shared_ptr<const PlanCacheStmt> lex(const std::string &sql) {
+    SetPreparedPlanCacheEnabled(false);
+    auto stmt = mustGet(sql);
+    SetPreparedPlanCacheEnabled(true);
+    return stmt;
+}
+}  // namespace
+
+TEST(TestPlanCache, TestTemplate) {
+    auto stmt = mustGet("SELECT a, b FROM t WHERE a = ? AND b IN (?, 1);");
+    EXPECT_EQ(stmt->NumParams(), 2);
+    ASSERT_EQ(stmt->ParamMarkers.size(), 2);
+    EXPECT_EQ(stmt->Tokens[stmt->ParamMarkers[0]].Tok, parser::tok_paramMarker);
+    EXPECT_EQ(stmt->Tokens[0], (StmtToken{parser::tok_selectKwd, "select"}));
+    EXPECT_EQ(stmt->Tokens.back().Lit, ")");
+    EXPECT_EQ(stmt->NormalizedSQL, "select a , b from t where a = ? and b in ( ... )");
+}
+
+TEST(TestPlanCache, TestShared) {
+    auto stmt1 = mustGet("select c from plan_cache_shared where id = ?");
+    auto stmt2 = mustGet("SELECT c\n  FROM plan_cache_shared /* comment */ WHERE id = ?");
+    EXPECT_EQ(stmt1, stmt2);
+
+    // Same digest, different tokens: both are cached as variants of the digest.
+    auto stmt3 = mustGet("select c from plan_cache_shared where id = 1");
+    EXPECT_EQ(stmt3->SQLDigest, stmt1->SQLDigest);
+    EXPECT_NE(stmt3, stmt1);
+    EXPECT_EQ(mustGet("select c from plan_cache_shared where id = 1"), stmt3);
+
+    // The plans depend on the SQL mode: a session of another mode gets its own template.
+    auto [stmt4, err] = GetPlanCacheStmt("select c from plan_cache_shared where id = ?",
+                                         mysql::SQLMode{mysql::ModeNoUnsignedSubtraction});
+    ASSERT_FALSE(err);
+    EXPECT_NE(stmt4, stmt1);
+    EXPECT_EQ(stmt4->SQLDigest, stmt1->SQLDigest);
+}
+
+TEST(TestPlanCache, TestHints) {
+    auto cached = mustGet("select c from plan_cache_hints where id = ?");
+    EXPECT_NE(mustGet("select /*+ IGNORE_PLAN_CACHE() */ c from plan_cache_hints where id = ?"), cached);
+    EXPECT_EQ(mustGet("select /*+ use_plan_cache() */ c from plan_cache_hints where id = ?"), cached);
+
+    SetPreparedPlanCacheEnabled(false);
+    auto stmt1 = mustGet("select c from plan_cache_disabled where id = ?");
+    EXPECT_NE(mustGet("select c from plan_cache_disabled where id = ?"), stmt1);
+    auto stmt2 = mustGet("select /*+ USE_PLAN_CACHE() */ c from plan_cache_disabled where id = ?");
+    EXPECT_EQ(mustGet("select /*+ USE_PLAN_CACHE() */ c from plan_cache_disabled where id = ?"), stmt2);
+    SetPreparedPlanCacheEnabled(true);
+
+    // A hint comment is only an optimizer hint right after SELECT, INSERT, etc.
+    auto stmt3 = mustGet("select c from plan_cache_hints /*+ IGNORE_PLAN_CACHE() */ where id = ?");
+    EXPECT_EQ(stmt3, cached);
+}
+
+TEST(TestPlanCache, TestErrors) {
+    auto [stmt1, err1] = GetPlanCacheStmt("select 1; select 2", mysql::SQLMode{mysql::ModeNone});
+    EXPECT_EQ(stmt1, nullptr);
+    ASSERT_TRUE(err1.has_value());
+    EXPECT_EQ(err1->Code, mysql::ErrUnsupportedPs);
+
+    auto [stmt2, err2] = GetPlanCacheStmt(" -- nothing\n", mysql::SQLMode{mysql::ModeNone});
+    ASSERT_TRUE(err2.has_value());
+    EXPECT_EQ(err2->Code, mysql::ErrEmptyQuery);
+    EXPECT_EQ(err2->Error(), "ERROR 1065 (42000): Query was empty");
+}
+
+TEST(TestPlanCache, TestEvict) {
+    PlanCache cache(4);
+    std::vector<std::shared_ptr<const PlanCacheStmt>> held;
+    for (int i = 0; i < 4; i++) {
+        held.push_back(cache.Put(lex("select " + std::to_string(i) + " from t" + std::to_string(i))));
+    }
+    EXPECT_EQ(cache.Size(), 4);
+    EXPECT_EQ(cache.Misses(), 4);
+
+    // Every template is still held by a session: nothing can be evicted.
+    auto stmt = lex("select 5 from t5");
+    EXPECT_EQ(cache.Put(stmt), stmt);
+    EXPECT_EQ(cache.Size(), 4);
+
+    // A miss evicts one of the templates released to cache its own.
+    held.erase(held.begin(), held.begin() + 2);
+    EXPECT_EQ(cache.Put(stmt), stmt);
+    EXPECT_EQ(cache.Size(), 4);
+    EXPECT_EQ(cache.Put(std::make_shared<PlanCacheStmt>(*stmt)), stmt);
+    EXPECT_EQ(cache.Hits(), 1);
+
+    // The template hit is kept, the other one released is evicted.
+    auto other = lex("select 6 from t6");
+    EXPECT_EQ(cache.Put(other), other);
+    EXPECT_EQ(cache.Put(std::make_shared<PlanCacheStmt>(*stmt)), stmt);
+    EXPECT_EQ(cache.Put(std::make_shared<PlanCacheStmt>(*other)), other);
+    EXPECT_EQ(cache.Hits(), 3);
+    EXPECT_EQ(cache.Size(), 4);
+    for (auto &h : held) {
+        EXPECT_EQ(cache.Put(std::make_shared<PlanCacheStmt>(*h)), h);
+    }
+    EXPECT_EQ(cache.Hits(), 5);
+}
+
+TEST(TestPlanCache, TestConcurrentPut) {
+    PlanCache cache;
+    std::vector<std::shared_ptr<const PlanCacheStmt>> results(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); i++) {
+        threads.emplace_back([&, i] {
+            results[i] = cache.Put(lex("select * from t where a = ?"));
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    for (auto &stmt : results) {
+        EXPECT_EQ(stmt, results[0]);
+    }
+    EXPECT_EQ(cache.Size(), 1);
+}
@@ -0,0 +1,126 @@
+#include "server/compress.hh"
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include "parser/mysql/const.hh"
+#include "server/packetio.hh"
+
+using namespace server;
+
+namespace {
+std::string repetitive(size_t n) {
+    std::string s;
+    while (s.length() < n) {
+        s += "select c1, c2 from t where id = " + std::to_string(s.length()) + ";";
+    }
+    s.resize(n);
+    return s;
+}
+
+std::vector<CompressionAlgorithm> algorithms() {
+    std::vector<CompressionAlgorithm> algs{CompressionAlgorithm::Zlib};
+    if (zstdSupported) {
+        algs.push_back(CompressionAlgorithm::Zstd);
+    }
+    return algs;
+}
+}  // namespace
+
+TEST(CompressTest, TestPayload) {
+    for (auto alg : algorithms()) {
+        for (size_t n : {0, 1, 100, 100000}) {
+            auto src = repetitive(n);
+            std::string compressed("prefix");
+            ASSERT_TRUE(compressPayload(alg, defaultZstdCompressionLevel, src, compressed));
+            EXPECT_EQ(compressed.substr(0, 6), "prefix");
+            if (n == 100000) {
+                EXPECT_LT(compressed.length(), n / 10);
+            }
+            std::string dst;
+            ASSERT_TRUE(decompressPayload(alg, std::string_view(compressed).substr(6), n, dst));
+            EXPECT_EQ(dst, src);
+            // The announced length must match.
+            EXPECT_FALSE(decompressPayload(alg, std::string_view(compressed).substr(6), n + 1, dst));
+        }
+        std::string dst;
+        EXPECT_FALSE(decompressPayload(alg, "not compressed", 14, dst));
+    }
+    if (!zstdSupported) {
+        std::string dst;
+        EXPECT_FALSE(compressPayload(CompressionAlgorithm::Zstd, defaultZstdCompressionLevel, "abc", dst));
+    }
+}
+
+TEST(CompressTest, TestPacketIO) {
+    for (auto alg : algorithms()) {
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        PacketIO writer(fds[0]), reader(fds[1]);
+        writer.setCompression(alg);
+        reader.setCompression(alg);
+
+        // A payload larger than a packet, a payload below the threshold and an incompressible one.
+        auto large = repetitive(mysql::MaxPayloadLen + 1000);
+        std::string small("ping");
+        std::string random(1000, '\0');
+        for (size_t i = 0; i < random.length(); i++) {
+            random[i] = static_cast<char>((i * 2654435761u) >> 13);
+        }
+        std::thread t([&] {
+            writer.writePacket(large);
+            writer.writePacket(small);
+            writer.writePacket(random);
+            EXPECT_TRUE(writer.flush().Run());
+        });
+        std::string data;
+        ASSERT_TRUE(reader.readPacket(data).Run());
+        EXPECT_EQ(data, large);
+        ASSERT_TRUE(reader.readPacket(data).Run());
+        EXPECT_EQ(data, small);
+        ASSERT_TRUE(reader.readPacket(data).Run());
+        EXPECT_EQ(data, random);
+        EXPECT_FALSE(reader.hasBufferedInput());
+        t.join();
+
+        auto written = writer.compressionStats();
+        auto read = reader.compressionStats();
+        EXPECT_EQ(written.BytesWritten, read.BytesRead);
+        EXPECT_EQ(written.WireBytesWritten, read.WireBytesRead);
+        EXPECT_GT(written.Ratio(), 10);
+        EXPECT_GT(written.CompressTime.count(), 0);
+        EXPECT_GT(read.DecompressTime.count(), 0);
+        close(fds[0]);
+        close(fds[1]);
+    }
+}
+
+TEST(CompressTest, TestSequence) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    PacketIO writer(fds[0]), reader(fds[1]);
+    writer.setCompression(CompressionAlgorithm::Zlib);
+    reader.setCompression(CompressionAlgorithm::Zlib);
+
+    // Two flushes make two compressed packets with consecutive sequence ids.
+    writer.writePacket("first");
+    ASSERT_TRUE(writer.flush().Run());
+    writer.writePacket("second");
+    ASSERT_TRUE(writer.flush().Run());
+    std::string data;
+    ASSERT_TRUE(reader.readPacket(data).Run());
+    EXPECT_EQ(data, "first");
+    ASSERT_TRUE(reader.readPacket(data).Run());
+    EXPECT_EQ(data, "second");
+
+    // A new command restarts the sequence on one side only: the other one rejects it.
+    writer.resetSequence();
+    writer.writePacket("third");
+    ASSERT_TRUE(writer.flush().Run());
+    EXPECT_FALSE(reader.readPacket(data).Run());
+    close(fds[0]);
+    close(fds[1]);
+}
@@ -0,0 +1,138 @@
+#include "server/conn_stmt.hh"
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "parser/mysql/const.hh"
+#include "parser/mysql/type.hh"
+#include "server/resultset_encoder.hh"
+#include "server/util.hh"
+
+using namespace server;
+
+namespace {
+// readPackets reads the payloads of the packets io has flushed to fd.
+std::vector<std::string> readPackets(int fd) {
+    uint8_t buf[4096];
+    auto n = read(fd, buf, sizeof(buf));
+    EXPECT_GT(n, 0);
+    std::vector<std::string> packets;
+    ssize_t pos = 0;
+    while (pos < n) {
+        size_t length = buf[pos] | (buf[pos + 1] << 8) | (buf[pos + 2] << 16);
+        packets.emplace_back(reinterpret_cast<const char *>(buf + pos + 4), length);
+        pos += 4 + length;
+    }
+    EXPECT_EQ(pos, n);
+    return packets;
+}
+
+std::string stmtIDBytes(uint32_t stmtID) {
+    std::string data;
+    dumpUint32(data, stmtID);
+    return data;
+}
+
+class ConnStmtTest : public testing::Test {
+protected:
+    void SetUp() override { ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, _fds), 0); }
+
+    void TearDown() override {
+        close(_fds[0]);
+        close(_fds[1]);
+    }
+
+    int _fds[2];
+    uint32_t _capability = mysql::ClientProtocol41 | mysql::ClientDeprecateEOF;
+};
+}  // namespace
+
+TEST_F(ConnStmtTest, TestPrepare) {
+    PacketIO io(_fds[0]);
+    TiDBContext ctx;
+    ASSERT_FALSE(handleStmtPrepare(io, ctx, _capability, "select a from t where a = ? and b > ?"));
+    ASSERT_TRUE(io.flush().Run());
+    auto packets = readPackets(_fds[1]);
+    ASSERT_EQ(packets.size(), 3);
+    EXPECT_EQ(packets[0], std::string("\x00\x01\x00\x00\x00\x00\x00\x02\x00\x00\x00\x00", 12));
+    EXPECT_EQ(ctx.NumStatements(), 1);
+
+    EXPECT_TRUE(handleStmtPrepare(io, ctx, _capability, "select 1; select 2"));
+    EXPECT_EQ(ctx.NumStatements(), 1);
+
+    handleStmtClose(ctx, stmtIDBytes(1));
+    EXPECT_EQ(ctx.NumStatements(), 0);
+}
+
+TEST_F(ConnStmtTest, TestExecute) {
+    PacketIO io(_fds[0]);
+    TiDBContext ctx;
+    auto [stmt, err] = ctx.Prepare("insert into t values (?, ?, ?, ?)");
+    ASSERT_FALSE(err);
+
+    std::string data = stmtIDBytes(stmt->ID());
+    data += '\0';
+    dumpUint32(data, 1);
+    // null bitmap: the third parameter is NULL
+    data += '\x04';
+    // new param bound flag
+    data += '\x01';
+    data += std::string{static_cast<char>(mysql::TypeLonglong), '\x00', static_cast<char>(mysql::TypeTiny),
+                        '\x80', static_cast<char>(mysql::TypeNull), '\x00', static_cast<char>(mysql::TypeDatetime),
+                        '\x00'};
+    dumpUint64(data, -7);
+    data += std::string("\x07\xe5\x07\x0a\x1c\x0a\x0b\x0c", 8);
+
+    handleStmtSendLongData(ctx, stmtIDBytes(stmt->ID()) + std::string("\x01\x00long", 6));
+    std::vector<StmtParam> params;
+    auto exec = [&](PacketIO &io, TiDBStatement &stmt) -> Task<std::optional<mysql::SQLError>> {
+        params = stmt.Params();
+        writeOK(io, _capability, 1, 0, ctx.Status(), 0);
+        co_return std::nullopt;
+    };
+    ASSERT_FALSE(handleStmtExecute(io, ctx, data, exec).Run());
+    ASSERT_TRUE(io.flush().Run());
+    auto packets = readPackets(_fds[1]);
+    ASSERT_EQ(packets.size(), 1);
+    EXPECT_EQ(static_cast<uint8_t>(packets[0][0]), mysql::OKHeader);
+    ASSERT_EQ(params.size(), 4);
+    EXPECT_EQ(params[0], StmtParam(int64_t(-7)));
+    EXPECT_EQ(params[1], StmtParam(std::string("long")));
+    EXPECT_EQ(params[2], StmtParam(std::monostate{}));
+    EXPECT_EQ(params[3], StmtParam(std::string("2021-10-28 10:11:12")));
+    EXPECT_TRUE(stmt->BoundParams()[1] == std::nullopt);
+
+    // The types are omitted by later executions.
+    data = stmtIDBytes(stmt->ID()) + std::string("\x00\x01\x00\x00\x00\x04\x00", 7);
+    dumpUint64(data, 9);
+    data += '\xff';
+    data += '\x00';
+    ASSERT_FALSE(handleStmtExecute(io, ctx, data, exec).Run());
+    EXPECT_EQ(params[0], StmtParam(int64_t(9)));
+    EXPECT_EQ(params[1], StmtParam(uint64_t(255)));
+    EXPECT_EQ(params[3], StmtParam(std::string("0000-00-00 00:00:00")));
+
+    auto execErr = handleStmtExecute(io, ctx, stmtIDBytes(42) + std::string(5, '\0'), exec).Run();
+    ASSERT_TRUE(execErr);
+    EXPECT_EQ(execErr->Code, mysql::ErrUnknownStmtHandler);
+}
+
+TEST(ParseExecArgsTest, TestParseExecArgs) {
+    std::vector<StmtParam> args(1);
+    std::vector<std::optional<std::string>> boundParams(1);
+    std::string duration("\x0c\x01\x01\x00\x00\x00\x02\x03\x04\x05\x00\x00\x00", 13);
+    auto err = parseExecArgs(args, boundParams, std::string(1, '\0'),
+                             std::string{static_cast<char>(mysql::TypeDuration), '\x00'}, duration);
+    ASSERT_FALSE(err);
+    EXPECT_EQ(args[0], StmtParam(std::string("-26:03:04.000005")));
+
+    err = parseExecArgs(args, boundParams, std::string(1, '\0'), std::string("\xf0\x00", 2), "");
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrUnknown);
+
+    err = parseExecArgs(args, boundParams, std::string(1, '\0'),
+                        std::string{static_cast<char>(mysql::TypeLong), '\x00'}, "\x01");
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrMalformedPacket);
+}
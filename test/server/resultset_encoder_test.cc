@@ -0,0 +1,229 @@
+#include "server/resultset_encoder.hh"
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include "parser/mysql/const.hh"
+#include "parser/mysql/type.hh"
+
+using namespace server;
+
+namespace {
+// splitPackets returns the payloads of the packets in buf.
+std::vector<std::string> splitPackets(const uint8_t *buf, size_t len) {
+    std::vector<std::string> packets;
+    size_t pos = 0;
+    while (pos < len) {
+        size_t length = buf[pos] | (buf[pos + 1] << 8) | (buf[pos + 2] << 16);
+        packets.emplace_back(reinterpret_cast<const char *>(buf + pos + 4), length);
+        pos += 4 + length;
+    }
+    EXPECT_EQ(pos, len);
+    return packets;
+}
+
+// parseTextRow decodes a text protocol row, with "NULL" standing for the NULL marker.
+std::vector<std::string> parseTextRow(std::string_view payload) {
+    std::vector<std::string> values;
+    while (!payload.empty()) {
+        auto [value, isNull, n] = parseLengthEncodedBytes(payload);
+        EXPECT_NE(n, 0);
+        values.emplace_back(isNull ? "NULL" : std::string(value));
+        payload.remove_prefix(n);
+    }
+    return values;
+}
+
+ColumnInfo makeColumn(std::string name, uint8_t tp, uint16_t flag = 0) {
+    ColumnInfo column;
+    column.Name = std::move(name);
+    column.Type = tp;
+    column.Flag = flag;
+    column.Decimal = 31;
+    return column;
+}
+
+struct stringColumn {
+    std::string data;
+    std::vector<int64_t> offsets{0};
+
+    explicit stringColumn(const std::vector<std::string> &values) {
+        for (auto &v : values) {
+            data += v;
+            offsets.push_back(data.size());
+        }
+    }
+
+    ColumnVector view(const uint8_t *nullBitmap = nullptr) const { return {nullBitmap, data.data(), offsets.data()}; }
+};
+}  // namespace
+
+TEST(ResultSetEncoderTest, TestLengthEncodedInt) {
+    for (uint64_t n : {0ul, 250ul, 251ul, 0xfffful, 0x10000ul, 0xfffffful, 0x1000000ul, ~0ul}) {
+        std::string buf;
+        dumpLengthEncodedInt(buf, n);
+        EXPECT_EQ(buf.size(), lengthEncodedIntSize(n));
+        auto [num, isNull, size] = parseLengthEncodedInt(buf);
+        EXPECT_EQ(num, n);
+        EXPECT_FALSE(isNull);
+        EXPECT_EQ(size, buf.size());
+    }
+    auto [num, isNull, size] = parseLengthEncodedInt("\xfb");
+    EXPECT_TRUE(isNull);
+    EXPECT_EQ(size, 1);
+}
+
+TEST(ResultSetEncoderTest, TestTextRows) {
+    std::vector<ColumnInfo> columns = {makeColumn("a", mysql::TypeLonglong),
+                                       makeColumn("b", mysql::TypeLonglong, mysql::UnsignedFlag),
+                                       makeColumn("c", mysql::TypeDouble), makeColumn("d", mysql::TypeVarString)};
+    std::vector<int64_t> a = {0, -1, 9223372036854775807, (-9223372036854775807 - 1)};
+    std::vector<int64_t> b = {10, 0, -1, 99};
+    std::vector<double> c = {1.5, 0.1, -2e30, 0};
+    stringColumn d({"hello", "", "x", "y"});
+    uint8_t notNull = 0b0111;  // the last row is NULL in c and d
+
+    ColumnBatch batch;
+    batch.columns = {{nullptr, a.data(), nullptr}, {nullptr, b.data(), nullptr}, {&notNull, c.data(), nullptr},
+                     d.view(&notNull)};
+    batch.numRows = 4;
+
+    ResultSetEncoder encoder(columns, mysql::ClientProtocol41);
+    PacketBuffer buffer;
+    EXPECT_EQ(encoder.encodeTextRows(buffer, batch, 0), 4);
+
+    auto packets = splitPackets(buffer.data(), buffer.size());
+    ASSERT_EQ(packets.size(), 4);
+    EXPECT_EQ(parseTextRow(packets[0]), std::vector<std::string>({"0", "10", "1.5", "hello"}));
+    EXPECT_EQ(parseTextRow(packets[1]), std::vector<std::string>({"-1", "0", "0.1", ""}));
+    EXPECT_EQ(parseTextRow(packets[2]),
+              std::vector<std::string>({"9223372036854775807", "18446744073709551615", "-2e+30", "x"}));
+    EXPECT_EQ(parseTextRow(packets[3]), std::vector<std::string>({"-9223372036854775808", "99", "NULL", "NULL"}));
+    EXPECT_EQ(buffer.sequence(), 4);
+}
+
+TEST(ResultSetEncoderTest, TestBinaryRows) {
+    std::vector<ColumnInfo> columns = {makeColumn("a", mysql::TypeTiny), makeColumn("b", mysql::TypeLong),
+                                       makeColumn("c", mysql::TypeDatetime), makeColumn("d", mysql::TypeDuration),
+                                       makeColumn("e", mysql::TypeVarString)};
+    std::vector<int64_t> a = {-1, 7};
+    std::vector<int64_t> b = {0x01020304, 0};
+    stringColumn c({"2021-10-28 10:11:12.000123", "2021-10-28"});
+    stringColumn d({"-25:00:01", "00:00:00"});
+    stringColumn e({"abc", ""});
+    uint8_t notNull = 0b01;  // the second row is NULL in b and e
+
+    ColumnBatch batch;
+    batch.columns = {{nullptr, a.data(), nullptr}, {&notNull, b.data(), nullptr}, c.view(), d.view(),
+                     e.view(&notNull)};
+    batch.numRows = 2;
+
+    ResultSetEncoder encoder(columns, mysql::ClientProtocol41);
+    PacketBuffer buffer;
+    EXPECT_EQ(encoder.encodeBinaryRows(buffer, batch, 0), 2);
+    auto packets = splitPackets(buffer.data(), buffer.size());
+    ASSERT_EQ(packets.size(), 2);
+
+    std::string row0("\x00\x00", 2);                                              // header, null bitmap
+    row0 += '\xff';                                                               // a
+    row0 += std::string("\x04\x03\x02\x01", 4);                                   // b
+    row0 += std::string("\x0b\xe5\x07\x0a\x1c\x0a\x0b\x0c\x7b\x00\x00\x00", 12);  // c
+    row0 += std::string("\x08\x01\x01\x00\x00\x00\x01\x00\x01", 9);               // d
+    row0 += std::string("\x03" "abc", 4);                                         // e
+    EXPECT_EQ(packets[0], row0);
+
+    // b and e are NULL: bits 3 and 6 of the null bitmap, which is offset by 2.
+    EXPECT_EQ(packets[1], std::string("\x00\x48\x07\x04\xe5\x07\x0a\x1c\x00", 9));
+}
+
+TEST(ResultSetEncoderTest, TestChunk) {
+    std::vector<ColumnInfo> columns = {makeColumn("a", mysql::TypeLong), makeColumn("b", mysql::TypeFloat),
+                                       makeColumn("c", mysql::TypeVarString)};
+    std::vector<uint8_t> types;
+    for (auto &column : columns) {
+        types.push_back(column.Type);
+    }
+    util::chunk::Chunk chk(types);
+    chk.Col(0).AppendInt64(-3);
+    chk.Col(1).AppendFloat32(0.5);
+    chk.Col(2).AppendBytes("abc");
+    chk.Col(0).AppendInt64(4);
+    chk.Col(1).AppendNull();
+    chk.Col(2).AppendNull();
+
+    // The chunk is encoded in place.
+    ResultSetEncoder encoder(columns, mysql::ClientProtocol41);
+    PacketBuffer buffer;
+    EXPECT_EQ(encoder.encodeTextRows(buffer, ColumnBatchOf(chk), 0), 2);
+    auto packets = splitPackets(buffer.data(), buffer.size());
+    ASSERT_EQ(packets.size(), 2);
+    EXPECT_EQ(parseTextRow(packets[0]), std::vector<std::string>({"-3", "0.5", "abc"}));
+    EXPECT_EQ(parseTextRow(packets[1]), std::vector<std::string>({"4", "NULL", "NULL"}));
+}
+
+TEST(ResultSetEncoderTest, TestFlushWhenBufferFull) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    std::vector<ColumnInfo> columns = {makeColumn("a", mysql::TypeLonglong), makeColumn("b", mysql::TypeVarString)};
+    constexpr size_t numRows = 3000;
+    std::vector<int64_t> a(numRows);
+    std::vector<std::string> values(numRows);
+    for (size_t i = 0; i < numRows; i++) {
+        a[i] = i;
+        values[i] = std::string(i % 64, 'x');
+    }
+    stringColumn b(values);
+    ColumnBatch batch;
+    batch.columns = {{nullptr, a.data(), nullptr}, b.view()};
+    batch.numRows = numRows;
+
+    ResultSetEncoder encoder(columns, mysql::ClientProtocol41 | mysql::ClientDeprecateEOF);
+    PacketBuffer small(256);
+    auto next = encoder.encodeTextRows(small, batch, 0);
+    EXPECT_GT(next, 0);
+    EXPECT_LT(next, numRows);
+
+    std::thread writer([&] {
+        PacketIO io(fds[0]);
+        EXPECT_TRUE(encoder.writeRows(io, batch, false).Run());
+        encoder.writeEOF(io, mysql::ServerStatusAutocommit | mysql::ServerMoreResultsExists);
+        EXPECT_TRUE(io.flush().Run());
+        close(fds[0]);
+    });
+
+    PacketIO reader(fds[1]);
+    std::string data;
+    for (size_t i = 0; i < numRows; i++) {
+        ASSERT_TRUE(reader.readPacket(data).Run());
+        EXPECT_EQ(parseTextRow(data), std::vector<std::string>({std::to_string(i), values[i]}));
+    }
+    ASSERT_TRUE(reader.readPacket(data).Run());
+    ASSERT_EQ(data.size(), 7);
+    EXPECT_EQ(static_cast<uint8_t>(data[0]), mysql::EOFHeader);
+    EXPECT_EQ(static_cast<uint8_t>(data[3]), mysql::ServerStatusAutocommit | mysql::ServerMoreResultsExists);
+    EXPECT_FALSE(reader.readPacket(data).Run());
+    writer.join();
+    close(fds[1]);
+}
+
+TEST(ResultSetEncoderTest, TestRowLargerThanBuffer) {
+    std::vector<ColumnInfo> columns = {makeColumn("a", mysql::TypeBlob)};
+    stringColumn a({"small", std::string(1000, 'y'), "small"});
+    ColumnBatch batch;
+    batch.columns = {a.view()};
+    batch.numRows = 3;
+
+    ResultSetEncoder encoder(columns, mysql::ClientProtocol41);
+    PacketBuffer buffer(128);
+    EXPECT_EQ(encoder.encodeTextRows(buffer, batch, 0), 1);
+    buffer.clear();
+    EXPECT_EQ(encoder.encodeTextRows(buffer, batch, 1), 2);
+    EXPECT_EQ(buffer.size(), 4 + 3 + 1000);
+    buffer.clear();
+    EXPECT_EQ(buffer.capacity(), 128);
+    EXPECT_EQ(encoder.encodeTextRows(buffer, batch, 2), 3);
+}
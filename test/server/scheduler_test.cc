@@ -0,0 +1,82 @@
+#include "server/scheduler.hh"
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+
+using namespace server;
+
+namespace {
+DetachedTask count(std::atomic<int> &n) {
+    n++;
+    co_return;
+}
+
+DetachedTask block(std::atomic<bool> &running, std::atomic<bool> &done) {
+    running = true;
+    while (!done) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    co_return;
+}
+
+DetachedTask readOne(Reactor &reactor, int fd, std::atomic<int> &result) {
+    auto events = co_await reactor.WaitFor(fd, EV_READ);
+    char c;
+    result = (events & EV_READ) != 0 && read(fd, &c, 1) == 1 ? c : -1;
+}
+}  // namespace
+
+TEST(SchedulerTest, TestSchedule) {
+    std::atomic<int> n{0};
+    {
+        Scheduler scheduler(4);
+        EXPECT_EQ(scheduler.NumWorkers(), 4);
+        for (int i = 0; i < 10000; i++) {
+            scheduler.Schedule(count(n).handle());
+        }
+    }
+    EXPECT_EQ(n, 10000);
+}
+
+TEST(SchedulerTest, TestSteal) {
+    Scheduler scheduler(2);
+    std::atomic<bool> running{false}, done{false};
+    std::atomic<int> n{0};
+    scheduler.Schedule(block(running, done).handle());
+    while (!running) {
+        std::this_thread::yield();
+    }
+    // Half of these are queued behind the blocked worker: the other one steals them.
+    for (int i = 0; i < 100; i++) {
+        scheduler.Schedule(count(n).handle());
+    }
+    for (int i = 0; i < 5000 && n < 100; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(n, 100);
+    done = true;
+}
+
+TEST(SchedulerTest, TestReactor) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    std::atomic<int> result{0};
+    {
+        Scheduler scheduler(1);
+        Reactor reactor(scheduler);
+        scheduler.Schedule(readOne(reactor, fds[0], result).handle());
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        EXPECT_EQ(result, 0);
+        ASSERT_EQ(write(fds[1], "x", 1), 1);
+        for (int i = 0; i < 5000 && result == 0; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    EXPECT_EQ(result, 'x');
+    close(fds[0]);
+    close(fds[1]);
+}
@@ -0,0 +1,462 @@
+#include "server/server.hh"
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "parser/mysql/const.hh"
+#include "parser/mysql/type.hh"
+#include "server/conn.hh"
+#include "server/resultset_encoder.hh"
+#include "server/util.hh"
+
+using namespace server;
+
+namespace {
+// execResult is the result of the executors of the tests.
+using execResult = Task<std::optional<mysql::SQLError>>;
+
+// testClient is a blocking MySQL client that speaks just enough of the protocol for the tests.
+class testClient {
+public:
+    explicit testClient(uint16_t port) {
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        _connected = connect(_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+        _io = std::make_unique<PacketIO>(_fd);
+    }
+
+    ~testClient() { close(_fd); }
+
+    // handshake reads the initial handshake and logs in with the extra capability, returning the connection id.
+    uint32_t handshake(uint32_t capability = 0) {
+        std::string data;
+        EXPECT_TRUE(_connected);
+        EXPECT_TRUE(_io->readPacket(data).Run());
+        EXPECT_EQ(data[0], '\x0a');
+        auto [version, rest] = parseNullTermString(std::string_view(data).substr(1));
+        EXPECT_EQ(version, mysql::ServerVersion);
+        uint32_t connID;
+        std::memcpy(&connID, rest.data(), 4);
+
+        std::string resp;
+        dumpUint32(resp, mysql::ClientProtocol41 | mysql::ClientSecureConnection | mysql::ClientPluginAuth |
+                             mysql::ClientConnectWithDB | mysql::ClientDeprecateEOF | capability);
+        dumpUint32(resp, mysql::MaxPayloadLen);
+        resp += static_cast<char>(mysql::DefaultCollationID);
+        resp.append(23, '\0');
+        resp += std::string("root\0", 5);
+        resp += '\0';
+        resp += std::string("test\0", 5);
+        resp += std::string("mysql_native_password\0", 22);
+        _io->writePacket(resp);
+        EXPECT_TRUE(_io->flush().Run());
+        EXPECT_EQ(readResponse()[0], mysql::OKHeader);
+        if ((capability & mysql::ClientCompress) != 0) {
+            _io->setCompression(CompressionAlgorithm::Zlib);
+        }
+        return connID;
+    }
+
+    // command sends a command and returns the first packet of the response.
+    std::string command(uint8_t cmd, std::string_view arg = {}) {
+        send(cmd, arg);
+        return readResponse();
+    }
+
+    void send(uint8_t cmd, std::string_view arg = {}) {
+        _io->resetSequence();
+        std::string data(1, static_cast<char>(cmd));
+        data += arg;
+        _io->writePacket(data);
+        EXPECT_TRUE(_io->flush().Run());
+    }
+
+    std::string readResponse() {
+        std::string data;
+        if (!_io->readPacket(data).Run()) {
+            return "";
+        }
+        return data;
+    }
+
+    PacketIO &io() { return *_io; }
+
+private:
+    int _fd;
+    bool _connected;
+    std::unique_ptr<PacketIO> _io;
+};
+
+// httpGet sends a GET request for path to the local port and returns the response.
+std::string httpGet(uint16_t port, std::string_view path) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    std::string resp;
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0) {
+        auto req = "GET " + std::string(path) + " HTTP/1.0\r\n\r\n";
+        EXPECT_EQ(write(fd, req.data(), req.length()), static_cast<ssize_t>(req.length()));
+        char buf[4096];
+        for (ssize_t n; (n = read(fd, buf, sizeof(buf))) > 0;) {
+            resp.append(buf, n);
+        }
+    }
+    close(fd);
+    return resp;
+}
+
+// waitFor polls cond for up to a few seconds.
+template <typename Cond>
+bool waitFor(Cond cond) {
+    for (int i = 0; i < 500 && !cond(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return cond();
+}
+
+Config testConfig(int numWorkers) {
+    Config cfg;
+    cfg.Host = "127.0.0.1";
+    cfg.Port = 0;
+    cfg.NumWorkers = numWorkers;
+    cfg.NumReactors = 2;
+    cfg.StatusPort = 0;
+    cfg.SlowQueryFile = "";
+    return cfg;
+}
+}  // namespace
+
+TEST(ServerTest, TestCommands) {
+    Server svr(testConfig(2));
+    ASSERT_TRUE(svr.Start());
+
+    testClient client(svr.Port());
+    EXPECT_EQ(client.handshake(), 1);
+    EXPECT_EQ(client.command(mysql::ComPing)[0], mysql::OKHeader);
+    EXPECT_EQ(client.command(mysql::ComInitDB, "test")[0], mysql::OKHeader);
+
+    auto resp = client.command(mysql::ComQuery, "select 1");
+    EXPECT_EQ(static_cast<uint8_t>(resp[0]), mysql::ErrHeader);
+    resp = client.command(mysql::ComStmtPrepare, "select ?");
+    EXPECT_EQ(resp.substr(0, 5), std::string("\x00\x01\x00\x00\x00", 5));
+    EXPECT_EQ(client.readResponse().substr(0, 4), "\x03""def");
+
+    resp = client.command(mysql::ComBinlogDump);
+    EXPECT_EQ(static_cast<uint8_t>(resp[0]), mysql::ErrHeader);
+    EXPECT_NE(resp.find("command 18 not supported now"), std::string::npos);
+
+    EXPECT_EQ(client.command(mysql::ComQuit), "");
+    EXPECT_TRUE(waitFor([&] { return svr.NumConnections() == 0; }));
+}
+
+TEST(ServerTest, TestIdleConnections) {
+    Server svr(testConfig(2));
+    ASSERT_TRUE(svr.Start());
+
+    constexpr size_t numConns = 200;
+    std::vector<std::unique_ptr<testClient>> clients;
+    for (size_t i = 0; i < numConns; i++) {
+        clients.push_back(std::make_unique<testClient>(svr.Port()));
+        clients.back()->handshake();
+    }
+    EXPECT_EQ(svr.NumConnections(), numConns);
+    // Every connection is parked in a reactor, the two workers serve them all.
+    for (auto &client : clients) {
+        EXPECT_EQ(client->command(mysql::ComPing)[0], mysql::OKHeader);
+    }
+    clients.resize(numConns / 2);
+    EXPECT_TRUE(waitFor([&] { return svr.NumConnections() == numConns / 2; }));
+
+    // Close shuts down the remaining connections.
+    svr.Close();
+    EXPECT_EQ(svr.NumConnections(), 0);
+    EXPECT_EQ(clients[0]->command(mysql::ComPing), "");
+}
+
+TEST(ServerTest, TestLongQuery) {
+    Server svr(testConfig(2));
+    std::atomic<bool> running{false}, done{false};
+    svr.SetQueryExecutor([&](PacketIO &io, TiDBContext &ctx, uint32_t capability, std::string_view sql) -> execResult {
+        if (sql == "sleep") {
+            running = true;
+            while (!done) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        writeOK(io, capability, 0, 0, ctx.Status(), 0);
+        co_return std::nullopt;
+    });
+    ASSERT_TRUE(svr.Start());
+
+    testClient slow(svr.Port()), fast(svr.Port());
+    slow.handshake();
+    fast.handshake();
+    slow.send(mysql::ComQuery, "sleep");
+    ASSERT_TRUE(waitFor([&] { return running.load(); }));
+    // The long query holds one worker, the other connections keep being served.
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(fast.command(mysql::ComQuery, "select 1")[0], mysql::OKHeader);
+    }
+    done = true;
+    EXPECT_EQ(slow.readResponse()[0], mysql::OKHeader);
+}
+
+TEST(ServerTest, TestSuspendOnFullSocket) {
+    // A single worker: the session writing a result larger than the socket buffers must not hold it while its client
+    // does not read.
+    Server svr(testConfig(1));
+    auto result = std::string(32 << 20, 'x');
+    std::atomic<bool> written{false};
+    svr.SetQueryExecutor([&](PacketIO &io, TiDBContext &, uint32_t, std::string_view) -> execResult {
+        io.writePacket(result);
+        written = true;
+        co_return std::nullopt;
+    });
+    ASSERT_TRUE(svr.Start());
+
+    testClient slow(svr.Port()), fast(svr.Port());
+    slow.handshake();
+    fast.handshake();
+    slow.send(mysql::ComQuery, "large");
+    ASSERT_TRUE(waitFor([&] { return written.load(); }));
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(fast.command(mysql::ComPing)[0], mysql::OKHeader);
+    }
+    EXPECT_EQ(slow.readResponse(), result);
+    EXPECT_EQ(slow.command(mysql::ComPing)[0], mysql::OKHeader);
+}
+
+TEST(ServerTest, TestCompressedProtocol) {
+    Server svr(testConfig(2));
+    auto result = std::string(10000, 'x');
+    svr.SetQueryExecutor([&](PacketIO &io, TiDBContext &, uint32_t, std::string_view sql) -> execResult {
+        io.writePacket(sql == "large" ? result : "small");
+        co_return std::nullopt;
+    });
+    ASSERT_TRUE(svr.Start());
+
+    testClient client(svr.Port()), plain(svr.Port());
+    auto connID = client.handshake(mysql::ClientCompress);
+    auto plainID = plain.handshake();
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(client.command(mysql::ComQuery, "large"), result);
+        EXPECT_EQ(client.command(mysql::ComQuery, "small"), "small");
+        EXPECT_EQ(client.command(mysql::ComPing)[0], mysql::OKHeader);
+    }
+    EXPECT_EQ(plain.command(mysql::ComQuery, "large"), result);
+
+    // The server counts a packet after writing it: the client may read it first.
+    std::unordered_map<uint32_t, CompressionStats> stats;
+    ASSERT_TRUE(waitFor([&] {
+        stats = svr.ConnCompressionStats();
+        return stats[connID].BytesWritten == client.io().compressionStats().BytesRead;
+    }));
+    ASSERT_EQ(stats.size(), 2);
+    EXPECT_EQ(stats[connID].BytesWritten, client.io().compressionStats().BytesRead);
+    EXPECT_EQ(stats[connID].WireBytesWritten, client.io().compressionStats().WireBytesRead);
+    EXPECT_GT(stats[connID].Ratio(), 10);
+    EXPECT_GT(stats[connID].CompressTime.count(), 0);
+    EXPECT_EQ(stats[plainID].WireBytesWritten, 0);
+}
+
+TEST(ServerTest, TestMultiStatements) {
+    Server svr(testConfig(2));
+    std::vector<std::string> executed;
+    svr.SetQueryExecutor([&](PacketIO &io, TiDBContext &ctx, uint32_t capability, std::string_view sql) -> execResult {
+        executed.emplace_back(sql);
+        if (sql == "error") {
+            co_return mysql::NewErr(mysql::ErrUnknown);
+        }
+        writeOK(io, capability, 0, 0, ctx.Status(), 0);
+        co_return std::nullopt;
+    });
+    ASSERT_TRUE(svr.Start());
+    // status returns the status flags of an OK packet without affected rows nor insert id.
+    auto status = [](const std::string &ok) { return static_cast<uint8_t>(ok[3]) | static_cast<uint8_t>(ok[4]) << 8; };
+
+    testClient client(svr.Port());
+    client.handshake(mysql::ClientMultiStatements);
+    auto resp = client.command(mysql::ComQuery, "first; 'second;'; third;");
+    EXPECT_EQ(resp[0], mysql::OKHeader);
+    EXPECT_NE(status(resp) & mysql::ServerMoreResultsExists, 0);
+    resp = client.readResponse();
+    EXPECT_NE(status(resp) & mysql::ServerMoreResultsExists, 0);
+    resp = client.readResponse();
+    EXPECT_EQ(status(resp) & mysql::ServerMoreResultsExists, 0);
+    EXPECT_EQ(executed, (std::vector<std::string>{"first", "'second;'", "third"}));
+
+    // The batch stops at the first error.
+    executed.clear();
+    resp = client.command(mysql::ComQuery, "first; error; third");
+    EXPECT_NE(status(resp) & mysql::ServerMoreResultsExists, 0);
+    EXPECT_EQ(static_cast<uint8_t>(client.readResponse()[0]), mysql::ErrHeader);
+    EXPECT_EQ(executed, (std::vector<std::string>{"first", "error"}));
+    resp = client.command(mysql::ComQuery, "single;");
+    EXPECT_EQ(status(resp) & mysql::ServerMoreResultsExists, 0);
+
+    // A client without the capability cannot send a batch.
+    testClient single(svr.Port());
+    single.handshake();
+    resp = single.command(mysql::ComQuery, "first; second");
+    EXPECT_EQ(static_cast<uint8_t>(resp[0]), mysql::ErrHeader);
+    EXPECT_NE(resp.find("multi-statement"), std::string::npos);
+}
+
+TEST(ServerTest, TestStatus) {
+    Server svr(testConfig(2));
+    ASSERT_TRUE(svr.Start());
+    ASSERT_NE(svr.StatusPort(), 0);
+
+    testClient client(svr.Port());
+    client.handshake();
+    EXPECT_EQ(client.command(mysql::ComPing)[0], mysql::OKHeader);
+    client.command(mysql::ComQuery, "select 1");
+
+    auto resp = httpGet(svr.StatusPort(), "/metrics");
+    EXPECT_EQ(resp.substr(0, 15), "HTTP/1.0 200 OK");
+    EXPECT_NE(resp.find("pxtidb_server_connections 1\n"), std::string::npos);
+    EXPECT_NE(resp.find("pxtidb_server_command_total{type=\"Ping\"} "), std::string::npos);
+    EXPECT_NE(resp.find("pxtidb_server_phase_duration_seconds{phase=\"execute\",quantile=\"0.99\"} "),
+              std::string::npos);
+    EXPECT_NE(resp.find("pxtidb_server_handle_command_duration_seconds_count "), std::string::npos);
+    EXPECT_NE(httpGet(svr.StatusPort(), "/unknown").find("404"), std::string::npos);
+}
+
+TEST(ServerTest, TestSlowQueryLog) {
+    auto path = "/tmp/server_test_slow." + std::to_string(getpid());
+    {
+        auto cfg = testConfig(2);
+        cfg.SlowQueryFile = path;
+        cfg.SlowThreshold = std::chrono::milliseconds(20);
+        Server svr(cfg);
+        svr.SetQueryExecutor(
+            [&](PacketIO &io, TiDBContext &ctx, uint32_t capability, std::string_view sql) -> execResult {
+                if (sql.starts_with("select sleep")) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    ctx.StmtCtx().ResultRows = 3;
+                }
+                writeOK(io, capability, 0, 0, ctx.Status(), 0);
+                co_return std::nullopt;
+            });
+        ASSERT_TRUE(svr.Start());
+        testClient client(svr.Port());
+        client.handshake(mysql::ClientMultiStatements);
+        client.command(mysql::ComQuery, "select 1; select sleep(1) from t where a = 'x'");
+        client.readResponse();
+    }
+    // The server flushes the log when it is destroyed.
+    std::ifstream in(path);
+    std::stringstream log;
+    log << in.rdbuf();
+    EXPECT_NE(log.str().find("# Result_rows: 3\n"), std::string::npos);
+    EXPECT_NE(log.str().find("\nselect sleep ( ? ) from t where a = ?;\n"), std::string::npos) << log.str();
+    EXPECT_EQ(log.str().find("select 1"), std::string::npos);
+    unlink(path.c_str());
+}
+
+TEST(ServerTest, TestStmtSummary) {
+    Server svr(testConfig(2));
+    svr.SetQueryExecutor([&](PacketIO &io, TiDBContext &ctx, uint32_t capability, std::string_view sql) -> execResult {
+        if (sql.starts_with("insert")) {
+            co_return mysql::NewErr(mysql::ErrDupEntry, "1", "PRIMARY");
+        }
+        ctx.StmtCtx().ResultRows = 1;
+        ctx.StmtCtx().ExaminedRows = 10;
+        writeOK(io, capability, 0, 0, ctx.Status(), 0);
+        co_return std::nullopt;
+    });
+    svr.SetStmtExecutor([&](PacketIO &io, TiDBStatement &) -> execResult {
+        writeOK(io, mysql::ClientProtocol41, 0, 0, 0, 0);
+        co_return std::nullopt;
+    });
+    ASSERT_TRUE(svr.Start());
+
+    testClient client(svr.Port());
+    client.handshake(mysql::ClientDeprecateEOF);
+    client.command(mysql::ComInitDB, "test");
+    client.command(mysql::ComQuery, "select * from t where a = 1");
+    client.command(mysql::ComQuery, "SELECT * FROM t WHERE a = 2");
+    client.command(mysql::ComQuery, "insert into t values (1)");
+    client.command(mysql::ComStmtPrepare, "UPDATE t SET b = ? WHERE a = 1");
+    client.readResponse();
+    std::string execute("\x01\x00\x00\x00\x00\x01\x00\x00\x00\x00\x01", 11);
+    execute += static_cast<char>(mysql::TypeLonglong);
+    execute += '\0';
+    dumpUint64(execute, 7);
+    EXPECT_EQ(client.command(mysql::ComStmtExecute, execute)[0], mysql::OKHeader);
+    // An unknown statement is reported too.
+    execute[0] = 42;
+    EXPECT_EQ(static_cast<uint8_t>(client.command(mysql::ComStmtExecute, execute)[0]), mysql::ErrHeader);
+
+    auto records = svr.GetStmtSummary()->Current();
+    ASSERT_EQ(records.size(), 4);
+    std::sort(records.begin(), records.end(), [](auto &a, auto &b) { return a.NormalizedSQL < b.NormalizedSQL; });
+    EXPECT_EQ(records[0].NormalizedSQL, "");
+    EXPECT_EQ(records[0].Stats.Errors,
+              (std::vector<std::pair<uint16_t, uint64_t>>{{mysql::ErrUnknownStmtHandler, 1}}));
+    EXPECT_EQ(records[1].NormalizedSQL, "insert into t values ( ? )");
+    EXPECT_EQ(records[1].Stats.SumErrors, 1);
+    EXPECT_EQ(records[1].Stats.Errors, (std::vector<std::pair<uint16_t, uint64_t>>{{mysql::ErrDupEntry, 1}}));
+    EXPECT_EQ(records[2].SchemaName, "test");
+    EXPECT_EQ(records[2].NormalizedSQL, "select * from t where a = ?");
+    EXPECT_EQ(records[2].Stats.SampleSQL, "select * from t where a = 1");
+    EXPECT_EQ(records[2].Stats.ExecCount, 2);
+    EXPECT_EQ(records[2].Stats.SumErrors, 0);
+    EXPECT_EQ(records[2].Stats.SumResultRows, 2);
+    EXPECT_EQ(records[2].Stats.MaxExaminedRows, 10);
+    EXPECT_EQ(records[3].NormalizedSQL, "update t set b = ? where a = ?");
+    EXPECT_EQ(records[3].Stats.SampleSQL, "UPDATE t SET b = ? WHERE a = 1");
+    EXPECT_TRUE(records[3].Stats.Prepared);
+
+    auto resp = httpGet(svr.StatusPort(), "/statements_summary");
+    EXPECT_EQ(resp.substr(0, 15), "HTTP/1.0 200 OK");
+    EXPECT_NE(resp.find("\"DIGEST_TEXT\":\"select * from t where a = ?\""), std::string::npos) << resp;
+    EXPECT_NE(resp.find("\"ERRORS\":{\"1062\":1}"), std::string::npos) << resp;
+    EXPECT_EQ(resp.find("\"ERRORS\":{\"1062\":1}"), resp.rfind("\"ERRORS\":{\"1062\":1}"));
+    EXPECT_NE(httpGet(svr.StatusPort(), "/statements_summary_history").find("\"EXEC_COUNT\":2"),
+              std::string::npos);
+}
+
+TEST(ServerTest, TestTrace) {
+    auto cfg = testConfig(2);
+    cfg.TraceSampleRate = 0;
+    Server svr(cfg);
+    std::vector<std::string> executed;
+    svr.SetQueryExecutor([&](PacketIO &io, TiDBContext &ctx, uint32_t capability, std::string_view sql) -> execResult {
+        common::tracing::Span span("operator");
+        executed.emplace_back(sql);
+        writeOK(io, capability, 0, 0, ctx.Status(), 0);
+        co_return std::nullopt;
+    });
+    ASSERT_TRUE(svr.Start());
+
+    testClient client(svr.Port());
+    client.handshake();
+    EXPECT_EQ(client.command(mysql::ComQuery, "select 1")[0], mysql::OKHeader);
+    EXPECT_EQ(svr.Traces().Size(), 0);
+    EXPECT_EQ(client.command(mysql::ComQuery, " TRACE select 2")[0], mysql::OKHeader);
+    EXPECT_EQ(executed, (std::vector<std::string>{"select 1", "select 2"}));
+    // The trace is added once the response is sent.
+    ASSERT_TRUE(waitFor([&] { return svr.Traces().Size() == 1; }));
+
+    auto resp = httpGet(svr.StatusPort(), "/debug/trace");
+    EXPECT_EQ(resp.substr(0, 15), "HTTP/1.0 200 OK");
+    for (auto name : {"command", "parse", "statement", "execute", "operator", "flush"}) {
+        EXPECT_NE(resp.find("\"name\":\"" + std::string(name) + "\""), std::string::npos) << name;
+    }
+    EXPECT_NE(resp.find("\"label\":\"Query select 2\""), std::string::npos) << resp;
+}
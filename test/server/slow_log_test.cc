@@ -0,0 +1,77 @@
+#include "server/slow_log.hh"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "metrics/server.hh"
+
+using namespace server;
+
+namespace {
+std::string readFile(const std::string &path) {
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+std::string tempPath(const char *name) { return "/tmp/" + std::string(name) + "." + std::to_string(getpid()); }
+}  // namespace
+
+TEST(SlowQueryLoggerTest, TestLog) {
+    auto path = tempPath("slow_log_test");
+    {
+        SlowQueryLogger logger(path, std::chrono::hours(1));
+        SlowQueryRecord record;
+        record.Time = std::chrono::system_clock::now();
+        record.ConnID = 7;
+        record.QueryTime = std::chrono::milliseconds(1500);
+        record.ResultRows = 42;
+        record.Succ = false;
+        record.SetSQL("select * from t where a = ?");
+        EXPECT_TRUE(logger.Log(record));
+        // The hour-long interval shows that Flush does not wait for it.
+        logger.Flush();
+
+        auto log = readFile(path);
+        EXPECT_EQ(log.substr(0, 8), "# Time: ");
+        EXPECT_NE(log.find("# Conn_ID: 7\n"), std::string::npos);
+        EXPECT_NE(log.find("# Query_time: 1.5\n"), std::string::npos);
+        EXPECT_NE(log.find("# Result_rows: 42\n"), std::string::npos);
+        EXPECT_NE(log.find("# Succ: false\n"), std::string::npos);
+        EXPECT_NE(log.find("\nselect * from t where a = ?;\n"), std::string::npos);
+
+        record.SetSQL(std::string(1000, 'x'));
+        EXPECT_EQ(record.GetSQL().length(), SlowQueryRecord::maxSQLLen);
+    }
+    unlink(path.c_str());
+}
+
+TEST(SlowQueryLoggerTest, TestFull) {
+    auto path = tempPath("slow_log_full_test");
+    {
+        SlowQueryLogger logger(path, std::chrono::hours(1));
+        SlowQueryRecord record;
+        record.SetSQL("select 1");
+        auto dropped = metrics::SlowQueriesDropped.Value();
+        // The background thread only drains on Flush: the ring fills up and the extra records are dropped.
+        for (size_t i = 0; i < SlowQueryLogger::ringSize; i++) {
+            EXPECT_TRUE(logger.Log(record));
+        }
+        EXPECT_FALSE(logger.Log(record));
+        EXPECT_EQ(metrics::SlowQueriesDropped.Value(), dropped + 1);
+        logger.Flush();
+        EXPECT_TRUE(logger.Log(record));
+    }
+    // The destructor writes what is left.
+    size_t n = 0;
+    std::ifstream in(path);
+    for (std::string line; std::getline(in, line);) {
+        n += line == "select 1;";
+    }
+    EXPECT_EQ(n, SlowQueryLogger::ringSize + 1);
+    unlink(path.c_str());
+}
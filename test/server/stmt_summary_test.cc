@@ -0,0 +1,159 @@
+#include "server/stmt_summary.hh"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace server;
+using namespace std::chrono_literals;
+
+namespace {
+
+// at returns the time point d after the epoch.
+std::chrono::system_clock::time_point at(std::chrono::system_clock::duration d) {
+    return std::chrono::system_clock::time_point(d);
+}
+
+StmtExecInfo execInfo(const std::string &normalized, std::chrono::system_clock::time_point start,
+                      std::chrono::nanoseconds latency) {
+    StmtExecInfo info;
+    info.Digest = parser::DigestNormalized(normalized);
+    info.SchemaName = "test";
+    info.NormalizedSQL = normalized;
+    info.SampleSQL = normalized;
+    info.StartTime = start;
+    info.Latency = latency;
+    return info;
+}
+
+}  // namespace
+
+TEST(StmtSummaryTest, TestAggregate) {
+    StmtSummary summary(60s);
+    for (int i = 1; i <= 100; i++) {
+        auto info = execInfo("select ?", at(10s), std::chrono::milliseconds(i));
+        info.ResultRows = i;
+        info.ErrorCode = i % 10 == 0 ? 1062 : (i % 25 == 0 ? 1146 : 0);
+        summary.Add(info);
+    }
+    // Another schema is another statement.
+    auto info = execInfo("select ?", at(10s), 1ms);
+    info.SchemaName = "mysql";
+    summary.Add(info);
+    EXPECT_EQ(summary.NumStmts(), 2);
+
+    auto records = summary.Current(at(30s));
+    ASSERT_EQ(records.size(), 2);
+    auto &r = records[0];
+    EXPECT_EQ(r.SchemaName, "test");
+    EXPECT_EQ(r.Begin, at(0s));
+    EXPECT_EQ(r.End, at(60s));
+    EXPECT_EQ(r.Stats.ExecCount, 100);
+    EXPECT_EQ(r.Stats.SumLatency, 5050ms);
+    EXPECT_EQ(r.Stats.MaxLatency, 100ms);
+    EXPECT_EQ(r.Stats.MinLatency, 1ms);
+    EXPECT_EQ(r.Stats.SumResultRows, 5050);
+    EXPECT_EQ(r.Stats.MaxResultRows, 100);
+    EXPECT_EQ(r.Stats.SumErrors, 12);
+    EXPECT_EQ(r.Stats.Errors, (std::vector<std::pair<uint16_t, uint64_t>>{{1062, 10}, {1146, 2}}));
+    // The percentiles are within the precision of the buckets.
+    EXPECT_GE(r.Stats.LatencyPercentile(0.5), 50ms);
+    EXPECT_LE(r.Stats.LatencyPercentile(0.5), 50ms * 9 / 8);
+    EXPECT_GE(r.Stats.LatencyPercentile(0.99), 99ms);
+    EXPECT_EQ(r.Stats.LatencyPercentile(1), 100ms);
+    EXPECT_EQ(records[1].SchemaName, "mysql");
+}
+
+TEST(StmtSummaryTest, TestWindows) {
+    StmtSummary summary(60s, 2);
+    summary.Add(execInfo("select ?", at(10s), 1ms));
+    summary.Add(execInfo("select ?", at(70s), 2ms));
+    summary.Add(execInfo("select ?", at(80s), 3ms));
+    summary.Add(execInfo("update t set a = ?", at(80s), 3ms));
+
+    EXPECT_TRUE(summary.Current(at(130s)).empty());
+    auto records = summary.Current(at(119s));
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(records[0].NormalizedSQL, "select ?");
+    EXPECT_EQ(records[0].Stats.ExecCount, 2);
+
+    auto history = summary.History();
+    ASSERT_EQ(history.size(), 3);
+    EXPECT_EQ(history[0].Begin, at(0s));
+    EXPECT_EQ(history[0].Stats.ExecCount, 1);
+    EXPECT_EQ(history[1].Begin, at(60s));
+
+    // Only the last two windows are kept.
+    summary.Add(execInfo("select ?", at(130s), 1ms));
+    history = summary.History();
+    ASSERT_EQ(history.size(), 3);
+    EXPECT_EQ(history[0].Begin, at(60s));
+    EXPECT_EQ(history[2].Begin, at(120s));
+}
+
+TEST(StmtSummaryTest, TestEvict) {
+    StmtSummary summary(60s, 24, 16);
+    for (int i = 0; i < 40; i++) {
+        summary.Add(execInfo("select " + std::to_string(i), at(std::chrono::seconds(i)), 1ms));
+    }
+    EXPECT_LE(summary.NumStmts(), 16);
+
+    auto records = summary.Current(at(59s));
+    ASSERT_EQ(records.size(), summary.NumStmts() + 1);
+    auto &others = records.back();
+    EXPECT_TRUE(others.IsOthers());
+    EXPECT_EQ(others.Stats.ExecCount, 40 - summary.NumStmts());
+    // The statements executed the longest ago were evicted.
+    EXPECT_EQ(others.Stats.LastSeen, at(std::chrono::seconds(40 - summary.NumStmts() - 1)));
+    for (size_t i = 0; i < records.size() - 1; i++) {
+        EXPECT_FALSE(records[i].IsOthers());
+        EXPECT_GE(records[i].Stats.FirstSeen, at(std::chrono::seconds(40 - summary.NumStmts())));
+    }
+
+    std::string out;
+    WriteStmtSummaryJSON(records, out);
+    EXPECT_NE(out.find("\"DIGEST\":null"), std::string::npos);
+    EXPECT_NE(out.find("\"DIGEST_TEXT\":\"select 39\""), std::string::npos);
+}
+
+TEST(StmtSummaryTest, TestConcurrent) {
+    constexpr int numThreads = 4;
+    constexpr int perThread = 20000;
+    StmtSummary summary(60s, 24, 32);
+    auto now = std::chrono::system_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < perThread; i++) {
+                // More statements than the summary holds: the sessions keep evicting while the others update.
+                summary.Add(execInfo("select " + std::to_string((i + t) % 64), now, 1us));
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    uint64_t n = 0;
+    for (auto &r : summary.Current(now)) {
+        n += r.Stats.ExecCount;
+    }
+    EXPECT_EQ(n, numThreads * perThread);
+}
+
+TEST(StmtSummaryTest, TestJSON) {
+    StmtSummary summary;
+    auto info = execInfo("select ?", std::chrono::system_clock::now(), 1ms);
+    info.SampleSQL = "select \"a\\b\"\n";
+    summary.Add(info);
+    // Invalid UTF-8 is replaced.
+    info = execInfo("select ?, ?", std::chrono::system_clock::now(), 1ms);
+    info.SampleSQL = "select 1, '\xff'";
+    summary.Add(info);
+    std::string out;
+    WriteStmtSummaryJSON(summary.Current(), out);
+    EXPECT_NE(out.find(R"("QUERY_SAMPLE_TEXT":"select \"a\\b\"\n")"), std::string::npos) << out;
+    EXPECT_NE(out.find("\"EXEC_COUNT\":1,"), std::string::npos);
+    EXPECT_NE(out.find("select 1, '\xef\xbf\xbd'"), std::string::npos) << out;
+    EXPECT_EQ(out.back(), ']');
+}
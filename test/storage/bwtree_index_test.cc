@@ -0,0 +1,339 @@
+#include "storage/index/bwtree_index.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace storage::index;
+
+namespace {
+
+Key<16> bytesKey(std::string_view bytes) { return *Key<16>::FromBytes(bytes); }
+
+template <typename KeyType, typename ValueType>
+std::vector<ValueType> collect(typename BwTreeIndex<KeyType, ValueType>::Iterator it) {
+    std::vector<ValueType> out;
+    for (; it.Valid(); it.Next()) {
+        out.push_back(it.Value());
+    }
+    return out;
+}
+
+}  // namespace
+
+TEST(IndexKeyTest, TestKeyOrder) {
+    // The keys order like memcmp of their bytes, a prefix first, whatever the padding.
+    std::vector<std::string> bytes{"", std::string(1, '\0'), std::string("\0\x01", 2), "a", "a\x7f",
+                                   std::string("a\0", 2), "ab", "abcdefgh", "abcdefgh\x01", "b",
+                                   std::string(16, '\xff')};
+    Key<16>::Less less;
+    Key<16>::Equal equal;
+    for (const auto &a : bytes) {
+        for (const auto &b : bytes) {
+            auto ka = bytesKey(a), kb = bytesKey(b);
+            EXPECT_EQ(less(ka, kb), a < b) << a << " " << b;
+            EXPECT_EQ(equal(ka, kb), a == b);
+            if (a == b) {
+                EXPECT_EQ(Key<16>::Hash{}(ka), Key<16>::Hash{}(kb));
+            }
+        }
+        EXPECT_FALSE(less(Key<16>::Max(), bytesKey(a)));
+    }
+    EXPECT_FALSE(Key<16>::FromBytes(std::string(17, 'a')));
+    EXPECT_EQ(bytesKey("abc").Bytes(), "abc");
+
+    // IntKey orders like its encoding.
+    std::vector<int64_t> ints{INT64_MIN, -2, -1, 0, 1, 255, 256, INT64_MAX};
+    for (auto a : ints) {
+        for (auto b : ints) {
+            std::string ea, eb;
+            IntKey(a).Encode(ea);
+            IntKey(b).Encode(eb);
+            EXPECT_EQ(IntKey::Less{}(IntKey(a), IntKey(b)), ea < eb);
+        }
+    }
+}
+
+TEST(BwTreeIndexTest, TestPointOps) {
+    BwTreeIndex<IntKey> index(true);
+    EXPECT_FALSE(index.Get(IntKey(1)));
+    EXPECT_TRUE(index.Insert(IntKey(1), 10));
+    // A unique index rejects a second value for a key.
+    EXPECT_FALSE(index.Insert(IntKey(1), 11));
+    EXPECT_EQ(index.Get(IntKey(1)), 10u);
+    EXPECT_EQ(index.Size(), 1u);
+
+    index.Upsert(IntKey(1), 12);
+    index.Upsert(IntKey(2), 20);
+    EXPECT_EQ(index.Get(IntKey(1)), 12u);
+    EXPECT_EQ(index.Get(IntKey(2)), 20u);
+    EXPECT_EQ(index.Size(), 2u);
+
+    EXPECT_FALSE(index.Delete(IntKey(1), 10));
+    EXPECT_TRUE(index.Delete(IntKey(1), 12));
+    EXPECT_FALSE(index.Get(IntKey(1)));
+    EXPECT_EQ(index.Size(), 1u);
+
+    BwTreeIndex<Key<16>> multi(false);
+    EXPECT_TRUE(multi.Insert(bytesKey("k"), 1));
+    EXPECT_TRUE(multi.Insert(bytesKey("k"), 2));
+    EXPECT_FALSE(multi.Insert(bytesKey("k"), 2));
+    std::vector<uint64_t> values;
+    multi.GetAll(bytesKey("k"), values);
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(values, (std::vector<uint64_t>{1, 2}));
+    EXPECT_EQ(multi.DeleteKey(bytesKey("k")), 2u);
+    EXPECT_EQ(multi.Size(), 0u);
+}
+
+TEST(BwTreeIndexTest, TestRangeScan) {
+    using index_t = BwTreeIndex<IntKey, int64_t>;
+    index_t index(true);
+    auto scan = [](index_t::Iterator it) { return collect<IntKey, int64_t>(std::move(it)); };
+    EXPECT_TRUE(scan(index.Iter()).empty());
+    EXPECT_TRUE(scan(index.IterReverse()).empty());
+
+    // Enough keys to split the leaves, inserted out of order, the even ones only.
+    constexpr int64_t n = 10000;
+    std::vector<int64_t> keys;
+    for (int64_t i = 0; i < n; i++) {
+        keys.push_back(i * 2);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+    for (auto k : keys) {
+        ASSERT_TRUE(index.Insert(IntKey(k), k));
+    }
+
+    auto all = scan(index.Iter());
+    ASSERT_EQ(all.size(), static_cast<size_t>(n));
+    EXPECT_TRUE(std::is_sorted(all.begin(), all.end()));
+    auto reverse = scan(index.IterReverse());
+    std::reverse(reverse.begin(), reverse.end());
+    EXPECT_EQ(reverse, all);
+
+    // The bounds are [lower, upper), whether they are keys or not.
+    EXPECT_EQ(scan(index.Iter(IntKey(100), IntKey(110))), (std::vector<int64_t>{100, 102, 104, 106, 108}));
+    EXPECT_EQ(scan(index.Iter(IntKey(101), IntKey(109))), (std::vector<int64_t>{102, 104, 106, 108}));
+    EXPECT_EQ(scan(index.IterReverse(IntKey(110), IntKey(100))), (std::vector<int64_t>{108, 106, 104, 102, 100}));
+    EXPECT_EQ(scan(index.IterReverse(IntKey(109), IntKey(101))), (std::vector<int64_t>{108, 106, 104, 102}));
+    EXPECT_EQ(scan(index.IterReverse(IntKey(1))), (std::vector<int64_t>{0}));
+    EXPECT_TRUE(scan(index.IterReverse(IntKey(0))).empty());
+    EXPECT_TRUE(scan(index.Iter(IntKey(2 * n))).empty());
+    EXPECT_EQ(scan(index.Iter(IntKey(2 * n - 3))), (std::vector<int64_t>{2 * n - 2}));
+}
+
+TEST(BwTreeIndexTest, TestConcurrent) {
+    constexpr int numThreads = 4;
+    constexpr int64_t perThread = 20000;
+    BwTreeIndex<IntKey> index(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&index, t] {
+            // Interleave the keys of the threads so that they write the same leaves, then delete half of them.
+            for (int64_t i = 0; i < perThread; i++) {
+                auto k = i * numThreads + t;
+                ASSERT_TRUE(index.Insert(IntKey(k), static_cast<uint64_t>(k)));
+            }
+            for (int64_t i = 0; i < perThread; i += 2) {
+                auto k = i * numThreads + t;
+                ASSERT_TRUE(index.Delete(IntKey(k), static_cast<uint64_t>(k)));
+            }
+        });
+    }
+    // A reader scanning meanwhile sees the keys in order.
+    threads.emplace_back([&index] {
+        for (int round = 0; round < 20; round++) {
+            std::optional<int64_t> prev;
+            for (auto it = index.Iter(); it.Valid(); it.Next()) {
+                ASSERT_TRUE(!prev || *prev < it.Key().Value());
+                prev = it.Key().Value();
+            }
+        }
+    });
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(index.Size(), static_cast<size_t>(numThreads * perThread / 2));
+    int64_t expected = numThreads;
+    for (auto it = index.Iter(); it.Valid(); it.Next()) {
+        ASSERT_EQ(it.Key().Value(), expected);
+        ASSERT_EQ(it.Value(), static_cast<uint64_t>(expected));
+        // Skip the deleted keys: those of the even rows of every thread.
+        expected += expected % (2 * numThreads) == 2 * numThreads - 1 ? numThreads + 1 : 1;
+    }
+    EXPECT_EQ(expected, numThreads * perThread + numThreads);
+}
+
+TEST(BwTreeIndexTest, TestBulkLoad) {
+    using index_t = BwTreeIndex<IntKey, int64_t>;
+    auto scan = [](index_t::Iterator it) { return collect<IntKey, int64_t>(std::move(it)); };
+
+    // Enough pairs for two inner levels, out of order, each key twice with the same value.
+    constexpr int64_t n = 200000;
+    std::vector<std::pair<IntKey, int64_t>> pairs;
+    for (int64_t i = 0; i < n; i++) {
+        pairs.emplace_back(IntKey(i * 2), i * 2);
+        pairs.emplace_back(IntKey(i * 2), i * 2);
+    }
+    std::shuffle(pairs.begin(), pairs.end(), std::mt19937(1));
+
+    index_t index(true);
+    EXPECT_EQ(index.BulkLoad(pairs), static_cast<size_t>(n));
+    EXPECT_EQ(index.Size(), static_cast<size_t>(n));
+    for (int64_t k : {int64_t{0}, int64_t{2}, n, 2 * n - 2}) {
+        EXPECT_EQ(index.Get(IntKey(k)), k);
+        EXPECT_FALSE(index.Get(IntKey(k + 1)));
+    }
+    auto all = scan(index.Iter());
+    ASSERT_EQ(all.size(), static_cast<size_t>(n));
+    EXPECT_TRUE(std::is_sorted(all.begin(), all.end()));
+    auto reverse = scan(index.IterReverse());
+    std::reverse(reverse.begin(), reverse.end());
+    EXPECT_EQ(reverse, all);
+    EXPECT_EQ(scan(index.Iter(IntKey(1001), IntKey(1009))), (std::vector<int64_t>{1002, 1004, 1006, 1008}));
+    EXPECT_EQ(scan(index.IterReverse(IntKey(1009), IntKey(1001))), (std::vector<int64_t>{1008, 1006, 1004, 1002}));
+
+    // The loaded nodes split and merge like the others.
+    for (int64_t i = 0; i < n; i++) {
+        ASSERT_TRUE(index.Insert(IntKey(i * 2 + 1), i * 2 + 1));
+    }
+    for (int64_t i = 0; i < n; i += 2) {
+        ASSERT_TRUE(index.Delete(IntKey(i * 2), i * 2));
+    }
+    EXPECT_EQ(index.Size(), static_cast<size_t>(n + n / 2));
+    EXPECT_EQ(scan(index.Iter(IntKey(1000), IntKey(1006))), (std::vector<int64_t>{1001, 1002, 1003, 1005}));
+
+    // A non-empty index inserts the pairs instead; the keys it has are rejected.
+    EXPECT_EQ(index.BulkLoad({{IntKey(1), 1}, {IntKey(-1), -1}, {IntKey(2 * n), 2 * n}}), 2u);
+    EXPECT_EQ(index.Get(IntKey(-1)), -1);
+    EXPECT_EQ(index.Get(IntKey(2 * n)), 2 * n);
+
+    // A unique index keeps one value of a key, a non-unique one all its distinct values.
+    std::vector<std::pair<Key<16>, uint64_t>> dups;
+    for (uint64_t i = 0; i < 1000; i++) {
+        dups.emplace_back(bytesKey("k" + std::to_string(i % 10)), i % 30);
+    }
+    BwTreeIndex<Key<16>> unique(true);
+    EXPECT_EQ(unique.BulkLoad(dups), 10u);
+    // The first value given for a key wins, like when inserting one by one.
+    EXPECT_EQ(unique.Get(bytesKey("k3")), 3u);
+    BwTreeIndex<Key<16>> multi(false);
+    EXPECT_EQ(multi.BulkLoad(dups), 30u);
+    std::vector<uint64_t> values;
+    multi.GetAll(bytesKey("k3"), values);
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(values, (std::vector<uint64_t>{3, 13, 23}));
+
+    // A single leaf keeps the initial root.
+    index_t small(false);
+    EXPECT_EQ(small.BulkLoad({{IntKey(2), 2}, {IntKey(1), 1}}), 2u);
+    EXPECT_EQ(scan(small.Iter()), (std::vector<int64_t>{1, 2}));
+    EXPECT_TRUE(small.Insert(IntKey(3), 3));
+    EXPECT_EQ(small.BulkLoad({}), 0u);
+
+    // A concurrent reader sees none of the pairs or all of them.
+    index_t loading(true);
+    std::vector<std::pair<IntKey, int64_t>> rows;
+    for (int64_t i = 0; i < 20000; i++) {
+        rows.emplace_back(IntKey(i), i);
+    }
+    std::atomic<bool> loaded{false};
+    std::thread reader([&] {
+        while (!loaded) {
+            auto seen = scan(loading.Iter()).size();
+            ASSERT_TRUE(seen == 0 || seen == rows.size()) << seen;
+        }
+    });
+    EXPECT_EQ(loading.BulkLoad(rows), rows.size());
+    loaded = true;
+    reader.join();
+}
+
+TEST(BwTreeIndexTest, TestBatchScan) {
+    using index_t = BwTreeIndex<IntKey, int64_t>;
+    auto scan = [](index_t::BatchIterator it) {
+        std::vector<int64_t> out;
+        while (it.Next()) {
+            EXPECT_FALSE(it.Keys().empty());
+            EXPECT_EQ(it.Keys().size(), it.Values().size());
+            for (size_t i = 0; i < it.Keys().size(); i++) {
+                EXPECT_EQ(it.Keys()[i].Value(), it.Values()[i]);
+            }
+            out.insert(out.end(), it.Values().begin(), it.Values().end());
+        }
+        return out;
+    };
+    index_t index(true);
+    EXPECT_TRUE(scan(index.IterBatch()).empty());
+
+    // Enough keys to split the leaves, inserted out of order, the even ones only, negative ones included.
+    constexpr int64_t n = 10000;
+    std::vector<int64_t> keys;
+    for (int64_t i = -n / 2; i < n / 2; i++) {
+        keys.push_back(i * 2);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+    for (auto k : keys) {
+        ASSERT_TRUE(index.Insert(IntKey(k), k));
+    }
+    std::sort(keys.begin(), keys.end());
+    EXPECT_EQ(scan(index.IterBatch()), keys);
+
+    // The bounds are [lower, upper), whether they are keys or not, and the limit cuts the scan.
+    EXPECT_EQ(scan(index.IterBatch(IntKey(100), IntKey(110))), (std::vector<int64_t>{100, 102, 104, 106, 108}));
+    EXPECT_EQ(scan(index.IterBatch(IntKey(101), IntKey(109))), (std::vector<int64_t>{102, 104, 106, 108}));
+    EXPECT_EQ(scan(index.IterBatch(IntKey(-3), std::nullopt, 3)), (std::vector<int64_t>{-2, 0, 2}));
+    EXPECT_EQ(scan(index.IterBatch(IntKey(n - 3))), (std::vector<int64_t>{n - 2}));
+    EXPECT_TRUE(scan(index.IterBatch(IntKey(n))).empty());
+    EXPECT_TRUE(scan(index.IterBatch(IntKey(0), IntKey(0))).empty());
+    EXPECT_TRUE(scan(index.IterBatch(std::nullopt, std::nullopt, 0)).empty());
+    auto limited = scan(index.IterBatch(std::nullopt, std::nullopt, 1000));
+    EXPECT_EQ(limited, std::vector<int64_t>(keys.begin(), keys.begin() + 1000));
+
+    // The leaves merged between two batches are found from the root.
+    auto it = index.IterBatch();
+    ASSERT_TRUE(it.Next());
+    auto last = it.Values().back();
+    std::vector<int64_t> seen(it.Values().begin(), it.Values().end());
+    for (auto k : keys) {
+        if (k > last && k % 8 != 0) {
+            ASSERT_TRUE(index.Delete(IntKey(k), k));
+        }
+    }
+    while (it.Next()) {
+        seen.insert(seen.end(), it.Values().begin(), it.Values().end());
+    }
+    std::vector<int64_t> want;
+    std::copy_if(keys.begin(), keys.end(), std::back_inserter(want),
+                 [&](int64_t k) { return k <= last || k % 8 == 0; });
+    EXPECT_EQ(seen, want);
+
+    // A scan concurrent with writers sees the keys they never touch, in order.
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        std::mt19937 rng(2);
+        std::uniform_int_distribution<int64_t> pick(-n / 2, n / 2 - 1);
+        for (int i = 0; i < 50000; i++) {
+            auto k = pick(rng) * 2 + 1;
+            if (!index.Insert(IntKey(k), k)) {
+                index.Delete(IntKey(k), k);
+            }
+        }
+        done = true;
+    });
+    while (!done) {
+        auto all = scan(index.IterBatch());
+        ASSERT_TRUE(std::is_sorted(all.begin(), all.end()));
+        std::vector<int64_t> stable;
+        std::copy_if(all.begin(), all.end(), std::back_inserter(stable), [](int64_t k) { return k % 8 == 0; });
+        ASSERT_EQ(stable.size(), static_cast<size_t>(n / 4));
+    }
+    writer.join();
+}
@@ -0,0 +1,145 @@
+#include "storage/index/handle_index.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "metrics/storage.hh"
+
+using namespace storage::index;
+
+TEST(HandleIndexTest, TestPointOps) {
+    for (bool withHash : {false, true}) {
+        HandleIndex index(withHash);
+        EXPECT_EQ(index.HasHash(), withHash);
+        EXPECT_TRUE(index.Insert(1, 10));
+        EXPECT_TRUE(index.Insert(-5, 50));
+        EXPECT_FALSE(index.Insert(1, 11));
+        EXPECT_EQ(index.Get(1), 10u);
+        EXPECT_EQ(index.Get(-5), 50u);
+        EXPECT_EQ(index.Get(2), std::nullopt);
+
+        index.Update(1, 12);
+        index.Update(3, 30);
+        EXPECT_EQ(index.Get(1), 12u);
+        EXPECT_EQ(index.Get(3), 30u);
+        EXPECT_EQ(index.Size(), 3u);
+
+        EXPECT_TRUE(index.Delete(-5));
+        EXPECT_FALSE(index.Delete(-5));
+        EXPECT_EQ(index.Get(-5), std::nullopt);
+
+        std::vector<int64_t> handles{3, 4, 1, 3};
+        std::vector<std::optional<RowLocation>> out;
+        index.BatchGet(handles, out);
+        EXPECT_EQ(out, (std::vector<std::optional<RowLocation>>{30, std::nullopt, 12, 30}));
+
+        // The tree and the hash table hold the same handles.
+        std::vector<RowLocation> scanned;
+        for (auto it = index.Iter(); it.Valid(); it.Next()) {
+            scanned.push_back(it.Value());
+        }
+        EXPECT_EQ(scanned, (std::vector<RowLocation>{12, 30}));
+    }
+}
+
+TEST(HandleIndexTest, TestLoadFactor) {
+    auto entries = metrics::HandleIndexEntries.Value();
+    auto slots = metrics::HandleIndexSlots.Value();
+    {
+        HandleIndex plain(false);
+        EXPECT_EQ(plain.LoadFactor(), 0);
+
+        // A table estimated at its row count does not grow while it is loaded.
+        constexpr int64_t rows = 100000;
+        HandleIndex index(true, rows);
+        auto capacity = metrics::HandleIndexSlots.Value() - slots;
+        EXPECT_GE(static_cast<double>(capacity), rows / HandleIndex::maxHashLoadFactor);
+        for (int64_t h = 0; h < rows; h++) {
+            ASSERT_TRUE(index.Insert(h, h));
+        }
+        EXPECT_EQ(metrics::HandleIndexSlots.Value() - slots, capacity);
+        EXPECT_EQ(metrics::HandleIndexEntries.Value() - entries, rows);
+        EXPECT_GT(index.LoadFactor(), 0.2);
+        EXPECT_LE(index.LoadFactor(), HandleIndex::maxHashLoadFactor);
+        EXPECT_GT(metrics::HandleIndexLoadFactor.Value(), 0);
+
+        // Without an estimate, the table grows as the rows are inserted.
+        HandleIndex small(true);
+        auto smallSlots = metrics::HandleIndexSlots.Value();
+        for (int64_t h = 0; h < 10000; h++) {
+            ASSERT_TRUE(small.Insert(h, h));
+        }
+        EXPECT_GT(metrics::HandleIndexSlots.Value(), smallSlots);
+        EXPECT_TRUE(small.Delete(0));
+        EXPECT_EQ(metrics::HandleIndexEntries.Value() - entries, rows + 9999);
+    }
+    EXPECT_EQ(metrics::HandleIndexEntries.Value(), entries);
+    EXPECT_EQ(metrics::HandleIndexSlots.Value(), slots);
+}
+
+TEST(HandleIndexTest, TestBulkLoad) {
+    std::vector<std::pair<int64_t, RowLocation>> rows;
+    for (int64_t h = 0; h < 50000; h++) {
+        rows.emplace_back(h * 3, h);
+    }
+    rows.emplace_back(0, 99);
+    std::shuffle(rows.begin(), rows.end(), std::mt19937(1));
+
+    HandleIndex index(true);
+    EXPECT_EQ(index.BulkLoad(rows), 50000u);
+    EXPECT_EQ(index.Size(), 50000u);
+    // The location the tree kept for a handle given twice is the one the hash table returns.
+    std::optional<RowLocation> first;
+    for (auto it = index.Iter(0, 1); it.Valid(); it.Next()) {
+        first = it.Value();
+    }
+    EXPECT_EQ(index.Get(0), first);
+    for (int64_t h = 1; h < 50000; h++) {
+        ASSERT_EQ(index.Get(h * 3), static_cast<RowLocation>(h));
+        ASSERT_EQ(index.Get(h * 3 + 1), std::nullopt);
+    }
+
+    // A non-empty index inserts the rows.
+    EXPECT_EQ(index.BulkLoad({{1, 1}, {3, 3}}), 1u);
+    EXPECT_EQ(index.Get(1), 1u);
+    EXPECT_EQ(index.Get(3), 1u);
+}
+
+TEST(HandleIndexTest, TestConcurrent) {
+    // Readers of the handles no writer touches always find them, while writers insert and delete others.
+    constexpr int64_t stable = 10000;
+    HandleIndex index(true);
+    for (int64_t h = 0; h < stable; h++) {
+        ASSERT_TRUE(index.Insert(h * 2, h));
+    }
+    std::atomic<int> finished{0};
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 2; w++) {
+        writers.emplace_back([&, w] {
+            // Every writer owns its own handles.
+            for (int64_t h = 0; h < 20000; h++) {
+                auto handle = (h * 2 + w) * 2 + 1;
+                ASSERT_TRUE(index.Insert(handle, h));
+                if (h % 2 == 0) {
+                    ASSERT_TRUE(index.Delete(handle));
+                }
+            }
+            finished++;
+        });
+    }
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int64_t> pick(0, stable - 1);
+    while (finished < 2) {
+        auto h = pick(rng);
+        ASSERT_EQ(index.Get(h * 2), static_cast<RowLocation>(h));
+    }
+    for (auto &t : writers) {
+        t.join();
+    }
+    EXPECT_EQ(index.Size(), static_cast<size_t>(stable + 20000));
+}
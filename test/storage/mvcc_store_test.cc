@@ -0,0 +1,232 @@
+#include "storage/mvcc/mvcc_store.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "errcode/errcode.hh"
+
+using namespace storage::mvcc;
+
+namespace {
+
+std::vector<std::pair<std::string, std::string>> scan(const Txn &txn, std::string_view lower = {},
+                                                      const std::optional<std::string> &upper = std::nullopt) {
+    std::vector<std::pair<std::string, std::string>> out;
+    for (auto it = txn.Iter(lower, upper); it.Valid(); it.Next()) {
+        out.emplace_back(it.Key(), it.Value());
+    }
+    return out;
+}
+
+void put(MVCCStore &store, const std::string &key, const std::string &value) {
+    auto txn = store.Begin();
+    ASSERT_FALSE(txn->Set(key, value));
+    ASSERT_FALSE(txn->Commit());
+}
+
+}  // namespace
+
+TEST(MVCCStoreTest, TestSnapshotIsolation) {
+    MVCCStore store(std::chrono::milliseconds(0));
+    put(store, "a", "1");
+
+    auto reader = store.Begin();
+    put(store, "a", "2");
+    put(store, "b", "1");
+    // The reader sees the snapshot it began with, and its own writes.
+    EXPECT_EQ(reader->Get("a"), "1");
+    EXPECT_EQ(reader->Get("b"), std::nullopt);
+    ASSERT_FALSE(reader->Set("c", "3"));
+    EXPECT_EQ(reader->Get("c"), "3");
+
+    auto latest = store.Begin();
+    EXPECT_EQ(latest->Get("a"), "2");
+    EXPECT_EQ(latest->Get("b"), "1");
+    EXPECT_EQ(latest->Get("c"), std::nullopt);
+    EXPECT_EQ(latest->StartTS(), store.CommitTS());
+
+    // A transaction writing nothing commits without a timestamp.
+    auto ts = store.CommitTS();
+    EXPECT_FALSE(latest->Commit());
+    EXPECT_EQ(store.CommitTS(), ts);
+}
+
+TEST(MVCCStoreTest, TestWriteConflict) {
+    MVCCStore store(std::chrono::milliseconds(0));
+    put(store, "k", "0");
+
+    auto t1 = store.Begin();
+    auto t2 = store.Begin();
+    ASSERT_FALSE(t1->Set("k", "1"));
+    ASSERT_FALSE(t2->Set("k", "2"));
+    ASSERT_FALSE(t2->Set("other", "2"));
+    EXPECT_FALSE(t1->Commit());
+    auto err = t2->Commit();
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, errcode::ErrWriteConflict);
+
+    // Nothing of the failed transaction is installed.
+    auto t3 = store.Begin();
+    EXPECT_EQ(t3->Get("k"), "1");
+    EXPECT_EQ(t3->Get("other"), std::nullopt);
+
+    // Writing keys the others do not touch never conflicts.
+    auto t4 = store.Begin();
+    ASSERT_FALSE(t3->Set("x", "3"));
+    ASSERT_FALSE(t4->Set("y", "4"));
+    EXPECT_FALSE(t3->Commit());
+    EXPECT_FALSE(t4->Commit());
+
+    auto long_ = store.Begin();
+    err = long_->Set(std::string(MaxKeyLength + 1, 'k'), "v");
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrTooLongKey);
+    EXPECT_FALSE(long_->Set(std::string(MaxKeyLength, 'k'), "v"));
+    EXPECT_FALSE(long_->Commit());
+}
+
+TEST(MVCCStoreTest, TestIter) {
+    MVCCStore store(std::chrono::milliseconds(0));
+    {
+        auto txn = store.Begin();
+        for (auto k : {"a", "b", "bb", "c", "d"}) {
+            ASSERT_FALSE(txn->Set(k, std::string(k) + "0"));
+        }
+        ASSERT_FALSE(txn->Commit());
+    }
+    auto old = store.Begin();
+    put(store, "b", "b1");
+    {
+        auto txn = store.Begin();
+        ASSERT_FALSE(txn->Delete("c"));
+        ASSERT_FALSE(txn->Commit());
+    }
+
+    using kvs = std::vector<std::pair<std::string, std::string>>;
+    EXPECT_EQ(scan(*old), (kvs{{"a", "a0"}, {"b", "b0"}, {"bb", "bb0"}, {"c", "c0"}, {"d", "d0"}}));
+
+    auto txn = store.Begin();
+    EXPECT_EQ(scan(*txn), (kvs{{"a", "a0"}, {"b", "b1"}, {"bb", "bb0"}, {"d", "d0"}}));
+    EXPECT_EQ(scan(*txn, "b", "d"), (kvs{{"b", "b1"}, {"bb", "bb0"}}));
+    EXPECT_EQ(scan(*txn, "ba"), (kvs{{"bb", "bb0"}, {"d", "d0"}}));
+    // The bounds may be longer than the keys.
+    EXPECT_EQ(scan(*txn, std::string(MaxKeyLength + 5, 'b'), std::string(MaxKeyLength + 5, 'd')),
+              (kvs{{"d", "d0"}}));
+    EXPECT_EQ(scan(*txn, "", std::string(MaxKeyLength + 5, 'a')), (kvs{{"a", "a0"}}));
+
+    // The writes of the transaction shadow its snapshot.
+    ASSERT_FALSE(txn->Delete("a"));
+    ASSERT_FALSE(txn->Set("bb", "bb2"));
+    ASSERT_FALSE(txn->Set("c", "c2"));
+    ASSERT_FALSE(txn->Set("e", "e2"));
+    ASSERT_FALSE(txn->Delete("f"));
+    EXPECT_EQ(scan(*txn), (kvs{{"b", "b1"}, {"bb", "bb2"}, {"c", "c2"}, {"d", "d0"}, {"e", "e2"}}));
+    EXPECT_EQ(scan(*txn, "bb", "d"), (kvs{{"bb", "bb2"}, {"c", "c2"}}));
+    EXPECT_EQ(txn->Get("a"), std::nullopt);
+}
+
+TEST(MVCCStoreTest, TestGC) {
+    MVCCStore store(std::chrono::milliseconds(0));
+    for (int i = 0; i < 3; i++) {
+        put(store, "a", std::to_string(i));
+    }
+    auto old = store.Begin();
+    put(store, "a", "3");
+    {
+        auto txn = store.Begin();
+        ASSERT_FALSE(txn->Set("b", "0"));
+        ASSERT_FALSE(txn->Commit());
+        txn = store.Begin();
+        ASSERT_FALSE(txn->Delete("b"));
+        ASSERT_FALSE(txn->Commit());
+    }
+    EXPECT_EQ(store.NumVersions(), 6u);
+    EXPECT_EQ(store.SafePoint(), old->StartTS());
+
+    // The oldest snapshot still reads the third version of a and nothing of b.
+    EXPECT_EQ(store.GC(), 2u);
+    EXPECT_EQ(store.NumVersions(), 4u);
+    EXPECT_EQ(old->Get("a"), "2");
+    EXPECT_EQ(old->Get("b"), std::nullopt);
+
+    old->Rollback();
+    EXPECT_EQ(store.SafePoint(), store.CommitTS());
+    // Then only the last version of a remains, b being deleted.
+    EXPECT_EQ(store.GC(), 3u);
+    EXPECT_EQ(store.NumVersions(), 1u);
+    auto txn = store.Begin();
+    EXPECT_EQ(txn->Get("a"), "3");
+    EXPECT_EQ(txn->Get("b"), std::nullopt);
+    EXPECT_EQ(store.GC(), 0u);
+}
+
+TEST(MVCCStoreTest, TestConcurrent) {
+    // Transfers between accounts, retried on conflicts, keep the total. Every snapshot must see it while the
+    // garbage collection runs in the background.
+    constexpr int accounts = 16;
+    constexpr int transfers = 2000;
+    MVCCStore store(std::chrono::milliseconds(1));
+    {
+        auto txn = store.Begin();
+        for (int i = 0; i < accounts; i++) {
+            ASSERT_FALSE(txn->Set("acct" + std::to_string(i), "100"));
+        }
+        ASSERT_FALSE(txn->Commit());
+    }
+
+    std::atomic<int> finished{0};
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 2; w++) {
+        writers.emplace_back([&, w] {
+            std::mt19937 rng(w);
+            std::uniform_int_distribution<int> pick(0, accounts - 1);
+            for (int n = 0; n < transfers;) {
+                auto from = "acct" + std::to_string(pick(rng));
+                auto to = "acct" + std::to_string(pick(rng));
+                if (from == to) {
+                    continue;
+                }
+                auto txn = store.Begin();
+                auto a = std::stoi(*txn->Get(from));
+                auto b = std::stoi(*txn->Get(to));
+                ASSERT_FALSE(txn->Set(from, std::to_string(a - 1)));
+                ASSERT_FALSE(txn->Set(to, std::to_string(b + 1)));
+                if (auto err = txn->Commit()) {
+                    ASSERT_EQ(err->Code, errcode::ErrWriteConflict);
+                    continue;
+                }
+                n++;
+            }
+            finished++;
+        });
+    }
+    while (finished < 2) {
+        auto txn = store.Begin();
+        int total = 0, n = 0;
+        for (auto it = txn->Iter(); it.Valid(); it.Next()) {
+            total += std::stoi(std::string(it.Value()));
+            n++;
+        }
+        ASSERT_EQ(n, accounts);
+        ASSERT_EQ(total, accounts * 100);
+    }
+    for (auto &t : writers) {
+        t.join();
+    }
+
+    auto txn = store.Begin();
+    int total = 0;
+    for (int i = 0; i < accounts; i++) {
+        total += std::stoi(*txn->Get("acct" + std::to_string(i)));
+    }
+    EXPECT_EQ(total, accounts * 100);
+    txn->Rollback();
+    store.GC();
+    EXPECT_EQ(store.NumVersions(), static_cast<size_t>(accounts));
+}
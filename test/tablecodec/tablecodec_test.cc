@@ -0,0 +1,73 @@
+#include "tablecodec/tablecodec.hh"
+
+#include <gtest/gtest.h>
+
+#include "util/codec/codec.hh"
+
+using namespace tablecodec;
+
+TEST(TableCodecTest, TestRowKey) {
+    auto key = EncodeRowKeyWithHandle(42, -7);
+    EXPECT_EQ(key.size(), RecordRowKeyLen);
+    EXPECT_EQ(key.substr(0, prefixLen), GenTableRecordPrefix(42));
+    EXPECT_EQ(key.substr(0, 1 + idLen), EncodeTablePrefix(42));
+    EXPECT_TRUE(IsRecordKey(key));
+    EXPECT_FALSE(IsIndexKey(key));
+    auto [tableID, handle, ok] = DecodeRecordKey(key);
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(tableID, 42);
+    EXPECT_EQ(handle, -7);
+    EXPECT_EQ(DecodeTableID(key), 42);
+
+    // The rows of a table sort by handle, and the tables by id.
+    EXPECT_LT(EncodeRowKeyWithHandle(42, -8), key);
+    EXPECT_LT(key, EncodeRowKeyWithHandle(42, 0));
+    EXPECT_LT(EncodeRowKeyWithHandle(41, 100), key);
+
+    std::vector<int64_t> handles{1, -1, 1 << 20};
+    std::string batch = "x";
+    EncodeRowKeys(batch, 42, handles);
+    ASSERT_EQ(batch.size(), 1 + handles.size() * RecordRowKeyLen);
+    for (size_t i = 0; i < handles.size(); i++) {
+        EXPECT_EQ(batch.substr(1 + i * RecordRowKeyLen, RecordRowKeyLen), EncodeRowKeyWithHandle(42, handles[i]));
+    }
+
+    EXPECT_FALSE(std::get<2>(DecodeRecordKey(key.substr(1))));
+    EXPECT_FALSE(std::get<2>(DecodeRecordKey(EncodeIndexSeekKey(42, 1, "12345678"))));
+    EXPECT_EQ(DecodeTableID("x"), 0);
+}
+
+TEST(TableCodecTest, TestIndexKey) {
+    std::vector<std::string> keys;
+    ResetIndexKeys(keys, 2, 42, 3);
+    std::vector<int64_t> ints{5, 5};
+    util::codec::EncodeIntColumn(keys, ints);
+    std::vector<std::string_view> strs{"abcdefghij", "b"};
+    util::codec::EncodeBytesColumn(keys, strs);
+    // A non-unique index appends the handle.
+    std::vector<int64_t> handles{100, 101};
+    util::codec::EncodeIntColumn(keys, handles);
+
+    EXPECT_LT(keys[0], keys[1]);
+    EXPECT_EQ(keys[0].substr(0, prefixLen), GenTableIndexPrefix(42));
+    EXPECT_TRUE(keys[0].starts_with(EncodeIndexSeekKey(42, 3, {})));
+    EXPECT_TRUE(IsIndexKey(keys[0]));
+
+    auto [tableID, indexID, isRecord, ok] = DecodeKeyHead(keys[0]);
+    EXPECT_TRUE(ok);
+    EXPECT_FALSE(isRecord);
+    EXPECT_EQ(tableID, 42);
+    EXPECT_EQ(indexID, 3);
+
+    auto [values, rest, cut] = CutIndexKey(keys[0], 2);
+    ASSERT_TRUE(cut);
+    ASSERT_EQ(values.size(), 2u);
+    std::string s;
+    EXPECT_GT(util::codec::DecodeBytes(values[1].substr(1), s), 0u);
+    EXPECT_EQ(s, "abcdefghij");
+    EXPECT_EQ(std::get<0>(util::codec::DecodeInt(rest.substr(1))), 100);
+    EXPECT_FALSE(std::get<2>(CutIndexKey(keys[0].substr(0, keys[0].size() - 20), 3)));
+
+    EXPECT_TRUE(std::get<2>(DecodeKeyHead(EncodeRowKeyWithHandle(1, 1))));
+    EXPECT_FALSE(std::get<3>(DecodeKeyHead("t123")));
+}
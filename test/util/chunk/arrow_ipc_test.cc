@@ -0,0 +1,286 @@
+#include "util/chunk/arrow_ipc.hh"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "parser/mysql/errcode.hh"
+#include "parser/mysql/type.hh"
+
+using namespace util::chunk;
+
+namespace {
+
+const std::vector<Field> fields{
+    {"id", mysql::TypeLonglong, mysql::NotNullFlag},
+    {"u", mysql::TypeLonglong, mysql::UnsignedFlag},
+    {"f", mysql::TypeFloat, 0},
+    {"d", mysql::TypeDouble, 0},
+    {"s", mysql::TypeVarString, 0},
+    {"b", mysql::TypeBlob, mysql::BinaryFlag},
+    {"t", mysql::TypeDatetime, 0},
+};
+
+// newChunk returns a chunk of fields with rows [begin, end), the nullable columns null every fourth row.
+Chunk newChunk(int begin, int end) {
+    std::vector<uint8_t> types;
+    for (const auto &f : fields) {
+        types.push_back(f.Type);
+    }
+    Chunk chk(types);
+    for (int i = begin; i < end; i++) {
+        chk.Col(0).AppendInt64(i);
+        if (i % 4 == 3) {
+            for (size_t c = 1; c < chk.NumCols(); c++) {
+                chk.Col(c).AppendNull();
+            }
+            continue;
+        }
+        chk.Col(1).AppendUint64(UINT64_MAX - i);
+        chk.Col(2).AppendFloat32(i * 0.5f);
+        chk.Col(3).AppendFloat64(i * 0.25);
+        chk.Col(4).AppendBytes(std::string(i % 7, 'a' + i % 26));
+        chk.Col(5).AppendBytes(std::string(1, static_cast<char>(i)));
+        chk.Col(6).AppendBytes("2026-10-19 00:00:" + std::to_string(10 + i % 50));
+    }
+    return chk;
+}
+
+// expectRows checks that the rows of chk are those of newChunk at row numbers.
+void expectRows(const Chunk &chk, const std::vector<int> &rows) {
+    auto want = newChunk(0, rows.empty() ? 0 : rows.back() + 1);
+    ASSERT_EQ(chk.NumRows(), rows.size());
+    for (size_t r = 0; r < rows.size(); r++) {
+        auto i = static_cast<size_t>(rows[r]);
+        ASSERT_EQ(chk.Col(0).GetInt64(r), rows[r]);
+        for (size_t c = 1; c < chk.NumCols(); c++) {
+            ASSERT_EQ(chk.Col(c).IsNull(r), want.Col(c).IsNull(i));
+        }
+        if (want.Col(1).IsNull(i)) {
+            continue;
+        }
+        ASSERT_EQ(chk.Col(1).GetUint64(r), want.Col(1).GetUint64(i));
+        ASSERT_EQ(chk.Col(2).GetFloat32(r), want.Col(2).GetFloat32(i));
+        ASSERT_EQ(chk.Col(3).GetFloat64(r), want.Col(3).GetFloat64(i));
+        for (size_t c = 4; c < chk.NumCols(); c++) {
+            ASSERT_EQ(chk.Col(c).GetBytes(r), want.Col(c).GetBytes(i));
+        }
+    }
+}
+
+std::string tempPath(const std::string &name) {
+    return (std::filesystem::temp_directory_path() / (name + "." + std::to_string(::getpid()) + ".arrow")).string();
+}
+
+std::vector<uint8_t> readFile(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+// write writes two batches of newChunk, the second through a selection vector, and returns the bytes written.
+std::vector<uint8_t> write(ArrowFormat format) {
+    auto path = tempPath("write");
+    auto [writer, err] = ArrowWriter::Create(path, fields, format);
+    EXPECT_FALSE(err);
+    EXPECT_FALSE(writer->Write(newChunk(0, 100)));
+    auto chk = newChunk(0, 10);
+    chk.SetSel({1, 2, 3, 8});
+    EXPECT_FALSE(writer->Write(chk));
+    EXPECT_FALSE(writer->Finish());
+    EXPECT_EQ(writer->BytesWritten(), std::filesystem::file_size(path));
+    writer.reset();
+    auto data = readFile(path);
+    std::filesystem::remove(path);
+    return data;
+}
+
+}  // namespace
+
+TEST(ArrowIPCTest, TestRoundTrip) {
+    std::vector<int> all(100), sel{1, 2, 3, 8};
+    for (int i = 0; i < 100; i++) {
+        all[i] = i;
+    }
+    for (auto format : {ArrowFormat::Stream, ArrowFormat::File}) {
+        auto path = tempPath("round_trip");
+        {
+            auto [writer, err] = ArrowWriter::Create(path, fields, format);
+            ASSERT_FALSE(err);
+            ASSERT_FALSE(writer->Write(newChunk(0, 100)));
+            auto chk = newChunk(0, 10);
+            chk.SetSel(std::vector<uint32_t>(sel.begin(), sel.end()));
+            ASSERT_FALSE(writer->Write(chk));
+            // An empty batch is a batch.
+            ASSERT_FALSE(writer->Write(newChunk(0, 0)));
+            ASSERT_FALSE(writer->Finish());
+        }
+        auto [reader, err] = ArrowReader::Open(path);
+        ASSERT_FALSE(err) << err->Message;
+        ASSERT_EQ(reader->Fields().size(), fields.size());
+        for (size_t c = 0; c < fields.size(); c++) {
+            EXPECT_EQ(reader->Fields()[c].Name, fields[c].Name);
+            EXPECT_EQ(reader->Fields()[c].Type, fields[c].Type);
+            EXPECT_EQ(reader->Fields()[c].Flag, fields[c].Flag);
+        }
+        ASSERT_EQ(reader->NumBatches(), 3u);
+        Chunk chk;
+        ASSERT_FALSE(reader->ReadBatch(0, chk));
+        expectRows(chk, all);
+        for (size_t c = 0; c < chk.NumCols(); c++) {
+            // The body is aligned like the columns.
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(chk.Col(c).Data()) % bufferAlignment, 0u);
+        }
+        ASSERT_FALSE(reader->ReadBatch(1, chk));
+        expectRows(chk, sel);
+        ASSERT_FALSE(reader->ReadBatch(2, chk));
+        EXPECT_EQ(chk.NumRows(), 0u);
+
+        // The columns read are views, copied when rows are appended.
+        ASSERT_FALSE(reader->ReadBatch(1, chk));
+        chk.Col(1).SetNull(0, true);
+        EXPECT_TRUE(chk.Col(1).IsNull(0));
+        EXPECT_EQ(chk.Col(1).NullCount(), 2u);
+        chk.Col(4).AppendBytes("appended");
+        chk.Col(1).AppendNull();
+        EXPECT_EQ(chk.Col(4).GetBytes(1), std::string(2, 'c'));
+        EXPECT_EQ(chk.Col(4).GetBytes(4), "appended");
+        EXPECT_TRUE(chk.Col(1).IsNull(4));
+        EXPECT_EQ(chk.Col(1).NullCount(), 3u);
+        reader.reset();
+        std::filesystem::remove(path);
+    }
+}
+
+TEST(ArrowIPCTest, TestMemory) {
+    for (auto format : {ArrowFormat::Stream, ArrowFormat::File}) {
+        auto data = write(format);
+        auto [reader, err] = ArrowReader::Open(data, "memory");
+        ASSERT_FALSE(err) << err->Message;
+        ASSERT_EQ(reader->NumBatches(), 2u);
+        Chunk chk;
+        ASSERT_FALSE(reader->ReadBatch(1, chk));
+        expectRows(chk, {1, 2, 3, 8});
+        // Nothing is copied.
+        for (size_t c = 0; c < chk.NumCols(); c++) {
+            EXPECT_GE(chk.Col(c).Data(), data.data());
+            EXPECT_LT(chk.Col(c).Data(), data.data() + data.size());
+        }
+    }
+}
+
+TEST(ArrowIPCTest, TestEmptyOffsets) {
+    // The writer writes the single offset of an empty column, but other writers may leave it out.
+    auto path = tempPath("empty");
+    std::vector<Field> strings{{"s", mysql::TypeVarString, 0}};
+    auto [writer, err] = ArrowWriter::Create(path, strings, ArrowFormat::Stream);
+    ASSERT_FALSE(err);
+    ASSERT_FALSE(writer->Write(Chunk(std::vector<uint8_t>{mysql::TypeVarString})));
+    ASSERT_FALSE(writer->Finish());
+    writer.reset();
+    auto data = readFile(path);
+    std::filesystem::remove(path);
+
+    // The buffers of the column are the validity bitmap, the offsets and the data, each an offset and a length: find
+    // the empty bitmap followed by the 8 bytes of offsets, and empty the offsets.
+    const int64_t pattern[] = {0, 0, 0, 8};
+    auto it = std::search(data.begin(), data.end(), reinterpret_cast<const uint8_t *>(pattern),
+                          reinterpret_cast<const uint8_t *>(pattern) + sizeof(pattern));
+    ASSERT_NE(it, data.end());
+    it[3 * sizeof(int64_t)] = 0;
+
+    auto [reader, openErr] = ArrowReader::Open(data, "empty");
+    ASSERT_FALSE(openErr) << openErr->Message;
+    ASSERT_EQ(reader->NumBatches(), 1u);
+    Chunk chk;
+    ASSERT_FALSE(reader->ReadBatch(0, chk));
+    EXPECT_EQ(chk.NumRows(), 0u);
+    chk.Col(0).AppendBytes("a");
+    EXPECT_EQ(chk.Col(0).GetBytes(0), "a");
+}
+
+TEST(ArrowIPCTest, TestCorrupted) {
+    for (auto format : {ArrowFormat::Stream, ArrowFormat::File}) {
+        auto data = write(format);
+        // Every truncation is reported, or reads the batches before it for a stream cut between two messages.
+        for (size_t n = 0; n < data.size(); n++) {
+            std::vector<uint8_t> truncated(data.begin(), data.begin() + n);
+            auto [reader, err] = ArrowReader::Open(truncated, "truncated");
+            if (err) {
+                EXPECT_EQ(err->Code, mysql::ErrNotFormFile);
+                continue;
+            }
+            ASSERT_EQ(format, ArrowFormat::Stream);
+            Chunk chk;
+            for (size_t i = 0; i < reader->NumBatches(); i++) {
+                ASSERT_FALSE(reader->ReadBatch(i, chk));
+            }
+        }
+        // So is any flipped byte that makes the data inconsistent; the others read some rows.
+        for (size_t n = 0; n < data.size(); n++) {
+            auto flipped = data;
+            flipped[n] ^= 0x5a;
+            auto [reader, err] = ArrowReader::Open(flipped, "flipped");
+            if (err) {
+                continue;
+            }
+            Chunk chk;
+            for (size_t i = 0; i < reader->NumBatches(); i++) {
+                if (reader->ReadBatch(i, chk)) {
+                    continue;
+                }
+                for (size_t c = 0; c < chk.NumCols(); c++) {
+                    for (size_t r = 0; r < chk.NumRows(); r++) {
+                        if (!chk.Col(c).IsFixed() && !chk.Col(c).IsNull(r)) {
+                            ASSERT_LE(chk.Col(c).GetBytes(r).size(), chk.Col(c).DataSize());
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    auto [reader, err] = ArrowReader::Open(tempPath("missing"));
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrCantOpenFile);
+}
+
+TEST(ArrowIPCTest, TestHugeLength) {
+    auto path = tempPath("huge");
+    std::vector<Field> ints{{"i", mysql::TypeLonglong, 0}};
+    auto [writer, err] = ArrowWriter::Create(path, ints, ArrowFormat::Stream);
+    ASSERT_FALSE(err);
+    Chunk chk(std::vector<uint8_t>{mysql::TypeLonglong});
+    for (int i = 0; i < 5; i++) {
+        chk.Col(0).AppendInt64(100 + i);
+    }
+    ASSERT_FALSE(writer->Write(chk));
+    ASSERT_FALSE(writer->Finish());
+    writer.reset();
+    auto data = readFile(path);
+    std::filesystem::remove(path);
+
+    // The length of the batch and of its array is 5: make both huge, with no nulls, so that a reader trusting them
+    // would allocate a bitmap for them.
+    const int64_t five = 5, huge = int64_t(1) << 60;
+    const auto *pattern = reinterpret_cast<const uint8_t *>(&five);
+    size_t patched = 0;
+    for (auto it = data.begin(); (it = std::search(it, data.end(), pattern, pattern + sizeof(five))) != data.end();) {
+        std::copy_n(reinterpret_cast<const uint8_t *>(&huge), sizeof(huge), it);
+        patched++;
+    }
+    ASSERT_EQ(patched, 2u);
+
+    auto [reader, openErr] = ArrowReader::Open(data, "huge");
+    ASSERT_FALSE(openErr) << openErr->Message;
+    ASSERT_EQ(reader->NumBatches(), 1u);
+    auto readErr = reader->ReadBatch(0, chk);
+    ASSERT_TRUE(readErr);
+    EXPECT_EQ(readErr->Code, mysql::ErrNotFormFile);
+}
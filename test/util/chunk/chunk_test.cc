@@ -0,0 +1,159 @@
+#include "util/chunk/chunk.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "parser/mysql/type.hh"
+#include "util/chunk/alloc.hh"
+
+using namespace util::chunk;
+
+namespace {
+
+const std::vector<uint8_t> types{mysql::TypeLonglong, mysql::TypeDouble, mysql::TypeVarString, mysql::TypeFloat};
+
+// fill appends n rows to chk, every third row null.
+void fill(Chunk &chk, int n) {
+    for (int i = 0; i < n; i++) {
+        if (i % 3 == 1) {
+            for (size_t c = 0; c < chk.NumCols(); c++) {
+                chk.Col(c).AppendNull();
+            }
+            continue;
+        }
+        chk.Col(0).AppendInt64(i);
+        chk.Col(1).AppendFloat64(i * 0.5);
+        chk.Col(2).AppendBytes(std::string(i % 5, 'x'));
+        chk.Col(3).AppendFloat32(static_cast<float>(i));
+    }
+}
+
+}  // namespace
+
+TEST(ChunkTest, TestLayout) {
+    Chunk chk(types, 100);
+    EXPECT_EQ(chk.NumCols(), 4u);
+    EXPECT_EQ(chk.Col(0).ElemSize(), 8u);
+    EXPECT_EQ(chk.Col(2).ElemSize(), Column::varElemSize);
+    EXPECT_EQ(chk.Col(3).ElemSize(), 4u);
+    fill(chk, 100);
+    ASSERT_EQ(chk.NumRows(), 100u);
+    EXPECT_TRUE(chk.IsFull());
+    EXPECT_EQ(chk.Col(0).NullCount(), 33u);
+
+    for (size_t c = 0; c < chk.NumCols(); c++) {
+        // The buffers are aligned like Arrow's.
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(chk.Col(c).Data()) % bufferAlignment, 0u);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(chk.Col(c).NullBitmap()) % bufferAlignment, 0u);
+    }
+    auto ints = chk.Col(0).Values<int64_t>();
+    ASSERT_EQ(ints.size(), 100u);
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(chk.Col(0).IsNull(i), i % 3 == 1);
+        // The bitmap is the validity bitmap of Arrow, least significant bit first.
+        ASSERT_EQ((chk.Col(0).NullBitmap()[i / 8] >> (i % 8)) & 1, i % 3 == 1 ? 0 : 1);
+        ASSERT_EQ(ints[i], i % 3 == 1 ? 0 : i);
+        if (i % 3 != 1) {
+            ASSERT_EQ(chk.Col(1).GetFloat64(i), i * 0.5);
+            ASSERT_EQ(chk.Col(2).GetBytes(i), std::string(i % 5, 'x'));
+            ASSERT_EQ(chk.Col(3).GetFloat32(i), static_cast<float>(i));
+        }
+    }
+    // A var-length column has Length() + 1 offsets, the null values being empty.
+    const auto *offsets = chk.Col(2).Offsets();
+    EXPECT_EQ(offsets[0], 0);
+    EXPECT_EQ(offsets[2], offsets[1]);
+    EXPECT_EQ(static_cast<size_t>(offsets[100]), chk.Col(2).DataSize());
+
+    chk.Col(0).SetNull(0, true);
+    chk.Col(0).SetNull(1, false);
+    chk.Col(0).SetNull(2, false);
+    EXPECT_TRUE(chk.Col(0).IsNull(0));
+    EXPECT_FALSE(chk.Col(0).IsNull(1));
+    EXPECT_EQ(chk.Col(0).NullCount(), 33u);
+    chk.Col(0).RecountNulls();
+    EXPECT_EQ(chk.Col(0).NullCount(), 33u);
+
+    chk.Reset();
+    EXPECT_EQ(chk.NumRows(), 0u);
+    EXPECT_EQ(chk.Col(2).Offsets()[0], 0);
+    fill(chk, 2);
+    EXPECT_EQ(chk.Col(2).GetBytes(0), "");
+    EXPECT_TRUE(chk.Col(2).IsNull(1));
+}
+
+TEST(ChunkTest, TestSel) {
+    Chunk chk(types);
+    fill(chk, 10);
+    chk.SetSel({0, 3, 5, 9});
+    EXPECT_EQ(chk.NumRows(), 4u);
+    EXPECT_EQ(chk.NumRowsUnfiltered(), 10u);
+    EXPECT_EQ(chk.RowIdx(1), 3u);
+
+    // Appending copies the selected rows only.
+    Chunk out(types);
+    out.Append(chk, 0, chk.NumRows());
+    out.AppendRow(chk, 0);
+    ASSERT_EQ(out.NumRows(), 5u);
+    EXPECT_FALSE(out.HasSel());
+    std::vector<int64_t> got;
+    for (size_t i = 0; i < out.NumRows(); i++) {
+        got.push_back(out.Col(0).GetInt64(i));
+    }
+    EXPECT_EQ(got, (std::vector<int64_t>{0, 3, 5, 9, 0}));
+    EXPECT_FALSE(out.Col(2).IsNull(3));
+    EXPECT_EQ(out.Col(2).GetBytes(3), std::string(4, 'x'));
+
+    chk.MutableSel().push_back(1);
+    EXPECT_EQ(chk.NumRows(), 5u);
+    chk.ClearSel();
+    EXPECT_EQ(chk.NumRows(), 10u);
+    EXPECT_TRUE(chk.MutableSel().empty());
+    EXPECT_EQ(chk.NumRows(), 0u);
+}
+
+TEST(ChunkTest, TestResizeFixed) {
+    Column col(8);
+    col.ResizeFixed(20);
+    EXPECT_EQ(col.Length(), 20u);
+    EXPECT_EQ(col.NullCount(), 0u);
+    auto values = col.MutableValues<int64_t>();
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = static_cast<int64_t>(i) * 2;
+    }
+    col.MutableNullBitmap()[1] = 0;
+    col.RecountNulls();
+    EXPECT_EQ(col.NullCount(), 8u);
+    EXPECT_TRUE(col.IsNull(8));
+    EXPECT_FALSE(col.IsNull(16));
+    EXPECT_EQ(col.GetInt64(19), 38);
+}
+
+TEST(ChunkTest, TestAllocator) {
+    Allocator alloc;
+    auto chk = alloc.Alloc(types);
+    fill(chk, 1000);
+    const auto *data = chk.Col(2).Data();
+    alloc.Free(std::move(chk));
+    EXPECT_EQ(alloc.NumFree(), 4u);
+
+    // The columns come back empty with their buffers.
+    auto again = alloc.Alloc(types);
+    EXPECT_EQ(alloc.NumFree(), 0u);
+    EXPECT_EQ(again.NumRows(), 0u);
+    EXPECT_EQ(again.Col(2).Data(), data);
+    EXPECT_EQ(again.Col(2).Offsets()[0], 0);
+    fill(again, 3);
+    EXPECT_EQ(again.Col(0).GetInt64(2), 2);
+
+    // The pool is bounded.
+    Allocator small(1);
+    auto a = small.Alloc(types);
+    auto b = small.Alloc(types);
+    small.Free(std::move(a));
+    small.Free(std::move(b));
+    EXPECT_EQ(small.NumFree(), 3u);
+}
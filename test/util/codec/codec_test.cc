@@ -0,0 +1,187 @@
+#include "util/codec/codec.hh"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace util::codec;
+
+namespace {
+
+template <typename T, typename Encode>
+std::string encoded(T v, Encode encode) {
+    std::string b;
+    encode(b, v);
+    return b;
+}
+
+}  // namespace
+
+TEST(CodecTest, TestNumberOrder) {
+    std::vector<int64_t> ints{std::numeric_limits<int64_t>::min(), -256, -1, 0, 1, 255, 256,
+                              std::numeric_limits<int64_t>::max()};
+    for (auto a : ints) {
+        auto ea = encoded(a, EncodeInt);
+        auto [v, n] = DecodeInt(ea);
+        EXPECT_EQ(v, a);
+        EXPECT_EQ(n, 8u);
+        EXPECT_EQ(std::get<0>(DecodeIntDesc(encoded(a, EncodeIntDesc))), a);
+        for (auto b : ints) {
+            EXPECT_EQ(ea < encoded(b, EncodeInt), a < b);
+            EXPECT_EQ(encoded(a, EncodeIntDesc) < encoded(b, EncodeIntDesc), a > b);
+        }
+    }
+    EXPECT_EQ(std::get<1>(DecodeInt("1234567")), 0u);
+    EXPECT_EQ(std::get<0>(DecodeUint(encoded(uint64_t{1} << 63, EncodeUint))), uint64_t{1} << 63);
+    EXPECT_LT(encoded(uint64_t{1}, EncodeUint), encoded(uint64_t{1} << 63, EncodeUint));
+
+    auto inf = std::numeric_limits<double>::infinity();
+    std::vector<double> floats{-inf, -1e300, -1.5, -1e-300, 0, 1e-300, 1.5, 1e300, inf};
+    for (auto a : floats) {
+        auto ea = encoded(a, EncodeFloat);
+        EXPECT_EQ(std::get<0>(DecodeFloat(ea)), a);
+        EXPECT_EQ(std::get<0>(DecodeFloatDesc(encoded(a, EncodeFloatDesc))), a);
+        for (auto b : floats) {
+            EXPECT_EQ(ea < encoded(b, EncodeFloat), a < b);
+        }
+    }
+    // Both zeros encode the same.
+    EXPECT_EQ(encoded(-0.0, EncodeFloat), encoded(0.0, EncodeFloat));
+}
+
+TEST(CodecTest, TestBytes) {
+    EXPECT_EQ(encoded(std::string_view(""), EncodeBytes), std::string(8, '\0') + "\xf7");
+    // A default string_view has no data at all.
+    EXPECT_EQ(encoded(std::string_view(), EncodeBytes), std::string(8, '\0') + "\xf7");
+    EXPECT_EQ(encoded(std::string_view("abc"), EncodeBytes), std::string("abc\0\0\0\0\0\xfa", 9));
+    EXPECT_EQ(encoded(std::string_view("12345678"), EncodeBytes), "12345678\xff" + std::string(8, '\0') + "\xf7");
+
+    std::mt19937 rng(1);
+    std::vector<std::string> strings{"", std::string(1, '\0'), std::string(8, '\0'), std::string(9, '\xff')};
+    for (int i = 0; i < 200; i++) {
+        std::string s(rng() % 20, '\0');
+        for (auto &c : s) {
+            // A small alphabet makes common prefixes and zero bytes likely.
+            c = static_cast<char>(rng() % 3);
+        }
+        strings.push_back(s);
+    }
+    for (const auto &a : strings) {
+        auto ea = encoded(std::string_view(a), EncodeBytes);
+        ASSERT_EQ(ea.size(), EncodedBytesLength(a.size()));
+        std::string out;
+        EXPECT_EQ(DecodeBytes(ea + "rest", out), ea.size());
+        EXPECT_EQ(out, a);
+        auto da = encoded(std::string_view(a), EncodeBytesDesc);
+        out.clear();
+        EXPECT_EQ(DecodeBytesDesc(da, out), da.size());
+        EXPECT_EQ(out, a);
+        for (const auto &b : strings) {
+            EXPECT_EQ(ea < encoded(std::string_view(b), EncodeBytes), a < b);
+            EXPECT_EQ(da < encoded(std::string_view(b), EncodeBytesDesc), a > b);
+        }
+    }
+
+    std::string out = "kept";
+    // Truncated, a marker padding more than a group, and a non-zero padding byte.
+    EXPECT_EQ(DecodeBytes(std::string("abc\0\0\0\0\0", 8), out), 0u);
+    EXPECT_EQ(DecodeBytes(std::string("abc\0\0\0\0\0\xf6", 9), out), 0u);
+    EXPECT_EQ(DecodeBytes(std::string("12345678\xff" "abc\0\0\0\0\x01\xfa", 18), out), 0u);
+    EXPECT_EQ(out, "kept");
+}
+
+TEST(CodecTest, TestDecimal) {
+    struct testCase {
+        std::string Text;
+        int Precision;
+        int Frac;
+        std::string Decoded;
+    };
+    std::vector<testCase> cases{
+        {"0", 0, 0, "0"},
+        {"-0.00", 5, 2, "0.00"},
+        {"1234567890.1234", 14, 4, "1234567890.1234"},
+        {"-1234567890.1234", 20, 10, "-1234567890.1234000000"},
+        {"00012.5", 10, 3, "12.500"},
+        {".5", 0, 0, "0.5"},
+        {"-123456789012345678901234567890.123456789", 65, 30,
+         "-123456789012345678901234567890.123456789000000000000000000000"},
+    };
+    for (const auto &c : cases) {
+        std::string b;
+        EXPECT_FALSE(EncodeDecimal(b, c.Text, c.Precision, c.Frac)) << c.Text;
+        auto [text, precision, frac, n] = DecodeDecimal(b + "rest");
+        EXPECT_EQ(text, c.Decoded);
+        EXPECT_EQ(n, b.size());
+        EXPECT_EQ(PeekKeyValue(std::string(1, static_cast<char>(DecimalFlag)) + b), b.size() + 1);
+    }
+
+    // Decimals of the same type sort like their values.
+    std::vector<std::string> ordered{"-99999.999", "-100", "-1.5", "-1.25", "-0.001", "0",
+                                     "0.001",      "1.25", "1.5",  "100",   "99999.999"};
+    for (size_t i = 0; i < ordered.size(); i++) {
+        for (size_t j = 0; j < ordered.size(); j++) {
+            std::string a, b;
+            EncodeDecimal(a, ordered[i], 8, 3);
+            EncodeDecimal(b, ordered[j], 8, 3);
+            EXPECT_EQ(a < b, i < j) << ordered[i] << " " << ordered[j];
+        }
+    }
+
+    std::string b;
+    EXPECT_EQ(EncodeDecimal(b, "1.2.3", 5, 2)->Code, mysql::ErrTruncatedWrongValue);
+    EXPECT_EQ(EncodeDecimal(b, "-", 5, 2)->Code, mysql::ErrTruncatedWrongValue);
+    EXPECT_EQ(EncodeDecimal(b, "1", 66, 2)->Code, mysql::ErrTooBigPrecision);
+    EXPECT_EQ(EncodeDecimal(b, "1", 5, 6)->Code, mysql::ErrMBiggerThanD);
+    EXPECT_TRUE(b.empty());
+    // A value that does not fit is still encoded, with a warning.
+    EXPECT_EQ(EncodeDecimal(b, "1.239", 5, 2)->Code, mysql::WarnDataTruncated);
+    EXPECT_EQ(std::get<0>(DecodeDecimal(b)), "1.23");
+    b.clear();
+    EXPECT_EQ(EncodeDecimal(b, "-12345", 5, 2)->Code, mysql::ErrDataOutOfRange);
+    EXPECT_EQ(std::get<0>(DecodeDecimal(b)), "-999.99");
+    b.clear();
+    EXPECT_FALSE(EncodeDecimal(b, "1.2300", 5, 2));
+}
+
+TEST(CodecTest, TestColumns) {
+    std::vector<std::string> keys(3, "p");
+    std::vector<int64_t> ints{3, -1, 7};
+    std::vector<uint8_t> nulls{0, 1, 0};
+    EncodeIntColumn(keys, ints, nulls);
+    std::vector<std::string_view> strs{"a", "bb", ""};
+    EncodeBytesColumn(keys, strs);
+    std::vector<double> floats{1.5, 2.5, -3};
+    EncodeFloatColumn(keys, floats);
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        // The row by row encoding gives the same keys.
+        std::string expected = "p";
+        if (nulls[i]) {
+            expected.push_back(static_cast<char>(NilFlag));
+        } else {
+            expected.push_back(static_cast<char>(IntFlag));
+            EncodeInt(expected, ints[i]);
+        }
+        expected.push_back(static_cast<char>(BytesFlag));
+        EncodeBytes(expected, strs[i]);
+        expected.push_back(static_cast<char>(FloatFlag));
+        EncodeFloat(expected, floats[i]);
+        EXPECT_EQ(keys[i], expected);
+
+        // The values can be cut off one at a time.
+        std::string_view rest = std::string_view(keys[i]).substr(1);
+        for (int col = 0; col < 3; col++) {
+            auto n = PeekKeyValue(rest);
+            ASSERT_GT(n, 0u);
+            rest.remove_prefix(n);
+        }
+        EXPECT_TRUE(rest.empty());
+    }
+    EXPECT_EQ(PeekKeyValue(std::string(1, static_cast<char>(IntFlag)) + "1234567"), 0u);
+    EXPECT_EQ(PeekKeyValue(std::string(1, static_cast<char>(CompactBytesFlag))), 0u);
+}
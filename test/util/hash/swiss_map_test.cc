@@ -0,0 +1,133 @@
+#include "util/hash/swiss_map.hh"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <unordered_map>
+
+using namespace util::hash;
+
+namespace {
+
+// collidingHash sends every key to the same group with the same control byte, so that the lookups compare all the
+// keys and probe all the groups.
+struct collidingHash {
+    size_t operator()(int64_t) const { return 0; }
+};
+
+}  // namespace
+
+TEST(SwissMapTest, TestBasic) {
+    SwissMap<int64_t, int64_t> m;
+    EXPECT_TRUE(m.Empty());
+    EXPECT_EQ(m.Find(1), nullptr);
+    EXPECT_FALSE(m.Erase(1));
+
+    auto [v, inserted] = m.TryEmplace(1, 10);
+    EXPECT_TRUE(inserted);
+    EXPECT_EQ(*v, 10);
+    std::tie(v, inserted) = m.TryEmplace(1, 11);
+    EXPECT_FALSE(inserted);
+    EXPECT_EQ(*v, 10);
+    EXPECT_FALSE(m.InsertOrAssign(1, 12));
+    EXPECT_EQ(*m.Find(1), 12);
+    m[2] += 5;
+    m[2] += 5;
+    EXPECT_EQ(*m.Find(2), 10);
+    EXPECT_EQ(m.Size(), 2u);
+    EXPECT_TRUE(m.Contains(2));
+
+    EXPECT_TRUE(m.Erase(1));
+    EXPECT_FALSE(m.Contains(1));
+    EXPECT_EQ(m.Size(), 1u);
+    m.Clear();
+    EXPECT_TRUE(m.Empty());
+    EXPECT_FALSE(m.Contains(2));
+}
+
+TEST(SwissMapTest, TestRandomOps) {
+    // Inserts and erases on a small key space, so that deleted slots pile up and are reused, checked against
+    // std::unordered_map.
+    SwissMap<int64_t, int64_t> m;
+    std::unordered_map<int64_t, int64_t> want;
+    std::mt19937_64 rng(1);
+    std::uniform_int_distribution<int64_t> pick(0, 5000);
+    for (int i = 0; i < 200000; i++) {
+        auto k = pick(rng);
+        switch (rng() % 3) {
+            case 0:
+                ASSERT_EQ(m.InsertOrAssign(k, i), want.insert_or_assign(k, i).second);
+                break;
+            case 1:
+                ASSERT_EQ(m.Erase(k), want.erase(k) == 1);
+                break;
+            default: {
+                auto it = want.find(k);
+                auto *v = m.Find(k);
+                ASSERT_EQ(v != nullptr, it != want.end());
+                if (v != nullptr) {
+                    ASSERT_EQ(*v, it->second);
+                }
+            }
+        }
+        ASSERT_EQ(m.Size(), want.size());
+    }
+    size_t n = 0;
+    m.ForEach([&](int64_t k, int64_t v) {
+        EXPECT_EQ(want.at(k), v);
+        n++;
+    });
+    EXPECT_EQ(n, want.size());
+    // The deleted slots are reclaimed instead of growing the table forever.
+    EXPECT_LE(m.Capacity(), 16384u);
+}
+
+TEST(SwissMapTest, TestStrings) {
+    SwissMap<std::string, std::string> m;
+    for (int i = 0; i < 1000; i++) {
+        m[std::to_string(i)] = std::string(100, static_cast<char>('a' + i % 26));
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        ASSERT_TRUE(m.Erase(std::to_string(i)));
+    }
+    EXPECT_EQ(m.Size(), 500u);
+    EXPECT_EQ(*m.Find(std::string("999")), std::string(100, static_cast<char>('a' + 999 % 26)));
+    EXPECT_EQ(m.Find(std::string("998")), nullptr);
+    // The strings are looked up by std::string_view without a copy.
+    EXPECT_EQ(*m.Find(std::string_view("999")), std::string(100, static_cast<char>('a' + 999 % 26)));
+    EXPECT_TRUE(m.Contains(std::string_view("1")));
+    EXPECT_FALSE(m.Contains(std::string_view("998")));
+
+    auto moved = std::move(m);
+    EXPECT_EQ(moved.Size(), 500u);
+    EXPECT_EQ(m.Size(), 0u);
+    EXPECT_EQ(m.Find(std::string("999")), nullptr);
+    EXPECT_TRUE(moved.Contains(std::string("1")));
+}
+
+TEST(SwissMapTest, TestReserveAndCollisions) {
+    SwissMap<int64_t, int64_t> m(10000);
+    auto capacity = m.Capacity();
+    EXPECT_GE(capacity, 10000u);
+    for (int64_t i = 0; i < 10000; i++) {
+        m[i] = i;
+    }
+    EXPECT_EQ(m.Capacity(), capacity);
+    for (int64_t i = 10000; i < 20000; i++) {
+        m[i] = i;
+    }
+    EXPECT_GT(m.Capacity(), capacity);
+
+    SwissMap<int64_t, int64_t, collidingHash> c;
+    for (int64_t i = 0; i < 300; i++) {
+        c[i] = i;
+    }
+    for (int64_t i = 0; i < 300; i += 3) {
+        ASSERT_TRUE(c.Erase(i));
+    }
+    for (int64_t i = 0; i < 300; i++) {
+        auto *v = c.Find(i);
+        ASSERT_EQ(v != nullptr, i % 3 != 0) << i;
+    }
+}
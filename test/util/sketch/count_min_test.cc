@@ -0,0 +1,69 @@
+#include "util/sketch/count_min.hh"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <tuple>
+
+using namespace util::sketch;
+
+TEST(CountMinSketchTest, TestEstimate) {
+    // A Zipf-like stream: the key i occurs 1000 / i times.
+    CountMinSketch s;
+    uint64_t total = 0;
+    for (uint64_t i = 1; i <= 10000; i++) {
+        auto n = std::max<uint64_t>(1000 / i, 1);
+        s.Add("key" + std::to_string(i), n);
+        total += n;
+    }
+    EXPECT_EQ(s.Width(), CountMinSketch::defaultWidth);
+    size_t exact = 0;
+    for (uint64_t i = 1; i <= 10000; i++) {
+        auto n = std::max<uint64_t>(1000 / i, 1);
+        auto estimate = s.Get("key" + std::to_string(i));
+        // Never below the count, and above it by less than e / width of the total but for a few keys.
+        ASSERT_GE(estimate, n) << i;
+        exact += estimate - n <= total * 2.72 / CountMinSketch::defaultWidth;
+    }
+    EXPECT_GE(exact, 9500u);
+}
+
+TEST(CountMinSketchTest, TestSaturate) {
+    // The counters saturate at the largest value, which bounds the estimates.
+    CountMinSketch s(16, 15);
+    for (int i = 0; i < 100; i++) {
+        s.Add(std::to_string(i), 3);
+    }
+    EXPECT_EQ(s.MaxValue(), 15u);
+    for (int i = 0; i < 100; i++) {
+        auto estimate = s.Get(std::to_string(i));
+        EXPECT_GE(estimate, 3u);
+        EXPECT_LE(estimate, 15u);
+    }
+}
+
+TEST(CountMinSketchTest, TestSaveOpen) {
+    auto path = (std::filesystem::temp_directory_path() / ("count_min_test_" + std::to_string(::getpid()))).string();
+    CountMinSketch s(256, 1000, 7);
+    for (int i = 0; i < 500; i++) {
+        s.Add(std::to_string(i), i % 10 + 1);
+    }
+    ASSERT_FALSE(s.Save(path));
+    auto [opened, err] = CountMinSketch::Open(path);
+    ASSERT_FALSE(err);
+    EXPECT_EQ(opened->Width(), 256u);
+    EXPECT_EQ(opened->Bytes(), s.Bytes());
+    for (int i = 0; i < 600; i++) {
+        EXPECT_EQ(opened->Get(std::to_string(i)), s.Get(std::to_string(i))) << i;
+    }
+    std::filesystem::remove(path);
+
+    std::tie(opened, err) = CountMinSketch::Open(path);
+    ASSERT_TRUE(err);
+    EXPECT_EQ(err->Code, mysql::ErrCantOpenFile);
+    EXPECT_TRUE(s.Save(path + "/missing/sketch"));
+}
@@ -0,0 +1,66 @@
+#include "util/sketch/hyperloglog.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "xxHash/xxhash.h"
+
+using namespace util::sketch;
+
+namespace {
+
+uint64_t hashOf(uint64_t v) { return XXH3_64bits(&v, sizeof(v)); }
+
+}  // namespace
+
+TEST(HyperLogLogTest, TestSparse) {
+    HyperLogLog hll;
+    EXPECT_EQ(hll.Estimate(), 0u);
+    // Up to maxSparse distinct values are counted exactly, whatever their duplicates.
+    for (int round = 0; round < 10; round++) {
+        for (uint64_t v = 0; v < HyperLogLog::maxSparse; v++) {
+            hll.Update(hashOf(v));
+        }
+    }
+    EXPECT_TRUE(hll.IsSparse());
+    EXPECT_EQ(hll.Estimate(), HyperLogLog::maxSparse);
+    hll.Update(hashOf(HyperLogLog::maxSparse));
+    EXPECT_EQ(hll.Estimate(), HyperLogLog::maxSparse + 1);
+}
+
+TEST(HyperLogLogTest, TestEstimate) {
+    for (uint64_t n : {1000, 100000, 1000000}) {
+        HyperLogLog hll;
+        for (uint64_t v = 0; v < n; v++) {
+            hll.Update(hashOf(v));
+            hll.Update(hashOf(v / 2));
+        }
+        EXPECT_FALSE(hll.IsSparse());
+        EXPECT_NEAR(static_cast<double>(hll.Estimate()), static_cast<double>(n), n * 0.03) << n;
+    }
+}
+
+TEST(HyperLogLogTest, TestMerge) {
+    // The values of 8 threads, overlapping, some of them sparse.
+    std::vector<HyperLogLog> parts(8);
+    for (uint64_t v = 0; v < 200000; v++) {
+        parts[v % 6].Update(hashOf(v));
+        parts[(v + 1) % 6].Update(hashOf(v));
+    }
+    for (uint64_t v = 0; v < 100; v++) {
+        parts[6].Update(hashOf(v));
+        parts[7].Update(hashOf(v + 1000000));
+    }
+    EXPECT_TRUE(parts[6].IsSparse());
+    HyperLogLog merged, sparse;
+    for (const auto &p : parts) {
+        merged.Merge(p);
+    }
+    EXPECT_NEAR(static_cast<double>(merged.Estimate()), 200100.0, 200100 * 0.03);
+    sparse.Merge(parts[6]);
+    sparse.Merge(parts[7]);
+    EXPECT_TRUE(sparse.IsSparse());
+    EXPECT_EQ(sparse.Estimate(), 200u);
+}
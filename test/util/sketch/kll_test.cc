@@ -0,0 +1,82 @@
+#include "util/sketch/kll.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace util::sketch;
+
+namespace {
+
+// rankError returns how far the rank of v in the sorted values is from q, as a fraction of their number.
+double rankError(const std::vector<uint64_t> &sorted, uint64_t v, double q) {
+    auto lower = static_cast<double>(std::lower_bound(sorted.begin(), sorted.end(), v) - sorted.begin());
+    auto upper = static_cast<double>(std::upper_bound(sorted.begin(), sorted.end(), v) - sorted.begin());
+    auto rank = q * static_cast<double>(sorted.size());
+    auto err = rank < lower ? lower - rank : rank > upper ? rank - upper : 0;
+    return err / static_cast<double>(sorted.size());
+}
+
+}  // namespace
+
+TEST(KLLSketchTest, TestSmall) {
+    KLLSketch kll;
+    EXPECT_EQ(kll.Quantile(0.5), 0u);
+    for (uint64_t v : {5, 1, 4, 2, 3}) {
+        kll.Update(v);
+    }
+    // Until the sketch compacts, the quantiles are exact.
+    EXPECT_EQ(kll.Count(), 5u);
+    EXPECT_EQ(kll.Quantile(0), 1u);
+    EXPECT_EQ(kll.Quantile(0.2), 1u);
+    EXPECT_EQ(kll.Quantile(0.5), 3u);
+    EXPECT_EQ(kll.Quantile(0.9), 5u);
+    EXPECT_EQ(kll.Quantile(1), 5u);
+}
+
+TEST(KLLSketchTest, TestQuantiles) {
+    std::mt19937_64 rng(49);
+    std::vector<uint64_t> values;
+    KLLSketch kll;
+    for (size_t i = 0; i < 1000000; i++) {
+        // Skewed: most values are small.
+        auto v = rng() % (rng() % 2 == 0 ? 100 : 1000000);
+        values.push_back(v);
+        kll.Update(v);
+    }
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(kll.Count(), values.size());
+    EXPECT_LT(kll.NumRetained(), 4 * KLLSketch::defaultK);
+    for (double q : {0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99}) {
+        EXPECT_LT(rankError(values, kll.Quantile(q), q), 0.02) << q;
+    }
+}
+
+TEST(KLLSketchTest, TestMerge) {
+    std::vector<uint64_t> values;
+    std::vector<KLLSketch> parts;
+    for (uint64_t seed = 0; seed < 8; seed++) {
+        parts.emplace_back(KLLSketch::defaultK, seed);
+    }
+    for (uint64_t v = 0; v < 400000; v++) {
+        // Each thread has values of its own range, and of different numbers.
+        auto p = v % 8;
+        if (v % (p + 1) == 0) {
+            parts[p].Update(v * 8 / 400000 * 1000000 + v);
+            values.push_back(v * 8 / 400000 * 1000000 + v);
+        }
+    }
+    KLLSketch merged;
+    for (const auto &p : parts) {
+        merged.Merge(p);
+    }
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(merged.Count(), values.size());
+    EXPECT_LT(merged.NumRetained(), 4 * KLLSketch::defaultK);
+    for (double q : {0.05, 0.3, 0.5, 0.7, 0.95}) {
+        EXPECT_LT(rankError(values, merged.Quantile(q), q), 0.02) << q;
+    }
+}
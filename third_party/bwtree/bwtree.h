@@ -2,6 +2,8 @@
 
 // 2020-08-27: modified by Wan to track index_size, exposed via GetSize()
 // 2020-10-05: modified by Wan to disable ASAN per function, because apparently gcc refuses to add fsanitize-blacklist.
+// 2026-10-18: added BulkLoad() to build the tree bottom-up from sorted pairs.
+// 2026-10-18: added ScanBatch() to scan the leaves a batch at a time, following the sibling chain.
 
 // As we have learned from recent events, if we do not test for something, then it does not exist.
 #define NO_ASAN __attribute__((no_sanitize("address")))
@@ -24,8 +26,7 @@
 #include "bwtree/atomic_stack.h"
 #include "bwtree/bloom_filter.h"
 #include "bwtree/sorted_small_set.h"
-#include "common/macros.h"
-#include "loggers/index_logger.h"
+#include "bwtree/bwtree_compat.h"
 
 #ifndef NDEBUG
 /*
@@ -6812,6 +6813,166 @@ class BwTree : public BwTreeBase {
   /** GetSize() - Return the size of the BwTree. */
   NO_ASAN uint64_t GetSize() const { return index_size.load(); }
 
+  /*
+   * BulkLoad() - Build an empty tree bottom-up from pairs sorted by key
+   *
+   * The leaves are filled to 3/4 of the split threshold, never splitting
+   * the values of a key across two leaves, and linked by their high keys;
+   * the inner levels are built over them the same way. Nothing is visible
+   * until the empty first leaf is replaced with a single CAS: since its high
+   * key sends the larger keys right along the sibling chain, readers see
+   * either none of the pairs or all of them. The root is then replaced to
+   * index the new leaves.
+   *
+   * The pairs must not contain a pair twice, nor a key twice if the tree is
+   * used as a unique index. Readers may run concurrently; writers should
+   * wait for the load to finish.
+   *
+   * The return value is false if the tree is not empty, in which case
+   * nothing is installed
+   */
+  NO_ASAN bool BulkLoad(const KeyValuePair *begin_p, const KeyValuePair *end_p) {
+    if (begin_p == end_p) {
+      return true;
+    }
+
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
+
+    // Only the layout of InitNodeLayout() is loaded into: the root inner
+    // node with a single separator, over an empty leaf without deltas
+    const NodeID old_root_id = root_id.load();
+    const BaseNode *old_root_p = GetNode(old_root_id);
+    const BaseNode *first_leaf_p = GetNode(FIRST_LEAF_NODE_ID);
+    if (index_size.load() != 0 || old_root_p->GetType() != NodeType::InnerType || old_root_p->GetItemCount() != 1 ||
+        first_leaf_p->GetType() != NodeType::LeafType || first_leaf_p->GetItemCount() != 0 ||
+        first_leaf_p->GetNextNodeID() != INVALID_NODE_ID) {
+      epoch_manager.LeaveEpoch(epoch_node_p);
+      return false;
+    }
+
+    /////////////////////////////////////////////////////////////////
+    // Leaf level
+    /////////////////////////////////////////////////////////////////
+
+    // The start of every leaf in the input, followed by the end
+    const int leaf_fill = std::max(GetLeafNodeSizeUpperThreshold() * 3 / 4, 1);
+    std::vector<const KeyValuePair *> bounds{begin_p};
+    while (bounds.back() != end_p) {
+      const KeyValuePair *p = bounds.back() + std::min<ptrdiff_t>(leaf_fill, end_p - bounds.back());
+      while (p != end_p && KeyCmpEqual(p->first, (p - 1)->first)) {
+        p++;
+      }
+      bounds.push_back(p);
+    }
+
+    // The low key and NodeID of every node of the level being built
+    std::vector<KeyNodeIDPair> level(bounds.size() - 1);
+    level[0] = std::make_pair(KeyType{}, FIRST_LEAF_NODE_ID);
+    for (size_t i = 1; i < level.size(); i++) {
+      level[i] = std::make_pair(bounds[i]->first, GetNextNodeID());
+    }
+
+    // The NodeIDs taken by the new nodes but the first leaf, to free them if
+    // the load fails
+    std::vector<NodeID> new_node_ids;
+    LeafNode *new_first_leaf_p = nullptr;
+    for (size_t i = 0; i < level.size(); i++) {
+      const int size = static_cast<int>(bounds[i + 1] - bounds[i]);
+      // As in InitNodeLayout() and GetSplitSibling(): the low key of a leaf
+      // is not used, and an INVALID_NODE_ID high key is +Inf
+      KeyNodeIDPair low_key = i == 0 ? std::make_pair(KeyType{}, INVALID_NODE_ID)
+                                     : std::make_pair(level[i].first, ~INVALID_NODE_ID);
+      KeyNodeIDPair high_key = i + 1 == level.size() ? std::make_pair(KeyType{}, INVALID_NODE_ID) : level[i + 1];
+
+      auto *leaf_node_p = reinterpret_cast<LeafNode *>(
+          ElasticNode<KeyValuePair>::Get(size, NodeType::LeafType, 0, size, low_key, high_key));
+      leaf_node_p->PushBack(bounds[i], bounds[i + 1]);
+
+      if (i == 0) {
+        new_first_leaf_p = leaf_node_p;
+      } else {
+        InstallNewNode(level[i].second, leaf_node_p);
+        new_node_ids.push_back(level[i].second);
+      }
+    }
+
+    /////////////////////////////////////////////////////////////////
+    // Inner levels
+    /////////////////////////////////////////////////////////////////
+
+    const int inner_fill = std::max(GetInnerNodeSizeUpperThreshold() * 3 / 4, 2);
+    while (level.size() > 1) {
+      // Spread the separators evenly, so that no node is left nearly empty
+      const size_t node_count = (level.size() + inner_fill - 1) / inner_fill;
+      std::vector<KeyNodeIDPair> upper_level(node_count);
+      std::vector<size_t> starts(node_count + 1);
+      for (size_t i = 0; i <= node_count; i++) {
+        starts[i] = level.size() * i / node_count;
+      }
+      for (size_t i = 0; i < node_count; i++) {
+        upper_level[i] = std::make_pair(level[starts[i]].first, GetNextNodeID());
+      }
+
+      for (size_t i = 0; i < node_count; i++) {
+        const int size = static_cast<int>(starts[i + 1] - starts[i]);
+        // The first separator is the low key, that of the leftmost node being
+        // the empty key of InitNodeLayout()
+        const KeyNodeIDPair &low_key = level[starts[i]];
+        KeyNodeIDPair high_key =
+            i + 1 == node_count ? std::make_pair(KeyType{}, INVALID_NODE_ID) : upper_level[i + 1];
+
+        auto *inner_node_p = reinterpret_cast<InnerNode *>(
+            ElasticNode<KeyNodeIDPair>::Get(size, NodeType::InnerType, 0, size, low_key, high_key));
+        inner_node_p->PushBack(level.data() + starts[i], level.data() + starts[i + 1]);
+        InstallNewNode(upper_level[i].second, inner_node_p);
+        new_node_ids.push_back(upper_level[i].second);
+      }
+
+      level = std::move(upper_level);
+    }
+
+    /////////////////////////////////////////////////////////////////
+    // Publish
+    /////////////////////////////////////////////////////////////////
+
+    if (!InstallNodeToReplace(FIRST_LEAF_NODE_ID, new_first_leaf_p, first_leaf_p)) {
+      // A writer got to the tree first: the new nodes were never reachable.
+      // They are freed one by one, as the inner nodes point to the live first
+      // leaf, and their NodeIDs are recycled at once since no thread can
+      // have seen them
+      new_first_leaf_p->~LeafNode();
+      new_first_leaf_p->Destroy();
+      for (NodeID node_id : new_node_ids) {
+        const BaseNode *node_p = GetNode(node_id);
+        InvalidateNodeID(node_id);
+        if (node_p->GetType() == NodeType::LeafType) {
+          static_cast<const LeafNode *>(node_p)->~LeafNode();
+          static_cast<const LeafNode *>(node_p)->Destroy();
+        } else {
+          static_cast<const InnerNode *>(node_p)->~InnerNode();
+          static_cast<const InnerNode *>(node_p)->Destroy();
+        }
+      }
+
+      epoch_manager.LeaveEpoch(epoch_node_p);
+      return false;
+    }
+
+    index_size.fetch_add(static_cast<uint64_t>(end_p - begin_p));
+    epoch_manager.AddGarbageNode(first_leaf_p);
+
+    // With a single leaf the old root already indexes it
+    if (level[0].second != FIRST_LEAF_NODE_ID) {
+      bool ret = InstallRootNode(old_root_id, level[0].second);
+      NOISEPAGE_ASSERT(ret, "The root changed during a bulk load.");
+      (void)ret;
+      epoch_manager.AddGarbageNode(old_root_p);
+    }
+
+    epoch_manager.LeaveEpoch(epoch_node_p);
+    return true;
+  }
+
   /*
    * GetValue() - Fill a value list with values stored
    *
@@ -7653,6 +7814,112 @@ class BwTree : public BwTreeBase {
    */
   NO_ASAN ForwardIterator NullIterator() { return ForwardIterator{}; }
 
+  /*
+   * class ScanCursor - Position of a batched scan between two leaves
+   *
+   * next_key is the first key not scanned yet, i.e. the high key of the last
+   * leaf scanned, and next_node_id the NodeID of its right sibling. A default
+   * constructed cursor starts at the first leaf, with no key to start from.
+   * done is set once the last leaf has been scanned.
+   */
+  class ScanCursor {
+   public:
+    KeyType next_key{};
+    NodeID next_node_id{FIRST_LEAF_NODE_ID};
+    bool from_start{true};
+    bool done{false};
+
+    ScanCursor() = default;
+    explicit ScanCursor(const KeyType &start_key)
+        : next_key{start_key}, next_node_id{INVALID_NODE_ID}, from_start{false} {}
+  };
+
+  /*
+   * ScanBatch() - Append the pairs of the next leaf of a scan to two arrays
+   *
+   * The leaf holding cursor_p->next_key is consolidated, and its pairs whose
+   * key is >= next_key are appended to keys and values in key order. The
+   * cursor then moves past the leaf, and the node of its right sibling is
+   * prefetched so that it is in cache when the caller asks for the next batch.
+   *
+   * Unlike ForwardIterator, which traverses from the root on every leaf,
+   * the scan follows the sibling chain: the sibling is used if it is still a
+   * leaf whose low key is the high key of the leaf before, which also holds
+   * if its NodeID has been recycled meanwhile. Otherwise, e.g. after a merge,
+   * the leaf is found from the root.
+   *
+   * The batch may be empty without the scan being done.
+   */
+  NO_ASAN void ScanBatch(ScanCursor *cursor_p, std::vector<KeyType> &keys, std::vector<ValueType> &values) {
+    NOISEPAGE_ASSERT(!cursor_p->done, "The scan is done.");
+
+    EpochNode *epoch_node_p = epoch_manager.JoinEpoch();
+
+    NodeSnapshot snapshot{INVALID_NODE_ID, nullptr};
+    if (cursor_p->from_start) {
+      // The first leaf is never removed
+      snapshot = NodeSnapshot{FIRST_LEAF_NODE_ID, GetNode(FIRST_LEAF_NODE_ID)};
+    } else if (cursor_p->next_node_id != INVALID_NODE_ID) {
+      const BaseNode *node_p = GetNode(cursor_p->next_node_id);
+      if (node_p != nullptr && node_p->IsOnLeafDeltaChain() && node_p->GetType() != NodeType::LeafRemoveType &&
+          node_p->GetLowKeyPair().second != INVALID_NODE_ID && KeyCmpEqual(node_p->GetLowKey(), cursor_p->next_key)) {
+        snapshot = NodeSnapshot{cursor_p->next_node_id, node_p};
+      }
+    }
+
+    Context context{cursor_p->next_key};
+    NodeSnapshot *snapshot_p = &snapshot;
+    if (snapshot.node_p == nullptr) {
+      Traverse(&context, nullptr, nullptr);
+      snapshot_p = GetLatestNodeSnapshot(&context);
+    }
+    const BaseNode *node_p = snapshot_p->node_p;
+
+    // A leaf without deltas is read in place, the others are consolidated
+    LeafNode *leaf_node_p = nullptr;
+    const LeafNode *base_p = static_cast<const LeafNode *>(node_p);
+    if (node_p->GetType() != NodeType::LeafType) {
+      leaf_node_p = CollectAllValuesOnLeaf(snapshot_p);
+      base_p = leaf_node_p;
+    }
+    const KeyValuePair *start_p = base_p->Begin();
+    const KeyValuePair *end_p = base_p->End();
+    if (!cursor_p->from_start) {
+      start_p = std::lower_bound(start_p, end_p, std::make_pair(cursor_p->next_key, ValueType{}),
+                                 key_value_pair_cmp_obj);
+    }
+    size_t offset = keys.size();
+    keys.resize(offset + (end_p - start_p));
+    values.resize(offset + (end_p - start_p));
+    for (const KeyValuePair *kv_p = start_p; kv_p != end_p; kv_p++, offset++) {
+      keys[offset] = kv_p->first;
+      values[offset] = kv_p->second;
+    }
+
+    // The top of the delta chain has the high key of the logical leaf
+    const KeyNodeIDPair &high_key = node_p->GetHighKeyPair();
+    if (high_key.second == INVALID_NODE_ID) {
+      cursor_p->done = true;
+    } else {
+      cursor_p->next_key = high_key.first;
+      cursor_p->next_node_id = high_key.second;
+      cursor_p->from_start = false;
+
+      // Only a hint: the node is read again once the caller asks for it
+      const BaseNode *next_node_p = GetNode(high_key.second);
+      for (size_t line = 0; line < 4 * CACHE_LINE_SIZE; line += CACHE_LINE_SIZE) {
+        __builtin_prefetch(reinterpret_cast<const char *>(next_node_p) + line);
+      }
+    }
+
+    if (leaf_node_p != nullptr) {
+      leaf_node_p->~LeafNode();
+      leaf_node_p->Destroy();
+    }
+
+    epoch_manager.LeaveEpoch(epoch_node_p);
+  }
+
   /*
    * Iterators
    */
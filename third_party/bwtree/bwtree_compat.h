@@ -0,0 +1,10 @@
+#pragma once
+// Stand-ins for the NoisePage macros the Bw-Tree was written against: assertions and printf-style index logging.
+#include <cassert>
+#include <cstdio>
+
+#define NOISEPAGE_ASSERT(expr, message) assert((expr) && (message))
+
+#define INDEX_LOG_TRACE(...) ((void)0)
+#define INDEX_LOG_DEBUG(...) ((void)0)
+#define INDEX_LOG_ERROR(...) (std::fprintf(stderr, __VA_ARGS__), std::fputc('\n', stderr))